@@ -52,8 +52,9 @@ extern "C" {
 #define FUTEX_WAIT_BITSET 9
 #define FUTEX_WAKE_BITSET 10
 
+#define FUTEX_PRIVATE_FLAG (1 << 7)
 #define FUTEX_CLOCK_REALTIME (1 << 8)
-#define FUTEX_CMD_MASK ~(FUTEX_CLOCK_REALTIME)
+#define FUTEX_CMD_MASK ~(FUTEX_PRIVATE_FLAG | FUTEX_CLOCK_REALTIME)
 
 #define FUTEX_BITSET_MATCH_ANY 0xffffffff
 
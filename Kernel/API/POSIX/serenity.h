@@ -42,6 +42,85 @@ enum {
 #define THREAD_PRIORITY_HIGH 50
 #define THREAD_PRIORITY_MAX 99
 
+#define READINESS_SET_CLOEXEC 0x1
+
+#define READINESS_SET_ADD 1
+#define READINESS_SET_MODIFY 2
+#define READINESS_SET_REMOVE 3
+
+#define READINESS_READ 0x1
+#define READINESS_WRITE 0x2
+#define READINESS_EDGE_TRIGGERED 0x80000000
+
+struct readiness_event {
+    int fd;
+    uint32_t events;
+    uint64_t user_data;
+};
+
+#define IO_RING_CLOEXEC 0x1
+#define IO_RING_MAX_ENTRIES 4096
+
+#define IO_RING_OP_NOP 0
+#define IO_RING_OP_READ 1
+#define IO_RING_OP_WRITE 2
+#define IO_RING_OP_READV 3
+#define IO_RING_OP_WRITEV 4
+#define IO_RING_OP_ACCEPT 5
+#define IO_RING_OP_CONNECT 6
+#define IO_RING_OP_POLL 7
+#define IO_RING_OP_FSYNC 8
+#define IO_RING_OP_CANCEL 9
+
+// Reads and writes with this offset use (and advance) the file offset, like read() and write() do.
+#define IO_RING_OFFSET_CURRENT ((uint64_t)-1)
+
+// An entry in the submission queue.
+//
+// - READ/WRITE: address and length describe the buffer.
+// - READV/WRITEV: address points to an array of `length` iovecs.
+// - ACCEPT: address and length (if nonzero) receive the peer address, flags takes SOCK_NONBLOCK and SOCK_CLOEXEC.
+// - CONNECT: address and length describe the sockaddr to connect to.
+// - POLL: poll_events takes POLLIN and/or POLLOUT, the result is the ready subset of them.
+// - CANCEL: address is the user_data of the request to cancel.
+struct io_ring_submission {
+    uint8_t opcode;
+    uint8_t reserved;
+    uint16_t poll_events;
+    int32_t fd;
+    uint64_t offset;
+    uint64_t address;
+    uint32_t length;
+    uint32_t flags;
+    uint64_t user_data;
+};
+
+// An entry in the completion queue. The result is what the equivalent syscall would have returned, or -errno.
+struct io_ring_completion {
+    uint64_t user_data;
+    int32_t result;
+    uint32_t flags;
+};
+
+// Lives at the start of the ring mapping. Userspace advances submission_tail and completion_head,
+// the kernel advances submission_head and completion_tail.
+struct io_ring_header {
+    uint32_t submission_head;
+    uint32_t submission_tail;
+    uint32_t completion_head;
+    uint32_t completion_tail;
+    uint32_t dropped_completions;
+};
+
+// Filled in by io_ring_create(), describes how to mmap() the ring and where its queues are.
+struct io_ring_params {
+    uint32_t submission_entries;
+    uint32_t completion_entries;
+    uint32_t submissions_offset;
+    uint32_t completions_offset;
+    uint32_t mapping_size;
+};
+
 #ifdef __cplusplus
 }
 #endif
@@ -36,6 +36,8 @@ extern "C" {
 #define MADV_SET_VOLATILE 0x1
 #define MADV_SET_NONVOLATILE 0x2
 #define MADV_DONTNEED 0x3
+#define MADV_HUGEPAGE 0x4
+#define MADV_NOHUGEPAGE 0x5
 
 // https://pubs.opengroup.org/onlinepubs/9699919799/functions/posix_madvise.html
 #define POSIX_MADV_NORMAL MADV_NORMAL
@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Types.h>
+
+namespace Kernel {
+
+// The binary format of /proc/process_statistics.
+//
+// The first read after opening the file returns every process. Each time the file
+// is rewound with lseek(fd, 0, SEEK_SET), the next read only contains full records
+// for the processes that may have changed since the previous one, along with the
+// PIDs of all living processes, so readers can tell which ones have gone away.
+//
+// A snapshot starts with a ProcessStatisticsHeader, followed by `process_count` u32
+// PIDs and `changed_process_count` process records. Each process record is a
+// ProcessStatisticsRecord, followed by its strings (name, executable, tty, pledge
+// and veil, without null terminators) and then `thread_count` thread records. Each
+// thread record is a ThreadStatisticsRecord, followed by its name and state strings.
+//
+// Records are packed, and each one starts with its total size including the strings
+// and threads that follow it. Any change to the layout bumps the version.
+
+static constexpr u32 process_statistics_magic = 0x53545350; // "PSTS"
+static constexpr u32 process_statistics_version = 1;
+
+struct [[gnu::packed]] ProcessStatisticsHeader {
+    u32 magic;
+    u32 version;
+    u32 header_size;
+    u32 process_count;
+    u32 changed_process_count;
+    // Zero if this is a full snapshot.
+    u64 since_generation;
+    u64 generation;
+    u64 total_time_scheduled;
+    u64 total_time_scheduled_kernel;
+};
+
+struct [[gnu::packed]] ProcessStatisticsRecord {
+    u32 record_size;
+    u32 pid;
+    u32 pgid;
+    u32 pgp;
+    u32 sid;
+    u32 uid;
+    u32 gid;
+    u32 ppid;
+    u32 nfds;
+    u8 kernel;
+    u8 dumpable;
+    u16 name_length;
+    u16 executable_length;
+    u16 tty_length;
+    u16 pledge_length;
+    u16 veil_length;
+    u64 amount_virtual;
+    u64 amount_resident;
+    u64 amount_shared;
+    u64 amount_dirty_private;
+    u64 amount_clean_inode;
+    u64 amount_purgeable_volatile;
+    u64 amount_purgeable_nonvolatile;
+    u32 thread_count;
+};
+
+struct [[gnu::packed]] ThreadStatisticsRecord {
+    u32 record_size;
+    u32 tid;
+    u32 times_scheduled;
+    u64 time_user;
+    u64 time_kernel;
+    u32 cpu;
+    u32 priority;
+    u64 syscall_count;
+    u64 inode_faults;
+    u64 zero_faults;
+    u64 cow_faults;
+    u64 file_read_bytes;
+    u64 file_write_bytes;
+    u64 unix_socket_read_bytes;
+    u64 unix_socket_write_bytes;
+    u64 ipv4_socket_read_bytes;
+    u64 ipv4_socket_write_bytes;
+    u16 name_length;
+    u16 state_length;
+};
+
+}
@@ -20,6 +20,8 @@ extern "C" {
 struct pollfd;
 struct timeval;
 struct timespec;
+struct io_ring_params;
+struct readiness_event;
 struct sockaddr;
 struct siginfo;
 struct stat;
@@ -61,6 +63,7 @@ enum class NeedsBigProcessLock {
     S(close, NeedsBigProcessLock::Yes)                      \
     S(connect, NeedsBigProcessLock::Yes)                    \
     S(create_inode_watcher, NeedsBigProcessLock::Yes)       \
+    S(create_readiness_set, NeedsBigProcessLock::Yes)       \
     S(create_thread, NeedsBigProcessLock::Yes)              \
     S(dbgputstr, NeedsBigProcessLock::No)                   \
     S(detach_thread, NeedsBigProcessLock::Yes)              \
@@ -76,11 +79,11 @@ enum class NeedsBigProcessLock {
     S(fchown, NeedsBigProcessLock::Yes)                     \
     S(fcntl, NeedsBigProcessLock::Yes)                      \
     S(fork, NeedsBigProcessLock::Yes)                       \
-    S(fstat, NeedsBigProcessLock::Yes)                      \
+    S(fstat, NeedsBigProcessLock::No)                       \
     S(fstatvfs, NeedsBigProcessLock::Yes)                   \
     S(fsync, NeedsBigProcessLock::Yes)                      \
     S(ftruncate, NeedsBigProcessLock::Yes)                  \
-    S(futex, NeedsBigProcessLock::Yes)                      \
+    S(futex, NeedsBigProcessLock::No)                       \
     S(get_dir_entries, NeedsBigProcessLock::Yes)            \
     S(get_process_name, NeedsBigProcessLock::Yes)           \
     S(get_stack_bounds, NeedsBigProcessLock::No)            \
@@ -107,6 +110,8 @@ enum class NeedsBigProcessLock {
     S(getuid, NeedsBigProcessLock::Yes)                     \
     S(inode_watcher_add_watch, NeedsBigProcessLock::Yes)    \
     S(inode_watcher_remove_watch, NeedsBigProcessLock::Yes) \
+    S(io_ring_create, NeedsBigProcessLock::Yes)             \
+    S(io_ring_enter, NeedsBigProcessLock::No)               \
     S(ioctl, NeedsBigProcessLock::Yes)                      \
     S(join_thread, NeedsBigProcessLock::Yes)                \
     S(kill, NeedsBigProcessLock::Yes)                       \
@@ -114,7 +119,7 @@ enum class NeedsBigProcessLock {
     S(killpg, NeedsBigProcessLock::Yes)                     \
     S(link, NeedsBigProcessLock::Yes)                       \
     S(listen, NeedsBigProcessLock::Yes)                     \
-    S(lseek, NeedsBigProcessLock::Yes)                      \
+    S(lseek, NeedsBigProcessLock::No)                       \
     S(madvise, NeedsBigProcessLock::Yes)                    \
     S(map_time_page, NeedsBigProcessLock::Yes)              \
     S(mkdir, NeedsBigProcessLock::Yes)                      \
@@ -131,7 +136,7 @@ enum class NeedsBigProcessLock {
     S(perf_register_string, NeedsBigProcessLock::Yes)       \
     S(pipe, NeedsBigProcessLock::Yes)                       \
     S(pledge, NeedsBigProcessLock::Yes)                     \
-    S(poll, NeedsBigProcessLock::Yes)                       \
+    S(poll, NeedsBigProcessLock::No)                        \
     S(prctl, NeedsBigProcessLock::Yes)                      \
     S(profiling_disable, NeedsBigProcessLock::Yes)          \
     S(profiling_enable, NeedsBigProcessLock::Yes)           \
@@ -139,19 +144,23 @@ enum class NeedsBigProcessLock {
     S(ptrace, NeedsBigProcessLock::Yes)                     \
     S(ptsname, NeedsBigProcessLock::Yes)                    \
     S(purge, NeedsBigProcessLock::Yes)                      \
-    S(read, NeedsBigProcessLock::Yes)                       \
-    S(pread, NeedsBigProcessLock::Yes)                      \
+    S(read, NeedsBigProcessLock::No)                        \
+    S(pread, NeedsBigProcessLock::No)                       \
+    S(preadv, NeedsBigProcessLock::No)                      \
     S(readlink, NeedsBigProcessLock::Yes)                   \
-    S(readv, NeedsBigProcessLock::Yes)                      \
+    S(readiness_set_control, NeedsBigProcessLock::No)       \
+    S(readiness_set_wait, NeedsBigProcessLock::No)          \
+    S(readv, NeedsBigProcessLock::No)                       \
     S(realpath, NeedsBigProcessLock::Yes)                   \
     S(recvfd, NeedsBigProcessLock::Yes)                     \
-    S(recvmsg, NeedsBigProcessLock::Yes)                    \
+    S(recvmsg, NeedsBigProcessLock::No)                     \
     S(rename, NeedsBigProcessLock::Yes)                     \
     S(rmdir, NeedsBigProcessLock::Yes)                      \
     S(sched_getparam, NeedsBigProcessLock::Yes)             \
     S(sched_setparam, NeedsBigProcessLock::Yes)             \
     S(sendfd, NeedsBigProcessLock::Yes)                     \
-    S(sendmsg, NeedsBigProcessLock::Yes)                    \
+    S(sendfile, NeedsBigProcessLock::No)                    \
+    S(sendmsg, NeedsBigProcessLock::No)                     \
     S(set_coredump_metadata, NeedsBigProcessLock::Yes)      \
     S(set_mmap_name, NeedsBigProcessLock::Yes)              \
     S(set_process_name, NeedsBigProcessLock::Yes)           \
@@ -191,9 +200,12 @@ enum class NeedsBigProcessLock {
     S(unlink, NeedsBigProcessLock::Yes)                     \
     S(unveil, NeedsBigProcessLock::Yes)                     \
     S(utime, NeedsBigProcessLock::Yes)                      \
+    S(vfork, NeedsBigProcessLock::Yes)                      \
     S(waitid, NeedsBigProcessLock::Yes)                     \
-    S(write, NeedsBigProcessLock::Yes)                      \
-    S(writev, NeedsBigProcessLock::Yes)                     \
+    S(write, NeedsBigProcessLock::No)                       \
+    S(pwrite, NeedsBigProcessLock::No)                      \
+    S(pwritev, NeedsBigProcessLock::No)                     \
+    S(writev, NeedsBigProcessLock::No)                      \
     S(yield, NeedsBigProcessLock::No)
 
 namespace Syscall {
@@ -270,6 +282,35 @@ struct SC_poll_params {
     const u32* sigmask;
 };
 
+struct SC_readiness_set_control_params {
+    int set_fd;
+    int operation;
+    int fd;
+    u32 events;
+    u64 user_data;
+};
+
+struct SC_readiness_set_wait_params {
+    int set_fd;
+    struct readiness_event* events;
+    size_t max_events;
+    const struct timespec* timeout;
+};
+
+struct SC_io_ring_enter_params {
+    int ring_fd;
+    u32 to_submit;
+    u32 min_complete;
+    const struct timespec* timeout;
+};
+
+struct SC_sendfile_params {
+    int out_fd;
+    int in_fd;
+    off_t* offset;
+    size_t count;
+};
+
 struct SC_clock_nanosleep_params {
     int clock_id;
     int flags;
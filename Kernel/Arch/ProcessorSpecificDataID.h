@@ -10,6 +10,7 @@ namespace Kernel {
 
 enum class ProcessorSpecificDataID {
     MemoryManager,
+    KmallocCache,
     __Count,
 };
 
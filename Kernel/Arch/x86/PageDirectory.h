@@ -25,6 +25,14 @@ public:
         m_raw |= PhysicalAddress::physical_page_base(value);
     }
 
+    // Only meaningful if this entry maps a large page (is_huge()) instead of pointing to a page table.
+    PhysicalPtr large_page_base() const { return m_raw & large_page_base_mask; }
+    void set_large_page_base(PhysicalPtr value)
+    {
+        m_raw &= 0x8000000000000fffULL;
+        m_raw |= value & large_page_base_mask;
+    }
+
     bool is_null() const { return m_raw == 0; }
     void clear() { m_raw = 0; }
 
@@ -67,6 +75,9 @@ public:
     void set_execute_disabled(bool b) { set_bit(NoExecute, b); }
 
 private:
+    // Bits 51:21, as large pages are 2 MiB aligned.
+    static constexpr u64 large_page_base_mask = 0x000fffffffe00000ULL;
+
     void set_bit(u64 bit, bool value)
     {
         if (value)
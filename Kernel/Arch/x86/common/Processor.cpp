@@ -343,6 +343,8 @@ UNMAP_AFTER_INIT void Processor::early_initialize(u32 cpu)
     m_idle_thread = nullptr;
     m_current_thread = nullptr;
     m_info = nullptr;
+    for (auto& specific_data : m_processor_specific_data)
+        specific_data = nullptr;
 
     m_halt_requested = false;
     if (cpu == 0) {
@@ -7,15 +7,40 @@
 #include <AK/AnyOf.h>
 #include <Kernel/Bus/PCI/API.h>
 #include <Kernel/Bus/PCI/Device.h>
+#include <Kernel/Interrupts/APIC.h>
+#include <Kernel/Memory/MemoryManager.h>
 
 namespace Kernel {
 namespace PCI {
 
+namespace MSIX {
+static constexpr u32 message_control_offset = 0x2;
+static constexpr u32 table_offset_offset = 0x4;
+static constexpr u16 message_control_table_size_mask = 0x7ff;
+static constexpr u16 message_control_function_mask = 1 << 14;
+static constexpr u16 message_control_enable = 1 << 15;
+static constexpr u32 table_bir_mask = 0x7;
+static constexpr size_t table_entry_size = 16;
+static constexpr u32 vector_control_masked = 1 << 0;
+
+struct [[gnu::packed]] TableEntry {
+    u32 message_address_low;
+    u32 message_address_high;
+    u32 message_data;
+    u32 vector_control;
+};
+static_assert(sizeof(TableEntry) == table_entry_size);
+}
+
 Device::Device(Address address)
     : m_pci_address(address)
 {
 }
 
+Device::~Device()
+{
+}
+
 bool Device::is_msi_capable() const
 {
     return AK::any_of(
@@ -48,11 +73,73 @@ void Device::disable_message_signalled_interrupts()
 }
 void Device::enable_extended_message_signalled_interrupts()
 {
-    TODO();
+    auto capability = msix_capability();
+    VERIFY(capability.has_value());
+    auto message_control = capability->read16(MSIX::message_control_offset);
+    message_control |= MSIX::message_control_enable;
+    message_control &= ~MSIX::message_control_function_mask;
+    capability->write16(MSIX::message_control_offset, message_control);
+    // While MSI-X is enabled the device isn't supposed to assert its interrupt pin anyway, but make sure of it.
+    disable_pin_based_interrupts();
 }
 void Device::disable_extended_message_signalled_interrupts()
 {
-    TODO();
+    auto capability = msix_capability();
+    VERIFY(capability.has_value());
+    auto message_control = capability->read16(MSIX::message_control_offset);
+    capability->write16(MSIX::message_control_offset, message_control & ~MSIX::message_control_enable);
+}
+
+Optional<Capability> Device::msix_capability() const
+{
+    for (auto const& capability : PCI::get_device_identifier(pci_address()).capabilities()) {
+        if (capability.id().value() == PCI::Capabilities::ID::MSIX)
+            return capability;
+    }
+    return {};
+}
+
+size_t Device::msix_vector_count() const
+{
+    auto capability = msix_capability();
+    if (!capability.has_value())
+        return 0;
+    return (capability->read16(MSIX::message_control_offset) & MSIX::message_control_table_size_mask) + 1;
+}
+
+ErrorOr<void> Device::map_msix_table()
+{
+    if (m_msix_table_region)
+        return {};
+    auto capability = msix_capability();
+    if (!capability.has_value())
+        return ENOTSUP;
+    auto table_offset_and_bir = capability->read32(MSIX::table_offset_offset);
+    auto bir = static_cast<u8>(table_offset_and_bir & MSIX::table_bir_mask);
+    if (bir > 5)
+        return EINVAL;
+    // FIXME: Support MSI-X tables in 64-bit BARs above 4 GiB.
+    auto table_address = PhysicalAddress((PCI::get_BAR(pci_address(), bir) & 0xfffffff0) + (table_offset_and_bir & ~MSIX::table_bir_mask));
+    auto table_size = msix_vector_count() * MSIX::table_entry_size;
+    auto region_size = TRY(Memory::page_round_up(static_cast<size_t>(table_address.offset_in_page()) + table_size));
+    m_msix_table_region = TRY(MM.allocate_kernel_region(table_address.page_base(), region_size, "PCI MSI-X Table"sv, Memory::Region::Access::ReadWrite, Memory::Region::Cacheable::No));
+    m_msix_table_offset_in_region = static_cast<size_t>(table_address.offset_in_page());
+    return {};
+}
+
+ErrorOr<void> Device::set_up_msix_vector(size_t index, u32 cpu, u8 interrupt_number)
+{
+    if (index >= msix_vector_count())
+        return EINVAL;
+    TRY(map_msix_table());
+    auto message = TRY(APIC::the().message_signalled_interrupt_for(cpu, interrupt_number));
+    auto* entry = reinterpret_cast<MSIX::TableEntry volatile*>(m_msix_table_region->vaddr().offset(m_msix_table_offset_in_region + index * MSIX::table_entry_size).as_ptr());
+    entry->vector_control = entry->vector_control | MSIX::vector_control_masked;
+    entry->message_address_low = message.address;
+    entry->message_address_high = 0;
+    entry->message_data = message.data;
+    entry->vector_control = entry->vector_control & ~MSIX::vector_control_masked;
+    return {};
 }
 
 }
@@ -6,8 +6,11 @@
 
 #pragma once
 
+#include <AK/Error.h>
+#include <AK/OwnPtr.h>
 #include <AK/Types.h>
 #include <Kernel/Bus/PCI/Definitions.h>
+#include <Kernel/Forward.h>
 
 namespace Kernel {
 namespace PCI {
@@ -16,7 +19,7 @@ class Device {
 public:
     Address pci_address() const { return m_pci_address; };
 
-    virtual ~Device() = default;
+    virtual ~Device();
     void enable_pin_based_interrupts() const;
     void disable_pin_based_interrupts() const;
 
@@ -29,11 +32,21 @@ public:
     void enable_extended_message_signalled_interrupts();
     void disable_extended_message_signalled_interrupts();
 
+    // The number of entries in the MSI-X table, or 0 if the device isn't MSI-X capable.
+    size_t msix_vector_count() const;
+    // Points MSI-X table entry `index` at the local APIC of `cpu`, and unmasks it.
+    ErrorOr<void> set_up_msix_vector(size_t index, u32 cpu, u8 interrupt_number);
+
 protected:
     explicit Device(Address pci_address);
 
 private:
+    Optional<Capability> msix_capability() const;
+    ErrorOr<void> map_msix_table();
+
     Address m_pci_address;
+    OwnPtr<Memory::Region> m_msix_table_region;
+    size_t m_msix_table_offset_in_region { 0 };
 };
 
 }
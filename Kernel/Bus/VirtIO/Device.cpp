@@ -35,6 +35,14 @@ UNMAP_AFTER_INIT void detect()
             rng.initialize();
             break;
         }
+        case PCI::DeviceID::VirtIONetAdapter: {
+            // This should have been initialized by the networking subsystem
+            break;
+        }
+        case PCI::DeviceID::VirtIOBlockDevice: {
+            // This should have been initialized by the storage subsystem
+            break;
+        }
         case PCI::DeviceID::VirtIOGPU: {
             // This should have been initialized by the graphics subsystem
             break;
@@ -264,10 +272,7 @@ bool Device::accept_device_features(u64 device_features, u64 accepted_features)
         accepted_features &= ~(VIRTIO_F_RING_PACKED);
     }
 
-    // TODO: implement indirect descriptors to allow queue_size buffers instead of buffers totalling (PAGE_SIZE * queue_size) bytes
-    if (is_feature_set(device_features, VIRTIO_F_INDIRECT_DESC)) {
-        // accepted_features |= VIRTIO_F_INDIRECT_DESC;
-    }
+    // NOTE: VIRTIO_F_INDIRECT_DESC is left to the drivers that build indirect descriptor tables.
 
     if (is_feature_set(device_features, VIRTIO_F_IN_ORDER)) {
         accepted_features |= VIRTIO_F_IN_ORDER;
@@ -419,23 +424,38 @@ bool Device::handle_irq(const RegisterState&)
     }
     if (isr_type & QUEUE_INTERRUPT) {
         dbgln_if(VIRTIO_DEBUG, "{}: VirtIO Queue interrupt!", class_name());
+        // NOTE: There is only one interrupt for all queues, so every queue that has something new has to be handled here.
+        bool handled_any_queue = false;
         for (size_t i = 0; i < m_queues.size(); i++) {
             if (get_queue(i).new_data_available()) {
                 handle_queue_update(i);
-                return true;
+                handled_any_queue = true;
             }
         }
-        dbgln_if(VIRTIO_DEBUG, "{}: Got queue interrupt but all queues are up to date!", class_name());
+        if (!handled_any_queue)
+            dbgln_if(VIRTIO_DEBUG, "{}: Got queue interrupt but all queues are up to date!", class_name());
     }
     return true;
 }
 
 void Device::supply_chain_and_notify(u16 queue_index, QueueChain& chain)
+{
+    supply_chain(queue_index, chain);
+    notify_queue_if_needed(queue_index);
+}
+
+void Device::supply_chain(u16 queue_index, QueueChain& chain)
 {
     auto& queue = get_queue(queue_index);
     VERIFY(&chain.queue() == &queue);
     VERIFY(queue.lock().is_locked());
     chain.submit_to_queue();
+}
+
+void Device::notify_queue_if_needed(u16 queue_index)
+{
+    auto& queue = get_queue(queue_index);
+    VERIFY(queue.lock().is_locked());
     if (queue.should_notify())
         notify_queue(queue_index);
 }
@@ -28,10 +28,19 @@ enum class BufferType {
 
 class Queue {
 public:
+    // Also the layout of the entries in an indirect descriptor table.
+    struct [[gnu::packed]] QueueDescriptor {
+        u64 address;
+        u32 length;
+        u16 flags;
+        u16 next;
+    };
+
     static ErrorOr<NonnullOwnPtr<Queue>> try_create(u16 queue_size, u16 notify_offset);
 
     ~Queue();
 
+    u16 size() const { return m_queue_size; }
     u16 notify_offset() const { return m_notify_offset; }
 
     void enable_interrupts();
@@ -61,13 +70,6 @@ private:
         auto offset = FlatPtr(ptr) - m_queue_region->vaddr().get();
         return m_queue_region->physical_page(0)->paddr().offset(offset);
     }
-    struct [[gnu::packed]] QueueDescriptor {
-        u64 address;
-        u32 length;
-        u16 flags;
-        u16 next;
-    };
-
     struct [[gnu::packed]] QueueDriver {
         u16 flags;
         u16 index;
@@ -153,6 +155,9 @@ public:
     [[nodiscard]] bool is_empty() const { return m_chain_length == 0; }
     [[nodiscard]] size_t length() const { return m_chain_length; }
     bool add_buffer_to_chain(PhysicalAddress buffer_start, size_t buffer_length, BufferType buffer_type);
+    // Hands the device a whole chain through a single descriptor, which points to a table of QueueDescriptors.
+    // Requires VIRTIO_F_INDIRECT_DESC, and has to be the only buffer in the chain.
+    bool add_indirect_table_to_chain(PhysicalAddress table_start, size_t descriptor_count);
     void submit_to_queue();
     void release_buffer_slots_to_queue();
 
@@ -170,6 +170,11 @@ UNMAP_AFTER_INIT bool CommandLine::is_force_pio() const
     return contains("force_pio"sv);
 }
 
+UNMAP_AFTER_INIT bool CommandLine::is_nvme_polling_enabled() const
+{
+    return contains("nvme_poll"sv);
+}
+
 UNMAP_AFTER_INIT StringView CommandLine::root_device() const
 {
     return lookup("root"sv).value_or("/dev/hda"sv);
@@ -239,6 +244,16 @@ UNMAP_AFTER_INIT AHCIResetMode CommandLine::ahci_reset_mode() const
     PANIC("Unknown AHCIResetMode: {}", ahci_reset_mode);
 }
 
+TCPCongestionControlAlgorithm CommandLine::tcp_congestion_control_algorithm() const
+{
+    const auto algorithm = lookup("tcp_congestion_control"sv).value_or("cubic"sv);
+    if (algorithm == "cubic"sv)
+        return TCPCongestionControlAlgorithm::CUBIC;
+    if (algorithm == "newreno"sv)
+        return TCPCongestionControlAlgorithm::NewReno;
+    PANIC("Unknown TCPCongestionControlAlgorithm: {}", algorithm);
+}
+
 StringView CommandLine::system_mode() const
 {
     return lookup("system_mode"sv).value_or("graphical"sv);
@@ -40,6 +40,11 @@ enum class AHCIResetMode {
     Aggressive,
 };
 
+enum class TCPCongestionControlAlgorithm {
+    NewReno,
+    CUBIC,
+};
+
 class CommandLine {
 
 public:
@@ -74,6 +79,7 @@ public:
     [[nodiscard]] bool is_pc_speaker_enabled() const;
     [[nodiscard]] FrameBufferDevices are_framebuffer_devices_enabled() const;
     [[nodiscard]] bool is_force_pio() const;
+    [[nodiscard]] bool is_nvme_polling_enabled() const;
     [[nodiscard]] AcpiFeatureLevel acpi_feature_level() const;
     [[nodiscard]] StringView system_mode() const;
     [[nodiscard]] PanicMode panic_mode(Validate should_validate = Validate::No) const;
@@ -84,6 +90,7 @@ public:
     [[nodiscard]] bool disable_usb() const;
     [[nodiscard]] bool disable_virtio() const;
     [[nodiscard]] AHCIResetMode ahci_reset_mode() const;
+    [[nodiscard]] TCPCongestionControlAlgorithm tcp_congestion_control_algorithm() const;
     [[nodiscard]] StringView userspace_init() const;
     [[nodiscard]] NonnullOwnPtrVector<KString> userspace_init_args() const;
     [[nodiscard]] StringView root_device() const;
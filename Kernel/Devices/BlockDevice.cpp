@@ -21,6 +21,13 @@ AsyncBlockDeviceRequest::AsyncBlockDeviceRequest(Device& block_device, RequestTy
 
 void AsyncBlockDeviceRequest::start()
 {
+    bool is_unsupported = (m_request_type == Flush && !m_block_device.supports_flush())
+        || (m_request_type == Discard && !m_block_device.supports_discard());
+    if (is_unsupported) {
+        // Without a volatile write cache there is nothing to flush, and discarding is only ever a hint.
+        complete(Success);
+        return;
+    }
     m_block_device.start_request(*this);
 }
 
@@ -80,4 +87,30 @@ bool BlockDevice::write_block(u64 index, const UserOrKernelBuffer& buffer)
     return false;
 }
 
+ErrorOr<void> BlockDevice::flush_write_cache()
+{
+    return submit_request_without_data(AsyncBlockDeviceRequest::Flush, 0, 0);
+}
+
+ErrorOr<void> BlockDevice::discard_blocks(u64 index, u32 count)
+{
+    return submit_request_without_data(AsyncBlockDeviceRequest::Discard, index, count);
+}
+
+ErrorOr<void> BlockDevice::submit_request_without_data(AsyncBlockDeviceRequest::RequestType request_type, u64 index, u32 count)
+{
+    auto request = TRY(try_make_request<AsyncBlockDeviceRequest>(request_type, index, count, UserOrKernelBuffer::for_kernel_buffer(nullptr), 0));
+    auto result = request->wait();
+    if (result.wait_result().was_interrupted())
+        return EINTR;
+    switch (result.request_result()) {
+    case AsyncDeviceRequest::Success:
+        return {};
+    case AsyncDeviceRequest::MemoryFault:
+        return EFAULT;
+    default:
+        return EIO;
+    }
+}
+
 }
@@ -17,7 +17,11 @@ class AsyncBlockDeviceRequest final : public AsyncDeviceRequest {
 public:
     enum RequestType {
         Read,
-        Write
+        Write,
+        // Makes everything the device has acknowledged so far persistent. Covers no blocks.
+        Flush,
+        // Tells the device that the blocks no longer hold anything of value. Carries no data.
+        Discard,
     };
     AsyncBlockDeviceRequest(Device& block_device, RequestType request_type,
         u64 block_index, u32 block_count, const UserOrKernelBuffer& buffer, size_t buffer_size);
@@ -37,6 +41,10 @@ public:
             return "BlockDeviceRequest (read)"sv;
         case Write:
             return "BlockDeviceRequest (write)"sv;
+        case Flush:
+            return "BlockDeviceRequest (flush)"sv;
+        case Discard:
+            return "BlockDeviceRequest (discard)"sv;
         default:
             VERIFY_NOT_REACHED();
         }
@@ -61,6 +69,14 @@ public:
     bool read_block(u64 index, UserOrKernelBuffer&);
     bool write_block(u64 index, const UserOrKernelBuffer&);
 
+    // Flush and discard requests for devices that don't support them complete right away,
+    // so start_request() only ever sees them if these return true.
+    virtual bool supports_flush() const { return false; }
+    virtual bool supports_discard() const { return false; }
+
+    ErrorOr<void> flush_write_cache();
+    ErrorOr<void> discard_blocks(u64 index, u32 count);
+
     virtual void start_request(AsyncBlockDeviceRequest&) = 0;
 
 protected:
@@ -75,6 +91,8 @@ protected:
 private:
     virtual bool is_block_device() const final { return true; }
 
+    ErrorOr<void> submit_request_without_data(AsyncBlockDeviceRequest::RequestType, u64 index, u32 count);
+
     size_t m_block_size { 0 };
 };
 
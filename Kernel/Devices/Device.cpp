@@ -155,11 +155,20 @@ void Device::process_next_queued_request(Badge<AsyncDeviceRequest>, const AsyncD
 {
     SpinlockLocker lock(m_requests_lock);
     VERIFY(!m_requests.is_empty());
-    VERIFY(m_requests.first().ptr() == &completed_request);
-    m_requests.remove(m_requests.begin());
-    if (!m_requests.is_empty()) {
-        auto* next_request = m_requests.first().ptr();
-        next_request->do_start(move(lock));
+    if (can_process_requests_concurrently()) {
+        // Requests complete in any order, and all of them have been started already.
+        auto it = m_requests.begin();
+        while (it != m_requests.end() && it->ptr() != &completed_request)
+            ++it;
+        VERIFY(it != m_requests.end());
+        m_requests.remove(it);
+    } else {
+        VERIFY(m_requests.first().ptr() == &completed_request);
+        m_requests.remove(m_requests.begin());
+        if (!m_requests.is_empty()) {
+            auto* next_request = m_requests.first().ptr();
+            next_request->do_start(move(lock));
+        }
     }
 
     evaluate_block_conditions();
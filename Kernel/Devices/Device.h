@@ -58,11 +58,15 @@ public:
         SpinlockLocker lock(m_requests_lock);
         bool was_empty = m_requests.is_empty();
         m_requests.append(request);
-        if (was_empty)
+        if (was_empty || can_process_requests_concurrently())
             request->do_start(move(lock));
         return request;
     }
 
+    // Devices that can have several requests in flight (each tracking its own completion)
+    // start every request right away, instead of waiting for the previous one to finish.
+    virtual bool can_process_requests_concurrently() const { return false; }
+
 protected:
     Device(MajorNumber major, MinorNumber minor);
     void set_uid(UserID uid) { m_uid = uid; }
@@ -6,8 +6,11 @@
 
 #include <AK/IntrusiveList.h>
 #include <Kernel/Debug.h>
+#include <Kernel/Devices/BlockDevice.h>
 #include <Kernel/FileSystem/BlockBasedFileSystem.h>
 #include <Kernel/Process.h>
+#include <Kernel/Tasks/SyncTask.h>
+#include <Kernel/Time/TimeManagement.h>
 
 namespace Kernel {
 
@@ -16,15 +19,29 @@ struct CacheEntry {
     BlockBasedFileSystem::BlockIndex block_index { 0 };
     u8* data { nullptr };
     bool has_data { false };
+    // When (and in which order) this entry went from clean to dirty.
+    u64 dirtied_at_ms { 0 };
+    u64 dirty_sequence { 0 };
 };
 
 class DiskCache {
 public:
     static constexpr size_t EntryCount = 10000;
-    explicit DiskCache(BlockBasedFileSystem& fs, NonnullOwnPtr<KBuffer> cached_block_data, NonnullOwnPtr<KBuffer> entries_buffer)
+    // Runs of contiguous blocks are moved to and from the device in requests of up to this size.
+    static constexpr size_t MaxRunSize = 64 * KiB;
+
+    // Above this many dirty entries, the SyncTask starts writing back in the background.
+    static constexpr size_t BackgroundDirtyLimit = EntryCount / 10;
+    // Above this many, writers have to write back the oldest entries themselves before dirtying more.
+    static constexpr size_t DirtyLimit = EntryCount / 4;
+    // Entries that have been dirty for this long are written back in the background regardless.
+    static constexpr u64 DirtyExpireMilliseconds = 1000;
+
+    explicit DiskCache(BlockBasedFileSystem& fs, NonnullOwnPtr<KBuffer> cached_block_data, NonnullOwnPtr<KBuffer> entries_buffer, NonnullOwnPtr<KBuffer> run_buffer)
         : m_fs(fs)
         , m_cached_block_data(move(cached_block_data))
         , m_entries(move(entries_buffer))
+        , m_run_buffer(move(run_buffer))
     {
         for (size_t i = 0; i < EntryCount; ++i) {
             entries()[i].data = m_cached_block_data->data() + i * m_fs.block_size();
@@ -36,23 +53,36 @@ public:
 
     bool is_dirty() const { return !m_dirty_list.is_empty(); }
     bool entry_is_dirty(CacheEntry const& entry) const { return m_dirty_list.contains(entry); }
+    size_t dirty_count() const { return m_dirty_count; }
+    u64 next_dirty_sequence() const { return m_next_dirty_sequence; }
 
     void mark_all_clean()
     {
         while (auto* entry = m_dirty_list.first())
             m_clean_list.prepend(*entry);
+        m_dirty_count = 0;
     }
 
     void mark_dirty(CacheEntry& entry)
     {
+        // An entry that is dirtied again keeps its place, so the back of the list is always the oldest.
+        if (entry_is_dirty(entry))
+            return;
+        entry.dirtied_at_ms = TimeManagement::the().uptime_ms();
+        entry.dirty_sequence = m_next_dirty_sequence++;
         m_dirty_list.prepend(entry);
+        ++m_dirty_count;
     }
 
     void mark_clean(CacheEntry& entry)
     {
+        if (entry_is_dirty(entry))
+            --m_dirty_count;
         m_clean_list.prepend(entry);
     }
 
+    CacheEntry* oldest_dirty_entry() const { return m_dirty_list.last(); }
+
     CacheEntry* get(BlockBasedFileSystem::BlockIndex block_index) const
     {
         auto it = m_hash.find(block_index);
@@ -63,16 +93,22 @@ public:
         return &entry;
     }
 
-    CacheEntry& ensure(BlockBasedFileSystem::BlockIndex block_index) const
+    bool has_data_for(BlockBasedFileSystem::BlockIndex block_index) const
+    {
+        auto* entry = get(block_index);
+        return entry && entry->has_data;
+    }
+
+    ErrorOr<CacheEntry*> ensure(BlockBasedFileSystem::BlockIndex block_index) const
     {
         if (auto* entry = get(block_index))
-            return *entry;
+            return entry;
 
         if (m_clean_list.is_empty()) {
             // Not a single clean entry! Flush writes and try again.
             // NOTE: We want to make sure we only call FileBackedFileSystem flush here,
             //       not some FileBackedFileSystem subclass flush!
-            m_fs.flush_writes_impl();
+            TRY(m_fs.flush_writes_impl());
             return ensure(block_index);
         }
 
@@ -86,7 +122,7 @@ public:
         new_entry.block_index = block_index;
         new_entry.has_data = false;
 
-        return new_entry;
+        return &new_entry;
     }
 
     const CacheEntry* entries() const { return (const CacheEntry*)m_entries->data(); }
@@ -99,13 +135,20 @@ public:
             callback(entry);
     }
 
+    // Scratch space for assembling a run of blocks, only to be used while holding the cache lock.
+    u8* run_buffer() { return m_run_buffer->data(); }
+    size_t max_run_block_count() const { return m_run_buffer->size() / m_fs.block_size(); }
+
 private:
     BlockBasedFileSystem& m_fs;
     mutable HashMap<BlockBasedFileSystem::BlockIndex, CacheEntry*> m_hash;
     mutable IntrusiveList<&CacheEntry::list_node> m_clean_list;
     mutable IntrusiveList<&CacheEntry::list_node> m_dirty_list;
+    size_t m_dirty_count { 0 };
+    u64 m_next_dirty_sequence { 0 };
     NonnullOwnPtr<KBuffer> m_cached_block_data;
     NonnullOwnPtr<KBuffer> m_entries;
+    NonnullOwnPtr<KBuffer> m_run_buffer;
 };
 
 BlockBasedFileSystem::BlockBasedFileSystem(OpenFileDescription& file_description)
@@ -123,7 +166,8 @@ ErrorOr<void> BlockBasedFileSystem::initialize()
     VERIFY(block_size() != 0);
     auto cached_block_data = TRY(KBuffer::try_create_with_size(DiskCache::EntryCount * block_size()));
     auto entries_data = TRY(KBuffer::try_create_with_size(DiskCache::EntryCount * sizeof(CacheEntry)));
-    auto disk_cache = TRY(adopt_nonnull_own_or_enomem(new (nothrow) DiskCache(*this, move(cached_block_data), move(entries_data))));
+    auto run_buffer = TRY(KBuffer::try_create_with_size(max<size_t>(DiskCache::MaxRunSize / block_size(), 1) * block_size()));
+    auto disk_cache = TRY(adopt_nonnull_own_or_enomem(new (nothrow) DiskCache(*this, move(cached_block_data), move(entries_data), move(run_buffer))));
 
     m_cache.with_exclusive([&](auto& cache) {
         cache = move(disk_cache);
@@ -147,6 +191,9 @@ ErrorOr<void> BlockBasedFileSystem::write_block(BlockIndex index, const UserOrKe
 
     TRY(data.read(buffered_data.bytes()));
 
+    if (allow_cache)
+        TRY(throttle_writer());
+
     return m_cache.with_exclusive([&](auto& cache) -> ErrorOr<void> {
         if (!allow_cache) {
             flush_specific_block_if_needed(index);
@@ -156,7 +203,7 @@ ErrorOr<void> BlockBasedFileSystem::write_block(BlockIndex index, const UserOrKe
             return {};
         }
 
-        auto& entry = cache->ensure(index);
+        auto& entry = *TRY(cache->ensure(index));
         if (count < block_size()) {
             // Fill the cache first.
             TRY(read_block(index, nullptr, block_size()));
@@ -187,21 +234,17 @@ ErrorOr<void> BlockBasedFileSystem::raw_write(BlockIndex index, const UserOrKern
 
 ErrorOr<void> BlockBasedFileSystem::raw_read_blocks(BlockIndex index, size_t count, UserOrKernelBuffer& buffer)
 {
-    auto current = buffer;
-    for (auto block = index.value(); block < (index.value() + count); block++) {
-        TRY(raw_read(BlockIndex { block }, current));
-        current = current.offset(logical_block_size());
-    }
+    auto base_offset = index.value() * m_logical_block_size;
+    auto nread = TRY(file_description().read(buffer, base_offset, count * m_logical_block_size));
+    VERIFY(nread == count * m_logical_block_size);
     return {};
 }
 
 ErrorOr<void> BlockBasedFileSystem::raw_write_blocks(BlockIndex index, size_t count, const UserOrKernelBuffer& buffer)
 {
-    auto current = buffer;
-    for (auto block = index.value(); block < (index.value() + count); block++) {
-        TRY(raw_write(block, current));
-        current = current.offset(logical_block_size());
-    }
+    auto base_offset = index.value() * m_logical_block_size;
+    auto nwritten = TRY(file_description().write(base_offset, buffer, count * m_logical_block_size));
+    VERIFY(nwritten == count * m_logical_block_size);
     return {};
 }
 
@@ -209,8 +252,51 @@ ErrorOr<void> BlockBasedFileSystem::write_blocks(BlockIndex index, unsigned coun
 {
     VERIFY(m_logical_block_size);
     dbgln_if(BBFS_DEBUG, "BlockBasedFileSystem::write_blocks {}, count={}", index, count);
-    for (unsigned i = 0; i < count; ++i) {
-        TRY(write_block(BlockIndex { index.value() + i }, data.offset(i * block_size()), block_size(), 0, allow_cache));
+    if (!count)
+        return EINVAL;
+    if (count == 1)
+        return write_block(index, data, block_size(), 0, allow_cache);
+
+    if (!allow_cache) {
+        // The whole run goes to the device at once. Cached copies of these blocks would now be stale,
+        // so they're brought up to date (and are no longer dirty, since the device has the same data).
+        auto nwritten = TRY(file_description().write(index.value() * block_size(), data, count * block_size()));
+        VERIFY(nwritten == count * block_size());
+        return m_cache.with_exclusive([&](auto& cache) -> ErrorOr<void> {
+            for (unsigned i = 0; i < count; ++i) {
+                auto* entry = cache->get(BlockIndex { index.value() + i });
+                if (!entry)
+                    continue;
+                TRY(data.read(entry->data, i * block_size(), block_size()));
+                entry->has_data = true;
+                if (cache->entry_is_dirty(*entry))
+                    cache->mark_clean(*entry);
+            }
+            return {};
+        });
+    }
+
+    // NOTE: Like in write_block(), the data is copied into a local buffer before taking the cache lock,
+    //       so any page faults caused by accessing it occur before we tie down the cache.
+    auto blocks_per_chunk = min<size_t>(count, max<size_t>(DiskCache::MaxRunSize / block_size(), 1));
+    auto buffered_data_or_error = ByteBuffer::create_uninitialized(blocks_per_chunk * block_size());
+    if (!buffered_data_or_error.has_value())
+        return ENOMEM;
+    auto buffered_data = buffered_data_or_error.release_value();
+
+    for (size_t chunk_start = 0; chunk_start < count; chunk_start += blocks_per_chunk) {
+        auto blocks_in_chunk = min<size_t>(count - chunk_start, blocks_per_chunk);
+        TRY(data.read(buffered_data.data(), chunk_start * block_size(), blocks_in_chunk * block_size()));
+        TRY(throttle_writer());
+        TRY(m_cache.with_exclusive([&](auto& cache) -> ErrorOr<void> {
+            for (size_t i = 0; i < blocks_in_chunk; ++i) {
+                auto& entry = *TRY(cache->ensure(BlockIndex { index.value() + chunk_start + i }));
+                memcpy(entry.data, buffered_data.data() + i * block_size(), block_size());
+                cache->mark_dirty(entry);
+                entry.has_data = true;
+            }
+            return {};
+        }));
     }
     return {};
 }
@@ -230,7 +316,7 @@ ErrorOr<void> BlockBasedFileSystem::read_block(BlockIndex index, UserOrKernelBuf
             return {};
         }
 
-        auto& entry = cache->ensure(index);
+        auto& entry = *TRY(cache->ensure(index));
         if (!entry.has_data) {
             auto base_offset = index.value() * block_size();
             auto entry_data_buffer = UserOrKernelBuffer::for_kernel_buffer(entry.data);
@@ -251,13 +337,49 @@ ErrorOr<void> BlockBasedFileSystem::read_blocks(BlockIndex index, unsigned count
         return EINVAL;
     if (count == 1)
         return read_block(index, &buffer, block_size(), 0, allow_cache);
-    auto out = buffer;
-    for (unsigned i = 0; i < count; ++i) {
-        TRY(read_block(BlockIndex { index.value() + i }, &out, block_size(), 0, allow_cache));
-        out = out.offset(block_size());
+
+    if (!allow_cache) {
+        for (unsigned i = 0; i < count; ++i)
+            const_cast<BlockBasedFileSystem*>(this)->flush_specific_block_if_needed(BlockIndex { index.value() + i });
+        auto nread = TRY(file_description().read(buffer, index.value() * block_size(), count * block_size()));
+        VERIFY(nread == count * block_size());
+        return {};
     }
 
-    return {};
+    return m_cache.with_exclusive([&](auto& cache) -> ErrorOr<void> {
+        unsigned i = 0;
+        while (i < count) {
+            if (auto* entry = cache->get(BlockIndex { index.value() + i }); entry && entry->has_data) {
+                TRY(buffer.write(entry->data, i * block_size(), block_size()));
+                ++i;
+                continue;
+            }
+
+            // Read the whole run of blocks we don't have yet with a single request,
+            // through the run buffer so what ends up in the cache can't be touched by userspace.
+            size_t run_length = 1;
+            while (i + run_length < count && run_length < cache->max_run_block_count() && !cache->has_data_for(BlockIndex { index.value() + i + run_length }))
+                ++run_length;
+
+            // NOTE: ensure() may have to flush, which uses the run buffer, so get the entries before reading.
+            Vector<CacheEntry*, DiskCache::MaxRunSize / 512> run_entries;
+            for (size_t j = 0; j < run_length; ++j)
+                TRY(run_entries.try_append(TRY(cache->ensure(BlockIndex { index.value() + i + j }))));
+
+            dbgln_if(BBFS_DEBUG, "BlockBasedFileSystem::read_blocks reading run of {} blocks at {}", run_length, index.value() + i);
+            auto run_buffer = UserOrKernelBuffer::for_kernel_buffer(cache->run_buffer());
+            auto nread = TRY(file_description().read(run_buffer, (index.value() + i) * block_size(), run_length * block_size()));
+            VERIFY(nread == run_length * block_size());
+
+            for (size_t j = 0; j < run_length; ++j) {
+                memcpy(run_entries[j]->data, cache->run_buffer() + j * block_size(), block_size());
+                run_entries[j]->has_data = true;
+            }
+            TRY(buffer.write(cache->run_buffer(), i * block_size(), run_length * block_size()));
+            i += run_length;
+        }
+        return {};
+    });
 }
 
 void BlockBasedFileSystem::flush_specific_block_if_needed(BlockIndex index)
@@ -276,26 +398,148 @@ void BlockBasedFileSystem::flush_specific_block_if_needed(BlockIndex index)
     });
 }
 
-void BlockBasedFileSystem::flush_writes_impl()
+ErrorOr<size_t> BlockBasedFileSystem::write_back_run(DiskCache& cache, CacheEntry& entry)
 {
+    VERIFY(cache.entry_is_dirty(entry));
+
+    // Write back the run of contiguous dirty blocks around this entry with a single request.
+    auto max_run_block_count = cache.max_run_block_count();
+    auto run_start = entry.block_index.value();
+    while (run_start > 0 && entry.block_index.value() - run_start + 1 < max_run_block_count) {
+        auto* previous = cache.get(BlockIndex { run_start - 1 });
+        if (!previous || !cache.entry_is_dirty(*previous))
+            break;
+        --run_start;
+    }
+
+    size_t run_length = 0;
+    for (auto* run_entry = cache.get(BlockIndex { run_start }); run_entry && cache.entry_is_dirty(*run_entry) && run_length < max_run_block_count; run_entry = cache.get(BlockIndex { run_start + run_length })) {
+        memcpy(cache.run_buffer() + run_length * block_size(), run_entry->data, block_size());
+        ++run_length;
+    }
+
+    // The blocks stay dirty until the device actually has them, so a failed write is retried
+    // by the next flush instead of silently dropping the data.
+    auto run_buffer = UserOrKernelBuffer::for_kernel_buffer(cache.run_buffer());
+    auto result = file_description().write(run_start * block_size(), run_buffer, run_length * block_size());
+    if (result.is_error()) {
+        dbgln("{}: Failed to write back {} blocks at {}: {}", class_name(), run_length, run_start, result.error());
+        return result.release_error();
+    }
+    VERIFY(result.value() == run_length * block_size());
+
+    for (size_t i = 0; i < run_length; ++i)
+        cache.mark_clean(*cache.get(BlockIndex { run_start + i }));
+    return run_length;
+}
+
+ErrorOr<void> BlockBasedFileSystem::flush_writes_impl()
+{
+    // NOTE: The cache lock is only held for one run at a time, so writers get a chance to make
+    //       progress between the runs, instead of waiting for the entire flush to finish.
     size_t count = 0;
-    m_cache.with_exclusive([&](auto& cache) {
-        if (!cache->is_dirty())
-            return;
-        cache->for_each_dirty_entry([&](CacheEntry& entry) {
-            auto base_offset = entry.block_index.value() * block_size();
-            auto entry_data_buffer = UserOrKernelBuffer::for_kernel_buffer(entry.data);
-            [[maybe_unused]] auto rc = file_description().write(base_offset, entry_data_buffer, block_size());
-            ++count;
-        });
-        cache->mark_all_clean();
+    auto flush_sequence = m_cache.with_exclusive([](auto& cache) { return cache->next_dirty_sequence(); });
+    for (;;) {
+        auto written = TRY(m_cache.with_exclusive([&](auto& cache) -> ErrorOr<size_t> {
+            auto* entry = cache->oldest_dirty_entry();
+            // Anything that became dirty after we started is left for the next flush.
+            if (!entry || entry->dirty_sequence >= flush_sequence)
+                return 0;
+            return write_back_run(*cache, *entry);
+        }));
+        if (!written)
+            break;
+        count += written;
+    }
+    if (count)
         dbgln("{}: Flushed {} blocks to disk", class_name(), count);
-    });
+    return {};
 }
 
-void BlockBasedFileSystem::flush_writes()
+void BlockBasedFileSystem::write_back_dirty_data()
 {
-    flush_writes_impl();
+    auto now_ms = TimeManagement::the().uptime_ms();
+    size_t count = 0;
+    for (;;) {
+        auto written_or_error = m_cache.with_exclusive([&](auto& cache) -> ErrorOr<size_t> {
+            if (!cache)
+                return 0;
+            auto* entry = cache->oldest_dirty_entry();
+            if (!entry)
+                return 0;
+            bool has_expired = now_ms - entry->dirtied_at_ms >= DiskCache::DirtyExpireMilliseconds;
+            if (!has_expired && cache->dirty_count() <= DiskCache::BackgroundDirtyLimit)
+                return 0;
+            return write_back_run(*cache, *entry);
+        });
+        // A failed run stays dirty, so give up until the next time instead of retrying it right away.
+        if (written_or_error.is_error() || !written_or_error.value())
+            break;
+        count += written_or_error.value();
+    }
+    dbgln_if(BBFS_DEBUG, "{}: Wrote back {} blocks in the background", class_name(), count);
+}
+
+ErrorOr<void> BlockBasedFileSystem::throttle_writer()
+{
+    // A writer that dirties blocks faster than the background writeback can keep up with
+    // writes back the oldest runs itself, one request at a time. This keeps its latency flat,
+    // instead of filling the cache and then stalling on a flush of every single entry.
+    for (;;) {
+        auto written = TRY(m_cache.with_exclusive([&](auto& cache) -> ErrorOr<size_t> {
+            if (cache->dirty_count() > DiskCache::BackgroundDirtyLimit)
+                SyncTask::request_writeback();
+            if (cache->dirty_count() < DiskCache::DirtyLimit)
+                return 0;
+            return write_back_run(*cache, *cache->oldest_dirty_entry());
+        }));
+        if (!written)
+            return {};
+    }
+}
+
+ErrorOr<void> BlockBasedFileSystem::flush_writes()
+{
+    TRY(flush_writes_impl());
+    // The device may still be holding on to what we just wrote.
+    if (auto* device = block_device()) {
+        if (auto result = device->flush_write_cache(); result.is_error()) {
+            dbgln("{}: Failed to flush the device's write cache: {}", class_name(), result.error());
+            return result.release_error();
+        }
+    }
+    return {};
+}
+
+BlockDevice* BlockBasedFileSystem::block_device()
+{
+    if (!file().is_block_device())
+        return nullptr;
+    return static_cast<BlockDevice*>(&file());
+}
+
+bool BlockBasedFileSystem::device_supports_discard()
+{
+    auto* device = block_device();
+    return device && device->supports_discard();
+}
+
+ErrorOr<void> BlockBasedFileSystem::discard_blocks(BlockIndex index, size_t count)
+{
+    auto* device = block_device();
+    if (!device)
+        return {};
+    VERIFY(block_size() % device->block_size() == 0);
+    auto device_blocks_per_block = block_size() / device->block_size();
+    u64 device_block_index = index.value() * device_blocks_per_block;
+    u64 device_block_count = static_cast<u64>(count) * device_blocks_per_block;
+    while (device_block_count > 0) {
+        u32 blocks_in_request = min<u64>(device_block_count, NumericLimits<u32>::max());
+        TRY(device->discard_blocks(device_block_index, blocks_in_request));
+        device_block_index += blocks_in_request;
+        device_block_count -= blocks_in_request;
+    }
+    return {};
 }
 
 }
@@ -11,6 +11,9 @@
 
 namespace Kernel {
 
+class BlockDevice;
+struct CacheEntry;
+
 class BlockBasedFileSystem : public FileBackedFileSystem {
 public:
     TYPEDEF_DISTINCT_ORDERED_ID(u64, BlockIndex);
@@ -20,8 +23,9 @@ public:
 
     u64 logical_block_size() const { return m_logical_block_size; };
 
-    virtual void flush_writes() override;
-    void flush_writes_impl();
+    virtual ErrorOr<void> flush_writes() override;
+    virtual void write_back_dirty_data() override;
+    ErrorOr<void> flush_writes_impl();
 
 protected:
     explicit BlockBasedFileSystem(OpenFileDescription&);
@@ -38,11 +42,19 @@ protected:
     ErrorOr<void> write_block(BlockIndex, const UserOrKernelBuffer&, size_t count, size_t offset = 0, bool allow_cache = true);
     ErrorOr<void> write_blocks(BlockIndex, unsigned count, const UserOrKernelBuffer&, bool allow_cache = true);
 
+    // Null if the file system lives in a regular file rather than on a block device.
+    BlockDevice* block_device();
+    bool device_supports_discard();
+    // Tells the device that the blocks are no longer in use.
+    ErrorOr<void> discard_blocks(BlockIndex, size_t count);
+
     u64 m_logical_block_size { 512 };
 
 private:
     DiskCache& cache() const;
     void flush_specific_block_if_needed(BlockIndex index);
+    ErrorOr<size_t> write_back_run(DiskCache&, CacheEntry&);
+    ErrorOr<void> throttle_writer();
 
     mutable MutexProtected<OwnPtr<DiskCache>> m_cache;
 };
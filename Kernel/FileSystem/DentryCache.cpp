@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/HashFunctions.h>
+#include <AK/Singleton.h>
+#include <Kernel/FileSystem/DentryCache.h>
+#include <Kernel/FileSystem/FileSystem.h>
+#include <Kernel/FileSystem/Inode.h>
+
+namespace Kernel {
+
+static Singleton<DentryCache> s_the;
+
+DentryCache& DentryCache::the()
+{
+    return *s_the;
+}
+
+bool DentryCache::is_cacheable(Inode const& directory)
+{
+    return directory.fs().supports_watchers();
+}
+
+DentryCache::Bucket& DentryCache::bucket_for(Inode const& directory, StringView name)
+{
+    // The bucket only depends on the directory inode and not on the custody leading to it,
+    // so invalidation doesn't have to know about every path to the directory.
+    return m_buckets[pair_int_hash(ptr_hash(&directory), name.hash()) % bucket_count];
+}
+
+Optional<RefPtr<Custody>> DentryCache::lookup(Custody& parent, StringView name, u32& generation)
+{
+    auto& bucket = bucket_for(parent.inode(), name);
+    SpinlockLocker locker(bucket.lock);
+    for (auto& entry : bucket.entries) {
+        if (entry.parent.ptr() != &parent || entry.name->view() != name)
+            continue;
+        entry.last_used = ++bucket.clock;
+        if (entry.child)
+            ++bucket.statistics.hits;
+        else
+            ++bucket.statistics.negative_hits;
+        return entry.child;
+    }
+    ++bucket.statistics.misses;
+    generation = bucket.generation;
+    return {};
+}
+
+void DentryCache::insert(Custody& parent, StringView name, RefPtr<Custody> child, u32 generation)
+{
+    auto name_or_error = KString::try_create(name);
+    if (name_or_error.is_error())
+        return;
+
+    Entry evicted;
+    {
+        auto& bucket = bucket_for(parent.inode(), name);
+        SpinlockLocker locker(bucket.lock);
+        if (bucket.generation != generation)
+            return;
+
+        Entry* victim = nullptr;
+        for (auto& entry : bucket.entries) {
+            if (entry.parent.ptr() == &parent && entry.name->view() == name)
+                return;
+            if (!victim || !entry.parent || (victim->parent && entry.last_used < victim->last_used))
+                victim = &entry;
+        }
+
+        if (victim->parent)
+            ++bucket.statistics.evictions;
+        else
+            ++bucket.statistics.cached_entries;
+        // The evicted custodies may only be released once we no longer hold the spinlock.
+        evicted = move(*victim);
+        victim->parent = parent;
+        victim->name = name_or_error.release_value();
+        victim->child = move(child);
+        victim->last_used = ++bucket.clock;
+    }
+}
+
+void DentryCache::invalidate(Inode const& directory, StringView name)
+{
+    Array<Entry, entries_per_bucket> invalidated;
+    {
+        auto& bucket = bucket_for(directory, name);
+        SpinlockLocker locker(bucket.lock);
+        ++bucket.generation;
+        for (size_t i = 0; i < entries_per_bucket; ++i) {
+            auto& entry = bucket.entries[i];
+            if (!entry.parent || &entry.parent->inode() != &directory || entry.name->view() != name)
+                continue;
+            invalidated[i] = move(entry);
+            entry = {};
+            ++bucket.statistics.invalidations;
+            --bucket.statistics.cached_entries;
+        }
+    }
+}
+
+void DentryCache::invalidate_all()
+{
+    for (auto& bucket : m_buckets) {
+        // Declared before the locker, so the custodies are only released after unlocking.
+        Array<Entry, entries_per_bucket> invalidated;
+        SpinlockLocker locker(bucket.lock);
+        ++bucket.generation;
+        for (size_t i = 0; i < entries_per_bucket; ++i) {
+            auto& entry = bucket.entries[i];
+            if (!entry.parent)
+                continue;
+            invalidated[i] = move(entry);
+            entry = {};
+            ++bucket.statistics.invalidations;
+            --bucket.statistics.cached_entries;
+        }
+    }
+}
+
+DentryCache::Statistics DentryCache::statistics() const
+{
+    Statistics total;
+    for (auto& bucket : m_buckets) {
+        SpinlockLocker locker(bucket.lock);
+        total.hits += bucket.statistics.hits;
+        total.negative_hits += bucket.statistics.negative_hits;
+        total.misses += bucket.statistics.misses;
+        total.invalidations += bucket.statistics.invalidations;
+        total.evictions += bucket.statistics.evictions;
+        total.cached_entries += bucket.statistics.cached_entries;
+    }
+    return total;
+}
+
+}
@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Array.h>
+#include <AK/OwnPtr.h>
+#include <AK/RefPtr.h>
+#include <AK/StringView.h>
+#include <Kernel/FileSystem/Custody.h>
+#include <Kernel/Forward.h>
+#include <Kernel/KString.h>
+#include <Kernel/Locking/Spinlock.h>
+
+namespace Kernel {
+
+// The DentryCache remembers what path resolution found when it looked up a name in a
+// directory, keyed by the Custody of that directory and the name. Names that turned
+// out not to exist are remembered as well, so repeated failing lookups are cheap too.
+//
+// Only directories of file systems that report every change to their children (the
+// ones that support watchers) are cached. Inode::did_add_child() and did_remove_child()
+// drop the entries for the changed name, and changes to the mount table drop everything.
+//
+// Entries live in a fixed number of small buckets, each with its own lock. Every
+// invalidation bumps the generation of its bucket, and a lookup result is only inserted
+// if the generation is still the one it saw before it asked the file system, so a result
+// that raced with a change to the directory never makes it into the cache.
+//
+// Unveil is unaffected, since callers still validate the custody they end up with.
+class DentryCache {
+public:
+    struct Statistics {
+        u64 hits { 0 };
+        u64 negative_hits { 0 };
+        u64 misses { 0 };
+        u64 invalidations { 0 };
+        u64 evictions { 0 };
+        size_t cached_entries { 0 };
+    };
+
+    static DentryCache& the();
+
+    static bool is_cacheable(Inode const& directory);
+
+    // Returns the cached child custody, or null if the name is known not to exist.
+    // On a miss, `generation` is set to what insert() expects for the same name.
+    Optional<RefPtr<Custody>> lookup(Custody& parent, StringView name, u32& generation);
+    void insert(Custody& parent, StringView name, RefPtr<Custody> child, u32 generation);
+
+    void invalidate(Inode const& directory, StringView name);
+    void invalidate_all();
+
+    Statistics statistics() const;
+
+private:
+    static constexpr size_t bucket_count = 512;
+    static constexpr size_t entries_per_bucket = 4;
+
+    struct Entry {
+        // A null parent marks an unused entry.
+        RefPtr<Custody> parent;
+        OwnPtr<KString> name;
+        RefPtr<Custody> child;
+        u32 last_used { 0 };
+    };
+
+    struct Bucket {
+        mutable Spinlock lock;
+        u32 generation { 0 };
+        u32 clock { 0 };
+        Array<Entry, entries_per_bucket> entries;
+        Statistics statistics;
+    };
+
+    Bucket& bucket_for(Inode const& directory, StringView name);
+
+    Array<Bucket, bucket_count> m_buckets;
+};
+
+}
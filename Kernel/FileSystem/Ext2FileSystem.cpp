@@ -7,13 +7,17 @@
 
 #include <AK/HashMap.h>
 #include <AK/MemoryStream.h>
+#include <AK/QuickSort.h>
+#include <AK/ScopeGuard.h>
 #include <AK/StdLibExtras.h>
 #include <AK/StringView.h>
 #include <Kernel/API/POSIX/errno.h>
 #include <Kernel/Debug.h>
 #include <Kernel/Devices/BlockDevice.h>
+#include <Kernel/FileSystem/DentryCache.h>
 #include <Kernel/FileSystem/Ext2FileSystem.h>
 #include <Kernel/FileSystem/OpenFileDescription.h>
+#include <Kernel/FileSystem/PageCache.h>
 #include <Kernel/FileSystem/ext2_fs.h>
 #include <Kernel/Process.h>
 #include <Kernel/UnixTypes.h>
@@ -49,6 +53,312 @@ static u8 to_ext2_file_type(mode_t mode)
     return EXT2_FT_UNKNOWN;
 }
 
+// The directory entry name hashes used by hash-indexed ("htree") directories.
+// These have to produce exactly the same values as the ones in Linux (fs/ext4/hash.c),
+// including the quirk that the legacy and half MD4 hashes depend on the signedness of char.
+
+template<typename Char>
+static u32 legacy_directory_hash(StringView name)
+{
+    u32 hash0 = 0x12a3fe2d;
+    u32 hash1 = 0x37abe8f9;
+    for (char ch : name) {
+        u32 hash = hash1 + (hash0 ^ static_cast<u32>(static_cast<i32>(static_cast<Char>(ch)) * 7152373));
+        if (hash & 0x80000000)
+            hash -= 0x7fffffff;
+        hash1 = hash0;
+        hash0 = hash;
+    }
+    return hash0 << 1;
+}
+
+template<typename Char>
+static void directory_hash_input(StringView name, u32* input, size_t count)
+{
+    u32 padding = static_cast<u32>(name.length()) | (static_cast<u32>(name.length()) << 8);
+    padding |= padding << 16;
+
+    u32 value = padding;
+    auto length = min(name.length(), count * 4);
+    for (size_t i = 0; i < length; ++i) {
+        value = static_cast<u32>(static_cast<i32>(static_cast<Char>(name[i]))) + (value << 8);
+        if (i % 4 == 3) {
+            *input++ = value;
+            value = padding;
+            --count;
+        }
+    }
+    if (count > 0) {
+        *input++ = value;
+        --count;
+    }
+    while (count-- > 0)
+        *input++ = padding;
+}
+
+static void half_md4_transform(u32 buffer[4], u32 const input[8])
+{
+    auto f = [](u32 x, u32 y, u32 z) { return z ^ (x & (y ^ z)); };
+    auto g = [](u32 x, u32 y, u32 z) { return (x & y) + ((x ^ y) & z); };
+    auto h = [](u32 x, u32 y, u32 z) { return x ^ y ^ z; };
+    auto round = [](auto function, u32& a, u32 b, u32 c, u32 d, u32 x, int shift) {
+        a += function(b, c, d) + x;
+        a = (a << shift) | (a >> (32 - shift));
+    };
+    constexpr u32 k2 = 0x5a827999;
+    constexpr u32 k3 = 0x6ed9eba1;
+
+    u32 a = buffer[0], b = buffer[1], c = buffer[2], d = buffer[3];
+
+    round(f, a, b, c, d, input[0], 3);
+    round(f, d, a, b, c, input[1], 7);
+    round(f, c, d, a, b, input[2], 11);
+    round(f, b, c, d, a, input[3], 19);
+    round(f, a, b, c, d, input[4], 3);
+    round(f, d, a, b, c, input[5], 7);
+    round(f, c, d, a, b, input[6], 11);
+    round(f, b, c, d, a, input[7], 19);
+
+    round(g, a, b, c, d, input[1] + k2, 3);
+    round(g, d, a, b, c, input[3] + k2, 5);
+    round(g, c, d, a, b, input[5] + k2, 9);
+    round(g, b, c, d, a, input[7] + k2, 13);
+    round(g, a, b, c, d, input[0] + k2, 3);
+    round(g, d, a, b, c, input[2] + k2, 5);
+    round(g, c, d, a, b, input[4] + k2, 9);
+    round(g, b, c, d, a, input[6] + k2, 13);
+
+    round(h, a, b, c, d, input[3] + k3, 3);
+    round(h, d, a, b, c, input[7] + k3, 9);
+    round(h, c, d, a, b, input[2] + k3, 11);
+    round(h, b, c, d, a, input[6] + k3, 15);
+    round(h, a, b, c, d, input[1] + k3, 3);
+    round(h, d, a, b, c, input[5] + k3, 9);
+    round(h, c, d, a, b, input[0] + k3, 11);
+    round(h, b, c, d, a, input[4] + k3, 15);
+
+    buffer[0] += a;
+    buffer[1] += b;
+    buffer[2] += c;
+    buffer[3] += d;
+}
+
+static void tea_transform(u32 buffer[4], u32 const input[4])
+{
+    u32 sum = 0;
+    u32 b0 = buffer[0], b1 = buffer[1];
+    for (size_t i = 0; i < 16; ++i) {
+        sum += 0x9e3779b9;
+        b0 += ((b1 << 4) + input[0]) ^ (b1 + sum) ^ ((b1 >> 5) + input[1]);
+        b1 += ((b0 << 4) + input[2]) ^ (b0 + sum) ^ ((b0 >> 5) + input[3]);
+    }
+    buffer[0] += b0;
+    buffer[1] += b1;
+}
+
+template<typename Char>
+static u32 block_directory_hash(StringView name, u32 buffer[4], u8 hash_version)
+{
+    bool is_tea = hash_version == EXT2_HASH_TEA;
+    size_t chunk_size = is_tea ? 16 : 32;
+    u32 input[8];
+    for (size_t offset = 0; offset < name.length(); offset += chunk_size) {
+        auto chunk = name.substring_view(offset);
+        if (is_tea) {
+            directory_hash_input<Char>(chunk, input, 4);
+            tea_transform(buffer, input);
+        } else {
+            directory_hash_input<Char>(chunk, input, 8);
+            half_md4_transform(buffer, input);
+        }
+    }
+    return is_tea ? buffer[0] : buffer[1];
+}
+
+// Directory entries must not span blocks, so we can check each one against the bounds of its block.
+static bool is_valid_directory_entry(ReadonlyBytes block, size_t offset)
+{
+    if (offset + 8 > block.size())
+        return false;
+    auto const& entry = *reinterpret_cast<ext2_dir_entry_2 const*>(block.offset_pointer(offset));
+    return entry.rec_len >= 8 && entry.rec_len % 4 == 0 && offset + entry.rec_len <= block.size() && 8u + entry.name_len <= entry.rec_len;
+}
+
+static ext2_dir_entry_2& directory_entry_at(Bytes block, size_t offset)
+{
+    return *reinterpret_cast<ext2_dir_entry_2*>(block.offset_pointer(offset));
+}
+
+static StringView directory_entry_name(ext2_dir_entry_2 const& entry)
+{
+    return { entry.name, entry.name_len };
+}
+
+static void write_directory_entry(Bytes block, size_t offset, u16 record_length, StringView name, InodeIndex inode_index, u8 file_type)
+{
+    auto& entry = directory_entry_at(block, offset);
+    entry.inode = inode_index.value();
+    entry.rec_len = record_length;
+    entry.name_len = name.length();
+    entry.file_type = file_type;
+    memcpy(entry.name, name.characters_without_null_termination(), name.length());
+    memset(entry.name + name.length(), 0, EXT2_DIR_REC_LEN(name.length()) - 8 - name.length());
+}
+
+static ErrorOr<Optional<size_t>> find_entry_in_directory_block(ReadonlyBytes block, StringView name)
+{
+    for (size_t offset = 0; offset < block.size();) {
+        if (!is_valid_directory_entry(block, offset))
+            return EIO;
+        auto const& entry = *reinterpret_cast<ext2_dir_entry_2 const*>(block.offset_pointer(offset));
+        if (entry.inode != 0 && directory_entry_name(entry) == name)
+            return Optional<size_t> { offset };
+        offset += entry.rec_len;
+    }
+    return Optional<size_t> {};
+}
+
+// Puts a new entry into an unused record, or into the space left over behind an existing one.
+static ErrorOr<bool> try_add_entry_to_directory_block(Bytes block, StringView name, InodeIndex inode_index, u8 file_type)
+{
+    size_t needed_length = EXT2_DIR_REC_LEN(name.length());
+    for (size_t offset = 0; offset < block.size();) {
+        if (!is_valid_directory_entry(block, offset))
+            return EIO;
+        auto& entry = directory_entry_at(block, offset);
+        size_t used_length = entry.inode != 0 ? EXT2_DIR_REC_LEN(entry.name_len) : 0;
+        if (entry.rec_len - used_length >= needed_length) {
+            u16 record_length = entry.rec_len - used_length;
+            if (used_length != 0)
+                entry.rec_len = used_length;
+            write_directory_entry(block, offset + used_length, record_length, name, inode_index, file_type);
+            return true;
+        }
+        offset += entry.rec_len;
+    }
+    return false;
+}
+
+// Like ext2 itself, we give the space of a removed entry to the one in front of it,
+// or, if it's the first one in its block, simply mark it as unused.
+static ErrorOr<Optional<InodeIndex>> remove_entry_from_directory_block(Bytes block, StringView name)
+{
+    Optional<size_t> previous_offset;
+    for (size_t offset = 0; offset < block.size();) {
+        if (!is_valid_directory_entry(block, offset))
+            return EIO;
+        auto& entry = directory_entry_at(block, offset);
+        if (entry.inode != 0 && directory_entry_name(entry) == name) {
+            InodeIndex inode_index = entry.inode;
+            if (previous_offset.has_value())
+                directory_entry_at(block, previous_offset.value()).rec_len += entry.rec_len;
+            else
+                entry.inode = 0;
+            return inode_index;
+        }
+        previous_offset = offset;
+        offset += entry.rec_len;
+    }
+    return Optional<InodeIndex> {};
+}
+
+struct HashedDirectoryEntry {
+    u32 hash { 0 };
+    ext2_dir_entry_2 const* entry { nullptr };
+};
+
+static ErrorOr<ByteBuffer> create_block_buffer(size_t block_size)
+{
+    auto buffer = ByteBuffer::create_zeroed(block_size);
+    if (!buffer.has_value())
+        return ENOMEM;
+    return buffer.release_value();
+}
+
+// The root block of an indexed directory starts with "." and "..", where ".." covers the
+// rest of the block. The index root sits behind those, followed by its entries.
+// Lower index nodes start with an unused entry covering the whole block instead.
+static constexpr size_t directory_index_root_info_offset = 24;
+static constexpr size_t directory_index_root_entries_offset = 32;
+static constexpr size_t directory_index_node_entries_offset = 8;
+static constexpr u8 directory_index_max_indirect_levels = 1;
+static constexpr u32 directory_index_block_mask = 0x0fffffff;
+
+// The index doesn't cover "." and "..", those only ever live at the start of the root block.
+static bool is_dot_or_dot_dot(StringView name)
+{
+    return name == "."sv || name == ".."sv;
+}
+
+// The index nodes leading to the leaf block that is responsible for a hash, from the root down.
+struct Ext2FSInode::DirectoryIndexPath {
+    struct Node {
+        u32 block { 0 };
+        size_t entries_offset { 0 };
+        size_t position { 0 };
+        ByteBuffer data;
+
+        ext2_dx_countlimit& count_limit() { return *reinterpret_cast<ext2_dx_countlimit*>(data.data() + entries_offset); }
+        ext2_dx_entry* entries() { return reinterpret_cast<ext2_dx_entry*>(data.data() + entries_offset); }
+        u16 count() { return count_limit().count; }
+        u16 limit() { return count_limit().limit; }
+
+        // The hash of the first entry is taken up by the count and limit, as it covers everything below the second one.
+        u32 hash_at(size_t index) { return index == 0 ? 0 : entries()[index].hash; }
+        u32 block_at(size_t index) { return entries()[index].block & directory_index_block_mask; }
+
+        bool is_valid(u32 directory_block_count)
+        {
+            if (limit() != (data.size() - entries_offset) / sizeof(ext2_dx_entry) || count() == 0 || count() > limit())
+                return false;
+            for (size_t i = 0; i < count(); ++i) {
+                if (block_at(i) == 0 || block_at(i) >= directory_block_count)
+                    return false;
+            }
+            return true;
+        }
+
+        // Returns the last entry whose hash is not above the given one.
+        size_t find(u32 hash)
+        {
+            size_t low = 1;
+            size_t high = count();
+            while (low < high) {
+                size_t middle = (low + high) / 2;
+                if (entries()[middle].hash > hash)
+                    high = middle;
+                else
+                    low = middle + 1;
+            }
+            return low - 1;
+        }
+
+        void insert(size_t index, u32 hash, u32 block)
+        {
+            VERIFY(index > 0 && count() < limit());
+            memmove(&entries()[index + 1], &entries()[index], (count() - index) * sizeof(ext2_dx_entry));
+            entries()[index] = { hash, block };
+            ++count_limit().count;
+        }
+    };
+
+    static ErrorOr<NonnullOwnPtr<DirectoryIndexPath>> try_create(size_t block_size)
+    {
+        auto path = TRY(adopt_nonnull_own_or_enomem(new (nothrow) DirectoryIndexPath));
+        for (auto& node : path->nodes)
+            node.data = TRY(create_block_buffer(block_size));
+        return path;
+    }
+
+    Node& bottom() { return nodes[depth - 1]; }
+    u32 leaf_block() { return bottom().block_at(bottom().position); }
+
+    u8 hash_version { 0 };
+    u32 hash { 0 };
+    size_t depth { 0 };
+    Node nodes[directory_index_max_indirect_levels + 1];
+};
+
 ErrorOr<NonnullRefPtr<Ext2FS>> Ext2FS::try_create(OpenFileDescription& file_description)
 {
     return adopt_nonnull_ref_or_enomem(new (nothrow) Ext2FS(file_description));
@@ -82,6 +392,7 @@ const ext2_group_desc& Ext2FS::group_descriptor(GroupIndex group_index) const
 ErrorOr<void> Ext2FS::initialize()
 {
     MutexLocker locker(m_lock);
+    m_discards_freed_blocks = device_supports_discard();
 
     VERIFY((sizeof(ext2_super_block) % logical_block_size()) == 0);
     auto super_block_buffer = UserOrKernelBuffer::for_kernel_buffer((u8*)&m_super_block);
@@ -671,7 +982,7 @@ void Ext2FS::flush_block_group_descriptor_table()
         dbgln("Ext2FS[{}]::flush_block_group_descriptor_table(): Failed to write blocks: {}", fsid(), result.error());
 }
 
-void Ext2FS::flush_writes()
+ErrorOr<void> Ext2FS::flush_writes()
 {
     {
         MutexLocker locker(m_lock);
@@ -717,7 +1028,12 @@ void Ext2FS::flush_writes()
         });
     }
 
-    BlockBasedFileSystem::flush_writes();
+    // Freed blocks are only discarded once the bitmaps that free them are on the disk.
+    TRY(BlockBasedFileSystem::flush_writes());
+
+    MutexLocker locker(m_lock);
+    discard_freed_blocks();
+    return {};
 }
 
 Ext2FSInode::Ext2FSInode(Ext2FS& fs, InodeIndex index)
@@ -772,13 +1088,6 @@ ErrorOr<void> Ext2FSInode::flush_metadata()
     MutexLocker locker(m_inode_lock);
     dbgln_if(EXT2_DEBUG, "Ext2FSInode[{}]::flush_metadata(): Flushing inode", identifier());
     TRY(fs().write_ext2_inode(index(), m_raw_inode));
-    if (is_directory()) {
-        // Unless we're about to go away permanently, invalidate the lookup cache.
-        if (m_raw_inode.i_links_count != 0) {
-            // FIXME: This invalidation is way too hardcore. It's sad to throw away the whole cache.
-            m_lookup_cache.clear();
-        }
-    }
     set_metadata_dirty(false);
     return {};
 }
@@ -818,6 +1127,18 @@ ErrorOr<NonnullRefPtr<Inode>> Ext2FS::get_inode(InodeIdentifier inode) const
     return new_inode;
 }
 
+// Returns how many blocks, starting at logical block `first`, are laid out back to back on disk (at most `max_count`),
+// so they can be transferred with a single request.
+static size_t contiguous_block_run_length(Vector<BlockBasedFileSystem::BlockIndex> const& block_list, size_t first, size_t max_count)
+{
+    if (block_list[first].value() == 0)
+        return 1;
+    size_t run_length = 1;
+    while (run_length < max_count && block_list[first + run_length].value() == block_list[first].value() + run_length)
+        ++run_length;
+    return run_length;
+}
+
 ErrorOr<size_t> Ext2FSInode::read_bytes(off_t offset, size_t count, UserOrKernelBuffer& buffer, OpenFileDescription* description) const
 {
     MutexLocker inode_locker(m_inode_lock);
@@ -861,14 +1182,24 @@ ErrorOr<size_t> Ext2FSInode::read_bytes(off_t offset, size_t count, UserOrKernel
 
     dbgln_if(EXT2_VERY_DEBUG, "Ext2FSInode[{}]::read_bytes(): Reading up to {} bytes, {} bytes into inode to {}", identifier(), count, offset, buffer.user_or_kernel_ptr());
 
-    for (auto bi = first_block_logical_index; remaining_count && bi <= last_block_logical_index; bi = bi.value() + 1) {
+    for (auto bi = first_block_logical_index; remaining_count && bi <= last_block_logical_index;) {
         auto block_index = m_block_list[bi.value()];
         size_t offset_into_block = (bi == first_block_logical_index) ? offset_into_first_block : 0;
         size_t num_bytes_to_copy = min((size_t)block_size - offset_into_block, (size_t)remaining_count);
+        size_t blocks_to_copy = 1;
         auto buffer_offset = buffer.offset(nread);
         if (block_index.value() == 0) {
             // This is a hole, act as if it's filled with zeroes.
             TRY(buffer_offset.memset(0, num_bytes_to_copy));
+        } else if (offset_into_block == 0 && num_bytes_to_copy == (size_t)block_size) {
+            // Whole blocks that are contiguous on disk are read with as few device requests as possible.
+            auto max_blocks = min<size_t>((size_t)remaining_count / block_size, last_block_logical_index.value() - bi.value() + 1);
+            blocks_to_copy = contiguous_block_run_length(m_block_list, bi.value(), max_blocks);
+            num_bytes_to_copy = blocks_to_copy * block_size;
+            if (auto result = fs().read_blocks(block_index, blocks_to_copy, buffer_offset, allow_cache); result.is_error()) {
+                dmesgln("Ext2FSInode[{}]::read_bytes(): Failed to read {} blocks at {} (index {})", identifier(), blocks_to_copy, block_index.value(), bi);
+                return result.release_error();
+            }
         } else {
             if (auto result = fs().read_block(block_index, &buffer_offset, num_bytes_to_copy, offset_into_block, allow_cache); result.is_error()) {
                 dmesgln("Ext2FSInode[{}]::read_bytes(): Failed to read block {} (index {})", identifier(), block_index.value(), bi);
@@ -877,6 +1208,7 @@ ErrorOr<size_t> Ext2FSInode::read_bytes(off_t offset, size_t count, UserOrKernel
         }
         remaining_count -= num_bytes_to_copy;
         nread += num_bytes_to_copy;
+        bi = bi.value() + blocks_to_copy;
     }
 
     return nread;
@@ -938,6 +1270,9 @@ ErrorOr<void> Ext2FSInode::resize(u64 new_size)
 
     set_metadata_dirty(true);
 
+    if (new_size < old_size)
+        PageCache::the().invalidate(*this, new_size, old_size - new_size);
+
     if (new_size > old_size) {
         // If we're growing the inode, make sure we zero out all the new space.
         // FIXME: There are definitely more efficient ways to achieve this.
@@ -1005,18 +1340,30 @@ ErrorOr<size_t> Ext2FSInode::write_bytes(off_t offset, size_t count, const UserO
 
     dbgln_if(EXT2_VERY_DEBUG, "Ext2FSInode[{}]::write_bytes(): Writing {} bytes, {} bytes into inode from {}", identifier(), count, offset, data.user_or_kernel_ptr());
 
-    for (auto bi = first_block_logical_index; remaining_count && bi <= last_block_logical_index; bi = bi.value() + 1) {
+    for (auto bi = first_block_logical_index; remaining_count && bi <= last_block_logical_index;) {
         size_t offset_into_block = (bi == first_block_logical_index) ? offset_into_first_block : 0;
         size_t num_bytes_to_copy = min((size_t)block_size - offset_into_block, (size_t)remaining_count);
-        dbgln_if(EXT2_DEBUG, "Ext2FSInode[{}]::write_bytes(): Writing block {} (offset_into_block: {})", identifier(), m_block_list[bi.value()], offset_into_block);
-        if (auto result = fs().write_block(m_block_list[bi.value()], data.offset(nwritten), num_bytes_to_copy, offset_into_block, allow_cache); result.is_error()) {
+        size_t blocks_to_copy = 1;
+        if (offset_into_block == 0 && num_bytes_to_copy == block_size) {
+            // Whole blocks that are contiguous on disk are written with as few device requests as possible.
+            auto max_blocks = min<size_t>((size_t)remaining_count / block_size, last_block_logical_index.value() - bi.value() + 1);
+            blocks_to_copy = contiguous_block_run_length(m_block_list, bi.value(), max_blocks);
+            num_bytes_to_copy = blocks_to_copy * block_size;
+        }
+        dbgln_if(EXT2_DEBUG, "Ext2FSInode[{}]::write_bytes(): Writing {} blocks at {} (offset_into_block: {})", identifier(), blocks_to_copy, m_block_list[bi.value()], offset_into_block);
+        auto result = blocks_to_copy > 1
+            ? fs().write_blocks(m_block_list[bi.value()], blocks_to_copy, data.offset(nwritten), allow_cache)
+            : fs().write_block(m_block_list[bi.value()], data.offset(nwritten), num_bytes_to_copy, offset_into_block, allow_cache);
+        if (result.is_error()) {
             dbgln("Ext2FSInode[{}]::write_bytes(): Failed to write block {} (index {})", identifier(), m_block_list[bi.value()], bi);
             return result.release_error();
         }
         remaining_count -= num_bytes_to_copy;
         nwritten += num_bytes_to_copy;
+        bi = bi.value() + blocks_to_copy;
     }
 
+    PageCache::the().invalidate(*this, offset, nwritten);
     did_modify_contents();
 
     dbgln_if(EXT2_VERY_DEBUG, "Ext2FSInode[{}]::write_bytes(): After write, i_size={}, i_blocks={} ({} blocks in list)", identifier(), size(), m_raw_inode.i_blocks, m_block_list.size());
@@ -1052,6 +1399,42 @@ Ext2FS::FeaturesReadOnly Ext2FS::get_features_readonly() const
     return Ext2FS::FeaturesReadOnly::None;
 }
 
+bool Ext2FS::supports_directory_index() const
+{
+    return m_super_block.s_rev_level > 0 && (m_super_block.s_feature_compat & EXT2_FEATURE_COMPAT_DIR_INDEX);
+}
+
+u8 Ext2FS::default_directory_hash_version() const
+{
+    if (m_super_block.s_def_hash_version > EXT2_HASH_TEA)
+        return EXT2_HASH_HALF_MD4;
+    return m_super_block.s_def_hash_version;
+}
+
+u32 Ext2FS::directory_entry_hash(StringView name, u8 hash_version) const
+{
+    u32 buffer[4] = { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476 };
+    auto const& seed = m_super_block.s_hash_seed;
+    if (seed[0] || seed[1] || seed[2] || seed[3])
+        memcpy(buffer, seed, sizeof(buffer));
+
+    // Without either flag, the file system has been created on a platform where char is signed.
+    bool is_unsigned = m_super_block.s_flags & EXT2_FLAGS_UNSIGNED_HASH;
+
+    u32 hash = 0;
+    if (hash_version == EXT2_HASH_LEGACY)
+        hash = is_unsigned ? legacy_directory_hash<u8>(name) : legacy_directory_hash<i8>(name);
+    else
+        hash = is_unsigned ? block_directory_hash<u8>(name, buffer, hash_version) : block_directory_hash<i8>(name, buffer, hash_version);
+
+    // The lowest bit is used to mark hash collisions that continue into the next leaf block,
+    // and the highest possible hash is reserved to mark the end of a directory in readdir() cookies.
+    hash &= ~1u;
+    if (hash == 0xfffffffe)
+        hash = 0xfffffffc;
+    return hash;
+}
+
 ErrorOr<void> Ext2FSInode::traverse_as_directory(Function<ErrorOr<void>(FileSystem::DirectoryEntryView const&)> callback) const
 {
     VERIFY(is_directory());
@@ -1149,6 +1532,416 @@ ErrorOr<NonnullRefPtr<Inode>> Ext2FSInode::create_child(StringView name, mode_t
     return fs().create_inode(*this, name, mode, dev, uid, gid);
 }
 
+u32 Ext2FSInode::directory_block_count() const
+{
+    return size() / fs().block_size();
+}
+
+bool Ext2FSInode::has_directory_index() const
+{
+    return (m_raw_inode.i_flags & EXT2_INDEX_FL) && fs().supports_directory_index();
+}
+
+ErrorOr<void> Ext2FSInode::read_directory_block(u32 block_index, Bytes block) const
+{
+    auto block_size = fs().block_size();
+    VERIFY(block.size() == block_size);
+    auto buffer = UserOrKernelBuffer::for_kernel_buffer(block.data());
+    auto nread = TRY(read_bytes(static_cast<off_t>(block_index) * block_size, block_size, buffer, nullptr));
+    if (nread != block_size)
+        return EIO;
+    return {};
+}
+
+ErrorOr<void> Ext2FSInode::write_directory_block(u32 block_index, ReadonlyBytes block)
+{
+    auto block_size = fs().block_size();
+    VERIFY(block.size() == block_size);
+    auto buffer = UserOrKernelBuffer::for_kernel_buffer(const_cast<u8*>(block.data()));
+    auto nwritten = TRY(write_bytes(static_cast<off_t>(block_index) * block_size, block_size, buffer, nullptr));
+    if (nwritten != block_size)
+        return EIO;
+    return {};
+}
+
+ErrorOr<u32> Ext2FSInode::append_directory_block(ReadonlyBytes block)
+{
+    u32 block_index = directory_block_count();
+    TRY(write_directory_block(block_index, block));
+    set_metadata_dirty(true);
+    return block_index;
+}
+
+void Ext2FSInode::drop_directory_index()
+{
+    // Index blocks look like unused space to anyone reading the directory linearly,
+    // so the directory stays intact when we stop maintaining its index.
+    dmesgln("Ext2FS: Dropping the index of directory {}", identifier());
+    m_raw_inode.i_flags &= ~EXT2_INDEX_FL;
+    set_metadata_dirty(true);
+}
+
+// Walks down the index towards the leaf block that is responsible for the given name.
+// Returns false if this is not an index we understand, in which case the directory can still be read linearly.
+ErrorOr<bool> Ext2FSInode::probe_directory_index(StringView name, DirectoryIndexPath& path) const
+{
+    auto block_count = directory_block_count();
+    auto& root = path.nodes[0];
+    root.block = 0;
+    root.entries_offset = directory_index_root_entries_offset;
+    TRY(read_directory_block(0, root.data));
+
+    auto const& info = *reinterpret_cast<ext2_dx_root_info const*>(root.data.data() + directory_index_root_info_offset);
+    if (info.reserved_zero != 0 || info.info_length != sizeof(ext2_dx_root_info) || info.indirect_levels > directory_index_max_indirect_levels || info.hash_version > EXT2_HASH_TEA)
+        return false;
+
+    path.hash_version = info.hash_version;
+    path.hash = fs().directory_entry_hash(name, info.hash_version);
+    path.depth = info.indirect_levels + 1;
+    for (size_t level = 0; level < path.depth; ++level) {
+        auto& node = path.nodes[level];
+        if (level > 0) {
+            auto& parent = path.nodes[level - 1];
+            node.block = parent.block_at(parent.position);
+            node.entries_offset = directory_index_node_entries_offset;
+            TRY(read_directory_block(node.block, node.data));
+        }
+        if (!node.is_valid(block_count))
+            return false;
+        node.position = node.find(path.hash);
+    }
+    return true;
+}
+
+// Moves the path on to the next leaf block, and returns the lowest hash that leaf is responsible for.
+ErrorOr<Optional<u32>> Ext2FSInode::advance_directory_index_path(DirectoryIndexPath& path) const
+{
+    size_t level = path.depth;
+    while (level > 0 && path.nodes[level - 1].position + 1 >= path.nodes[level - 1].count())
+        --level;
+    if (level == 0)
+        return Optional<u32> {};
+
+    auto& node = path.nodes[level - 1];
+    ++node.position;
+    u32 hash = node.hash_at(node.position);
+
+    auto block_count = directory_block_count();
+    for (; level < path.depth; ++level) {
+        auto& parent = path.nodes[level - 1];
+        auto& child = path.nodes[level];
+        child.block = parent.block_at(parent.position);
+        TRY(read_directory_block(child.block, child.data));
+        if (!child.is_valid(block_count))
+            return EIO;
+        child.position = 0;
+    }
+    return Optional<u32> { hash };
+}
+
+// Reads the leaf block holding the given name into `leaf` and returns the offset of its entry.
+// Entries with the same hash may continue into the following leaves, which is marked by the lowest bit of their hash in the index.
+ErrorOr<Optional<size_t>> Ext2FSInode::find_entry_in_directory_index(StringView name, DirectoryIndexPath& path, Bytes leaf) const
+{
+    while (true) {
+        TRY(read_directory_block(path.leaf_block(), leaf));
+        auto offset = TRY(find_entry_in_directory_block(leaf, name));
+        if (offset.has_value())
+            return offset;
+        auto next_hash = TRY(advance_directory_index_path(path));
+        if (!next_hash.has_value() || next_hash.value() != (path.hash | 1))
+            return Optional<size_t> {};
+    }
+}
+
+ErrorOr<Optional<InodeIndex>> Ext2FSInode::find_child(StringView name) const
+{
+    MutexLocker locker(m_inode_lock);
+    if (has_directory_index() && is_dot_or_dot_dot(name)) {
+        auto root = TRY(create_block_buffer(fs().block_size()));
+        TRY(read_directory_block(0, root));
+        auto offset = TRY(find_entry_in_directory_block(root, name));
+        if (!offset.has_value())
+            return Optional<InodeIndex> {};
+        return InodeIndex { directory_entry_at(root, offset.value()).inode };
+    }
+    if (has_directory_index()) {
+        auto path = TRY(DirectoryIndexPath::try_create(fs().block_size()));
+        if (TRY(probe_directory_index(name, *path))) {
+            auto leaf = TRY(create_block_buffer(fs().block_size()));
+            auto offset = TRY(find_entry_in_directory_index(name, *path, leaf));
+            if (!offset.has_value())
+                return Optional<InodeIndex> {};
+            return InodeIndex { directory_entry_at(leaf, offset.value()).inode };
+        }
+    }
+
+    TRY(populate_lookup_cache());
+    auto it = m_lookup_cache.find(name.hash(), [&](auto& entry) { return entry.key->view() == name; });
+    if (it == m_lookup_cache.end())
+        return Optional<InodeIndex> {};
+    return it->value;
+}
+
+// Writes the given entries back to back into a block, with the last one covering the rest of it.
+static void pack_directory_block(Bytes block, Span<HashedDirectoryEntry const> entries)
+{
+    memset(block.data(), 0, block.size());
+    if (entries.is_empty()) {
+        directory_entry_at(block, 0).rec_len = block.size();
+        return;
+    }
+    size_t offset = 0;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        auto const& entry = *entries[i].entry;
+        u16 record_length = i + 1 < entries.size() ? EXT2_DIR_REC_LEN(entry.name_len) : block.size() - offset;
+        write_directory_entry(block, offset, record_length, directory_entry_name(entry), entry.inode, entry.file_type);
+        offset += record_length;
+    }
+}
+
+// Like ext3 and ext4, we add an index once a directory outgrows its first block.
+// Returns false if the directory doesn't start out like one we can convert.
+ErrorOr<bool> Ext2FSInode::convert_to_indexed_directory()
+{
+    auto block_size = fs().block_size();
+    VERIFY(directory_block_count() == 1);
+    auto root = TRY(create_block_buffer(block_size));
+    TRY(read_directory_block(0, root));
+
+    // The index lives behind "." and "..", so those need to be the first two entries.
+    if (!is_valid_directory_entry(root, 0) || !is_valid_directory_entry(root, 12))
+        return false;
+    auto& dot = directory_entry_at(root, 0);
+    auto& dot_dot = directory_entry_at(root, 12);
+    if (dot.rec_len != 12 || directory_entry_name(dot) != "."sv || directory_entry_name(dot_dot) != ".."sv)
+        return false;
+
+    Vector<HashedDirectoryEntry> entries;
+    for (size_t offset = 12 + dot_dot.rec_len; offset < block_size;) {
+        if (!is_valid_directory_entry(root, offset))
+            return EIO;
+        auto const& entry = directory_entry_at(root, offset);
+        if (entry.inode != 0)
+            TRY(entries.try_append({ 0, &entry }));
+        offset += entry.rec_len;
+    }
+
+    auto leaf = TRY(create_block_buffer(block_size));
+    pack_directory_block(leaf, entries.span());
+    auto leaf_block = TRY(append_directory_block(leaf));
+
+    dot_dot.rec_len = block_size - 12;
+    memset(root.data() + directory_index_root_info_offset, 0, block_size - directory_index_root_info_offset);
+    auto& info = *reinterpret_cast<ext2_dx_root_info*>(root.data() + directory_index_root_info_offset);
+    info.hash_version = fs().default_directory_hash_version();
+    info.info_length = sizeof(ext2_dx_root_info);
+    auto& count_limit = *reinterpret_cast<ext2_dx_countlimit*>(root.data() + directory_index_root_entries_offset);
+    count_limit.limit = (block_size - directory_index_root_entries_offset) / sizeof(ext2_dx_entry);
+    count_limit.count = 1;
+    reinterpret_cast<ext2_dx_entry*>(root.data() + directory_index_root_entries_offset)->block = leaf_block;
+    TRY(write_directory_block(0, root));
+
+    m_raw_inode.i_flags |= EXT2_INDEX_FL;
+    set_metadata_dirty(true);
+    m_lookup_cache.clear();
+    return true;
+}
+
+// Splits a full leaf block in two halves with distinct hash ranges, and adds the upper half to the index.
+ErrorOr<void> Ext2FSInode::split_directory_index_leaf(DirectoryIndexPath& path, ReadonlyBytes leaf)
+{
+    Vector<HashedDirectoryEntry> entries;
+    for (size_t offset = 0; offset < leaf.size();) {
+        if (!is_valid_directory_entry(leaf, offset))
+            return EIO;
+        auto const& entry = *reinterpret_cast<ext2_dir_entry_2 const*>(leaf.offset_pointer(offset));
+        if (entry.inode != 0)
+            TRY(entries.try_append({ fs().directory_entry_hash(directory_entry_name(entry), path.hash_version), &entry }));
+        offset += entry.rec_len;
+    }
+    if (entries.size() < 2)
+        return ENOSPC;
+    quick_sort(entries, [](auto const& a, auto const& b) { return a.hash < b.hash; });
+
+    // Try not to split a run of equal hashes, so lookups for them only have to look at one leaf.
+    size_t middle = entries.size() / 2;
+    size_t split = middle;
+    for (size_t distance = 0; distance <= middle / 2; ++distance) {
+        if (entries[middle - distance - 1].hash != entries[middle - distance].hash) {
+            split = middle - distance;
+            break;
+        }
+        if (middle + distance + 1 < entries.size() && entries[middle + distance].hash != entries[middle + distance + 1].hash) {
+            split = middle + distance + 1;
+            break;
+        }
+    }
+    u32 split_hash = entries[split].hash;
+    if (entries[split - 1].hash == split_hash)
+        split_hash |= 1;
+
+    auto block_size = fs().block_size();
+    auto lower_half = TRY(create_block_buffer(block_size));
+    auto upper_half = TRY(create_block_buffer(block_size));
+    pack_directory_block(lower_half, entries.span().slice(0, split));
+    pack_directory_block(upper_half, entries.span().slice(split));
+
+    auto& node = path.bottom();
+    auto leaf_block = node.block_at(node.position);
+    auto new_leaf_block = TRY(append_directory_block(upper_half));
+    node.insert(node.position + 1, split_hash, new_leaf_block);
+    TRY(write_directory_block(node.block, node.data));
+    return write_directory_block(leaf_block, lower_half);
+}
+
+// Makes room in the lowest index node, either by moving the entries of the root into
+// a new node below it, or by splitting that node and adding its upper half to the root.
+ErrorOr<void> Ext2FSInode::grow_directory_index(DirectoryIndexPath& path)
+{
+    auto block_size = fs().block_size();
+    auto& root = path.nodes[0];
+    auto new_node = TRY(create_block_buffer(block_size));
+    directory_entry_at(new_node, 0).rec_len = block_size;
+    auto* new_entries = reinterpret_cast<ext2_dx_entry*>(new_node.data() + directory_index_node_entries_offset);
+    auto& new_count_limit = *reinterpret_cast<ext2_dx_countlimit*>(new_entries);
+    u16 new_limit = (block_size - directory_index_node_entries_offset) / sizeof(ext2_dx_entry);
+
+    if (path.depth == 1) {
+        memcpy(new_entries, root.entries(), root.count() * sizeof(ext2_dx_entry));
+        new_count_limit = { new_limit, root.count() };
+        auto new_block = TRY(append_directory_block(new_node));
+        root.count_limit().count = 1;
+        root.entries()[0].block = new_block;
+        reinterpret_cast<ext2_dx_root_info*>(root.data.data() + directory_index_root_info_offset)->indirect_levels = 1;
+        return write_directory_block(0, root.data);
+    }
+
+    // FIXME: ext4 can add a third level with the large_dir feature, but that's a lot of files.
+    if (root.count() >= root.limit())
+        return ENOSPC;
+
+    auto& node = path.nodes[1];
+    size_t split = node.count() / 2;
+    u32 split_hash = node.hash_at(split);
+    memcpy(new_entries, &node.entries()[split], (node.count() - split) * sizeof(ext2_dx_entry));
+    new_count_limit = { new_limit, static_cast<u16>(node.count() - split) };
+    auto new_block = TRY(append_directory_block(new_node));
+    root.insert(root.position + 1, split_hash, new_block);
+    TRY(write_directory_block(0, root.data));
+    node.count_limit().count = split;
+    return write_directory_block(node.block, node.data);
+}
+
+// Returns false if this directory doesn't have an index we can use.
+ErrorOr<bool> Ext2FSInode::try_add_child_to_directory_index(StringView name, InodeIndex inode_index, u8 file_type)
+{
+    if (!has_directory_index())
+        return false;
+
+    auto block_size = fs().block_size();
+    auto path = TRY(DirectoryIndexPath::try_create(block_size));
+    auto leaf = TRY(create_block_buffer(block_size));
+
+    // Each round either finds room for the entry, splits its leaf or grows the index above it,
+    // which can only happen so many times in a row.
+    for (size_t round = 0; round < 4; ++round) {
+        if (!TRY(probe_directory_index(name, *path))) {
+            drop_directory_index();
+            return false;
+        }
+        auto leaf_block = path->leaf_block();
+        TRY(read_directory_block(leaf_block, leaf));
+        if (TRY(try_add_entry_to_directory_block(leaf, name, inode_index, file_type))) {
+            TRY(write_directory_block(leaf_block, leaf));
+            return true;
+        }
+        if (path->bottom().count() < path->bottom().limit())
+            TRY(split_directory_index_leaf(*path, leaf));
+        else
+            TRY(grow_directory_index(*path));
+    }
+    return ENOSPC;
+}
+
+ErrorOr<void> Ext2FSInode::add_child_linearly(StringView name, InodeIndex inode_index, u8 file_type)
+{
+    if (m_raw_inode.i_flags & EXT2_INDEX_FL)
+        drop_directory_index();
+
+    auto block_size = fs().block_size();
+    auto block = TRY(create_block_buffer(block_size));
+    auto block_count = directory_block_count();
+    bool added = false;
+    for (u32 block_index = 0; block_index < block_count && !added; ++block_index) {
+        TRY(read_directory_block(block_index, block));
+        added = TRY(try_add_entry_to_directory_block(block, name, inode_index, file_type));
+        if (added)
+            TRY(write_directory_block(block_index, block));
+    }
+
+    if (!added) {
+        if (block_count == 1 && fs().supports_directory_index() && TRY(convert_to_indexed_directory())) {
+            if (!TRY(try_add_child_to_directory_index(name, inode_index, file_type)))
+                return EIO;
+            return {};
+        }
+        memset(block.data(), 0, block_size);
+        write_directory_entry(block, 0, block_size, name, inode_index, file_type);
+        TRY(append_directory_block(block));
+    }
+
+    // The lookup cache is only filled in on first use.
+    if (!m_lookup_cache.is_empty()) {
+        auto cache_entry_name = TRY(KString::try_create(name));
+        TRY(m_lookup_cache.try_set(move(cache_entry_name), InodeIndex { inode_index }));
+    }
+    return {};
+}
+
+ErrorOr<Optional<InodeIndex>> Ext2FSInode::remove_directory_entry(StringView name)
+{
+    auto block_size = fs().block_size();
+    auto block = TRY(create_block_buffer(block_size));
+
+    // rmdir() removes these right before freeing the directory, so it doesn't matter
+    // that removing ".." gives the space of the index root to ".".
+    if (has_directory_index() && is_dot_or_dot_dot(name)) {
+        TRY(read_directory_block(0, block));
+        auto inode_index = TRY(remove_entry_from_directory_block(block, name));
+        if (inode_index.has_value())
+            TRY(write_directory_block(0, block));
+        return inode_index;
+    }
+    if (has_directory_index()) {
+        auto path = TRY(DirectoryIndexPath::try_create(block_size));
+        if (TRY(probe_directory_index(name, *path))) {
+            auto offset = TRY(find_entry_in_directory_index(name, *path, block));
+            if (!offset.has_value())
+                return Optional<InodeIndex> {};
+            auto inode_index = TRY(remove_entry_from_directory_block(block, name));
+            TRY(write_directory_block(path->leaf_block(), block));
+            return inode_index;
+        }
+    }
+    if (m_raw_inode.i_flags & EXT2_INDEX_FL)
+        drop_directory_index();
+
+    auto block_count = directory_block_count();
+    for (u32 block_index = 0; block_index < block_count; ++block_index) {
+        TRY(read_directory_block(block_index, block));
+        auto inode_index = TRY(remove_entry_from_directory_block(block, name));
+        if (!inode_index.has_value())
+            continue;
+        TRY(write_directory_block(block_index, block));
+        auto it = m_lookup_cache.find(name.hash(), [&](auto& entry) { return entry.key->view() == name; });
+        if (it != m_lookup_cache.end())
+            m_lookup_cache.remove(it);
+        return inode_index;
+    }
+    return Optional<InodeIndex> {};
+}
+
 ErrorOr<void> Ext2FSInode::add_child(Inode& child, StringView name, mode_t mode)
 {
     MutexLocker locker(m_inode_lock);
@@ -1159,25 +1952,19 @@ ErrorOr<void> Ext2FSInode::add_child(Inode& child, StringView name, mode_t mode)
 
     dbgln_if(EXT2_DEBUG, "Ext2FSInode[{}]::add_child(): Adding inode {} with name '{}' and mode {:o} to directory {}", identifier(), child.index(), name, mode, index());
 
-    Vector<Ext2FSDirectoryEntry> entries;
-    TRY(traverse_as_directory([&](auto& entry) -> ErrorOr<void> {
-        if (name == entry.name)
-            return EEXIST;
-        auto entry_name = TRY(KString::try_create(entry.name));
-        TRY(entries.try_append({ move(entry_name), entry.inode.index(), entry.file_type }));
-        return {};
-    }));
+    if (TRY(find_child(name)).has_value())
+        return EEXIST;
 
     TRY(child.increment_link_count());
 
-    auto entry_name = TRY(KString::try_create(name));
-    TRY(entries.try_empend(move(entry_name), child.index(), to_ext2_file_type(mode)));
-
-    TRY(write_directory(entries));
-    TRY(populate_lookup_cache());
+    // Adding the entry may fail after some directory blocks were already rewritten,
+    // so the DentryCache can't keep a negative entry for this name either way.
+    ArmedScopeGuard invalidate_on_failure = [&] { DentryCache::the().invalidate(*this, name); };
+    auto file_type = to_ext2_file_type(mode);
+    if (!TRY(try_add_child_to_directory_index(name, child.index(), file_type)))
+        TRY(add_child_linearly(name, child.index(), file_type));
+    invalidate_on_failure.disarm();
 
-    auto cache_entry_name = TRY(KString::try_create(name));
-    TRY(m_lookup_cache.try_set(move(cache_entry_name), child.index()));
     did_add_child(child.identifier(), name);
     return {};
 }
@@ -1188,32 +1975,17 @@ ErrorOr<void> Ext2FSInode::remove_child(StringView name)
     dbgln_if(EXT2_DEBUG, "Ext2FSInode[{}]::remove_child(): Removing '{}'", identifier(), name);
     VERIFY(is_directory());
 
-    TRY(populate_lookup_cache());
-
-    auto it = m_lookup_cache.find(name.hash(), [&](auto& entry) { return entry.key->view() == name; });
-    if (it == m_lookup_cache.end())
+    ArmedScopeGuard invalidate_on_failure = [&] { DentryCache::the().invalidate(*this, name); };
+    auto child_inode_index = TRY(remove_directory_entry(name));
+    invalidate_on_failure.disarm();
+    if (!child_inode_index.has_value())
         return ENOENT;
-    auto child_inode_index = (*it).value;
-
-    InodeIdentifier child_id { fsid(), child_inode_index };
-
-    Vector<Ext2FSDirectoryEntry> entries;
-    TRY(traverse_as_directory([&](auto& entry) -> ErrorOr<void> {
-        if (name != entry.name) {
-            auto entry_name = TRY(KString::try_create(entry.name));
-            TRY(entries.try_append({ move(entry_name), entry.inode.index(), entry.file_type }));
-        }
-        return {};
-    }));
-
-    TRY(write_directory(entries));
-
-    m_lookup_cache.remove(it);
 
+    // The entry is gone from the directory now, even if dropping the child's link count fails below.
+    InodeIdentifier child_id { fsid(), child_inode_index.value() };
+    ScopeGuard notify_removal = [&] { did_remove_child(child_id, name); };
     auto child_inode = TRY(fs().get_inode(child_id));
     TRY(child_inode->decrement_link_count());
-
-    did_remove_child(child_id, name);
     return {};
 }
 
@@ -1457,7 +2229,76 @@ ErrorOr<void> Ext2FS::set_block_allocation_state(BlockIndex block_index, bool ne
     auto& bgd = const_cast<ext2_group_desc&>(group_descriptor(group_index));
 
     dbgln_if(EXT2_DEBUG, "Ext2FS: Block {} state -> {} (in bitmap block {})", block_index, new_state, bgd.bg_block_bitmap);
-    return update_bitmap_block(bgd.bg_block_bitmap, bit_index, new_state, m_super_block.s_free_blocks_count, bgd.bg_free_blocks_count);
+    TRY(update_bitmap_block(bgd.bg_block_bitmap, bit_index, new_state, m_super_block.s_free_blocks_count, bgd.bg_free_blocks_count));
+
+    if (new_state)
+        forget_freed_block(block_index);
+    else
+        remember_freed_block(block_index);
+    return {};
+}
+
+void Ext2FS::remember_freed_block(BlockIndex block_index)
+{
+    VERIFY(m_lock.is_locked());
+    if (!m_discards_freed_blocks)
+        return;
+    // Files are usually freed a run of blocks at a time.
+    if (!m_freed_blocks_to_discard.is_empty()) {
+        auto& last_range = m_freed_blocks_to_discard.last();
+        if (last_range.first_block.value() + last_range.block_count == block_index.value()) {
+            ++last_range.block_count;
+            return;
+        }
+        if (last_range.first_block.value() == block_index.value() + 1) {
+            last_range.first_block = block_index;
+            ++last_range.block_count;
+            return;
+        }
+    }
+    if (m_freed_blocks_to_discard.size() >= max_freed_block_ranges)
+        return;
+    (void)m_freed_blocks_to_discard.try_append({ block_index, 1 });
+}
+
+void Ext2FS::forget_freed_block(BlockIndex block_index)
+{
+    VERIFY(m_lock.is_locked());
+    for (size_t i = 0; i < m_freed_blocks_to_discard.size(); ++i) {
+        auto& range = m_freed_blocks_to_discard[i];
+        auto first = range.first_block.value();
+        if (block_index.value() < first || block_index.value() >= first + range.block_count)
+            continue;
+
+        if (range.block_count == 1) {
+            m_freed_blocks_to_discard.remove(i);
+        } else if (block_index.value() == first) {
+            range.first_block = first + 1;
+            --range.block_count;
+        } else if (block_index.value() == first + range.block_count - 1) {
+            --range.block_count;
+        } else {
+            // Split the range around the block. If we can't keep track of the second half, it's simply not discarded.
+            FreedBlockRange second_half { block_index.value() + 1, first + range.block_count - block_index.value() - 1 };
+            range.block_count = block_index.value() - first;
+            if (m_freed_blocks_to_discard.size() < max_freed_block_ranges)
+                (void)m_freed_blocks_to_discard.try_insert(i + 1, second_half);
+        }
+        return;
+    }
+}
+
+void Ext2FS::discard_freed_blocks()
+{
+    // NOTE: We hold the lock while discarding, so none of the blocks can be allocated and written to in the meantime.
+    VERIFY(m_lock.is_locked());
+    auto ranges = move(m_freed_blocks_to_discard);
+    for (auto& range : ranges) {
+        if (auto result = discard_blocks(range.first_block, range.block_count); result.is_error()) {
+            dbgln("Ext2FS[{}]::flush_writes(): Failed to discard blocks: {}", fsid(), result.error());
+            return;
+        }
+    }
 }
 
 ErrorOr<NonnullRefPtr<Inode>> Ext2FS::create_directory(Ext2FSInode& parent_inode, StringView name, mode_t mode, UserID uid, GroupID gid)
@@ -1547,20 +2388,14 @@ ErrorOr<NonnullRefPtr<Inode>> Ext2FSInode::lookup(StringView name)
 {
     VERIFY(is_directory());
     dbgln_if(EXT2_DEBUG, "Ext2FSInode[{}]:lookup(): Looking up '{}'", identifier(), name);
-    TRY(populate_lookup_cache());
 
-    InodeIndex inode_index;
-    {
-        MutexLocker locker(m_inode_lock);
-        auto it = m_lookup_cache.find(name.hash(), [&](auto& entry) { return entry.key->view() == name; });
-        if (it == m_lookup_cache.end()) {
-            dbgln_if(EXT2_DEBUG, "Ext2FSInode[{}]:lookup(): '{}' not found", identifier(), name);
-            return ENOENT;
-        }
-        inode_index = it->value;
+    auto inode_index = TRY(find_child(name));
+    if (!inode_index.has_value()) {
+        dbgln_if(EXT2_DEBUG, "Ext2FSInode[{}]:lookup(): '{}' not found", identifier(), name);
+        return ENOENT;
     }
 
-    return fs().get_inode({ fsid(), inode_index });
+    return fs().get_inode({ fsid(), inode_index.value() });
 }
 
 ErrorOr<void> Ext2FSInode::set_atime(time_t t)
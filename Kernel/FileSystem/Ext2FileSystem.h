@@ -54,8 +54,28 @@ private:
     virtual ErrorOr<void> truncate(u64) override;
     virtual ErrorOr<int> get_block_address(int) override;
 
+    struct DirectoryIndexPath;
+
     ErrorOr<void> write_directory(Vector<Ext2FSDirectoryEntry>&);
     ErrorOr<void> populate_lookup_cache() const;
+    ErrorOr<Optional<InodeIndex>> find_child(StringView name) const;
+    ErrorOr<Optional<InodeIndex>> remove_directory_entry(StringView name);
+    ErrorOr<void> add_child_linearly(StringView name, InodeIndex, u8 file_type);
+    u32 directory_block_count() const;
+    ErrorOr<void> read_directory_block(u32, Bytes) const;
+    ErrorOr<void> write_directory_block(u32, ReadonlyBytes);
+    ErrorOr<u32> append_directory_block(ReadonlyBytes);
+
+    // Hash-indexed ("htree") directories, as introduced by ext3.
+    bool has_directory_index() const;
+    void drop_directory_index();
+    ErrorOr<bool> convert_to_indexed_directory();
+    ErrorOr<bool> probe_directory_index(StringView name, DirectoryIndexPath&) const;
+    ErrorOr<Optional<u32>> advance_directory_index_path(DirectoryIndexPath&) const;
+    ErrorOr<Optional<size_t>> find_entry_in_directory_index(StringView name, DirectoryIndexPath&, Bytes leaf) const;
+    ErrorOr<bool> try_add_child_to_directory_index(StringView name, InodeIndex, u8 file_type);
+    ErrorOr<void> split_directory_index_leaf(DirectoryIndexPath&, ReadonlyBytes leaf);
+    ErrorOr<void> grow_directory_index(DirectoryIndexPath&);
     ErrorOr<void> resize(u64);
     ErrorOr<void> write_indirect_block(BlockBasedFileSystem::BlockIndex, Span<BlockBasedFileSystem::BlockIndex>);
     ErrorOr<void> grow_doubly_indirect_block(BlockBasedFileSystem::BlockIndex, size_t, Span<BlockBasedFileSystem::BlockIndex>, Vector<BlockBasedFileSystem::BlockIndex>&, unsigned&);
@@ -99,10 +119,12 @@ public:
     virtual ErrorOr<void> prepare_to_unmount() override;
 
     virtual bool supports_watchers() const override { return true; }
+    virtual bool supports_page_cache() const override { return true; }
 
     virtual u8 internal_file_type_to_directory_entry_type(const DirectoryEntryView& entry) const override;
 
     FeaturesReadOnly get_features_readonly() const;
+    bool supports_directory_index() const;
 
 private:
     TYPEDEF_DISTINCT_ORDERED_ID(unsigned, GroupIndex);
@@ -120,6 +142,8 @@ private:
     u64 inode_size() const;
 
     ErrorOr<void> write_ext2_inode(InodeIndex, ext2_inode const&);
+    u8 default_directory_hash_version() const;
+    u32 directory_entry_hash(StringView name, u8 hash_version) const;
     bool find_block_containing_inode(InodeIndex, BlockIndex& block_index, unsigned& offset) const;
 
     ErrorOr<void> flush_super_block();
@@ -129,7 +153,7 @@ private:
     ErrorOr<NonnullRefPtr<Inode>> get_inode(InodeIdentifier) const;
     ErrorOr<NonnullRefPtr<Inode>> create_inode(Ext2FSInode& parent_inode, StringView name, mode_t, dev_t, UserID, GroupID);
     ErrorOr<NonnullRefPtr<Inode>> create_directory(Ext2FSInode& parent_inode, StringView name, mode_t, UserID, GroupID);
-    virtual void flush_writes() override;
+    virtual ErrorOr<void> flush_writes() override;
 
     BlockIndex first_block_index() const;
     ErrorOr<InodeIndex> allocate_inode(GroupIndex preferred_group = 0);
@@ -181,6 +205,21 @@ private:
 
     Vector<OwnPtr<CachedBitmap>> m_cached_bitmaps;
     RefPtr<Ext2FSInode> m_root_inode;
+
+    // Freed blocks are discarded on the device once the bitmaps marking them as free have been flushed.
+    // Forgetting about some of them only costs the device some space, so the list is capped.
+    static constexpr size_t max_freed_block_ranges = 1024;
+    struct FreedBlockRange {
+        BlockIndex first_block { 0 };
+        size_t block_count { 0 };
+    };
+
+    void remember_freed_block(BlockIndex);
+    void forget_freed_block(BlockIndex);
+    void discard_freed_blocks();
+
+    bool m_discards_freed_blocks { false };
+    Vector<FreedBlockRange> m_freed_blocks_to_discard;
 };
 
 inline Ext2FS& Ext2FSInode::fs()
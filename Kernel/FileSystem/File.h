@@ -7,6 +7,7 @@
 #pragma once
 
 #include <AK/Error.h>
+#include <AK/IntrusiveList.h>
 #include <AK/NonnullRefPtr.h>
 #include <AK/RefCounted.h>
 #include <AK/StringView.h>
@@ -21,10 +22,31 @@ namespace Kernel {
 
 class File;
 
+// A FileReadinessWatcher is a persistent observer of a FileBlockerSet.
+// Unlike a Thread::FileBlocker, it stays registered across wakeups and is
+// told every time the readiness of the underlying File may have changed.
+// This is what allows ReadinessSet to avoid re-scanning every watched file.
+class FileReadinessWatcher {
+public:
+    virtual ~FileReadinessWatcher() = default;
+
+    // NOTE: This is called with the FileBlockerSet lock held.
+    virtual void file_readiness_may_have_changed() = 0;
+
+private:
+    friend class FileBlockerSet;
+    IntrusiveListNode<FileReadinessWatcher> m_blocker_set_list_node;
+};
+
 class FileBlockerSet final : public Thread::BlockerSet {
 public:
     FileBlockerSet() { }
 
+    virtual ~FileBlockerSet() override
+    {
+        VERIFY(m_readiness_watchers.is_empty());
+    }
+
     virtual bool should_add_blocker(Thread::Blocker& b, void* data) override
     {
         VERIFY(b.blocker_type() == Thread::Blocker::Type::File);
@@ -40,7 +62,24 @@ public:
             auto& blocker = static_cast<Thread::FileBlocker&>(b);
             return blocker.unblock_if_conditions_are_met(false, data);
         });
+        for (auto& watcher : m_readiness_watchers)
+            watcher.file_readiness_may_have_changed();
     }
+
+    void add_readiness_watcher(FileReadinessWatcher& watcher)
+    {
+        SpinlockLocker lock(m_lock);
+        m_readiness_watchers.append(watcher);
+    }
+
+    void remove_readiness_watcher(FileReadinessWatcher& watcher)
+    {
+        SpinlockLocker lock(m_lock);
+        m_readiness_watchers.remove(watcher);
+    }
+
+private:
+    IntrusiveList<&FileReadinessWatcher::m_blocker_set_list_node> m_readiness_watchers;
 };
 
 // File is the base class for anything that can be referenced by a OpenFileDescription.
@@ -114,6 +153,8 @@ public:
     virtual bool is_character_device() const { return false; }
     virtual bool is_socket() const { return false; }
     virtual bool is_inode_watcher() const { return false; }
+    virtual bool is_readiness_set() const { return false; }
+    virtual bool is_io_ring() const { return false; }
 
     virtual FileBlockerSet& blocker_set() { return m_blocker_set; }
 
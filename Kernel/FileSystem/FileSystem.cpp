@@ -60,8 +60,23 @@ void FileSystem::sync()
             file_systems.append(*it.value);
     }
 
+    for (auto& fs : file_systems) {
+        if (auto result = fs.flush_writes(); result.is_error())
+            dbgln("FileSystem::sync(): Failed to flush {}: {}", fs.class_name(), result.error());
+    }
+}
+
+void FileSystem::write_back_all()
+{
+    NonnullRefPtrVector<FileSystem, 32> file_systems;
+    {
+        InterruptDisabler disabler;
+        for (auto& it : all_file_systems())
+            file_systems.append(*it.value);
+    }
+
     for (auto& fs : file_systems)
-        fs.flush_writes();
+        fs.write_back_dirty_data();
 }
 
 void FileSystem::lock_all()
@@ -29,12 +29,16 @@ public:
     FileSystemID fsid() const { return m_fsid; }
     static FileSystem* from_fsid(FileSystemID);
     static void sync();
+    static void write_back_all();
     static void lock_all();
 
     virtual ErrorOr<void> initialize() = 0;
     virtual StringView class_name() const = 0;
     virtual Inode& root_inode() = 0;
     virtual bool supports_watchers() const { return false; }
+    // Whether the PageCache may keep this file system's file contents around. File systems that say yes
+    // must invalidate the cached pages of an inode whenever its contents change.
+    virtual bool supports_page_cache() const { return false; }
 
     bool is_readonly() const { return m_readonly; }
 
@@ -53,7 +57,11 @@ public:
         u8 file_type { 0 };
     };
 
-    virtual void flush_writes() { }
+    virtual ErrorOr<void> flush_writes() { return {}; }
+    // Called periodically by the SyncTask to write back data that has been dirty for too long,
+    // or that exceeds the file system's background dirty limit. Unlike flush_writes(), this
+    // doesn't have to write everything.
+    virtual void write_back_dirty_data() { }
 
     u64 block_size() const { return m_block_size; }
     size_t fragment_size() const { return m_fragment_size; }
@@ -0,0 +1,651 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/NumericLimits.h>
+#include <Kernel/FileSystem/IORing.h>
+#include <Kernel/FileSystem/OpenFileDescription.h>
+#include <Kernel/KString.h>
+#include <Kernel/Memory/MemoryManager.h>
+#include <Kernel/Memory/ScopedAddressSpaceSwitcher.h>
+#include <Kernel/Net/Socket.h>
+#include <Kernel/Process.h>
+
+namespace Kernel {
+
+using BlockFlags = Thread::FileBlocker::BlockFlags;
+
+// Arbitrary pain threshold, same as readv() and writev().
+static constexpr u32 max_iovecs_per_request = 1024;
+
+ErrorOr<NonnullRefPtr<IORing>> IORing::try_create(u32 entries)
+{
+    if (entries == 0 || entries > IO_RING_MAX_ENTRIES)
+        return EINVAL;
+
+    u32 submission_entries = 1;
+    while (submission_entries < entries)
+        submission_entries <<= 1;
+
+    io_ring_params params {};
+    params.submission_entries = submission_entries;
+    params.completion_entries = submission_entries * 2;
+    params.submissions_offset = round_up_to_power_of_two(sizeof(io_ring_header), 64);
+    params.completions_offset = params.submissions_offset + params.submission_entries * sizeof(io_ring_submission);
+    params.mapping_size = TRY(Memory::page_round_up(params.completions_offset + params.completion_entries * sizeof(io_ring_completion)));
+
+    // NOTE: The pages are committed up front, as completions are posted from contexts that can't take page faults.
+    auto vmobject = TRY(Memory::AnonymousVMObject::try_create_with_size(params.mapping_size, AllocationStrategy::AllocateNow));
+    auto kernel_region = TRY(MM.allocate_kernel_region_with_vmobject(*vmobject, params.mapping_size, "IORing"sv, Memory::Region::Access::ReadWrite));
+    auto worker = TRY(Worker::try_create());
+    auto ring_or_error = adopt_nonnull_ref_or_enomem(new (nothrow) IORing(params, move(vmobject), move(kernel_region), worker));
+    if (ring_or_error.is_error())
+        worker->shut_down();
+    return ring_or_error;
+}
+
+IORing::IORing(io_ring_params const& params, NonnullRefPtr<Memory::AnonymousVMObject> vmobject, NonnullOwnPtr<Memory::Region> kernel_region, NonnullRefPtr<Worker> worker)
+    : m_params(params)
+    , m_vmobject(move(vmobject))
+    , m_kernel_region(move(kernel_region))
+    , m_worker(move(worker))
+{
+    memset(m_kernel_region->vaddr().as_ptr(), 0, m_params.mapping_size);
+}
+
+// NOTE: Like ReadinessSet, we don't override File::close(), as the ring is shared by every
+//       description referring to it. Whatever is still in flight is dropped with the last one.
+IORing::~IORing()
+{
+    RequestList requests;
+    {
+        SpinlockLocker lock(m_completion_lock);
+        while (auto request = m_requests.take_first())
+            requests.append(*request);
+    }
+    while (auto request = requests.take_first())
+        request->detach();
+    // NOTE: The worker drops whatever is still queued up for us, as those requests can't find their ring anymore.
+    m_worker->shut_down();
+}
+
+ErrorOr<NonnullRefPtr<IORing::Worker>> IORing::Worker::try_create()
+{
+    auto worker = TRY(adopt_nonnull_ref_or_enomem(new (nothrow) Worker));
+    auto name = TRY(KString::try_create("IORing Worker"sv));
+    RefPtr<Thread> thread;
+    auto process = Process::create_kernel_process(thread, move(name), [worker]() mutable {
+        worker->run();
+    });
+    if (!process)
+        return ENOMEM;
+    return worker;
+}
+
+void IORing::Worker::queue(Request& request)
+{
+    m_queued_requests.with([&](auto& requests) {
+        requests.append(request);
+    });
+    m_wait_queue.wake_one();
+}
+
+void IORing::Worker::shut_down()
+{
+    m_shutting_down = true;
+    m_wait_queue.wake_one();
+}
+
+void IORing::Worker::run()
+{
+    // NOTE: Writes to a pipe without readers raise SIGPIPE on the current thread, which must not interrupt us.
+    Thread::current()->update_signal_mask(NumericLimits<u32>::max());
+    for (;;) {
+        // Check this first, so we don't miss anything that was queued up right before the ring went away.
+        bool shutting_down = m_shutting_down;
+        auto request = m_queued_requests.with([&](auto& requests) {
+            return requests.take_first();
+        });
+        if (request) {
+            request->run_queued_attempt();
+            continue;
+        }
+        if (shutting_down)
+            return;
+        // NOTE: Work queued up before we get to block leaves a wake request behind, so it's not lost.
+        [[maybe_unused]] auto result = m_wait_queue.wait_on({});
+    }
+}
+
+io_ring_submission& IORing::submission_at(u32 index) const
+{
+    auto* submissions = reinterpret_cast<io_ring_submission*>(m_kernel_region->vaddr().offset(m_params.submissions_offset).as_ptr());
+    return submissions[index & (m_params.submission_entries - 1)];
+}
+
+io_ring_completion& IORing::completion_at(u32 index) const
+{
+    auto* completions = reinterpret_cast<io_ring_completion*>(m_kernel_region->vaddr().offset(m_params.completions_offset).as_ptr());
+    return completions[index & (m_params.completion_entries - 1)];
+}
+
+size_t IORing::completions_ready() const
+{
+    SpinlockLocker lock(m_completion_lock);
+    auto head = AK::atomic_load(&header().completion_head, AK::memory_order_acquire);
+    return m_completion_tail - head;
+}
+
+bool IORing::can_read(const OpenFileDescription&, size_t) const
+{
+    return completions_ready() > 0;
+}
+
+ErrorOr<Memory::Region*> IORing::mmap(Process& process, OpenFileDescription&, Memory::VirtualRange const& range, u64 offset, int prot, bool shared)
+{
+    if (offset != 0 || range.size() != m_vmobject->size())
+        return EINVAL;
+    // A private mapping would stop seeing our side of the queues after its first write.
+    if (!shared)
+        return EINVAL;
+    return process.address_space().allocate_region_with_vmobject(range, m_vmobject, offset, "IORing"sv, prot, shared);
+}
+
+ErrorOr<NonnullOwnPtr<KString>> IORing::pseudo_path(const OpenFileDescription&) const
+{
+    return KString::formatted("IORing:({})", m_params.submission_entries);
+}
+
+ErrorOr<size_t> IORing::submit(Process& process, size_t count)
+{
+    MutexLocker locker(m_submission_lock);
+
+    auto& header = this->header();
+    u32 queued = AK::atomic_load(&header.submission_tail, AK::memory_order_acquire) - m_submission_head;
+    if (queued > m_params.submission_entries)
+        return EINVAL;
+    count = min(count, static_cast<size_t>(queued));
+
+    size_t submitted = 0;
+    while (submitted < count) {
+        {
+            SpinlockLocker lock(m_completion_lock);
+            // Every request in flight needs a free completion slot once it finishes.
+            u32 unconsumed = m_completion_tail - AK::atomic_load(&header.completion_head, AK::memory_order_acquire);
+            if (m_request_count + unconsumed >= m_params.completion_entries)
+                break;
+            ++m_request_count;
+        }
+
+        // NOTE: Userspace may scribble over the entry at any time, so we only ever look at our own copy.
+        io_ring_submission submission;
+        memcpy(&submission, &submission_at(m_submission_head), sizeof(submission));
+        AK::atomic_store(&header.submission_head, ++m_submission_head, AK::memory_order_release);
+        ++submitted;
+
+        auto request_or_error = Request::try_create(*this, process, submission);
+        if (request_or_error.is_error()) {
+            post_completion(submission.user_data, request_or_error.release_error());
+            continue;
+        }
+
+        auto request = request_or_error.release_value();
+        {
+            SpinlockLocker lock(m_completion_lock);
+            m_requests.append(request);
+        }
+        request->start();
+    }
+
+    if (submitted == 0 && count > 0)
+        return EBUSY;
+    return submitted;
+}
+
+ErrorOr<void> IORing::wait_for_completions(size_t count, Thread::BlockTimeout const& timeout)
+{
+    while (completions_ready() < count) {
+        // NOTE: A completion posted before we get to block leaves a wake request behind, so it's not lost.
+        auto result = m_completion_wait_queue.wait_on(timeout);
+        if (result.was_interrupted())
+            return EINTR;
+        if (result == Thread::BlockResult::InterruptedByTimeout)
+            break;
+    }
+    return {};
+}
+
+ErrorOr<FlatPtr> IORing::cancel(Request const& canceller, u64 user_data)
+{
+    RefPtr<Request> target;
+    {
+        SpinlockLocker lock(m_completion_lock);
+        for (auto& request : m_requests) {
+            if (&request != &canceller && request.user_data() == user_data) {
+                target = request;
+                break;
+            }
+        }
+    }
+    if (!target)
+        return ENOENT;
+    if (!target->cancel())
+        return EALREADY;
+    return 0;
+}
+
+void IORing::post_completion(u64 user_data, ErrorOr<FlatPtr> const& result, Request* request)
+{
+    {
+        SpinlockLocker lock(m_completion_lock);
+        // NOTE: Our caller holds a reference to the request, so this doesn't destroy it with our lock held.
+        if (request)
+            m_requests.remove(*request);
+        VERIFY(m_request_count > 0);
+        --m_request_count;
+
+        auto& header = this->header();
+        u32 unconsumed = m_completion_tail - AK::atomic_load(&header.completion_head, AK::memory_order_acquire);
+        if (unconsumed >= m_params.completion_entries) {
+            // Userspace moved completion_head somewhere it shouldn't have. Rather than overwriting
+            // completions that it may still be looking at, we let it know that this one got lost.
+            AK::atomic_fetch_add(&header.dropped_completions, 1u, AK::memory_order_relaxed);
+        } else {
+            auto& completion = completion_at(m_completion_tail);
+            completion.user_data = user_data;
+            completion.result = result.is_error() ? -static_cast<i32>(result.error().code()) : static_cast<i32>(result.value());
+            completion.flags = 0;
+            AK::atomic_store(&header.completion_tail, ++m_completion_tail, AK::memory_order_release);
+        }
+    }
+    m_completion_wait_queue.wake_all();
+    evaluate_block_conditions();
+}
+
+ErrorOr<NonnullRefPtr<IORing::Request>> IORing::Request::try_create(IORing& ring, Process& process, io_ring_submission const& submission)
+{
+    RefPtr<OpenFileDescription> description;
+    switch (submission.opcode) {
+    case IO_RING_OP_NOP:
+    case IO_RING_OP_CANCEL:
+        break;
+    case IO_RING_OP_READ:
+    case IO_RING_OP_READV:
+        description = TRY(process.fds().open_file_description(submission.fd));
+        if (!description->is_readable())
+            return EBADF;
+        if (description->is_directory())
+            return EISDIR;
+        break;
+    case IO_RING_OP_WRITE:
+    case IO_RING_OP_WRITEV:
+        description = TRY(process.fds().open_file_description(submission.fd));
+        if (!description->is_writable())
+            return EBADF;
+        break;
+    case IO_RING_OP_ACCEPT:
+        TRY(process.require_promise(Pledge::accept));
+        if (submission.flags & ~(SOCK_NONBLOCK | SOCK_CLOEXEC))
+            return EINVAL;
+        description = TRY(process.fds().open_file_description(submission.fd));
+        if (!description->is_socket())
+            return ENOTSOCK;
+        break;
+    case IO_RING_OP_CONNECT:
+        description = TRY(process.fds().open_file_description(submission.fd));
+        if (!description->is_socket())
+            return ENOTSOCK;
+        if (description->socket()->domain() == AF_INET)
+            TRY(process.require_promise(Pledge::inet));
+        else if (description->socket()->domain() == AF_LOCAL)
+            TRY(process.require_promise(Pledge::unix));
+        break;
+    case IO_RING_OP_POLL:
+        if (!submission.poll_events || (submission.poll_events & ~(POLLIN | POLLOUT)))
+            return EINVAL;
+        description = TRY(process.fds().open_file_description(submission.fd));
+        break;
+    case IO_RING_OP_FSYNC:
+        description = TRY(process.fds().open_file_description(submission.fd));
+        break;
+    default:
+        return EINVAL;
+    }
+
+    if (description) {
+        // NOTE: A request on a ring would keep that ring alive for as long as the request is in flight.
+        if (description->is_io_ring())
+            return EINVAL;
+        // TTYs do job control checks against the current process, which is not who we are once we retry on the worker.
+        if (description->is_tty())
+            return ENOTSUP;
+    }
+
+    auto request = TRY(adopt_nonnull_ref_or_enomem(new (nothrow) Request(ring, ring.m_worker, process, submission, move(description))));
+
+    switch (submission.opcode) {
+    case IO_RING_OP_READ:
+    case IO_RING_OP_WRITE:
+        if (submission.length > NumericLimits<ssize_t>::max())
+            return EINVAL;
+        TRY(request->m_iovecs.try_append({ reinterpret_cast<void*>(static_cast<FlatPtr>(submission.address)), submission.length }));
+        break;
+    case IO_RING_OP_READV:
+    case IO_RING_OP_WRITEV: {
+        if (submission.length > max_iovecs_per_request)
+            return EINVAL;
+        TRY(request->m_iovecs.try_resize(submission.length));
+        TRY(copy_n_from_user(request->m_iovecs.data(), Userspace<iovec const*>(static_cast<FlatPtr>(submission.address)), submission.length));
+        u64 total_length = 0;
+        for (auto& vec : request->m_iovecs) {
+            total_length += vec.iov_len;
+            if (total_length > NumericLimits<i32>::max())
+                return EINVAL;
+        }
+        break;
+    }
+    default:
+        break;
+    }
+
+    return request;
+}
+
+IORing::Request::Request(IORing& ring, NonnullRefPtr<Worker> worker, Process& process, io_ring_submission const& submission, RefPtr<OpenFileDescription> description)
+    : m_ring(ring.make_weak_ptr<IORing>())
+    , m_worker(move(worker))
+    , m_process(process)
+    , m_submission(submission)
+    , m_description(move(description))
+{
+}
+
+IORing::Request::~Request()
+{
+    VERIFY(!m_watching);
+}
+
+bool IORing::Request::should_run_on_worker() const
+{
+    switch (m_submission.opcode) {
+    case IO_RING_OP_FSYNC:
+        return true;
+    case IO_RING_OP_READ:
+    case IO_RING_OP_READV:
+    case IO_RING_OP_WRITE:
+    case IO_RING_OP_WRITEV:
+        return m_description->file().is_inode() || m_description->file().is_block_device();
+    default:
+        return false;
+    }
+}
+
+void IORing::Request::start()
+{
+    if (m_submission.opcode == IO_RING_OP_NOP || m_submission.opcode == IO_RING_OP_CANCEL) {
+        MutexLocker locker(m_lock);
+        if (m_submission.opcode == IO_RING_OP_NOP) {
+            complete(0);
+            return;
+        }
+        // NOTE: We are only ever started from IORing::submit(), which keeps the ring alive.
+        auto ring = m_ring.strong_ref();
+        VERIFY(ring);
+        complete(ring->cancel(*this, m_submission.address));
+        return;
+    }
+
+    if (should_run_on_worker()) {
+        queue_attempt();
+        return;
+    }
+
+    // Start watching before the first attempt, so a readiness change right after it can't get lost.
+    // NOTE: Holding the lock makes sure that the first attempt happens here, in the submitting thread.
+    MutexLocker locker(m_lock);
+    m_description->blocker_set().add_readiness_watcher(*this);
+    m_watching = true;
+    attempt_locked();
+}
+
+void IORing::Request::file_readiness_may_have_changed()
+{
+    // NOTE: We are called with the FileBlockerSet lock held, so leave the actual work to the worker.
+    queue_attempt();
+}
+
+void IORing::Request::queue_attempt()
+{
+    if (m_attempt_queued.exchange(true))
+        return;
+    m_worker->queue(*this);
+}
+
+void IORing::Request::run_queued_attempt()
+{
+    // Clear this first, so that a readiness change while we're busy queues up another attempt.
+    m_attempt_queued = false;
+    auto ring = m_ring.strong_ref();
+    if (!ring)
+        return;
+    ScopedAddressSpaceSwitcher switcher(*m_process);
+    attempt();
+}
+
+void IORing::Request::attempt()
+{
+    MutexLocker locker(m_lock);
+    attempt_locked();
+}
+
+void IORing::Request::attempt_locked()
+{
+    VERIFY(m_lock.is_locked());
+    if (m_completed)
+        return;
+
+    // Checking can_read() or can_write() up front isn't enough to keep the file from blocking us,
+    // as someone else may take the data or the buffer space in between. Watched requests wait for
+    // their next readiness change instead.
+    auto* current_thread = Thread::current();
+    bool was_file_io_nonblocking = current_thread->is_file_io_nonblocking();
+    current_thread->set_file_io_nonblocking(m_watching);
+    auto result = perform();
+    current_thread->set_file_io_nonblocking(was_file_io_nonblocking);
+    // Requests we are watching a description for simply wait for the next readiness change.
+    if (m_watching && result.is_error() && result.error().code() == EAGAIN)
+        return;
+    complete(result);
+}
+
+bool IORing::Request::cancel()
+{
+    MutexLocker locker(m_lock);
+    if (m_completed)
+        return false;
+    complete(ECANCELED);
+    return true;
+}
+
+void IORing::Request::detach()
+{
+    MutexLocker locker(m_lock);
+    m_completed = true;
+    if (m_watching) {
+        m_description->blocker_set().remove_readiness_watcher(*this);
+        m_watching = false;
+    }
+}
+
+void IORing::Request::complete(ErrorOr<FlatPtr> const& result)
+{
+    VERIFY(m_lock.is_locked());
+    VERIFY(!m_completed);
+    m_completed = true;
+    if (m_watching) {
+        m_description->blocker_set().remove_readiness_watcher(*this);
+        m_watching = false;
+    }
+    if (auto ring = m_ring.strong_ref())
+        ring->post_completion(user_data(), result, this);
+}
+
+ErrorOr<FlatPtr> IORing::Request::perform()
+{
+    switch (m_submission.opcode) {
+    case IO_RING_OP_READ:
+    case IO_RING_OP_READV:
+        return perform_read();
+    case IO_RING_OP_WRITE:
+    case IO_RING_OP_WRITEV:
+        return perform_write();
+    case IO_RING_OP_ACCEPT:
+        return perform_accept();
+    case IO_RING_OP_CONNECT:
+        return perform_connect();
+    case IO_RING_OP_POLL:
+        return perform_poll();
+    case IO_RING_OP_FSYNC:
+        TRY(m_description->sync());
+        return 0;
+    default:
+        VERIFY_NOT_REACHED();
+    }
+}
+
+ErrorOr<FlatPtr> IORing::Request::perform_read()
+{
+    auto& description = *m_description;
+    if (m_watching && !description.can_read())
+        return EAGAIN;
+
+    bool use_file_offset = m_submission.offset == IO_RING_OFFSET_CURRENT;
+    if (!use_file_offset && !description.file().is_seekable())
+        return EINVAL;
+
+    size_t total_nread = 0;
+    for (auto& vec : m_iovecs) {
+        auto buffer = TRY(UserOrKernelBuffer::for_user_buffer(static_cast<u8*>(vec.iov_base), vec.iov_len));
+        auto nread_or_error = use_file_offset
+            ? description.read(buffer, vec.iov_len)
+            : description.read(buffer, m_submission.offset + total_nread, vec.iov_len);
+        if (nread_or_error.is_error()) {
+            if (total_nread > 0)
+                break;
+            return nread_or_error.release_error();
+        }
+        total_nread += nread_or_error.value();
+        if (nread_or_error.value() < vec.iov_len)
+            break;
+    }
+    return total_nread;
+}
+
+ErrorOr<FlatPtr> IORing::Request::perform_write()
+{
+    auto& description = *m_description;
+    if (m_watching && !description.can_write())
+        return EAGAIN;
+
+    bool use_file_offset = m_submission.offset == IO_RING_OFFSET_CURRENT;
+    if (!use_file_offset && !description.file().is_seekable())
+        return EINVAL;
+    if (use_file_offset && description.should_append() && description.file().is_seekable())
+        TRY(description.seek(0, SEEK_END));
+
+    size_t total_nwritten = 0;
+    for (auto& vec : m_iovecs) {
+        auto buffer = TRY(UserOrKernelBuffer::for_user_buffer(static_cast<u8*>(vec.iov_base), vec.iov_len));
+        auto nwritten_or_error = use_file_offset
+            ? description.write(buffer, vec.iov_len)
+            : description.write(m_submission.offset + total_nwritten, buffer, vec.iov_len);
+        if (nwritten_or_error.is_error()) {
+            if (total_nwritten > 0)
+                break;
+            return nwritten_or_error.release_error();
+        }
+        total_nwritten += nwritten_or_error.value();
+        if (nwritten_or_error.value() < vec.iov_len)
+            break;
+    }
+    return total_nwritten;
+}
+
+ErrorOr<FlatPtr> IORing::Request::perform_accept()
+{
+    auto& socket = *m_description->socket();
+    if (!socket.can_accept())
+        return EAGAIN;
+
+    // NOTE: This mirrors sys$accept4(), which runs with the big process lock held.
+    MutexLocker big_lock_locker(m_process->big_lock());
+    auto fd_allocation = TRY(m_process->fds().allocate());
+    auto accepted_socket = socket.accept(*m_process);
+    if (!accepted_socket)
+        return EAGAIN;
+
+    if (m_submission.address && m_submission.length) {
+        sockaddr_un address_buffer {};
+        socklen_t address_size = min(sizeof(sockaddr_un), static_cast<size_t>(m_submission.length));
+        accepted_socket->get_peer_address((sockaddr*)&address_buffer, &address_size);
+        TRY(copy_to_user(reinterpret_cast<void*>(static_cast<FlatPtr>(m_submission.address)), &address_buffer, address_size));
+    }
+
+    auto accepted_socket_description = TRY(OpenFileDescription::try_create(*accepted_socket));
+    accepted_socket_description->set_readable(true);
+    accepted_socket_description->set_writable(true);
+    if (m_submission.flags & SOCK_NONBLOCK)
+        accepted_socket_description->set_blocking(false);
+    u32 fd_flags = (m_submission.flags & SOCK_CLOEXEC) ? FD_CLOEXEC : 0;
+    m_process->fds().set(fd_allocation.fd, move(accepted_socket_description), fd_flags);
+
+    accepted_socket->set_setup_state(Socket::SetupState::Completed);
+    return fd_allocation.fd;
+}
+
+ErrorOr<FlatPtr> IORing::Request::perform_connect()
+{
+    auto& socket = *m_description->socket();
+    if (m_connect_started) {
+        if (socket.setup_state() != Socket::SetupState::Completed)
+            return EAGAIN;
+        if (!socket.is_connected())
+            return ECONNREFUSED;
+        return 0;
+    }
+
+    // NOTE: The first attempt always happens in the submitting thread, which is where the address is read from.
+    //       Local sockets finish connecting right away (or block until they have), like they do for connect().
+    m_connect_started = true;
+    MutexLocker big_lock_locker(m_process->big_lock());
+    auto result = socket.connect(*m_description, Userspace<sockaddr const*>(static_cast<FlatPtr>(m_submission.address)), m_submission.length, ShouldBlock::No);
+    if (!result.is_error())
+        return 0;
+    if (result.error().code() == EINPROGRESS)
+        return EAGAIN;
+    return result.release_error();
+}
+
+ErrorOr<FlatPtr> IORing::Request::perform_poll()
+{
+    auto block_flags = BlockFlags::None;
+    if (m_submission.poll_events & POLLIN)
+        block_flags |= BlockFlags::Read;
+    if (m_submission.poll_events & POLLOUT)
+        block_flags |= BlockFlags::Write;
+
+    auto unblock_flags = m_description->should_unblock(block_flags);
+    if (unblock_flags == BlockFlags::None)
+        return EAGAIN;
+
+    FlatPtr revents = 0;
+    if (has_flag(unblock_flags, BlockFlags::Read))
+        revents |= POLLIN;
+    if (has_flag(unblock_flags, BlockFlags::Write))
+        revents |= POLLOUT;
+    return revents;
+}
+
+}
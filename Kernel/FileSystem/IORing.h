@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/IntrusiveList.h>
+#include <AK/NonnullOwnPtr.h>
+#include <AK/WeakPtr.h>
+#include <Kernel/FileSystem/File.h>
+#include <Kernel/Forward.h>
+#include <Kernel/Locking/Mutex.h>
+#include <Kernel/Locking/SpinlockProtected.h>
+#include <Kernel/Memory/AnonymousVMObject.h>
+#include <Kernel/Memory/Region.h>
+#include <Kernel/UnixTypes.h>
+#include <Kernel/WaitQueue.h>
+
+namespace Kernel {
+
+// An IORing is a pair of queues shared between a process and the kernel.
+//
+// The process fills in io_ring_submission entries and hands any number of them
+// to the kernel with a single io_ring_enter() call. Each one turns into a Request
+// that finishes by posting an io_ring_completion, which the process reads back
+// out of the shared mapping without another syscall.
+//
+// Requests on sockets, pipes and the like are attempted right away and, if they
+// would block, wait for a readiness change of their description (via
+// FileReadinessWatcher) to be retried by the worker of their ring. Requests that
+// may have to wait for storage, like reads from regular files and fsync, always
+// run on that worker so they never hold up the submitting thread. Every ring has
+// a worker thread of its own, so a slow disk only ever holds up the rings using it.
+//
+// We never have more requests in flight than there are free completion slots,
+// so the completion queue cannot overflow as long as userspace only ever moves
+// completion_head forward over completions it has consumed.
+class IORing final : public File {
+public:
+    static ErrorOr<NonnullRefPtr<IORing>> try_create(u32 entries);
+    virtual ~IORing() override;
+
+    virtual bool can_read(const OpenFileDescription&, size_t) const override;
+    virtual ErrorOr<size_t> read(OpenFileDescription&, u64, UserOrKernelBuffer&, size_t) override { return EINVAL; }
+    virtual bool can_write(const OpenFileDescription&, size_t) const override { return false; }
+    virtual ErrorOr<size_t> write(OpenFileDescription&, u64, const UserOrKernelBuffer&, size_t) override { return EINVAL; }
+    virtual ErrorOr<Memory::Region*> mmap(Process&, OpenFileDescription&, Memory::VirtualRange const&, u64 offset, int prot, bool shared) override;
+
+    virtual ErrorOr<NonnullOwnPtr<KString>> pseudo_path(const OpenFileDescription&) const override;
+    virtual StringView class_name() const override { return "IORing"sv; }
+    virtual bool is_io_ring() const override { return true; }
+
+    io_ring_params const& params() const { return m_params; }
+
+    // Starts up to `count` queued submissions and returns how many of them were consumed.
+    ErrorOr<size_t> submit(Process&, size_t count);
+
+    // Blocks until at least `count` completions are waiting to be consumed by userspace.
+    ErrorOr<void> wait_for_completions(size_t count, Thread::BlockTimeout const&);
+
+private:
+    class Worker;
+
+    class Request final
+        : public RefCounted<Request>
+        , public FileReadinessWatcher {
+    public:
+        static ErrorOr<NonnullRefPtr<Request>> try_create(IORing&, Process&, io_ring_submission const&);
+        virtual ~Request() override;
+
+        virtual void file_readiness_may_have_changed() override;
+
+        u64 user_data() const { return m_submission.user_data; }
+
+        void start();
+        bool cancel();
+        void detach();
+        void run_queued_attempt();
+
+        IntrusiveListNode<Request, RefPtr<Request>> m_list_node;
+        IntrusiveListNode<Request, RefPtr<Request>> m_worker_list_node;
+
+    private:
+        Request(IORing&, NonnullRefPtr<Worker>, Process&, io_ring_submission const&, RefPtr<OpenFileDescription>);
+
+        bool should_run_on_worker() const;
+
+        void queue_attempt();
+        void attempt();
+        void attempt_locked();
+        void complete(ErrorOr<FlatPtr> const&);
+
+        ErrorOr<FlatPtr> perform();
+        ErrorOr<FlatPtr> perform_read();
+        ErrorOr<FlatPtr> perform_write();
+        ErrorOr<FlatPtr> perform_accept();
+        ErrorOr<FlatPtr> perform_connect();
+        ErrorOr<FlatPtr> perform_poll();
+
+        WeakPtr<IORing> m_ring;
+        NonnullRefPtr<Worker> m_worker;
+        NonnullRefPtr<Process> m_process;
+        io_ring_submission m_submission;
+        RefPtr<OpenFileDescription> m_description;
+        Vector<iovec> m_iovecs;
+
+        // Serializes attempts coming from the submitting thread, the worker and cancellation.
+        Mutex m_lock;
+        bool m_completed { false };
+        bool m_connect_started { false };
+        bool m_watching { false };
+        Atomic<bool> m_attempt_queued { false };
+    };
+
+    using RequestList = IntrusiveList<&Request::m_list_node>;
+
+    // The kernel thread making the queued attempts of one ring. It keeps going until the ring shuts it down.
+    class Worker final : public RefCounted<Worker> {
+    public:
+        static ErrorOr<NonnullRefPtr<Worker>> try_create();
+
+        void queue(Request&);
+        void shut_down();
+
+    private:
+        Worker() = default;
+
+        void run();
+
+        SpinlockProtected<IntrusiveList<&Request::m_worker_list_node>> m_queued_requests;
+        Atomic<bool> m_shutting_down { false };
+        WaitQueue m_wait_queue;
+    };
+
+    IORing(io_ring_params const&, NonnullRefPtr<Memory::AnonymousVMObject>, NonnullOwnPtr<Memory::Region>, NonnullRefPtr<Worker>);
+
+    io_ring_header& header() const { return *reinterpret_cast<io_ring_header*>(m_kernel_region->vaddr().as_ptr()); }
+    io_ring_submission& submission_at(u32 index) const;
+    io_ring_completion& completion_at(u32 index) const;
+    size_t completions_ready() const;
+
+    ErrorOr<FlatPtr> cancel(Request const& canceller, u64 user_data);
+    void post_completion(u64 user_data, ErrorOr<FlatPtr> const&, Request* = nullptr);
+
+    io_ring_params m_params;
+    NonnullRefPtr<Memory::AnonymousVMObject> m_vmobject;
+    NonnullOwnPtr<Memory::Region> m_kernel_region;
+    NonnullRefPtr<Worker> m_worker;
+
+    Mutex m_submission_lock;
+    u32 m_submission_head { 0 };
+
+    mutable Spinlock m_completion_lock;
+    u32 m_completion_tail { 0 };
+    // Requests that have been started but have not posted their completion yet.
+    RequestList m_requests;
+    size_t m_request_count { 0 };
+
+    WaitQueue m_completion_wait_queue;
+};
+
+}
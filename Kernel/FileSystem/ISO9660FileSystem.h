@@ -311,6 +311,8 @@ public:
     virtual ErrorOr<void> initialize() override;
     virtual StringView class_name() const override { return "ISO9660FS"sv; }
     virtual Inode& root_inode() override;
+    // Nothing on an ISO 9660 image ever changes, so there's nothing to invalidate.
+    virtual bool supports_page_cache() const override { return true; }
 
     virtual unsigned total_block_count() const override;
     virtual unsigned total_inode_count() const override;
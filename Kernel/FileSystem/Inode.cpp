@@ -10,9 +10,11 @@
 #include <AK/StringView.h>
 #include <Kernel/API/InodeWatcherEvent.h>
 #include <Kernel/FileSystem/Custody.h>
+#include <Kernel/FileSystem/DentryCache.h>
 #include <Kernel/FileSystem/Inode.h>
 #include <Kernel/FileSystem/InodeWatcher.h>
 #include <Kernel/FileSystem/OpenFileDescription.h>
+#include <Kernel/FileSystem/PageCache.h>
 #include <Kernel/FileSystem/VirtualFileSystem.h>
 #include <Kernel/KBufferBuilder.h>
 #include <Kernel/Memory/SharedInodeVMObject.h>
@@ -44,11 +46,11 @@ void Inode::sync_all()
     }
 }
 
-void Inode::sync()
+ErrorOr<void> Inode::sync()
 {
     if (is_metadata_dirty())
-        (void)flush_metadata();
-    fs().flush_writes();
+        TRY(flush_metadata());
+    return fs().flush_writes();
 }
 
 ErrorOr<NonnullOwnPtr<KBuffer>> Inode::read_entire(OpenFileDescription* description) const
@@ -93,6 +95,8 @@ Inode::Inode(FileSystem& fs, InodeIndex index)
 
 Inode::~Inode()
 {
+    PageCache::the().forget(*this);
+
     for (auto& watcher : m_watchers) {
         watcher->unregister_by_inode({}, identifier());
     }
@@ -204,6 +208,8 @@ void Inode::set_metadata_dirty(bool metadata_dirty)
 
 void Inode::did_add_child(InodeIdentifier, StringView name)
 {
+    DentryCache::the().invalidate(*this, name);
+
     MutexLocker locker(m_inode_lock);
 
     for (auto& watcher : m_watchers) {
@@ -213,6 +219,8 @@ void Inode::did_add_child(InodeIdentifier, StringView name)
 
 void Inode::did_remove_child(InodeIdentifier, StringView name)
 {
+    DentryCache::the().invalidate(*this, name);
+
     MutexLocker locker(m_inode_lock);
 
     if (name == "." || name == "..") {
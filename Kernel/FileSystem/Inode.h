@@ -87,7 +87,7 @@ public:
     RefPtr<Memory::SharedInodeVMObject> shared_vmobject() const;
 
     static void sync_all();
-    void sync();
+    ErrorOr<void> sync();
 
     bool has_watchers() const { return !m_watchers.is_empty(); }
 
@@ -9,6 +9,7 @@
 #include <Kernel/FileSystem/Inode.h>
 #include <Kernel/FileSystem/InodeFile.h>
 #include <Kernel/FileSystem/OpenFileDescription.h>
+#include <Kernel/FileSystem/PageCache.h>
 #include <Kernel/FileSystem/VirtualFileSystem.h>
 #include <Kernel/Memory/PrivateInodeVMObject.h>
 #include <Kernel/Memory/SharedInodeVMObject.h>
@@ -31,7 +32,11 @@ ErrorOr<size_t> InodeFile::read(OpenFileDescription& description, u64 offset, Us
     if (Checked<off_t>::addition_would_overflow(offset, count))
         return EOVERFLOW;
 
-    auto nread = TRY(m_inode->read_bytes(offset, count, buffer, &description));
+    size_t nread;
+    if (!description.is_direct() && PageCache::is_cacheable(*m_inode))
+        nread = TRY(PageCache::the().read(*m_inode, offset, buffer, count));
+    else
+        nread = TRY(m_inode->read_bytes(offset, count, buffer, &description));
     if (nread > 0) {
         Thread::current()->did_file_read(nread);
         evaluate_block_conditions();
@@ -108,8 +113,7 @@ ErrorOr<void> InodeFile::truncate(u64 size)
 
 ErrorOr<void> InodeFile::sync()
 {
-    m_inode->sync();
-    return {};
+    return m_inode->sync();
 }
 
 ErrorOr<void> InodeFile::chown(OpenFileDescription& description, UserID uid, GroupID gid)
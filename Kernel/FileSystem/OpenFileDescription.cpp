@@ -12,9 +12,11 @@
 #include <Kernel/FileSystem/Custody.h>
 #include <Kernel/FileSystem/FIFO.h>
 #include <Kernel/FileSystem/FileSystem.h>
+#include <Kernel/FileSystem/IORing.h>
 #include <Kernel/FileSystem/InodeFile.h>
 #include <Kernel/FileSystem/InodeWatcher.h>
 #include <Kernel/FileSystem/OpenFileDescription.h>
+#include <Kernel/FileSystem/ReadinessSet.h>
 #include <Kernel/Memory/MemoryManager.h>
 #include <Kernel/Net/Socket.h>
 #include <Kernel/Process.h>
@@ -173,6 +175,20 @@ ErrorOr<size_t> OpenFileDescription::read(UserOrKernelBuffer& buffer, size_t cou
     return nread;
 }
 
+ErrorOr<size_t> OpenFileDescription::read_and_consume(UserOrKernelBuffer& buffer, size_t count, Function<ErrorOr<size_t>(size_t nread)> const& consumer)
+{
+    MutexLocker locker(m_lock);
+    if (Checked<off_t>::addition_would_overflow(m_current_offset, count))
+        return EOVERFLOW;
+    auto nread = TRY(m_file->read(*this, offset(), buffer, count));
+    auto nconsumed = TRY(consumer(nread));
+    VERIFY(nconsumed <= nread);
+    if (m_file->is_seekable())
+        m_current_offset += nconsumed;
+    evaluate_block_conditions();
+    return nconsumed;
+}
+
 ErrorOr<size_t> OpenFileDescription::write(const UserOrKernelBuffer& data, size_t size)
 {
     MutexLocker locker(m_lock);
@@ -185,6 +201,11 @@ ErrorOr<size_t> OpenFileDescription::write(const UserOrKernelBuffer& data, size_
     return nwritten;
 }
 
+bool OpenFileDescription::is_blocking() const
+{
+    return m_is_blocking && !Thread::current()->is_file_io_nonblocking();
+}
+
 bool OpenFileDescription::can_write() const
 {
     return m_file->can_write(*this, offset());
@@ -322,6 +343,37 @@ InodeWatcher* OpenFileDescription::inode_watcher()
     return static_cast<InodeWatcher*>(m_file.ptr());
 }
 
+bool OpenFileDescription::is_readiness_set() const
+{
+    return m_file->is_readiness_set();
+}
+
+const ReadinessSet* OpenFileDescription::readiness_set() const
+{
+    if (!is_readiness_set())
+        return nullptr;
+    return static_cast<const ReadinessSet*>(m_file.ptr());
+}
+
+ReadinessSet* OpenFileDescription::readiness_set()
+{
+    if (!is_readiness_set())
+        return nullptr;
+    return static_cast<ReadinessSet*>(m_file.ptr());
+}
+
+bool OpenFileDescription::is_io_ring() const
+{
+    return m_file->is_io_ring();
+}
+
+IORing* OpenFileDescription::io_ring()
+{
+    if (!is_io_ring())
+        return nullptr;
+    return static_cast<IORing*>(m_file.ptr());
+}
+
 bool OpenFileDescription::is_master_pty() const
 {
     return m_file->is_master_pty();
@@ -8,7 +8,9 @@
 
 #include <AK/Badge.h>
 #include <AK/ByteBuffer.h>
+#include <AK/Function.h>
 #include <AK/RefCounted.h>
+#include <AK/Weakable.h>
 #include <Kernel/FileSystem/FIFO.h>
 #include <Kernel/FileSystem/Inode.h>
 #include <Kernel/FileSystem/InodeMetadata.h>
@@ -23,7 +25,9 @@ public:
     virtual ~OpenFileDescriptionData() = default;
 };
 
-class OpenFileDescription : public RefCounted<OpenFileDescription> {
+class OpenFileDescription
+    : public RefCounted<OpenFileDescription>
+    , public Weakable<OpenFileDescription> {
 public:
     static ErrorOr<NonnullRefPtr<OpenFileDescription>> try_create(Custody&);
     static ErrorOr<NonnullRefPtr<OpenFileDescription>> try_create(File&);
@@ -48,6 +52,9 @@ public:
     ErrorOr<off_t> seek(off_t, int whence);
     ErrorOr<size_t> read(UserOrKernelBuffer&, size_t);
     ErrorOr<size_t> write(const UserOrKernelBuffer& data, size_t);
+    // Like read(), but hands what was read to `consumer` before letting go of the offset, and only advances
+    // the offset by as much as it says it consumed. Other reads, writes and seeks can't get in between.
+    ErrorOr<size_t> read_and_consume(UserOrKernelBuffer&, size_t, Function<ErrorOr<size_t>(size_t nread)> const& consumer);
     ErrorOr<struct stat> stat();
 
     // NOTE: These ignore the current offset of this file description.
@@ -85,6 +92,13 @@ public:
     const InodeWatcher* inode_watcher() const;
     InodeWatcher* inode_watcher();
 
+    bool is_readiness_set() const;
+    const ReadinessSet* readiness_set() const;
+    ReadinessSet* readiness_set();
+
+    bool is_io_ring() const;
+    IORing* io_ring();
+
     bool is_master_pty() const;
     const MasterPTY* master_pty() const;
     MasterPTY* master_pty();
@@ -98,7 +112,7 @@ public:
 
     ErrorOr<Memory::Region*> mmap(Process&, Memory::VirtualRange const&, u64 offset, int prot, bool shared);
 
-    bool is_blocking() const { return m_is_blocking; }
+    bool is_blocking() const;
     void set_blocking(bool b) { m_is_blocking = b; }
     bool should_append() const { return m_should_append; }
     void set_should_append(bool s) { m_should_append = s; }
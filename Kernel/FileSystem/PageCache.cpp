@@ -0,0 +1,272 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Singleton.h>
+#include <Kernel/FileSystem/FileSystem.h>
+#include <Kernel/FileSystem/Inode.h>
+#include <Kernel/FileSystem/PageCache.h>
+#include <Kernel/KBuffer.h>
+#include <Kernel/Memory/MemoryManager.h>
+
+namespace Kernel {
+
+static Singleton<PageCache> s_the;
+
+static constexpr size_t initial_readahead_page_count = 4;
+static constexpr size_t max_readahead_page_count = 32;
+
+// Start evicting once less than 1/8 of all user physical pages are left uncommitted.
+static constexpr size_t memory_pressure_divisor = 8;
+static constexpr size_t max_pages_evicted_at_once = 64;
+
+PageCache& PageCache::the()
+{
+    return *s_the;
+}
+
+UNMAP_AFTER_INIT PageCache::PageCache()
+{
+}
+
+bool PageCache::is_cacheable(Inode const& inode)
+{
+    // Only file systems that invalidate what we cache can use this. Everything else either already lives
+    // in memory, generates its contents on demand (like ProcFS), or can change behind our back (like Plan9FS).
+    return inode.fs().supports_page_cache() && inode.metadata().is_regular_file();
+}
+
+ErrorOr<PageCache::InodePages*> PageCache::ensure_inode_pages(Inode const& inode)
+{
+    VERIFY(m_lock.is_locked());
+    if (auto it = m_inodes.find(&inode); it != m_inodes.end())
+        return it->value.ptr();
+    auto inode_pages = TRY(adopt_nonnull_own_or_enomem(new (nothrow) InodePages));
+    auto* inode_pages_ptr = inode_pages.ptr();
+    TRY(m_inodes.try_set(&inode, move(inode_pages)));
+    return inode_pages_ptr;
+}
+
+void PageCache::touch(CachedPage& cached_page)
+{
+    m_lru_list.remove(cached_page);
+    m_lru_list.append(cached_page);
+}
+
+void PageCache::remove(CachedPage& cached_page)
+{
+    m_lru_list.remove(cached_page);
+    --m_statistics.cached_pages;
+    // NOTE: This destroys the CachedPage.
+    cached_page.owner.pages.remove(cached_page.page_index);
+}
+
+size_t PageCache::evict_least_recently_used_pages(size_t max_page_count)
+{
+    VERIFY(m_lock.is_locked());
+    size_t evicted_page_count = 0;
+    for (auto it = m_lru_list.begin(); it != m_lru_list.end() && evicted_page_count < max_page_count;) {
+        auto& cached_page = *it;
+        ++it;
+        // Pages that are also mapped by a SharedInodeVMObject wouldn't be freed by evicting them.
+        if (cached_page.page->ref_count() > 1)
+            continue;
+        remove(cached_page);
+        ++m_statistics.evictions;
+        ++evicted_page_count;
+    }
+    return evicted_page_count;
+}
+
+size_t PageCache::evict_pages_if_under_memory_pressure_locked()
+{
+    VERIFY(m_lock.is_locked());
+    auto memory_info = MM.get_system_memory_info();
+    auto low_watermark = memory_info.user_physical_pages / memory_pressure_divisor;
+    if (memory_info.user_physical_pages_uncommitted >= low_watermark)
+        return 0;
+    return evict_least_recently_used_pages(min(low_watermark - memory_info.user_physical_pages_uncommitted, max_pages_evicted_at_once));
+}
+
+size_t PageCache::evict_pages_if_under_memory_pressure()
+{
+    MutexLocker locker(m_lock);
+    return evict_pages_if_under_memory_pressure_locked();
+}
+
+size_t PageCache::purge()
+{
+    MutexLocker locker(m_lock);
+    return evict_least_recently_used_pages(NumericLimits<size_t>::max());
+}
+
+ErrorOr<NonnullRefPtr<Memory::PhysicalPage>> PageCache::get_page(Inode& inode, size_t page_index)
+{
+    // NOTE: Looking at the inode's size takes its lock, which must never be taken while holding m_lock,
+    //       as file systems invalidate pages while holding their inode lock.
+    auto page_count_in_inode = ceil_div(static_cast<size_t>(inode.size()), static_cast<size_t>(PAGE_SIZE));
+
+    size_t page_count_to_read = 1;
+    u64 generation = 0;
+    {
+        MutexLocker locker(m_lock);
+        auto& inode_pages = *TRY(ensure_inode_pages(inode));
+        bool is_sequential = page_index == inode_pages.next_sequential_page_index;
+        inode_pages.next_sequential_page_index = page_index + 1;
+
+        if (auto it = inode_pages.pages.find(page_index); it != inode_pages.pages.end()) {
+            ++m_statistics.hits;
+            touch(*it->value);
+            return it->value->page;
+        }
+        ++m_statistics.misses;
+
+        if (is_sequential)
+            inode_pages.readahead_page_count = clamp(inode_pages.readahead_page_count * 2, initial_readahead_page_count, max_readahead_page_count);
+        else
+            inode_pages.readahead_page_count = 0;
+
+        while (page_count_to_read <= inode_pages.readahead_page_count
+            && page_index + page_count_to_read < page_count_in_inode
+            && !inode_pages.pages.contains(page_index + page_count_to_read))
+            ++page_count_to_read;
+
+        generation = inode_pages.generation;
+    }
+
+    // Read the whole run at once, so the file system can issue as few requests as possible.
+    OwnPtr<KBuffer> run_buffer;
+    u8 single_page_buffer[PAGE_SIZE];
+    u8* data = single_page_buffer;
+    if (page_count_to_read > 1) {
+        run_buffer = TRY(KBuffer::try_create_with_size(page_count_to_read * PAGE_SIZE, Memory::Region::Access::ReadWrite, "PageCache readahead"sv));
+        data = run_buffer->data();
+    }
+    auto buffer = UserOrKernelBuffer::for_kernel_buffer(data);
+    auto nread = TRY(inode.read_bytes(page_index * PAGE_SIZE, page_count_to_read * PAGE_SIZE, buffer, nullptr));
+
+    // If the file shrank while we weren't looking, there's still something to map (just zeroes).
+    auto page_count_read = max<size_t>(ceil_div(nread, static_cast<size_t>(PAGE_SIZE)), 1);
+    memset(data + nread, 0, page_count_read * PAGE_SIZE - nread);
+
+    Vector<NonnullRefPtr<Memory::PhysicalPage>, max_readahead_page_count + 1> physical_pages;
+    {
+        MutexLocker locker(m_lock);
+        evict_pages_if_under_memory_pressure_locked();
+    }
+    for (size_t i = 0; i < page_count_read; ++i) {
+        auto physical_page = MM.allocate_user_physical_page(Memory::MemoryManager::ShouldZeroFill::No);
+        if (!physical_page) {
+            if (i == 0)
+                return ENOMEM;
+            break;
+        }
+        MM.copy_to_physical_page(*physical_page, data + i * PAGE_SIZE);
+        physical_pages.unchecked_append(physical_page.release_nonnull());
+    }
+
+    MutexLocker locker(m_lock);
+    auto& inode_pages = *TRY(ensure_inode_pages(inode));
+    if (inode_pages.generation != generation || nread == 0) {
+        // The contents changed while we were reading, so don't keep what we read around.
+        return physical_pages.take_first();
+    }
+
+    RefPtr<Memory::PhysicalPage> requested_page;
+    for (size_t i = 0; i < physical_pages.size(); ++i) {
+        auto it = inode_pages.pages.find(page_index + i);
+        if (it != inode_pages.pages.end()) {
+            // Someone else filled this page while we were reading, use theirs.
+            if (i == 0)
+                requested_page = it->value->page;
+            continue;
+        }
+        auto cached_page = adopt_own_if_nonnull(new (nothrow) CachedPage(inode_pages, page_index + i, physical_pages[i]));
+        if (!cached_page || inode_pages.pages.try_set(page_index + i, cached_page.release_nonnull()).is_error())
+            break;
+        auto& inserted_page = *inode_pages.pages.get(page_index + i).value();
+        m_lru_list.append(inserted_page);
+        ++m_statistics.cached_pages;
+        if (i == 0)
+            requested_page = inserted_page.page;
+        else
+            ++m_statistics.readahead_pages;
+    }
+    inode_pages.next_sequential_page_index = page_index + 1;
+
+    if (!requested_page)
+        return physical_pages.take_first();
+    return requested_page.release_nonnull();
+}
+
+ErrorOr<size_t> PageCache::read(Inode& inode, u64 offset, UserOrKernelBuffer& buffer, size_t count)
+{
+    auto size = inode.size();
+    if (offset >= size)
+        return 0;
+    count = min(count, static_cast<size_t>(size - offset));
+
+    size_t nread = 0;
+    while (nread < count) {
+        auto page_index = (offset + nread) / PAGE_SIZE;
+        auto offset_in_page = (offset + nread) % PAGE_SIZE;
+        auto chunk_size = min(PAGE_SIZE - offset_in_page, count - nread);
+
+        auto page_or_error = get_page(inode, page_index);
+        if (page_or_error.is_error()) {
+            if (nread == 0)
+                return page_or_error.release_error();
+            break;
+        }
+
+        // NOTE: We can't copy straight from a quickmapped page, since writing to a userspace buffer may fault.
+        u8 page_buffer[PAGE_SIZE];
+        MM.copy_physical_page(page_or_error.value(), page_buffer);
+        TRY(buffer.write(page_buffer + offset_in_page, nread, chunk_size));
+        nread += chunk_size;
+    }
+    return nread;
+}
+
+void PageCache::invalidate(Inode const& inode, u64 offset, u64 size)
+{
+    MutexLocker locker(m_lock);
+    auto it = m_inodes.find(&inode);
+    if (it == m_inodes.end())
+        return;
+    auto& inode_pages = *it->value;
+    ++inode_pages.generation;
+
+    auto first_page_index = offset / PAGE_SIZE;
+    auto end_offset = Checked<u64>::addition_would_overflow(offset, size) ? NumericLimits<u64>::max() : offset + size;
+    inode_pages.pages.remove_all_matching([&](size_t page_index, NonnullOwnPtr<CachedPage>& cached_page) {
+        if (page_index < first_page_index || static_cast<u64>(page_index) * PAGE_SIZE >= end_offset)
+            return false;
+        m_lru_list.remove(*cached_page);
+        --m_statistics.cached_pages;
+        return true;
+    });
+}
+
+void PageCache::forget(Inode const& inode)
+{
+    MutexLocker locker(m_lock);
+    auto it = m_inodes.find(&inode);
+    if (it == m_inodes.end())
+        return;
+    for (auto& entry : it->value->pages) {
+        m_lru_list.remove(*entry.value);
+        --m_statistics.cached_pages;
+    }
+    m_inodes.remove(it);
+}
+
+PageCache::Statistics PageCache::statistics() const
+{
+    MutexLocker locker(m_lock);
+    return m_statistics;
+}
+
+}
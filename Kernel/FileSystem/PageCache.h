@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/HashMap.h>
+#include <AK/IntrusiveList.h>
+#include <AK/NonnullOwnPtr.h>
+#include <Kernel/Forward.h>
+#include <Kernel/Locking/Mutex.h>
+#include <Kernel/Memory/PhysicalPage.h>
+#include <Kernel/UserOrKernelBuffer.h>
+
+namespace Kernel {
+
+// The PageCache keeps page-sized chunks of regular files in memory, keyed by (inode, page index).
+//
+// Both read() on an InodeFile and page faults in InodeVMObjects are served from it,
+// and SharedInodeVMObjects map the cached pages directly, so a file that is read and
+// mmap'ed at the same time only occupies memory once.
+//
+// Misses are filled with a single read that also covers a readahead window. The window
+// grows while an inode is being read sequentially and collapses on random access.
+// Pages are evicted in LRU order once the system runs low on uncommitted physical pages, which is
+// checked on every miss and periodically by the SyncTask. purge(PURGE_ALL_CLEAN_INODE) evicts them all.
+class PageCache {
+public:
+    struct Statistics {
+        u64 hits { 0 };
+        u64 misses { 0 };
+        u64 readahead_pages { 0 };
+        u64 evictions { 0 };
+        size_t cached_pages { 0 };
+    };
+
+    static PageCache& the();
+    PageCache();
+
+    static bool is_cacheable(Inode const&);
+
+    ErrorOr<size_t> read(Inode&, u64 offset, UserOrKernelBuffer&, size_t count);
+    ErrorOr<NonnullRefPtr<Memory::PhysicalPage>> get_page(Inode&, size_t page_index);
+
+    // Drops all cached pages overlapping [offset, offset + size).
+    void invalidate(Inode const&, u64 offset, u64 size);
+    void forget(Inode const&);
+
+    // Called periodically by the SyncTask, so memory is given back even when nobody is reading files.
+    size_t evict_pages_if_under_memory_pressure();
+    // Evicts every cached page that isn't also mapped somewhere, returns how many that were.
+    size_t purge();
+
+    Statistics statistics() const;
+
+private:
+    struct InodePages;
+
+    struct CachedPage {
+        CachedPage(InodePages& owner, size_t page_index, NonnullRefPtr<Memory::PhysicalPage> page)
+            : owner(owner)
+            , page_index(page_index)
+            , page(move(page))
+        {
+        }
+
+        InodePages& owner;
+        size_t page_index { 0 };
+        NonnullRefPtr<Memory::PhysicalPage> page;
+        IntrusiveListNode<CachedPage> lru_list_node;
+    };
+
+    struct InodePages {
+        HashMap<size_t, NonnullOwnPtr<CachedPage>> pages;
+        // Bumped on every invalidation, so fills that raced with a write don't insert stale data.
+        u64 generation { 0 };
+        size_t next_sequential_page_index { 0 };
+        size_t readahead_page_count { 0 };
+    };
+
+    ErrorOr<InodePages*> ensure_inode_pages(Inode const&);
+    void touch(CachedPage&);
+    void remove(CachedPage&);
+    size_t evict_least_recently_used_pages(size_t max_page_count);
+    size_t evict_pages_if_under_memory_pressure_locked();
+
+    mutable Mutex m_lock { "PageCache" };
+    HashMap<Inode const*, NonnullOwnPtr<InodePages>> m_inodes;
+    // Least recently used pages are at the front.
+    IntrusiveList<&CachedPage::lru_list_node> m_lru_list;
+    Statistics m_statistics;
+};
+
+}
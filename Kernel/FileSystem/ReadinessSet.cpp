@@ -0,0 +1,208 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <Kernel/FileSystem/OpenFileDescription.h>
+#include <Kernel/FileSystem/ReadinessSet.h>
+#include <Kernel/KString.h>
+
+namespace Kernel {
+
+static constexpr u32 valid_readiness_events = READINESS_READ | READINESS_WRITE | READINESS_EDGE_TRIGGERED;
+
+ErrorOr<NonnullRefPtr<ReadinessSet>> ReadinessSet::try_create()
+{
+    return adopt_nonnull_ref_or_enomem(new (nothrow) ReadinessSet);
+}
+
+// NOTE: We don't override File::close(), as that gets called whenever *any* fd referring to
+//       this set is closed, including copies inherited across fork(). The registered entries
+//       go away together with the last description instead.
+ReadinessSet::~ReadinessSet()
+{
+    MutexLocker locker(m_lock);
+    m_entries.clear();
+}
+
+ReadinessSet::Entry::Entry(ReadinessSet& set, int fd, OpenFileDescription& description, u32 events, u64 user_data)
+    : m_set(set)
+    , m_fd(fd)
+    , m_description(description)
+    , m_file(description.file())
+    , m_blocker_set(description.blocker_set())
+    , m_events(events)
+    , m_user_data(user_data)
+{
+    m_blocker_set.add_readiness_watcher(*this);
+}
+
+ReadinessSet::Entry::~Entry()
+{
+    m_blocker_set.remove_readiness_watcher(*this);
+
+    SpinlockLocker lock(m_set.m_ready_lock);
+    if (m_ready_list_node.is_in_list())
+        m_ready_list_node.remove();
+}
+
+Thread::FileBlocker::BlockFlags ReadinessSet::Entry::block_flags() const
+{
+    using BlockFlags = Thread::FileBlocker::BlockFlags;
+    auto flags = BlockFlags::None;
+    if (m_events & READINESS_READ)
+        flags |= BlockFlags::Read;
+    if (m_events & READINESS_WRITE)
+        flags |= BlockFlags::Write;
+    return flags;
+}
+
+void ReadinessSet::Entry::update(u32 events, u64 user_data)
+{
+    SpinlockLocker lock(m_set.m_ready_lock);
+    m_events = events;
+    m_user_data = user_data;
+}
+
+void ReadinessSet::Entry::file_readiness_may_have_changed()
+{
+    m_set.enqueue_ready_entry(*this);
+}
+
+void ReadinessSet::enqueue_ready_entry(Entry& entry)
+{
+    {
+        SpinlockLocker lock(m_ready_lock);
+        if (entry.m_ready_list_node.is_in_list())
+            return;
+        m_ready_entries.append(entry);
+    }
+    evaluate_block_conditions();
+}
+
+bool ReadinessSet::can_read(const OpenFileDescription&, size_t) const
+{
+    SpinlockLocker lock(m_ready_lock);
+    return !m_ready_entries.is_empty();
+}
+
+ErrorOr<NonnullOwnPtr<KString>> ReadinessSet::pseudo_path(const OpenFileDescription&) const
+{
+    MutexLocker locker(m_lock);
+    return KString::formatted("ReadinessSet:({})", m_entries.size());
+}
+
+ErrorOr<void> ReadinessSet::add(int fd, OpenFileDescription& description, u32 events, u64 user_data)
+{
+    if (events & ~valid_readiness_events)
+        return EINVAL;
+    // NOTE: Nesting readiness sets would let the notification path recurse through FileBlockerSet locks.
+    if (description.is_readiness_set())
+        return EINVAL;
+
+    MutexLocker locker(m_lock);
+    if (auto it = m_entries.find(fd); it != m_entries.end()) {
+        // The fd number may have been closed and reused without being removed from the set first.
+        // In that case the old entry is stale and can simply be replaced.
+        if (it->value->is_watching(description) && it->value->description().strong_ref())
+            return EEXIST;
+        m_entries.remove(it);
+    }
+
+    auto entry = TRY(adopt_nonnull_own_or_enomem(new (nothrow) Entry(*this, fd, description, events, user_data)));
+    auto& entry_ref = *entry;
+    TRY(m_entries.try_set(fd, move(entry)));
+
+    // Report the current state of the description on the next wait.
+    enqueue_ready_entry(entry_ref);
+    return {};
+}
+
+ErrorOr<void> ReadinessSet::modify(int fd, u32 events, u64 user_data)
+{
+    if (events & ~valid_readiness_events)
+        return EINVAL;
+
+    MutexLocker locker(m_lock);
+    auto it = m_entries.find(fd);
+    if (it == m_entries.end())
+        return ENOENT;
+    it->value->update(events, user_data);
+    enqueue_ready_entry(*it->value);
+    return {};
+}
+
+ErrorOr<void> ReadinessSet::remove(int fd)
+{
+    MutexLocker locker(m_lock);
+    if (!m_entries.remove(fd))
+        return ENOENT;
+    return {};
+}
+
+size_t ReadinessSet::collect_ready_events(Span<readiness_event> events)
+{
+    using BlockFlags = Thread::FileBlocker::BlockFlags;
+
+    MutexLocker locker(m_lock);
+
+    // Detach the current ready list so that level-triggered entries we put back
+    // below are not looked at again during this call.
+    ReadyList pending;
+    {
+        SpinlockLocker lock(m_ready_lock);
+        while (auto* entry = m_ready_entries.take_first())
+            pending.append(*entry);
+    }
+
+    size_t count = 0;
+    while (count < events.size()) {
+        Entry* entry;
+        {
+            SpinlockLocker lock(m_ready_lock);
+            // NOTE: The entry is off every list while we look at it, so a change that
+            //       races with should_unblock() below will re-queue it instead of getting lost.
+            entry = pending.take_first();
+        }
+        if (!entry)
+            break;
+
+        auto description = entry->description().strong_ref();
+        if (!description) {
+            // The watched description has been closed without being removed from the set.
+            m_entries.remove(entry->fd());
+            continue;
+        }
+
+        auto unblock_flags = description->should_unblock(entry->block_flags());
+        if (unblock_flags == BlockFlags::None)
+            continue;
+
+        auto& event = events[count++];
+        event.fd = entry->fd();
+        event.events = 0;
+        if (has_flag(unblock_flags, BlockFlags::Read))
+            event.events |= READINESS_READ;
+        if (has_flag(unblock_flags, BlockFlags::Write))
+            event.events |= READINESS_WRITE;
+        event.user_data = entry->user_data();
+
+        if (!entry->is_edge_triggered()) {
+            SpinlockLocker lock(m_ready_lock);
+            if (!entry->m_ready_list_node.is_in_list())
+                m_ready_entries.append(*entry);
+        }
+    }
+
+    {
+        // Whatever we did not get to goes back to the front of the ready list.
+        SpinlockLocker lock(m_ready_lock);
+        while (auto* entry = pending.take_last())
+            m_ready_entries.prepend(*entry);
+    }
+
+    return count;
+}
+
+}
@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/HashMap.h>
+#include <AK/IntrusiveList.h>
+#include <AK/NonnullOwnPtr.h>
+#include <AK/WeakPtr.h>
+#include <Kernel/FileSystem/File.h>
+#include <Kernel/Forward.h>
+#include <Kernel/Locking/Mutex.h>
+#include <Kernel/UnixTypes.h>
+
+namespace Kernel {
+
+// A ReadinessSet is a persistent set of watched file descriptions.
+//
+// Descriptions are registered once, after which the set only hears about the
+// ones whose readiness may have changed (via FileReadinessWatcher), so waiting
+// on it costs O(number of ready descriptions) instead of O(number of watched
+// descriptions) like select() and poll() do.
+//
+// Entries are level-triggered by default: a description that is still ready
+// after being reported stays on the ready list until it is reported as not
+// ready. With READINESS_EDGE_TRIGGERED, a description is only reported again
+// once its File signals another change.
+class ReadinessSet final : public File {
+public:
+    static ErrorOr<NonnullRefPtr<ReadinessSet>> try_create();
+    virtual ~ReadinessSet() override;
+
+    virtual bool can_read(const OpenFileDescription&, size_t) const override;
+    virtual ErrorOr<size_t> read(OpenFileDescription&, u64, UserOrKernelBuffer&, size_t) override { return EINVAL; }
+    virtual bool can_write(const OpenFileDescription&, size_t) const override { return false; }
+    virtual ErrorOr<size_t> write(OpenFileDescription&, u64, const UserOrKernelBuffer&, size_t) override { return EINVAL; }
+
+    virtual ErrorOr<NonnullOwnPtr<KString>> pseudo_path(const OpenFileDescription&) const override;
+    virtual StringView class_name() const override { return "ReadinessSet"sv; }
+    virtual bool is_readiness_set() const override { return true; }
+
+    ErrorOr<void> add(int fd, OpenFileDescription&, u32 events, u64 user_data);
+    ErrorOr<void> modify(int fd, u32 events, u64 user_data);
+    ErrorOr<void> remove(int fd);
+
+    // Fills `events` with up to events.size() ready descriptions and returns how many were filled.
+    size_t collect_ready_events(Span<readiness_event> events);
+
+private:
+    class Entry final : public FileReadinessWatcher {
+    public:
+        Entry(ReadinessSet&, int fd, OpenFileDescription&, u32 events, u64 user_data);
+        virtual ~Entry() override;
+
+        virtual void file_readiness_may_have_changed() override;
+
+        int fd() const { return m_fd; }
+        WeakPtr<OpenFileDescription> const& description() const { return m_description; }
+        bool is_watching(OpenFileDescription const& description) const { return m_description.unsafe_ptr() == &description; }
+
+        Thread::FileBlocker::BlockFlags block_flags() const;
+        bool is_edge_triggered() const { return m_events & READINESS_EDGE_TRIGGERED; }
+        u64 user_data() const { return m_user_data; }
+
+        void update(u32 events, u64 user_data);
+
+        IntrusiveListNode<Entry> m_ready_list_node;
+
+    private:
+        ReadinessSet& m_set;
+        int m_fd { -1 };
+        WeakPtr<OpenFileDescription> m_description;
+
+        // NOTE: We keep the File alive so the FileBlockerSet we registered with stays valid,
+        //       even after the last reference to the watched description has gone away.
+        NonnullRefPtr<File> m_file;
+        FileBlockerSet& m_blocker_set;
+
+        u32 m_events { 0 };
+        u64 m_user_data { 0 };
+    };
+
+    using ReadyList = IntrusiveList<&Entry::m_ready_list_node>;
+
+    ReadinessSet() = default;
+
+    void enqueue_ready_entry(Entry&);
+
+    mutable Mutex m_lock;
+    HashMap<int, NonnullOwnPtr<Entry>> m_entries;
+
+    mutable Spinlock m_ready_lock;
+    ReadyList m_ready_entries;
+};
+
+}
@@ -12,6 +12,7 @@
 #include <Kernel/Devices/BlockDevice.h>
 #include <Kernel/Devices/DeviceManagement.h>
 #include <Kernel/FileSystem/Custody.h>
+#include <Kernel/FileSystem/DentryCache.h>
 #include <Kernel/FileSystem/FileBackedFileSystem.h>
 #include <Kernel/FileSystem/FileSystem.h>
 #include <Kernel/FileSystem/OpenFileDescription.h>
@@ -61,6 +62,7 @@ ErrorOr<void> VirtualFileSystem::mount(FileSystem& fs, Custody& mount_point, int
         // FIXME: check that this is not already a mount point
         Mount mount { fs, &mount_point, flags };
         mounts.append(move(mount));
+        DentryCache::the().invalidate_all();
         return {};
     });
 }
@@ -72,6 +74,7 @@ ErrorOr<void> VirtualFileSystem::bind_mount(Custody& source, Custody& mount_poin
         // FIXME: check that this is not already a mount point
         Mount mount { source.inode(), mount_point, flags };
         mounts.append(move(mount));
+        DentryCache::the().invalidate_all();
         return {};
     });
 }
@@ -85,6 +88,8 @@ ErrorOr<void> VirtualFileSystem::remount(Custody& mount_point, int new_flags)
         return ENODEV;
 
     mount->set_flags(new_flags);
+    // Cached custodies carry the flags of the mount they were found in.
+    DentryCache::the().invalidate_all();
     return {};
 }
 
@@ -97,6 +102,8 @@ ErrorOr<void> VirtualFileSystem::unmount(Inode& guest_inode)
             auto& mount = mounts[i];
             if (&mount.guest() != &guest_inode)
                 continue;
+            // Cached custodies keep inodes of the file system alive, which would make it look busy.
+            DentryCache::the().invalidate_all();
             TRY(mount.guest_fs().prepare_to_unmount());
             dbgln("VirtualFileSystem: Unmounting file system {}...", mount.guest_fs().fsid());
             mounts.unstable_take(i);
@@ -847,6 +854,41 @@ static bool safe_to_follow_symlink(const Inode& inode, const InodeMetadata& pare
     return false;
 }
 
+ErrorOr<NonnullRefPtr<Custody>> VirtualFileSystem::lookup_child_custody(Custody& parent, StringView name)
+{
+    bool is_cacheable = DentryCache::is_cacheable(parent.inode());
+    u32 generation = 0;
+    if (is_cacheable) {
+        if (auto cached_child = DentryCache::the().lookup(parent, name, generation); cached_child.has_value()) {
+            if (!cached_child.value())
+                return ENOENT;
+            return cached_child.release_value().release_nonnull();
+        }
+    }
+
+    auto child_or_error = parent.inode().lookup(name);
+    if (child_or_error.is_error()) {
+        if (is_cacheable && child_or_error.error().code() == ENOENT)
+            DentryCache::the().insert(parent, name, nullptr, generation);
+        return child_or_error.release_error();
+    }
+    auto child_inode = child_or_error.release_value();
+
+    int mount_flags_for_child = parent.mount_flags();
+
+    // See if there's something mounted on the child; in that case
+    // we would need to return the guest inode, not the host inode.
+    if (auto mount = find_mount_for_host(child_inode->identifier())) {
+        child_inode = mount->guest();
+        mount_flags_for_child = mount->flags();
+    }
+
+    auto custody = TRY(Custody::try_create(&parent, name, *child_inode, mount_flags_for_child));
+    if (is_cacheable)
+        DentryCache::the().insert(parent, name, custody, generation);
+    return custody;
+}
+
 ErrorOr<NonnullRefPtr<Custody>> VirtualFileSystem::resolve_path_without_veil(StringView path, Custody& base, RefPtr<Custody>* out_parent, int options, int symlink_recursion_level)
 {
     if (symlink_recursion_level >= symlink_recursion_limit)
@@ -887,28 +929,18 @@ ErrorOr<NonnullRefPtr<Custody>> VirtualFileSystem::resolve_path_without_veil(Str
         }
 
         // Okay, let's look up this part.
-        auto child_or_error = parent.inode().lookup(part);
-        if (child_or_error.is_error()) {
+        auto child_custody_or_error = lookup_child_custody(parent, part);
+        if (child_custody_or_error.is_error()) {
             if (out_parent) {
                 // ENOENT with a non-null parent custody signals to caller that
                 // we found the immediate parent of the file, but the file itself
                 // does not exist yet.
                 *out_parent = have_more_parts ? nullptr : &parent;
             }
-            return child_or_error.release_error();
+            return child_custody_or_error.release_error();
         }
-        auto child_inode = child_or_error.release_value();
-
-        int mount_flags_for_child = parent.mount_flags();
-
-        // See if there's something mounted on the child; in that case
-        // we would need to return the guest inode, not the host inode.
-        if (auto mount = find_mount_for_host(child_inode->identifier())) {
-            child_inode = mount->guest();
-            mount_flags_for_child = mount->flags();
-        }
-
-        custody = TRY(Custody::try_create(&parent, part, *child_inode, mount_flags_for_child));
+        custody = child_custody_or_error.release_value();
+        NonnullRefPtr<Inode> child_inode = custody->inode();
 
         if (child_inode->metadata().is_symlink()) {
             if (!have_more_parts) {
@@ -92,6 +92,9 @@ private:
     Mount* find_mount_for_host(InodeIdentifier);
     Mount* find_mount_for_guest(InodeIdentifier);
 
+    // Looks up a single path component, going through the DentryCache where possible.
+    ErrorOr<NonnullRefPtr<Custody>> lookup_child_custody(Custody& parent, StringView name);
+
     RefPtr<Inode> m_root_inode;
     RefPtr<Custody> m_root_custody;
 
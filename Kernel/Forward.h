@@ -27,6 +27,7 @@ class File;
 class OpenFileDescription;
 class FileSystem;
 class FutexQueue;
+class IORing;
 class IPv4Socket;
 class Inode;
 class InodeIdentifier;
@@ -48,6 +49,7 @@ class ProcFSSystemBoolean;
 class ProcFSSystemDirectory;
 class Process;
 class ProcessGroup;
+class ReadinessSet;
 class RecursiveSpinlock;
 class Scheduler;
 class Socket;
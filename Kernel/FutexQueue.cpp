@@ -10,7 +10,9 @@
 
 namespace Kernel {
 
-FutexQueue::FutexQueue()
+FutexQueue::FutexQueue(FutexKey const& key, RefPtr<Memory::VMObject> vmobject)
+    : m_key(key)
+    , m_vmobject(move(vmobject))
 {
 }
 
@@ -26,8 +28,9 @@ bool FutexQueue::should_add_blocker(Thread::Blocker& b, void*)
     VERIFY(m_imminent_waits > 0);
     m_imminent_waits--;
 
-    if (m_was_removed) {
-        dbgln_if(FUTEXQUEUE_DEBUG, "FutexQueue @ {}: should not block thread {}: was removed", this, b.thread());
+    if (m_pending_wakeups > 0) {
+        m_pending_wakeups--;
+        dbgln_if(FUTEXQUEUE_DEBUG, "FutexQueue @ {}: should not block thread {}: already woken", this, b.thread());
         return false;
     }
     dbgln_if(FUTEXQUEUE_DEBUG, "FutexQueue @ {}: should block thread {}", this, b.thread());
@@ -35,28 +38,36 @@ bool FutexQueue::should_add_blocker(Thread::Blocker& b, void*)
     return true;
 }
 
-u32 FutexQueue::wake_n_requeue(u32 wake_count, const Function<FutexQueue*()>& get_target_queue, u32 requeue_count, bool& is_empty, bool& is_empty_target)
+u32 FutexQueue::wake_n_requeue(u32 wake_count, const Function<FutexQueue*()>& get_target_queue, u32 requeue_count, u32& did_requeue)
 {
-    is_empty_target = false;
+    did_requeue = 0;
     SpinlockLocker lock(m_lock);
 
     dbgln_if(FUTEXQUEUE_DEBUG, "FutexQueue @ {}: wake_n_requeue({}, {})", this, wake_count, requeue_count);
 
-    u32 did_wake = 0, did_requeue = 0;
-    unblock_all_blockers_whose_conditions_are_met_locked([&](Thread::Blocker& b, void*, bool& stop_iterating) {
-        VERIFY(b.blocker_type() == Thread::Blocker::Type::Futex);
-        auto& blocker = static_cast<Thread::FutexBlocker&>(b);
-
-        dbgln_if(FUTEXQUEUE_DEBUG, "FutexQueue @ {}: wake_n_requeue unblocking {}", this, blocker.thread());
-        VERIFY(did_wake < wake_count);
-        if (blocker.unblock()) {
-            if (++did_wake >= wake_count)
-                stop_iterating = true;
-            return true;
-        }
-        return false;
-    });
-    is_empty = is_empty_and_no_imminent_waits_locked();
+    u32 did_wake = 0;
+    if (wake_count > 0) {
+        unblock_all_blockers_whose_conditions_are_met_locked([&](Thread::Blocker& b, void*, bool& stop_iterating) {
+            VERIFY(b.blocker_type() == Thread::Blocker::Type::Futex);
+            auto& blocker = static_cast<Thread::FutexBlocker&>(b);
+
+            dbgln_if(FUTEXQUEUE_DEBUG, "FutexQueue @ {}: wake_n_requeue unblocking {}", this, blocker.thread());
+            VERIFY(did_wake < wake_count);
+            if (blocker.unblock()) {
+                if (++did_wake >= wake_count)
+                    stop_iterating = true;
+                return true;
+            }
+            return false;
+        });
+    }
+    // Threads that haven't blocked yet can't be moved to the target queue, so wake them
+    // instead. They would otherwise sleep on a futex nobody is going to wake anymore.
+    u32 wakes_left = wake_count - did_wake;
+    u32 granted = grant_pending_wakeups_locked(static_cast<u64>(wakes_left) + requeue_count);
+    if (granted > wakes_left)
+        requeue_count -= granted - wakes_left;
+    did_wake += granted;
     if (requeue_count > 0) {
         auto blockers_to_requeue = do_take_blockers(requeue_count);
         if (!blockers_to_requeue.is_empty()) {
@@ -82,7 +93,6 @@ u32 FutexQueue::wake_n_requeue(u32 wake_count, const Function<FutexQueue*()>& ge
                     blocker.finish_requeue(*target_futex_queue);
                 }
                 target_futex_queue->do_append_blockers(move(blockers_to_requeue));
-                is_empty_target = target_futex_queue->is_empty_and_no_imminent_waits_locked();
             } else {
                 dbgln_if(FUTEXQUEUE_DEBUG, "FutexQueue @ {}: wake_n_requeue could not get target queue to requeue {} blockers", this, blockers_to_requeue.size());
                 do_append_blockers(move(blockers_to_requeue));
@@ -114,6 +124,9 @@ u32 FutexQueue::wake_n(u32 wake_count, const Optional<u32>& bitset, bool& is_emp
         }
         return false;
     });
+    // Spurious wakeups are allowed, so we don't have to know the bitset of an imminent waiter.
+    if (did_wake < wake_count)
+        did_wake += grant_pending_wakeups_locked(wake_count - did_wake);
     is_empty = is_empty_and_no_imminent_waits_locked();
     return did_wake;
 }
@@ -133,6 +146,7 @@ u32 FutexQueue::wake_all(bool& is_empty)
         }
         return false;
     });
+    did_wake += grant_pending_wakeups_locked(m_imminent_waits);
     is_empty = is_empty_and_no_imminent_waits_locked();
     return did_wake;
 }
@@ -142,24 +156,28 @@ bool FutexQueue::is_empty_and_no_imminent_waits_locked()
     return m_imminent_waits == 0 && is_empty_locked();
 }
 
-bool FutexQueue::queue_imminent_wait()
+void FutexQueue::queue_imminent_wait()
 {
     SpinlockLocker lock(m_lock);
-    if (m_was_removed)
-        return false;
     m_imminent_waits++;
-    return true;
 }
 
-bool FutexQueue::try_remove()
+void FutexQueue::cancel_imminent_wait()
 {
     SpinlockLocker lock(m_lock);
-    if (m_was_removed)
-        return false;
-    if (!is_empty_and_no_imminent_waits_locked())
-        return false;
-    m_was_removed = true;
-    return true;
+    VERIFY(m_imminent_waits > 0);
+    m_imminent_waits--;
+    // A wake handed to us is simply consumed by returning early.
+    if (m_pending_wakeups > m_imminent_waits)
+        m_pending_wakeups = m_imminent_waits;
+}
+
+u32 FutexQueue::grant_pending_wakeups_locked(u64 count)
+{
+    VERIFY(m_lock.is_locked());
+    u32 granted = min<u64>(count, m_imminent_waits - m_pending_wakeups);
+    m_pending_wakeups += granted;
+    return granted;
 }
 
 }
@@ -7,32 +7,62 @@
 #pragma once
 
 #include <AK/Atomic.h>
+#include <AK/HashFunctions.h>
 #include <AK/RefCounted.h>
+#include <AK/Traits.h>
 #include <Kernel/Locking/Spinlock.h>
 #include <Kernel/Memory/VMObject.h>
 #include <Kernel/Thread.h>
 
 namespace Kernel {
 
+// Private futexes are identified by their process and virtual address. Shared ones are identified
+// by the VMObject backing them and the offset into it, so that every mapping of it agrees.
+struct FutexKey {
+    FlatPtr owner { 0 };
+    FlatPtr offset { 0 };
+
+    bool operator==(FutexKey const&) const = default;
+};
+
+}
+
+namespace AK {
+
+template<>
+struct Traits<Kernel::FutexKey> : public GenericTraits<Kernel::FutexKey> {
+    static unsigned hash(Kernel::FutexKey const& key) { return pair_int_hash(ptr_hash(key.owner), ptr_hash(key.offset)); }
+};
+
+}
+
+namespace Kernel {
+
+// All queues live in the FutexTable, and may only be created, looked up or
+// removed while holding the lock of the bucket they belong to.
 class FutexQueue final
     : public RefCounted<FutexQueue>
     , public Thread::BlockerSet {
 public:
-    FutexQueue();
+    FutexQueue(FutexKey const&, RefPtr<Memory::VMObject>);
     virtual ~FutexQueue();
 
-    u32 wake_n_requeue(u32, const Function<FutexQueue*()>&, u32, bool&, bool&);
+    FutexKey const& key() const { return m_key; }
+
+    u32 wake_n_requeue(u32, const Function<FutexQueue*()>&, u32, u32&);
     u32 wake_n(u32, const Optional<u32>&, bool&);
     u32 wake_all(bool&);
 
-    template<class... Args>
-    Thread::BlockResult wait_on(const Thread::BlockTimeout& timeout, Args&&... args)
+    // If the waiting thread gets requeued, futex_queue is updated to the queue it ended up on.
+    static Thread::BlockResult wait_on(RefPtr<FutexQueue>& futex_queue, const Thread::BlockTimeout& timeout, u32 bitset)
     {
-        return Thread::current()->block<Thread::FutexBlocker>(timeout, *this, forward<Args>(args)...);
+        return Thread::current()->block<Thread::FutexBlocker>(timeout, futex_queue, bitset);
     }
 
-    bool queue_imminent_wait();
-    bool try_remove();
+    // A thread registers an imminent wait before it checks the futex value, so that a
+    // wake arriving between that check and the actual block is not lost.
+    void queue_imminent_wait();
+    void cancel_imminent_wait();
 
     bool is_empty_and_no_imminent_waits()
     {
@@ -45,8 +75,14 @@ protected:
     virtual bool should_add_blocker(Thread::Blocker& b, void*) override;
 
 private:
-    size_t m_imminent_waits { 1 }; // We only create this object if we're going to be waiting, so start out with 1
-    bool m_was_removed { false };
+    u32 grant_pending_wakeups_locked(u64 count);
+
+    FutexKey m_key;
+    // Keeps the backing memory of a shared futex alive, since its address is part of the key.
+    RefPtr<Memory::VMObject> m_vmobject;
+    size_t m_imminent_waits { 0 };
+    // Wakes handed out to imminent waiters, which will return instead of blocking.
+    size_t m_pending_wakeups { 0 };
 };
 
 }
@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Singleton.h>
+#include <Kernel/FutexTable.h>
+#include <Kernel/Process.h>
+
+namespace Kernel {
+
+static Singleton<FutexTable> s_the;
+
+FutexTable& FutexTable::the()
+{
+    return *s_the;
+}
+
+RefPtr<FutexQueue> FutexTable::Bucket::find_queue(FutexKey const& key)
+{
+    VERIFY(lock.is_locked());
+    auto it = queues.find(key);
+    if (it == queues.end())
+        return {};
+    return it->value;
+}
+
+ErrorOr<NonnullRefPtr<FutexQueue>> FutexTable::Bucket::find_or_create_queue(FutexKey const& key, RefPtr<Memory::VMObject> vmobject)
+{
+    VERIFY(lock.is_locked());
+    if (auto it = queues.find(key); it != queues.end())
+        return it->value;
+    auto futex_queue = TRY(adopt_nonnull_ref_or_enomem(new (nothrow) FutexQueue(key, move(vmobject))));
+    TRY(queues.try_set(key, futex_queue));
+    return futex_queue;
+}
+
+void FutexTable::Bucket::remove_queue_if_unused(FutexKey const& key)
+{
+    VERIFY(lock.is_locked());
+    auto it = queues.find(key);
+    if (it == queues.end())
+        return;
+    if (it->value->is_empty_and_no_imminent_waits())
+        queues.remove(it);
+}
+
+void FutexTable::wake_and_remove_private_queues(Process const& process)
+{
+    auto owner = FlatPtr(&process);
+    for (auto& bucket : m_buckets) {
+        SpinlockLocker lock(bucket.lock);
+        bucket.queues.remove_all_matching([&](auto& key, auto& futex_queue) {
+            if (key.owner != owner)
+                return false;
+            bool is_empty;
+            futex_queue->wake_all(is_empty);
+            return true;
+        });
+    }
+}
+
+}
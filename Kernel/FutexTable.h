@@ -0,0 +1,45 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Array.h>
+#include <AK/HashMap.h>
+#include <AK/NonnullRefPtr.h>
+#include <Kernel/Forward.h>
+#include <Kernel/FutexQueue.h>
+#include <Kernel/Locking/Spinlock.h>
+
+namespace Kernel {
+
+class FutexTable {
+public:
+    static FutexTable& the();
+
+    struct Bucket {
+        Spinlock lock;
+        // Counts the threads that are waiting, or about to wait, on any futex in this bucket.
+        // Wakers read it without taking the lock, so a wake with nobody waiting never contends.
+        Atomic<u32> waiter_count { 0 };
+        HashMap<FutexKey, NonnullRefPtr<FutexQueue>> queues;
+
+        RefPtr<FutexQueue> find_queue(FutexKey const&);
+        ErrorOr<NonnullRefPtr<FutexQueue>> find_or_create_queue(FutexKey const&, RefPtr<Memory::VMObject>);
+        void remove_queue_if_unused(FutexKey const&);
+    };
+
+    Bucket& bucket_for(FutexKey const& key) { return m_buckets[Traits<FutexKey>::hash(key) % bucket_count]; }
+
+    // Wakes up every thread waiting on a private futex of the process, and forgets its queues.
+    void wake_and_remove_private_queues(Process const&);
+
+private:
+    static constexpr size_t bucket_count = 256;
+
+    Array<Bucket, bucket_count> m_buckets;
+};
+
+}
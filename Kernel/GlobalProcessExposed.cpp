@@ -6,6 +6,7 @@
 
 #include <AK/JsonObjectSerializer.h>
 #include <AK/UBSanitizer.h>
+#include <Kernel/API/ProcessStatistics.h>
 #include <Kernel/Arch/x86/CPU.h>
 #include <Kernel/Arch/x86/InterruptDisabler.h>
 #include <Kernel/Arch/x86/ProcessorInfo.h>
@@ -58,6 +59,8 @@ private:
             obj.add("bytes_in", adapter.bytes_in());
             obj.add("packets_out", adapter.packets_out());
             obj.add("bytes_out", adapter.bytes_out());
+            obj.add("packets_dropped", adapter.packets_dropped());
+            obj.add("receive_queues", adapter.receive_queue_count());
             obj.add("link_up", adapter.link_up());
             obj.add("link_speed", adapter.link_speed());
             obj.add("link_full_duplex", adapter.link_full_duplex());
@@ -109,6 +112,14 @@ private:
             obj.add("bytes_in", socket.bytes_in());
             obj.add("packets_out", socket.packets_out());
             obj.add("bytes_out", socket.bytes_out());
+            obj.add("maximum_segment_size", static_cast<u64>(socket.maximum_segment_size()));
+            obj.add("congestion_control", socket.congestion_control().name());
+            obj.add("congestion_window", static_cast<u64>(socket.congestion_control().congestion_window()));
+            obj.add("slow_start_threshold", static_cast<u64>(socket.congestion_control().slow_start_threshold()));
+            obj.add("smoothed_rtt_us", socket.smoothed_rtt().to_microseconds());
+            obj.add("retransmit_timeout_ms", socket.retransmit_timeout().to_milliseconds());
+            obj.add("window_scaling", socket.is_window_scaling_enabled());
+            obj.add("sack", socket.is_sack_permitted());
             if (Process::current().is_superuser() || Process::current().uid() == socket.origin_uid()) {
                 obj.add("origin_pid", socket.origin_pid().value());
                 obj.add("origin_uid", socket.origin_uid().value());
@@ -412,6 +423,10 @@ private:
         json.add("user_physical_uncommitted", system_memory.user_physical_pages_uncommitted);
         json.add("super_physical_allocated", system_memory.super_physical_pages_used);
         json.add("super_physical_available", system_memory.super_physical_pages - system_memory.super_physical_pages_used);
+        json.add("large_pages_allocated", system_memory.large_pages_allocated);
+        json.add("large_page_allocation_failures", system_memory.large_page_allocation_failures);
+        json.add("large_pages_mapped", system_memory.large_pages_mapped);
+        json.add("large_pages_split", system_memory.large_pages_split);
         json.add("kmalloc_call_count", stats.kmalloc_call_count);
         json.add("kfree_call_count", stats.kfree_call_count);
         json.finish();
@@ -553,6 +568,233 @@ private:
         return {};
     }
 };
+struct ProcessStatisticsInodeData : public ProcFSInodeData {
+    // The generation of the last snapshot read through this description, or zero before the first one.
+    u64 generation { 0 };
+};
+
+// The binary, incremental counterpart of /proc/all. See Kernel/API/ProcessStatistics.h for the format.
+class ProcFSProcessStatistics final : public ProcFSGlobalInformation {
+public:
+    static NonnullRefPtr<ProcFSProcessStatistics> must_create();
+
+private:
+    ProcFSProcessStatistics();
+
+    virtual ErrorOr<void> refresh_data(OpenFileDescription& description) const override
+    {
+        MutexLocker lock(m_refresh_lock);
+        auto& cached_data = description.data();
+        if (!cached_data) {
+            cached_data = adopt_own_if_nonnull(new (nothrow) ProcessStatisticsInodeData);
+            if (!cached_data)
+                return ENOMEM;
+        }
+        auto& typed_cached_data = static_cast<ProcessStatisticsInodeData&>(*cached_data);
+        auto builder = TRY(KBufferBuilder::try_create());
+        auto generation = TRY(generate(builder, typed_cached_data.generation));
+        typed_cached_data.buffer = builder.build();
+        if (!typed_cached_data.buffer)
+            return ENOMEM;
+        typed_cached_data.generation = generation;
+        return {};
+    }
+
+    virtual ErrorOr<void> try_generate(KBufferBuilder& builder) override
+    {
+        TRY(generate(builder, 0));
+        return {};
+    }
+
+    static StringView clamp_string(StringView string)
+    {
+        return string.substring_view(0, min<size_t>(string.length(), NumericLimits<u16>::max()));
+    }
+
+    static bool may_have_changed(Process const& process, u64 since_generation)
+    {
+        // Processes without threads are about to go away, and are cheap to include.
+        if (since_generation == 0 || process.thread_count() == 0)
+            return true;
+        if (process.statistics_generation() >= since_generation)
+            return true;
+        bool changed = false;
+        process.for_each_thread([&](Thread const& thread) {
+            if (thread.state() == Thread::State::Running || thread.statistics_generation() >= since_generation) {
+                changed = true;
+                return IterationDecision::Break;
+            }
+            return IterationDecision::Continue;
+        });
+        return changed;
+    }
+
+    static ErrorOr<void> append_threads(StringBuilder& threads, Process const& process, u32& thread_count)
+    {
+        ErrorOr<void> result;
+        process.for_each_thread([&](Thread const& thread) {
+            SpinlockLocker locker(thread.get_lock());
+            auto name = clamp_string(thread.name());
+            auto state = clamp_string(thread.state_string());
+
+            ThreadStatisticsRecord record {};
+            record.record_size = sizeof(record) + name.length() + state.length();
+            record.tid = thread.tid().value();
+            record.times_scheduled = thread.times_scheduled();
+            record.time_user = thread.time_in_user();
+            record.time_kernel = thread.time_in_kernel();
+            record.cpu = thread.cpu();
+            record.priority = thread.priority();
+            record.syscall_count = thread.syscall_count();
+            record.inode_faults = thread.inode_faults();
+            record.zero_faults = thread.zero_faults();
+            record.cow_faults = thread.cow_faults();
+            record.file_read_bytes = thread.file_read_bytes();
+            record.file_write_bytes = thread.file_write_bytes();
+            record.unix_socket_read_bytes = thread.unix_socket_read_bytes();
+            record.unix_socket_write_bytes = thread.unix_socket_write_bytes();
+            record.ipv4_socket_read_bytes = thread.ipv4_socket_read_bytes();
+            record.ipv4_socket_write_bytes = thread.ipv4_socket_write_bytes();
+            record.name_length = name.length();
+            record.state_length = state.length();
+
+            result = threads.try_append(reinterpret_cast<char const*>(&record), sizeof(record));
+            if (!result.is_error())
+                result = threads.try_append(name);
+            if (!result.is_error())
+                result = threads.try_append(state);
+            if (result.is_error())
+                return IterationDecision::Break;
+            ++thread_count;
+            return IterationDecision::Continue;
+        });
+        return result;
+    }
+
+    // Keep this in sync with ProcFSOverallProcesses and Core::ProcessStatisticsReader.
+    static ErrorOr<void> append_process(KBufferBuilder& builder, StringBuilder& threads, Process const& process)
+    {
+        StringBuilder pledge_builder;
+        StringView veil;
+        if (process.is_user_process()) {
+#define __ENUMERATE_PLEDGE_PROMISE(promise)             \
+    if (process.has_promised(Pledge::promise)) {        \
+        TRY(pledge_builder.try_append(#promise " "sv)); \
+    }
+            ENUMERATE_PLEDGE_PROMISES
+#undef __ENUMERATE_PLEDGE_PROMISE
+
+            switch (process.veil_state()) {
+            case VeilState::None:
+                veil = "None"sv;
+                break;
+            case VeilState::Dropped:
+                veil = "Dropped"sv;
+                break;
+            case VeilState::Locked:
+                veil = "Locked"sv;
+                break;
+            }
+        }
+
+        OwnPtr<KString> executable_path;
+        if (process.executable())
+            executable_path = TRY(process.executable()->try_serialize_absolute_path());
+
+        auto name = clamp_string(process.name());
+        auto executable = clamp_string(executable_path ? executable_path->view() : ""sv);
+        auto tty = clamp_string(process.tty() ? process.tty()->tty_name().view() : "notty"sv);
+        auto pledge = clamp_string(pledge_builder.string_view());
+
+        threads.clear();
+        u32 thread_count = 0;
+        TRY(append_threads(threads, process, thread_count));
+
+        ProcessStatisticsRecord record {};
+        record.record_size = sizeof(record) + name.length() + executable.length() + tty.length() + pledge.length() + veil.length() + threads.length();
+        record.pid = process.pid().value();
+        record.pgid = process.tty() ? process.tty()->pgid().value() : 0;
+        record.pgp = process.pgid().value();
+        record.sid = process.sid().value();
+        record.uid = process.uid().value();
+        record.gid = process.gid().value();
+        record.ppid = process.ppid().value();
+        record.nfds = process.fds().open_count();
+        record.kernel = process.is_kernel_process();
+        record.dumpable = process.is_dumpable();
+        record.name_length = name.length();
+        record.executable_length = executable.length();
+        record.tty_length = tty.length();
+        record.pledge_length = pledge.length();
+        record.veil_length = veil.length();
+        record.amount_virtual = process.address_space().amount_virtual();
+        record.amount_resident = process.address_space().amount_resident();
+        record.amount_shared = process.address_space().amount_shared();
+        record.amount_dirty_private = process.address_space().amount_dirty_private();
+        record.amount_clean_inode = process.address_space().amount_clean_inode();
+        record.amount_purgeable_volatile = process.address_space().amount_purgeable_volatile();
+        record.amount_purgeable_nonvolatile = process.address_space().amount_purgeable_nonvolatile();
+        record.thread_count = thread_count;
+
+        TRY(builder.append_bytes({ &record, sizeof(record) }));
+        TRY(builder.append_bytes(name.bytes()));
+        TRY(builder.append_bytes(executable.bytes()));
+        TRY(builder.append_bytes(tty.bytes()));
+        TRY(builder.append_bytes(pledge.bytes()));
+        TRY(builder.append_bytes(veil.bytes()));
+        TRY(builder.append_bytes(threads.string_view().bytes()));
+        return {};
+    }
+
+    // Returns the generation of the new snapshot, to be passed back in as `since_generation` next time.
+    static ErrorOr<u64> generate(KBufferBuilder& builder, u64 since_generation)
+    {
+        StringBuilder threads;
+
+        SpinlockLocker lock(g_scheduler_lock);
+        // Threads only change state with the scheduler lock held, so everything that happens after
+        // this point is stamped with a generation that's at least the one of this snapshot.
+        auto generation = Thread::advance_statistics_generation();
+
+        return Process::all_instances().with([&](auto& processes) -> ErrorOr<u64> {
+            auto& colonel = *Scheduler::colonel();
+
+            ProcessStatisticsHeader header {};
+            header.magic = process_statistics_magic;
+            header.version = process_statistics_version;
+            header.header_size = sizeof(header);
+            header.process_count = 1;
+            header.changed_process_count = may_have_changed(colonel, since_generation);
+            for (auto& process : processes) {
+                ++header.process_count;
+                if (may_have_changed(process, since_generation))
+                    ++header.changed_process_count;
+            }
+            header.since_generation = since_generation;
+            header.generation = generation;
+            auto total_time_scheduled = Scheduler::get_total_time_scheduled();
+            header.total_time_scheduled = total_time_scheduled.total;
+            header.total_time_scheduled_kernel = total_time_scheduled.total_kernel;
+            TRY(builder.append_bytes({ &header, sizeof(header) }));
+
+            auto append_pid = [&](Process const& process) -> ErrorOr<void> {
+                u32 pid = process.pid().value();
+                return builder.append_bytes({ &pid, sizeof(pid) });
+            };
+            TRY(append_pid(colonel));
+            for (auto& process : processes)
+                TRY(append_pid(process));
+
+            if (may_have_changed(colonel, since_generation))
+                TRY(append_process(builder, threads, colonel));
+            for (auto& process : processes) {
+                if (may_have_changed(process, since_generation))
+                    TRY(append_process(builder, threads, process));
+            }
+            return generation;
+        });
+    }
+};
 class ProcFSCPUInformation final : public ProcFSGlobalInformation {
 public:
     static NonnullRefPtr<ProcFSCPUInformation> must_create();
@@ -751,6 +993,28 @@ private:
     }
 };
 
+// Unlike /proc/profile, reading this consumes the events, so that a long-running
+// system-wide profile can be drained while it's still recording.
+class ProcFSProfileStream final : public ProcFSExposedComponent {
+public:
+    static NonnullRefPtr<ProcFSProfileStream> must_create();
+
+    virtual mode_t required_mode() const override { return 0400; }
+
+private:
+    ProcFSProfileStream()
+        : ProcFSExposedComponent("profile_stream"sv)
+    {
+    }
+
+    virtual ErrorOr<size_t> read_bytes(off_t, size_t count, UserOrKernelBuffer& buffer, OpenFileDescription*) const override
+    {
+        if (!g_global_perf_events)
+            return ENOENT;
+        return g_global_perf_events->stream_json(buffer, count);
+    }
+};
+
 class ProcFSKernelBase final : public ProcFSGlobalInformation {
 public:
     static NonnullRefPtr<ProcFSKernelBase> must_create();
@@ -788,6 +1052,10 @@ UNMAP_AFTER_INIT NonnullRefPtr<ProcFSOverallProcesses> ProcFSOverallProcesses::m
 {
     return adopt_ref_if_nonnull(new (nothrow) ProcFSOverallProcesses).release_nonnull();
 }
+UNMAP_AFTER_INIT NonnullRefPtr<ProcFSProcessStatistics> ProcFSProcessStatistics::must_create()
+{
+    return adopt_ref_if_nonnull(new (nothrow) ProcFSProcessStatistics).release_nonnull();
+}
 UNMAP_AFTER_INIT NonnullRefPtr<ProcFSCPUInformation> ProcFSCPUInformation::must_create()
 {
     return adopt_ref_if_nonnull(new (nothrow) ProcFSCPUInformation).release_nonnull();
@@ -829,6 +1097,11 @@ UNMAP_AFTER_INIT NonnullRefPtr<ProcFSProfile> ProcFSProfile::must_create()
     return adopt_ref_if_nonnull(new (nothrow) ProcFSProfile).release_nonnull();
 }
 
+UNMAP_AFTER_INIT NonnullRefPtr<ProcFSProfileStream> ProcFSProfileStream::must_create()
+{
+    return adopt_ref_if_nonnull(new (nothrow) ProcFSProfileStream).release_nonnull();
+}
+
 UNMAP_AFTER_INIT NonnullRefPtr<ProcFSKernelBase> ProcFSKernelBase::must_create()
 {
     return adopt_ref_if_nonnull(new (nothrow) ProcFSKernelBase).release_nonnull();
@@ -854,6 +1127,10 @@ UNMAP_AFTER_INIT ProcFSOverallProcesses::ProcFSOverallProcesses()
     : ProcFSGlobalInformation("all"sv)
 {
 }
+UNMAP_AFTER_INIT ProcFSProcessStatistics::ProcFSProcessStatistics()
+    : ProcFSGlobalInformation("process_statistics"sv)
+{
+}
 UNMAP_AFTER_INIT ProcFSCPUInformation::ProcFSCPUInformation()
     : ProcFSGlobalInformation("cpuinfo"sv)
 {
@@ -922,6 +1199,7 @@ UNMAP_AFTER_INIT NonnullRefPtr<ProcFSRootDirectory> ProcFSRootDirectory::must_cr
     directory->m_components.append(ProcFSMemoryStatus::must_create());
     directory->m_components.append(ProcFSSystemStatistics::must_create());
     directory->m_components.append(ProcFSOverallProcesses::must_create());
+    directory->m_components.append(ProcFSProcessStatistics::must_create());
     directory->m_components.append(ProcFSCPUInformation::must_create());
     directory->m_components.append(ProcFSDmesg::must_create());
     directory->m_components.append(ProcFSInterrupts::must_create());
@@ -932,6 +1210,7 @@ UNMAP_AFTER_INIT NonnullRefPtr<ProcFSRootDirectory> ProcFSRootDirectory::must_cr
     directory->m_components.append(ProcFSCommandLine::must_create());
     directory->m_components.append(ProcFSSystemMode::must_create());
     directory->m_components.append(ProcFSProfile::must_create());
+    directory->m_components.append(ProcFSProfileStream::must_create());
     directory->m_components.append(ProcFSKernelBase::must_create());
 
     directory->m_components.append(ProcFSNetworkDirectory::must_create(*directory));
@@ -6,6 +6,7 @@
 
 #include <AK/Assertions.h>
 #include <AK/Types.h>
+#include <Kernel/Arch/Processor.h>
 #include <Kernel/Debug.h>
 #include <Kernel/Heap/Heap.h>
 #include <Kernel/Heap/kmalloc.h>
@@ -309,7 +310,7 @@ struct KmallocGlobalData {
 
     KmallocSubheap::List subheaps;
 
-    KmallocSlabheap slabheaps[6] = { 16, 32, 64, 128, 256, 512 };
+    KmallocSlabheap slabheaps[KMALLOC_SIZE_CLASS_COUNT] = { 16, 32, 64, 128, 256, 512 };
 
     bool expansion_in_progress { false };
 };
@@ -322,11 +323,102 @@ static size_t g_kfree_call_count;
 static size_t g_nested_kfree_calls;
 bool g_dump_kmalloc_stacks;
 
+// A magazine is a small per-processor stack of free slabs of one size class.
+// Allocations and frees are served from it without touching s_lock, and it's
+// only refilled from (or flushed to) the shared slabheap in batches.
+struct KmallocMagazine {
+    static constexpr size_t capacity = 32;
+    static constexpr size_t batch_size = capacity / 2;
+
+    size_t count { 0 };
+    void* slabs[capacity];
+};
+
+struct KmallocProcessorCache {
+    static Kernel::ProcessorSpecificDataID processor_specific_data_id() { return Kernel::ProcessorSpecificDataID::KmallocCache; }
+
+    // NOTE: This is only ever contended by someone reading the statistics, or
+    //       by a thread that got moved to another processor after looking us up.
+    //       It also keeps interrupt handlers on this processor out of the magazines.
+    Kernel::Spinlock lock;
+    KmallocMagazine magazines[KMALLOC_SIZE_CLASS_COUNT];
+    kmalloc_size_class_stats stats[KMALLOC_SIZE_CLASS_COUNT] {};
+    size_t kmalloc_call_count { 0 };
+    size_t kfree_call_count { 0 };
+};
+
+static inline KmallocProcessorCache* current_processor_cache()
+{
+    if (!Kernel::Processor::is_initialized())
+        return nullptr;
+    return Kernel::Processor::current().get_specific<KmallocProcessorCache>();
+}
+
+static inline Optional<size_t> size_class_for(size_t size)
+{
+    for (size_t i = 0; i < KMALLOC_SIZE_CLASS_COUNT; ++i) {
+        if (size <= g_kmalloc_global->slabheaps[i].slab_size())
+            return i;
+    }
+    return {};
+}
+
+static void* allocate_from_processor_cache(KmallocProcessorCache& cache, size_t size_class)
+{
+    SpinlockLocker cache_locker(cache.lock);
+    ++cache.kmalloc_call_count;
+
+    auto& slabheap = g_kmalloc_global->slabheaps[size_class];
+    auto& magazine = cache.magazines[size_class];
+    auto& stats = cache.stats[size_class];
+    if (magazine.count == 0) {
+        ++stats.magazine_misses;
+        SpinlockLocker lock(s_lock);
+        while (magazine.count < KmallocMagazine::batch_size)
+            magazine.slabs[magazine.count++] = slabheap.allocate();
+    } else {
+        ++stats.magazine_hits;
+    }
+
+    auto* ptr = magazine.slabs[--magazine.count];
+    memset(ptr, KMALLOC_SCRUB_BYTE, slabheap.slab_size());
+    return ptr;
+}
+
+static void deallocate_to_processor_cache(KmallocProcessorCache& cache, void* ptr, size_t size_class)
+{
+    SpinlockLocker cache_locker(cache.lock);
+    ++cache.kfree_call_count;
+
+    auto& slabheap = g_kmalloc_global->slabheaps[size_class];
+    auto& magazine = cache.magazines[size_class];
+    auto& stats = cache.stats[size_class];
+    if (magazine.count == KmallocMagazine::capacity) {
+        ++stats.magazine_flushes;
+        SpinlockLocker lock(s_lock);
+        // Give back the oldest half, the most recently freed slabs are the most likely to still be cached.
+        for (size_t i = 0; i < KmallocMagazine::batch_size; ++i)
+            slabheap.deallocate(magazine.slabs[i]);
+        memmove(magazine.slabs, magazine.slabs + KmallocMagazine::batch_size, (magazine.count - KmallocMagazine::batch_size) * sizeof(void*));
+        magazine.count -= KmallocMagazine::batch_size;
+    } else {
+        ++stats.free_magazine_hits;
+    }
+
+    memset(ptr, KFREE_SCRUB_BYTE, slabheap.slab_size());
+    magazine.slabs[magazine.count++] = ptr;
+}
+
 void kmalloc_enable_expand()
 {
     g_kmalloc_global->enable_expansion();
 }
 
+void kmalloc_initialize_processor_cache()
+{
+    Kernel::ProcessorSpecific<KmallocProcessorCache>::initialize();
+}
+
 static inline void kmalloc_verify_nospinlock_held()
 {
     // Catch bad callers allocating under spinlock.
@@ -347,15 +439,23 @@ UNMAP_AFTER_INIT void kmalloc_init()
 void* kmalloc(size_t size)
 {
     kmalloc_verify_nospinlock_held();
-    SpinlockLocker lock(s_lock);
-    ++g_kmalloc_call_count;
 
-    if (g_dump_kmalloc_stacks && Kernel::g_kernel_symbols_available) {
-        dbgln("kmalloc({})", size);
-        Kernel::dump_backtrace();
-    }
+    void* ptr = nullptr;
+    auto size_class = size_class_for(size);
+    auto* cache = size_class.has_value() ? current_processor_cache() : nullptr;
+    if (cache && !g_dump_kmalloc_stacks) {
+        ptr = allocate_from_processor_cache(*cache, size_class.value());
+    } else {
+        SpinlockLocker lock(s_lock);
+        ++g_kmalloc_call_count;
+
+        if (g_dump_kmalloc_stacks && Kernel::g_kernel_symbols_available) {
+            dbgln("kmalloc({})", size);
+            Kernel::dump_backtrace();
+        }
 
-    void* ptr = g_kmalloc_global->allocate(size);
+        ptr = g_kmalloc_global->allocate(size);
+    }
 
     Thread* current_thread = Thread::current();
     if (!current_thread)
@@ -378,6 +478,23 @@ void kfree_sized(void* ptr, size_t size)
     VERIFY(size > 0);
 
     kmalloc_verify_nospinlock_held();
+
+    auto size_class = size_class_for(size);
+    auto* cache = size_class.has_value() ? current_processor_cache() : nullptr;
+    if (cache) {
+        VERIFY(g_kmalloc_global->is_valid_kmalloc_address(VirtualAddress { ptr }));
+        deallocate_to_processor_cache(*cache, ptr, size_class.value());
+
+        Thread* current_thread = Thread::current();
+        if (!current_thread)
+            current_thread = Processor::idle_thread();
+        if (current_thread) {
+            VERIFY(current_thread->is_allocation_enabled());
+            PerformanceManager::add_kfree_perf_event(*current_thread, 0, (FlatPtr)ptr);
+        }
+        return;
+    }
+
     SpinlockLocker lock(s_lock);
     ++g_kfree_call_count;
     ++g_nested_kfree_calls;
@@ -481,9 +598,42 @@ void operator delete[](void* ptr, size_t size) noexcept
 
 void get_kmalloc_stats(kmalloc_stats& stats)
 {
+    size_t cached_kmalloc_call_count = 0;
+    size_t cached_kfree_call_count = 0;
+    Processor::for_each([&](Processor& processor) {
+        auto* cache = processor.get_specific<KmallocProcessorCache>();
+        if (!cache)
+            return;
+        SpinlockLocker cache_locker(cache->lock);
+        cached_kmalloc_call_count += cache->kmalloc_call_count;
+        cached_kfree_call_count += cache->kfree_call_count;
+    });
+
     SpinlockLocker lock(s_lock);
     stats.bytes_allocated = g_kmalloc_global->allocated_bytes();
     stats.bytes_free = g_kmalloc_global->free_bytes();
-    stats.kmalloc_call_count = g_kmalloc_call_count;
-    stats.kfree_call_count = g_kfree_call_count;
+    stats.kmalloc_call_count = g_kmalloc_call_count + cached_kmalloc_call_count;
+    stats.kfree_call_count = g_kfree_call_count + cached_kfree_call_count;
+}
+
+void get_kmalloc_size_class_stats(kmalloc_size_class_stats (&stats)[KMALLOC_SIZE_CLASS_COUNT])
+{
+    for (size_t i = 0; i < KMALLOC_SIZE_CLASS_COUNT; ++i) {
+        stats[i] = {};
+        stats[i].slab_size = g_kmalloc_global->slabheaps[i].slab_size();
+    }
+
+    Processor::for_each([&](Processor& processor) {
+        auto* cache = processor.get_specific<KmallocProcessorCache>();
+        if (!cache)
+            return;
+        SpinlockLocker cache_locker(cache->lock);
+        for (size_t i = 0; i < KMALLOC_SIZE_CLASS_COUNT; ++i) {
+            stats[i].magazine_hits += cache->stats[i].magazine_hits;
+            stats[i].magazine_misses += cache->stats[i].magazine_misses;
+            stats[i].free_magazine_hits += cache->stats[i].free_magazine_hits;
+            stats[i].magazine_flushes += cache->stats[i].magazine_flushes;
+            stats[i].cached_slabs += cache->magazines[i].count;
+        }
+    });
 }
@@ -50,6 +50,18 @@ struct kmalloc_stats {
 };
 void get_kmalloc_stats(kmalloc_stats&);
 
+#define KMALLOC_SIZE_CLASS_COUNT 6
+
+struct kmalloc_size_class_stats {
+    size_t slab_size;
+    size_t magazine_hits;
+    size_t magazine_misses;
+    size_t free_magazine_hits;
+    size_t magazine_flushes;
+    size_t cached_slabs;
+};
+void get_kmalloc_size_class_stats(kmalloc_size_class_stats (&)[KMALLOC_SIZE_CLASS_COUNT]);
+
 extern bool g_dump_kmalloc_stacks;
 
 inline void* operator new(size_t, void* p) { return p; }
@@ -85,3 +97,4 @@ inline void kfree_aligned(void* ptr)
 size_t kmalloc_good_size(size_t);
 
 void kmalloc_enable_expand();
+void kmalloc_initialize_processor_cache();
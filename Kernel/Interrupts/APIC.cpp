@@ -565,6 +565,27 @@ void APIC::send_ipi(u32 cpu)
     write_icr({ IRQ_APIC_IPI + IRQ_VECTOR_BASE, m_is_x2 ? Processor::by_id(cpu).info().apic_id() : cpu, ICRReg::Fixed, m_is_x2 ? ICRReg::Physical : ICRReg::Logical, ICRReg::Assert, ICRReg::TriggerMode::Edge, ICRReg::NoShorthand });
 }
 
+auto APIC::message_signalled_interrupt_for(u32 cpu, u8 interrupt_number) const -> ErrorOr<MessageSignalledInterrupt>
+{
+    static constexpr u32 msi_address_base = 0xfee00000;
+    static constexpr u32 msi_address_destination_mode_logical = 1 << 2;
+
+    // Like IPIs, these are addressed by x2APIC ID, or by the logical xAPIC ID we assigned in enable().
+    // NOTE: Without interrupt remapping, only 8 bits of the destination fit into the address.
+    VERIFY(cpu < Processor::count());
+    u32 address = msi_address_base;
+    if (m_is_x2) {
+        auto apic_id = Processor::by_id(cpu).info().apic_id();
+        if (apic_id > 0xff)
+            return ENOTSUP;
+        address |= apic_id << 12;
+    } else {
+        address |= (cpu << 12) | msi_address_destination_mode_logical;
+    }
+    // Fixed delivery mode, edge triggered.
+    return MessageSignalledInterrupt { address, static_cast<u32>(interrupt_number) + IRQ_VECTOR_BASE };
+}
+
 UNMAP_AFTER_INIT APICTimer* APIC::initialize_timers(HardwareTimerBase& calibration_timer)
 {
     if (!m_apic_base && !m_is_x2)
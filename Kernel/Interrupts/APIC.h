@@ -32,6 +32,13 @@ public:
     void init_finished(u32 cpu);
     void broadcast_ipi();
     void send_ipi(u32 cpu);
+
+    // What a PCI device has to write (with MSI or MSI-X) to raise an interrupt on a processor.
+    struct MessageSignalledInterrupt {
+        u32 address;
+        u32 data;
+    };
+    ErrorOr<MessageSignalledInterrupt> message_signalled_interrupt_for(u32 cpu, u8 interrupt_number) const;
     static u8 spurious_interrupt_vector();
     Thread* get_idle_thread(u32 cpu) const;
     u32 enabled_processor_count() const { return m_processor_enabled_cnt; }
@@ -98,6 +98,32 @@ u8 InterruptManagement::get_irq_vector(u8 mapped_interrupt_vector)
     return mapped_interrupt_vector;
 }
 
+ErrorOr<u8> InterruptManagement::allocate_message_signalled_interrupt_number()
+{
+    // The local APIC's own interrupts (timer, IPI, error and spurious) start at vector 0xfc.
+    static constexpr u8 first_local_apic_interrupt_number = 0xfc - IRQ_VECTOR_BASE;
+
+    if (!m_smp_enabled || !APIC::initialized())
+        return ENOTSUP;
+
+    SpinlockLocker locker(m_message_signalled_interrupts_lock);
+    // Hand out interrupt numbers from the top down, stopping before we reach those the IRQ controllers deliver to.
+    size_t first_unrouted_interrupt_number = 0;
+    for (auto& irq_controller : m_interrupt_controllers)
+        first_unrouted_interrupt_number = max(first_unrouted_interrupt_number, irq_controller->gsi_base() + irq_controller->interrupt_vectors_count());
+
+    u8 candidate = m_next_message_signalled_interrupt_number.value_or(first_local_apic_interrupt_number - 1);
+    for (; candidate >= first_unrouted_interrupt_number && candidate > 0; --candidate) {
+        if (candidate + IRQ_VECTOR_BASE == syscall_vector)
+            continue;
+        if (get_interrupt_handler(candidate).type() != HandlerType::UnhandledInterruptHandler)
+            continue;
+        m_next_message_signalled_interrupt_number = candidate - 1;
+        return candidate;
+    }
+    return EBUSY;
+}
+
 RefPtr<IRQController> InterruptManagement::get_responsible_irq_controller(u8 interrupt_vector)
 {
     if (m_interrupt_controllers.size() == 1 && m_interrupt_controllers[0]->type() == IRQControllerType::i8259) {
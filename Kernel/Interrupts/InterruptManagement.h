@@ -16,6 +16,7 @@
 #include <Kernel/Interrupts/GenericInterruptHandler.h>
 #include <Kernel/Interrupts/IOAPIC.h>
 #include <Kernel/Interrupts/IRQController.h>
+#include <Kernel/Locking/Spinlock.h>
 
 namespace Kernel {
 
@@ -49,6 +50,10 @@ public:
     static u8 acquire_mapped_interrupt_number(u8 original_irq);
     static u8 acquire_irq_number(u8 mapped_interrupt_vector);
 
+    // Hands out an interrupt number that none of the IRQ controllers deliver to, for interrupts that
+    // devices send to a local APIC directly (MSI and MSI-X). Only available with APIC-based interrupts.
+    ErrorOr<u8> allocate_message_signalled_interrupt_number();
+
     virtual void switch_to_pic_mode();
     virtual void switch_to_ioapic_mode();
 
@@ -75,6 +80,8 @@ private:
     Vector<ISAInterruptOverrideMetadata> m_isa_interrupt_overrides;
     Vector<PCIInterruptOverrideMetadata> m_pci_interrupt_overrides;
     PhysicalAddress m_madt;
+    Spinlock m_message_signalled_interrupts_lock;
+    Optional<u8> m_next_message_signalled_interrupt_number;
 };
 
 }
@@ -0,0 +1,29 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <Kernel/Debug.h>
+#include <Kernel/Interrupts/APIC.h>
+#include <Kernel/Interrupts/MSIHandler.h>
+
+namespace Kernel {
+
+MSIHandler::MSIHandler(u8 interrupt_number)
+    : GenericInterruptHandler(interrupt_number, true)
+{
+}
+
+MSIHandler::~MSIHandler()
+{
+}
+
+bool MSIHandler::eoi()
+{
+    dbgln_if(IRQ_DEBUG, "EOI MSI {}", interrupt_number());
+    APIC::the().eoi();
+    return true;
+}
+
+}
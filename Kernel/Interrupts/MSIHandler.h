@@ -8,31 +8,31 @@
 
 #include <AK/Types.h>
 #include <Kernel/Interrupts/GenericInterruptHandler.h>
-#include <Kernel/PCI/Definitions.h>
 
 namespace Kernel {
 
-class MSIHandler final : public GenericInterruptHandler {
+// Message signalled interrupts are written by the device straight to a local APIC,
+// so they bypass the IRQ controllers entirely and are never shared.
+class MSIHandler : public GenericInterruptHandler {
 public:
     virtual ~MSIHandler();
 
-    virtual void handle_interrupt(RegisterState&) override { }
-
-    void enable_irq();
-    void disable_irq();
+    virtual bool handle_interrupt(const RegisterState& regs) override { return handle_irq(regs); }
+    virtual bool handle_irq(const RegisterState&) = 0;
 
     virtual bool eoi() override;
 
+    virtual HandlerType type() const override { return HandlerType::IRQHandler; }
+    virtual StringView purpose() const override { return "MSI Handler"sv; }
+    virtual StringView controller() const override { return "MSI"sv; }
+
     virtual size_t sharing_devices_count() const override { return 0; }
     virtual bool is_shared_handler() const override { return false; }
-    virtual bool is_sharing_with_others() const override { return m_shared_with_others; }
+    virtual bool is_sharing_with_others() const override { return false; }
 
 protected:
-    void change_irq_number(u8 irq);
-    explicit MSIHandler(PCI::Address);
-
-private:
-    bool m_shared_with_others;
-    bool m_enabled;
+    // The interrupt number has to come from InterruptManagement::allocate_message_signalled_interrupt_number().
+    explicit MSIHandler(u8 interrupt_number);
 };
+
 }
@@ -15,10 +15,10 @@
 
 namespace Kernel::Memory {
 
-ErrorOr<NonnullOwnPtr<AddressSpace>> AddressSpace::try_create(AddressSpace const* parent)
+ErrorOr<NonnullRefPtr<AddressSpace>> AddressSpace::try_create(AddressSpace const* parent)
 {
     auto page_directory = TRY(PageDirectory::try_create_for_userspace(parent ? &parent->page_directory().range_allocator() : nullptr));
-    auto space = TRY(adopt_nonnull_own_or_enomem(new (nothrow) AddressSpace(page_directory)));
+    auto space = TRY(adopt_nonnull_ref_or_enomem(new (nothrow) AddressSpace(page_directory)));
     space->page_directory().set_space({}, *space);
     return space;
 }
@@ -149,6 +149,7 @@ ErrorOr<Region*> AddressSpace::try_allocate_split_region(Region const& source_re
     region->set_syscall_region(source_region.is_syscall_region());
     region->set_mmap(source_region.is_mmap());
     region->set_stack(source_region.is_stack());
+    region->set_large_pages_allowed(source_region.are_large_pages_allowed());
     size_t page_offset_in_source_region = (offset_in_vmobject - source_region.offset_in_vmobject()) / PAGE_SIZE;
     for (size_t i = 0; i < region->page_count(); ++i) {
         if (source_region.should_cow(page_offset_in_source_region + i))
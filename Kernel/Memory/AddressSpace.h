@@ -8,6 +8,7 @@
 #pragma once
 
 #include <AK/RedBlackTree.h>
+#include <AK/RefCounted.h>
 #include <AK/Vector.h>
 #include <AK/WeakPtr.h>
 #include <Kernel/Memory/AllocationStrategy.h>
@@ -16,9 +17,9 @@
 
 namespace Kernel::Memory {
 
-class AddressSpace {
+class AddressSpace : public RefCounted<AddressSpace> {
 public:
-    static ErrorOr<NonnullOwnPtr<AddressSpace>> try_create(AddressSpace const* parent);
+    static ErrorOr<NonnullRefPtr<AddressSpace>> try_create(AddressSpace const* parent);
     ~AddressSpace();
 
     PageDirectory& page_directory() { return *m_page_directory; }
@@ -251,6 +251,37 @@ NonnullRefPtr<PhysicalPage> AnonymousVMObject::allocate_committed_page(Badge<Reg
     return m_unused_committed_pages->take_one();
 }
 
+bool AnonymousVMObject::try_allocate_committed_large_page(Badge<Region>, size_t first_page_index)
+{
+    VERIFY(m_lock.is_locked());
+    // NOTE: Purging replaces pages behind the back of the regions, which would have to split large pages while
+    //       already allocating memory. Purgeable memory is short-lived cache data anyway, so it doesn't get any.
+    if (m_purgeable)
+        return false;
+    if (!m_unused_committed_pages.has_value() || m_unused_committed_pages->page_count() < PAGES_PER_LARGE_PAGE)
+        return false;
+    if (first_page_index + PAGES_PER_LARGE_PAGE > page_count())
+        return false;
+
+    auto slots = physical_pages().slice(first_page_index, PAGES_PER_LARGE_PAGE);
+    for (auto& page : slots) {
+        if (!page || !page->is_lazy_committed_page())
+            return false;
+    }
+
+    auto pages = m_unused_committed_pages->take_large_page();
+    if (pages.is_empty())
+        return false;
+
+    for (size_t i = 0; i < PAGES_PER_LARGE_PAGE; ++i) {
+        slots[i] = pages[i];
+        // Nobody else can have seen these pages yet.
+        if (!m_cow_map.is_null())
+            m_cow_map.set(first_page_index + i, false);
+    }
+    return true;
+}
+
 Bitmap& AnonymousVMObject::ensure_cow_map()
 {
     if (m_cow_map.is_null())
@@ -26,6 +26,8 @@ public:
     virtual ErrorOr<NonnullRefPtr<VMObject>> try_clone() override;
 
     [[nodiscard]] NonnullRefPtr<PhysicalPage> allocate_committed_page(Badge<Region>);
+    // Backs the given lazily committed pages with one physically contiguous large page, if one is available.
+    [[nodiscard]] bool try_allocate_committed_large_page(Badge<Region>, size_t first_page_index);
     PageFaultResponse handle_cow_fault(size_t, VirtualAddress);
     size_t cow_pages() const;
     bool should_cow(size_t page_index, bool) const;
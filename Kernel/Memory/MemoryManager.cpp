@@ -568,9 +568,10 @@ PageTableEntry* MemoryManager::ensure_pte(PageDirectory& page_directory, Virtual
 
     auto* pd = quickmap_pd(page_directory, page_directory_table_index);
     auto& pde = pd[page_directory_index];
-    if (pde.is_present())
+    if (pde.is_present() && !pde.is_huge())
         return &quickmap_pt(PhysicalAddress(pde.page_table_base()))[page_table_index];
 
+    auto original_pde = pde;
     bool did_purge = false;
     auto page_table = allocate_user_physical_page(ShouldZeroFill::Yes, &did_purge);
     if (!page_table) {
@@ -584,8 +585,28 @@ PageTableEntry* MemoryManager::ensure_pte(PageDirectory& page_directory, Virtual
         pd = quickmap_pd(page_directory, page_directory_table_index);
         VERIFY(&pde == &pd[page_directory_index]); // Sanity check
 
-        VERIFY(!pde.is_present()); // Should have not changed
+        VERIFY(pde.raw() == original_pde.raw()); // Should have not changed
     }
+
+    if (original_pde.is_huge()) {
+        // Someone wants to map a single page inside a large page, so split it up into a page table
+        // that maps the same memory with the same permissions. The caller then changes what it wants.
+        auto* new_page_table = quickmap_pt(page_table->paddr());
+        for (size_t i = 0; i < PAGES_PER_LARGE_PAGE; ++i) {
+            auto& pte = new_page_table[i];
+            pte.set_physical_page_base(original_pde.large_page_base() + i * PAGE_SIZE);
+            pte.set_present(true);
+            pte.set_writable(original_pde.is_writable());
+            pte.set_user_allowed(original_pde.is_user_allowed());
+            pte.set_write_through(original_pde.is_write_through());
+            pte.set_cache_disabled(original_pde.is_cache_disabled());
+            pte.set_global(original_pde.is_global());
+            pte.set_execute_disabled(original_pde.is_execute_disabled());
+        }
+        ++m_system_memory_info.large_pages_split;
+        pde.clear();
+    }
+
     pde.set_page_table_base(page_table->paddr().get());
     pde.set_user_allowed(true);
     pde.set_present(true);
@@ -598,6 +619,26 @@ PageTableEntry* MemoryManager::ensure_pte(PageDirectory& page_directory, Virtual
     return &quickmap_pt(PhysicalAddress(pde.page_table_base()))[page_table_index];
 }
 
+PageDirectoryEntry* MemoryManager::ensure_large_page_pde(PageDirectory& page_directory, VirtualAddress vaddr)
+{
+    VERIFY_INTERRUPTS_DISABLED();
+    VERIFY(s_mm_lock.is_locked_by_current_processor());
+    VERIFY(page_directory.get_lock().is_locked_by_current_processor());
+    VERIFY(vaddr.get() % LARGE_PAGE_SIZE == 0);
+    u32 page_directory_table_index = (vaddr.get() >> 30) & 0x1ff;
+    u32 page_directory_index = (vaddr.get() >> 21) & 0x1ff;
+
+    auto* pd = quickmap_pd(page_directory, page_directory_table_index);
+    auto& pde = pd[page_directory_index];
+    if (pde.is_present() && !pde.is_huge()) {
+        // Large pages only ever map memory that belongs to a single region, so nobody else uses this page table.
+        get_physical_page_entry(PhysicalAddress { pde.page_table_base() }).allocated.physical_page.unref();
+    }
+    pde.clear();
+    ++m_system_memory_info.large_pages_mapped;
+    return &pde;
+}
+
 void MemoryManager::release_pte(PageDirectory& page_directory, VirtualAddress vaddr, IsLastPTERelease is_last_pte_release)
 {
     VERIFY_INTERRUPTS_DISABLED();
@@ -609,6 +650,11 @@ void MemoryManager::release_pte(PageDirectory& page_directory, VirtualAddress va
 
     auto* pd = quickmap_pd(page_directory, page_directory_table_index);
     PageDirectoryEntry& pde = pd[page_directory_index];
+    if (pde.is_present() && pde.is_huge()) {
+        // A large page always lies entirely within the region being unmapped, so it goes away as a whole.
+        pde.clear();
+        return;
+    }
     if (pde.is_present()) {
         auto* page_table = quickmap_pt(PhysicalAddress((FlatPtr)pde.page_table_base()));
         auto& pte = page_table[page_table_index];
@@ -635,6 +681,7 @@ void MemoryManager::release_pte(PageDirectory& page_directory, VirtualAddress va
 UNMAP_AFTER_INIT void MemoryManager::initialize(u32 cpu)
 {
     ProcessorSpecific<MemoryManagerData>::initialize();
+    kmalloc_initialize_processor_cache();
 
     if (cpu == 0) {
         new MemoryManager;
@@ -898,6 +945,35 @@ NonnullRefPtr<PhysicalPage> MemoryManager::allocate_committed_user_physical_page
     return page.release_nonnull();
 }
 
+NonnullRefPtrVector<PhysicalPage> MemoryManager::allocate_committed_user_large_page(Badge<CommittedPhysicalPageSet>)
+{
+    SpinlockLocker lock(s_mm_lock);
+    VERIFY(m_system_memory_info.user_physical_pages_committed >= PAGES_PER_LARGE_PAGE);
+
+    NonnullRefPtrVector<PhysicalPage> pages;
+    for (auto& region : m_user_physical_regions) {
+        pages = region.take_free_large_page();
+        if (!pages.is_empty())
+            break;
+    }
+    if (pages.is_empty()) {
+        // Memory is too fragmented, the caller falls back to individual pages.
+        ++m_system_memory_info.large_page_allocation_failures;
+        return {};
+    }
+
+    m_system_memory_info.user_physical_pages_committed -= PAGES_PER_LARGE_PAGE;
+    m_system_memory_info.user_physical_pages_used += PAGES_PER_LARGE_PAGE;
+    ++m_system_memory_info.large_pages_allocated;
+
+    for (auto& page : pages) {
+        auto* ptr = quickmap_page(page);
+        memset(ptr, 0, PAGE_SIZE);
+        unquickmap_page();
+    }
+    return pages;
+}
+
 RefPtr<PhysicalPage> MemoryManager::allocate_user_physical_page(ShouldZeroFill should_zero_fill, bool* did_purge)
 {
     SpinlockLocker lock(s_mm_lock);
@@ -1172,6 +1248,15 @@ NonnullRefPtr<PhysicalPage> CommittedPhysicalPageSet::take_one()
     return MM.allocate_committed_user_physical_page({}, MemoryManager::ShouldZeroFill::Yes);
 }
 
+NonnullRefPtrVector<PhysicalPage> CommittedPhysicalPageSet::take_large_page()
+{
+    VERIFY(m_page_count >= PAGES_PER_LARGE_PAGE);
+    auto pages = MM.allocate_committed_user_large_page({});
+    if (!pages.is_empty())
+        m_page_count -= PAGES_PER_LARGE_PAGE;
+    return pages;
+}
+
 void CommittedPhysicalPageSet::uncommit_one()
 {
     VERIFY(m_page_count > 0);
@@ -1187,4 +1272,12 @@ void MemoryManager::copy_physical_page(PhysicalPage& physical_page, u8 page_buff
     unquickmap_page();
 }
 
+void MemoryManager::copy_to_physical_page(PhysicalPage& physical_page, u8 const page_buffer[PAGE_SIZE])
+{
+    SpinlockLocker locker(s_mm_lock);
+    auto* quickmapped_page = quickmap_page(physical_page);
+    memcpy(quickmapped_page, page_buffer, PAGE_SIZE);
+    unquickmap_page();
+}
+
 }
@@ -35,6 +35,11 @@ constexpr FlatPtr page_round_down(FlatPtr x)
     return ((FlatPtr)(x)) & ~(PAGE_SIZE - 1);
 }
 
+// A single page directory entry can map this much memory at once, which saves a page table and
+// lets the CPU cover it with a single TLB entry.
+constexpr size_t LARGE_PAGE_SIZE = 2 * MiB;
+constexpr size_t PAGES_PER_LARGE_PAGE = LARGE_PAGE_SIZE / PAGE_SIZE;
+
 inline FlatPtr virtual_to_low_physical(FlatPtr virtual_)
 {
     return virtual_ - physical_to_virtual_offset;
@@ -121,6 +126,8 @@ public:
     size_t page_count() const { return m_page_count; }
 
     [[nodiscard]] NonnullRefPtr<PhysicalPage> take_one();
+    // Takes PAGES_PER_LARGE_PAGE pages making up one large page, or none if there is no free large page.
+    [[nodiscard]] NonnullRefPtrVector<PhysicalPage> take_large_page();
     void uncommit_one();
 
     void operator=(CommittedPhysicalPageSet&&) = delete;
@@ -171,6 +178,7 @@ public:
     void uncommit_user_physical_pages(Badge<CommittedPhysicalPageSet>, size_t page_count);
 
     NonnullRefPtr<PhysicalPage> allocate_committed_user_physical_page(Badge<CommittedPhysicalPageSet>, ShouldZeroFill = ShouldZeroFill::Yes);
+    NonnullRefPtrVector<PhysicalPage> allocate_committed_user_large_page(Badge<CommittedPhysicalPageSet>);
     RefPtr<PhysicalPage> allocate_user_physical_page(ShouldZeroFill = ShouldZeroFill::Yes, bool* did_purge = nullptr);
     RefPtr<PhysicalPage> allocate_supervisor_physical_page();
     NonnullRefPtrVector<PhysicalPage> allocate_contiguous_supervisor_physical_pages(size_t size);
@@ -193,6 +201,10 @@ public:
         PhysicalSize user_physical_pages_uncommitted { 0 };
         PhysicalSize super_physical_pages { 0 };
         PhysicalSize super_physical_pages_used { 0 };
+        u64 large_pages_allocated { 0 };
+        u64 large_page_allocation_failures { 0 };
+        u64 large_pages_mapped { 0 };
+        u64 large_pages_split { 0 };
     };
 
     SystemMemoryInfo get_system_memory_info()
@@ -240,6 +252,7 @@ public:
     PhysicalAddress get_physical_address(PhysicalPage const&);
 
     void copy_physical_page(PhysicalPage&, u8 page_buffer[PAGE_SIZE]);
+    void copy_to_physical_page(PhysicalPage&, u8 const page_buffer[PAGE_SIZE]);
 
     IterationDecision for_each_physical_memory_range(Function<IterationDecision(PhysicalMemoryRange const&)>);
 
@@ -276,6 +289,9 @@ private:
 
     PageTableEntry* pte(PageDirectory&, VirtualAddress);
     PageTableEntry* ensure_pte(PageDirectory&, VirtualAddress);
+    // Returns the page directory entry for the large page at the given (aligned) address, after getting
+    // rid of the page table it may have pointed to. The caller has to fill in the entry.
+    PageDirectoryEntry* ensure_large_page_pde(PageDirectory&, VirtualAddress);
     enum class IsLastPTERelease {
         Yes,
         No
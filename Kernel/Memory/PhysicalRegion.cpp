@@ -106,6 +106,34 @@ NonnullRefPtrVector<PhysicalPage> PhysicalRegion::take_contiguous_free_pages(siz
     return physical_pages;
 }
 
+NonnullRefPtrVector<PhysicalPage> PhysicalRegion::take_free_large_page()
+{
+    constexpr auto order = count_trailing_zeroes(PAGES_PER_LARGE_PAGE);
+
+    Optional<PhysicalAddress> page_base;
+    for (auto& zone : m_usable_zones) {
+        // Buddy blocks are only aligned relative to the base of their zone.
+        if (zone.base().get() % LARGE_PAGE_SIZE != 0)
+            continue;
+        page_base = zone.allocate_block(order);
+        if (page_base.has_value()) {
+            if (zone.is_empty())
+                m_full_zones.append(zone);
+            break;
+        }
+    }
+
+    if (!page_base.has_value())
+        return {};
+
+    NonnullRefPtrVector<PhysicalPage> physical_pages;
+    physical_pages.ensure_capacity(PAGES_PER_LARGE_PAGE);
+    // NOTE: The pages are handed back one at a time, and the buddy allocator merges them again.
+    for (size_t i = 0; i < PAGES_PER_LARGE_PAGE; ++i)
+        physical_pages.append(PhysicalPage::create(page_base.value().offset(i * PAGE_SIZE)));
+    return physical_pages;
+}
+
 RefPtr<PhysicalPage> PhysicalRegion::take_free_page()
 {
     if (m_usable_zones.is_empty())
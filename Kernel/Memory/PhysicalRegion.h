@@ -35,6 +35,8 @@ public:
 
     RefPtr<PhysicalPage> take_free_page();
     NonnullRefPtrVector<PhysicalPage> take_contiguous_free_pages(size_t count);
+    // Returns the PAGES_PER_LARGE_PAGE pages of a naturally aligned large page, or nothing if no zone has one free.
+    NonnullRefPtrVector<PhysicalPage> take_free_large_page();
     void return_page(PhysicalAddress);
 
 private:
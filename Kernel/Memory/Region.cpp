@@ -9,6 +9,7 @@
 #include <Kernel/Arch/x86/PageFault.h>
 #include <Kernel/Debug.h>
 #include <Kernel/FileSystem/Inode.h>
+#include <Kernel/FileSystem/PageCache.h>
 #include <Kernel/Memory/AnonymousVMObject.h>
 #include <Kernel/Memory/MemoryManager.h>
 #include <Kernel/Memory/PageDirectory.h>
@@ -112,6 +113,7 @@ ErrorOr<NonnullOwnPtr<Region>> Region::try_clone()
     }
     clone_region->set_syscall_region(is_syscall_region());
     clone_region->set_mmap(m_mmap);
+    clone_region->set_large_pages_allowed(m_large_pages_allowed);
     return clone_region;
 }
 
@@ -217,6 +219,57 @@ bool Region::map_individual_page_impl(size_t page_index)
     return true;
 }
 
+Optional<size_t> Region::first_page_index_of_large_page(size_t page_index) const
+{
+    if (!m_large_pages_allowed)
+        return {};
+    auto large_page_base = VirtualAddress { vaddr_from_page_index(page_index).get() & ~(LARGE_PAGE_SIZE - 1) };
+    if (large_page_base < vaddr() || large_page_base.offset(LARGE_PAGE_SIZE) > range().end())
+        return {};
+    return page_index_from_address(large_page_base);
+}
+
+bool Region::can_map_large_page(size_t first_page_index) const
+{
+    VERIFY(m_large_pages_allowed);
+    VERIFY(vaddr_from_page_index(first_page_index).get() % LARGE_PAGE_SIZE == 0);
+    if (!is_readable() && !is_writable())
+        return false;
+
+    // All pages have to be the consecutive pieces of one large page, and nothing may need to be copied on write.
+    auto const* first_page = physical_page(first_page_index);
+    if (!first_page || first_page->is_shared_zero_page() || first_page->is_lazy_committed_page())
+        return false;
+    auto base = first_page->paddr();
+    if (base.get() % LARGE_PAGE_SIZE != 0)
+        return false;
+    for (size_t i = 0; i < PAGES_PER_LARGE_PAGE; ++i) {
+        auto const* page = physical_page(first_page_index + i);
+        if (!page || page->paddr() != base.offset(i * PAGE_SIZE))
+            return false;
+        if (is_writable() && should_cow(first_page_index + i))
+            return false;
+    }
+    return true;
+}
+
+void Region::map_large_page_impl(size_t first_page_index)
+{
+    VERIFY(m_page_directory->get_lock().is_locked_by_current_processor());
+    VERIFY(s_mm_lock.is_locked_by_current_processor());
+    VERIFY(is_user());
+
+    auto& pde = *MM.ensure_large_page_pde(*m_page_directory, vaddr_from_page_index(first_page_index));
+    pde.set_large_page_base(physical_page(first_page_index)->paddr().get());
+    pde.set_huge(true);
+    pde.set_present(true);
+    pde.set_writable(is_writable());
+    pde.set_user_allowed(true);
+    pde.set_cache_disabled(!m_cacheable);
+    if (Processor::current().has_feature(CPUFeature::NX))
+        pde.set_execute_disabled(!is_executable());
+}
+
 bool Region::do_remap_vmobject_page(size_t page_index, bool with_flush)
 {
     if (!m_page_directory)
@@ -226,6 +279,12 @@ bool Region::do_remap_vmobject_page(size_t page_index, bool with_flush)
     SpinlockLocker page_lock(m_page_directory->get_lock());
     SpinlockLocker lock(s_mm_lock);
     VERIFY(physical_page(page_index));
+    if (auto first_page_index = first_page_index_of_large_page(page_index); first_page_index.has_value() && can_map_large_page(*first_page_index)) {
+        map_large_page_impl(*first_page_index);
+        if (with_flush)
+            MemoryManager::flush_tlb(m_page_directory, vaddr_from_page_index(*first_page_index), PAGES_PER_LARGE_PAGE);
+        return true;
+    }
     bool success = map_individual_page_impl(page_index);
     if (with_flush)
         MemoryManager::flush_tlb(m_page_directory, vaddr_from_page_index(page_index));
@@ -290,6 +349,11 @@ ErrorOr<void> Region::map(PageDirectory& page_directory, ShouldFlushTLB should_f
     set_page_directory(page_directory);
     size_t page_index = 0;
     while (page_index < page_count()) {
+        if (auto first_page_index = first_page_index_of_large_page(page_index); first_page_index.has_value() && *first_page_index == page_index && can_map_large_page(page_index)) {
+            map_large_page_impl(page_index);
+            page_index += PAGES_PER_LARGE_PAGE;
+            continue;
+        }
         if (!map_individual_page_impl(page_index))
             break;
         ++page_index;
@@ -303,6 +367,13 @@ ErrorOr<void> Region::map(PageDirectory& page_directory, ShouldFlushTLB should_f
     return ENOMEM;
 }
 
+void Region::map_lazily(PageDirectory& page_directory)
+{
+    SpinlockLocker page_lock(page_directory.get_lock());
+    SpinlockLocker lock(s_mm_lock);
+    set_page_directory(page_directory);
+}
+
 void Region::remap()
 {
     VERIFY(m_page_directory);
@@ -342,16 +413,21 @@ PageFaultResponse Region::handle_fault(PageFault const& fault)
         }
 
         auto& page_slot = physical_page_slot(page_index_in_region);
-        if (page_slot->is_lazy_committed_page()) {
-            auto page_index_in_vmobject = translate_to_vmobject_page(page_index_in_region);
-            VERIFY(m_vmobject->is_anonymous());
-            page_slot = static_cast<AnonymousVMObject&>(*m_vmobject).allocate_committed_page({});
-            if (!remap_vmobject_page(page_index_in_vmobject))
-                return PageFaultResponse::OutOfMemory;
-            return PageFaultResponse::Continue;
+        if (page_slot->is_lazy_committed_page())
+            return handle_zero_fault(page_index_in_region);
+
+        // The page is there, it just hasn't been mapped yet (see map_lazily()).
+        if (fault.is_write() && should_cow(page_index_in_region)) {
+            // Don't bother mapping it read-only only to take another fault right away.
+            if (page_slot->is_shared_zero_page())
+                return handle_zero_fault(page_index_in_region);
+            return handle_cow_fault(page_index_in_region);
         }
-        dbgln("BUG! Unexpected NP fault at {}", fault.vaddr());
-        return PageFaultResponse::ShouldCrash;
+        dbgln_if(PAGE_FAULT_DEBUG, "NP(lazy) fault in Region({})[{}] at {}", this, page_index_in_region, fault.vaddr());
+        SpinlockLocker locker(vmobject().m_lock);
+        if (!do_remap_vmobject_page(translate_to_vmobject_page(page_index_in_region)))
+            return PageFaultResponse::OutOfMemory;
+        return PageFaultResponse::Continue;
     }
     VERIFY(fault.type() == PageFault::Type::ProtectionViolation);
     if (fault.access() == PageFault::Access::Write && is_writable() && should_cow(page_index_in_region)) {
@@ -390,7 +466,16 @@ PageFaultResponse Region::handle_zero_fault(size_t page_index_in_region)
 
     if (page_slot->is_lazy_committed_page()) {
         VERIFY(m_vmobject->is_anonymous());
-        page_slot = static_cast<AnonymousVMObject&>(*m_vmobject).allocate_committed_page({});
+        auto& anonymous_vmobject = static_cast<AnonymousVMObject&>(*m_vmobject);
+        if (auto first_page_index = first_page_index_of_large_page(page_index_in_region); first_page_index.has_value()) {
+            if (anonymous_vmobject.try_allocate_committed_large_page({}, translate_to_vmobject_page(*first_page_index))) {
+                dbgln_if(PAGE_FAULT_DEBUG, "      >> ALLOCATED LARGE PAGE {}", physical_page(*first_page_index)->paddr());
+                if (!remap_vmobject_page(page_index_in_vmobject))
+                    return PageFaultResponse::OutOfMemory;
+                return PageFaultResponse::Continue;
+            }
+        }
+        page_slot = anonymous_vmobject.allocate_committed_page({});
         dbgln_if(PAGE_FAULT_DEBUG, "      >> ALLOCATED COMMITTED {}", page_slot->paddr());
     } else {
         page_slot = MM.allocate_user_physical_page(MemoryManager::ShouldZeroFill::Yes);
@@ -456,18 +541,40 @@ PageFaultResponse Region::handle_inode_fault(size_t page_index_in_region)
     u8 page_buffer[PAGE_SIZE];
     auto& inode = inode_vmobject.inode();
 
-    auto buffer = UserOrKernelBuffer::for_kernel_buffer(page_buffer);
-    auto result = inode.read_bytes(page_index_in_vmobject * PAGE_SIZE, PAGE_SIZE, buffer, nullptr);
+    if (PageCache::is_cacheable(inode)) {
+        auto cached_page_or_error = PageCache::the().get_page(inode, page_index_in_vmobject);
+        if (cached_page_or_error.is_error()) {
+            dmesgln("handle_inode_fault: Error ({}) while reading from page cache", cached_page_or_error.error());
+            return PageFaultResponse::ShouldCrash;
+        }
+        auto cached_page = cached_page_or_error.release_value();
+
+        if (inode_vmobject.is_shared_inode()) {
+            // Shared mappings use the cached page itself, so they see the same memory as read().
+            SpinlockLocker locker(inode_vmobject.m_lock);
+            if (vmobject_physical_page_entry.is_null())
+                vmobject_physical_page_entry = move(cached_page);
+            if (!remap_vmobject_page(page_index_in_vmobject))
+                return PageFaultResponse::OutOfMemory;
+            return PageFaultResponse::Continue;
+        }
 
-    if (result.is_error()) {
-        dmesgln("handle_inode_fault: Error ({}) while reading from inode", result.error());
-        return PageFaultResponse::ShouldCrash;
-    }
+        // Private mappings get their own copy, since they may write to it.
+        MM.copy_physical_page(cached_page, page_buffer);
+    } else {
+        auto buffer = UserOrKernelBuffer::for_kernel_buffer(page_buffer);
+        auto result = inode.read_bytes(page_index_in_vmobject * PAGE_SIZE, PAGE_SIZE, buffer, nullptr);
+
+        if (result.is_error()) {
+            dmesgln("handle_inode_fault: Error ({}) while reading from inode", result.error());
+            return PageFaultResponse::ShouldCrash;
+        }
 
-    auto nread = result.value();
-    if (nread < PAGE_SIZE) {
-        // If we read less than a page, zero out the rest to avoid leaking uninitialized data.
-        memset(page_buffer + nread, 0, PAGE_SIZE - nread);
+        auto nread = result.value();
+        if (nread < PAGE_SIZE) {
+            // If we read less than a page, zero out the rest to avoid leaking uninitialized data.
+            memset(page_buffer + nread, 0, PAGE_SIZE - nread);
+        }
     }
 
     SpinlockLocker locker(inode_vmobject.m_lock);
@@ -9,6 +9,7 @@
 #include <AK/EnumBits.h>
 #include <AK/IntrusiveList.h>
 #include <AK/IntrusiveRedBlackTree.h>
+#include <AK/Optional.h>
 #include <AK/Weakable.h>
 #include <Kernel/Forward.h>
 #include <Kernel/KString.h>
@@ -87,6 +88,10 @@ public:
     [[nodiscard]] bool is_mmap() const { return m_mmap; }
     void set_mmap(bool mmap) { m_mmap = mmap; }
 
+    // Whether aligned 2 MiB chunks of this region may be backed and mapped by large pages.
+    [[nodiscard]] bool are_large_pages_allowed() const { return m_large_pages_allowed; }
+    void set_large_pages_allowed(bool allowed) { m_large_pages_allowed = allowed; }
+
     [[nodiscard]] bool is_user() const { return !is_kernel(); }
     [[nodiscard]] bool is_kernel() const { return vaddr().get() < USER_RANGE_BASE || vaddr().get() >= kernel_mapping_base; }
 
@@ -175,6 +180,9 @@ public:
 
     void set_page_directory(PageDirectory&);
     ErrorOr<void> map(PageDirectory&, ShouldFlushTLB = ShouldFlushTLB::Yes);
+    // Puts the region into a page directory without creating any page table entries.
+    // Every page then gets mapped by handle_fault() once it's accessed for the first time.
+    void map_lazily(PageDirectory&);
     enum class ShouldDeallocateVirtualRange {
         No,
         Yes,
@@ -209,6 +217,10 @@ private:
 
     [[nodiscard]] bool map_individual_page_impl(size_t page_index);
 
+    [[nodiscard]] Optional<size_t> first_page_index_of_large_page(size_t page_index) const;
+    [[nodiscard]] bool can_map_large_page(size_t first_page_index) const;
+    void map_large_page_impl(size_t first_page_index);
+
     RefPtr<PageDirectory> m_page_directory;
     VirtualRange m_range;
     size_t m_offset_in_vmobject { 0 };
@@ -220,6 +232,7 @@ private:
     bool m_stack : 1 { false };
     bool m_mmap : 1 { false };
     bool m_syscall_region : 1 { false };
+    bool m_large_pages_allowed : 1 { false };
 
     IntrusiveRedBlackTreeNode<FlatPtr, Region, RawPtr<Region>> m_tree_node;
     IntrusiveListNode<Region> m_vmobject_list_node;
@@ -27,6 +27,7 @@
 namespace Kernel {
 
 static Singleton<MutexProtected<IPv4Socket::List>> s_all_sockets;
+static Singleton<MutexProtected<Array<IPv4Socket::RawList, 256>>> s_raw_sockets_by_protocol;
 
 using BlockFlags = Thread::OpenFileDescriptionBlocker::BlockFlags;
 
@@ -35,9 +36,14 @@ MutexProtected<IPv4Socket::List>& IPv4Socket::all_sockets()
     return *s_all_sockets;
 }
 
+MutexProtected<Array<IPv4Socket::RawList, 256>>& IPv4Socket::raw_sockets_by_protocol()
+{
+    return *s_raw_sockets_by_protocol;
+}
+
 ErrorOr<NonnullOwnPtr<DoubleBuffer>> IPv4Socket::try_create_receive_buffer()
 {
-    return DoubleBuffer::try_create(256 * KiB);
+    return DoubleBuffer::try_create(receive_buffer_size);
 }
 
 ErrorOr<NonnullRefPtr<Socket>> IPv4Socket::create(int type, int protocol)
@@ -71,6 +77,12 @@ IPv4Socket::IPv4Socket(int type, int protocol, NonnullOwnPtr<DoubleBuffer> recei
     all_sockets().with_exclusive([&](auto& table) {
         table.append(*this);
     });
+
+    if (type == SOCK_RAW && protocol >= 0 && protocol < 256) {
+        raw_sockets_by_protocol().with_exclusive([&](auto& table) {
+            table[protocol].append(*this);
+        });
+    }
 }
 
 IPv4Socket::~IPv4Socket()
@@ -78,6 +90,12 @@ IPv4Socket::~IPv4Socket()
     all_sockets().with_exclusive([&](auto& table) {
         table.remove(*this);
     });
+
+    if (m_raw_list_node.is_in_list()) {
+        raw_sockets_by_protocol().with_exclusive([&](auto& table) {
+            table[protocol()].remove(*this);
+        });
+    }
 }
 
 void IPv4Socket::get_local_address(sockaddr* address, socklen_t* address_size)
@@ -282,6 +300,9 @@ ErrorOr<size_t> IPv4Socket::receive_byte_buffered(OpenFileDescription& descripti
         Thread::current()->did_ipv4_socket_read(nreceived_or_error.value());
 
     set_can_read(!m_receive_buffer->is_empty());
+
+    if (!nreceived_or_error.is_error() && nreceived_or_error.value() > 0 && !(flags & MSG_PEEK))
+        protocol_did_read(nreceived_or_error.value());
     return nreceived_or_error;
 }
 
@@ -425,8 +446,12 @@ bool IPv4Socket::did_receive(const IPv4Address& source_address, u16 source_port,
     if (buffer_mode() == BufferMode::Bytes) {
         VERIFY(m_receive_buffer);
 
+        // NOTE: Only the payload ends up in the receive buffer, and that is what the peer was told it may send.
+        auto payload_size_or_error = protocol_size(packet);
+        if (payload_size_or_error.is_error())
+            return false;
         size_t space_in_receive_buffer = m_receive_buffer->space_for_writing();
-        if (packet_size > space_in_receive_buffer) {
+        if (payload_size_or_error.value() > space_in_receive_buffer) {
             dbgln("IPv4Socket({}): did_receive refusing packet since buffer is full.", this);
             VERIFY(m_can_read);
             return false;
@@ -6,6 +6,7 @@
 
 #pragma once
 
+#include <AK/Array.h>
 #include <AK/HashMap.h>
 #include <AK/SinglyLinkedListWithCount.h>
 #include <Kernel/DoubleBuffer.h>
@@ -86,14 +87,18 @@ protected:
     virtual ErrorOr<u16> protocol_allocate_local_port() { return ENOPROTOOPT; }
     virtual ErrorOr<size_t> protocol_size(ReadonlyBytes /* raw_ipv4_packet */) { return ENOTIMPL; }
     virtual bool protocol_is_disconnected() const { return false; }
+    // Called after the application took bytes out of the receive buffer.
+    virtual void protocol_did_read(size_t) { }
 
     virtual void shut_down_for_reading() override;
 
     void set_local_address(IPv4Address address) { m_local_address = address; }
     void set_peer_address(IPv4Address address) { m_peer_address = address; }
 
+    static constexpr size_t receive_buffer_size = 256 * KiB;
     static ErrorOr<NonnullOwnPtr<DoubleBuffer>> try_create_receive_buffer();
     void drop_receive_buffer();
+    size_t receive_buffer_space() const { return m_receive_buffer ? m_receive_buffer->space_for_writing() : 0; }
 
 private:
     virtual bool is_ipv4() const override { return true; }
@@ -135,11 +140,15 @@ private:
     OwnPtr<KBuffer> m_scratch_buffer;
 
     IntrusiveListNode<IPv4Socket> m_list_node;
+    IntrusiveListNode<IPv4Socket> m_raw_list_node;
 
 public:
     using List = IntrusiveList<&IPv4Socket::m_list_node>;
+    using RawList = IntrusiveList<&IPv4Socket::m_raw_list_node>;
 
     static MutexProtected<IPv4Socket::List>& all_sockets();
+    // SOCK_RAW sockets, indexed by their IP protocol number.
+    static MutexProtected<Array<IPv4Socket::RawList, 256>>& raw_sockets_by_protocol();
 };
 
 }
@@ -4,7 +4,6 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
-#include <Kernel/Arch/x86/InterruptDisabler.h>
 #include <Kernel/Heap/kmalloc.h>
 #include <Kernel/Net/EtherType.h>
 #include <Kernel/Net/NetworkAdapter.h>
@@ -23,11 +22,25 @@ NetworkAdapter::~NetworkAdapter()
 {
 }
 
-void NetworkAdapter::send_packet(ReadonlyBytes packet)
+bool NetworkAdapter::supports_offloads(TransmitOffloads const& offloads) const
+{
+    if (offloads.tcp_checksum && !has_tcp_checksum_offload())
+        return false;
+    if (offloads.tcp_segment_size != 0 && tcp_segmentation_offload_size() == 0)
+        return false;
+    return true;
+}
+
+void NetworkAdapter::send_packet(ReadonlyBytes packet, TransmitOffloads const& offloads)
 {
     m_packets_out++;
     m_bytes_out += packet.size();
-    send_raw(packet);
+    if (offloads.is_empty()) {
+        send_raw(packet);
+        return;
+    }
+    VERIFY(supports_offloads(offloads));
+    send_raw_with_offloads(packet, offloads);
 }
 
 void NetworkAdapter::send(const MACAddress& destination, const ARPPacket& packet)
@@ -49,7 +62,9 @@ void NetworkAdapter::send(const MACAddress& destination, const ARPPacket& packet
 void NetworkAdapter::fill_in_ipv4_header(PacketWithTimestamp& packet, IPv4Address const& source_ipv4, MACAddress const& destination_mac, IPv4Address const& destination_ipv4, IPv4Protocol protocol, size_t payload_size, u8 type_of_service, u8 ttl)
 {
     size_t ipv4_packet_size = sizeof(IPv4Packet) + payload_size;
-    VERIFY(ipv4_packet_size <= mtu());
+    // NOTE: TCP packets may be larger than the MTU if the adapter segments them for us.
+    VERIFY(ipv4_packet_size <= mtu() || (protocol == IPv4Protocol::TCP && tcp_segmentation_offload_size() != 0));
+    VERIFY(ipv4_packet_size <= NumericLimits<u16>::max());
 
     size_t ethernet_frame_size = ipv4_payload_offset() + payload_size;
     VERIFY(packet.buffer->size() == ethernet_frame_size);
@@ -71,70 +86,108 @@ void NetworkAdapter::fill_in_ipv4_header(PacketWithTimestamp& packet, IPv4Addres
     ipv4.set_checksum(ipv4.compute_checksum());
 }
 
+void NetworkAdapter::set_receive_queue_count(size_t count)
+{
+    VERIFY(count > 0 && count <= max_receive_queues);
+    SpinlockLocker locker(m_packet_lock);
+    VERIFY(m_queued_packets == 0);
+    m_receive_queue_count = count;
+}
+
+size_t NetworkAdapter::receive_queue_for(ReadonlyBytes frame) const
+{
+    if (m_receive_queue_count == 1)
+        return 0;
+    if (frame.size() < sizeof(EthernetFrameHeader) + sizeof(IPv4Packet))
+        return 0;
+    auto& eth = *(EthernetFrameHeader const*)frame.data();
+    if (eth.ether_type() != EtherType::IPv4)
+        return 0;
+
+    // Like receive side scaling, hash the addresses and ports of the flow, but leave out the ports
+    // for fragments and protocols without them.
+    auto& ipv4 = *(IPv4Packet const*)eth.payload();
+    u32 hash = pair_int_hash(ipv4.source().to_u32(), ipv4.destination().to_u32());
+    auto protocol = (IPv4Protocol)ipv4.protocol();
+    bool has_ports = (protocol == IPv4Protocol::TCP || protocol == IPv4Protocol::UDP) && !ipv4.is_a_fragment();
+    if (has_ports && frame.size() >= sizeof(EthernetFrameHeader) + sizeof(IPv4Packet) + sizeof(u32)) {
+        u32 ports;
+        memcpy(&ports, ipv4.payload(), sizeof(ports));
+        hash = pair_int_hash(hash, ports);
+    }
+    return hash % m_receive_queue_count;
+}
+
 void NetworkAdapter::did_receive(ReadonlyBytes payload)
 {
-    InterruptDisabler disabler;
     m_packets_in++;
     m_bytes_in += payload.size();
 
-    if (m_packet_queue_size == max_packet_buffers) {
-        // FIXME: Keep track of the number of dropped packets
-        return;
-    }
-
     auto packet = acquire_packet_buffer(payload.size());
     if (!packet) {
         dbgln("Discarding packet because we're out of memory");
+        m_packets_dropped++;
         return;
     }
 
     memcpy(packet->buffer->data(), payload.data(), payload.size());
 
-    m_packet_queue.append(*packet);
-    m_packet_queue_size++;
+    bool queue_was_empty;
+    size_t queue_index;
+    {
+        SpinlockLocker locker(m_packet_lock);
+        if (m_queued_packets == max_packet_buffers) {
+            m_unused_packets.append(*packet);
+            m_packets_dropped++;
+            return;
+        }
+        queue_index = receive_queue_for(payload);
+        auto& queue = m_receive_queues[queue_index];
+        queue_was_empty = queue.is_empty();
+        queue.append(*packet);
+        m_queued_packets++;
+    }
 
-    if (on_receive)
-        on_receive();
+    // Whoever drains the queue keeps going until it is empty, so a burst of frames from one
+    // interrupt only causes a single wakeup.
+    if (queue_was_empty && on_receive)
+        on_receive(queue_index);
 }
 
-size_t NetworkAdapter::dequeue_packet(u8* buffer, size_t buffer_size, Time& packet_timestamp)
+size_t NetworkAdapter::dequeue_packet(size_t queue_index, u8* buffer, size_t buffer_size, Time& packet_timestamp)
 {
-    InterruptDisabler disabler;
-    if (m_packet_queue.is_empty())
+    VERIFY(queue_index < m_receive_queue_count);
+    SpinlockLocker locker(m_packet_lock);
+    auto& queue = m_receive_queues[queue_index];
+    if (queue.is_empty())
         return 0;
-    auto packet_with_timestamp = m_packet_queue.take_first();
-    m_packet_queue_size--;
+    auto packet_with_timestamp = queue.take_first();
+    m_queued_packets--;
     packet_timestamp = packet_with_timestamp->timestamp;
     auto& packet_buffer = packet_with_timestamp->buffer;
     size_t packet_size = packet_buffer->size();
     VERIFY(packet_size <= buffer_size);
     memcpy(buffer, packet_buffer->data(), packet_size);
-    release_packet_buffer(*packet_with_timestamp);
+    m_unused_packets.append(*packet_with_timestamp);
     return packet_size;
 }
 
 RefPtr<PacketWithTimestamp> NetworkAdapter::acquire_packet_buffer(size_t size)
 {
-    InterruptDisabler disabler;
-    if (m_unused_packets.is_empty()) {
-        auto buffer_or_error = KBuffer::try_create_with_size(size, Memory::Region::Access::ReadWrite, "Packet Buffer", AllocationStrategy::AllocateNow);
-        if (buffer_or_error.is_error())
-            return {};
-        auto buffer = buffer_or_error.release_value();
-        auto packet = adopt_ref_if_nonnull(new (nothrow) PacketWithTimestamp { move(buffer), kgettimeofday() });
-        if (!packet)
-            return {};
-        packet->buffer->set_size(size);
-        return packet;
+    RefPtr<PacketWithTimestamp> packet;
+    {
+        SpinlockLocker locker(m_packet_lock);
+        if (!m_unused_packets.is_empty())
+            packet = m_unused_packets.take_first();
     }
 
-    auto packet = m_unused_packets.take_first();
-    if (packet->buffer->capacity() >= size) {
+    if (packet && packet->buffer->capacity() >= size) {
         packet->timestamp = kgettimeofday();
         packet->buffer->set_size(size);
         return packet;
     }
 
+    // NOTE: The buffer is allocated without holding the lock, as that might have to wait for memory.
     auto buffer_or_error = KBuffer::try_create_with_size(size, Memory::Region::Access::ReadWrite, "Packet Buffer", AllocationStrategy::AllocateNow);
     if (buffer_or_error.is_error())
         return {};
@@ -147,7 +200,7 @@ RefPtr<PacketWithTimestamp> NetworkAdapter::acquire_packet_buffer(size_t size)
 
 void NetworkAdapter::release_packet_buffer(PacketWithTimestamp& packet)
 {
-    InterruptDisabler disabler;
+    SpinlockLocker locker(m_packet_lock);
     m_unused_packets.append(packet);
 }
 
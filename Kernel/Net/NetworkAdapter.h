@@ -6,6 +6,7 @@
 
 #pragma once
 
+#include <AK/Array.h>
 #include <AK/ByteBuffer.h>
 #include <AK/Function.h>
 #include <AK/IntrusiveList.h>
@@ -15,6 +16,7 @@
 #include <AK/Weakable.h>
 #include <Kernel/Bus/PCI/Definitions.h>
 #include <Kernel/KBuffer.h>
+#include <Kernel/Locking/Spinlock.h>
 #include <Kernel/Net/ARP.h>
 #include <Kernel/Net/EthernetFrameHeader.h>
 #include <Kernel/Net/ICMP.h>
@@ -41,6 +43,16 @@ struct PacketWithTimestamp : public RefCounted<PacketWithTimestamp> {
     IntrusiveListNode<PacketWithTimestamp, RefPtr<PacketWithTimestamp>> packet_node;
 };
 
+// Work that an outgoing packet leaves to the adapter.
+struct TransmitOffloads {
+    // The TCP checksum field only holds the checksum of the pseudo header.
+    bool tcp_checksum { false };
+    // If non-zero, the TCP payload is cut into segments of this size, each of which gets its own headers.
+    u16 tcp_segment_size { 0 };
+
+    bool is_empty() const { return !tcp_checksum && tcp_segment_size == 0; }
+};
+
 class NetworkAdapter : public RefCounted<NetworkAdapter>
     , public Weakable<NetworkAdapter> {
 public:
@@ -71,17 +83,28 @@ public:
     void send(const MACAddress&, const ARPPacket&);
     void fill_in_ipv4_header(PacketWithTimestamp&, IPv4Address const&, MACAddress const&, IPv4Address const&, IPv4Protocol, size_t, u8 type_of_service, u8 ttl);
 
-    size_t dequeue_packet(u8* buffer, size_t buffer_size, Time& packet_timestamp);
+    // Received frames are spread over this many queues by a hash of their flow, so that all frames
+    // of one connection end up in the same queue, in order.
+    static constexpr size_t max_receive_queues = 8;
+    void set_receive_queue_count(size_t);
+    size_t receive_queue_count() const { return m_receive_queue_count; }
 
-    bool has_queued_packets() const { return !m_packet_queue.is_empty(); }
+    size_t dequeue_packet(size_t queue_index, u8* buffer, size_t buffer_size, Time& packet_timestamp);
 
     u32 mtu() const { return m_mtu; }
     void set_mtu(u32 mtu) { m_mtu = mtu; }
 
+    virtual bool has_tcp_checksum_offload() const { return false; }
+    // The largest TCP payload the adapter can segment by itself, or 0 if it can't.
+    // Adapters that can do this also have to offload the TCP checksum.
+    virtual size_t tcp_segmentation_offload_size() const { return 0; }
+    bool supports_offloads(TransmitOffloads const&) const;
+
     u32 packets_in() const { return m_packets_in; }
     u32 bytes_in() const { return m_bytes_in; }
     u32 packets_out() const { return m_packets_out; }
     u32 bytes_out() const { return m_bytes_out; }
+    u32 packets_dropped() const { return m_packets_dropped; }
 
     RefPtr<PacketWithTimestamp> acquire_packet_buffer(size_t);
     void release_packet_buffer(PacketWithTimestamp&);
@@ -89,15 +112,18 @@ public:
     constexpr size_t layer3_payload_offset() const { return sizeof(EthernetFrameHeader); }
     constexpr size_t ipv4_payload_offset() const { return layer3_payload_offset() + sizeof(IPv4Packet); }
 
-    Function<void()> on_receive;
+    // Called when a receive queue goes from empty to non-empty, possibly in IRQ context.
+    Function<void(size_t queue_index)> on_receive;
 
-    void send_packet(ReadonlyBytes);
+    void send_packet(ReadonlyBytes, TransmitOffloads const& = {});
 
 protected:
     NetworkAdapter(NonnullOwnPtr<KString>);
     void set_mac_address(const MACAddress& mac_address) { m_mac_address = mac_address; }
     void did_receive(ReadonlyBytes);
     virtual void send_raw(ReadonlyBytes) = 0;
+    // Only called with offloads that the adapter supports.
+    virtual void send_raw_with_offloads(ReadonlyBytes, TransmitOffloads const&) { VERIFY_NOT_REACHED(); }
 
 private:
     MACAddress m_mac_address;
@@ -110,14 +136,19 @@ private:
 
     using PacketList = IntrusiveList<&PacketWithTimestamp::packet_node>;
 
-    PacketList m_packet_queue;
-    size_t m_packet_queue_size { 0 };
+    size_t receive_queue_for(ReadonlyBytes frame) const;
+
+    Spinlock m_packet_lock;
+    Array<PacketList, max_receive_queues> m_receive_queues;
+    size_t m_receive_queue_count { 1 };
+    size_t m_queued_packets { 0 };
     PacketList m_unused_packets;
     NonnullOwnPtr<KString> m_name;
     u32 m_packets_in { 0 };
     u32 m_bytes_in { 0 };
     u32 m_packets_out { 0 };
     u32 m_bytes_out { 0 };
+    u32 m_packets_dropped { 0 };
     u32 m_mtu { 1500 };
 };
 
@@ -4,6 +4,8 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/Array.h>
+#include <Kernel/Arch/x86/Processor.h>
 #include <Kernel/Debug.h>
 #include <Kernel/Locking/Mutex.h>
 #include <Kernel/Locking/MutexProtected.h>
@@ -22,6 +24,7 @@
 #include <Kernel/Net/UDP.h>
 #include <Kernel/Net/UDPSocket.h>
 #include <Kernel/Process.h>
+#include <Kernel/Scheduler.h>
 
 namespace Kernel {
 
@@ -35,32 +38,30 @@ static void send_tcp_rst(IPv4Packet const& ipv4_packet, TCPPacket const& tcp_pac
 static void flush_delayed_tcp_acks();
 static void retransmit_tcp_packets();
 
-static Thread* network_task = nullptr;
-static HashTable<RefPtr<TCPSocket>>* delayed_ack_sockets;
+// Received frames are spread over one worker per scheduled CPU (up to the number of receive queues an adapter
+// has), by a hash of their flow. All frames of a connection are thus handled by the same worker, in order.
+struct NetworkWorker {
+    size_t index { 0 };
+    Thread* thread { nullptr };
+    WaitQueue packet_wait_queue;
+    HashTable<RefPtr<TCPSocket>> delayed_ack_sockets;
+};
 
-[[noreturn]] static void NetworkTask_main(void*);
+static Array<NetworkWorker, NetworkAdapter::max_receive_queues>* s_workers;
+static size_t s_worker_count;
 
-void NetworkTask::spawn()
-{
-    RefPtr<Thread> thread;
-    auto name = KString::try_create("NetworkTask");
-    if (name.is_error())
-        TODO();
-    (void)Process::create_kernel_process(thread, name.release_value(), NetworkTask_main, nullptr);
-    network_task = thread;
-}
+// The number of frames a worker takes from one adapter before looking at the others.
+static constexpr size_t receive_batch_size = 64;
 
-bool NetworkTask::is_current()
-{
-    return Thread::current() == network_task;
-}
+[[noreturn]] static void NetworkTask_main(void*);
+static void handle_frame(u8 const* buffer, size_t frame_size, Time const& packet_timestamp);
 
-void NetworkTask_main(void*)
+void NetworkTask::spawn()
 {
-    delayed_ack_sockets = new HashTable<RefPtr<TCPSocket>>;
+    s_workers = new Array<NetworkWorker, NetworkAdapter::max_receive_queues>;
+    // NOTE: Workers are pinned to their CPU, so there can only be as many as there are CPUs that actually schedule threads.
+    s_worker_count = min(static_cast<size_t>(Scheduler::scheduled_processor_count()), NetworkAdapter::max_receive_queues);
 
-    WaitQueue packet_wait_queue;
-    int pending_packets = 0;
     NetworkingManagement::the().for_each([&](auto& adapter) {
         dmesgln("NetworkTask: {} network adapter found: hw={}", adapter.class_name(), adapter.mac_address().to_string());
 
@@ -70,27 +71,53 @@ void NetworkTask_main(void*)
             adapter.set_ipv4_gateway({ 0, 0, 0, 0 });
         }
 
-        adapter.on_receive = [&]() {
-            pending_packets++;
-            packet_wait_queue.wake_all();
+        adapter.set_receive_queue_count(s_worker_count);
+        adapter.on_receive = [](size_t queue_index) {
+            (*s_workers)[queue_index].packet_wait_queue.wake_all();
         };
     });
 
-    auto dequeue_packet = [&pending_packets](u8* buffer, size_t buffer_size, Time& packet_timestamp) -> size_t {
-        if (pending_packets == 0)
-            return 0;
-        size_t packet_size = 0;
-        NetworkingManagement::the().for_each([&](auto& adapter) {
-            if (packet_size || !adapter.has_queued_packets())
-                return;
-            packet_size = adapter.dequeue_packet(buffer, buffer_size, packet_timestamp);
-            pending_packets--;
-            dbgln_if(NETWORK_TASK_DEBUG, "NetworkTask: Dequeued packet from {} ({} bytes)", adapter.name(), packet_size);
-        });
-        return packet_size;
-    };
+    for (size_t i = 0; i < s_worker_count; ++i) {
+        auto& worker = (*s_workers)[i];
+        worker.index = i;
+        RefPtr<Thread> thread;
+        auto name = KString::formatted("NetworkTask {}", i);
+        if (name.is_error())
+            TODO();
+        (void)Process::create_kernel_process(thread, name.release_value(), NetworkTask_main, &worker, 1u << i);
+    }
+}
+
+static NetworkWorker* current_worker()
+{
+    if (!s_workers)
+        return nullptr;
+    auto* current_thread = Thread::current();
+    for (size_t i = 0; i < s_worker_count; ++i) {
+        if ((*s_workers)[i].thread == current_thread)
+            return &(*s_workers)[i];
+    }
+    return nullptr;
+}
+
+bool NetworkTask::is_current()
+{
+    return current_worker() != nullptr;
+}
+
+void NetworkTask_main(void* data)
+{
+    auto& worker = *static_cast<NetworkWorker*>(data);
+    worker.thread = Thread::current();
 
-    size_t buffer_size = 64 * KiB;
+    // The set of adapters doesn't change after boot, and only these got a receive queue for us.
+    NonnullRefPtrVector<NetworkAdapter> adapters;
+    NetworkingManagement::the().for_each([&](auto& adapter) {
+        adapters.append(adapter);
+    });
+
+    // NOTE: Adapters with large receive offload hand us IPv4 packets of up to 64 KiB plus the link layer header.
+    size_t buffer_size = 68 * KiB;
     auto region_or_error = MM.allocate_kernel_region(buffer_size, "Kernel Packet Buffer", Memory::Region::Access::ReadWrite);
     if (region_or_error.is_error())
         TODO();
@@ -100,34 +127,53 @@ void NetworkTask_main(void*)
 
     for (;;) {
         flush_delayed_tcp_acks();
-        retransmit_tcp_packets();
-        size_t packet_size = dequeue_packet(buffer, buffer_size, packet_timestamp);
-        if (!packet_size) {
-            auto timeout_time = Time::from_milliseconds(500);
-            auto timeout = Thread::BlockTimeout { false, &timeout_time };
-            [[maybe_unused]] auto result = packet_wait_queue.wait_on(timeout, "NetworkTask");
-            continue;
+        // Retransmissions aren't tied to any received frame, so only the first worker looks after them.
+        if (worker.index == 0)
+            retransmit_tcp_packets();
+
+        size_t handled_frames = 0;
+        for (auto& adapter : adapters) {
+            for (size_t i = 0; i < receive_batch_size; ++i) {
+                size_t packet_size = adapter.dequeue_packet(worker.index, buffer, buffer_size, packet_timestamp);
+                if (!packet_size)
+                    break;
+                dbgln_if(NETWORK_TASK_DEBUG, "NetworkTask: Dequeued packet from {} ({} bytes)", adapter.name(), packet_size);
+                handle_frame(buffer, packet_size, packet_timestamp);
+                ++handled_frames;
+            }
         }
-        if (packet_size < sizeof(EthernetFrameHeader)) {
-            dbgln("NetworkTask: Packet is too small to be an Ethernet packet! ({})", packet_size);
+        if (handled_frames)
             continue;
-        }
-        auto& eth = *(EthernetFrameHeader const*)buffer;
-        dbgln_if(ETHERNET_DEBUG, "NetworkTask: From {} to {}, ether_type={:#04x}, packet_size={}", eth.source().to_string(), eth.destination().to_string(), eth.ether_type(), packet_size);
-
-        switch (eth.ether_type()) {
-        case EtherType::ARP:
-            handle_arp(eth, packet_size);
-            break;
-        case EtherType::IPv4:
-            handle_ipv4(eth, packet_size, packet_timestamp);
-            break;
-        case EtherType::IPv6:
-            // ignore
-            break;
-        default:
-            dbgln_if(ETHERNET_DEBUG, "NetworkTask: Unknown ethernet type {:#04x}", eth.ether_type());
-        }
+
+        // While there's unacknowledged data, wake up often enough to honor short retransmission timeouts.
+        bool has_sockets_for_retransmit = worker.index == 0 && TCPSocket::sockets_for_retransmit().with_shared([](auto& list) { return !list.is_empty(); });
+        auto timeout_time = Time::from_milliseconds(has_sockets_for_retransmit ? 100 : 500);
+        auto timeout = Thread::BlockTimeout { false, &timeout_time };
+        [[maybe_unused]] auto result = worker.packet_wait_queue.wait_on(timeout, "NetworkTask");
+    }
+}
+
+void handle_frame(u8 const* buffer, size_t frame_size, Time const& packet_timestamp)
+{
+    if (frame_size < sizeof(EthernetFrameHeader)) {
+        dbgln("NetworkTask: Packet is too small to be an Ethernet packet! ({})", frame_size);
+        return;
+    }
+    auto& eth = *(EthernetFrameHeader const*)buffer;
+    dbgln_if(ETHERNET_DEBUG, "NetworkTask: From {} to {}, ether_type={:#04x}, packet_size={}", eth.source().to_string(), eth.destination().to_string(), eth.ether_type(), frame_size);
+
+    switch (eth.ether_type()) {
+    case EtherType::ARP:
+        handle_arp(eth, frame_size);
+        break;
+    case EtherType::IPv4:
+        handle_ipv4(eth, frame_size, packet_timestamp);
+        break;
+    case EtherType::IPv6:
+        // ignore
+        break;
+    default:
+        dbgln_if(ETHERNET_DEBUG, "NetworkTask: Unknown ethernet type {:#04x}", eth.ether_type());
     }
 }
 
@@ -230,11 +276,9 @@ void handle_icmp(EthernetFrameHeader const& eth, IPv4Packet const& ipv4_packet,
 
     {
         NonnullRefPtrVector<IPv4Socket> icmp_sockets;
-        IPv4Socket::all_sockets().with_exclusive([&](auto& sockets) {
-            for (auto& socket : sockets) {
-                if (socket.protocol() == (unsigned)IPv4Protocol::ICMP)
-                    icmp_sockets.append(socket);
-            }
+        IPv4Socket::raw_sockets_by_protocol().with_exclusive([&](auto& table) {
+            for (auto& socket : table[(u8)IPv4Protocol::ICMP])
+                icmp_sockets.append(socket);
         });
         for (auto& socket : icmp_sockets)
             socket.did_receive(ipv4_packet.source(), 0, { &ipv4_packet, sizeof(IPv4Packet) + ipv4_packet.payload_size() }, packet_timestamp);
@@ -310,13 +354,15 @@ void send_delayed_tcp_ack(RefPtr<TCPSocket> socket)
         return;
     }
 
-    delayed_ack_sockets->set(move(socket));
+    // All packets of the connection go to the same worker, which is the one handling this one.
+    current_worker()->delayed_ack_sockets.set(move(socket));
 }
 
 void flush_delayed_tcp_acks()
 {
+    auto& delayed_ack_sockets = current_worker()->delayed_ack_sockets;
     Vector<RefPtr<TCPSocket>, 32> remaining_sockets;
-    for (auto& socket : *delayed_ack_sockets) {
+    for (auto& socket : delayed_ack_sockets) {
         MutexLocker locker(socket->mutex());
         if (socket->should_delay_next_ack()) {
             MUST(remaining_sockets.try_append(socket));
@@ -325,12 +371,12 @@ void flush_delayed_tcp_acks()
         [[maybe_unused]] auto result = socket->send_ack();
     }
 
-    if (remaining_sockets.size() != delayed_ack_sockets->size()) {
-        delayed_ack_sockets->clear();
+    if (remaining_sockets.size() != delayed_ack_sockets.size()) {
+        delayed_ack_sockets.clear();
         if (remaining_sockets.size() > 0)
             dbgln("flush_delayed_tcp_acks: {} sockets remaining", remaining_sockets.size());
         for (auto&& socket : remaining_sockets)
-            delayed_ack_sockets->set(move(socket));
+            delayed_ack_sockets.set(move(socket));
     }
 }
 
@@ -459,6 +505,7 @@ void handle_tcp(IPv4Packet const& ipv4_packet, Time const& packet_timestamp)
             dbgln_if(TCP_DEBUG, "handle_tcp: created new client socket with tuple {}", client->tuple().to_string());
             client->set_sequence_number(1000);
             client->set_ack_number(tcp_packet.sequence_number() + payload_size + 1);
+            client->apply_syn_options(tcp_packet);
             [[maybe_unused]] auto rc2 = client->send_tcp_packet(TCPFlags::SYN | TCPFlags::ACK);
             client->set_state(TCPSocket::State::SynReceived);
             return;
@@ -472,11 +519,13 @@ void handle_tcp(IPv4Packet const& ipv4_packet, Time const& packet_timestamp)
         switch (tcp_packet.flags()) {
         case TCPFlags::SYN:
             socket->set_ack_number(tcp_packet.sequence_number() + payload_size + 1);
+            socket->apply_syn_options(tcp_packet);
             (void)socket->send_ack(true);
             socket->set_state(TCPSocket::State::SynReceived);
             return;
         case TCPFlags::ACK | TCPFlags::SYN:
             socket->set_ack_number(tcp_packet.sequence_number() + payload_size + 1);
+            socket->apply_syn_options(tcp_packet);
             (void)socket->send_ack(true);
             socket->set_state(TCPSocket::State::Established);
             socket->set_setup_state(Socket::SetupState::Completed);
@@ -612,17 +661,14 @@ void handle_tcp(IPv4Packet const& ipv4_packet, Time const& packet_timestamp)
         }
 
         if (tcp_packet.sequence_number() != socket->ack_number()) {
-            dbgln_if(TCP_DEBUG, "Discarding out of order packet: seq {} vs. ack {}", tcp_packet.sequence_number(), socket->ack_number());
-            if (socket->duplicate_acks() < TCPSocket::maximum_duplicate_acks) {
-                dbgln_if(TCP_DEBUG, "Sending ACK with same ack number to trigger fast retransmission");
-                socket->set_duplicate_acks(socket->duplicate_acks() + 1);
-                [[maybe_unused]] auto result = socket->send_ack(true);
-            }
+            dbgln_if(TCP_DEBUG, "Queueing out of order packet: seq {} vs. ack {}", tcp_packet.sequence_number(), socket->ack_number());
+            if (!tcp_packet.has_fin())
+                socket->queue_out_of_order_segment(ipv4_packet, tcp_packet, payload_size);
+            // RFC 5681, 4.2: Send a duplicate ACK right away, so the peer can start fast retransmission.
+            [[maybe_unused]] auto result = socket->send_ack(true);
             return;
         }
 
-        socket->set_duplicate_acks(0);
-
         if (tcp_packet.has_fin()) {
             if (payload_size != 0)
                 socket->did_receive(ipv4_packet.source(), tcp_packet.source_port(), { &ipv4_packet, sizeof(IPv4Packet) + ipv4_packet.payload_size() }, packet_timestamp);
@@ -639,7 +685,16 @@ void handle_tcp(IPv4Packet const& ipv4_packet, Time const& packet_timestamp)
                 socket->set_ack_number(tcp_packet.sequence_number() + payload_size);
                 dbgln_if(TCP_DEBUG, "Got packet with ack_no={}, seq_no={}, payload_size={}, acking it with new ack_no={}, seq_no={}",
                     tcp_packet.ack_number(), tcp_packet.sequence_number(), payload_size, socket->ack_number(), socket->sequence_number());
-                send_delayed_tcp_ack(socket);
+                if (socket->has_out_of_order_segments()) {
+                    // This filled a hole, so let the peer know right away how far we've got.
+                    socket->deliver_out_of_order_segments(packet_timestamp);
+                    [[maybe_unused]] auto result = socket->send_ack(true);
+                } else {
+                    send_delayed_tcp_ack(socket);
+                }
+            } else {
+                // The receive buffer is full. Tell the peer about our window, so it knows to back off.
+                [[maybe_unused]] auto result = socket->send_ack(true);
             }
         }
     }
@@ -18,6 +18,7 @@
 #include <Kernel/Net/NetworkingManagement.h>
 #include <Kernel/Net/Realtek/RTL8139NetworkAdapter.h>
 #include <Kernel/Net/Realtek/RTL8168NetworkAdapter.h>
+#include <Kernel/Net/VirtIO/VirtIONetworkAdapter.h>
 #include <Kernel/Sections.h>
 
 namespace Kernel {
@@ -45,14 +46,14 @@ NonnullRefPtr<NetworkAdapter> NetworkingManagement::loopback_adapter() const
 
 void NetworkingManagement::for_each(Function<void(NetworkAdapter&)> callback)
 {
-    MutexLocker locker(m_lock);
+    MutexLocker locker(m_lock, Mutex::Mode::Shared);
     for (auto& it : m_adapters)
         callback(it);
 }
 
 RefPtr<NetworkAdapter> NetworkingManagement::from_ipv4_address(const IPv4Address& address) const
 {
-    MutexLocker locker(m_lock);
+    MutexLocker locker(m_lock, Mutex::Mode::Shared);
     for (auto& adapter : m_adapters) {
         if (adapter.ipv4_address() == address || adapter.ipv4_broadcast() == address)
             return adapter;
@@ -65,7 +66,7 @@ RefPtr<NetworkAdapter> NetworkingManagement::from_ipv4_address(const IPv4Address
 }
 RefPtr<NetworkAdapter> NetworkingManagement::lookup_by_name(StringView name) const
 {
-    MutexLocker locker(m_lock);
+    MutexLocker locker(m_lock, Mutex::Mode::Shared);
     RefPtr<NetworkAdapter> found_adapter;
     for (auto& it : m_adapters) {
         if (it.name() == name)
@@ -95,6 +96,8 @@ UNMAP_AFTER_INIT RefPtr<NetworkAdapter> NetworkingManagement::determine_network_
         return candidate;
     if (auto candidate = NE2000NetworkAdapter::try_to_initialize(device_identifier); !candidate.is_null())
         return candidate;
+    if (auto candidate = VirtIONetworkAdapter::try_to_initialize(device_identifier); !candidate.is_null())
+        return candidate;
     return {};
 }
 
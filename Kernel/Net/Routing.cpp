@@ -112,6 +112,17 @@ MutexProtected<HashMap<IPv4Address, MACAddress>>& arp_table()
 
 void update_arp_table(IPv4Address const& ip_addr, MACAddress const& addr, UpdateArp update)
 {
+    // Every received IPv4 packet refreshes the entry of its sender, which almost never changes.
+    // Don't make the network workers contend on the exclusive lock for that.
+    if (update == UpdateArp::Set) {
+        bool is_unchanged = arp_table().with_shared([&](auto const& table) {
+            auto entry = table.get(ip_addr);
+            return entry.has_value() && entry.value() == addr;
+        });
+        if (is_unchanged)
+            return;
+    }
+
     arp_table().with_exclusive([&](auto& table) {
         if (update == UpdateArp::Set)
             table.set(ip_addr, addr);
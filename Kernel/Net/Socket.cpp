@@ -48,7 +48,7 @@ void Socket::set_setup_state(SetupState new_setup_state)
     evaluate_block_conditions();
 }
 
-RefPtr<Socket> Socket::accept()
+RefPtr<Socket> Socket::accept(Process const& acceptor)
 {
     MutexLocker locker(mutex());
     if (m_pending.is_empty())
@@ -56,8 +56,7 @@ RefPtr<Socket> Socket::accept()
     dbgln_if(SOCKET_DEBUG, "Socket({}) de-queueing connection", this);
     auto client = m_pending.take_first();
     VERIFY(!client->is_connected());
-    auto& process = Process::current();
-    client->set_acceptor(process);
+    client->set_acceptor(acceptor);
     client->m_connected = true;
     client->set_role(Role::Accepted);
     if (!m_pending.is_empty())
@@ -74,7 +74,7 @@ public:
     void set_connected(bool);
 
     bool can_accept() const { return !m_pending.is_empty(); }
-    RefPtr<Socket> accept();
+    RefPtr<Socket> accept(Process const& acceptor);
 
     ErrorOr<void> shutdown(int how);
 
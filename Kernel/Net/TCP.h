@@ -6,6 +6,7 @@
 
 #pragma once
 
+#include <AK/Span.h>
 #include <AK/StdLibExtras.h>
 #include <Kernel/Net/IPv4.h>
 
@@ -22,6 +23,26 @@ struct TCPFlags {
     };
 };
 
+enum class TCPOptionKind : u8 {
+    End = 0,
+    NOP = 1,
+    MSS = 2,
+    WindowScale = 3,
+    SACKPermitted = 4,
+    SACK = 5,
+};
+
+// Sequence numbers wrap around, so they have to be compared by their distance (RFC 793, 3.3).
+constexpr bool tcp_sequence_number_before(u32 a, u32 b)
+{
+    return static_cast<i32>(a - b) < 0;
+}
+
+constexpr bool tcp_sequence_number_before_or_equal(u32 a, u32 b)
+{
+    return static_cast<i32>(a - b) <= 0;
+}
+
 class [[gnu::packed]] TCPOptionMSS {
 public:
     TCPOptionMSS(u16 value)
@@ -32,13 +53,48 @@ public:
     u16 value() const { return m_value; }
 
 private:
-    u8 m_option_kind { 0x02 };
+    TCPOptionKind m_option_kind { TCPOptionKind::MSS };
     u8 m_option_length { sizeof(TCPOptionMSS) };
     NetworkOrdered<u16> m_value;
 };
 
 static_assert(AssertSize<TCPOptionMSS, 4>());
 
+// RFC 7323, 2.2
+class [[gnu::packed]] TCPOptionWindowScale {
+public:
+    TCPOptionWindowScale(u8 shift_count)
+        : m_shift_count(shift_count)
+    {
+    }
+
+    u8 shift_count() const { return m_shift_count; }
+
+private:
+    TCPOptionKind m_option_kind { TCPOptionKind::WindowScale };
+    u8 m_option_length { sizeof(TCPOptionWindowScale) };
+    u8 m_shift_count { 0 };
+};
+
+static_assert(AssertSize<TCPOptionWindowScale, 3>());
+
+// RFC 2018, 2
+class [[gnu::packed]] TCPOptionSACKPermitted {
+private:
+    TCPOptionKind m_option_kind { TCPOptionKind::SACKPermitted };
+    u8 m_option_length { sizeof(TCPOptionSACKPermitted) };
+};
+
+static_assert(AssertSize<TCPOptionSACKPermitted, 2>());
+
+// RFC 2018, 3: A SACK option is its kind and length, followed by up to four of these.
+struct [[gnu::packed]] TCPSACKBlock {
+    NetworkOrdered<u32> left_edge;
+    NetworkOrdered<u32> right_edge;
+};
+
+static_assert(AssertSize<TCPSACKBlock, 8>());
+
 class [[gnu::packed]] TCPPacket {
 public:
     TCPPacket() = default;
@@ -78,6 +134,8 @@ public:
     u16 urgent() const { return m_urgent; }
     void set_urgent(u16 urgent) { m_urgent = urgent; }
 
+    ReadonlyBytes options() const { return { ((const u8*)this) + sizeof(TCPPacket), header_size() - sizeof(TCPPacket) }; }
+
     const void* payload() const { return ((const u8*)this) + header_size(); }
     void* payload() { return ((u8*)this) + header_size(); }
 
@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/NumericLimits.h>
+#include <Kernel/Net/TCPCongestionControl.h>
+
+namespace Kernel {
+
+// RFC 6928
+static size_t initial_window(size_t maximum_segment_size)
+{
+    return min(10 * maximum_segment_size, max<size_t>(2 * maximum_segment_size, 14600));
+}
+
+ErrorOr<NonnullOwnPtr<TCPCongestionControl>> TCPCongestionControl::try_create(TCPCongestionControlAlgorithm algorithm, size_t maximum_segment_size)
+{
+    switch (algorithm) {
+    case TCPCongestionControlAlgorithm::NewReno:
+        return adopt_nonnull_own_or_enomem<TCPCongestionControl>(new (nothrow) TCPNewReno(maximum_segment_size));
+    case TCPCongestionControlAlgorithm::CUBIC:
+        return adopt_nonnull_own_or_enomem<TCPCongestionControl>(new (nothrow) TCPCubic(maximum_segment_size));
+    }
+    VERIFY_NOT_REACHED();
+}
+
+TCPCongestionControl::TCPCongestionControl(size_t maximum_segment_size)
+    : m_maximum_segment_size(maximum_segment_size)
+    , m_congestion_window(initial_window(maximum_segment_size))
+    , m_slow_start_threshold(NumericLimits<size_t>::max())
+{
+}
+
+void TCPCongestionControl::set_maximum_segment_size(size_t maximum_segment_size)
+{
+    // NOTE: This only happens while the connection is being set up, so nothing has been sent yet.
+    m_maximum_segment_size = maximum_segment_size;
+    m_congestion_window = initial_window(maximum_segment_size);
+}
+
+void TCPCongestionControl::on_ack(size_t acknowledged_bytes, Time const& now, Time const& smoothed_rtt)
+{
+    if (is_in_slow_start()) {
+        // RFC 3465: Count the acknowledged bytes, but no more than one segment per ACK.
+        m_congestion_window += min(acknowledged_bytes, m_maximum_segment_size);
+        return;
+    }
+    on_congestion_avoidance_ack(acknowledged_bytes, now, smoothed_rtt);
+}
+
+void TCPCongestionControl::on_enter_recovery(size_t bytes_in_flight, Time const& now, bool inflate_for_duplicate_acks)
+{
+    m_slow_start_threshold = on_loss(bytes_in_flight, now);
+    m_congestion_window = m_slow_start_threshold;
+    if (inflate_for_duplicate_acks)
+        m_congestion_window += 3 * m_maximum_segment_size;
+    m_pending_increase = 0;
+}
+
+void TCPCongestionControl::on_retransmit_timeout(size_t bytes_in_flight, Time const& now)
+{
+    m_slow_start_threshold = on_loss(bytes_in_flight, now);
+    // RFC 5681, 3.1: Start over from the loss window.
+    m_congestion_window = m_maximum_segment_size;
+    m_pending_increase = 0;
+}
+
+void TCPCongestionControl::increase_congestion_window(u64 increase)
+{
+    m_pending_increase += increase;
+    auto growth = m_pending_increase / m_congestion_window;
+    m_pending_increase -= growth * m_congestion_window;
+    m_congestion_window += growth;
+}
+
+void TCPNewReno::on_congestion_avoidance_ack(size_t acknowledged_bytes, Time const&, Time const&)
+{
+    // RFC 5681, 3.1: About one segment per round trip.
+    increase_congestion_window(static_cast<u64>(m_maximum_segment_size) * acknowledged_bytes);
+}
+
+size_t TCPNewReno::on_loss(size_t bytes_in_flight, Time const&)
+{
+    return max(bytes_in_flight / 2, 2 * m_maximum_segment_size);
+}
+
+// Hacker's Delight, 11-2
+static u64 integer_cube_root(u64 value)
+{
+    u64 root = 0;
+    for (int shift = 63; shift >= 0; shift -= 3) {
+        root *= 2;
+        u64 step = 3 * root * (root + 1) + 1;
+        if ((value >> shift) >= step) {
+            value -= step << shift;
+            ++root;
+        }
+    }
+    return root;
+}
+
+// C = 0.4 and beta = 0.7, as recommended by RFC 8312.
+// Past this many milliseconds away from the origin point the cubic function would overflow,
+// and the window would be clamped to at most 1.5 * cwnd anyways.
+static constexpr i64 max_cubic_time_distance_ms = 100'000;
+
+void TCPCubic::on_congestion_avoidance_ack(size_t acknowledged_bytes, Time const& now, Time const& smoothed_rtt)
+{
+    if (!m_epoch_start.has_value()) {
+        m_epoch_start = now;
+        if (m_congestion_window < m_window_max) {
+            // K = cbrt((W_max - cwnd) / C), in milliseconds and bytes.
+            u64 distance = m_window_max - m_congestion_window;
+            m_time_to_origin_point_ms = static_cast<i64>(integer_cube_root(distance * 2'500'000'000ull / m_maximum_segment_size));
+            m_origin_point = m_window_max;
+        } else {
+            m_time_to_origin_point_ms = 0;
+            m_origin_point = m_congestion_window;
+        }
+    }
+
+    i64 rtt_ms = max<i64>(smoothed_rtt.to_milliseconds(), 1);
+    i64 time_in_epoch_ms = (now - *m_epoch_start).to_milliseconds();
+
+    // W_cubic(t + RTT) = C * (t + RTT - K)^3 + W_max
+    i64 distance_ms = clamp(time_in_epoch_ms + rtt_ms - m_time_to_origin_point_ms, -max_cubic_time_distance_ms, max_cubic_time_distance_ms);
+    i64 offset = (distance_ms * distance_ms * distance_ms / 1000) * 4 * static_cast<i64>(m_maximum_segment_size) / 10'000'000;
+    i64 target = max<i64>(static_cast<i64>(m_origin_point) + offset, static_cast<i64>(m_congestion_window));
+    target = min<i64>(target, static_cast<i64>(m_congestion_window + m_congestion_window / 2));
+
+    // RFC 8312, 4.2: Never grow slower than standard TCP would.
+    // W_est(t) = W_max * beta + 3 * (1 - beta) / (1 + beta) * t / RTT
+    u64 estimated_reno_window = m_window_max * 7 / 10 + 529 * static_cast<u64>(time_in_epoch_ms) * m_maximum_segment_size / (1000 * static_cast<u64>(rtt_ms));
+    if (estimated_reno_window > m_congestion_window) {
+        m_congestion_window = estimated_reno_window;
+        return;
+    }
+
+    if (target > static_cast<i64>(m_congestion_window))
+        increase_congestion_window(static_cast<u64>(target - static_cast<i64>(m_congestion_window)) * acknowledged_bytes);
+    else
+        increase_congestion_window(static_cast<u64>(m_maximum_segment_size) * acknowledged_bytes / 100);
+}
+
+size_t TCPCubic::on_loss(size_t, Time const&)
+{
+    m_epoch_start.clear();
+
+    // RFC 8312, 4.6: Fast convergence lets newer flows claim their share sooner.
+    if (m_congestion_window < m_last_window_max)
+        m_window_max = m_congestion_window * 17 / 20;
+    else
+        m_window_max = m_congestion_window;
+    m_last_window_max = m_congestion_window;
+
+    return max(m_congestion_window * 7 / 10, 2 * m_maximum_segment_size);
+}
+
+}
@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Error.h>
+#include <AK/NonnullOwnPtr.h>
+#include <AK/Optional.h>
+#include <AK/StringView.h>
+#include <AK/Time.h>
+#include <Kernel/CommandLine.h>
+
+namespace Kernel {
+
+// Decides how much unacknowledged data a TCPSocket may have in flight.
+// All windows are in bytes. The socket takes care of detecting loss (duplicate ACKs,
+// SACK and the retransmission timer) and of fast recovery, and only reports the
+// relevant events here.
+class TCPCongestionControl {
+public:
+    static ErrorOr<NonnullOwnPtr<TCPCongestionControl>> try_create(TCPCongestionControlAlgorithm, size_t maximum_segment_size);
+    virtual ~TCPCongestionControl() = default;
+
+    virtual StringView name() const = 0;
+
+    size_t congestion_window() const { return m_congestion_window; }
+    size_t slow_start_threshold() const { return m_slow_start_threshold; }
+    bool is_in_slow_start() const { return m_congestion_window < m_slow_start_threshold; }
+
+    void set_maximum_segment_size(size_t);
+
+    // New data was acknowledged outside of fast recovery.
+    void on_ack(size_t acknowledged_bytes, Time const& now, Time const& smoothed_rtt);
+
+    // Loss was detected by duplicate ACKs or SACK, and fast recovery begins (RFC 5681, 3.2).
+    // Without SACK, the window is inflated by the duplicate ACKs seen so far, and by each further one,
+    // since every one of them means another segment has left the network.
+    void on_enter_recovery(size_t bytes_in_flight, Time const& now, bool inflate_for_duplicate_acks);
+    void on_duplicate_ack_in_recovery() { m_congestion_window += m_maximum_segment_size; }
+    void on_exit_recovery() { m_congestion_window = m_slow_start_threshold; }
+
+    void on_retransmit_timeout(size_t bytes_in_flight, Time const& now);
+
+protected:
+    explicit TCPCongestionControl(size_t maximum_segment_size);
+
+    virtual void on_congestion_avoidance_ack(size_t acknowledged_bytes, Time const& now, Time const& smoothed_rtt) = 0;
+    // Returns the new slow start threshold after a loss.
+    virtual size_t on_loss(size_t bytes_in_flight, Time const& now) = 0;
+
+    // Grows the congestion window by increase / congestion_window bytes, keeping the remainder
+    // around so that many small increments still add up.
+    void increase_congestion_window(u64 increase);
+
+    size_t m_maximum_segment_size { 0 };
+    size_t m_congestion_window { 0 };
+    size_t m_slow_start_threshold { 0 };
+
+private:
+    u64 m_pending_increase { 0 };
+};
+
+// RFC 5681 and RFC 6582: Grow by one segment per round trip, halve on loss.
+class TCPNewReno final : public TCPCongestionControl {
+public:
+    explicit TCPNewReno(size_t maximum_segment_size)
+        : TCPCongestionControl(maximum_segment_size)
+    {
+    }
+
+    virtual StringView name() const override { return "newreno"sv; }
+
+private:
+    virtual void on_congestion_avoidance_ack(size_t acknowledged_bytes, Time const& now, Time const& smoothed_rtt) override;
+    virtual size_t on_loss(size_t bytes_in_flight, Time const& now) override;
+};
+
+// RFC 8312: The window grows along a cubic function of the time since the last loss,
+// which makes it independent of the RTT and quick to recover on high-BDP paths.
+// NOTE: The kernel doesn't use the FPU, so everything here is integer math in milliseconds.
+class TCPCubic final : public TCPCongestionControl {
+public:
+    explicit TCPCubic(size_t maximum_segment_size)
+        : TCPCongestionControl(maximum_segment_size)
+    {
+    }
+
+    virtual StringView name() const override { return "cubic"sv; }
+
+private:
+    virtual void on_congestion_avoidance_ack(size_t acknowledged_bytes, Time const& now, Time const& smoothed_rtt) override;
+    virtual size_t on_loss(size_t bytes_in_flight, Time const& now) override;
+
+    Optional<Time> m_epoch_start;
+    size_t m_window_max { 0 };
+    size_t m_last_window_max { 0 };
+    size_t m_origin_point { 0 };
+    i64 m_time_to_origin_point_ms { 0 };
+};
+
+}
@@ -19,9 +19,42 @@
 #include <Kernel/Net/TCPSocket.h>
 #include <Kernel/Process.h>
 #include <Kernel/Random.h>
+#include <Kernel/Time/TimeManagement.h>
 
 namespace Kernel {
 
+// RFC 6298 asks for at least one second, but like other stacks we go lower so that
+// a lost segment on a fast link doesn't stall the connection for ages.
+static constexpr Time minimum_retransmit_timeout = Time::from_milliseconds(200);
+static constexpr Time maximum_retransmit_timeout = Time::from_seconds(60);
+
+// A TCP header is at most 60 bytes long.
+static constexpr size_t maximum_options_size = 40;
+// RFC 2018, 3: Without the timestamp option, four SACK blocks fit into a header.
+static constexpr size_t maximum_sack_blocks = 4;
+
+template<typename Callback>
+static void for_each_option(TCPPacket const& packet, Callback callback)
+{
+    auto options = packet.options();
+    for (size_t i = 0; i < options.size();) {
+        auto kind = static_cast<TCPOptionKind>(options[i]);
+        if (kind == TCPOptionKind::End)
+            return;
+        if (kind == TCPOptionKind::NOP) {
+            ++i;
+            continue;
+        }
+        if (i + 1 >= options.size())
+            return;
+        u8 length = options[i + 1];
+        if (length < 2 || i + length > options.size())
+            return;
+        callback(kind, options.slice(i + 2, length - 2));
+        i += length;
+    }
+}
+
 void TCPSocket::for_each(Function<void(const TCPSocket&)> callback)
 {
     sockets_by_tuple().for_each_shared([&](const auto& it) {
@@ -153,10 +186,10 @@ void TCPSocket::release_for_accept(RefPtr<TCPSocket> socket)
     [[maybe_unused]] auto rc = queue_connection_from(*socket);
 }
 
-TCPSocket::TCPSocket(int protocol, NonnullOwnPtr<DoubleBuffer> receive_buffer, NonnullOwnPtr<KBuffer> scratch_buffer)
+TCPSocket::TCPSocket(int protocol, NonnullOwnPtr<DoubleBuffer> receive_buffer, NonnullOwnPtr<KBuffer> scratch_buffer, NonnullOwnPtr<TCPCongestionControl> congestion_control)
     : IPv4Socket(SOCK_STREAM, protocol, move(receive_buffer), move(scratch_buffer))
+    , m_congestion_control(move(congestion_control))
 {
-    m_last_retransmit_time = kgettimeofday();
 }
 
 TCPSocket::~TCPSocket()
@@ -170,7 +203,8 @@ ErrorOr<NonnullRefPtr<TCPSocket>> TCPSocket::try_create(int protocol, NonnullOwn
 {
     // Note: Scratch buffer is only used for SOCK_STREAM sockets.
     auto scratch_buffer = TRY(KBuffer::try_create_with_size(65536));
-    return adopt_nonnull_ref_or_enomem(new (nothrow) TCPSocket(protocol, move(receive_buffer), move(scratch_buffer)));
+    auto congestion_control = TRY(TCPCongestionControl::try_create(kernel_command_line().tcp_congestion_control_algorithm(), default_maximum_segment_size));
+    return adopt_nonnull_ref_or_enomem(new (nothrow) TCPSocket(protocol, move(receive_buffer), move(scratch_buffer), move(congestion_control)));
 }
 
 ErrorOr<size_t> TCPSocket::protocol_size(ReadonlyBytes raw_ipv4_packet)
@@ -196,8 +230,18 @@ ErrorOr<size_t> TCPSocket::protocol_send(const UserOrKernelBuffer& data, size_t
     RoutingDecision routing_decision = route_to(peer_address(), local_address(), bound_interface());
     if (routing_decision.is_zero())
         return set_so_error(EHOSTUNREACH);
-    size_t mss = routing_decision.adapter->mtu() - sizeof(IPv4Packet) - sizeof(TCPPacket);
-    data_length = min(data_length, mss);
+    size_t mss = segment_size_for(*routing_decision.adapter);
+    auto window = m_unacked_packets.with_shared([&](auto& unacked_packets) {
+        // With nothing in flight we always send, which doubles as a probe for a closed window.
+        if (unacked_packets.packets.is_empty())
+            return max(available_send_window(unacked_packets), mss);
+        return available_send_window(unacked_packets);
+    });
+    if (window == 0)
+        return set_so_error(EAGAIN);
+    // Adapters with segmentation offload take care of cutting larger packets into MSS-sized segments.
+    auto maximum_packet_payload_size = max(mss, routing_decision.adapter->tcp_segmentation_offload_size());
+    data_length = min(data_length, min(maximum_packet_payload_size, window));
     TRY(send_tcp_packet(TCPFlags::PUSH | TCPFlags::ACK, &data, data_length, &routing_decision));
     return data_length;
 }
@@ -209,6 +253,93 @@ ErrorOr<void> TCPSocket::send_ack(bool allow_duplicate)
     return send_tcp_packet(TCPFlags::ACK);
 }
 
+size_t TCPSocket::segment_size_for(NetworkAdapter const& adapter) const
+{
+    return min(adapter.mtu() - sizeof(IPv4Packet) - sizeof(TCPPacket), m_maximum_segment_size);
+}
+
+u16 TCPSocket::compute_advertised_window(bool is_syn)
+{
+    // NOTE: Out-of-order segments already sit inside the window we advertised earlier, and they take
+    //       up receive buffer space once they're delivered, so the right edge of the window stays put.
+    size_t window = receive_buffer_space();
+    // RFC 7323, 2.2: The window in a SYN segment is never scaled.
+    u8 shift = (!is_syn && m_window_scaling_enabled) ? m_receive_window_scale : 0;
+    auto scaled_window = min<size_t>(window >> shift, NumericLimits<u16>::max());
+    m_last_advertised_window = scaled_window << shift;
+    return scaled_window;
+}
+
+size_t TCPSocket::build_options(u16 flags, size_t payload_size, RoutingDecision const& routing_decision, Bytes options)
+{
+    size_t offset = 0;
+    auto append = [&](auto const& option) {
+        VERIFY(offset + sizeof(option) <= options.size());
+        memcpy(options.offset_pointer(offset), &option, sizeof(option));
+        offset += sizeof(option);
+    };
+    auto append_nop = [&] {
+        options[offset++] = to_underlying(TCPOptionKind::NOP);
+    };
+
+    if (flags & TCPFlags::SYN) {
+        u16 mss = routing_decision.adapter->mtu() - sizeof(IPv4Packet) - sizeof(TCPPacket);
+        append(TCPOptionMSS { mss });
+        // A SYN-ACK may only carry the options that the peer's SYN carried as well.
+        bool is_syn_ack = flags & TCPFlags::ACK;
+        if (!is_syn_ack || m_window_scaling_enabled) {
+            append_nop();
+            append(TCPOptionWindowScale { preferred_receive_window_scale() });
+        }
+        if (!is_syn_ack || m_sack_permitted) {
+            append_nop();
+            append_nop();
+            append(TCPOptionSACKPermitted {});
+        }
+        return offset;
+    }
+
+    // NOTE: SACK blocks only go into pure ACKs, since the MSS doesn't leave room for options in full-sized segments.
+    if (!m_sack_permitted || payload_size != 0 || !(flags & TCPFlags::ACK) || m_out_of_order_segments.is_empty())
+        return offset;
+
+    struct Range {
+        u32 start { 0 };
+        u32 end { 0 };
+    };
+    Vector<Range, 8> ranges;
+    for (auto& segment : m_out_of_order_segments) {
+        if (!ranges.is_empty() && ranges.last().end == segment.sequence_number)
+            ranges.last().end += segment.payload_size;
+        else
+            ranges.append({ segment.sequence_number, static_cast<u32>(segment.sequence_number + segment.payload_size) });
+    }
+
+    // RFC 2018, 4: The first block has to contain the most recently received segment.
+    size_t first_index = 0;
+    for (size_t i = 0; i < ranges.size(); ++i) {
+        if (tcp_sequence_number_before_or_equal(ranges[i].start, m_last_out_of_order_sequence_number)
+            && tcp_sequence_number_before(m_last_out_of_order_sequence_number, ranges[i].end)) {
+            first_index = i;
+            break;
+        }
+    }
+
+    size_t block_count = min(ranges.size(), maximum_sack_blocks);
+    append_nop();
+    append_nop();
+    options[offset++] = to_underlying(TCPOptionKind::SACK);
+    options[offset++] = 2 + block_count * sizeof(TCPSACKBlock);
+    append(TCPSACKBlock { ranges[first_index].start, ranges[first_index].end });
+    for (size_t i = 0; i < ranges.size() && block_count > 1; ++i) {
+        if (i == first_index)
+            continue;
+        append(TCPSACKBlock { ranges[i].start, ranges[i].end });
+        --block_count;
+    }
+    return offset;
+}
+
 ErrorOr<void> TCPSocket::send_tcp_packet(u16 flags, const UserOrKernelBuffer* payload, size_t payload_size, RoutingDecision* user_routing_decision)
 {
     RoutingDecision routing_decision = user_routing_decision ? *user_routing_decision : route_to(peer_address(), local_address(), bound_interface());
@@ -217,8 +348,9 @@ ErrorOr<void> TCPSocket::send_tcp_packet(u16 flags, const UserOrKernelBuffer* pa
 
     auto ipv4_payload_offset = routing_decision.adapter->ipv4_payload_offset();
 
-    const bool has_mss_option = flags == TCPFlags::SYN;
-    const size_t options_size = has_mss_option ? sizeof(TCPOptionMSS) : 0;
+    u8 options[maximum_options_size];
+    const size_t options_size = build_options(flags, payload_size, routing_decision, { options, sizeof(options) });
+    VERIFY(options_size % sizeof(u32) == 0);
     const size_t tcp_header_size = sizeof(TCPPacket) + options_size;
     const size_t buffer_size = ipv4_payload_offset + tcp_header_size + payload_size;
     auto packet = routing_decision.adapter->acquire_packet_buffer(buffer_size);
@@ -232,10 +364,11 @@ ErrorOr<void> TCPSocket::send_tcp_packet(u16 flags, const UserOrKernelBuffer* pa
     VERIFY(local_port());
     tcp_packet.set_source_port(local_port());
     tcp_packet.set_destination_port(peer_port());
-    tcp_packet.set_window_size(NumericLimits<u16>::max());
+    tcp_packet.set_window_size(compute_advertised_window(flags & TCPFlags::SYN));
     tcp_packet.set_sequence_number(m_sequence_number);
     tcp_packet.set_data_offset(tcp_header_size / sizeof(u32));
     tcp_packet.set_flags(flags);
+    memcpy(packet->buffer->data() + ipv4_payload_offset + sizeof(TCPPacket), options, options_size);
 
     if (flags & TCPFlags::ACK) {
         m_last_ack_number_sent = m_ack_number;
@@ -250,29 +383,38 @@ ErrorOr<void> TCPSocket::send_tcp_packet(u16 flags, const UserOrKernelBuffer* pa
         }
     }
 
+    auto sequence_number = m_sequence_number;
     if (flags & TCPFlags::SYN) {
         ++m_sequence_number;
     } else {
         m_sequence_number += payload_size;
     }
 
-    if (has_mss_option) {
-        u16 mss = routing_decision.adapter->mtu() - sizeof(IPv4Packet) - sizeof(TCPPacket);
-        TCPOptionMSS mss_option { mss };
-        VERIFY(packet->buffer->size() >= ipv4_payload_offset + sizeof(TCPPacket) + sizeof(mss_option));
-        memcpy(packet->buffer->data() + ipv4_payload_offset + sizeof(TCPPacket), &mss_option, sizeof(mss_option));
+    TransmitOffloads offloads;
+    if (routing_decision.adapter->has_tcp_checksum_offload()) {
+        offloads.tcp_checksum = true;
+        tcp_packet.set_checksum(compute_tcp_pseudo_header_checksum(local_address(), peer_address(), tcp_header_size + payload_size));
+    } else {
+        tcp_packet.set_checksum(compute_tcp_checksum(local_address(), peer_address(), tcp_packet, payload_size));
+    }
+    if (auto segment_size = segment_size_for(*routing_decision.adapter); payload_size > segment_size) {
+        VERIFY(payload_size <= routing_decision.adapter->tcp_segmentation_offload_size());
+        offloads.tcp_segment_size = segment_size;
     }
 
-    tcp_packet.set_checksum(compute_tcp_checksum(local_address(), peer_address(), tcp_packet, payload_size));
-
-    routing_decision.adapter->send_packet(packet->bytes());
+    routing_decision.adapter->send_packet(packet->bytes(), offloads);
 
     m_packets_out++;
     m_bytes_out += buffer_size;
     if (tcp_packet.has_syn() || payload_size > 0) {
+        auto now = TimeManagement::the().monotonic_time();
         m_unacked_packets.with_exclusive([&](auto& unacked_packets) {
-            unacked_packets.packets.append({ m_sequence_number, move(packet), ipv4_payload_offset, *routing_decision.adapter });
+            // RFC 6298, 5.1: Start the timer when the first outstanding segment goes out.
+            if (unacked_packets.packets.is_empty())
+                m_retransmit_deadline = now + m_retransmit_timeout;
+            unacked_packets.packets.append({ sequence_number, m_sequence_number, move(packet), ipv4_payload_offset, *routing_decision.adapter, payload_size, now, offloads });
             unacked_packets.size += payload_size;
+            unacked_packets.bytes_in_flight += payload_size;
             enqueue_for_retransmit();
         });
     } else {
@@ -282,55 +424,335 @@ ErrorOr<void> TCPSocket::send_tcp_packet(u16 flags, const UserOrKernelBuffer* pa
     return {};
 }
 
+void TCPSocket::apply_syn_options(TCPPacket const& packet)
+{
+    VERIFY(packet.has_syn());
+
+    Optional<u16> peer_maximum_segment_size;
+    Optional<u8> peer_window_scale;
+    bool peer_sack_permitted = false;
+    for_each_option(packet, [&](TCPOptionKind kind, ReadonlyBytes data) {
+        switch (kind) {
+        case TCPOptionKind::MSS:
+            if (data.size() == 2)
+                peer_maximum_segment_size = (data[0] << 8) | data[1];
+            break;
+        case TCPOptionKind::WindowScale:
+            if (data.size() == 1)
+                peer_window_scale = data[0];
+            break;
+        case TCPOptionKind::SACKPermitted:
+            peer_sack_permitted = data.is_empty();
+            break;
+        default:
+            break;
+        }
+    });
+
+    size_t our_maximum_segment_size = default_maximum_segment_size;
+    auto routing_decision = route_to(peer_address(), local_address(), bound_interface());
+    if (!routing_decision.is_zero())
+        our_maximum_segment_size = routing_decision.adapter->mtu() - sizeof(IPv4Packet) - sizeof(TCPPacket);
+    m_maximum_segment_size = min(our_maximum_segment_size, static_cast<size_t>(peer_maximum_segment_size.value_or(default_maximum_segment_size)));
+    m_congestion_control->set_maximum_segment_size(m_maximum_segment_size);
+
+    if (peer_window_scale.has_value()) {
+        m_window_scaling_enabled = true;
+        // RFC 7323, 2.3: Anything above 14 must be treated as 14.
+        m_send_window_scale = min<u8>(peer_window_scale.value(), 14);
+        m_receive_window_scale = preferred_receive_window_scale();
+    }
+    m_sack_permitted = peer_sack_permitted;
+    m_send_window = packet.window_size();
+
+    dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket({}) MSS={}, window scaling={} ({}/{}), SACK={}", this, m_maximum_segment_size, m_window_scaling_enabled, m_send_window_scale, m_receive_window_scale, m_sack_permitted);
+}
+
+void TCPSocket::update_send_window(TCPPacket const& packet)
+{
+    // RFC 7323, 2.2: The window in a SYN segment is never scaled.
+    u8 shift = packet.has_syn() ? 0 : m_send_window_scale;
+    m_send_window = static_cast<size_t>(packet.window_size()) << shift;
+}
+
+void TCPSocket::update_rtt(Time const& rtt_sample)
+{
+    // RFC 6298, 2
+    i64 rtt = max<i64>(rtt_sample.to_microseconds(), 1);
+    i64 smoothed_rtt = m_smoothed_rtt.to_microseconds();
+    i64 rtt_variation = m_rtt_variation.to_microseconds();
+    if (!m_has_rtt_sample) {
+        m_has_rtt_sample = true;
+        smoothed_rtt = rtt;
+        rtt_variation = rtt / 2;
+    } else {
+        rtt_variation = (3 * rtt_variation + (smoothed_rtt > rtt ? smoothed_rtt - rtt : rtt - smoothed_rtt)) / 4;
+        smoothed_rtt = (7 * smoothed_rtt + rtt) / 8;
+    }
+    m_smoothed_rtt = Time::from_microseconds(smoothed_rtt);
+    m_rtt_variation = Time::from_microseconds(rtt_variation);
+    m_retransmit_timeout = clamp(Time::from_microseconds(smoothed_rtt + 4 * rtt_variation), minimum_retransmit_timeout, maximum_retransmit_timeout);
+}
+
+size_t TCPSocket::available_send_window(UnackedPackets const& unacked_packets) const
+{
+    size_t congestion_window = m_congestion_control->congestion_window();
+    size_t congestion_limit = congestion_window > unacked_packets.bytes_in_flight ? congestion_window - unacked_packets.bytes_in_flight : 0;
+    size_t receive_limit = m_send_window > unacked_packets.size ? m_send_window - unacked_packets.size : 0;
+    return min(congestion_limit, receive_limit);
+}
+
+void TCPSocket::update_bytes_in_flight(UnackedPackets& unacked_packets)
+{
+    size_t bytes_in_flight = 0;
+    for (auto& packet : unacked_packets.packets) {
+        if (packet.sacked || (packet.lost && !packet.retransmitted))
+            continue;
+        bytes_in_flight += packet.payload_size;
+    }
+    unacked_packets.bytes_in_flight = bytes_in_flight;
+}
+
+void TCPSocket::mark_lost_packets(UnackedPackets& unacked_packets)
+{
+    if (!m_sack_permitted)
+        return;
+
+    // RFC 6675, 4: A segment is lost once enough segments after it have been SACKed.
+    size_t sacked_packets_after = 0;
+    for (auto& packet : unacked_packets.packets) {
+        if (packet.sacked)
+            ++sacked_packets_after;
+    }
+    for (auto& packet : unacked_packets.packets) {
+        if (packet.sacked) {
+            --sacked_packets_after;
+            continue;
+        }
+        if (sacked_packets_after < duplicate_ack_threshold)
+            break;
+        packet.lost = true;
+    }
+}
+
+void TCPSocket::send_lost_packets(UnackedPackets& unacked_packets)
+{
+    auto routing_decision = route_to(peer_address(), local_address(), bound_interface());
+    if (routing_decision.is_zero())
+        return;
+
+    auto congestion_window = m_congestion_control->congestion_window();
+    for (auto& packet : unacked_packets.packets) {
+        if (!packet.lost || packet.retransmitted || packet.sacked)
+            continue;
+        if (unacked_packets.bytes_in_flight > 0 && unacked_packets.bytes_in_flight + packet.payload_size > congestion_window)
+            break;
+        retransmit_packet(packet, routing_decision);
+        packet.retransmitted = true;
+        unacked_packets.bytes_in_flight += packet.payload_size;
+    }
+}
+
 void TCPSocket::receive_tcp_packet(const TCPPacket& packet, u16 size)
 {
-    if (packet.has_ack()) {
-        u32 ack_number = packet.ack_number();
+    m_packets_in++;
+    m_bytes_in += packet.header_size() + size;
+
+    if (!packet.has_ack())
+        return;
+
+    u32 ack_number = packet.ack_number();
+    size_t payload_size = size - packet.header_size();
+    auto now = TimeManagement::the().monotonic_time();
 
-        dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket: receive_tcp_packet: {}", ack_number);
+    dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket: receive_tcp_packet: {}", ack_number);
+
+    auto previous_send_window = m_send_window;
+    update_send_window(packet);
+
+    Vector<TCPSACKBlock, maximum_sack_blocks> sack_blocks;
+    if (m_sack_permitted) {
+        for_each_option(packet, [&](TCPOptionKind kind, ReadonlyBytes data) {
+            if (kind != TCPOptionKind::SACK)
+                return;
+            for (size_t offset = 0; offset + sizeof(TCPSACKBlock) <= data.size() && sack_blocks.size() < maximum_sack_blocks; offset += sizeof(TCPSACKBlock)) {
+                TCPSACKBlock block;
+                memcpy(&block, data.offset_pointer(offset), sizeof(block));
+                sack_blocks.unchecked_append(block);
+            }
+        });
+    }
+
+    bool should_evaluate_block_conditions = m_send_window != previous_send_window;
+
+    m_unacked_packets.with_exclusive([&](auto& unacked_packets) {
+        if (unacked_packets.packets.is_empty())
+            return;
 
         int removed = 0;
-        m_unacked_packets.with_exclusive([&](auto& unacked_packets) {
-            while (!unacked_packets.packets.is_empty()) {
-                auto& packet = unacked_packets.packets.first();
-
-                dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket: iterate: {}", packet.ack_number);
-
-                if (packet.ack_number <= ack_number) {
-                    auto old_adapter = packet.adapter.strong_ref();
-                    if (old_adapter)
-                        old_adapter->release_packet_buffer(*packet.buffer);
-                    TCPPacket& tcp_packet = *(TCPPacket*)(packet.buffer->buffer->data() + packet.ipv4_payload_offset);
-                    auto payload_size = packet.buffer->buffer->data() + packet.buffer->buffer->size() - (u8*)tcp_packet.payload();
-                    unacked_packets.size -= payload_size;
-                    evaluate_block_conditions();
-                    unacked_packets.packets.take_first();
-                    removed++;
-                } else {
+        size_t acknowledged_bytes = 0;
+        Optional<Time> rtt_sample;
+        while (!unacked_packets.packets.is_empty()) {
+            auto& outgoing_packet = unacked_packets.packets.first();
+
+            dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket: iterate: {}", outgoing_packet.ack_number);
+
+            if (!tcp_sequence_number_before_or_equal(outgoing_packet.ack_number, ack_number))
+                break;
+
+            auto old_adapter = outgoing_packet.adapter.strong_ref();
+            if (old_adapter)
+                old_adapter->release_packet_buffer(*outgoing_packet.buffer);
+            // Karn's algorithm: An ACK for a retransmitted segment is ambiguous, so it can't be used as an RTT sample.
+            if (outgoing_packet.tx_counter == 0)
+                rtt_sample = now - outgoing_packet.first_sent_time;
+            unacked_packets.size -= outgoing_packet.payload_size;
+            acknowledged_bytes += outgoing_packet.payload_size;
+            unacked_packets.packets.take_first();
+            removed++;
+        }
+
+        for (auto& outgoing_packet : unacked_packets.packets) {
+            if (outgoing_packet.sacked)
+                continue;
+            for (auto& block : sack_blocks) {
+                if (tcp_sequence_number_before_or_equal(block.left_edge, outgoing_packet.sequence_number)
+                    && tcp_sequence_number_before_or_equal(outgoing_packet.ack_number, block.right_edge)) {
+                    outgoing_packet.sacked = true;
                     break;
                 }
             }
+        }
 
-            if (unacked_packets.packets.is_empty()) {
-                m_retransmit_attempts = 0;
-                dequeue_for_retransmit();
+        if (removed > 0) {
+            should_evaluate_block_conditions = true;
+            m_duplicate_acks = 0;
+            if (rtt_sample.has_value())
+                update_rtt(rtt_sample.value());
+
+            if (m_in_recovery) {
+                if (tcp_sequence_number_before(ack_number, m_recovery_point)) {
+                    // RFC 6582, 3.2: A partial ACK means that the next segment was lost as well.
+                    if (!unacked_packets.packets.is_empty())
+                        unacked_packets.packets.first().lost = true;
+                } else {
+                    m_in_recovery = false;
+                    m_congestion_control->on_exit_recovery();
+                }
+            } else {
+                m_congestion_control->on_ack(acknowledged_bytes, now, m_smoothed_rtt);
             }
 
-            dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket: receive_tcp_packet acknowledged {} packets", removed);
-        });
+            // RFC 6298, 5.3: Restart the timer whenever new data is acknowledged.
+            m_retransmit_deadline = now + m_retransmit_timeout;
+        } else if (payload_size == 0 && !packet.has_syn() && !packet.has_fin() && m_send_window == previous_send_window && m_send_window > 0) {
+            // RFC 5681, 2: This is a duplicate ACK. (Those for a closed window only tell us that it's still closed.)
+            ++m_duplicate_acks;
+            if (m_in_recovery) {
+                // With SACK we know exactly what left the network, otherwise every duplicate ACK stands for one segment.
+                if (!m_sack_permitted)
+                    m_congestion_control->on_duplicate_ack_in_recovery();
+            } else if (m_duplicate_acks >= duplicate_ack_threshold) {
+                dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket({}) entering fast recovery", this);
+                m_in_recovery = true;
+                m_recovery_point = m_sequence_number;
+                m_congestion_control->on_enter_recovery(unacked_packets.bytes_in_flight, now, !m_sack_permitted);
+                if (!unacked_packets.packets.is_empty())
+                    unacked_packets.packets.first().lost = true;
+            }
+        }
+
+        if (previous_send_window == 0 && m_send_window > 0) {
+            // Whatever we sent into the closed window was dropped, so don't wait for the timer to send it again.
+            for (auto& outgoing_packet : unacked_packets.packets) {
+                outgoing_packet.lost = true;
+                outgoing_packet.retransmitted = false;
+            }
+        }
+
+        if (m_in_recovery)
+            mark_lost_packets(unacked_packets);
+        update_bytes_in_flight(unacked_packets);
+        send_lost_packets(unacked_packets);
+
+        if (unacked_packets.packets.is_empty())
+            dequeue_for_retransmit();
+
+        dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket: receive_tcp_packet acknowledged {} packets", removed);
+    });
+
+    // The peer is still there, so a lack of progress is due to its window and not a dead connection.
+    m_retransmit_attempts = 0;
+
+    if (should_evaluate_block_conditions)
+        evaluate_block_conditions();
+}
+
+void TCPSocket::queue_out_of_order_segment(IPv4Packet const& ipv4_packet, TCPPacket const& tcp_packet, size_t payload_size)
+{
+    auto sequence_number = tcp_packet.sequence_number();
+    // Retransmissions of data we already have only need to be acknowledged again.
+    if (payload_size == 0 || tcp_sequence_number_before(sequence_number, m_ack_number))
+        return;
+    // Keep only what fits into the window we advertised.
+    if (static_cast<size_t>(sequence_number - m_ack_number) + payload_size > receive_buffer_space())
+        return;
+
+    size_t index = 0;
+    for (; index < m_out_of_order_segments.size(); ++index) {
+        auto& segment = m_out_of_order_segments[index];
+        if (segment.sequence_number == sequence_number)
+            return;
+        if (tcp_sequence_number_before(sequence_number, segment.sequence_number))
+            break;
     }
 
-    m_packets_in++;
-    m_bytes_in += packet.header_size() + size;
+    auto data_or_error = KBuffer::try_create_with_bytes({ &ipv4_packet, sizeof(IPv4Packet) + ipv4_packet.payload_size() });
+    if (data_or_error.is_error())
+        return;
+    if (m_out_of_order_segments.try_insert(index, OutOfOrderSegment { sequence_number, payload_size, data_or_error.release_value() }).is_error())
+        return;
+    m_out_of_order_bytes += payload_size;
+    m_last_out_of_order_sequence_number = sequence_number;
+
+    dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket({}) queued out of order segment {} ({} bytes), {} bytes queued", this, sequence_number, payload_size, m_out_of_order_bytes);
+}
+
+void TCPSocket::deliver_out_of_order_segments(Time const& packet_timestamp)
+{
+    while (!m_out_of_order_segments.is_empty()) {
+        if (tcp_sequence_number_before(m_ack_number, m_out_of_order_segments.first().sequence_number))
+            break;
+        auto segment = m_out_of_order_segments.take_first();
+        m_out_of_order_bytes -= segment.payload_size;
+        // FIXME: Segments that overlap with what we already have are dropped and have to be sent again.
+        if (segment.sequence_number != m_ack_number)
+            continue;
+        if (!did_receive(peer_address(), peer_port(), segment.ipv4_packet->bytes(), packet_timestamp))
+            break;
+        m_ack_number += segment.payload_size;
+    }
+}
+
+void TCPSocket::protocol_did_read(size_t)
+{
+    if (m_state != State::Established && m_state != State::FinWait1 && m_state != State::FinWait2)
+        return;
+    // RFC 1122, 4.2.3.3: Only announce a larger window once it has grown by a meaningful amount.
+    auto window = receive_buffer_space();
+    if (window < m_last_advertised_window + min(receive_buffer_size / 2, 2 * m_maximum_segment_size))
+        return;
+    [[maybe_unused]] auto result = send_ack(true);
 }
 
 bool TCPSocket::should_delay_next_ack() const
 {
-    // FIXME: We don't know the MSS here so make a reasonable guess.
-    const size_t mss = 1500;
+    // RFC 5681, 4.2: Out-of-order segments, and those filling a hole, must be acknowledged immediately.
+    if (!m_out_of_order_segments.is_empty())
+        return false;
 
     // RFC 1122 says we should send an ACK for every two full-sized segments.
-    if (m_ack_number >= m_last_ack_number_sent + 2 * mss)
+    if (tcp_sequence_number_before_or_equal(m_last_ack_number_sent + 2 * m_maximum_segment_size, m_ack_number))
         return false;
 
     // RFC 1122 says we should not delay ACKs for more than 500 milliseconds.
@@ -340,7 +762,7 @@ bool TCPSocket::should_delay_next_ack() const
     return true;
 }
 
-NetworkOrdered<u16> TCPSocket::compute_tcp_checksum(const IPv4Address& source, const IPv4Address& destination, const TCPPacket& packet, u16 payload_size)
+static u32 sum_tcp_pseudo_header(IPv4Address const& source, IPv4Address const& destination, u16 tcp_length)
 {
     struct [[gnu::packed]] PseudoHeader {
         IPv4Address source;
@@ -350,7 +772,7 @@ NetworkOrdered<u16> TCPSocket::compute_tcp_checksum(const IPv4Address& source, c
         NetworkOrdered<u16> payload_size;
     };
 
-    PseudoHeader pseudo_header { source, destination, 0, (u8)IPv4Protocol::TCP, packet.header_size() + payload_size };
+    PseudoHeader pseudo_header { source, destination, 0, (u8)IPv4Protocol::TCP, tcp_length };
 
     u32 checksum = 0;
     auto raw_pseudo_header = bit_cast<u16*>(&pseudo_header);
@@ -359,6 +781,18 @@ NetworkOrdered<u16> TCPSocket::compute_tcp_checksum(const IPv4Address& source, c
         if (checksum > 0xffff)
             checksum = (checksum >> 16) + (checksum & 0xffff);
     }
+    return checksum;
+}
+
+NetworkOrdered<u16> TCPSocket::compute_tcp_pseudo_header_checksum(IPv4Address const& source, IPv4Address const& destination, u16 tcp_length)
+{
+    // NOTE: Unlike the full checksum, this one is not inverted, since the adapter continues summing from here.
+    return sum_tcp_pseudo_header(source, destination, tcp_length);
+}
+
+NetworkOrdered<u16> TCPSocket::compute_tcp_checksum(const IPv4Address& source, const IPv4Address& destination, const TCPPacket& packet, u16 payload_size)
+{
+    u32 checksum = sum_tcp_pseudo_header(source, destination, packet.header_size() + payload_size);
     auto raw_packet = bit_cast<u16*>(&packet);
     for (size_t i = 0; i < packet.header_size() / sizeof(u16); ++i) {
         checksum += AK::convert_between_host_and_network_endian(raw_packet[i]);
@@ -549,20 +983,21 @@ void TCPSocket::dequeue_for_retransmit()
 
 void TCPSocket::retransmit_packets()
 {
-    auto now = kgettimeofday();
+    auto now = TimeManagement::the().monotonic_time();
 
-    // RFC6298 says we should have at least one second between retransmits. According to
-    // RFC1122 we must do exponential backoff - even for SYN packets.
-    i64 retransmit_interval = 1;
-    for (decltype(m_retransmit_attempts) i = 0; i < m_retransmit_attempts; i++)
-        retransmit_interval *= 2;
+    bool has_unacked_packets = m_unacked_packets.with_shared([&](auto& unacked_packets) {
+        return !unacked_packets.packets.is_empty();
+    });
+    if (!has_unacked_packets) {
+        dequeue_for_retransmit();
+        return;
+    }
 
-    if (m_last_retransmit_time > now - Time::from_seconds(retransmit_interval))
+    if (now < m_retransmit_deadline)
         return;
 
     dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket({}) handling retransmit", this);
 
-    m_last_retransmit_time = now;
     ++m_retransmit_attempts;
 
     if (m_retransmit_attempts > maximum_retransmits) {
@@ -572,46 +1007,61 @@ void TCPSocket::retransmit_packets()
         return;
     }
 
-    auto routing_decision = route_to(peer_address(), local_address(), bound_interface());
-    if (routing_decision.is_zero())
-        return;
+    // RFC 6298, 5.5: Back off the timer. According to RFC1122 we must do this even for SYN packets.
+    m_retransmit_timeout = min(Time::from_microseconds(m_retransmit_timeout.to_microseconds() * 2), maximum_retransmit_timeout);
+    m_retransmit_deadline = now + m_retransmit_timeout;
+    m_in_recovery = false;
+    m_duplicate_acks = 0;
 
     m_unacked_packets.with_exclusive([&](auto& unacked_packets) {
+        m_congestion_control->on_retransmit_timeout(unacked_packets.bytes_in_flight, now);
+
+        // Everything that's still outstanding is presumed lost. The peer is allowed to discard
+        // data it has SACKed (RFC 2018, 8), so that's sent again as well.
         for (auto& packet : unacked_packets.packets) {
-            packet.tx_counter++;
-
-            if constexpr (TCP_SOCKET_DEBUG) {
-                auto& tcp_packet = *(const TCPPacket*)(packet.buffer->buffer->data() + packet.ipv4_payload_offset);
-                dbgln("Sending TCP packet from {}:{} to {}:{} with ({}{}{}{}) seq_no={}, ack_no={}, tx_counter={}",
-                    local_address(), local_port(),
-                    peer_address(), peer_port(),
-                    (tcp_packet.has_syn() ? "SYN " : ""),
-                    (tcp_packet.has_ack() ? "ACK " : ""),
-                    (tcp_packet.has_fin() ? "FIN " : ""),
-                    (tcp_packet.has_rst() ? "RST " : ""),
-                    tcp_packet.sequence_number(),
-                    tcp_packet.ack_number(),
-                    packet.tx_counter);
-            }
+            packet.sacked = false;
+            packet.lost = true;
+            packet.retransmitted = false;
+        }
+        update_bytes_in_flight(unacked_packets);
+        send_lost_packets(unacked_packets);
+    });
+}
 
-            size_t ipv4_payload_offset = routing_decision.adapter->ipv4_payload_offset();
-            if (ipv4_payload_offset != packet.ipv4_payload_offset) {
-                // FIXME: Add support for this. This can happen if after a route change
-                // we ended up on another adapter which doesn't have the same layer 2 type
-                // like the previous adapter.
-                VERIFY_NOT_REACHED();
-            }
+void TCPSocket::retransmit_packet(OutgoingPacket& packet, RoutingDecision& routing_decision)
+{
+    packet.tx_counter++;
+
+    if constexpr (TCP_SOCKET_DEBUG) {
+        auto& tcp_packet = *(const TCPPacket*)(packet.buffer->buffer->data() + packet.ipv4_payload_offset);
+        dbgln("Sending TCP packet from {}:{} to {}:{} with ({}{}{}{}) seq_no={}, ack_no={}, tx_counter={}",
+            local_address(), local_port(),
+            peer_address(), peer_port(),
+            (tcp_packet.has_syn() ? "SYN " : ""),
+            (tcp_packet.has_ack() ? "ACK " : ""),
+            (tcp_packet.has_fin() ? "FIN " : ""),
+            (tcp_packet.has_rst() ? "RST " : ""),
+            tcp_packet.sequence_number(),
+            tcp_packet.ack_number(),
+            packet.tx_counter);
+    }
 
-            auto packet_buffer = packet.buffer->bytes();
+    size_t ipv4_payload_offset = routing_decision.adapter->ipv4_payload_offset();
+    if (ipv4_payload_offset != packet.ipv4_payload_offset || !routing_decision.adapter->supports_offloads(packet.offloads)) {
+        // FIXME: Add support for this. This can happen if after a route change
+        // we ended up on another adapter which doesn't have the same layer 2 type
+        // or can't finish the checksum or segmentation like the previous adapter.
+        VERIFY_NOT_REACHED();
+    }
 
-            routing_decision.adapter->fill_in_ipv4_header(*packet.buffer,
-                local_address(), routing_decision.next_hop, peer_address(),
-                IPv4Protocol::TCP, packet_buffer.size() - ipv4_payload_offset, type_of_service(), ttl());
-            routing_decision.adapter->send_packet(packet_buffer);
-            m_packets_out++;
-            m_bytes_out += packet_buffer.size();
-        }
-    });
+    auto packet_buffer = packet.buffer->bytes();
+
+    routing_decision.adapter->fill_in_ipv4_header(*packet.buffer,
+        local_address(), routing_decision.next_hop, peer_address(),
+        IPv4Protocol::TCP, packet_buffer.size() - ipv4_payload_offset, type_of_service(), ttl());
+    routing_decision.adapter->send_packet(packet_buffer, packet.offloads);
+    m_packets_out++;
+    m_bytes_out += packet_buffer.size();
 }
 
 bool TCPSocket::can_write(const OpenFileDescription& file_description, size_t size) const
@@ -622,11 +1072,11 @@ bool TCPSocket::can_write(const OpenFileDescription& file_description, size_t si
     if (m_state == State::SynSent || m_state == State::SynReceived)
         return false;
 
-    if (!file_description.is_blocking())
-        return true;
-
     return m_unacked_packets.with_shared([&](auto& unacked_packets) {
-        return unacked_packets.size + size <= m_send_window_size;
+        if (unacked_packets.packets.is_empty())
+            return true;
+        // Don't wake up writers for windows too small to fill a segment (RFC 1122, 4.2.3.4).
+        return available_send_window(unacked_packets) >= m_maximum_segment_size;
     });
 }
 }
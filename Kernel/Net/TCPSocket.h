@@ -10,9 +10,11 @@
 #include <AK/Function.h>
 #include <AK/HashMap.h>
 #include <AK/SinglyLinkedList.h>
+#include <AK/Vector.h>
 #include <AK/WeakPtr.h>
 #include <Kernel/Locking/MutexProtected.h>
 #include <Kernel/Net/IPv4Socket.h>
+#include <Kernel/Net/TCPCongestionControl.h>
 
 namespace Kernel {
 
@@ -133,15 +135,26 @@ public:
     u32 packets_out() const { return m_packets_out; }
     u32 bytes_out() const { return m_bytes_out; }
 
-    // FIXME: Make this configurable?
-    static constexpr u32 maximum_duplicate_acks = 5;
-    void set_duplicate_acks(u32 acks) { m_duplicate_acks = acks; }
-    u32 duplicate_acks() const { return m_duplicate_acks; }
+    size_t maximum_segment_size() const { return m_maximum_segment_size; }
+    TCPCongestionControl const& congestion_control() const { return *m_congestion_control; }
+    Time smoothed_rtt() const { return m_smoothed_rtt; }
+    Time retransmit_timeout() const { return m_retransmit_timeout; }
+    bool is_window_scaling_enabled() const { return m_window_scaling_enabled; }
+    bool is_sack_permitted() const { return m_sack_permitted; }
 
     ErrorOr<void> send_ack(bool allow_duplicate = false);
     ErrorOr<void> send_tcp_packet(u16 flags, const UserOrKernelBuffer* = nullptr, size_t = 0, RoutingDecision* = nullptr);
     void receive_tcp_packet(const TCPPacket&, u16 size);
 
+    // Takes the MSS, window scale and SACK-permitted options from the peer's SYN.
+    void apply_syn_options(TCPPacket const&);
+
+    // Segments that arrive ahead of a hole are kept around until the hole is filled,
+    // and are reported back to the peer in SACK blocks.
+    void queue_out_of_order_segment(IPv4Packet const&, TCPPacket const&, size_t payload_size);
+    bool has_out_of_order_segments() const { return !m_out_of_order_segments.is_empty(); }
+    void deliver_out_of_order_segments(Time const& packet_timestamp);
+
     bool should_delay_next_ack() const;
 
     static MutexProtected<HashMap<IPv4SocketTuple, TCPSocket*>>& sockets_by_tuple();
@@ -162,12 +175,14 @@ public:
     virtual bool can_write(const OpenFileDescription&, size_t) const override;
 
     static NetworkOrdered<u16> compute_tcp_checksum(IPv4Address const& source, IPv4Address const& destination, TCPPacket const&, u16 payload_size);
+    // The partial checksum that adapters with TCP checksum offload expect to find in the packet.
+    static NetworkOrdered<u16> compute_tcp_pseudo_header_checksum(IPv4Address const& source, IPv4Address const& destination, u16 tcp_length);
 
 protected:
     void set_direction(Direction direction) { m_direction = direction; }
 
 private:
-    explicit TCPSocket(int protocol, NonnullOwnPtr<DoubleBuffer> receive_buffer, NonnullOwnPtr<KBuffer> scratch_buffer);
+    explicit TCPSocket(int protocol, NonnullOwnPtr<DoubleBuffer> receive_buffer, NonnullOwnPtr<KBuffer> scratch_buffer, NonnullOwnPtr<TCPCongestionControl>);
     virtual StringView class_name() const override { return "TCPSocket"sv; }
 
     virtual void shut_down_for_writing() override;
@@ -180,10 +195,17 @@ private:
     virtual bool protocol_is_disconnected() const override;
     virtual ErrorOr<void> protocol_bind() override;
     virtual ErrorOr<void> protocol_listen(bool did_allocate_port) override;
+    virtual void protocol_did_read(size_t) override;
 
     void enqueue_for_retransmit();
     void dequeue_for_retransmit();
 
+    size_t segment_size_for(NetworkAdapter const&) const;
+    u16 compute_advertised_window(bool is_syn);
+    size_t build_options(u16 flags, size_t payload_size, RoutingDecision const&, Bytes options);
+    void update_rtt(Time const& rtt_sample);
+    void update_send_window(TCPPacket const&);
+
     WeakPtr<TCPSocket> m_originator;
     HashMap<IPv4SocketTuple, NonnullRefPtr<TCPSocket>> m_pending_release_for_accept;
     Direction m_direction { Direction::Unspecified };
@@ -198,33 +220,92 @@ private:
     u32 m_bytes_out { 0 };
 
     struct OutgoingPacket {
+        u32 sequence_number { 0 };
         u32 ack_number { 0 };
         RefPtr<PacketWithTimestamp> buffer;
         size_t ipv4_payload_offset;
         WeakPtr<NetworkAdapter> adapter;
+        size_t payload_size { 0 };
+        Time first_sent_time;
+        TransmitOffloads offloads;
         int tx_counter { 0 };
+        // The peer told us it has this segment, but it hasn't acknowledged it yet.
+        bool sacked { false };
+        // We think this segment never made it, and it has to be sent again.
+        bool lost { false };
+        bool retransmitted { false };
     };
 
     struct UnackedPackets {
         SinglyLinkedList<OutgoingPacket> packets;
         size_t size { 0 };
+        // RFC 6675 "pipe": The unacknowledged bytes that are still believed to be in the network.
+        size_t bytes_in_flight { 0 };
     };
 
+    void update_bytes_in_flight(UnackedPackets&);
+    void mark_lost_packets(UnackedPackets&);
+    void send_lost_packets(UnackedPackets&);
+    void retransmit_packet(OutgoingPacket&, RoutingDecision&);
+    size_t available_send_window(UnackedPackets const&) const;
+
     MutexProtected<UnackedPackets> m_unacked_packets;
 
+    // RFC 1122, 4.2.2.6: What we must assume if the peer doesn't tell us otherwise.
+    static constexpr size_t default_maximum_segment_size = 536;
+    // The MSS in effect for this connection, i.e. the smaller one of ours and the peer's.
+    size_t m_maximum_segment_size { default_maximum_segment_size };
+    NonnullOwnPtr<TCPCongestionControl> m_congestion_control;
+
+    // RFC 7323: The window scale is only used if both sides send it in their SYN.
+    bool m_window_scaling_enabled { false };
+    u8 m_send_window_scale { 0 };
+    u8 m_receive_window_scale { 0 };
+    bool m_sack_permitted { false };
+
+    // The smallest shift that still lets us advertise the whole receive buffer.
+    static constexpr u8 preferred_receive_window_scale()
+    {
+        u8 shift = 0;
+        while ((receive_buffer_size >> shift) > NumericLimits<u16>::max())
+            ++shift;
+        return shift;
+    }
+
+    // The window the peer is willing to receive, in bytes.
+    size_t m_send_window { NumericLimits<u16>::max() };
+    size_t m_last_advertised_window { 0 };
+
+    // Fast recovery (RFC 5681, RFC 6582)
+    static constexpr u32 duplicate_ack_threshold = 3;
     u32 m_duplicate_acks { 0 };
+    bool m_in_recovery { false };
+    u32 m_recovery_point { 0 };
+
+    struct OutOfOrderSegment {
+        u32 sequence_number { 0 };
+        size_t payload_size { 0 };
+        NonnullOwnPtr<KBuffer> ipv4_packet;
+    };
+    // Sorted by sequence number.
+    Vector<OutOfOrderSegment> m_out_of_order_segments;
+    size_t m_out_of_order_bytes { 0 };
+    u32 m_last_out_of_order_sequence_number { 0 };
 
     u32 m_last_ack_number_sent { 0 };
     Time m_last_ack_sent_time;
 
+    // RFC 6298
+    bool m_has_rtt_sample { false };
+    Time m_smoothed_rtt;
+    Time m_rtt_variation;
+    Time m_retransmit_timeout { Time::from_seconds(1) };
+    Time m_retransmit_deadline;
+
     // FIXME: Make this configurable (sysctl)
     static constexpr u32 maximum_retransmits = 5;
-    Time m_last_retransmit_time;
     u32 m_retransmit_attempts { 0 };
 
-    // FIXME: Parse window size TCP option from the peer
-    u32 m_send_window_size { 64 * KiB };
-
     IntrusiveListNode<TCPSocket> m_retransmit_list_node;
 
 public:
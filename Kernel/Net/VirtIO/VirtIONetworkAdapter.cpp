@@ -0,0 +1,557 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/HashFunctions.h>
+#include <AK/NumericLimits.h>
+#include <Kernel/Arch/x86/IO.h>
+#include <Kernel/Bus/PCI/API.h>
+#include <Kernel/Bus/PCI/IDs.h>
+#include <Kernel/Net/EtherType.h>
+#include <Kernel/Net/NetworkingManagement.h>
+#include <Kernel/Net/TCP.h>
+#include <Kernel/Net/VirtIO/VirtIONetworkAdapter.h>
+#include <Kernel/Random.h>
+#include <Kernel/Sections.h>
+
+namespace Kernel {
+
+#define VIRTIO_NET_F_CSUM ((u64)1 << 0)
+#define VIRTIO_NET_F_GUEST_CSUM ((u64)1 << 1)
+#define VIRTIO_NET_F_MTU ((u64)1 << 3)
+#define VIRTIO_NET_F_MAC ((u64)1 << 5)
+#define VIRTIO_NET_F_GUEST_TSO4 ((u64)1 << 7)
+#define VIRTIO_NET_F_HOST_TSO4 ((u64)1 << 11)
+#define VIRTIO_NET_F_MRG_RXBUF ((u64)1 << 15)
+#define VIRTIO_NET_F_STATUS ((u64)1 << 16)
+#define VIRTIO_NET_F_CTRL_VQ ((u64)1 << 17)
+#define VIRTIO_NET_F_MQ ((u64)1 << 22)
+#define VIRTIO_NET_F_SPEED_DUPLEX ((u64)1 << 63)
+
+#define VIRTIO_NET_S_LINK_UP 1
+
+#define VIRTIO_NET_HDR_F_NEEDS_CSUM 1
+#define VIRTIO_NET_HDR_GSO_TCPV4 1
+
+#define VIRTIO_NET_CTRL_MQ 4
+#define VIRTIO_NET_CTRL_MQ_VQ_PAIRS_SET 0
+#define VIRTIO_NET_OK 0
+
+// virtio_net_config
+#define DEVICE_CONFIG_MAC 0x0
+#define DEVICE_CONFIG_STATUS 0x6
+#define DEVICE_CONFIG_MAX_VIRTQUEUE_PAIRS 0x8
+#define DEVICE_CONFIG_MTU 0xa
+#define DEVICE_CONFIG_SPEED 0xc
+#define DEVICE_CONFIG_DUPLEX 0x10
+
+// The offset of the checksum field in the TCP header.
+#define TCP_CHECKSUM_OFFSET 16
+
+struct [[gnu::packed]] VirtIONetHeader {
+    u8 flags;
+    u8 gso_type;
+    u16 header_length;
+    u16 gso_size;
+    u16 checksum_start;
+    u16 checksum_offset;
+    u16 buffer_count;
+};
+static_assert(sizeof(VirtIONetHeader) == 12);
+
+struct [[gnu::packed]] VirtIONetControlCommand {
+    u8 command_class;
+    u8 command;
+    u16 virtqueue_pairs;
+};
+
+static constexpr u16 max_queue_pairs = 8;
+static constexpr size_t buffers_per_queue = 256;
+// Leaves room for the headers in an IPv4 packet, which can't be larger than 64 KiB.
+static constexpr size_t max_tcp_segmentation_offload_size = 63 * KiB;
+static constexpr size_t max_frame_size = sizeof(EthernetFrameHeader) + NumericLimits<u16>::max();
+static constexpr size_t control_command_ack_offset = 64;
+
+UNMAP_AFTER_INIT RefPtr<VirtIONetworkAdapter> VirtIONetworkAdapter::try_to_initialize(PCI::DeviceIdentifier const& pci_device_identifier)
+{
+    if (pci_device_identifier.hardware_id().vendor_id != PCI::VendorID::VirtIO)
+        return {};
+    if (pci_device_identifier.hardware_id().device_id != PCI::DeviceID::VirtIONetAdapter)
+        return {};
+    // FIXME: Better propagate errors here
+    auto interface_name_or_error = NetworkingManagement::generate_interface_name_from_pci_address(pci_device_identifier);
+    if (interface_name_or_error.is_error())
+        return {};
+    auto adapter = adopt_ref_if_nonnull(new (nothrow) VirtIONetworkAdapter(pci_device_identifier, interface_name_or_error.release_value()));
+    if (!adapter)
+        return {};
+    if (adapter->initialize_adapter())
+        return adapter;
+    return {};
+}
+
+UNMAP_AFTER_INIT VirtIONetworkAdapter::VirtIONetworkAdapter(PCI::DeviceIdentifier const& pci_device_identifier, NonnullOwnPtr<KString> interface_name)
+    : NetworkAdapter(move(interface_name))
+    , VirtIO::Device(pci_device_identifier)
+{
+}
+
+UNMAP_AFTER_INIT bool VirtIONetworkAdapter::initialize_adapter()
+{
+    VirtIO::Device::initialize();
+
+    bool success = negotiate_features([&](u64 device_features) {
+        u64 accepted_features = 0;
+        auto accept_if_offered = [&](u64 feature) {
+            if (is_feature_set(device_features, feature))
+                accepted_features |= feature;
+        };
+        accept_if_offered(VIRTIO_NET_F_MAC);
+        accept_if_offered(VIRTIO_NET_F_MTU);
+        accept_if_offered(VIRTIO_NET_F_STATUS);
+        accept_if_offered(VIRTIO_NET_F_SPEED_DUPLEX);
+        accept_if_offered(VIRTIO_NET_F_MRG_RXBUF);
+        accept_if_offered(VIRTIO_NET_F_CSUM);
+        accept_if_offered(VIRTIO_NET_F_GUEST_CSUM);
+        accept_if_offered(VIRTIO_NET_F_CTRL_VQ);
+        // Segmentation offload builds on checksum offload.
+        if (is_feature_set(accepted_features, VIRTIO_NET_F_CSUM))
+            accept_if_offered(VIRTIO_NET_F_HOST_TSO4);
+        // Large received packets only fit if they can be spread over several of our page-sized buffers.
+        if (is_feature_set(accepted_features, VIRTIO_NET_F_GUEST_CSUM | VIRTIO_NET_F_MRG_RXBUF))
+            accept_if_offered(VIRTIO_NET_F_GUEST_TSO4);
+        // The number of queue pairs in use is set through the control queue.
+        if (is_feature_set(accepted_features, VIRTIO_NET_F_CTRL_VQ))
+            accept_if_offered(VIRTIO_NET_F_MQ);
+        return accepted_features;
+    });
+    if (!success)
+        return false;
+
+    auto const* device_config = get_config(VirtIO::ConfigurationType::Device);
+    if (!device_config) {
+        dbgln("{}: Device has no configuration", class_name());
+        return false;
+    }
+
+    u16 available_queue_pair_count = 1;
+    u16 device_mtu = 0;
+    read_config_atomic([&] {
+        if (is_feature_accepted(VIRTIO_NET_F_MAC)) {
+            set_mac_address(MACAddress(
+                config_read8(*device_config, DEVICE_CONFIG_MAC + 0),
+                config_read8(*device_config, DEVICE_CONFIG_MAC + 1),
+                config_read8(*device_config, DEVICE_CONFIG_MAC + 2),
+                config_read8(*device_config, DEVICE_CONFIG_MAC + 3),
+                config_read8(*device_config, DEVICE_CONFIG_MAC + 4),
+                config_read8(*device_config, DEVICE_CONFIG_MAC + 5)));
+        }
+        if (is_feature_accepted(VIRTIO_NET_F_MQ))
+            available_queue_pair_count = max<u16>(config_read16(*device_config, DEVICE_CONFIG_MAX_VIRTQUEUE_PAIRS), 1);
+        if (is_feature_accepted(VIRTIO_NET_F_MTU))
+            device_mtu = config_read16(*device_config, DEVICE_CONFIG_MTU);
+    });
+
+    if (!is_feature_accepted(VIRTIO_NET_F_MAC)) {
+        // Make up a locally administered unicast address.
+        u8 address[6];
+        get_fast_random_bytes({ address, sizeof(address) });
+        set_mac_address(MACAddress((address[0] & ~1) | 2, address[1], address[2], address[3], address[4], address[5]));
+    }
+
+    if (device_mtu != 0) {
+        // Without mergeable receive buffers, every packet has to fit into a single one.
+        if (!is_feature_accepted(VIRTIO_NET_F_MRG_RXBUF))
+            device_mtu = min<u16>(device_mtu, PAGE_SIZE - sizeof(VirtIONetHeader) - sizeof(EthernetFrameHeader));
+        set_mtu(device_mtu);
+    }
+
+    // The queues are laid out as receiveq1, transmitq1, ..., receiveqN, transmitqN, controlq.
+    u16 queue_count = 2 * available_queue_pair_count;
+    if (is_feature_accepted(VIRTIO_NET_F_CTRL_VQ))
+        m_control_queue_index = queue_count++;
+    if (!setup_queues(queue_count))
+        return false;
+    finish_init();
+
+    u16 queue_pair_count = 1;
+    if (available_queue_pair_count > 1) {
+        m_control_buffer = MM.allocate_contiguous_kernel_region(PAGE_SIZE, "VirtIONetworkAdapter Control"sv, Memory::Region::Access::ReadWrite).release_value_but_fixme_should_propagate_errors();
+        // The device starts out with a single queue pair.
+        auto requested_queue_pair_count = min(available_queue_pair_count, max_queue_pairs);
+        if (set_active_queue_pair_count(requested_queue_pair_count))
+            queue_pair_count = requested_queue_pair_count;
+        else
+            dbgln("{}: Failed to enable {} queue pairs", class_name(), requested_queue_pair_count);
+    }
+
+    if (auto result = create_queue_buffers(queue_pair_count); result.is_error()) {
+        dbgln("{}: Failed to allocate queue buffers: {}", class_name(), result.error());
+        return false;
+    }
+
+    for (auto& receive_queue : m_receive_queues) {
+        auto& queue = get_queue(receive_queue.queue_index);
+        SpinlockLocker locker(queue.lock());
+        for (size_t i = 0; i < buffers_per_queue; ++i)
+            supply_receive_buffer(receive_queue, i);
+        notify_queue_if_needed(receive_queue.queue_index);
+    }
+
+    read_link_status();
+
+    dmesgln("{}: Found @ {}, MAC {}, {} queue pair(s), checksum offload: {}, segmentation offload: {}",
+        class_name(), pci_address(), mac_address().to_string(), queue_pair_count,
+        has_tcp_checksum_offload(), tcp_segmentation_offload_size() != 0);
+    return true;
+}
+
+UNMAP_AFTER_INIT bool VirtIONetworkAdapter::set_active_queue_pair_count(u16 queue_pair_count)
+{
+    VERIFY(m_control_queue_index.has_value());
+    auto control_queue_index = m_control_queue_index.value();
+    auto& queue = get_queue(control_queue_index);
+
+    // NOTE: The control queue is polled, so we don't want to hear about it.
+    queue.disable_interrupts();
+
+    auto* command = reinterpret_cast<VirtIONetControlCommand*>(m_control_buffer->vaddr().as_ptr());
+    command->command_class = VIRTIO_NET_CTRL_MQ;
+    command->command = VIRTIO_NET_CTRL_MQ_VQ_PAIRS_SET;
+    command->virtqueue_pairs = queue_pair_count;
+    auto* ack = m_control_buffer->vaddr().offset(control_command_ack_offset).as_ptr();
+    *ack = ~VIRTIO_NET_OK;
+
+    auto buffer_address = m_control_buffer->physical_page(0)->paddr();
+    {
+        SpinlockLocker locker(queue.lock());
+        VirtIO::QueueChain chain(queue);
+        chain.add_buffer_to_chain(buffer_address, sizeof(VirtIONetControlCommand), VirtIO::BufferType::DeviceReadable);
+        chain.add_buffer_to_chain(buffer_address.offset(control_command_ack_offset), sizeof(u8), VirtIO::BufferType::DeviceWritable);
+        supply_chain_and_notify(control_queue_index, chain);
+    }
+
+    // Give the device up to a second to answer.
+    for (size_t attempt = 0; attempt < 10000; ++attempt) {
+        {
+            SpinlockLocker locker(queue.lock());
+            size_t used = 0;
+            auto chain = queue.pop_used_buffer_chain(used);
+            if (!chain.is_empty()) {
+                chain.release_buffer_slots_to_queue();
+                return *ack == VIRTIO_NET_OK;
+            }
+        }
+        IO::delay(100);
+    }
+    return false;
+}
+
+UNMAP_AFTER_INIT ErrorOr<void> VirtIONetworkAdapter::create_queue_buffers(u16 queue_pair_count)
+{
+    // NOTE: The interrupt handler looks at these, so they must never be reallocated.
+    TRY(m_receive_queues.try_ensure_capacity(queue_pair_count));
+    TRY(m_transmit_queues.try_ensure_capacity(queue_pair_count));
+
+    for (u16 i = 0; i < queue_pair_count; ++i) {
+        ReceiveQueue receive_queue;
+        receive_queue.queue_index = 2 * i;
+        receive_queue.buffers = TRY(MM.allocate_contiguous_kernel_region(buffers_per_queue * PAGE_SIZE, "VirtIONetworkAdapter RX"sv, Memory::Region::Access::ReadWrite));
+        if (is_feature_accepted(VIRTIO_NET_F_MRG_RXBUF))
+            receive_queue.reassembly_buffer = TRY(KBuffer::try_create_with_size(max_frame_size, Memory::Region::Access::ReadWrite, "VirtIONetworkAdapter RX Reassembly"sv, AllocationStrategy::AllocateNow));
+
+        TransmitQueue transmit_queue;
+        transmit_queue.queue_index = 2 * i + 1;
+        transmit_queue.buffers = TRY(MM.allocate_contiguous_kernel_region(buffers_per_queue * PAGE_SIZE, "VirtIONetworkAdapter TX"sv, Memory::Region::Access::ReadWrite));
+        TRY(transmit_queue.free_buffer_indices.try_ensure_capacity(buffers_per_queue));
+        for (size_t buffer_index = 0; buffer_index < buffers_per_queue; ++buffer_index)
+            transmit_queue.free_buffer_indices.unchecked_append(buffer_index);
+        // NOTE: Finished transmissions are collected whenever we send something, so we only
+        //       ask for an interrupt while somebody waits for buffers to become free.
+        get_queue(transmit_queue.queue_index).disable_interrupts();
+
+        m_receive_queues.unchecked_append(move(receive_queue));
+        m_transmit_queues.unchecked_append(move(transmit_queue));
+    }
+    return {};
+}
+
+void VirtIONetworkAdapter::read_link_status()
+{
+    auto const* device_config = get_config(VirtIO::ConfigurationType::Device);
+    VERIFY(device_config);
+    read_config_atomic([&] {
+        // Without the status field, the link is assumed to always be up.
+        m_link_up = !is_feature_accepted(VIRTIO_NET_F_STATUS) || (config_read16(*device_config, DEVICE_CONFIG_STATUS) & VIRTIO_NET_S_LINK_UP);
+        if (is_feature_accepted(VIRTIO_NET_F_SPEED_DUPLEX)) {
+            u32 speed = config_read32(*device_config, DEVICE_CONFIG_SPEED);
+            m_link_speed = speed > static_cast<u32>(NumericLimits<i32>::max()) ? LINKSPEED_INVALID : static_cast<i32>(speed);
+            m_link_full_duplex = config_read8(*device_config, DEVICE_CONFIG_DUPLEX) == 1;
+        }
+    });
+}
+
+bool VirtIONetworkAdapter::has_tcp_checksum_offload() const
+{
+    return is_feature_accepted(VIRTIO_NET_F_CSUM);
+}
+
+size_t VirtIONetworkAdapter::tcp_segmentation_offload_size() const
+{
+    return is_feature_accepted(VIRTIO_NET_F_HOST_TSO4) ? max_tcp_segmentation_offload_size : 0;
+}
+
+bool VirtIONetworkAdapter::handle_device_config_change()
+{
+    read_link_status();
+    return true;
+}
+
+void VirtIONetworkAdapter::handle_queue_update(u16 queue_index)
+{
+    if (m_control_queue_index.has_value() && m_control_queue_index.value() == queue_index)
+        return;
+    // NOTE: The device may offer more queue pairs than we use.
+    size_t queue_pair_index = queue_index / 2;
+    if (queue_pair_index >= m_receive_queues.size())
+        return;
+
+    if (queue_index % 2 == 0) {
+        receive(m_receive_queues[queue_pair_index]);
+        return;
+    }
+
+    auto& transmit_queue = m_transmit_queues[queue_pair_index];
+    {
+        SpinlockLocker locker(get_queue(queue_index).lock());
+        reclaim_transmit_buffers(transmit_queue);
+    }
+    m_transmit_wait_queue.wake_all();
+}
+
+void VirtIONetworkAdapter::supply_receive_buffer(ReceiveQueue& receive_queue, size_t buffer_index)
+{
+    auto& queue = get_queue(receive_queue.queue_index);
+    VirtIO::QueueChain chain(queue);
+    auto buffer_address = receive_queue.buffers->physical_page(0)->paddr().offset(buffer_index * PAGE_SIZE);
+    if (!chain.add_buffer_to_chain(buffer_address, PAGE_SIZE, VirtIO::BufferType::DeviceWritable))
+        return;
+    supply_chain(receive_queue.queue_index, chain);
+}
+
+void VirtIONetworkAdapter::receive(ReceiveQueue& receive_queue)
+{
+    auto& queue = get_queue(receive_queue.queue_index);
+    auto buffers_address = receive_queue.buffers->physical_page(0)->paddr();
+
+    SpinlockLocker locker(queue.lock());
+    size_t used = 0;
+    for (auto chain = queue.pop_used_buffer_chain(used); !chain.is_empty(); chain = queue.pop_used_buffer_chain(used)) {
+        size_t buffer_index = 0;
+        chain.for_each([&](PhysicalAddress address, size_t) {
+            buffer_index = (address.get() - buffers_address.get()) / PAGE_SIZE;
+        });
+        chain.release_buffer_slots_to_queue();
+
+        auto* buffer = receive_queue.buffers->vaddr().offset(buffer_index * PAGE_SIZE).as_ptr();
+        receive_buffer(receive_queue, { buffer, min(used, PAGE_SIZE) });
+        // Everything has been copied out of the buffer, so the device can have it back right away.
+        supply_receive_buffer(receive_queue, buffer_index);
+    }
+    notify_queue_if_needed(receive_queue.queue_index);
+}
+
+void VirtIONetworkAdapter::receive_buffer(ReceiveQueue& receive_queue, ReadonlyBytes buffer)
+{
+    auto append_to_packet = [&](ReadonlyBytes bytes) {
+        if (receive_queue.is_dropping_packet)
+            return;
+        if (receive_queue.reassembled_size + bytes.size() > receive_queue.reassembly_buffer->size()) {
+            dbgln("{}: Dropping oversized packet", class_name());
+            receive_queue.is_dropping_packet = true;
+            return;
+        }
+        memcpy(receive_queue.reassembly_buffer->data() + receive_queue.reassembled_size, bytes.data(), bytes.size());
+        receive_queue.reassembled_size += bytes.size();
+    };
+
+    if (receive_queue.remaining_buffer_count > 0) {
+        append_to_packet(buffer);
+        if (--receive_queue.remaining_buffer_count == 0 && !receive_queue.is_dropping_packet)
+            did_receive({ receive_queue.reassembly_buffer->data(), receive_queue.reassembled_size });
+        return;
+    }
+
+    // This is the first buffer of a packet, which starts out with the header.
+    if (buffer.size() < sizeof(VirtIONetHeader))
+        return;
+    VirtIONetHeader header;
+    memcpy(&header, buffer.data(), sizeof(header));
+    auto frame = buffer.slice(sizeof(VirtIONetHeader));
+
+    // NOTE: With GUEST_CSUM, the device may leave transport checksums unfinished (VIRTIO_NET_HDR_F_NEEDS_CSUM)
+    //       for packets that never left the host. We don't verify those checksums on receive, so that's fine.
+    u16 buffer_count = is_feature_accepted(VIRTIO_NET_F_MRG_RXBUF) ? header.buffer_count : 1;
+    if (buffer_count <= 1) {
+        did_receive(frame);
+        return;
+    }
+
+    receive_queue.remaining_buffer_count = buffer_count - 1;
+    receive_queue.reassembled_size = 0;
+    receive_queue.is_dropping_packet = false;
+    append_to_packet(frame);
+}
+
+void VirtIONetworkAdapter::send_raw(ReadonlyBytes frame)
+{
+    transmit(frame, {});
+}
+
+void VirtIONetworkAdapter::send_raw_with_offloads(ReadonlyBytes frame, TransmitOffloads const& offloads)
+{
+    transmit(frame, offloads);
+}
+
+VirtIONetworkAdapter::TransmitQueue& VirtIONetworkAdapter::transmit_queue_for(ReadonlyBytes frame)
+{
+    if (m_transmit_queues.size() == 1)
+        return m_transmit_queues[0];
+
+    // Keep all packets of a flow on the same queue, so that they can't overtake each other.
+    u32 hash = 0;
+    if (frame.size() >= sizeof(EthernetFrameHeader) + sizeof(IPv4Packet)) {
+        auto& eth = *(EthernetFrameHeader const*)frame.data();
+        if (eth.ether_type() == EtherType::IPv4) {
+            auto& ipv4 = *(IPv4Packet const*)eth.payload();
+            hash = pair_int_hash(ipv4.source().to_u32(), ipv4.destination().to_u32());
+            auto ports_offset = sizeof(EthernetFrameHeader) + ipv4.internet_header_length() * sizeof(u32);
+            bool has_ports = ipv4.protocol() == (u8)IPv4Protocol::TCP || ipv4.protocol() == (u8)IPv4Protocol::UDP;
+            if (has_ports && frame.size() >= ports_offset + sizeof(u32)) {
+                u32 ports;
+                memcpy(&ports, frame.offset_pointer(ports_offset), sizeof(ports));
+                hash = pair_int_hash(hash, ports);
+            }
+        }
+    }
+    return m_transmit_queues[hash % m_transmit_queues.size()];
+}
+
+void VirtIONetworkAdapter::set_waiting_for_transmit_buffers(TransmitQueue& transmit_queue, bool waiting)
+{
+    SpinlockLocker locker(m_transmit_waiters_lock);
+    auto& queue = get_queue(transmit_queue.queue_index);
+    if (waiting) {
+        if (transmit_queue.waiter_count++ == 0)
+            queue.enable_interrupts();
+    } else {
+        VERIFY(transmit_queue.waiter_count > 0);
+        if (--transmit_queue.waiter_count == 0)
+            queue.disable_interrupts();
+    }
+}
+
+void VirtIONetworkAdapter::transmit(ReadonlyBytes frame, TransmitOffloads const& offloads)
+{
+    VERIFY(frame.size() <= max_frame_size);
+    auto& transmit_queue = transmit_queue_for(frame);
+    auto& queue = get_queue(transmit_queue.queue_index);
+
+    bool is_waiting = false;
+    for (;;) {
+        bool did_queue_frame = false;
+        {
+            SpinlockLocker locker(queue.lock());
+            reclaim_transmit_buffers(transmit_queue);
+            did_queue_frame = try_to_queue_frame(transmit_queue, frame, offloads);
+        }
+        if (did_queue_frame)
+            break;
+        if (!is_waiting) {
+            // Ask for an interrupt once the device is done with something, then look again,
+            // in case it already was before it knew that we wanted to hear about it.
+            set_waiting_for_transmit_buffers(transmit_queue, true);
+            is_waiting = true;
+            continue;
+        }
+        m_transmit_wait_queue.wait_forever("VirtIONetworkAdapter"sv);
+    }
+    if (is_waiting)
+        set_waiting_for_transmit_buffers(transmit_queue, false);
+}
+
+bool VirtIONetworkAdapter::try_to_queue_frame(TransmitQueue& transmit_queue, ReadonlyBytes frame, TransmitOffloads const& offloads)
+{
+    auto& queue = get_queue(transmit_queue.queue_index);
+    VERIFY(queue.lock().is_locked());
+
+    size_t total_size = sizeof(VirtIONetHeader) + frame.size();
+    size_t buffer_count = ceil_div(total_size, static_cast<size_t>(PAGE_SIZE));
+    if (transmit_queue.free_buffer_indices.size() < buffer_count)
+        return false;
+
+    VirtIONetHeader header {};
+    if (offloads.tcp_checksum) {
+        auto& ipv4 = *(IPv4Packet const*)(frame.data() + sizeof(EthernetFrameHeader));
+        u16 tcp_offset = sizeof(EthernetFrameHeader) + ipv4.internet_header_length() * sizeof(u32);
+        header.flags = VIRTIO_NET_HDR_F_NEEDS_CSUM;
+        header.checksum_start = tcp_offset;
+        header.checksum_offset = TCP_CHECKSUM_OFFSET;
+        if (offloads.tcp_segment_size != 0) {
+            auto& tcp = *(TCPPacket const*)(frame.data() + tcp_offset);
+            header.gso_type = VIRTIO_NET_HDR_GSO_TCPV4;
+            header.header_length = tcp_offset + tcp.header_size();
+            header.gso_size = offloads.tcp_segment_size;
+        }
+    }
+
+    // The header and the frame go out back to back, cut into page-sized buffers.
+    auto copy_to_buffer = [&](u8* destination, size_t offset, size_t size) {
+        if (offset < sizeof(header)) {
+            auto header_part_size = min(sizeof(header) - offset, size);
+            memcpy(destination, reinterpret_cast<u8 const*>(&header) + offset, header_part_size);
+            destination += header_part_size;
+            offset += header_part_size;
+            size -= header_part_size;
+        }
+        memcpy(destination, frame.offset_pointer(offset - sizeof(header)), size);
+    };
+
+    auto buffers_address = transmit_queue.buffers->physical_page(0)->paddr();
+    VirtIO::QueueChain chain(queue);
+    for (size_t offset = 0; offset < total_size; offset += PAGE_SIZE) {
+        auto buffer_index = transmit_queue.free_buffer_indices.take_last();
+        auto size = min(static_cast<size_t>(PAGE_SIZE), total_size - offset);
+        copy_to_buffer(transmit_queue.buffers->vaddr().offset(buffer_index * PAGE_SIZE).as_ptr(), offset, size);
+        if (!chain.add_buffer_to_chain(buffers_address.offset(buffer_index * PAGE_SIZE), size, VirtIO::BufferType::DeviceReadable)) {
+            // We ran out of descriptors, so hand back everything we took.
+            transmit_queue.free_buffer_indices.unchecked_append(buffer_index);
+            chain.for_each([&](PhysicalAddress address, size_t) {
+                transmit_queue.free_buffer_indices.unchecked_append((address.get() - buffers_address.get()) / PAGE_SIZE);
+            });
+            chain.release_buffer_slots_to_queue();
+            return false;
+        }
+    }
+    supply_chain(transmit_queue.queue_index, chain);
+    notify_queue_if_needed(transmit_queue.queue_index);
+    return true;
+}
+
+void VirtIONetworkAdapter::reclaim_transmit_buffers(TransmitQueue& transmit_queue)
+{
+    auto& queue = get_queue(transmit_queue.queue_index);
+    VERIFY(queue.lock().is_locked());
+    auto buffers_address = transmit_queue.buffers->physical_page(0)->paddr();
+    size_t used = 0;
+    for (auto chain = queue.pop_used_buffer_chain(used); !chain.is_empty(); chain = queue.pop_used_buffer_chain(used)) {
+        chain.for_each([&](PhysicalAddress address, size_t) {
+            transmit_queue.free_buffer_indices.unchecked_append((address.get() - buffers_address.get()) / PAGE_SIZE);
+        });
+        chain.release_buffer_slots_to_queue();
+    }
+}
+
+}
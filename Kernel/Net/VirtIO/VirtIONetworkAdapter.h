@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Optional.h>
+#include <AK/OwnPtr.h>
+#include <AK/Vector.h>
+#include <Kernel/Bus/VirtIO/Device.h>
+#include <Kernel/KBuffer.h>
+#include <Kernel/Locking/Spinlock.h>
+#include <Kernel/Net/NetworkAdapter.h>
+#include <Kernel/WaitQueue.h>
+
+namespace Kernel {
+
+class VirtIONetworkAdapter final
+    : public NetworkAdapter
+    , public VirtIO::Device {
+public:
+    static RefPtr<VirtIONetworkAdapter> try_to_initialize(PCI::DeviceIdentifier const&);
+
+    virtual ~VirtIONetworkAdapter() override = default;
+
+    virtual StringView class_name() const override { return "VirtIONetworkAdapter"sv; }
+    virtual StringView purpose() const override { return class_name(); }
+
+    virtual bool link_up() override { return m_link_up; }
+    virtual i32 link_speed() override { return m_link_speed; }
+    virtual bool link_full_duplex() override { return m_link_full_duplex; }
+
+    virtual bool has_tcp_checksum_offload() const override;
+    virtual size_t tcp_segmentation_offload_size() const override;
+
+private:
+    // Every queue owns a physically contiguous pool of page-sized buffers, so that the
+    // addresses the device hands back can be turned into buffer indices.
+    struct ReceiveQueue {
+        u16 queue_index { 0 };
+        OwnPtr<Memory::Region> buffers;
+        // With mergeable receive buffers, a packet can be spread over several of them.
+        OwnPtr<KBuffer> reassembly_buffer;
+        size_t reassembled_size { 0 };
+        u16 remaining_buffer_count { 0 };
+        bool is_dropping_packet { false };
+    };
+
+    struct TransmitQueue {
+        u16 queue_index { 0 };
+        OwnPtr<Memory::Region> buffers;
+        Vector<u16> free_buffer_indices;
+        // Guarded by m_transmit_waiters_lock.
+        u32 waiter_count { 0 };
+    };
+
+    VirtIONetworkAdapter(PCI::DeviceIdentifier const&, NonnullOwnPtr<KString>);
+
+    bool initialize_adapter();
+    bool set_active_queue_pair_count(u16);
+    ErrorOr<void> create_queue_buffers(u16 queue_pair_count);
+    void read_link_status();
+
+    virtual bool handle_device_config_change() override;
+    virtual void handle_queue_update(u16 queue_index) override;
+
+    virtual void send_raw(ReadonlyBytes) override;
+    virtual void send_raw_with_offloads(ReadonlyBytes, TransmitOffloads const&) override;
+    void transmit(ReadonlyBytes frame, TransmitOffloads const&);
+    TransmitQueue& transmit_queue_for(ReadonlyBytes frame);
+    bool try_to_queue_frame(TransmitQueue&, ReadonlyBytes frame, TransmitOffloads const&);
+    void reclaim_transmit_buffers(TransmitQueue&);
+    void set_waiting_for_transmit_buffers(TransmitQueue&, bool);
+
+    void supply_receive_buffer(ReceiveQueue&, size_t buffer_index);
+    void receive(ReceiveQueue&);
+    void receive_buffer(ReceiveQueue&, ReadonlyBytes);
+
+    Vector<ReceiveQueue> m_receive_queues;
+    Vector<TransmitQueue> m_transmit_queues;
+    Optional<u16> m_control_queue_index;
+    OwnPtr<Memory::Region> m_control_buffer;
+
+    Spinlock m_transmit_waiters_lock;
+    WaitQueue m_transmit_wait_queue;
+
+    bool m_link_up { false };
+    i32 m_link_speed { LINKSPEED_INVALID };
+    bool m_link_full_duplex { false };
+};
+
+}
@@ -7,18 +7,58 @@
 #include <AK/JsonArraySerializer.h>
 #include <AK/JsonObjectSerializer.h>
 #include <AK/ScopeGuard.h>
+#include <AK/StringBuilder.h>
 #include <Kernel/Arch/RegisterState.h>
 #include <Kernel/Arch/SmapDisabler.h>
 #include <Kernel/FileSystem/Custody.h>
 #include <Kernel/KBufferBuilder.h>
 #include <Kernel/PerformanceEventBuffer.h>
 #include <Kernel/Process.h>
+#include <Kernel/Scheduler.h>
 
 namespace Kernel {
 
-PerformanceEventBuffer::PerformanceEventBuffer(NonnullOwnPtr<KBuffer> buffer)
+PerformanceEventBuffer::PerformanceEventBuffer(NonnullOwnPtr<KBuffer> buffer, size_t ring_size, u32 scheduled_ring_count)
     : m_buffer(move(buffer))
+    , m_ring_size(ring_size)
+    , m_scheduled_ring_count(scheduled_ring_count)
 {
+    for (u32 processor = 0; processor < Processor::count(); ++processor) {
+        auto& ring = this->ring(processor);
+        new (&ring) Ring;
+        ring.capacity = (this->ring_size(processor) - sizeof(Ring)) / sizeof(Slot);
+        VERIFY(ring.capacity > 0);
+        for (size_t i = 0; i < ring.capacity; ++i)
+            new (&ring.slot_at(i).sequence) Atomic<size_t>(0);
+    }
+}
+
+void PerformanceEventBuffer::clear()
+{
+    // NOTE: This may race with writers on other processors, in which case their events either
+    //       survive the clear or are dropped. Both are fine when (re)starting a profile.
+    for (u32 processor = 0; processor < Processor::count(); ++processor) {
+        auto& ring = this->ring(processor);
+        ring.tail.store(ring.head.load(AK::MemoryOrder::memory_order_acquire), AK::MemoryOrder::memory_order_release);
+    }
+}
+
+size_t PerformanceEventBuffer::capacity() const
+{
+    size_t capacity = 0;
+    for (u32 processor = 0; processor < Processor::count(); ++processor)
+        capacity += ring(processor).capacity;
+    return capacity;
+}
+
+size_t PerformanceEventBuffer::count() const
+{
+    size_t count = 0;
+    for (u32 processor = 0; processor < Processor::count(); ++processor) {
+        auto& ring = this->ring(processor);
+        count += ring.head.load(AK::MemoryOrder::memory_order_relaxed) - ring.tail.load(AK::MemoryOrder::memory_order_relaxed);
+    }
+    return count;
 }
 
 NEVER_INLINE ErrorOr<void> PerformanceEventBuffer::append(int type, FlatPtr arg1, FlatPtr arg2, StringView arg3, Thread* current_thread)
@@ -80,9 +120,6 @@ ErrorOr<void> PerformanceEventBuffer::append_with_ip_and_bp(ProcessID pid, Threa
 ErrorOr<void> PerformanceEventBuffer::append_with_ip_and_bp(ProcessID pid, ThreadID tid,
     FlatPtr ip, FlatPtr bp, int type, u32 lost_samples, FlatPtr arg1, FlatPtr arg2, StringView arg3)
 {
-    if (count() >= capacity())
-        return ENOBUFS;
-
     if ((g_profiling_event_mask & type) == 0)
         return EINVAL;
 
@@ -175,15 +212,145 @@ ErrorOr<void> PerformanceEventBuffer::append_with_ip_and_bp(ProcessID pid, Threa
     event.pid = pid.value();
     event.tid = tid.value();
     event.timestamp = TimeManagement::the().uptime_ms();
-    at(m_count++) = event;
+
+    // Stay on this processor until the event has been published to its ring.
+    ScopedCritical critical;
+    auto& ring = this->ring(Processor::current_id());
+    auto index = ring.head.load(AK::MemoryOrder::memory_order_relaxed);
+    do {
+        if (index - ring.tail.load(AK::MemoryOrder::memory_order_acquire) >= ring.capacity)
+            return ENOBUFS;
+    } while (!ring.head.compare_exchange_strong(index, index + 1, AK::MemoryOrder::memory_order_acq_rel));
+
+    auto& slot = ring.slot_at(index);
+    slot.event = event;
+    slot.sequence.store(index + 1, AK::MemoryOrder::memory_order_release);
     return {};
 }
 
-PerformanceEvent& PerformanceEventBuffer::at(size_t index)
+template<typename Callback>
+void PerformanceEventBuffer::for_each_event_in_order(bool consume, Callback callback) const
 {
-    VERIFY(index < capacity());
-    auto* events = reinterpret_cast<PerformanceEvent*>(m_buffer->data());
-    return events[index];
+    VERIFY(m_lock.is_locked());
+
+    Vector<size_t, 32> cursors;
+    for (u32 processor = 0; processor < Processor::count(); ++processor) {
+        if (cursors.try_append(ring(processor).tail.load(AK::MemoryOrder::memory_order_acquire)).is_error())
+            return;
+    }
+
+    for (;;) {
+        // Find the oldest published event at the front of any ring. Each ring is already in order.
+        Optional<u32> next_processor;
+        u64 next_timestamp = 0;
+        for (u32 processor = 0; processor < cursors.size(); ++processor) {
+            auto& slot = ring(processor).slot_at(cursors[processor]);
+            if (slot.sequence.load(AK::MemoryOrder::memory_order_acquire) != cursors[processor] + 1)
+                continue;
+            if (!next_processor.has_value() || slot.event.timestamp < next_timestamp) {
+                next_processor = processor;
+                next_timestamp = slot.event.timestamp;
+            }
+        }
+        if (!next_processor.has_value())
+            return;
+
+        auto& ring = this->ring(*next_processor);
+        auto& cursor = cursors[*next_processor];
+        if (callback(ring.slot_at(cursor).event) == IterationDecision::Break)
+            return;
+        // If the ring was cleared under us, it's not ours to advance anymore.
+        if (consume && !ring.tail.compare_exchange_strong(cursor, cursor + 1, AK::MemoryOrder::memory_order_release))
+            return;
+        ++cursor;
+    }
+}
+
+template<typename Serializer>
+static void serialize_event(Serializer& event_object, PerformanceEvent const& event, bool show_kernel_addresses, bool seen_first_sample)
+{
+    switch (event.type) {
+    case PERF_EVENT_SAMPLE:
+        event_object.add("type", "sample");
+        break;
+    case PERF_EVENT_MALLOC:
+        event_object.add("type", "malloc");
+        event_object.add("ptr", static_cast<u64>(event.data.malloc.ptr));
+        event_object.add("size", static_cast<u64>(event.data.malloc.size));
+        break;
+    case PERF_EVENT_FREE:
+        event_object.add("type", "free");
+        event_object.add("ptr", static_cast<u64>(event.data.free.ptr));
+        break;
+    case PERF_EVENT_MMAP:
+        event_object.add("type", "mmap");
+        event_object.add("ptr", static_cast<u64>(event.data.mmap.ptr));
+        event_object.add("size", static_cast<u64>(event.data.mmap.size));
+        event_object.add("name", event.data.mmap.name);
+        break;
+    case PERF_EVENT_MUNMAP:
+        event_object.add("type", "munmap");
+        event_object.add("ptr", static_cast<u64>(event.data.munmap.ptr));
+        event_object.add("size", static_cast<u64>(event.data.munmap.size));
+        break;
+    case PERF_EVENT_PROCESS_CREATE:
+        event_object.add("type", "process_create");
+        event_object.add("parent_pid", static_cast<u64>(event.data.process_create.parent_pid));
+        event_object.add("executable", event.data.process_create.executable);
+        break;
+    case PERF_EVENT_PROCESS_EXEC:
+        event_object.add("type", "process_exec");
+        event_object.add("executable", event.data.process_exec.executable);
+        break;
+    case PERF_EVENT_PROCESS_EXIT:
+        event_object.add("type", "process_exit");
+        break;
+    case PERF_EVENT_THREAD_CREATE:
+        event_object.add("type", "thread_create");
+        event_object.add("parent_tid", static_cast<u64>(event.data.thread_create.parent_tid));
+        break;
+    case PERF_EVENT_THREAD_EXIT:
+        event_object.add("type", "thread_exit");
+        break;
+    case PERF_EVENT_CONTEXT_SWITCH:
+        event_object.add("type", "context_switch");
+        event_object.add("next_pid", static_cast<u64>(event.data.context_switch.next_pid));
+        event_object.add("next_tid", static_cast<u64>(event.data.context_switch.next_tid));
+        break;
+    case PERF_EVENT_KMALLOC:
+        event_object.add("type", "kmalloc");
+        event_object.add("ptr", static_cast<u64>(event.data.kmalloc.ptr));
+        event_object.add("size", static_cast<u64>(event.data.kmalloc.size));
+        break;
+    case PERF_EVENT_KFREE:
+        event_object.add("type", "kfree");
+        event_object.add("ptr", static_cast<u64>(event.data.kfree.ptr));
+        event_object.add("size", static_cast<u64>(event.data.kfree.size));
+        break;
+    case PERF_EVENT_PAGE_FAULT:
+        event_object.add("type", "page_fault");
+        break;
+    case PERF_EVENT_SYSCALL:
+        event_object.add("type", "syscall");
+        break;
+    case PERF_EVENT_SIGNPOST:
+        event_object.add("type"sv, "signpost"sv);
+        event_object.add("arg1"sv, event.data.signpost.arg1);
+        event_object.add("arg2"sv, event.data.signpost.arg2);
+        break;
+    }
+    event_object.add("pid", event.pid);
+    event_object.add("tid", event.tid);
+    event_object.add("timestamp", event.timestamp);
+    event_object.add("lost_samples", seen_first_sample ? event.lost_samples : 0);
+    auto stack_array = event_object.add_array("stack");
+    for (size_t j = 0; j < event.stack_size; ++j) {
+        auto address = event.stack[j];
+        if (!show_kernel_addresses && !Memory::is_user_address(VirtualAddress { address }))
+            address = 0xdeadc0de;
+        stack_array.add(address);
+    }
+    stack_array.finish();
 }
 
 template<typename Serializer>
@@ -199,101 +366,19 @@ ErrorOr<void> PerformanceEventBuffer::to_json_impl(Serializer& object) const
     bool show_kernel_addresses = Process::current().is_superuser();
     auto array = object.add_array("events");
     bool seen_first_sample = false;
-    for (size_t i = 0; i < m_count; ++i) {
-        auto const& event = at(i);
-
+    for_each_event_in_order(false, [&](PerformanceEvent const& event) {
         if (!show_kernel_addresses) {
             if (event.type == PERF_EVENT_KMALLOC || event.type == PERF_EVENT_KFREE)
-                continue;
+                return IterationDecision::Continue;
         }
 
         auto event_object = array.add_object();
-        switch (event.type) {
-        case PERF_EVENT_SAMPLE:
-            event_object.add("type", "sample");
-            break;
-        case PERF_EVENT_MALLOC:
-            event_object.add("type", "malloc");
-            event_object.add("ptr", static_cast<u64>(event.data.malloc.ptr));
-            event_object.add("size", static_cast<u64>(event.data.malloc.size));
-            break;
-        case PERF_EVENT_FREE:
-            event_object.add("type", "free");
-            event_object.add("ptr", static_cast<u64>(event.data.free.ptr));
-            break;
-        case PERF_EVENT_MMAP:
-            event_object.add("type", "mmap");
-            event_object.add("ptr", static_cast<u64>(event.data.mmap.ptr));
-            event_object.add("size", static_cast<u64>(event.data.mmap.size));
-            event_object.add("name", event.data.mmap.name);
-            break;
-        case PERF_EVENT_MUNMAP:
-            event_object.add("type", "munmap");
-            event_object.add("ptr", static_cast<u64>(event.data.munmap.ptr));
-            event_object.add("size", static_cast<u64>(event.data.munmap.size));
-            break;
-        case PERF_EVENT_PROCESS_CREATE:
-            event_object.add("type", "process_create");
-            event_object.add("parent_pid", static_cast<u64>(event.data.process_create.parent_pid));
-            event_object.add("executable", event.data.process_create.executable);
-            break;
-        case PERF_EVENT_PROCESS_EXEC:
-            event_object.add("type", "process_exec");
-            event_object.add("executable", event.data.process_exec.executable);
-            break;
-        case PERF_EVENT_PROCESS_EXIT:
-            event_object.add("type", "process_exit");
-            break;
-        case PERF_EVENT_THREAD_CREATE:
-            event_object.add("type", "thread_create");
-            event_object.add("parent_tid", static_cast<u64>(event.data.thread_create.parent_tid));
-            break;
-        case PERF_EVENT_THREAD_EXIT:
-            event_object.add("type", "thread_exit");
-            break;
-        case PERF_EVENT_CONTEXT_SWITCH:
-            event_object.add("type", "context_switch");
-            event_object.add("next_pid", static_cast<u64>(event.data.context_switch.next_pid));
-            event_object.add("next_tid", static_cast<u64>(event.data.context_switch.next_tid));
-            break;
-        case PERF_EVENT_KMALLOC:
-            event_object.add("type", "kmalloc");
-            event_object.add("ptr", static_cast<u64>(event.data.kmalloc.ptr));
-            event_object.add("size", static_cast<u64>(event.data.kmalloc.size));
-            break;
-        case PERF_EVENT_KFREE:
-            event_object.add("type", "kfree");
-            event_object.add("ptr", static_cast<u64>(event.data.kfree.ptr));
-            event_object.add("size", static_cast<u64>(event.data.kfree.size));
-            break;
-        case PERF_EVENT_PAGE_FAULT:
-            event_object.add("type", "page_fault");
-            break;
-        case PERF_EVENT_SYSCALL:
-            event_object.add("type", "syscall");
-            break;
-        case PERF_EVENT_SIGNPOST:
-            event_object.add("type"sv, "signpost"sv);
-            event_object.add("arg1"sv, event.data.signpost.arg1);
-            event_object.add("arg2"sv, event.data.signpost.arg2);
-            break;
-        }
-        event_object.add("pid", event.pid);
-        event_object.add("tid", event.tid);
-        event_object.add("timestamp", event.timestamp);
-        event_object.add("lost_samples", seen_first_sample ? event.lost_samples : 0);
+        serialize_event(event_object, event, show_kernel_addresses, seen_first_sample);
+        event_object.finish();
         if (event.type == PERF_EVENT_SAMPLE)
             seen_first_sample = true;
-        auto stack_array = event_object.add_array("stack");
-        for (size_t j = 0; j < event.stack_size; ++j) {
-            auto address = event.stack[j];
-            if (!show_kernel_addresses && !Memory::is_user_address(VirtualAddress { address }))
-                address = 0xdeadc0de;
-            stack_array.add(address);
-        }
-        stack_array.finish();
-        event_object.finish();
-    }
+        return IterationDecision::Continue;
+    });
     array.finish();
     object.finish();
     return {};
@@ -301,16 +386,66 @@ ErrorOr<void> PerformanceEventBuffer::to_json_impl(Serializer& object) const
 
 ErrorOr<void> PerformanceEventBuffer::to_json(KBufferBuilder& builder) const
 {
+    MutexLocker locker(m_lock);
     JsonObjectSerializer object(builder);
     return to_json_impl(object);
 }
 
+ErrorOr<size_t> PerformanceEventBuffer::stream_json(UserOrKernelBuffer& buffer, size_t size)
+{
+    MutexLocker locker(m_lock);
+    bool show_kernel_addresses = Process::current().is_superuser();
+    size_t nwritten = 0;
+    bool did_not_fit = false;
+    ErrorOr<void> result;
+    StringBuilder builder;
+    for_each_event_in_order(true, [&](PerformanceEvent const& event) {
+        if (!show_kernel_addresses) {
+            if (event.type == PERF_EVENT_KMALLOC || event.type == PERF_EVENT_KFREE)
+                return IterationDecision::Continue;
+        }
+
+        builder.clear();
+        {
+            JsonObjectSerializer event_object(builder);
+            serialize_event(event_object, event, show_kernel_addresses, m_streamed_first_sample);
+        }
+        builder.append('\n');
+        // Never hand out partial events, they stay in the ring for the next read.
+        if (nwritten + builder.length() > size) {
+            did_not_fit = true;
+            return IterationDecision::Break;
+        }
+        result = buffer.write(builder.string_view().characters_without_null_termination(), nwritten, builder.length());
+        if (result.is_error())
+            return IterationDecision::Break;
+        nwritten += builder.length();
+        if (event.type == PERF_EVENT_SAMPLE)
+            m_streamed_first_sample = true;
+        return IterationDecision::Continue;
+    });
+    if (nwritten > 0)
+        return nwritten;
+    TRY(result);
+    // A read that can't hold even a single event would otherwise look like the end of the stream.
+    if (did_not_fit)
+        return EINVAL;
+    return 0;
+}
+
 OwnPtr<PerformanceEventBuffer> PerformanceEventBuffer::try_create_with_size(size_t buffer_size)
 {
-    auto buffer_or_error = KBuffer::try_create_with_size(buffer_size, Memory::Region::Access::ReadWrite, "Performance events", AllocationStrategy::AllocateNow);
+    // Each processor that runs threads gets its own page-aligned share of the buffer, so that rings don't share cache lines.
+    auto scheduled_ring_count = min(Scheduler::scheduled_processor_count(), Processor::count());
+    auto ring_size_or_error = Memory::page_round_up(buffer_size / scheduled_ring_count);
+    if (ring_size_or_error.is_error())
+        return {};
+    auto ring_size = ring_size_or_error.release_value();
+    auto total_size = ring_size * scheduled_ring_count + unscheduled_ring_size * (Processor::count() - scheduled_ring_count);
+    auto buffer_or_error = KBuffer::try_create_with_size(total_size, Memory::Region::Access::ReadWrite, "Performance events", AllocationStrategy::AllocateNow);
     if (buffer_or_error.is_error())
         return {};
-    return adopt_own_if_nonnull(new (nothrow) PerformanceEventBuffer(buffer_or_error.release_value()));
+    return adopt_own_if_nonnull(new (nothrow) PerformanceEventBuffer(buffer_or_error.release_value(), ring_size, scheduled_ring_count));
 }
 
 ErrorOr<void> PerformanceEventBuffer::add_process(const Process& process, ProcessEventType event_type)
@@ -345,6 +480,7 @@ ErrorOr<void> PerformanceEventBuffer::add_process(const Process& process, Proces
 
 ErrorOr<FlatPtr> PerformanceEventBuffer::register_string(NonnullOwnPtr<KString> string)
 {
+    MutexLocker locker(m_lock);
     FlatPtr string_id = m_strings.size();
     TRY(m_strings.try_set(move(string)));
     return string_id;
@@ -6,8 +6,10 @@
 
 #pragma once
 
+#include <AK/Atomic.h>
 #include <AK/Error.h>
 #include <Kernel/KBuffer.h>
+#include <Kernel/Locking/Mutex.h>
 
 namespace Kernel {
 
@@ -97,6 +99,13 @@ enum class ProcessEventType {
     Exec
 };
 
+// Events are recorded into one ring per processor, so CPUs never contend with each other
+// while recording. A writer only ever touches the ring of the processor it's running on,
+// and claims its slot with an atomic increment so that it can be interrupted by another
+// writer on the same processor (e.g. the profiling timer).
+//
+// Readers merge the rings by timestamp. to_json() leaves the events in place, while
+// stream_json() consumes them so that the rings can be refilled while a profile runs.
 class PerformanceEventBuffer {
 public:
     static OwnPtr<PerformanceEventBuffer> try_create_with_size(size_t buffer_size);
@@ -107,36 +116,68 @@ public:
     ErrorOr<void> append_with_ip_and_bp(ProcessID pid, ThreadID tid, const RegisterState& regs,
         int type, u32 lost_samples, FlatPtr arg1, FlatPtr arg2, StringView arg3);
 
-    void clear()
-    {
-        m_count = 0;
-    }
+    void clear();
 
-    size_t capacity() const { return m_buffer->size() / sizeof(PerformanceEvent); }
-    size_t count() const { return m_count; }
-    const PerformanceEvent& at(size_t index) const
-    {
-        return const_cast<PerformanceEventBuffer&>(*this).at(index);
-    }
+    size_t capacity() const;
+    size_t count() const;
 
     ErrorOr<void> to_json(KBufferBuilder&) const;
 
+    // Consumes as many events as fit into `size` bytes, as one JSON object per line.
+    ErrorOr<size_t> stream_json(UserOrKernelBuffer&, size_t size);
+
     ErrorOr<void> add_process(const Process&, ProcessEventType event_type);
 
     ErrorOr<FlatPtr> register_string(NonnullOwnPtr<KString>);
 
 private:
-    explicit PerformanceEventBuffer(NonnullOwnPtr<KBuffer>);
+    struct Slot {
+        // Holds index + 1 once the event for the given ring index has been written.
+        Atomic<size_t> sequence;
+        PerformanceEvent event;
+    };
+
+    struct Ring {
+        // The next index to be claimed by a writer.
+        Atomic<size_t> head;
+        // The oldest index that hasn't been consumed by a reader yet.
+        Atomic<size_t> tail;
+        size_t capacity;
+
+        Slot& slot_at(size_t index) { return reinterpret_cast<Slot*>(this + 1)[index % capacity]; }
+    };
+
+    // Processors that don't run threads only ever record the odd event from an interrupt handler,
+    // so their rings are kept small and the requested size goes to the processors that do.
+    static constexpr size_t unscheduled_ring_size = PAGE_SIZE;
+
+    PerformanceEventBuffer(NonnullOwnPtr<KBuffer>, size_t ring_size, u32 scheduled_ring_count);
+
+    size_t ring_size(u32 processor) const { return processor < m_scheduled_ring_count ? m_ring_size : unscheduled_ring_size; }
+    size_t ring_offset(u32 processor) const
+    {
+        if (processor < m_scheduled_ring_count)
+            return processor * m_ring_size;
+        return m_scheduled_ring_count * m_ring_size + (processor - m_scheduled_ring_count) * unscheduled_ring_size;
+    }
+
+    // The rings are updated by writers no matter how the buffer itself is being accessed.
+    Ring& ring(u32 processor) const { return *reinterpret_cast<Ring*>(const_cast<u8*>(m_buffer->data()) + ring_offset(processor)); }
+
+    template<typename Callback>
+    void for_each_event_in_order(bool consume, Callback) const;
 
     template<typename Serializer>
     ErrorOr<void> to_json_impl(Serializer&) const;
 
-    PerformanceEvent& at(size_t index);
-
-    size_t m_count { 0 };
     NonnullOwnPtr<KBuffer> m_buffer;
+    size_t m_ring_size { 0 };
+    u32 m_scheduled_ring_count { 0 };
 
+    // Serializes readers and protects everything below. Writers never take it.
+    mutable Mutex m_lock;
     HashTable<NonnullOwnPtr<KString>> m_strings;
+    bool m_streamed_first_sample { false };
 };
 
 extern bool g_profiling_all_threads;
@@ -21,6 +21,7 @@
 #include <Kernel/FileSystem/Custody.h>
 #include <Kernel/FileSystem/OpenFileDescription.h>
 #include <Kernel/FileSystem/VirtualFileSystem.h>
+#include <Kernel/FutexTable.h>
 #include <Kernel/KBufferBuilder.h>
 #include <Kernel/KSyms.h>
 #include <Kernel/Memory/AnonymousVMObject.h>
@@ -145,7 +146,7 @@ ErrorOr<NonnullRefPtr<Process>> Process::try_create_user_process(RefPtr<Thread>&
     auto description = TRY(device_to_use_as_tty.open(O_RDWR));
     auto setup_description = [&process, &description](int fd) {
         process->m_fds.m_fds_metadatas[fd].allocate();
-        process->m_fds[fd].set(*description);
+        process->m_fds.set(fd, *description);
     };
     setup_description(0);
     setup_description(1);
@@ -235,7 +236,7 @@ Process::Process(NonnullOwnPtr<KString> name, UserID uid, GroupID gid, ProcessID
     dbgln_if(PROCESS_DEBUG, "Created new process {}({})", m_name, this->pid().value());
 }
 
-ErrorOr<void> Process::attach_resources(NonnullOwnPtr<Memory::AddressSpace>&& preallocated_space, RefPtr<Thread>& first_thread, Process* fork_parent)
+ErrorOr<void> Process::attach_resources(NonnullRefPtr<Memory::AddressSpace>&& preallocated_space, RefPtr<Thread>& first_thread, Process* fork_parent)
 {
     m_space = move(preallocated_space);
 
@@ -429,6 +430,38 @@ ErrorOr<NonnullRefPtr<OpenFileDescription>> Process::OpenFileDescriptions::open_
     return description.release_nonnull();
 }
 
+void Process::OpenFileDescriptions::set(int fd, NonnullRefPtr<OpenFileDescription>&& description, u32 flags)
+{
+    RefPtr<OpenFileDescription> replaced_description;
+    {
+        SpinlockLocker lock(m_fds_lock);
+        auto& metadata = m_fds_metadatas[fd];
+        // NOTE: dup2() may target an fd number that hasn't been allocated yet.
+        if (!metadata.is_allocated())
+            metadata.allocate();
+        replaced_description = metadata.description();
+        metadata.set(move(description), flags);
+    }
+    // NOTE: The replaced description (if any) is released here, outside of m_fds_lock, as closing it may block.
+}
+
+void Process::OpenFileDescriptions::set_flags(int fd, u32 flags)
+{
+    SpinlockLocker lock(m_fds_lock);
+    VERIFY(m_fds_metadatas[fd].is_valid());
+    m_fds_metadatas[fd].set_flags(flags);
+}
+
+void Process::OpenFileDescriptions::deallocate(int fd)
+{
+    RefPtr<OpenFileDescription> description;
+    {
+        SpinlockLocker lock(m_fds_lock);
+        description = m_fds_metadatas[fd].description();
+        m_fds_metadatas[fd] = {};
+    }
+}
+
 void Process::OpenFileDescriptions::enumerate(Function<void(const OpenFileDescriptionAndFlags&)> callback) const
 {
     SpinlockLocker lock(m_fds_lock);
@@ -613,8 +646,12 @@ void Process::finalize()
 
     unblock_waiters(Thread::WaitBlocker::UnblockFlags::Terminated);
 
+    return_borrowed_space();
     m_space->remove_all_regions({});
 
+    // Our private futex keys contain our address, which may get reused by another process.
+    FutexTable::the().wake_and_remove_private_queues(*this);
+
     VERIFY(ref_count() > 0);
     // WaitBlockerSet::finalize will be in charge of dropping the last
     // reference if there are still waiters around, or whenever the last
@@ -744,14 +781,12 @@ RefPtr<Thread> Process::create_kernel_thread(void (*entry)(void*), void* entry_d
 
 void Process::OpenFileDescriptionAndFlags::clear()
 {
-    // FIXME: Verify Process::m_fds_lock is locked!
     m_description = nullptr;
     m_flags = 0;
 }
 
 void Process::OpenFileDescriptionAndFlags::set(NonnullRefPtr<OpenFileDescription>&& description, u32 flags)
 {
-    // FIXME: Verify Process::m_fds_lock is locked!
     m_description = move(description);
     m_flags = flags;
 }
@@ -803,6 +838,7 @@ bool Process::remove_thread(Thread& thread)
     thread_list().with([&](auto& thread_list) {
         thread_list.remove(thread);
     });
+    did_change_statistics();
     return thread_cnt_before == 1;
 }
 
@@ -813,6 +849,7 @@ bool Process::add_thread(Thread& thread)
     thread_list().with([&](auto& thread_list) {
         thread_list.append(thread);
     });
+    did_change_statistics();
     return is_first;
 }
 
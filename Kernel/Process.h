@@ -34,6 +34,7 @@
 #include <Kernel/StdLib.h>
 #include <Kernel/Thread.h>
 #include <Kernel/UnixTypes.h>
+#include <Kernel/WaitQueue.h>
 #include <LibC/elf.h>
 #include <LibC/signal_numbers.h>
 
@@ -81,8 +82,6 @@ enum class VeilState {
     Locked,
 };
 
-using FutexQueues = HashMap<FlatPtr, RefPtr<FutexQueue>>;
-
 struct LoadResult;
 
 class Process final
@@ -292,8 +291,11 @@ public:
     ErrorOr<FlatPtr> sys$read(int fd, Userspace<u8*>, size_t);
     ErrorOr<FlatPtr> sys$pread(int fd, Userspace<u8*>, size_t, Userspace<off_t const*>);
     ErrorOr<FlatPtr> sys$readv(int fd, Userspace<const struct iovec*> iov, int iov_count);
+    ErrorOr<FlatPtr> sys$preadv(int fd, Userspace<const struct iovec*> iov, int iov_count, Userspace<off_t const*>);
     ErrorOr<FlatPtr> sys$write(int fd, Userspace<const u8*>, size_t);
+    ErrorOr<FlatPtr> sys$pwrite(int fd, Userspace<const u8*>, size_t, Userspace<off_t const*>);
     ErrorOr<FlatPtr> sys$writev(int fd, Userspace<const struct iovec*> iov, int iov_count);
+    ErrorOr<FlatPtr> sys$pwritev(int fd, Userspace<const struct iovec*> iov, int iov_count, Userspace<off_t const*>);
     ErrorOr<FlatPtr> sys$fstat(int fd, Userspace<stat*>);
     ErrorOr<FlatPtr> sys$stat(Userspace<const Syscall::SC_stat_params*>);
     ErrorOr<FlatPtr> sys$lseek(int fd, Userspace<off_t*>, int whence);
@@ -312,6 +314,11 @@ public:
     ErrorOr<FlatPtr> sys$msync(Userspace<void*>, size_t, int flags);
     ErrorOr<FlatPtr> sys$purge(int mode);
     ErrorOr<FlatPtr> sys$poll(Userspace<const Syscall::SC_poll_params*>);
+    ErrorOr<FlatPtr> sys$create_readiness_set(u32 flags);
+    ErrorOr<FlatPtr> sys$readiness_set_control(Userspace<const Syscall::SC_readiness_set_control_params*>);
+    ErrorOr<FlatPtr> sys$readiness_set_wait(Userspace<const Syscall::SC_readiness_set_wait_params*>);
+    ErrorOr<FlatPtr> sys$io_ring_create(u32 entries, u32 flags, Userspace<io_ring_params*>);
+    ErrorOr<FlatPtr> sys$io_ring_enter(Userspace<const Syscall::SC_io_ring_enter_params*>);
     ErrorOr<FlatPtr> sys$get_dir_entries(int fd, Userspace<void*>, size_t);
     ErrorOr<FlatPtr> sys$getcwd(Userspace<char*>, size_t);
     ErrorOr<FlatPtr> sys$chdir(Userspace<const char*>, size_t);
@@ -327,6 +334,7 @@ public:
     ErrorOr<FlatPtr> sys$ttyname(int fd, Userspace<char*>, size_t);
     ErrorOr<FlatPtr> sys$ptsname(int fd, Userspace<char*>, size_t);
     ErrorOr<FlatPtr> sys$fork(RegisterState&);
+    ErrorOr<FlatPtr> sys$vfork(RegisterState&);
     ErrorOr<FlatPtr> sys$execve(Userspace<const Syscall::SC_execve_params*>);
     ErrorOr<FlatPtr> sys$dup2(int old_fd, int new_fd);
     ErrorOr<FlatPtr> sys$sigaction(int signum, Userspace<const sigaction*> act, Userspace<sigaction*> old_act);
@@ -402,6 +410,7 @@ public:
     ErrorOr<FlatPtr> sys$get_stack_bounds(Userspace<FlatPtr*> stack_base, Userspace<size_t*> stack_size);
     ErrorOr<FlatPtr> sys$ptrace(Userspace<const Syscall::SC_ptrace_params*>);
     ErrorOr<FlatPtr> sys$sendfd(int sockfd, int fd);
+    ErrorOr<FlatPtr> sys$sendfile(Userspace<const Syscall::SC_sendfile_params*>);
     ErrorOr<FlatPtr> sys$recvfd(int sockfd, int options);
     ErrorOr<FlatPtr> sys$sysconf(int name);
     ErrorOr<FlatPtr> sys$disown(ProcessID);
@@ -453,6 +462,12 @@ public:
         return m_protected_values.thread_count.load(AK::MemoryOrder::memory_order_relaxed);
     }
 
+    // Changes a process makes to itself are covered by its running threads (see Thread::statistics_generation()),
+    // everything else (threads coming and going, or another process changing our process group or parent)
+    // has to be stamped here. Call this after making the change, so a snapshot can't see the stamp without it.
+    u64 statistics_generation() const { return m_statistics_generation.load(AK::MemoryOrder::memory_order_relaxed); }
+    void did_change_statistics() { m_statistics_generation.store(Thread::current_statistics_generation(), AK::MemoryOrder::memory_order_relaxed); }
+
     Mutex& big_lock() { return m_big_lock; }
     Mutex& ptrace_lock() { return m_ptrace_lock; }
 
@@ -502,8 +517,8 @@ public:
     PerformanceEventBuffer* perf_events() { return m_perf_event_buffer; }
     PerformanceEventBuffer const* perf_events() const { return m_perf_event_buffer; }
 
-    Memory::AddressSpace& address_space() { return *m_space; }
-    Memory::AddressSpace const& address_space() const { return *m_space; }
+    Memory::AddressSpace& address_space() { return m_borrowed_space ? *m_borrowed_space : *m_space; }
+    Memory::AddressSpace const& address_space() const { return m_borrowed_space ? *m_borrowed_space : *m_space; }
 
     VirtualAddress signal_trampoline() const { return m_protected_values.signal_trampoline; }
 
@@ -521,7 +536,7 @@ private:
 
     Process(NonnullOwnPtr<KString> name, UserID, GroupID, ProcessID ppid, bool is_kernel_process, RefPtr<Custody> cwd, RefPtr<Custody> executable, TTY* tty);
     static ErrorOr<NonnullRefPtr<Process>> try_create(RefPtr<Thread>& first_thread, NonnullOwnPtr<KString> name, UserID, GroupID, ProcessID ppid, bool is_kernel_process, RefPtr<Custody> cwd = nullptr, RefPtr<Custody> executable = nullptr, TTY* = nullptr, Process* fork_parent = nullptr);
-    ErrorOr<void> attach_resources(NonnullOwnPtr<Memory::AddressSpace>&&, RefPtr<Thread>& first_thread, Process* fork_parent);
+    ErrorOr<void> attach_resources(NonnullRefPtr<Memory::AddressSpace>&&, RefPtr<Thread>& first_thread, Process* fork_parent);
     static ProcessID allocate_pid();
 
     void kill_threads_except_self();
@@ -531,8 +546,18 @@ private:
     bool create_perf_events_buffer_if_needed();
     void delete_perf_events_buffer();
 
+    enum class ShareAddressSpace {
+        No,
+        Yes,
+    };
+    ErrorOr<FlatPtr> do_fork(RegisterState&, ShareAddressSpace);
+    void wait_for_borrowed_space_to_be_returned();
+    void return_borrowed_space();
+
     ErrorOr<void> do_exec(NonnullRefPtr<OpenFileDescription> main_program_description, NonnullOwnPtrVector<KString> arguments, NonnullOwnPtrVector<KString> environment, RefPtr<OpenFileDescription> interpreter_description, Thread*& new_main_thread, u32& prev_flags, const ElfW(Ehdr) & main_program_header);
-    ErrorOr<FlatPtr> do_write(OpenFileDescription&, const UserOrKernelBuffer&, size_t);
+    ErrorOr<FlatPtr> do_write(OpenFileDescription&, const UserOrKernelBuffer&, size_t, Optional<off_t> offset = {});
+    ErrorOr<FlatPtr> do_readv(int fd, Userspace<const struct iovec*>, int iov_count, Optional<off_t> offset);
+    ErrorOr<FlatPtr> do_writev(int fd, Userspace<const struct iovec*>, int iov_count, Optional<off_t> offset);
 
     ErrorOr<FlatPtr> do_statvfs(FileSystem const& path, Custody const*, statvfs* buf);
 
@@ -588,7 +613,15 @@ private:
 
     NonnullOwnPtr<KString> m_name;
 
-    OwnPtr<Memory::AddressSpace> m_space;
+    RefPtr<Memory::AddressSpace> m_space;
+
+    // A child created by vfork() runs on its parent's address space until it execs or dies.
+    // The parent is blocked on m_borrowed_space_wait_queue until then.
+    // The child also holds a reference to the space, since another thread of the parent may
+    // exec and replace the parent's space while the child is still running on it.
+    Memory::AddressSpace* m_borrowed_space { nullptr };
+    RefPtr<Memory::AddressSpace> m_borrowed_space_reference;
+    WaitQueue m_borrowed_space_wait_queue;
 
     RefPtr<ProcessGroup> m_pg;
 
@@ -599,6 +632,8 @@ private:
     OwnPtr<ThreadTracer> m_tracer;
 
 public:
+    class OpenFileDescriptions;
+
     class OpenFileDescriptionAndFlags {
     public:
         bool is_valid() const { return !m_description.is_null(); }
@@ -619,12 +654,16 @@ public:
         OpenFileDescription* description() { return m_description; }
         const OpenFileDescription* description() const { return m_description; }
         u32 flags() const { return m_flags; }
-        void set_flags(u32 flags) { m_flags = flags; }
 
+    private:
+        friend class Process::OpenFileDescriptions;
+
+        // NOTE: These must only be called with the owning OpenFileDescriptions' m_fds_lock held,
+        //       see OpenFileDescriptions::set() and friends.
+        void set_flags(u32 flags) { m_flags = flags; }
         void clear();
         void set(NonnullRefPtr<OpenFileDescription>&&, u32 flags = 0);
 
-    private:
         RefPtr<OpenFileDescription> m_description;
         bool m_is_allocated { false };
         u32 m_flags { 0 };
@@ -671,10 +710,20 @@ public:
 
         void clear()
         {
-            SpinlockLocker lock(m_fds_lock);
-            m_fds_metadatas.clear();
+            Vector<OpenFileDescriptionAndFlags> fds_metadatas;
+            {
+                SpinlockLocker lock(m_fds_lock);
+                swap(fds_metadatas, m_fds_metadatas);
+            }
+            // NOTE: The descriptions are released here, after dropping m_fds_lock, as closing them may block.
         }
 
+        // NOTE: Syscalls that don't take the big process lock look up descriptions concurrently
+        //       with these, so the table is only ever modified with m_fds_lock held.
+        void set(int fd, NonnullRefPtr<OpenFileDescription>&&, u32 flags = 0);
+        void set_flags(int fd, u32 flags);
+        void deallocate(int fd);
+
         ErrorOr<NonnullRefPtr<OpenFileDescription>> open_file_description(int fd) const;
 
     private:
@@ -780,8 +829,7 @@ private:
 
     OwnPtr<PerformanceEventBuffer> m_perf_event_buffer;
 
-    FutexQueues m_futex_queues;
-    Spinlock m_futex_lock;
+    Atomic<u64> m_statistics_generation { 0 };
 
     // This member is used in the implementation of ptrace's PT_TRACEME flag.
     // If it is set to true, the process will stop at the next execve syscall
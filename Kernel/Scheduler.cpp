@@ -559,6 +559,16 @@ TotalTimeScheduled Scheduler::get_total_time_scheduled()
     return g_total_time_scheduled.with([&](auto& total_time_scheduled) { return total_time_scheduled; });
 }
 
+u32 Scheduler::scheduled_processor_count()
+{
+#if SCHEDULE_ON_ALL_PROCESSORS
+    return Processor::count();
+#else
+    // Only the bootstrap processor picks threads to run.
+    return 1;
+#endif
+}
+
 void dump_thread_list(bool with_stack_traces)
 {
     dbgln("Scheduler thread list for processor {}:", Processor::current_id());
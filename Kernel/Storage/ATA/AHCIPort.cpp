@@ -41,7 +41,7 @@ AHCIPort::AHCIPort(const AHCIPortHandler& handler, volatile AHCI::PortRegisters&
     if (m_fis_receive_page.is_null())
         return;
 
-    for (size_t index = 0; index < 1; index++) {
+    for (size_t index = 0; index < max_dma_buffer_page_count; index++) {
         m_dma_buffers.append(MM.allocate_supervisor_physical_page().release_nonnull());
     }
     for (size_t index = 0; index < 1; index++) {
@@ -37,6 +37,10 @@ class AHCIPort
     friend class AHCIController;
 
 public:
+    // Each DMA buffer page gets its own PRDT entry, so a single command can move up to 64 KiB.
+    // NOTE: This keeps the sector count of a 512-byte sector device within the u8 passed to access_device().
+    static constexpr size_t max_dma_buffer_page_count = 16;
+
     UNMAP_AFTER_INIT static NonnullRefPtr<AHCIPort> create(const AHCIPortHandler&, volatile AHCI::PortRegisters&, u32 port_index);
 
     u32 port_index() const { return m_port_index; }
@@ -23,6 +23,9 @@ class ATAController
 public:
     virtual void start_request(const ATADevice&, AsyncBlockDeviceRequest&) = 0;
 
+    // The largest transfer (in bytes) a single request to one of our devices may cover.
+    virtual size_t max_transfer_size() const = 0;
+
 protected:
     ATAController() = default;
 };
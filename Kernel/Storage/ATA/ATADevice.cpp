@@ -32,4 +32,11 @@ void ATADevice::start_request(AsyncBlockDeviceRequest& request)
     controller->start_request(*this, request);
 }
 
+u32 ATADevice::max_blocks_per_request() const
+{
+    auto controller = m_controller.strong_ref();
+    VERIFY(controller);
+    return controller->max_transfer_size() / block_size();
+}
+
 }
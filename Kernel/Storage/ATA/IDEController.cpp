@@ -56,6 +56,12 @@ void IDEController::start_request(const ATADevice& device, AsyncBlockDeviceReque
     VERIFY_NOT_REACHED();
 }
 
+size_t IDEController::max_transfer_size() const
+{
+    // Both the PIO and the bus master DMA paths of our channels go through a single page.
+    return PAGE_SIZE;
+}
+
 void IDEController::complete_current_request(AsyncDeviceRequest::RequestResult)
 {
     VERIFY_NOT_REACHED();
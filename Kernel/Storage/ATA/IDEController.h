@@ -28,6 +28,7 @@ public:
     virtual bool shutdown() override;
     virtual size_t devices_count() const override;
     virtual void start_request(const ATADevice&, AsyncBlockDeviceRequest&) override;
+    virtual size_t max_transfer_size() const override;
     virtual void complete_current_request(AsyncDeviceRequest::RequestResult) override;
 
     bool is_bus_master_capable() const;
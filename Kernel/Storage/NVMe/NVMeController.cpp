@@ -11,8 +11,10 @@
 #include <Kernel/Arch/x86/IO.h>
 #include <Kernel/Arch/x86/Processor.h>
 #include <Kernel/Bus/PCI/API.h>
+#include <Kernel/CommandLine.h>
 #include <Kernel/Devices/Device.h>
 #include <Kernel/FileSystem/ProcFS.h>
+#include <Kernel/Interrupts/InterruptManagement.h>
 #include <Kernel/Sections.h>
 
 namespace Kernel {
@@ -58,6 +60,18 @@ UNMAP_AFTER_INIT ErrorOr<void> NVMeController::initialize()
     VERIFY(IO_QUEUE_SIZE < MQES(caps));
     dbgln_if(NVME_DEBUG, "NVMe: IO queue depth is: {}", IO_QUEUE_SIZE);
 
+    m_polled_io = kernel_command_line().is_nvme_polling_enabled();
+    // With MSI-X, every IO queue gets its own interrupt, delivered to the processor that submits to it.
+    // If there are fewer vectors than processors, some processors have to share a queue.
+    if (auto msix_vector_count = this->msix_vector_count(); msix_vector_count >= 2) {
+        auto io_queue_count = m_polled_io ? nr_of_queues : min<u32>(nr_of_queues, msix_vector_count - 1);
+        if (auto result = set_up_message_signalled_interrupts(io_queue_count); result.is_error())
+            dmesgln("NVMe: Failed to set up MSI-X ({}), using pin-based interrupts", result.error());
+        else
+            nr_of_queues = io_queue_count;
+    }
+    dmesgln("NVMe: Using {} IO queues with {} completions", nr_of_queues, m_polled_io ? "polled" : (m_message_signalled_interrupt_numbers.is_empty() ? "pin-based interrupt" : "MSI-X"));
+
     // Create an IO queue per core
     for (u32 cpuid = 0; cpuid < nr_of_queues; ++cpuid) {
         // qid is zero is used for admin queue
@@ -280,7 +294,7 @@ UNMAP_AFTER_INIT ErrorOr<void> NVMeController::create_admin_queue(u8 irq)
     }
     auto doorbell_regs = TRY(Memory::map_typed_writable<volatile DoorbellRegister>(PhysicalAddress(m_bar + REG_SQ0TDBL_START)));
 
-    m_admin_queue = TRY(NVMeQueue::try_create(0, irq, qdepth, move(cq_dma_region), cq_dma_pages, move(sq_dma_region), sq_dma_pages, move(doorbell_regs)));
+    m_admin_queue = TRY(NVMeQueue::try_create(0, qdepth, move(cq_dma_region), cq_dma_pages, move(sq_dma_region), sq_dma_pages, move(doorbell_regs)));
 
     m_controller_regs->acq = reinterpret_cast<u64>(AK::convert_between_host_and_little_endian(cq_dma_pages.first().paddr().as_ptr()));
     m_controller_regs->asq = reinterpret_cast<u64>(AK::convert_between_host_and_little_endian(sq_dma_pages.first().paddr().as_ptr()));
@@ -290,11 +304,31 @@ UNMAP_AFTER_INIT ErrorOr<void> NVMeController::create_admin_queue(u8 irq)
         return EFAULT;
     }
     set_admin_queue_ready_flag();
-    m_admin_queue->enable_interrupts();
+    TRY(m_admin_queue->use_pin_based_interrupt(irq));
     dbgln_if(NVME_DEBUG, "NVMe: Admin queue created");
     return {};
 }
 
+UNMAP_AFTER_INIT ErrorOr<void> NVMeController::set_up_message_signalled_interrupts(u32 io_queue_count)
+{
+    // MSI-X table entry 0 belongs to the admin queue, entry N to IO queue N, which is used by processor N - 1.
+    auto interrupt_count = m_polled_io ? 1 : io_queue_count + 1;
+    VERIFY(interrupt_count <= msix_vector_count());
+
+    Vector<u8> interrupt_numbers;
+    TRY(interrupt_numbers.try_ensure_capacity(interrupt_count));
+    for (u32 i = 0; i < interrupt_count; ++i)
+        interrupt_numbers.unchecked_append(TRY(InterruptManagement::the().allocate_message_signalled_interrupt_number()));
+    for (u32 i = 0; i < interrupt_count; ++i)
+        TRY(set_up_msix_vector(i, i == 0 ? 0 : i - 1, interrupt_numbers[i]));
+
+    // The admin queue is idle right now, so no completion can get lost while we switch it over.
+    TRY(m_admin_queue->use_message_signalled_interrupt(interrupt_numbers[0]));
+    enable_extended_message_signalled_interrupts();
+    m_message_signalled_interrupt_numbers = move(interrupt_numbers);
+    return {};
+}
+
 UNMAP_AFTER_INIT ErrorOr<void> NVMeController::create_io_queue(u8 irq, u8 qid)
 {
     OwnPtr<Memory::Region> cq_dma_region;
@@ -325,11 +359,12 @@ UNMAP_AFTER_INIT ErrorOr<void> NVMeController::create_io_queue(u8 irq, u8 qid)
         sub.create_cq.cqid = qid;
         // The queue size is 0 based
         sub.create_cq.qsize = AK::convert_between_host_and_little_endian(IO_QUEUE_SIZE - 1);
-        auto flags = QUEUE_IRQ_ENABLED | QUEUE_PHY_CONTIGUOUS;
-        // TODO: Eventually move to MSI.
-        // For now using pin based interrupts. Clear the first 16 bits
-        // to use pin-based interrupts.
+        // Polled queues don't raise interrupts at all. Otherwise, the interrupt vector is the MSI-X table entry
+        // to use, and it's ignored for pin-based interrupts.
+        auto flags = m_polled_io ? QUEUE_PHY_CONTIGUOUS : (QUEUE_IRQ_ENABLED | QUEUE_PHY_CONTIGUOUS);
         sub.create_cq.cq_flags = AK::convert_between_host_and_little_endian(flags & 0xFFFF);
+        if (!m_polled_io && !m_message_signalled_interrupt_numbers.is_empty())
+            sub.create_cq.irq_vector = AK::convert_between_host_and_little_endian<u16>(qid);
         submit_admin_command(sub, true);
     }
     {
@@ -348,8 +383,14 @@ UNMAP_AFTER_INIT ErrorOr<void> NVMeController::create_io_queue(u8 irq, u8 qid)
     auto queue_doorbell_offset = REG_SQ0TDBL_START + ((2 * qid) * (4 << m_dbl_stride));
     auto doorbell_regs = TRY(Memory::map_typed_writable<volatile DoorbellRegister>(PhysicalAddress(m_bar + queue_doorbell_offset)));
 
-    m_queues.append(TRY(NVMeQueue::try_create(qid, irq, IO_QUEUE_SIZE, move(cq_dma_region), cq_dma_pages, move(sq_dma_region), sq_dma_pages, move(doorbell_regs))));
-    m_queues.last().enable_interrupts();
+    auto queue = TRY(NVMeQueue::try_create(qid, IO_QUEUE_SIZE, move(cq_dma_region), cq_dma_pages, move(sq_dma_region), sq_dma_pages, move(doorbell_regs)));
+    if (m_polled_io)
+        queue->use_polling();
+    else if (!m_message_signalled_interrupt_numbers.is_empty())
+        TRY(queue->use_message_signalled_interrupt(m_message_signalled_interrupt_numbers[qid]));
+    else
+        TRY(queue->use_pin_based_interrupt(irq));
+    m_queues.append(move(queue));
     dbgln_if(NVME_DEBUG, "NVMe: Created IO Queue with QID{}", m_queues.size());
     return {};
 }
@@ -13,6 +13,7 @@
 #include <AK/Time.h>
 #include <AK/Tuple.h>
 #include <AK/Types.h>
+#include <AK/Vector.h>
 #include <Kernel/Bus/PCI/Device.h>
 #include <Kernel/Locking/Spinlock.h>
 #include <Kernel/Memory/TypedMapping.h>
@@ -59,6 +60,7 @@ private:
     ErrorOr<void> identify_and_init_namespaces();
     Tuple<u64, u8> get_ns_features(IdentifyNamespace& identify_data_struct);
     ErrorOr<void> create_admin_queue(u8 irq);
+    ErrorOr<void> set_up_message_signalled_interrupts(u32 io_queue_count);
     ErrorOr<void> create_io_queue(u8 irq, u8 qid);
     void calculate_doorbell_stride()
     {
@@ -73,6 +75,9 @@ private:
     NonnullRefPtrVector<NVMeNameSpace> m_namespaces;
     Memory::TypedMapping<volatile ControllerRegister> m_controller_regs;
     bool m_admin_queue_ready { false };
+    bool m_polled_io { false };
+    // Indexed by queue ID, empty if we're using the pin-based interrupt.
+    Vector<u8> m_message_signalled_interrupt_numbers;
     size_t m_device_count {};
     AK::Time m_ready_timeout;
     u32 m_bar;
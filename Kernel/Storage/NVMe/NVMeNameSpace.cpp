@@ -29,11 +29,10 @@ UNMAP_AFTER_INIT NVMeNameSpace::NVMeNameSpace(NonnullRefPtrVector<NVMeQueue> que
 
 void NVMeNameSpace::start_request(AsyncBlockDeviceRequest& request)
 {
-    auto index = Processor::current_id();
+    // NOTE: There can be fewer queues than processors if the controller doesn't have enough interrupt vectors.
+    auto index = Processor::current_id() % m_queues.size();
     auto& queue = m_queues.at(index);
-    // TODO: For now we support only IO transfers of size PAGE_SIZE (Going along with the current constraint in the block layer)
-    // Eventually remove this constraint by using the PRP2 field in the submission struct and remove block layer constraint for NVMe driver.
-    VERIFY(request.block_count() <= (PAGE_SIZE / block_size()));
+    VERIFY(request.block_count() <= max_blocks_per_request());
 
     if (request.request_type() == AsyncBlockDeviceRequest::Read) {
         queue.read(request, m_nsid, request.block_index(), request.block_count());
@@ -27,6 +27,9 @@ public:
 
     CommandSet command_set() const override { return CommandSet::NVMe; };
     void start_request(AsyncBlockDeviceRequest& request) override;
+    virtual u32 max_blocks_per_request() const override { return NVMeQueue::max_rw_dma_page_count * PAGE_SIZE / block_size(); }
+    // Every queue keeps several requests in flight, and requests from different processors go to different queues.
+    virtual bool can_process_requests_concurrently() const override { return true; }
 
 private:
     u16 m_nsid;
@@ -6,42 +6,130 @@
 
 #include "NVMeQueue.h"
 #include "Kernel/StdLib.h"
+#include <AK/AllOf.h>
 #include <Kernel/Arch/x86/IO.h>
+#include <Kernel/Devices/BlockDevice.h>
+#include <Kernel/Interrupts/IRQHandler.h>
+#include <Kernel/Interrupts/MSIHandler.h>
 #include <Kernel/Storage/NVMe/NVMeController.h>
 #include <Kernel/Storage/NVMe/NVMeQueue.h>
 #include <Kernel/WorkQueue.h>
 
 namespace Kernel {
 
-ErrorOr<NonnullRefPtr<NVMeQueue>> NVMeQueue::try_create(u16 qid, u8 irq, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> cq_dma_page, OwnPtr<Memory::Region> sq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> sq_dma_page, Memory::TypedMapping<volatile DoorbellRegister> db_regs)
+class NVMeQueue::PinBasedInterruptHandler final : public IRQHandler {
+public:
+    PinBasedInterruptHandler(NVMeQueue& queue, u8 irq)
+        : IRQHandler(irq)
+        , m_queue(queue)
+    {
+    }
+
+    virtual bool handle_irq(const RegisterState&) override { return m_queue.process_completions(); }
+    virtual StringView purpose() const override { return "NVMe Queue"sv; }
+
+private:
+    NVMeQueue& m_queue;
+};
+
+class NVMeQueue::MessageSignalledInterruptHandler final : public MSIHandler {
+public:
+    MessageSignalledInterruptHandler(NVMeQueue& queue, u8 interrupt_number)
+        : MSIHandler(interrupt_number)
+        , m_queue(queue)
+    {
+    }
+
+    virtual bool handle_irq(const RegisterState&) override { return m_queue.process_completions(); }
+    virtual StringView purpose() const override { return "NVMe Queue"sv; }
+
+private:
+    NVMeQueue& m_queue;
+};
+
+ErrorOr<NonnullRefPtr<NVMeQueue>> NVMeQueue::try_create(u16 qid, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> cq_dma_page, OwnPtr<Memory::Region> sq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> sq_dma_page, Memory::TypedMapping<volatile DoorbellRegister> db_regs)
 {
-    // Note: Allocate DMA region for RW operation. For now the requests don't exceed more than 4096 bytes (Storage device takes care of it)
-    RefPtr<Memory::PhysicalPage> rw_dma_page;
-    auto rw_dma_region = TRY(MM.allocate_dma_buffer_page("NVMe Queue Read/Write DMA"sv, Memory::Region::Access::ReadWrite, rw_dma_page));
-    auto queue = TRY(adopt_nonnull_ref_or_enomem(new (nothrow) NVMeQueue(move(rw_dma_region), *rw_dma_page, qid, irq, q_depth, move(cq_dma_region), cq_dma_page, move(sq_dma_region), sq_dma_page, move(db_regs))));
+    auto queue = TRY(adopt_nonnull_ref_or_enomem(new (nothrow) NVMeQueue(qid, q_depth, move(cq_dma_region), cq_dma_page, move(sq_dma_region), sq_dma_page, move(db_regs))));
+    if (!queue->is_admin_queue())
+        TRY(queue->allocate_request_slots());
     return queue;
 }
 
-UNMAP_AFTER_INIT NVMeQueue::NVMeQueue(NonnullOwnPtr<Memory::Region> rw_dma_region, Memory::PhysicalPage const& rw_dma_page, u16 qid, u8 irq, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> cq_dma_page, OwnPtr<Memory::Region> sq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> sq_dma_page, Memory::TypedMapping<volatile DoorbellRegister> db_regs)
-    : IRQHandler(irq)
-    , m_qid(qid)
+UNMAP_AFTER_INIT NVMeQueue::NVMeQueue(u16 qid, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> cq_dma_page, OwnPtr<Memory::Region> sq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> sq_dma_page, Memory::TypedMapping<volatile DoorbellRegister> db_regs)
+    : m_qid(qid)
     , m_admin_queue(qid == 0)
-    , m_irq(irq)
     , m_qdepth(q_depth)
     , m_cq_dma_region(move(cq_dma_region))
     , m_cq_dma_page(cq_dma_page)
     , m_sq_dma_region(move(sq_dma_region))
     , m_sq_dma_page(sq_dma_page)
-    , m_rw_dma_region(move(rw_dma_region))
     , m_db_regs(move(db_regs))
-    , m_rw_dma_page(rw_dma_page)
-    , m_current_request(nullptr)
-
 {
     m_sqe_array = { reinterpret_cast<NVMeSubmission*>(m_sq_dma_region->vaddr().as_ptr()), m_qdepth };
     m_cqe_array = { reinterpret_cast<NVMeCompletion*>(m_cq_dma_region->vaddr().as_ptr()), m_qdepth };
 }
 
+NVMeQueue::~NVMeQueue()
+{
+    if (m_pin_based_interrupt_handler)
+        m_pin_based_interrupt_handler->unregister_interrupt_handler();
+    if (m_message_signalled_interrupt_handler)
+        m_message_signalled_interrupt_handler->unregister_interrupt_handler();
+}
+
+UNMAP_AFTER_INIT ErrorOr<void> NVMeQueue::allocate_request_slots()
+{
+    // Note: Requests never exceed max_rw_dma_page_count pages (NVMeNameSpace takes care of it)
+    static_assert(max_requests_in_flight < IO_QUEUE_SIZE);
+    for (auto& slot : m_request_slots) {
+        slot.dma_region = TRY(MM.allocate_dma_buffer_pages(max_rw_dma_page_count * PAGE_SIZE, "NVMe Queue Read/Write DMA"sv, Memory::Region::Access::ReadWrite, slot.dma_pages));
+        slot.prp_list_region = TRY(MM.allocate_dma_buffer_page("NVMe Queue PRP List"sv, Memory::Region::Access::ReadWrite, slot.prp_list_page));
+
+        // The DMA pages never change, so the PRP list describing all but the first of them can be filled in once.
+        auto* prp_list = reinterpret_cast<LittleEndian<u64>*>(slot.prp_list_region->vaddr().as_ptr());
+        for (size_t i = 1; i < slot.dma_pages.size(); ++i)
+            prp_list[i - 1] = slot.dma_pages[i].paddr().get();
+    }
+    return {};
+}
+
+ErrorOr<void> NVMeQueue::use_pin_based_interrupt(u8 irq)
+{
+    auto handler = TRY(adopt_nonnull_own_or_enomem(new (nothrow) PinBasedInterruptHandler(*this, irq)));
+    handler->enable_irq();
+    m_pin_based_interrupt_handler = move(handler);
+    if (m_message_signalled_interrupt_handler) {
+        m_message_signalled_interrupt_handler->unregister_interrupt_handler();
+        m_message_signalled_interrupt_handler.clear();
+    }
+    return {};
+}
+
+ErrorOr<void> NVMeQueue::use_message_signalled_interrupt(u8 interrupt_number)
+{
+    auto handler = TRY(adopt_nonnull_own_or_enomem(new (nothrow) MessageSignalledInterruptHandler(*this, interrupt_number)));
+    handler->register_interrupt_handler();
+    m_message_signalled_interrupt_handler = move(handler);
+    if (m_pin_based_interrupt_handler) {
+        m_pin_based_interrupt_handler->unregister_interrupt_handler();
+        m_pin_based_interrupt_handler.clear();
+    }
+    return {};
+}
+
+void NVMeQueue::set_data_pointer(NVMeSubmission& sub, RequestSlot const& slot, size_t transfer_size)
+{
+    auto page_count = ceil_div(transfer_size, static_cast<size_t>(PAGE_SIZE));
+    VERIFY(page_count > 0 && page_count <= slot.dma_pages.size());
+
+    sub.rw.data_ptr.prp1 = slot.dma_pages[0].paddr().get();
+    // PRP2 is either the second page itself, or a pointer to the list of all pages after the first one.
+    if (page_count == 2)
+        sub.rw.data_ptr.prp2 = slot.dma_pages[1].paddr().get();
+    else if (page_count > 2)
+        sub.rw.data_ptr.prp2 = slot.prp_list_page->paddr().get();
+}
+
 bool NVMeQueue::cqe_available()
 {
     return PHASE_TAG(m_cqe_array[m_cq_head].status) == m_cq_valid_phase;
@@ -59,43 +147,43 @@ void NVMeQueue::update_cqe_head()
     }
 }
 
-bool NVMeQueue::handle_irq(const RegisterState&)
+bool NVMeQueue::process_completions()
 {
     u32 nr_of_processed_cqes = 0;
-    while (cqe_available()) {
-        u16 status;
-        u16 cmdid;
-        ++nr_of_processed_cqes;
-        status = CQ_STATUS_FIELD(m_cqe_array[m_cq_head].status);
-        cmdid = m_cqe_array[m_cq_head].command_id;
-        dbgln_if(NVME_DEBUG, "NVMe: Completion with status {:x} and command identifier {}. CQ_HEAD: {}", status, cmdid, m_cq_head);
-        // TODO: We don't use AsyncBlockDevice requests for admin queue as it is only applicable for a block device (NVMe namespace)
-        //  But admin commands precedes namespace creation. Unify requests to avoid special conditions
-        if (m_admin_queue == false) {
-            // As the block layer calls are now sync (as we wait on each requests),
-            // everything is operated on a single request similar to BMIDE driver.
-            // TODO: Remove this constraint eventually.
-            VERIFY(cmdid == m_prev_sq_tail);
-            SpinlockLocker lock(m_request_lock);
-            if (m_current_request) {
-                complete_current_request(status);
+    {
+        SpinlockLocker cq_lock(m_cq_lock);
+        while (cqe_available()) {
+            u16 status;
+            u16 cmdid;
+            ++nr_of_processed_cqes;
+            status = CQ_STATUS_FIELD(m_cqe_array[m_cq_head].status);
+            cmdid = m_cqe_array[m_cq_head].command_id;
+            dbgln_if(NVME_DEBUG, "NVMe: Completion with status {:x} and command identifier {}. CQ_HEAD: {}", status, cmdid, m_cq_head);
+            // TODO: We don't use AsyncBlockDevice requests for admin queue as it is only applicable for a block device (NVMe namespace)
+            //  But admin commands precedes namespace creation. Unify requests to avoid special conditions
+            if (m_admin_queue == false) {
+                // I/O commands are identified by the slot they were started in.
+                SpinlockLocker lock(m_request_lock);
+                VERIFY(cmdid < m_request_slots.size());
+                auto& slot = m_request_slots[cmdid];
+                VERIFY(slot.state == SlotState::InUse);
+                slot.result = status ? AsyncDeviceRequest::Failure : AsyncDeviceRequest::Success;
+                slot.state = SlotState::Completed;
             }
+            update_cqe_head();
+        }
+        if (nr_of_processed_cqes) {
+            update_cq_doorbell();
         }
-        update_cqe_head();
-    }
-    if (nr_of_processed_cqes) {
-        update_cq_doorbell();
     }
+    if (nr_of_processed_cqes && !m_admin_queue)
+        schedule_finishing_completed_requests();
     return nr_of_processed_cqes ? true : false;
 }
 
-void NVMeQueue::submit_sqe(NVMeSubmission& sub)
+void NVMeQueue::push_sqe(NVMeSubmission& sub)
 {
-    SpinlockLocker lock(m_sq_lock);
-    // For now let's use sq tail as a unique command id.
-    sub.cmdid = m_sq_tail;
-    m_prev_sq_tail = m_sq_tail;
-
+    VERIFY(m_sq_lock.is_locked());
     memcpy(&m_sqe_array[m_sq_tail], &sub, sizeof(NVMeSubmission));
     {
         u32 temp_sq_tail = m_sq_tail + 1;
@@ -110,6 +198,14 @@ void NVMeQueue::submit_sqe(NVMeSubmission& sub)
     update_sq_doorbell();
 }
 
+void NVMeQueue::submit_sqe(NVMeSubmission& sub)
+{
+    SpinlockLocker lock(m_sq_lock);
+    // For now let's use sq tail as a unique command id.
+    sub.cmdid = m_sq_tail;
+    push_sqe(sub);
+}
+
 u16 NVMeQueue::submit_sync_sqe(NVMeSubmission& sub)
 {
     // For now let's use sq tail as a unique command id.
@@ -135,65 +231,136 @@ u16 NVMeQueue::submit_sync_sqe(NVMeSubmission& sub)
 
 void NVMeQueue::read(AsyncBlockDeviceRequest& request, u16 nsid, u64 index, u32 count)
 {
-    NVMeSubmission sub {};
-    SpinlockLocker m_lock(m_request_lock);
-    m_current_request = request;
+    submit_request({ request, nsid, index, count });
+}
 
-    sub.op = OP_NVME_READ;
-    sub.rw.nsid = nsid;
-    sub.rw.slba = AK::convert_between_host_and_little_endian(index);
-    // No. of lbas is 0 based
-    sub.rw.length = AK::convert_between_host_and_little_endian((count - 1) & 0xFFFF);
-    sub.rw.data_ptr.prp1 = reinterpret_cast<u64>(AK::convert_between_host_and_little_endian(m_rw_dma_page->paddr().as_ptr()));
+void NVMeQueue::write(AsyncBlockDeviceRequest& request, u16 nsid, u64 index, u32 count)
+{
+    submit_request({ request, nsid, index, count });
+}
 
-    full_memory_barrier();
-    submit_sqe(sub);
+void NVMeQueue::submit_request(PendingRequest pending_request)
+{
+    Optional<u16> slot_index;
+    {
+        SpinlockLocker lock(m_request_lock);
+        for (u16 i = 0; i < m_request_slots.size(); ++i) {
+            auto& slot = m_request_slots[i];
+            if (slot.state != SlotState::Free)
+                continue;
+            slot.state = SlotState::InUse;
+            slot.request = pending_request.request;
+            slot_index = i;
+            break;
+        }
+        if (!slot_index.has_value()) {
+            // Whoever frees up the next slot starts this request.
+            if (m_pending_requests.try_append(pending_request).is_error()) {
+                lock.unlock();
+                pending_request.request->complete(AsyncDeviceRequest::Failure);
+                return;
+            }
+        }
+    }
+    if (slot_index.has_value())
+        start_request_in_slot(slot_index.value(), pending_request);
+    if (m_polled)
+        poll_until_idle();
 }
 
-void NVMeQueue::write(AsyncBlockDeviceRequest& request, u16 nsid, u64 index, u32 count)
+void NVMeQueue::start_request_in_slot(u16 slot_index, PendingRequest& pending_request)
 {
-    NVMeSubmission sub {};
-    SpinlockLocker m_lock(m_request_lock);
-    m_current_request = request;
+    // NOTE: While a slot is in use, only the one who put it in use touches its buffers, so no lock is needed here.
+    auto& slot = m_request_slots[slot_index];
+    auto& request = *pending_request.request;
+    bool is_read = request.request_type() == AsyncBlockDeviceRequest::Read;
 
-    if (auto result = m_current_request->read_from_buffer(m_current_request->buffer(), m_rw_dma_region->vaddr().as_ptr(), 512 * m_current_request->block_count()); result.is_error()) {
-        complete_current_request(AsyncDeviceRequest::MemoryFault);
-        return;
+    if (!is_read) {
+        if (auto result = request.read_from_buffer(request.buffer(), slot.dma_region->vaddr().as_ptr(), request.buffer_size()); result.is_error()) {
+            {
+                SpinlockLocker lock(m_request_lock);
+                slot.result = AsyncDeviceRequest::MemoryFault;
+                slot.state = SlotState::Completed;
+            }
+            schedule_finishing_completed_requests();
+            return;
+        }
     }
-    sub.op = OP_NVME_WRITE;
-    sub.rw.nsid = nsid;
-    sub.rw.slba = AK::convert_between_host_and_little_endian(index);
+
+    NVMeSubmission sub {};
+    sub.op = is_read ? OP_NVME_READ : OP_NVME_WRITE;
+    sub.cmdid = slot_index;
+    sub.rw.nsid = pending_request.nsid;
+    sub.rw.slba = AK::convert_between_host_and_little_endian(pending_request.index);
     // No. of lbas is 0 based
-    sub.rw.length = AK::convert_between_host_and_little_endian((count - 1) & 0xFFFF);
-    sub.rw.data_ptr.prp1 = reinterpret_cast<u64>(AK::convert_between_host_and_little_endian(m_rw_dma_page->paddr().as_ptr()));
+    sub.rw.length = AK::convert_between_host_and_little_endian((pending_request.count - 1) & 0xFFFF);
+    set_data_pointer(sub, slot, request.buffer_size());
 
     full_memory_barrier();
-    submit_sqe(sub);
+    SpinlockLocker lock(m_sq_lock);
+    push_sqe(sub);
+}
+
+void NVMeQueue::schedule_finishing_completed_requests()
+{
+    // In polled mode, the submitter finishes requests itself, and it's not running in an interrupt handler.
+    if (m_polled)
+        return;
+    g_io_work->queue([this]() {
+        finish_completed_requests();
+    });
 }
 
-void NVMeQueue::complete_current_request(u16 status)
+void NVMeQueue::finish_completed_requests()
 {
-    VERIFY(m_request_lock.is_locked());
+    for (u16 slot_index = 0; slot_index < m_request_slots.size(); ++slot_index) {
+        auto& slot = m_request_slots[slot_index];
+        RefPtr<AsyncBlockDeviceRequest> request;
+        {
+            SpinlockLocker lock(m_request_lock);
+            if (slot.state != SlotState::Completed)
+                continue;
+            slot.state = SlotState::Finishing;
+            request = move(slot.request);
+        }
 
-    g_io_work->queue([this, status]() {
-        SpinlockLocker lock(m_request_lock);
-        auto current_request = m_current_request;
-        m_current_request.clear();
-        if (status) {
-            lock.unlock();
-            current_request->complete(AsyncBlockDeviceRequest::Failure);
-            return;
+        // The slot can't be reused until we're done copying out of its buffer.
+        auto result = slot.result;
+        if (result == AsyncDeviceRequest::Success && request->request_type() == AsyncBlockDeviceRequest::Read) {
+            if (auto write_result = request->write_to_buffer(request->buffer(), slot.dma_region->vaddr().as_ptr(), request->buffer_size()); write_result.is_error())
+                result = AsyncDeviceRequest::MemoryFault;
         }
-        if (current_request->request_type() == AsyncBlockDeviceRequest::RequestType::Read) {
-            if (auto result = current_request->write_to_buffer(current_request->buffer(), m_rw_dma_region->vaddr().as_ptr(), 512 * current_request->block_count()); result.is_error()) {
-                lock.unlock();
-                current_request->complete(AsyncDeviceRequest::MemoryFault);
-                return;
+
+        Optional<PendingRequest> next_request;
+        {
+            SpinlockLocker lock(m_request_lock);
+            if (m_pending_requests.is_empty()) {
+                slot.state = SlotState::Free;
+            } else {
+                next_request = m_pending_requests.take_first();
+                slot.state = SlotState::InUse;
+                slot.request = next_request->request;
             }
         }
-        lock.unlock();
-        current_request->complete(AsyncDeviceRequest::Success);
-        return;
-    });
+
+        request->complete(result);
+        if (next_request.has_value())
+            start_request_in_slot(slot_index, next_request.value());
+    }
+}
+
+void NVMeQueue::poll_until_idle()
+{
+    VERIFY(m_polled);
+    for (;;) {
+        process_completions();
+        finish_completed_requests();
+        {
+            SpinlockLocker lock(m_request_lock);
+            if (all_of(m_request_slots, [](auto& slot) { return slot.state == SlotState::Free; }))
+                return;
+        }
+        Processor::wait_check();
+    }
 }
 }
@@ -6,14 +6,16 @@
 
 #pragma once
 
+#include <AK/Array.h>
 #include <AK/NonnullRefPtr.h>
 #include <AK/NonnullRefPtrVector.h>
 #include <AK/OwnPtr.h>
 #include <AK/RefCounted.h>
 #include <AK/RefPtr.h>
 #include <AK/Types.h>
+#include <AK/Vector.h>
 #include <Kernel/Bus/PCI/Device.h>
-#include <Kernel/Interrupts/IRQHandler.h>
+#include <Kernel/Devices/AsyncDeviceRequest.h>
 #include <Kernel/Locking/Spinlock.h>
 #include <Kernel/Memory/MemoryManager.h>
 #include <Kernel/Memory/TypedMapping.h>
@@ -27,26 +29,74 @@ struct DoorbellRegister {
 };
 
 class AsyncBlockDeviceRequest;
-class NVMeQueue : public IRQHandler
-    , public RefCounted<NVMeQueue> {
+class NVMeQueue : public RefCounted<NVMeQueue> {
 public:
-    static ErrorOr<NonnullRefPtr<NVMeQueue>> try_create(u16 qid, u8 irq, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> cq_dma_page, OwnPtr<Memory::Region> sq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> sq_dma_page, Memory::TypedMapping<volatile DoorbellRegister> db_regs);
+    // A single read or write can cover this many pages, which are handed to the controller through a PRP list.
+    static constexpr size_t max_rw_dma_page_count = 16;
+    // Each I/O queue keeps up to this many reads and writes in flight, each with its own DMA buffer.
+    // Requests beyond that wait in a backlog until a slot frees up.
+    static constexpr size_t max_requests_in_flight = 4;
+
+    static ErrorOr<NonnullRefPtr<NVMeQueue>> try_create(u16 qid, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> cq_dma_page, OwnPtr<Memory::Region> sq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> sq_dma_page, Memory::TypedMapping<volatile DoorbellRegister> db_regs);
+    ~NVMeQueue();
+
     bool is_admin_queue() { return m_admin_queue; };
     void submit_sqe(NVMeSubmission&);
     u16 submit_sync_sqe(NVMeSubmission&);
     void read(AsyncBlockDeviceRequest& request, u16 nsid, u64 index, u32 count);
     void write(AsyncBlockDeviceRequest& request, u16 nsid, u64 index, u32 count);
-    void enable_interrupts() { enable_irq(); };
-    void disable_interrupts() { disable_irq(); };
+
+    // Completions are signalled either through the (possibly shared) pin-based interrupt of the controller,
+    // through an MSI-X vector that targets the processor owning this queue, or not at all, in which case
+    // whoever submits a request polls for its completion.
+    // Switching to another kind of interrupt drops the previous handler, after the new one is in place.
+    ErrorOr<void> use_pin_based_interrupt(u8 irq);
+    ErrorOr<void> use_message_signalled_interrupt(u8 interrupt_number);
+    void use_polling() { m_polled = true; }
+    bool is_polled() const { return m_polled; }
+
+    bool process_completions();
 
 private:
-    NVMeQueue(NonnullOwnPtr<Memory::Region> rw_dma_region, Memory::PhysicalPage const& rw_dma_page, u16 qid, u8 irq, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> cq_dma_page, OwnPtr<Memory::Region> sq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> sq_dma_page, Memory::TypedMapping<volatile DoorbellRegister> db_regs);
+    class PinBasedInterruptHandler;
+    class MessageSignalledInterruptHandler;
+
+    enum class SlotState {
+        Free,
+        InUse,
+        Completed,
+        Finishing,
+    };
+
+    struct RequestSlot {
+        SlotState state { SlotState::Free };
+        AsyncDeviceRequest::RequestResult result { AsyncDeviceRequest::Success };
+        RefPtr<AsyncBlockDeviceRequest> request;
+        OwnPtr<Memory::Region> dma_region;
+        NonnullRefPtrVector<Memory::PhysicalPage> dma_pages;
+        OwnPtr<Memory::Region> prp_list_region;
+        RefPtr<Memory::PhysicalPage> prp_list_page;
+    };
+
+    struct PendingRequest {
+        NonnullRefPtr<AsyncBlockDeviceRequest> request;
+        u16 nsid;
+        u64 index;
+        u32 count;
+    };
 
-    virtual bool handle_irq(const RegisterState&) override;
+    NVMeQueue(u16 qid, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> cq_dma_page, OwnPtr<Memory::Region> sq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> sq_dma_page, Memory::TypedMapping<volatile DoorbellRegister> db_regs);
+    ErrorOr<void> allocate_request_slots();
 
     bool cqe_available();
     void update_cqe_head();
-    void complete_current_request(u16 status);
+    void push_sqe(NVMeSubmission&);
+    void submit_request(PendingRequest);
+    void start_request_in_slot(u16 slot_index, PendingRequest&);
+    void finish_completed_requests();
+    void schedule_finishing_completed_requests();
+    void poll_until_idle();
+    void set_data_pointer(NVMeSubmission&, RequestSlot const&, size_t transfer_size);
     void update_cq_doorbell()
     {
         m_db_regs->cq_head = m_cq_head;
@@ -60,10 +110,9 @@ private:
     u16 m_qid {};
     u8 m_cq_valid_phase { 1 };
     u16 m_sq_tail {};
-    u16 m_prev_sq_tail {};
     u16 m_cq_head {};
     bool m_admin_queue { false };
-    u8 m_irq {};
+    bool m_polled { false };
     u32 m_qdepth {};
     Spinlock m_cq_lock { LockRank::Interrupts };
     Spinlock m_sq_lock { LockRank::Interrupts };
@@ -73,10 +122,11 @@ private:
     OwnPtr<Memory::Region> m_sq_dma_region;
     NonnullRefPtrVector<Memory::PhysicalPage> m_sq_dma_page;
     Span<NVMeCompletion> m_cqe_array;
-    NonnullOwnPtr<Memory::Region> m_rw_dma_region;
     Memory::TypedMapping<volatile DoorbellRegister> m_db_regs;
-    NonnullRefPtr<Memory::PhysicalPage> m_rw_dma_page;
-    Spinlock m_request_lock;
-    RefPtr<AsyncBlockDeviceRequest> m_current_request;
+    OwnPtr<PinBasedInterruptHandler> m_pin_based_interrupt_handler;
+    OwnPtr<MessageSignalledInterruptHandler> m_message_signalled_interrupt_handler;
+    Spinlock m_request_lock { LockRank::Interrupts };
+    Array<RequestSlot, max_requests_in_flight> m_request_slots;
+    Vector<PendingRequest> m_pending_requests;
 };
 }
@@ -47,6 +47,18 @@ void DiskPartition::start_request(AsyncBlockDeviceRequest& request)
     request.add_sub_request(sub_request_or_error.release_value());
 }
 
+bool DiskPartition::supports_flush() const
+{
+    auto device = m_device.strong_ref();
+    return device && device->supports_flush();
+}
+
+bool DiskPartition::supports_discard() const
+{
+    auto device = m_device.strong_ref();
+    return device && device->supports_discard();
+}
+
 ErrorOr<size_t> DiskPartition::read(OpenFileDescription& fd, u64 offset, UserOrKernelBuffer& outbuf, size_t len)
 {
     unsigned adjust = m_metadata.start_block() * block_size();
@@ -21,6 +21,8 @@ public:
     virtual ~DiskPartition();
 
     virtual void start_request(AsyncBlockDeviceRequest&) override;
+    virtual bool supports_flush() const override;
+    virtual bool supports_discard() const override;
 
     // ^BlockDevice
     virtual ErrorOr<size_t> read(OpenFileDescription&, u64, UserOrKernelBuffer&, size_t) override;
@@ -32,6 +32,8 @@ private:
 
     // ^StorageDevice
     virtual CommandSet command_set() const override { return CommandSet::PlainMemory; }
+    // There's no DMA buffer in the way, so any request is just a memcpy.
+    virtual u32 max_blocks_per_request() const override { return NumericLimits<u32>::max(); }
 
     Mutex m_lock { "RamdiskDevice" };
 
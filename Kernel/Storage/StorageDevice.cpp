@@ -26,26 +26,22 @@ StringView StorageDevice::class_name() const
     return "StorageDevice"sv;
 }
 
-ErrorOr<size_t> StorageDevice::read(OpenFileDescription&, u64 offset, UserOrKernelBuffer& outbuf, size_t len)
+u32 StorageDevice::max_blocks_per_request() const
 {
-    unsigned index = offset / block_size();
-    u16 whole_blocks = len / block_size();
-    size_t remaining = len % block_size();
-
-    unsigned blocks_per_page = PAGE_SIZE / block_size();
-
-    // PATAChannel will chuck a wobbly if we try to read more than PAGE_SIZE
+    // PATAChannel will chuck a wobbly if we try to transfer more than PAGE_SIZE
     // at a time, because it uses a single page for its DMA buffer.
-    if (whole_blocks >= blocks_per_page) {
-        whole_blocks = blocks_per_page;
-        remaining = 0;
-    }
-
-    dbgln_if(STORAGE_DEVICE_DEBUG, "StorageDevice::read() index={}, whole_blocks={}, remaining={}", index, whole_blocks, remaining);
+    return PAGE_SIZE / block_size();
+}
 
-    if (whole_blocks > 0) {
-        auto read_request = TRY(try_make_request<AsyncBlockDeviceRequest>(AsyncBlockDeviceRequest::Read, index, whole_blocks, outbuf, whole_blocks * block_size()));
-        auto result = read_request->wait();
+ErrorOr<void> StorageDevice::transfer_whole_blocks(AsyncBlockDeviceRequest::RequestType request_type, u64 index, size_t block_count, UserOrKernelBuffer const& buffer)
+{
+    // Split the transfer into the largest requests the device can handle, so a large
+    // contiguous read or write doesn't have to go back and forth to the device per page.
+    size_t blocks_done = 0;
+    while (blocks_done < block_count) {
+        u32 blocks_in_request = min<size_t>(block_count - blocks_done, max_blocks_per_request());
+        auto request = TRY(try_make_request<AsyncBlockDeviceRequest>(request_type, index + blocks_done, blocks_in_request, buffer.offset(blocks_done * block_size()), blocks_in_request * block_size()));
+        auto result = request->wait();
         if (result.wait_result().was_interrupted())
             return EINTR;
         switch (result.request_result()) {
@@ -57,7 +53,21 @@ ErrorOr<size_t> StorageDevice::read(OpenFileDescription&, u64 offset, UserOrKern
         default:
             break;
         }
+        blocks_done += blocks_in_request;
     }
+    return {};
+}
+
+ErrorOr<size_t> StorageDevice::read(OpenFileDescription&, u64 offset, UserOrKernelBuffer& outbuf, size_t len)
+{
+    u64 index = offset / block_size();
+    size_t whole_blocks = len / block_size();
+    size_t remaining = len % block_size();
+
+    dbgln_if(STORAGE_DEVICE_DEBUG, "StorageDevice::read() index={}, whole_blocks={}, remaining={}", index, whole_blocks, remaining);
+
+    if (whole_blocks > 0)
+        TRY(transfer_whole_blocks(AsyncBlockDeviceRequest::Read, index, whole_blocks, outbuf));
 
     off_t pos = whole_blocks * block_size();
 
@@ -95,36 +105,14 @@ bool StorageDevice::can_read(const OpenFileDescription&, size_t offset) const
 
 ErrorOr<size_t> StorageDevice::write(OpenFileDescription&, u64 offset, const UserOrKernelBuffer& inbuf, size_t len)
 {
-    unsigned index = offset / block_size();
-    u16 whole_blocks = len / block_size();
+    u64 index = offset / block_size();
+    size_t whole_blocks = len / block_size();
     size_t remaining = len % block_size();
 
-    unsigned blocks_per_page = PAGE_SIZE / block_size();
-
-    // PATAChannel will chuck a wobbly if we try to write more than PAGE_SIZE
-    // at a time, because it uses a single page for its DMA buffer.
-    if (whole_blocks >= blocks_per_page) {
-        whole_blocks = blocks_per_page;
-        remaining = 0;
-    }
-
     dbgln_if(STORAGE_DEVICE_DEBUG, "StorageDevice::write() index={}, whole_blocks={}, remaining={}", index, whole_blocks, remaining);
 
-    if (whole_blocks > 0) {
-        auto write_request = TRY(try_make_request<AsyncBlockDeviceRequest>(AsyncBlockDeviceRequest::Write, index, whole_blocks, inbuf, whole_blocks * block_size()));
-        auto result = write_request->wait();
-        if (result.wait_result().was_interrupted())
-            return EINTR;
-        switch (result.request_result()) {
-        case AsyncDeviceRequest::Failure:
-        case AsyncDeviceRequest::Cancelled:
-            return EIO;
-        case AsyncDeviceRequest::MemoryFault:
-            return EFAULT;
-        default:
-            break;
-        }
-    }
+    if (whole_blocks > 0)
+        TRY(transfer_whole_blocks(AsyncBlockDeviceRequest::Write, index, whole_blocks, inbuf));
 
     off_t pos = whole_blocks * block_size();
 
@@ -31,11 +31,16 @@ public:
         SCSI,
         ATA,
         NVMe,
+        VirtIO,
     };
 
 public:
     virtual u64 max_addressable_block() const { return m_max_addressable_block; }
 
+    // The largest number of blocks a single AsyncBlockDeviceRequest may cover.
+    // Reads and writes spanning more blocks are split into several requests.
+    virtual u32 max_blocks_per_request() const;
+
     // ^BlockDevice
     virtual ErrorOr<size_t> read(OpenFileDescription&, u64, UserOrKernelBuffer&, size_t) override;
     virtual bool can_read(const OpenFileDescription&, size_t) const override;
@@ -61,6 +66,8 @@ protected:
     virtual StringView class_name() const override;
 
 private:
+    ErrorOr<void> transfer_whole_blocks(AsyncBlockDeviceRequest::RequestType, u64 index, size_t block_count, UserOrKernelBuffer const&);
+
     mutable IntrusiveListNode<StorageDevice, RefPtr<StorageDevice>> m_list_node;
     NonnullRefPtrVector<DiskPartition> m_partitions;
 
@@ -10,6 +10,7 @@
 #include <Kernel/Bus/PCI/API.h>
 #include <Kernel/Bus/PCI/Access.h>
 #include <Kernel/Bus/PCI/Controller/VolumeManagementDevice.h>
+#include <Kernel/Bus/PCI/IDs.h>
 #include <Kernel/CommandLine.h>
 #include <Kernel/Devices/BlockDevice.h>
 #include <Kernel/FileSystem/Ext2FileSystem.h>
@@ -22,6 +23,7 @@
 #include <Kernel/Storage/Partition/MBRPartitionTable.h>
 #include <Kernel/Storage/RamdiskController.h>
 #include <Kernel/Storage/StorageManagement.h>
+#include <Kernel/Storage/VirtIO/VirtIOBlockController.h>
 
 namespace Kernel {
 
@@ -56,6 +58,18 @@ UNMAP_AFTER_INIT void StorageManagement::enumerate_controllers(bool force_pio)
                 return;
             }
 
+            if (device_identifier.hardware_id().vendor_id == PCI::VendorID::VirtIO) {
+                if (device_identifier.hardware_id().device_id != PCI::DeviceID::VirtIOBlockDevice || kernel_command_line().disable_virtio())
+                    return;
+                auto controller = VirtIOBlockController::try_initialize(device_identifier);
+                if (controller.is_error()) {
+                    dmesgln("Unable to initialize VirtIO block device: {}", controller.error());
+                } else {
+                    m_controllers.append(controller.release_value());
+                }
+                return;
+            }
+
             {
                 static constexpr PCI::HardwareID vmd_device = { 0x8086, 0x9a0b };
                 if (device_identifier.hardware_id() == vmd_device) {
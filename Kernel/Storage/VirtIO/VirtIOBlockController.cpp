@@ -0,0 +1,430 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Array.h>
+#include <Kernel/Arch/x86/Processor.h>
+#include <Kernel/Bus/PCI/IDs.h>
+#include <Kernel/Sections.h>
+#include <Kernel/Storage/VirtIO/VirtIOBlockController.h>
+#include <Kernel/Storage/VirtIO/VirtIOBlockDevice.h>
+#include <Kernel/WorkQueue.h>
+
+namespace Kernel {
+
+#define VIRTIO_BLK_F_SEG_MAX ((u64)1 << 2)
+#define VIRTIO_BLK_F_RO ((u64)1 << 5)
+#define VIRTIO_BLK_F_BLK_SIZE ((u64)1 << 6)
+#define VIRTIO_BLK_F_FLUSH ((u64)1 << 9)
+#define VIRTIO_BLK_F_MQ ((u64)1 << 12)
+#define VIRTIO_BLK_F_DISCARD ((u64)1 << 13)
+
+#define VIRTIO_BLK_T_IN 0
+#define VIRTIO_BLK_T_OUT 1
+#define VIRTIO_BLK_T_FLUSH 4
+#define VIRTIO_BLK_T_DISCARD 11
+
+#define VIRTIO_BLK_S_OK 0
+
+// virtio_blk_config
+#define DEVICE_CONFIG_CAPACITY 0x0
+#define DEVICE_CONFIG_SEG_MAX 0xc
+#define DEVICE_CONFIG_BLK_SIZE 0x14
+#define DEVICE_CONFIG_NUM_QUEUES 0x22
+#define DEVICE_CONFIG_MAX_DISCARD_SECTORS 0x24
+#define DEVICE_CONFIG_MAX_DISCARD_SEG 0x28
+
+// Request headers and discard segments always count in 512 byte sectors, whatever the block size.
+static constexpr size_t sector_size = 512;
+
+struct [[gnu::packed]] VirtIOBlockRequestHeader {
+    u32 type;
+    u32 reserved;
+    u64 sector;
+};
+
+struct [[gnu::packed]] VirtIOBlockDiscardSegment {
+    u64 sector;
+    u32 sector_count;
+    u32 flags;
+};
+
+// Layout of the control page of every request slot.
+static constexpr size_t header_offset = 0;
+static constexpr size_t status_offset = 16;
+static constexpr size_t discard_segments_offset = 32;
+static constexpr size_t max_discard_segments_per_request = 14;
+static constexpr size_t indirect_table_offset = 256;
+static_assert(discard_segments_offset + max_discard_segments_per_request * sizeof(VirtIOBlockDiscardSegment) <= indirect_table_offset);
+static_assert(indirect_table_offset + (VirtIOBlockController::max_data_pages_per_request + 2) * sizeof(VirtIO::Queue::QueueDescriptor) <= PAGE_SIZE);
+
+UNMAP_AFTER_INIT ErrorOr<NonnullRefPtr<VirtIOBlockController>> VirtIOBlockController::try_initialize(PCI::DeviceIdentifier const& device_identifier)
+{
+    VERIFY(device_identifier.hardware_id().vendor_id == PCI::VendorID::VirtIO);
+    VERIFY(device_identifier.hardware_id().device_id == PCI::DeviceID::VirtIOBlockDevice);
+    auto controller = TRY(adopt_nonnull_ref_or_enomem(new (nothrow) VirtIOBlockController(device_identifier)));
+    TRY(controller->initialize_controller());
+    return controller;
+}
+
+UNMAP_AFTER_INIT VirtIOBlockController::VirtIOBlockController(PCI::DeviceIdentifier const& device_identifier)
+    : StorageController()
+    , VirtIO::Device(device_identifier)
+{
+}
+
+UNMAP_AFTER_INIT ErrorOr<void> VirtIOBlockController::initialize_controller()
+{
+    VirtIO::Device::initialize();
+
+    bool success = negotiate_features([&](u64 device_features) {
+        u64 accepted_features = 0;
+        auto accept_if_offered = [&](u64 feature) {
+            if (is_feature_set(device_features, feature))
+                accepted_features |= feature;
+        };
+        accept_if_offered(VIRTIO_BLK_F_SEG_MAX);
+        accept_if_offered(VIRTIO_BLK_F_RO);
+        accept_if_offered(VIRTIO_BLK_F_BLK_SIZE);
+        accept_if_offered(VIRTIO_BLK_F_FLUSH);
+        accept_if_offered(VIRTIO_BLK_F_MQ);
+        accept_if_offered(VIRTIO_BLK_F_DISCARD);
+        // A request takes up a single descriptor of the queue this way, so the queue size is how many can be in flight.
+        accept_if_offered(VIRTIO_F_INDIRECT_DESC);
+        return accepted_features;
+    });
+    if (!success)
+        return EIO;
+
+    auto const* device_config = get_config(VirtIO::ConfigurationType::Device);
+    if (!device_config) {
+        dbgln("{}: Device has no configuration", class_name());
+        return ENODEV;
+    }
+
+    u64 capacity_in_sectors = 0;
+    u32 block_size = sector_size;
+    u32 max_segment_count = 0;
+    u16 available_queue_count = 1;
+    read_config_atomic([&] {
+        capacity_in_sectors = config_read32(*device_config, DEVICE_CONFIG_CAPACITY) | (static_cast<u64>(config_read32(*device_config, DEVICE_CONFIG_CAPACITY + 4)) << 32);
+        if (is_feature_accepted(VIRTIO_BLK_F_SEG_MAX))
+            max_segment_count = config_read32(*device_config, DEVICE_CONFIG_SEG_MAX);
+        if (is_feature_accepted(VIRTIO_BLK_F_BLK_SIZE))
+            block_size = config_read32(*device_config, DEVICE_CONFIG_BLK_SIZE);
+        if (is_feature_accepted(VIRTIO_BLK_F_MQ))
+            available_queue_count = max<u16>(config_read16(*device_config, DEVICE_CONFIG_NUM_QUEUES), 1);
+        if (is_feature_accepted(VIRTIO_BLK_F_DISCARD)) {
+            m_max_discard_sector_count = config_read32(*device_config, DEVICE_CONFIG_MAX_DISCARD_SECTORS);
+            m_max_discard_segment_count = min<u32>(config_read32(*device_config, DEVICE_CONFIG_MAX_DISCARD_SEG), max_discard_segments_per_request);
+        }
+    });
+
+    // The block size is only the optimal one, the device always accepts anything in 512 byte sectors.
+    if (block_size < sector_size || block_size > PAGE_SIZE || (block_size & (block_size - 1)) != 0)
+        block_size = sector_size;
+    m_sectors_per_block = block_size / sector_size;
+    m_read_only = is_feature_accepted(VIRTIO_BLK_F_RO);
+    m_supports_flush = is_feature_accepted(VIRTIO_BLK_F_FLUSH);
+    m_uses_indirect_descriptors = is_feature_accepted(VIRTIO_F_INDIRECT_DESC);
+    if (max_segment_count != 0)
+        m_max_data_pages_per_request = clamp<size_t>(max_segment_count, 1, max_data_pages_per_request);
+    if (m_max_discard_segment_count == 0)
+        m_max_discard_sector_count = 0;
+
+    u16 queue_count = min(min(available_queue_count, static_cast<u16>(Processor::count())), max_queue_count);
+    if (!setup_queues(queue_count))
+        return EIO;
+    finish_init();
+
+    TRY(create_request_queues(queue_count));
+
+    m_device = TRY(VirtIOBlockDevice::try_create(*this, block_size, capacity_in_sectors / m_sectors_per_block));
+    dmesgln("{}: {} with {} blocks of {} bytes, {} queues{}{}{}", class_name(), m_device->early_storage_name(), capacity_in_sectors / m_sectors_per_block, block_size, queue_count,
+        m_read_only ? ", read-only"sv : ""sv, m_supports_flush ? ", write cache"sv : ""sv, supports_discard() ? ", discard"sv : ""sv);
+    return {};
+}
+
+UNMAP_AFTER_INIT ErrorOr<void> VirtIOBlockController::create_request_queues(u16 queue_count)
+{
+    TRY(m_request_queues.try_ensure_capacity(queue_count));
+    for (u16 queue_index = 0; queue_index < queue_count; ++queue_index) {
+        // Without indirect descriptors, every buffer of a request takes up a descriptor of the queue.
+        size_t descriptors_per_request = m_uses_indirect_descriptors ? 1 : m_max_data_pages_per_request + 2;
+        size_t slot_count = min(max_requests_in_flight_per_queue, get_queue(queue_index).size() / descriptors_per_request);
+        if (slot_count == 0)
+            return ENOSPC;
+
+        RequestQueue request_queue;
+        request_queue.queue_index = queue_index;
+        request_queue.control_region = TRY(MM.allocate_contiguous_kernel_region(slot_count * PAGE_SIZE, "VirtIOBlockController Requests"sv, Memory::Region::Access::ReadWrite));
+        TRY(request_queue.slots.try_resize(slot_count));
+        for (auto& slot : request_queue.slots)
+            slot.data_region = TRY(MM.allocate_dma_buffer_pages(m_max_data_pages_per_request * PAGE_SIZE, "VirtIOBlockController DMA"sv, Memory::Region::Access::ReadWrite, slot.data_pages));
+        m_request_queues.unchecked_append(move(request_queue));
+    }
+    return {};
+}
+
+RefPtr<StorageDevice> VirtIOBlockController::device(u32 index) const
+{
+    if (index != 0)
+        return {};
+    return m_device;
+}
+
+bool VirtIOBlockController::reset()
+{
+    TODO();
+    return false;
+}
+
+bool VirtIOBlockController::shutdown()
+{
+    TODO();
+    return false;
+}
+
+void VirtIOBlockController::complete_current_request(AsyncDeviceRequest::RequestResult)
+{
+    VERIFY_NOT_REACHED();
+}
+
+u8* VirtIOBlockController::control_page(RequestQueue& request_queue, size_t slot_index)
+{
+    return request_queue.control_region->vaddr().offset(slot_index * PAGE_SIZE).as_ptr();
+}
+
+PhysicalAddress VirtIOBlockController::control_page_address(RequestQueue const& request_queue, size_t slot_index) const
+{
+    return request_queue.control_region->physical_page(0)->paddr().offset(slot_index * PAGE_SIZE);
+}
+
+void VirtIOBlockController::start_request(AsyncBlockDeviceRequest& request)
+{
+    auto request_type = request.request_type();
+    if (m_read_only && (request_type == AsyncBlockDeviceRequest::Write || request_type == AsyncBlockDeviceRequest::Discard)) {
+        request.complete(AsyncDeviceRequest::Failure);
+        return;
+    }
+    if (request_type == AsyncBlockDeviceRequest::Discard && request.block_count() == 0) {
+        request.complete(AsyncDeviceRequest::Success);
+        return;
+    }
+    if (request_type == AsyncBlockDeviceRequest::Read || request_type == AsyncBlockDeviceRequest::Write)
+        VERIFY(request.buffer_size() <= m_max_data_pages_per_request * PAGE_SIZE);
+
+    // NOTE: There can be fewer queues than processors if the device doesn't offer enough of them.
+    auto& request_queue = m_request_queues[Processor::current_id() % m_request_queues.size()];
+    Optional<size_t> slot_index;
+    {
+        SpinlockLocker locker(get_queue(request_queue.queue_index).lock());
+        for (size_t i = 0; i < request_queue.slots.size(); ++i) {
+            auto& slot = request_queue.slots[i];
+            if (slot.state != SlotState::Free)
+                continue;
+            slot.state = SlotState::InUse;
+            slot.request = request;
+            slot_index = i;
+            break;
+        }
+        if (!slot_index.has_value()) {
+            // Whoever frees up the next slot starts this request.
+            if (request_queue.pending_requests.try_append(request).is_error()) {
+                locker.unlock();
+                request.complete(AsyncDeviceRequest::Failure);
+            }
+            return;
+        }
+    }
+    start_request_in_slot(request_queue, slot_index.value());
+}
+
+void VirtIOBlockController::start_request_in_slot(RequestQueue& request_queue, size_t slot_index)
+{
+    // NOTE: While a slot is in use, only the one who put it in use touches its buffers, so no lock is needed here.
+    auto& slot = request_queue.slots[slot_index];
+    auto& request = *slot.request;
+    auto* control = control_page(request_queue, slot_index);
+    auto control_address = control_page_address(request_queue, slot_index);
+
+    struct Buffer {
+        PhysicalAddress address;
+        size_t length;
+        VirtIO::BufferType type;
+    };
+    Array<Buffer, max_data_pages_per_request + 2> buffers;
+    size_t buffer_count = 0;
+    auto add_data_pages = [&](VirtIO::BufferType type) {
+        for (size_t offset = 0; offset < request.buffer_size(); offset += PAGE_SIZE)
+            buffers[buffer_count++] = { slot.data_pages[offset / PAGE_SIZE].paddr(), min<size_t>(PAGE_SIZE, request.buffer_size() - offset), type };
+    };
+
+    auto& header = *reinterpret_cast<VirtIOBlockRequestHeader*>(control + header_offset);
+    header = {};
+    header.sector = request.block_index() * m_sectors_per_block;
+    buffers[buffer_count++] = { control_address.offset(header_offset), sizeof(VirtIOBlockRequestHeader), VirtIO::BufferType::DeviceReadable };
+
+    switch (request.request_type()) {
+    case AsyncBlockDeviceRequest::Read:
+        header.type = VIRTIO_BLK_T_IN;
+        add_data_pages(VirtIO::BufferType::DeviceWritable);
+        break;
+    case AsyncBlockDeviceRequest::Write:
+        header.type = VIRTIO_BLK_T_OUT;
+        if (auto result = request.read_from_buffer(request.buffer(), slot.data_region->vaddr().as_ptr(), request.buffer_size()); result.is_error()) {
+            complete_slot(request_queue, slot_index, AsyncDeviceRequest::MemoryFault);
+            return;
+        }
+        add_data_pages(VirtIO::BufferType::DeviceReadable);
+        break;
+    case AsyncBlockDeviceRequest::Flush:
+        header.type = VIRTIO_BLK_T_FLUSH;
+        header.sector = 0;
+        break;
+    case AsyncBlockDeviceRequest::Discard: {
+        header.type = VIRTIO_BLK_T_DISCARD;
+        header.sector = 0;
+        auto* segments = reinterpret_cast<VirtIOBlockDiscardSegment*>(control + discard_segments_offset);
+        u64 sector = request.block_index() * m_sectors_per_block;
+        u64 remaining_sector_count = static_cast<u64>(request.block_count()) * m_sectors_per_block;
+        size_t segment_count = 0;
+        // Whatever doesn't fit into a single request is simply not discarded, which is fine for a hint.
+        while (remaining_sector_count > 0 && segment_count < m_max_discard_segment_count) {
+            u32 sector_count = min<u64>(remaining_sector_count, m_max_discard_sector_count);
+            segments[segment_count++] = { sector, sector_count, 0 };
+            sector += sector_count;
+            remaining_sector_count -= sector_count;
+        }
+        buffers[buffer_count++] = { control_address.offset(discard_segments_offset), segment_count * sizeof(VirtIOBlockDiscardSegment), VirtIO::BufferType::DeviceReadable };
+        break;
+    }
+    }
+
+    control[status_offset] = 0xff;
+    buffers[buffer_count++] = { control_address.offset(status_offset), 1, VirtIO::BufferType::DeviceWritable };
+
+    auto& queue = get_queue(request_queue.queue_index);
+    SpinlockLocker locker(queue.lock());
+    VirtIO::QueueChain chain(queue);
+    // NOTE: The slots were sized so that the queue never runs out of descriptors.
+    if (m_uses_indirect_descriptors) {
+        auto* table = reinterpret_cast<VirtIO::Queue::QueueDescriptor*>(control + indirect_table_offset);
+        for (size_t i = 0; i < buffer_count; ++i) {
+            bool is_last = i + 1 == buffer_count;
+            table[i] = {
+                .address = buffers[i].address.get(),
+                .length = static_cast<u32>(buffers[i].length),
+                .flags = static_cast<u16>(static_cast<u16>(buffers[i].type) | (is_last ? 0 : VIRTQ_DESC_F_NEXT)),
+                .next = static_cast<u16>(is_last ? 0 : i + 1),
+            };
+        }
+        VERIFY(chain.add_indirect_table_to_chain(control_address.offset(indirect_table_offset), buffer_count));
+    } else {
+        for (size_t i = 0; i < buffer_count; ++i)
+            VERIFY(chain.add_buffer_to_chain(buffers[i].address, buffers[i].length, buffers[i].type));
+    }
+    supply_chain_and_notify(request_queue.queue_index, chain);
+}
+
+void VirtIOBlockController::complete_slot(RequestQueue& request_queue, size_t slot_index, AsyncDeviceRequest::RequestResult result)
+{
+    {
+        SpinlockLocker locker(get_queue(request_queue.queue_index).lock());
+        auto& slot = request_queue.slots[slot_index];
+        VERIFY(slot.state == SlotState::InUse);
+        slot.result = result;
+        slot.state = SlotState::Completed;
+    }
+    schedule_finishing_completed_requests(request_queue);
+}
+
+bool VirtIOBlockController::handle_device_config_change()
+{
+    // NOTE: This usually means that the disk was resized by the host, which we can't handle yet.
+    dbgln("{}: Device configuration changed", class_name());
+    return true;
+}
+
+void VirtIOBlockController::handle_queue_update(u16 queue_index)
+{
+    if (queue_index >= m_request_queues.size())
+        return;
+    auto& request_queue = m_request_queues[queue_index];
+    auto& queue = get_queue(queue_index);
+
+    bool completed_any_request = false;
+    {
+        SpinlockLocker locker(queue.lock());
+        size_t used;
+        for (auto chain = queue.pop_used_buffer_chain(used); !chain.is_empty(); chain = queue.pop_used_buffer_chain(used)) {
+            // Requests are identified by their control page, which holds the first buffer in their chain.
+            Optional<size_t> slot_index;
+            chain.for_each([&](PhysicalAddress address, size_t) {
+                if (!slot_index.has_value())
+                    slot_index = (address.get() - control_page_address(request_queue, 0).get()) / PAGE_SIZE;
+            });
+            chain.release_buffer_slots_to_queue();
+
+            VERIFY(slot_index.has_value() && slot_index.value() < request_queue.slots.size());
+            auto& slot = request_queue.slots[slot_index.value()];
+            VERIFY(slot.state == SlotState::InUse);
+            slot.result = control_page(request_queue, slot_index.value())[status_offset] == VIRTIO_BLK_S_OK ? AsyncDeviceRequest::Success : AsyncDeviceRequest::Failure;
+            slot.state = SlotState::Completed;
+            completed_any_request = true;
+        }
+    }
+    if (completed_any_request)
+        schedule_finishing_completed_requests(request_queue);
+}
+
+void VirtIOBlockController::schedule_finishing_completed_requests(RequestQueue& request_queue)
+{
+    // Copying into the requester's buffer can't happen in the interrupt handler.
+    g_io_work->queue([this, queue_index = request_queue.queue_index]() {
+        finish_completed_requests(m_request_queues[queue_index]);
+    });
+}
+
+void VirtIOBlockController::finish_completed_requests(RequestQueue& request_queue)
+{
+    auto& queue = get_queue(request_queue.queue_index);
+    for (size_t slot_index = 0; slot_index < request_queue.slots.size(); ++slot_index) {
+        auto& slot = request_queue.slots[slot_index];
+        RefPtr<AsyncBlockDeviceRequest> request;
+        {
+            SpinlockLocker locker(queue.lock());
+            if (slot.state != SlotState::Completed)
+                continue;
+            slot.state = SlotState::Finishing;
+            request = move(slot.request);
+        }
+
+        // The slot can't be reused until we're done copying out of its buffer.
+        auto result = slot.result;
+        if (result == AsyncDeviceRequest::Success && request->request_type() == AsyncBlockDeviceRequest::Read) {
+            if (auto write_result = request->write_to_buffer(request->buffer(), slot.data_region->vaddr().as_ptr(), request->buffer_size()); write_result.is_error())
+                result = AsyncDeviceRequest::MemoryFault;
+        }
+
+        bool has_next_request = false;
+        {
+            SpinlockLocker locker(queue.lock());
+            if (request_queue.pending_requests.is_empty()) {
+                slot.state = SlotState::Free;
+            } else {
+                slot.state = SlotState::InUse;
+                slot.request = request_queue.pending_requests.take_first();
+                has_next_request = true;
+            }
+        }
+
+        request->complete(result);
+        if (has_next_request)
+            start_request_in_slot(request_queue, slot_index);
+    }
+}
+
+}
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/NonnullRefPtrVector.h>
+#include <AK/OwnPtr.h>
+#include <AK/RefPtr.h>
+#include <AK/Vector.h>
+#include <AK/Weakable.h>
+#include <Kernel/Bus/VirtIO/Device.h>
+#include <Kernel/Devices/BlockDevice.h>
+#include <Kernel/Storage/StorageController.h>
+
+namespace Kernel {
+
+class VirtIOBlockDevice;
+
+// A virtio-blk PCI function, which always carries exactly one disk.
+class VirtIOBlockController final
+    : public StorageController
+    , public VirtIO::Device
+    , public Weakable<VirtIOBlockController> {
+public:
+    // A single read or write covers at most this many pages, fewer if the device can't take that many segments.
+    static constexpr size_t max_data_pages_per_request = 16;
+    // Every queue keeps up to this many requests in flight, each with its own DMA buffer.
+    // Requests beyond that wait in a backlog until a slot frees up.
+    static constexpr size_t max_requests_in_flight_per_queue = 32;
+    static constexpr u16 max_queue_count = 4;
+
+    static ErrorOr<NonnullRefPtr<VirtIOBlockController>> try_initialize(PCI::DeviceIdentifier const&);
+
+    virtual ~VirtIOBlockController() override = default;
+
+    // ^StorageController
+    virtual RefPtr<StorageDevice> device(u32 index) const override;
+    virtual size_t devices_count() const override { return m_device ? 1 : 0; }
+
+    size_t max_transfer_size() const { return m_max_data_pages_per_request * PAGE_SIZE; }
+    bool is_read_only() const { return m_read_only; }
+    bool supports_flush() const { return m_supports_flush; }
+    bool supports_discard() const { return m_max_discard_sector_count != 0; }
+
+    void start_request(AsyncBlockDeviceRequest&);
+
+protected:
+    // ^StorageController
+    virtual bool reset() override;
+    virtual bool shutdown() override;
+    virtual void complete_current_request(AsyncDeviceRequest::RequestResult) override;
+
+private:
+    enum class SlotState {
+        Free,
+        InUse,
+        Completed,
+        Finishing,
+    };
+
+    // Every slot owns a page for the request header, the status byte, discard segments and the
+    // indirect descriptor table, and the DMA buffer for its data.
+    struct RequestSlot {
+        SlotState state { SlotState::Free };
+        AsyncDeviceRequest::RequestResult result { AsyncDeviceRequest::Success };
+        RefPtr<AsyncBlockDeviceRequest> request;
+        OwnPtr<Memory::Region> data_region;
+        NonnullRefPtrVector<Memory::PhysicalPage> data_pages;
+    };
+
+    // All slot accounting is guarded by the lock of the virtqueue.
+    struct RequestQueue {
+        u16 queue_index { 0 };
+        OwnPtr<Memory::Region> control_region;
+        Vector<RequestSlot> slots;
+        Vector<NonnullRefPtr<AsyncBlockDeviceRequest>> pending_requests;
+    };
+
+    explicit VirtIOBlockController(PCI::DeviceIdentifier const&);
+
+    ErrorOr<void> initialize_controller();
+    ErrorOr<void> create_request_queues(u16 queue_count);
+
+    void start_request_in_slot(RequestQueue&, size_t slot_index);
+    void complete_slot(RequestQueue&, size_t slot_index, AsyncDeviceRequest::RequestResult);
+    void schedule_finishing_completed_requests(RequestQueue&);
+    void finish_completed_requests(RequestQueue&);
+
+    u8* control_page(RequestQueue&, size_t slot_index);
+    PhysicalAddress control_page_address(RequestQueue const&, size_t slot_index) const;
+
+    // ^VirtIO::Device
+    virtual StringView class_name() const override { return "VirtIOBlockController"sv; }
+    virtual bool handle_device_config_change() override;
+    virtual void handle_queue_update(u16 queue_index) override;
+
+    RefPtr<VirtIOBlockDevice> m_device;
+    Vector<RequestQueue> m_request_queues;
+
+    u32 m_sectors_per_block { 1 };
+    size_t m_max_data_pages_per_request { max_data_pages_per_request };
+    bool m_uses_indirect_descriptors { false };
+    bool m_read_only { false };
+    bool m_supports_flush { false };
+    u32 m_max_discard_sector_count { 0 };
+    u32 m_max_discard_segment_count { 0 };
+};
+
+}
@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Atomic.h>
+#include <Kernel/Devices/DeviceManagement.h>
+#include <Kernel/Sections.h>
+#include <Kernel/Storage/StorageManagement.h>
+#include <Kernel/Storage/VirtIO/VirtIOBlockDevice.h>
+
+namespace Kernel {
+
+static Atomic<u8> s_next_device_letter_index;
+
+UNMAP_AFTER_INIT ErrorOr<NonnullRefPtr<VirtIOBlockDevice>> VirtIOBlockDevice::try_create(VirtIOBlockController const& controller, size_t sector_size, u64 max_addressable_block)
+{
+    // NOTE: Like the ATA disks, these are named vda, vdb and so on, so partitions are simply vda1, vda2 and so on.
+    auto letter_index = s_next_device_letter_index.fetch_add(1);
+    if (letter_index >= 26)
+        return ENODEV;
+    auto device_name = TRY(KString::formatted("vd{:c}", 'a' + letter_index));
+    auto minor_number = StorageManagement::generate_storage_minor_number();
+    return DeviceManagement::try_create_device<VirtIOBlockDevice>(controller, minor_number, sector_size, max_addressable_block, move(device_name));
+}
+
+UNMAP_AFTER_INIT VirtIOBlockDevice::VirtIOBlockDevice(VirtIOBlockController const& controller, MinorNumber minor_number, size_t sector_size, u64 max_addressable_block, NonnullOwnPtr<KString> early_device_name)
+    : StorageDevice(StorageManagement::storage_type_major_number(), minor_number, sector_size, max_addressable_block, move(early_device_name))
+    , m_controller(controller)
+{
+}
+
+void VirtIOBlockDevice::start_request(AsyncBlockDeviceRequest& request)
+{
+    auto controller = m_controller.strong_ref();
+    if (!controller) {
+        request.complete(AsyncDeviceRequest::Failure);
+        return;
+    }
+    controller->start_request(request);
+}
+
+u32 VirtIOBlockDevice::max_blocks_per_request() const
+{
+    auto controller = m_controller.strong_ref();
+    VERIFY(controller);
+    return controller->max_transfer_size() / block_size();
+}
+
+bool VirtIOBlockDevice::supports_flush() const
+{
+    auto controller = m_controller.strong_ref();
+    return controller && controller->supports_flush();
+}
+
+bool VirtIOBlockDevice::supports_discard() const
+{
+    auto controller = m_controller.strong_ref();
+    return controller && controller->supports_discard();
+}
+
+}
@@ -0,0 +1,43 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/WeakPtr.h>
+#include <Kernel/Storage/StorageDevice.h>
+#include <Kernel/Storage/VirtIO/VirtIOBlockController.h>
+
+namespace Kernel {
+
+class VirtIOBlockDevice final : public StorageDevice {
+    friend class DeviceManagement;
+
+public:
+    static ErrorOr<NonnullRefPtr<VirtIOBlockDevice>> try_create(VirtIOBlockController const&, size_t sector_size, u64 max_addressable_block);
+
+    // ^StorageDevice
+    virtual CommandSet command_set() const override { return CommandSet::VirtIO; }
+    virtual u32 max_blocks_per_request() const override;
+
+    // ^BlockDevice
+    virtual void start_request(AsyncBlockDeviceRequest&) override;
+    virtual bool supports_flush() const override;
+    virtual bool supports_discard() const override;
+
+    // ^Device
+    // Every queue of the controller keeps many requests in flight.
+    virtual bool can_process_requests_concurrently() const override { return true; }
+
+private:
+    VirtIOBlockDevice(VirtIOBlockController const&, MinorNumber, size_t sector_size, u64 max_addressable_block, NonnullOwnPtr<KString> early_device_name);
+
+    // ^DiskDevice
+    virtual StringView class_name() const override { return "VirtIOBlockDevice"sv; }
+
+    WeakPtr<VirtIOBlockController> m_controller;
+};
+
+}
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/JsonObjectSerializer.h>
+#include <Kernel/FileSystem/DentryCache.h>
+#include <Kernel/FileSystem/PageCache.h>
+#include <Kernel/Heap/kmalloc.h>
+#include <Kernel/Sections.h>
+#include <Kernel/SysFSKernel.h>
+
+namespace Kernel {
+
+UNMAP_AFTER_INIT void KernelSysFSDirectory::initialize()
+{
+    auto kernel_directory = adopt_ref_if_nonnull(new (nothrow) KernelSysFSDirectory()).release_nonnull();
+    SysFSComponentRegistry::the().register_new_component(kernel_directory);
+    kernel_directory->create_components();
+}
+
+UNMAP_AFTER_INIT void KernelSysFSDirectory::create_components()
+{
+    m_components.append(KmallocStatisticsSysFSComponent::must_create());
+    m_components.append(PageCacheStatisticsSysFSComponent::must_create());
+    m_components.append(DentryCacheStatisticsSysFSComponent::must_create());
+}
+
+UNMAP_AFTER_INIT KernelSysFSDirectory::KernelSysFSDirectory()
+    : SysFSDirectory(SysFSComponentRegistry::the().root_directory())
+{
+}
+
+ErrorOr<size_t> KernelStatisticsSysFSComponent::read_bytes(off_t offset, size_t count, UserOrKernelBuffer& buffer, OpenFileDescription*) const
+{
+    auto builder = TRY(KBufferBuilder::try_create());
+    TRY(try_generate(builder));
+    auto data = builder.build();
+    if (!data)
+        return ENOMEM;
+
+    if ((size_t)offset >= data->size())
+        return 0;
+
+    ssize_t nread = min(static_cast<off_t>(data->size() - offset), static_cast<off_t>(count));
+    TRY(buffer.write(data->data() + offset, nread));
+    return nread;
+}
+
+UNMAP_AFTER_INIT NonnullRefPtr<KmallocStatisticsSysFSComponent> KmallocStatisticsSysFSComponent::must_create()
+{
+    return adopt_ref(*new (nothrow) KmallocStatisticsSysFSComponent());
+}
+
+ErrorOr<void> KmallocStatisticsSysFSComponent::try_generate(KBufferBuilder& builder) const
+{
+    kmalloc_size_class_stats size_classes[KMALLOC_SIZE_CLASS_COUNT];
+    get_kmalloc_size_class_stats(size_classes);
+
+    JsonArraySerializer array { builder };
+    for (auto& size_class : size_classes) {
+        auto obj = array.add_object();
+        obj.add("slab_size", size_class.slab_size);
+        obj.add("magazine_hits", size_class.magazine_hits);
+        obj.add("magazine_misses", size_class.magazine_misses);
+        obj.add("free_magazine_hits", size_class.free_magazine_hits);
+        obj.add("magazine_flushes", size_class.magazine_flushes);
+        obj.add("cached_slabs", size_class.cached_slabs);
+    }
+    array.finish();
+    return {};
+}
+
+UNMAP_AFTER_INIT NonnullRefPtr<PageCacheStatisticsSysFSComponent> PageCacheStatisticsSysFSComponent::must_create()
+{
+    return adopt_ref(*new (nothrow) PageCacheStatisticsSysFSComponent());
+}
+
+ErrorOr<void> PageCacheStatisticsSysFSComponent::try_generate(KBufferBuilder& builder) const
+{
+    auto statistics = PageCache::the().statistics();
+    JsonObjectSerializer<KBufferBuilder> json { builder };
+    json.add("hits", statistics.hits);
+    json.add("misses", statistics.misses);
+    json.add("readahead_pages", statistics.readahead_pages);
+    json.add("evictions", statistics.evictions);
+    json.add("cached_pages", statistics.cached_pages);
+    json.finish();
+    return {};
+}
+
+UNMAP_AFTER_INIT NonnullRefPtr<DentryCacheStatisticsSysFSComponent> DentryCacheStatisticsSysFSComponent::must_create()
+{
+    return adopt_ref(*new (nothrow) DentryCacheStatisticsSysFSComponent());
+}
+
+ErrorOr<void> DentryCacheStatisticsSysFSComponent::try_generate(KBufferBuilder& builder) const
+{
+    auto statistics = DentryCache::the().statistics();
+    JsonObjectSerializer<KBufferBuilder> json { builder };
+    json.add("hits", statistics.hits);
+    json.add("negative_hits", statistics.negative_hits);
+    json.add("misses", statistics.misses);
+    json.add("invalidations", statistics.invalidations);
+    json.add("evictions", statistics.evictions);
+    json.add("cached_entries", statistics.cached_entries);
+    json.finish();
+    return {};
+}
+
+}
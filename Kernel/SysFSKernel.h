@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Types.h>
+#include <Kernel/FileSystem/SysFS.h>
+#include <Kernel/KBufferBuilder.h>
+
+namespace Kernel {
+
+// /sys/kernel holds statistics about kernel subsystems.
+class KernelSysFSDirectory final : public SysFSDirectory {
+public:
+    virtual StringView name() const override { return "kernel"sv; }
+    static void initialize();
+
+    void create_components();
+
+private:
+    KernelSysFSDirectory();
+};
+
+// A read-only node whose contents are regenerated on every read.
+class KernelStatisticsSysFSComponent : public SysFSComponent {
+public:
+    virtual ErrorOr<size_t> read_bytes(off_t, size_t, UserOrKernelBuffer&, OpenFileDescription*) const override;
+
+protected:
+    KernelStatisticsSysFSComponent() = default;
+    virtual ErrorOr<void> try_generate(KBufferBuilder&) const = 0;
+};
+
+class KmallocStatisticsSysFSComponent final : public KernelStatisticsSysFSComponent {
+public:
+    virtual StringView name() const override { return "kmalloc"sv; }
+    static NonnullRefPtr<KmallocStatisticsSysFSComponent> must_create();
+
+private:
+    KmallocStatisticsSysFSComponent() = default;
+    virtual ErrorOr<void> try_generate(KBufferBuilder&) const override;
+};
+
+class PageCacheStatisticsSysFSComponent final : public KernelStatisticsSysFSComponent {
+public:
+    virtual StringView name() const override { return "page_cache"sv; }
+    static NonnullRefPtr<PageCacheStatisticsSysFSComponent> must_create();
+
+private:
+    PageCacheStatisticsSysFSComponent() = default;
+    virtual ErrorOr<void> try_generate(KBufferBuilder&) const override;
+};
+
+class DentryCacheStatisticsSysFSComponent final : public KernelStatisticsSysFSComponent {
+public:
+    virtual StringView name() const override { return "dentry_cache"sv; }
+    static NonnullRefPtr<DentryCacheStatisticsSysFSComponent> must_create();
+
+private:
+    DentryCacheStatisticsSysFSComponent() = default;
+    virtual ErrorOr<void> try_generate(KBufferBuilder&) const override;
+};
+
+}
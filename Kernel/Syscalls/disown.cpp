@@ -19,6 +19,7 @@ ErrorOr<FlatPtr> Process::sys$disown(ProcessID pid)
         return ECHILD;
     ProtectedDataMutationScope scope(*process);
     process->m_protected_values.ppid = 0;
+    process->did_change_statistics();
     process->disowned_by_waiter(*this);
     return 0;
 }
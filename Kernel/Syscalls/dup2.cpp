@@ -18,9 +18,7 @@ ErrorOr<FlatPtr> Process::sys$dup2(int old_fd, int new_fd)
         return new_fd;
     if (new_fd < 0 || static_cast<size_t>(new_fd) >= OpenFileDescriptions::max_open())
         return EINVAL;
-    if (!m_fds.m_fds_metadatas[new_fd].is_allocated())
-        m_fds.m_fds_metadatas[new_fd].allocate();
-    m_fds[new_fd].set(move(description));
+    m_fds.set(new_fd, move(description));
     return new_fd;
 }
 
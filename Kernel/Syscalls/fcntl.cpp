@@ -24,13 +24,13 @@ ErrorOr<FlatPtr> Process::sys$fcntl(int fd, int cmd, u32 arg)
         if (arg_fd < 0)
             return EINVAL;
         auto fd_allocation = TRY(m_fds.allocate(arg_fd));
-        m_fds[fd_allocation.fd].set(*description);
+        m_fds.set(fd_allocation.fd, *description);
         return fd_allocation.fd;
     }
     case F_GETFD:
         return m_fds[fd].flags();
     case F_SETFD:
-        m_fds[fd].set_flags(arg);
+        m_fds.set_flags(fd, arg);
         break;
     case F_GETFL:
         return description->file_flags();
@@ -17,6 +17,18 @@ ErrorOr<FlatPtr> Process::sys$fork(RegisterState& regs)
 {
     VERIFY_PROCESS_BIG_LOCK_ACQUIRED(this);
     TRY(require_promise(Pledge::proc));
+    return do_fork(regs, ShareAddressSpace::No);
+}
+
+ErrorOr<FlatPtr> Process::sys$vfork(RegisterState& regs)
+{
+    VERIFY_PROCESS_BIG_LOCK_ACQUIRED(this);
+    TRY(require_promise(Pledge::proc));
+    return do_fork(regs, ShareAddressSpace::Yes);
+}
+
+ErrorOr<FlatPtr> Process::do_fork(RegisterState& regs, ShareAddressSpace share_address_space)
+{
     RefPtr<Thread> child_first_thread;
     auto child_name = TRY(m_name->try_clone());
     auto child = TRY(Process::try_create(child_first_thread, move(child_name), uid(), gid(), pid(), m_is_kernel_process, m_cwd, m_executable, m_tty, this));
@@ -97,13 +109,21 @@ ErrorOr<FlatPtr> Process::sys$fork(RegisterState& regs)
         child_regs.cs, child_regs.rip, child_regs.rsp, child_regs.rsp0);
 #endif
 
-    {
+    if (share_address_space == ShareAddressSpace::Yes) {
+        // The child runs on our memory until it execs or dies, so there's nothing to clone.
+        dbgln_if(FORK_DEBUG, "fork: child will borrow our address space");
+        child->m_borrowed_space_reference = address_space();
+        child->m_borrowed_space = &address_space();
+        child_regs.cr3 = address_space().page_directory().cr3();
+    } else {
         SpinlockLocker lock(address_space().get_lock());
         for (auto& region : address_space().regions()) {
             dbgln_if(FORK_DEBUG, "fork: cloning Region({}) '{}' @ {}", region, region->name(), region->vaddr());
             auto region_clone = TRY(region->try_clone());
             auto* child_region = TRY(child->address_space().add_region(move(region_clone)));
-            TRY(child_region->map(child->address_space().page_directory(), Memory::ShouldFlushTLB::No));
+            // Most of what we have mapped is never touched by a child that's about to exec anyway,
+            // so its page tables are only filled in as it faults on its pages.
+            child_region->map_lazily(child->address_space().page_directory());
 
             if (region == m_master_tls_region.unsafe_ptr())
                 child->m_master_tls_region = child_region;
@@ -114,16 +134,50 @@ ErrorOr<FlatPtr> Process::sys$fork(RegisterState& regs)
 
     PerformanceManager::add_process_created_event(*child);
 
-    SpinlockLocker lock(g_scheduler_lock);
-    child_first_thread->set_affinity(Thread::current()->affinity());
-    child_first_thread->set_state(Thread::State::Runnable);
+    {
+        SpinlockLocker lock(g_scheduler_lock);
+        child_first_thread->set_affinity(Thread::current()->affinity());
+        child_first_thread->set_state(Thread::State::Runnable);
+    }
 
     auto child_pid = child->pid().value();
 
+    // NOTE: The reference leaked below may go away as soon as the child is dead, so hold on to our own while we wait.
+    RefPtr<Process> borrowing_child;
+    if (share_address_space == ShareAddressSpace::Yes)
+        borrowing_child = child;
+
     // NOTE: All user processes have a leaked ref on them. It's balanced by Thread::WaitBlockerSet::finalize().
     (void)child.leak_ref();
 
+    if (borrowing_child)
+        borrowing_child->wait_for_borrowed_space_to_be_returned();
+
     return child_pid;
 }
 
+void Process::wait_for_borrowed_space_to_be_returned()
+{
+    // NOTE: We can't leave before the child is done with our memory, not even when we're being killed,
+    //       since our address space would go away under its feet. Take the child down with us instead.
+    bool did_kill_child = false;
+    while (AK::atomic_load(&m_borrowed_space, AK::memory_order_acquire)) {
+        m_borrowed_space_wait_queue.wait_forever("vfork"sv);
+        if (Thread::current()->should_die() && !did_kill_child) {
+            [[maybe_unused]] auto result = send_signal(SIGKILL, nullptr);
+            did_kill_child = true;
+        }
+    }
+}
+
+void Process::return_borrowed_space()
+{
+    if (!m_borrowed_space)
+        return;
+    AK::atomic_store(&m_borrowed_space, static_cast<Memory::AddressSpace*>(nullptr), AK::memory_order_release);
+    m_borrowed_space_wait_queue.wake_all();
+    // If our parent has exec'd in the meantime, this is the last reference to its old space.
+    m_borrowed_space_reference = nullptr;
+}
+
 }
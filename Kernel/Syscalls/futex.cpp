@@ -4,8 +4,9 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
-#include <AK/Singleton.h>
+#include <AK/Optional.h>
 #include <Kernel/Debug.h>
+#include <Kernel/FutexTable.h>
 #include <Kernel/Memory/MemoryManager.h>
 #include <Kernel/Process.h>
 
@@ -13,22 +14,36 @@ namespace Kernel {
 
 void Process::clear_futex_queues_on_exec()
 {
-    SpinlockLocker lock(m_futex_lock);
-    for (auto& it : m_futex_queues) {
-        bool did_wake_all;
-        it.value->wake_all(did_wake_all);
-        VERIFY(did_wake_all); // No one should be left behind...
+    FutexTable::the().wake_and_remove_private_queues(*this);
+}
+
+static ErrorOr<FutexKey> futex_key_for(Process& process, FlatPtr user_address, bool is_private, RefPtr<Memory::VMObject>& vmobject)
+{
+    if (user_address % alignof(u32) != 0)
+        return EINVAL;
+    if (!is_private) {
+        auto& address_space = process.address_space();
+        SpinlockLocker lock(address_space.get_lock());
+        auto* region = address_space.find_region_containing(Memory::VirtualRange { VirtualAddress(user_address), sizeof(u32) });
+        if (!region)
+            return EFAULT;
+        // Only memory that other processes can map as well needs a process-independent key.
+        if (region->is_shared()) {
+            vmobject = region->vmobject();
+            return FutexKey { FlatPtr(vmobject.ptr()), region->offset_in_vmobject_from_vaddr(VirtualAddress(user_address)) };
+        }
     }
-    m_futex_queues.clear();
+    return FutexKey { FlatPtr(&process), user_address };
 }
 
 ErrorOr<FlatPtr> Process::sys$futex(Userspace<const Syscall::SC_futex_params*> user_params)
 {
-    VERIFY_PROCESS_BIG_LOCK_ACQUIRED(this);
+    VERIFY_NO_PROCESS_BIG_LOCK(this);
     auto params = TRY(copy_typed_from_user(user_params));
 
     Thread::BlockTimeout timeout;
     u32 cmd = params.futex_op & FUTEX_CMD_MASK;
+    bool is_private = (params.futex_op & FUTEX_PRIVATE_FLAG) != 0;
 
     bool use_realtime_clock = (params.futex_op & FUTEX_CLOCK_REALTIME) != 0;
     if (use_realtime_clock && cmd != FUTEX_WAIT && cmd != FUTEX_WAIT_BITSET) {
@@ -37,9 +52,7 @@ ErrorOr<FlatPtr> Process::sys$futex(Userspace<const Syscall::SC_futex_params*> u
 
     switch (cmd) {
     case FUTEX_WAIT:
-    case FUTEX_WAIT_BITSET:
-    case FUTEX_REQUEUE:
-    case FUTEX_CMP_REQUEUE: {
+    case FUTEX_WAIT_BITSET: {
         if (params.timeout) {
             auto timeout_time = TRY(copy_time_from_user(params.timeout));
             bool is_absolute = cmd != FUTEX_WAIT;
@@ -56,80 +69,76 @@ ErrorOr<FlatPtr> Process::sys$futex(Userspace<const Syscall::SC_futex_params*> u
     }
     }
 
-    auto find_futex_queue = [&](FlatPtr user_address, bool create_if_not_found, bool* did_create = nullptr) -> RefPtr<FutexQueue> {
-        VERIFY(!create_if_not_found || did_create != nullptr);
-        auto* queues = &m_futex_queues;
-        auto it = m_futex_queues.find(user_address);
-        if (it != m_futex_queues.end())
-            return it->value;
-        if (create_if_not_found) {
-            *did_create = true;
-            auto futex_queue = adopt_ref(*new FutexQueue);
-            auto result = queues->set(user_address, futex_queue);
-            VERIFY(result == AK::HashSetResult::InsertedNewEntry);
-            return futex_queue;
-        }
-        return {};
-    };
-
-    auto remove_futex_queue = [&](FlatPtr user_address) {
-        if (auto it = m_futex_queues.find(user_address); it != m_futex_queues.end()) {
-            if (it->value->try_remove()) {
-                m_futex_queues.remove(it);
-            }
-        }
-    };
+    auto& futex_table = FutexTable::the();
+    auto user_address = FlatPtr(params.userspace_address);
+    auto user_address2 = FlatPtr(params.userspace_address2);
 
-    auto do_wake = [&](FlatPtr user_address, u32 count, Optional<u32> bitmask) -> int {
+    auto do_wake = [&](FlatPtr address, u32 count, Optional<u32> bitmask) -> ErrorOr<FlatPtr> {
         if (count == 0)
             return 0;
-        SpinlockLocker locker(m_futex_lock);
-        auto futex_queue = find_futex_queue(user_address, false);
+        RefPtr<Memory::VMObject> vmobject;
+        auto key = TRY(futex_key_for(*this, address, is_private, vmobject));
+        auto& bucket = futex_table.bucket_for(key);
+        // Pairs with the fence in do_wait(): either the waiter sees the value our caller
+        // stored before making this call, or we see the waiter in the bucket's count.
+        atomic_thread_fence(AK::MemoryOrder::memory_order_seq_cst);
+        if (bucket.waiter_count.load(AK::MemoryOrder::memory_order_relaxed) == 0)
+            return 0;
+
+        SpinlockLocker locker(bucket.lock);
+        auto futex_queue = bucket.find_queue(key);
         if (!futex_queue)
             return 0;
         bool is_empty;
         u32 woke_count = futex_queue->wake_n(count, bitmask, is_empty);
         if (is_empty) {
             // If there are no more waiters, we want to get rid of the futex!
-            remove_futex_queue(user_address);
+            bucket.remove_queue_if_unused(key);
         }
-        return (int)woke_count;
+        return woke_count;
     };
 
-    auto user_address = FlatPtr(params.userspace_address);
-    auto user_address2 = FlatPtr(params.userspace_address2);
-
     auto do_wait = [&](u32 bitset) -> ErrorOr<FlatPtr> {
-        bool did_create;
+        RefPtr<Memory::VMObject> vmobject;
+        auto key = TRY(futex_key_for(*this, user_address, is_private, vmobject));
+        auto& bucket = futex_table.bucket_for(key);
+
         RefPtr<FutexQueue> futex_queue;
-        do {
-            auto user_value = user_atomic_load_relaxed(params.userspace_address);
+        {
+            SpinlockLocker locker(bucket.lock);
+            futex_queue = TRY(bucket.find_or_create_queue(key, move(vmobject)));
+            futex_queue->queue_imminent_wait();
+            bucket.waiter_count.fetch_add(1, AK::MemoryOrder::memory_order_relaxed);
+        }
+        atomic_thread_fence(AK::MemoryOrder::memory_order_seq_cst);
+
+        auto finish_waiting = [&] {
+            // We may have been requeued, in which case we're leaving through the bucket of the target futex.
+            auto const& final_key = futex_queue->key();
+            auto& final_bucket = futex_table.bucket_for(final_key);
+            SpinlockLocker locker(final_bucket.lock);
+            final_bucket.waiter_count.fetch_sub(1, AK::MemoryOrder::memory_order_relaxed);
+            final_bucket.remove_queue_if_unused(final_key);
+        };
+
+        // We are already visible to wakers, so a wake that races with this check won't be lost:
+        // it either changes the value first, or hands us a pending wakeup.
+        auto user_value = user_atomic_load_relaxed(params.userspace_address);
+        if (!user_value.has_value() || user_value.value() != params.val) {
+            futex_queue->cancel_imminent_wait();
+            finish_waiting();
             if (!user_value.has_value())
                 return EFAULT;
-            if (user_value.value() != params.val) {
-                dbgln_if(FUTEX_DEBUG, "futex wait: EAGAIN. user value: {:p} @ {:p} != val: {}", user_value.value(), params.userspace_address, params.val);
-                return EAGAIN;
-            }
-            atomic_thread_fence(AK::MemoryOrder::memory_order_acquire);
-
-            SpinlockLocker locker(m_futex_lock);
-            did_create = false;
-            futex_queue = find_futex_queue(user_address, true, &did_create);
-            VERIFY(futex_queue);
-            // We need to try again if we didn't create this queue and the existing queue
-            // was removed before we were able to queue an imminent wait.
-        } while (!did_create && !futex_queue->queue_imminent_wait());
+            dbgln_if(FUTEX_DEBUG, "futex wait: EAGAIN. user value: {:p} @ {:p} != val: {}", user_value.value(), params.userspace_address, params.val);
+            return EAGAIN;
+        }
+        atomic_thread_fence(AK::MemoryOrder::memory_order_acquire);
 
         // We must not hold the lock before blocking. But we have a reference
         // to the FutexQueue so that we can keep it alive.
+        Thread::BlockResult block_result = FutexQueue::wait_on(futex_queue, timeout, bitset);
 
-        Thread::BlockResult block_result = futex_queue->wait_on(timeout, bitset);
-
-        SpinlockLocker locker(m_futex_lock);
-        if (futex_queue->is_empty_and_no_imminent_waits()) {
-            // If there are no more waiters, we want to get rid of the futex!
-            remove_futex_queue(user_address);
-        }
+        finish_waiting();
         if (block_result == Thread::BlockResult::InterruptedByTimeout) {
             return ETIMEDOUT;
         }
@@ -137,32 +146,58 @@ ErrorOr<FlatPtr> Process::sys$futex(Userspace<const Syscall::SC_futex_params*> u
     };
 
     auto do_requeue = [&](Optional<u32> val3) -> ErrorOr<FlatPtr> {
+        RefPtr<Memory::VMObject> vmobject;
+        auto key = TRY(futex_key_for(*this, user_address, is_private, vmobject));
+        RefPtr<Memory::VMObject> target_vmobject;
+        auto target_key = TRY(futex_key_for(*this, user_address2, is_private, target_vmobject));
+
         auto user_value = user_atomic_load_relaxed(params.userspace_address);
         if (!user_value.has_value())
             return EFAULT;
         if (val3.has_value() && val3.value() != user_value.value())
             return EAGAIN;
-        atomic_thread_fence(AK::MemoryOrder::memory_order_acquire);
+        atomic_thread_fence(AK::MemoryOrder::memory_order_seq_cst);
+
+        auto& bucket = futex_table.bucket_for(key);
+        auto& target_bucket = futex_table.bucket_for(target_key);
+        if (bucket.waiter_count.load(AK::MemoryOrder::memory_order_relaxed) == 0)
+            return 0;
+
+        // Hold both buckets for the whole operation, so that nobody can wake the target futex
+        // while its new waiters are still on their way over. Always lock them in the same order.
+        auto* first_bucket = &bucket < &target_bucket ? &bucket : &target_bucket;
+        auto* second_bucket = &bucket < &target_bucket ? &target_bucket : &bucket;
+        SpinlockLocker first_locker(first_bucket->lock);
+        Optional<SpinlockLocker<Spinlock>> second_locker;
+        if (second_bucket != first_bucket)
+            second_locker.emplace(second_bucket->lock);
+
+        auto futex_queue = bucket.find_queue(key);
+        if (!futex_queue)
+            return 0;
 
-        int woken_or_requeued = 0;
-        SpinlockLocker locker(m_futex_lock);
-        if (auto futex_queue = find_futex_queue(user_address, false)) {
-            RefPtr<FutexQueue> target_futex_queue;
-            bool is_empty, is_target_empty;
-            woken_or_requeued = futex_queue->wake_n_requeue(
-                params.val, [&]() -> FutexQueue* {
-                    // NOTE: futex_queue's lock is being held while this callback is called
-                    // The reason we're doing this in a callback is that we don't want to always
-                    // create a target queue, only if we actually have anything to move to it!
-                    target_futex_queue = find_futex_queue(user_address2, true);
-                    return target_futex_queue.ptr();
-                },
-                params.val2, is_empty, is_target_empty);
-            if (is_empty)
-                remove_futex_queue(user_address);
-            if (is_target_empty && target_futex_queue)
-                remove_futex_queue(user_address2);
+        RefPtr<FutexQueue> target_futex_queue;
+        u32 did_requeue = 0;
+        u32 woken_or_requeued = futex_queue->wake_n_requeue(
+            params.val, [&]() -> FutexQueue* {
+                // NOTE: futex_queue's lock is being held while this callback is called
+                // The reason we're doing this in a callback is that we don't want to always
+                // create a target queue, only if we actually have anything to move to it!
+                auto target_or_error = target_bucket.find_or_create_queue(target_key, move(target_vmobject));
+                if (target_or_error.is_error())
+                    return nullptr;
+                target_futex_queue = target_or_error.release_value();
+                return target_futex_queue.ptr();
+            },
+            params.val2, did_requeue);
+        if (did_requeue > 0 && &target_bucket != &bucket) {
+            // The moved waiters will leave through the target bucket, so their counts have to move along.
+            target_bucket.waiter_count.fetch_add(did_requeue, AK::MemoryOrder::memory_order_relaxed);
+            bucket.waiter_count.fetch_sub(did_requeue, AK::MemoryOrder::memory_order_relaxed);
         }
+        bucket.remove_queue_if_unused(key);
+        if (target_futex_queue)
+            target_bucket.remove_queue_if_unused(target_key);
         return woken_or_requeued;
     };
 
@@ -179,7 +214,7 @@ ErrorOr<FlatPtr> Process::sys$futex(Userspace<const Syscall::SC_futex_params*> u
         auto op = _FUTEX_OP(params.val3);
         if (op & FUTEX_OP_ARG_SHIFT) {
             op_arg = 1 << op_arg;
-            op &= FUTEX_OP_ARG_SHIFT;
+            op &= ~FUTEX_OP_ARG_SHIFT;
         }
         atomic_thread_fence(AK::MemoryOrder::memory_order_release);
         switch (op) {
@@ -204,7 +239,7 @@ ErrorOr<FlatPtr> Process::sys$futex(Userspace<const Syscall::SC_futex_params*> u
         if (!oldval.has_value())
             return EFAULT;
         atomic_thread_fence(AK::MemoryOrder::memory_order_acquire);
-        auto result = do_wake(user_address, params.val, {});
+        auto result = TRY(do_wake(user_address, params.val, {}));
         if (params.val2 > 0) {
             bool compare_result;
             switch (_FUTEX_CMP(params.val3)) {
@@ -230,7 +265,7 @@ ErrorOr<FlatPtr> Process::sys$futex(Userspace<const Syscall::SC_futex_params*> u
                 return EINVAL;
             }
             if (compare_result)
-                result += do_wake(user_address2, params.val2, {});
+                result += TRY(do_wake(user_address2, params.val2, {}));
         }
         return result;
     }
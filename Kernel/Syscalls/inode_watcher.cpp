@@ -26,10 +26,8 @@ ErrorOr<FlatPtr> Process::sys$create_inode_watcher(u32 flags)
     if (flags & static_cast<unsigned>(InodeWatcherFlags::Nonblock))
         description->set_blocking(false);
 
-    m_fds[fd_allocation.fd].set(move(description));
-
-    if (flags & static_cast<unsigned>(InodeWatcherFlags::CloseOnExec))
-        m_fds[fd_allocation.fd].set_flags(m_fds[fd_allocation.fd].flags() | FD_CLOEXEC);
+    u32 fd_flags = (flags & static_cast<unsigned>(InodeWatcherFlags::CloseOnExec)) ? FD_CLOEXEC : 0;
+    m_fds.set(fd_allocation.fd, move(description), fd_flags);
 
     return fd_allocation.fd;
 }
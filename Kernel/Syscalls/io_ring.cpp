@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <Kernel/FileSystem/IORing.h>
+#include <Kernel/FileSystem/OpenFileDescription.h>
+#include <Kernel/Process.h>
+
+namespace Kernel {
+
+ErrorOr<FlatPtr> Process::sys$io_ring_create(u32 entries, u32 flags, Userspace<io_ring_params*> user_params)
+{
+    VERIFY_PROCESS_BIG_LOCK_ACQUIRED(this)
+    TRY(require_promise(Pledge::stdio));
+
+    if (flags & ~IO_RING_CLOEXEC)
+        return EINVAL;
+
+    auto fd_allocation = TRY(m_fds.allocate());
+    auto ring = TRY(IORing::try_create(entries));
+    TRY(copy_to_user(user_params, &ring->params()));
+    auto description = TRY(OpenFileDescription::try_create(move(ring)));
+
+    // NOTE: The ring is mapped shared and writable, which mmap() only allows for readable and writable descriptions.
+    description->set_readable(true);
+    description->set_writable(true);
+    u32 fd_flags = (flags & IO_RING_CLOEXEC) ? FD_CLOEXEC : 0;
+    m_fds.set(fd_allocation.fd, move(description), fd_flags);
+
+    return fd_allocation.fd;
+}
+
+ErrorOr<FlatPtr> Process::sys$io_ring_enter(Userspace<const Syscall::SC_io_ring_enter_params*> user_params)
+{
+    VERIFY_NO_PROCESS_BIG_LOCK(this)
+    TRY(require_promise(Pledge::stdio));
+    auto params = TRY(copy_typed_from_user(user_params));
+
+    auto description = TRY(fds().open_file_description(params.ring_fd));
+    if (!description->is_io_ring())
+        return EBADF;
+    auto* ring = description->io_ring();
+
+    size_t submitted = 0;
+    if (params.to_submit > 0) {
+        auto submitted_or_error = ring->submit(*this, params.to_submit);
+        if (submitted_or_error.is_error()) {
+            // A full completion queue is not an error if the caller is about to wait for some of it to drain.
+            if (submitted_or_error.error().code() != EBUSY || params.min_complete == 0)
+                return submitted_or_error.release_error();
+        } else {
+            submitted = submitted_or_error.value();
+        }
+    }
+
+    if (params.min_complete > 0) {
+        Thread::BlockTimeout timeout;
+        if (params.timeout) {
+            auto timeout_time = TRY(copy_time_from_user(params.timeout));
+            timeout = Thread::BlockTimeout(false, &timeout_time);
+        }
+        auto min_complete = min(params.min_complete, ring->params().completion_entries);
+        auto result = ring->wait_for_completions(min_complete, timeout);
+        // NOTE: Once submitted, requests are in flight no matter what, so we have to report them.
+        if (result.is_error() && submitted == 0)
+            return result.release_error();
+    }
+
+    return submitted;
+}
+
+}
@@ -184,6 +184,11 @@ ErrorOr<FlatPtr> Process::sys$mmap(Userspace<const Syscall::SC_mmap_params*> use
 
     Memory::Region* region = nullptr;
 
+    // Private anonymous memory is backed by large pages where possible, and those need aligned addresses.
+    bool use_large_pages = map_anonymous && map_private && !map_stack && !map_noreserve && !(flags & MAP_PURGEABLE);
+    if (use_large_pages && rounded_size >= Memory::LARGE_PAGE_SIZE && !addr && alignment == PAGE_SIZE)
+        alignment = Memory::LARGE_PAGE_SIZE;
+
     auto range = TRY([&]() -> ErrorOr<Memory::VirtualRange> {
         if (map_randomized)
             return address_space().page_directory().range_allocator().try_allocate_randomized(rounded_size, alignment);
@@ -243,6 +248,8 @@ ErrorOr<FlatPtr> Process::sys$mmap(Userspace<const Syscall::SC_mmap_params*> use
         region->set_shared(true);
     if (map_stack)
         region->set_stack(true);
+    if (use_large_pages)
+        region->set_large_pages_allowed(true);
     region->set_name(move(name));
 
     PerformanceManager::add_mmap_perf_event(*this, *region);
@@ -420,6 +427,19 @@ ErrorOr<FlatPtr> Process::sys$madvise(Userspace<void*> address, size_t size, int
         TRY(vmobject.set_volatile(advice == MADV_SET_VOLATILE, was_purged));
         return was_purged ? 1 : 0;
     }
+    if (advice == MADV_HUGEPAGE || advice == MADV_NOHUGEPAGE) {
+        if (!region->vmobject().is_anonymous() || region->is_shared() || region->is_stack())
+            return EINVAL;
+        if (static_cast<Memory::AnonymousVMObject&>(region->vmobject()).is_purgeable())
+            return EINVAL;
+        bool allowed = advice == MADV_HUGEPAGE;
+        if (region->are_large_pages_allowed() == allowed)
+            return 0;
+        region->set_large_pages_allowed(allowed);
+        // Existing large pages are split up (or suitable memory is merged) right away.
+        region->remap();
+        return 0;
+    }
     return EINVAL;
 }
 
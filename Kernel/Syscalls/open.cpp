@@ -60,7 +60,7 @@ ErrorOr<FlatPtr> Process::sys$open(Userspace<const Syscall::SC_open_params*> use
         return ENXIO;
 
     u32 fd_flags = (options & O_CLOEXEC) ? FD_CLOEXEC : 0;
-    m_fds[fd_allocation.fd].set(move(description), fd_flags);
+    m_fds.set(fd_allocation.fd, move(description), fd_flags);
     return fd_allocation.fd;
 }
 
@@ -70,7 +70,7 @@ ErrorOr<FlatPtr> Process::sys$close(int fd)
     TRY(require_promise(Pledge::stdio));
     auto description = TRY(fds().open_file_description(fd));
     auto result = description->close();
-    m_fds[fd] = {};
+    m_fds.deallocate(fd);
     if (result.is_error())
         return result.release_error();
     return 0;
@@ -35,8 +35,8 @@ ErrorOr<FlatPtr> Process::sys$pipe(int pipefd[2], int flags)
         writer_description->set_blocking(false);
     }
 
-    m_fds[reader_fd_allocation.fd].set(move(reader_description), fd_flags);
-    m_fds[writer_fd_allocation.fd].set(move(writer_description), fd_flags);
+    m_fds.set(reader_fd_allocation.fd, move(reader_description), fd_flags);
+    m_fds.set(writer_fd_allocation.fd, move(writer_description), fd_flags);
 
     TRY(copy_to_user(&pipefd[0], &reader_fd_allocation.fd));
     TRY(copy_to_user(&pipefd[1], &writer_fd_allocation.fd));
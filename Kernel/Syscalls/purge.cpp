@@ -5,6 +5,7 @@
  */
 
 #include <AK/NonnullRefPtrVector.h>
+#include <Kernel/FileSystem/PageCache.h>
 #include <Kernel/Memory/AnonymousVMObject.h>
 #include <Kernel/Memory/InodeVMObject.h>
 #include <Kernel/Memory/MemoryManager.h>
@@ -64,6 +65,8 @@ ErrorOr<FlatPtr> Process::sys$purge(int mode)
         for (auto& vmobject : vmobjects) {
             purged_page_count += vmobject.release_all_clean_pages();
         }
+        // Do this last, so the pages the InodeVMObjects just let go of can be evicted as well.
+        purged_page_count += PageCache::the().purge();
     }
     return purged_page_count;
 }
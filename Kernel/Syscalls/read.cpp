@@ -37,10 +37,8 @@ static ErrorOr<void> check_blocked_read(OpenFileDescription* description)
     return {};
 }
 
-ErrorOr<FlatPtr> Process::sys$readv(int fd, Userspace<const struct iovec*> iov, int iov_count)
+ErrorOr<FlatPtr> Process::do_readv(int fd, Userspace<const struct iovec*> iov, int iov_count, Optional<off_t> offset)
 {
-    VERIFY_PROCESS_BIG_LOCK_ACQUIRED(this)
-    TRY(require_promise(Pledge::stdio));
     if (iov_count < 0)
         return EINVAL;
 
@@ -59,21 +57,49 @@ ErrorOr<FlatPtr> Process::sys$readv(int fd, Userspace<const struct iovec*> iov,
     }
 
     auto description = TRY(open_readable_file_description(fds(), fd));
+    if (offset.has_value() && !description->file().is_seekable())
+        return EINVAL;
 
     int nread = 0;
     for (auto& vec : vecs) {
         TRY(check_blocked_read(description));
         auto buffer = TRY(UserOrKernelBuffer::for_user_buffer((u8*)vec.iov_base, vec.iov_len));
-        auto nread_here = TRY(description->read(buffer, vec.iov_len));
+        if (!offset.has_value()) {
+            nread += TRY(description->read(buffer, vec.iov_len));
+            continue;
+        }
+        // Positional reads leave the description's offset alone, so there's nothing to
+        // serialize against and threads can read different parts of a file in parallel.
+        auto nread_here = TRY(description->read(buffer, *offset + nread, vec.iov_len));
         nread += nread_here;
+        if (nread_here < vec.iov_len)
+            break;
     }
 
     return nread;
 }
 
+ErrorOr<FlatPtr> Process::sys$readv(int fd, Userspace<const struct iovec*> iov, int iov_count)
+{
+    VERIFY_NO_PROCESS_BIG_LOCK(this)
+    TRY(require_promise(Pledge::stdio));
+    return do_readv(fd, iov, iov_count, {});
+}
+
+ErrorOr<FlatPtr> Process::sys$preadv(int fd, Userspace<const struct iovec*> iov, int iov_count, Userspace<off_t const*> userspace_offset)
+{
+    VERIFY_NO_PROCESS_BIG_LOCK(this)
+    TRY(require_promise(Pledge::stdio));
+    auto offset = TRY(copy_typed_from_user(userspace_offset));
+    if (offset < 0)
+        return EINVAL;
+    dbgln_if(IO_DEBUG, "sys$preadv({}, {}, {}, {})", fd, iov.ptr(), iov_count, offset);
+    return do_readv(fd, iov, iov_count, offset);
+}
+
 ErrorOr<FlatPtr> Process::sys$read(int fd, Userspace<u8*> buffer, size_t size)
 {
-    VERIFY_PROCESS_BIG_LOCK_ACQUIRED(this)
+    VERIFY_NO_PROCESS_BIG_LOCK(this)
     TRY(require_promise(Pledge::stdio));
     if (size == 0)
         return 0;
@@ -90,7 +116,7 @@ ErrorOr<FlatPtr> Process::sys$read(int fd, Userspace<u8*> buffer, size_t size)
 // hence it can't be passed by register on 32bit platforms.
 ErrorOr<FlatPtr> Process::sys$pread(int fd, Userspace<u8*> buffer, size_t size, Userspace<off_t const*> userspace_offset)
 {
-    VERIFY_PROCESS_BIG_LOCK_ACQUIRED(this)
+    VERIFY_NO_PROCESS_BIG_LOCK(this)
     TRY(require_promise(Pledge::stdio));
     if (size == 0)
         return 0;
@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <Kernel/Debug.h>
+#include <Kernel/FileSystem/OpenFileDescription.h>
+#include <Kernel/FileSystem/ReadinessSet.h>
+#include <Kernel/Process.h>
+
+namespace Kernel {
+
+ErrorOr<FlatPtr> Process::sys$create_readiness_set(u32 flags)
+{
+    VERIFY_PROCESS_BIG_LOCK_ACQUIRED(this)
+    TRY(require_promise(Pledge::stdio));
+
+    if (flags & ~READINESS_SET_CLOEXEC)
+        return EINVAL;
+
+    auto fd_allocation = TRY(m_fds.allocate());
+    auto readiness_set = TRY(ReadinessSet::try_create());
+    auto description = TRY(OpenFileDescription::try_create(move(readiness_set)));
+
+    description->set_readable(true);
+    u32 fd_flags = (flags & READINESS_SET_CLOEXEC) ? FD_CLOEXEC : 0;
+    m_fds.set(fd_allocation.fd, move(description), fd_flags);
+
+    return fd_allocation.fd;
+}
+
+ErrorOr<FlatPtr> Process::sys$readiness_set_control(Userspace<const Syscall::SC_readiness_set_control_params*> user_params)
+{
+    VERIFY_NO_PROCESS_BIG_LOCK(this)
+    TRY(require_promise(Pledge::stdio));
+    auto params = TRY(copy_typed_from_user(user_params));
+
+    auto set_description = TRY(fds().open_file_description(params.set_fd));
+    if (!set_description->is_readiness_set())
+        return EBADF;
+    auto* readiness_set = set_description->readiness_set();
+
+    switch (params.operation) {
+    case READINESS_SET_ADD: {
+        auto description = TRY(fds().open_file_description(params.fd));
+        TRY(readiness_set->add(params.fd, *description, params.events, params.user_data));
+        return 0;
+    }
+    case READINESS_SET_MODIFY:
+        TRY(readiness_set->modify(params.fd, params.events, params.user_data));
+        return 0;
+    case READINESS_SET_REMOVE:
+        TRY(readiness_set->remove(params.fd));
+        return 0;
+    default:
+        return EINVAL;
+    }
+}
+
+ErrorOr<FlatPtr> Process::sys$readiness_set_wait(Userspace<const Syscall::SC_readiness_set_wait_params*> user_params)
+{
+    VERIFY_NO_PROCESS_BIG_LOCK(this)
+    TRY(require_promise(Pledge::stdio));
+    auto params = TRY(copy_typed_from_user(user_params));
+
+    if (params.max_events == 0)
+        return EINVAL;
+    // Arbitrary pain threshold.
+    if (params.max_events > OpenFileDescriptions::max_open())
+        params.max_events = OpenFileDescriptions::max_open();
+
+    auto description = TRY(fds().open_file_description(params.set_fd));
+    if (!description->is_readiness_set())
+        return EBADF;
+    auto* readiness_set = description->readiness_set();
+
+    Thread::BlockTimeout timeout;
+    if (params.timeout) {
+        auto timeout_time = TRY(copy_time_from_user(params.timeout));
+        timeout = Thread::BlockTimeout(false, &timeout_time);
+    }
+
+    Vector<readiness_event, 32> events;
+    TRY(events.try_resize(params.max_events));
+
+    size_t count = 0;
+    for (;;) {
+        count = readiness_set->collect_ready_events(events.span());
+        if (count > 0)
+            break;
+
+        // NOTE: The timeout is absolute once constructed, so spurious wakeups don't extend it.
+        auto unblock_flags = Thread::FileBlocker::BlockFlags::None;
+        auto block_result = Thread::current()->block<Thread::ReadBlocker>(timeout, *description, unblock_flags);
+        if (block_result.was_interrupted())
+            return EINTR;
+        if (block_result == Thread::BlockResult::InterruptedByTimeout) {
+            count = readiness_set->collect_ready_events(events.span());
+            break;
+        }
+    }
+
+    dbgln_if(POLL_SELECT_DEBUG, "readiness_set_wait: {} ready", count);
+
+    if (count > 0)
+        TRY(copy_n_to_user(params.events, events.data(), count));
+    return count;
+}
+
+}
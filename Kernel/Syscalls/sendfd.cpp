@@ -49,7 +49,7 @@ ErrorOr<FlatPtr> Process::sys$recvfd(int sockfd, int options)
     if (options & O_CLOEXEC)
         fd_flags |= FD_CLOEXEC;
 
-    m_fds[fd_allocation.fd].set(move(received_description), fd_flags);
+    m_fds.set(fd_allocation.fd, move(received_description), fd_flags);
     return fd_allocation.fd;
 }
 
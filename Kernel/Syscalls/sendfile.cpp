@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/NumericLimits.h>
+#include <Kernel/Debug.h>
+#include <Kernel/FileSystem/OpenFileDescription.h>
+#include <Kernel/KBuffer.h>
+#include <Kernel/Process.h>
+
+namespace Kernel {
+
+// Large enough to amortize the per-chunk write setup, small enough to not pin much kernel memory.
+static constexpr size_t sendfile_chunk_size = 64 * KiB;
+
+ErrorOr<FlatPtr> Process::sys$sendfile(Userspace<const Syscall::SC_sendfile_params*> user_params)
+{
+    VERIFY_NO_PROCESS_BIG_LOCK(this)
+    TRY(require_promise(Pledge::stdio));
+    auto params = TRY(copy_typed_from_user(user_params));
+
+    if (params.count == 0)
+        return 0;
+    if (params.count > NumericLimits<ssize_t>::max())
+        return EINVAL;
+
+    auto in_description = TRY(fds().open_file_description(params.in_fd));
+    if (!in_description->is_readable())
+        return EBADF;
+    if (in_description->is_directory())
+        return EISDIR;
+    // NOTE: Only regular files can be the source, since reading from them never blocks
+    //       and never consumes data we might fail to write out.
+    if (!in_description->file().is_inode())
+        return EINVAL;
+
+    auto out_description = TRY(fds().open_file_description(params.out_fd));
+    if (!out_description->is_writable())
+        return EBADF;
+
+    off_t offset = 0;
+    if (params.offset) {
+        TRY(copy_from_user(&offset, params.offset));
+        if (offset < 0)
+            return EINVAL;
+    }
+
+    dbgln_if(IO_DEBUG, "sys$sendfile({}, {}, {}, {})", params.out_fd, params.in_fd, params.offset ? offset : -1, params.count);
+
+    // The data only ever passes through this kernel buffer on its way from the
+    // file (and the DiskCache below it) into the destination, instead of being
+    // bounced through a userspace buffer by a read() + write() pair.
+    auto buffer_size = min(params.count, sendfile_chunk_size);
+    auto buffer = TRY(KBuffer::try_create_with_size(buffer_size, Memory::Region::Access::ReadWrite, "sendfile"sv));
+    auto kernel_buffer = UserOrKernelBuffer::for_kernel_buffer(buffer->data());
+
+    size_t total_nsent = 0;
+    while (total_nsent < params.count) {
+        size_t nread = 0;
+        auto send_chunk = [&](size_t nread_here) -> ErrorOr<size_t> {
+            nread = nread_here;
+            if (nread == 0)
+                return 0;
+            return do_write(*out_description, kernel_buffer, nread);
+        };
+        auto chunk_size = min(params.count - total_nsent, buffer_size);
+
+        // Without an explicit offset, the chunk is read and sent under the description's offset lock,
+        // so concurrent readers of the same description never see the same data twice (or skip any).
+        ErrorOr<size_t> nwritten_or_error = 0;
+        if (params.offset) {
+            auto nread_or_error = in_description->read(kernel_buffer, offset, chunk_size);
+            if (nread_or_error.is_error())
+                nwritten_or_error = nread_or_error.release_error();
+            else
+                nwritten_or_error = send_chunk(nread_or_error.value());
+        } else {
+            nwritten_or_error = in_description->read_and_consume(kernel_buffer, chunk_size, [&](size_t nread_here) { return send_chunk(nread_here); });
+        }
+        if (nwritten_or_error.is_error()) {
+            if (total_nsent == 0)
+                return nwritten_or_error.release_error();
+            break;
+        }
+        auto nwritten = nwritten_or_error.value();
+        total_nsent += nwritten;
+        offset += nwritten;
+
+        // A short write means the destination is non-blocking and full, or we got interrupted.
+        if (nread == 0 || nwritten < nread)
+            break;
+    }
+
+    if (params.offset)
+        TRY(copy_to_user(params.offset, &offset));
+
+    return total_nsent;
+}
+
+}
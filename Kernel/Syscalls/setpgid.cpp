@@ -119,6 +119,7 @@ ErrorOr<FlatPtr> Process::sys$setpgid(pid_t specified_pid, pid_t specified_pgid)
     }
     // FIXME: There are more EPERM conditions to check for here..
     process->m_pg = TRY(ProcessGroup::try_find_or_create(new_pgid));
+    process->did_change_statistics();
     return 0;
 }
 
@@ -28,7 +28,7 @@ void Process::setup_socket_fd(int fd, NonnullRefPtr<OpenFileDescription> descrip
         flags |= FD_CLOEXEC;
     if (type & SOCK_NONBLOCK)
         description->set_blocking(false);
-    m_fds[fd].set(*description, flags);
+    m_fds.set(fd, *description, flags);
 }
 
 ErrorOr<FlatPtr> Process::sys$socket(int domain, int type, int protocol)
@@ -104,7 +104,7 @@ ErrorOr<FlatPtr> Process::sys$accept4(Userspace<const Syscall::SC_accept4_params
             return EAGAIN;
         }
     }
-    auto accepted_socket = socket.accept();
+    auto accepted_socket = socket.accept(*this);
     VERIFY(accepted_socket);
 
     if (user_address) {
@@ -124,7 +124,7 @@ ErrorOr<FlatPtr> Process::sys$accept4(Userspace<const Syscall::SC_accept4_params
     int fd_flags = 0;
     if (flags & SOCK_CLOEXEC)
         fd_flags |= FD_CLOEXEC;
-    m_fds[fd_allocation.fd].set(move(accepted_socket_description), fd_flags);
+    m_fds.set(fd_allocation.fd, move(accepted_socket_description), fd_flags);
 
     // NOTE: Moving this state to Completed is what causes connect() to unblock on the client side.
     accepted_socket->set_setup_state(Socket::SetupState::Completed);
@@ -160,7 +160,7 @@ ErrorOr<FlatPtr> Process::sys$shutdown(int sockfd, int how)
 
 ErrorOr<FlatPtr> Process::sys$sendmsg(int sockfd, Userspace<const struct msghdr*> user_msg, int flags)
 {
-    VERIFY_PROCESS_BIG_LOCK_ACQUIRED(this)
+    VERIFY_NO_PROCESS_BIG_LOCK(this)
     TRY(require_promise(Pledge::stdio));
     auto msg = TRY(copy_typed_from_user(user_msg));
 
@@ -188,7 +188,7 @@ ErrorOr<FlatPtr> Process::sys$sendmsg(int sockfd, Userspace<const struct msghdr*
 
 ErrorOr<FlatPtr> Process::sys$recvmsg(int sockfd, Userspace<struct msghdr*> user_msg, int flags)
 {
-    VERIFY_PROCESS_BIG_LOCK_ACQUIRED(this)
+    VERIFY_NO_PROCESS_BIG_LOCK(this)
     TRY(require_promise(Pledge::stdio));
 
     struct msghdr msg;
@@ -354,8 +354,8 @@ ErrorOr<FlatPtr> Process::sys$socketpair(Userspace<const Syscall::SC_socketpair_
 
     if (copy_to_user(params.sv, fds, sizeof(fds)).is_error()) {
         // Avoid leaking both file descriptors on error.
-        m_fds[fds[0]] = {};
-        m_fds[fds[1]] = {};
+        m_fds.deallocate(fds[0]);
+        m_fds.deallocate(fds[1]);
         return EFAULT;
     }
     return 0;
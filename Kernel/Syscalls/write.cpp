@@ -11,10 +11,8 @@
 
 namespace Kernel {
 
-ErrorOr<FlatPtr> Process::sys$writev(int fd, Userspace<const struct iovec*> iov, int iov_count)
+ErrorOr<FlatPtr> Process::do_writev(int fd, Userspace<const struct iovec*> iov, int iov_count, Optional<off_t> offset)
 {
-    VERIFY_PROCESS_BIG_LOCK_ACQUIRED(this)
-    TRY(require_promise(Pledge::stdio));
     if (iov_count < 0)
         return EINVAL;
 
@@ -35,11 +33,16 @@ ErrorOr<FlatPtr> Process::sys$writev(int fd, Userspace<const struct iovec*> iov,
     auto description = TRY(fds().open_file_description(fd));
     if (!description->is_writable())
         return EBADF;
+    if (offset.has_value() && !description->file().is_seekable())
+        return EINVAL;
 
     int nwritten = 0;
     for (auto& vec : vecs) {
         auto buffer = TRY(UserOrKernelBuffer::for_user_buffer((u8*)vec.iov_base, vec.iov_len));
-        auto result = do_write(*description, buffer, vec.iov_len);
+        Optional<off_t> offset_here;
+        if (offset.has_value())
+            offset_here = *offset + nwritten;
+        auto result = do_write(*description, buffer, vec.iov_len, offset_here);
         if (result.is_error()) {
             if (nwritten == 0)
                 return result.release_error();
@@ -51,11 +54,31 @@ ErrorOr<FlatPtr> Process::sys$writev(int fd, Userspace<const struct iovec*> iov,
     return nwritten;
 }
 
-ErrorOr<FlatPtr> Process::do_write(OpenFileDescription& description, const UserOrKernelBuffer& data, size_t data_size)
+ErrorOr<FlatPtr> Process::sys$writev(int fd, Userspace<const struct iovec*> iov, int iov_count)
+{
+    VERIFY_NO_PROCESS_BIG_LOCK(this)
+    TRY(require_promise(Pledge::stdio));
+    return do_writev(fd, iov, iov_count, {});
+}
+
+// NOTE: Like in sys$pread, the offset is passed by pointer so that it fits in a register on 32bit platforms.
+ErrorOr<FlatPtr> Process::sys$pwritev(int fd, Userspace<const struct iovec*> iov, int iov_count, Userspace<off_t const*> userspace_offset)
+{
+    VERIFY_NO_PROCESS_BIG_LOCK(this)
+    TRY(require_promise(Pledge::stdio));
+    auto offset = TRY(copy_typed_from_user(userspace_offset));
+    if (offset < 0)
+        return EINVAL;
+    dbgln_if(IO_DEBUG, "sys$pwritev({}, {}, {}, {})", fd, iov.ptr(), iov_count, offset);
+    return do_writev(fd, iov, iov_count, offset);
+}
+
+ErrorOr<FlatPtr> Process::do_write(OpenFileDescription& description, const UserOrKernelBuffer& data, size_t data_size, Optional<off_t> offset)
 {
     size_t total_nwritten = 0;
 
-    if (description.should_append() && description.file().is_seekable()) {
+    // Positional writes go exactly where they were asked to, even on descriptions opened with O_APPEND.
+    if (!offset.has_value() && description.should_append() && description.file().is_seekable()) {
         TRY(description.seek(0, SEEK_END));
     }
 
@@ -73,7 +96,9 @@ ErrorOr<FlatPtr> Process::do_write(OpenFileDescription& description, const UserO
             }
             // TODO: handle exceptions in unblock_flags
         }
-        auto nwritten_or_error = description.write(data.offset(total_nwritten), data_size - total_nwritten);
+        auto nwritten_or_error = offset.has_value()
+            ? description.write(*offset + total_nwritten, data.offset(total_nwritten), data_size - total_nwritten)
+            : description.write(data.offset(total_nwritten), data_size - total_nwritten);
         if (nwritten_or_error.is_error()) {
             if (total_nwritten > 0)
                 return total_nwritten;
@@ -89,7 +114,7 @@ ErrorOr<FlatPtr> Process::do_write(OpenFileDescription& description, const UserO
 
 ErrorOr<FlatPtr> Process::sys$write(int fd, Userspace<const u8*> data, size_t size)
 {
-    VERIFY_PROCESS_BIG_LOCK_ACQUIRED(this)
+    VERIFY_NO_PROCESS_BIG_LOCK(this)
     TRY(require_promise(Pledge::stdio));
     if (size == 0)
         return 0;
@@ -105,4 +130,29 @@ ErrorOr<FlatPtr> Process::sys$write(int fd, Userspace<const u8*> data, size_t si
     return do_write(*description, buffer, size);
 }
 
+// NOTE: The offset is passed by pointer because off_t is 64bit,
+// hence it can't be passed by register on 32bit platforms.
+ErrorOr<FlatPtr> Process::sys$pwrite(int fd, Userspace<const u8*> data, size_t size, Userspace<off_t const*> userspace_offset)
+{
+    VERIFY_NO_PROCESS_BIG_LOCK(this)
+    TRY(require_promise(Pledge::stdio));
+    if (size == 0)
+        return 0;
+    if (size > NumericLimits<ssize_t>::max())
+        return EINVAL;
+    auto offset = TRY(copy_typed_from_user(userspace_offset));
+    if (offset < 0)
+        return EINVAL;
+
+    dbgln_if(IO_DEBUG, "sys$pwrite({}, {}, {}, {})", fd, data.ptr(), size, offset);
+    auto description = TRY(fds().open_file_description(fd));
+    if (!description->is_writable())
+        return EBADF;
+    if (!description->file().is_seekable())
+        return EINVAL;
+
+    auto buffer = TRY(UserOrKernelBuffer::for_user_buffer(data, static_cast<size_t>(size)));
+    return do_write(*description, buffer, size, offset);
+}
+
 }
@@ -506,6 +506,11 @@ ErrorOr<void> TTY::ioctl(OpenFileDescription&, unsigned request, Userspace<void*
         if (process && pgid != process->pgid())
             return EPERM;
         m_pg = process_group;
+        // The foreground process group is reported for every process on this TTY.
+        Process::for_each([&](auto& process_on_tty) {
+            if (process_on_tty.tty() == this)
+                process_on_tty.did_change_statistics();
+        });
 
         if (process) {
             if (auto parent = Process::from_pid(process->ppid())) {
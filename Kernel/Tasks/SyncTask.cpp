@@ -4,24 +4,51 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/Singleton.h>
+#include <Kernel/FileSystem/FileSystem.h>
+#include <Kernel/FileSystem/PageCache.h>
 #include <Kernel/FileSystem/VirtualFileSystem.h>
 #include <Kernel/Process.h>
 #include <Kernel/Sections.h>
 #include <Kernel/Tasks/SyncTask.h>
 #include <Kernel/Time/TimeManagement.h>
+#include <Kernel/WaitQueue.h>
 
 namespace Kernel {
 
+static Singleton<WaitQueue> s_writeback_wait_queue;
+
+// File systems are asked to write back old (or too much) dirty data this often,
+// while everything (including inode metadata) is synced less frequently.
+static constexpr Time writeback_interval = Time::from_milliseconds(250);
+static constexpr u64 sync_interval_ms = 5000;
+
 UNMAP_AFTER_INIT void SyncTask::spawn()
 {
     RefPtr<Thread> syncd_thread;
     (void)Process::create_kernel_process(syncd_thread, KString::must_create("SyncTask"), [] {
         dbgln("SyncTask is running");
+        auto last_sync_ms = TimeManagement::the().uptime_ms();
         for (;;) {
-            VirtualFileSystem::sync();
-            (void)Thread::current()->sleep(Time::from_seconds(1));
+            Thread::BlockTimeout timeout(false, &writeback_interval);
+            (void)s_writeback_wait_queue->wait_on(timeout, "SyncTask");
+
+            auto now_ms = TimeManagement::the().uptime_ms();
+            if (now_ms - last_sync_ms >= sync_interval_ms) {
+                VirtualFileSystem::sync();
+                last_sync_ms = now_ms;
+            } else {
+                FileSystem::write_back_all();
+            }
+
+            PageCache::the().evict_pages_if_under_memory_pressure();
         }
     });
 }
 
+void SyncTask::request_writeback()
+{
+    s_writeback_wait_queue->wake_all();
+}
+
 }
@@ -10,5 +10,8 @@ namespace Kernel {
 class SyncTask {
 public:
     static void spawn();
+
+    // Asks for dirty data to be written back right away, instead of at the next interval.
+    static void request_writeback();
 };
 }
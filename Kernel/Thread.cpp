@@ -1083,6 +1083,18 @@ ErrorOr<NonnullRefPtr<Thread>> Thread::try_clone(Process& process)
     return clone;
 }
 
+static Atomic<u64> s_statistics_generation { 1 };
+
+u64 Thread::current_statistics_generation()
+{
+    return s_statistics_generation.load(AK::MemoryOrder::memory_order_relaxed);
+}
+
+u64 Thread::advance_statistics_generation()
+{
+    return s_statistics_generation.fetch_add(1, AK::MemoryOrder::memory_order_relaxed) + 1;
+}
+
 void Thread::set_state(State new_state, u8 stop_signal)
 {
     State previous_state;
@@ -1090,6 +1102,8 @@ void Thread::set_state(State new_state, u8 stop_signal)
     if (new_state == m_state)
         return;
 
+    m_statistics_generation.store(current_statistics_generation(), AK::MemoryOrder::memory_order_relaxed);
+
     {
         SpinlockLocker thread_lock(m_lock);
         previous_state = m_state;
@@ -553,7 +553,7 @@ public:
 
     class FutexBlocker final : public Blocker {
     public:
-        explicit FutexBlocker(FutexQueue&, u32);
+        FutexBlocker(RefPtr<FutexQueue>&, u32);
         virtual ~FutexBlocker();
 
         virtual Type blocker_type() const override { return Type::Futex; }
@@ -574,7 +574,8 @@ public:
         bool unblock(bool force = false);
 
     protected:
-        FutexQueue& m_futex_queue;
+        // Points at the queue we're currently on, and is kept up to date when we get requeued.
+        RefPtr<FutexQueue>& m_futex_queue;
         u32 m_bitset { 0 };
         u32 m_relock_flags { 0 };
         bool m_did_unblock { false };
@@ -1065,6 +1066,13 @@ public:
 
     ErrorOr<void> make_thread_specific_region(Badge<Process>);
 
+    // Every snapshot of /proc/process_statistics advances the global statistics generation, and threads
+    // remember the generation of their last state change. Since a thread's counters only move while it's
+    // running, a thread that isn't running now and hasn't changed state since a snapshot has not changed either.
+    static u64 current_statistics_generation();
+    static u64 advance_statistics_generation();
+    u64 statistics_generation() const { return m_statistics_generation.load(AK::MemoryOrder::memory_order_relaxed); }
+
     unsigned syscall_count() const { return m_syscall_count; }
     void did_syscall() { ++m_syscall_count; }
     unsigned inode_faults() const { return m_inode_faults; }
@@ -1246,6 +1254,10 @@ public:
     bool is_allocation_enabled() const { return m_allocation_enabled; }
     void set_allocation_enabled(bool value) { m_allocation_enabled = value; }
 
+    // While set, every description acts as if it was opened with O_NONBLOCK for this thread.
+    bool is_file_io_nonblocking() const { return m_file_io_nonblocking; }
+    void set_file_io_nonblocking(bool value) { m_file_io_nonblocking = value; }
+
     ErrorOr<NonnullOwnPtr<KString>> backtrace();
 
 private:
@@ -1332,6 +1344,7 @@ private:
     u64 m_total_time_scheduled_kernel { 0 };
     u32 m_ticks_left { 0 };
     u32 m_times_scheduled { 0 };
+    Atomic<u64> m_statistics_generation { 0 };
     u32 m_ticks_in_user { 0 };
     u32 m_ticks_in_kernel { 0 };
     u32 m_pending_signals { 0 };
@@ -1351,6 +1364,7 @@ private:
     IntrusiveListNode<Thread> m_blocked_threads_list_node;
     LockRank m_lock_rank_mask { LockRank::None };
     bool m_allocation_enabled { true };
+    bool m_file_io_nonblocking { false };
 
 #if LOCK_DEBUG
     struct HoldingLockInfo {
@@ -7,6 +7,7 @@
 #include <AK/BuiltinWrappers.h>
 #include <Kernel/Debug.h>
 #include <Kernel/FileSystem/OpenFileDescription.h>
+#include <Kernel/FutexQueue.h>
 #include <Kernel/Net/Socket.h>
 #include <Kernel/Process.h>
 #include <Kernel/Scheduler.h>
@@ -146,7 +147,7 @@ bool Thread::WaitQueueBlocker::unblock()
     return true;
 }
 
-Thread::FutexBlocker::FutexBlocker(FutexQueue& futex_queue, u32 bitset)
+Thread::FutexBlocker::FutexBlocker(RefPtr<FutexQueue>& futex_queue, u32 bitset)
     : m_futex_queue(futex_queue)
     , m_bitset(bitset)
 {
@@ -154,7 +155,7 @@ Thread::FutexBlocker::FutexBlocker(FutexQueue& futex_queue, u32 bitset)
 
 bool Thread::FutexBlocker::setup_blocker()
 {
-    return add_to_blocker_set(m_futex_queue);
+    return add_to_blocker_set(*m_futex_queue);
 }
 
 Thread::FutexBlocker::~FutexBlocker()
@@ -165,6 +166,7 @@ void Thread::FutexBlocker::finish_requeue(FutexQueue& futex_queue)
 {
     VERIFY(m_lock.is_locked_by_current_processor());
     set_blocker_set_raw_locked(&futex_queue);
+    m_futex_queue = &futex_queue;
     // We can now release the lock
     m_lock.unlock(m_relock_flags);
 }
@@ -53,6 +53,16 @@ TimerQueue& TimerQueue::the()
 UNMAP_AFTER_INIT TimerQueue::TimerQueue()
 {
     m_ticks_per_second = TimeManagement::the().ticks_per_second();
+    m_timer_queue_monotonic.next_unit = unit_for(TimeManagement::the().current_time(CLOCK_MONOTONIC_COARSE));
+    m_timer_queue_realtime.next_unit = unit_for(TimeManagement::the().current_time(CLOCK_REALTIME_COARSE));
+}
+
+u64 TimerQueue::unit_for(Time const& time)
+{
+    auto nanoseconds = time.to_nanoseconds();
+    if (nanoseconds < 0)
+        return 0;
+    return static_cast<u64>(nanoseconds) >> unit_shift;
 }
 
 bool TimerQueue::add_timer_without_id(NonnullRefPtr<Timer> timer, clockid_t clock_id, const Time& deadline, Function<void()>&& callback)
@@ -86,33 +96,56 @@ TimerId TimerQueue::add_timer(NonnullRefPtr<Timer>&& timer)
 
 void TimerQueue::add_timer_locked(NonnullRefPtr<Timer> timer)
 {
-    Time timer_expiration = timer->m_expires;
-
     timer->clear_cancelled();
     timer->clear_callback_finished();
     timer->set_in_use();
 
-    auto& queue = queue_for_timer(*timer);
-    if (queue.list.is_empty()) {
-        queue.list.append(timer.leak_ref());
-        queue.next_timer_due = timer_expiration;
-    } else {
-        Timer* following_timer = nullptr;
-        for (auto& t : queue.list) {
-            if (t.m_expires > timer_expiration) {
-                following_timer = &t;
-                break;
-            }
+    place_timer_locked(queue_for_timer(*timer), timer.leak_ref());
+}
+
+void TimerQueue::place_timer_locked(Queue& queue, Timer& timer)
+{
+    VERIFY(g_timerqueue_lock.is_locked());
+
+    // The timer fires once the clock is past the start of this unit, which is after its expiration.
+    // Anything that should have fired already goes into the slot that's processed next.
+    u64 unit = max(unit_for(timer.m_expires) + 1, queue.next_unit);
+    u64 distance = unit - queue.next_unit;
+    for (size_t level = 0; level < level_count; ++level) {
+        if (distance < (1ull << ((level + 1) * slot_bits))) {
+            queue.wheel[level][slot_index(unit, level)].append(timer);
+            return;
         }
-        if (following_timer) {
-            bool next_timer_needs_update = queue.list.first() == following_timer;
-            queue.list.insert_before(*following_timer, timer.leak_ref());
-            if (next_timer_needs_update)
-                queue.next_timer_due = timer_expiration;
-        } else {
-            queue.list.append(timer.leak_ref());
+    }
+    queue.overflow.append(timer);
+}
+
+void TimerQueue::cascade_locked(Queue& queue, Timer::List& list)
+{
+    // NOTE: The timers only ever move closer to level 0, so they never end up in the list we're taking them from.
+    while (auto* timer = list.first()) {
+        list.remove(*timer);
+        place_timer_locked(queue, *timer);
+    }
+}
+
+void TimerQueue::rebuild_locked(Queue& queue, u64 next_unit)
+{
+    Timer::List timers;
+    auto take_all = [&](Timer::List& list) {
+        while (auto* timer = list.first()) {
+            list.remove(*timer);
+            timers.append(*timer);
         }
+    };
+    for (auto& level : queue.wheel) {
+        for (auto& slot : level)
+            take_all(slot);
     }
+    take_all(queue.overflow);
+
+    queue.next_unit = next_unit;
+    cascade_locked(queue, timers);
 }
 
 bool TimerQueue::cancel_timer(Timer& timer, bool* was_in_use)
@@ -128,15 +161,15 @@ bool TimerQueue::cancel_timer(Timer& timer, bool* was_in_use)
     }
 
     bool did_already_run = timer.set_cancelled();
-    auto& timer_queue = queue_for_timer(timer);
     if (!did_already_run) {
         timer.clear_in_use();
 
         SpinlockLocker lock(g_timerqueue_lock);
-        if (timer_queue.list.contains(timer)) {
-            // The timer has not fired, remove it
+        if (!m_timers_executing.contains(timer)) {
+            // The timer has not fired, remove it from the wheel
+            VERIFY(timer.is_queued());
             VERIFY(timer.ref_count() > 1);
-            remove_timer_locked(timer_queue, timer);
+            remove_timer_locked(timer);
             return true;
         }
 
@@ -145,7 +178,6 @@ bool TimerQueue::cancel_timer(Timer& timer, bool* was_in_use)
         // and we don't need to spin. It still holds a reference
         // that will be dropped when it does get a chance to run,
         // but since we called set_cancelled it will only drop its reference
-        VERIFY(m_timers_executing.contains(timer));
         m_timers_executing.remove(timer);
         return true;
     }
@@ -158,38 +190,46 @@ bool TimerQueue::cancel_timer(Timer& timer, bool* was_in_use)
     return false;
 }
 
-void TimerQueue::remove_timer_locked(Queue& queue, Timer& timer)
+void TimerQueue::remove_timer_locked(Timer& timer)
 {
-    bool was_next_timer = (queue.list.first() == &timer);
-    queue.list.remove(timer);
+    // NOTE: We don't need to know which slot of the wheel the timer is in to take it out of it.
+    timer.m_list_node.remove();
     auto now = timer.now(false);
     if (timer.m_expires > now)
         timer.m_remaining = timer.m_expires - now;
 
-    if (was_next_timer)
-        update_next_timer_due(queue);
     // Whenever we remove a timer that was still queued (but hasn't been
     // fired) we added a reference to it. So, when removing it from the
     // queue we need to drop that reference.
     timer.unref();
 }
 
-void TimerQueue::fire()
+void TimerQueue::fire_timers(Queue& queue, clockid_t clock_id)
 {
     SpinlockLocker lock(g_timerqueue_lock);
 
-    auto fire_timers = [&](Queue& queue) {
-        auto* timer = queue.list.first();
-        VERIFY(timer);
-        VERIFY(queue.next_timer_due == timer->m_expires);
+    // NOTE: We just updated the time in the interrupt handler, so coarse timestamps are precise enough.
+    u64 current_unit = unit_for(TimeManagement::the().current_time(clock_id));
+    // The wall clock can be set to anything, and we may not have been called in a while.
+    bool clock_went_backwards = current_unit + 1 < queue.next_unit;
+    bool clock_jumped_ahead = current_unit >= queue.next_unit && current_unit - queue.next_unit > max_units_to_advance;
+    if (clock_went_backwards || clock_jumped_ahead)
+        rebuild_locked(queue, current_unit);
+
+    while (queue.next_unit <= current_unit) {
+        u64 unit = queue.next_unit;
+        for (size_t level = 1; level < level_count && slot_index(unit, level - 1) == 0; ++level) {
+            cascade_locked(queue, queue.wheel[level][slot_index(unit, level)]);
+            if (level == level_count - 1 && slot_index(unit, level) == 0)
+                cascade_locked(queue, queue.overflow);
+        }
 
-        while (timer && timer->now(true) > timer->m_expires) {
-            queue.list.remove(*timer);
+        auto& slot = queue.wheel[0][slot_index(unit, 0)];
+        while (auto* timer = slot.first()) {
+            slot.remove(*timer);
 
             m_timers_executing.append(*timer);
 
-            update_next_timer_due(queue);
-
             lock.unlock();
 
             // Defer executing the timer outside of the irq handler
@@ -209,24 +249,18 @@ void TimerQueue::fire()
             });
 
             lock.lock();
-            timer = queue.list.first();
         }
-    };
 
-    if (!m_timer_queue_monotonic.list.is_empty())
-        fire_timers(m_timer_queue_monotonic);
-    if (!m_timer_queue_realtime.list.is_empty())
-        fire_timers(m_timer_queue_realtime);
+        // NOTE: Someone else may have processed this unit while we didn't hold the lock.
+        if (queue.next_unit == unit)
+            queue.next_unit = unit + 1;
+    }
 }
 
-void TimerQueue::update_next_timer_due(Queue& queue)
+void TimerQueue::fire()
 {
-    VERIFY(g_timerqueue_lock.is_locked());
-
-    if (auto* next_timer = queue.list.first())
-        queue.next_timer_due = next_timer->m_expires;
-    else
-        queue.next_timer_due = {};
+    fire_timers(m_timer_queue_monotonic, CLOCK_MONOTONIC_COARSE);
+    fire_timers(m_timer_queue_realtime, CLOCK_REALTIME_COARSE);
 }
 
 }
@@ -6,6 +6,7 @@
 
 #pragma once
 
+#include <AK/Array.h>
 #include <AK/Function.h>
 #include <AK/IntrusiveList.h>
 #include <AK/NonnullRefPtr.h>
@@ -93,13 +94,35 @@ public:
     void fire();
 
 private:
+    // Every clock has a hierarchical timing wheel (Varghese & Lauck), so adding and cancelling a timer
+    // take constant time, no matter how many timers are pending.
+    // Time is counted in units of 2^unit_shift nanoseconds. A timer expiring within 2^(6 * (L + 1)) units
+    // lives on level L, in the slot picked by the corresponding 6 bits of its expiration. Whenever the
+    // slot index of a level wraps around, the next slot of the level above is cascaded down.
+    static constexpr size_t unit_shift = 18;
+    static constexpr size_t slot_bits = 6;
+    static constexpr size_t slot_count = 1 << slot_bits;
+    static constexpr size_t level_count = 6;
+    // If the clock jumped further than this since we last looked, the wheel is rebuilt from scratch.
+    static constexpr u64 max_units_to_advance = 4 * slot_count * slot_count;
+
     struct Queue {
-        Timer::List list;
-        Time next_timer_due {};
+        Array<Array<Timer::List, slot_count>, level_count> wheel;
+        // Timers too far into the future for the wheel, looked at whenever the top level wraps around.
+        Timer::List overflow;
+        // All units before this one have been processed.
+        u64 next_unit { 0 };
     };
-    void remove_timer_locked(Queue&, Timer&);
-    void update_next_timer_due(Queue&);
+
+    static u64 unit_for(Time const&);
+    static u64 slot_index(u64 unit, size_t level) { return (unit >> (level * slot_bits)) & (slot_count - 1); }
+
+    void remove_timer_locked(Timer&);
     void add_timer_locked(NonnullRefPtr<Timer>);
+    void place_timer_locked(Queue&, Timer&);
+    void cascade_locked(Queue&, Timer::List&);
+    void rebuild_locked(Queue&, u64 next_unit);
+    void fire_timers(Queue&, clockid_t);
 
     Queue& queue_for_timer(Timer& timer)
     {
@@ -51,6 +51,7 @@
 #include <Kernel/Random.h>
 #include <Kernel/Scheduler.h>
 #include <Kernel/Sections.h>
+#include <Kernel/SysFSKernel.h>
 #include <Kernel/Storage/StorageManagement.h>
 #include <Kernel/TTY/ConsoleManagement.h>
 #include <Kernel/TTY/PTYMultiplexer.h>
@@ -311,6 +312,7 @@ void init_stage2(void*)
 
     USB::USBManagement::initialize();
     FirmwareSysFSDirectory::initialize();
+    KernelSysFSDirectory::initialize();
 
     VirtIO::detect();
 
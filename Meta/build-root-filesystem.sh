@@ -122,12 +122,13 @@ chmod 755 mnt/res/devel/templates/*.postcreate
 echo "done"
 
 printf "creating initial filesystem structure... "
-for dir in bin etc proc mnt tmp boot mod var/run; do
+for dir in bin etc proc mnt tmp boot mod var/run var/tmp; do
     mkdir -p mnt/$dir
 done
 chmod 700 mnt/boot
 chmod 700 mnt/mod
 chmod 1777 mnt/tmp
+chmod 1777 mnt/var/tmp
 echo "done"
 
 printf "creating utmp file... "
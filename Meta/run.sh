@@ -206,6 +206,13 @@ else
     fi
 fi
 
+# Attaches the disk as a virtio-blk device instead, which shows up as /dev/vda
+if [ "$SERENITY_VIRTIO_BLK_ENABLE" = "1" ]; then
+    SERENITY_BOOT_DRIVE="-drive file=${SERENITY_DISK_IMAGE},format=raw,index=0,media=disk,if=none,id=disk,cache=writeback,discard=unmap"
+    SERENITY_BOOT_DRIVE="$SERENITY_BOOT_DRIVE -device virtio-blk-pci,drive=disk,num-queues=4"
+    SERENITY_KERNEL_CMDLINE="$SERENITY_KERNEL_CMDLINE root=/dev/vda"
+fi
+
 if [ -z "$SERENITY_DISABLE_GDB_SOCKET" ]; then
   SERENITY_EXTRA_QEMU_ARGS="$SERENITY_EXTRA_QEMU_ARGS -s"
 fi
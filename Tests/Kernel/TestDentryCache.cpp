@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/JsonObject.h>
+#include <AK/JsonValue.h>
+#include <AK/String.h>
+#include <LibTest/TestCase.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static bool exists(String const& path)
+{
+    struct stat st;
+    return stat(path.characters(), &st) == 0;
+}
+
+static void create_file(String const& path)
+{
+    int fd = open(path.characters(), O_CREAT | O_EXCL | O_WRONLY, 0644);
+    VERIFY(fd >= 0);
+    close(fd);
+}
+
+static u64 cache_statistic(StringView name)
+{
+    int fd = open("/sys/kernel/dentry_cache", O_RDONLY);
+    VERIFY(fd >= 0);
+    char buffer[512];
+    auto nread = read(fd, buffer, sizeof(buffer));
+    VERIFY(nread > 0);
+    close(fd);
+    auto json = JsonValue::from_string(StringView { buffer, static_cast<size_t>(nread) }).release_value_but_fixme_should_propagate_errors();
+    return json.as_object().get(name).to_u64();
+}
+
+TEST_CASE(negative_entries_are_invalidated)
+{
+    char directory[] = "/tmp/TestDentryCache.XXXXXX";
+    VERIFY(mkdtemp(directory));
+    auto path = String::formatted("{}/file", directory);
+
+    // Looking up a missing name twice makes sure it's cached as missing.
+    EXPECT(!exists(path));
+    EXPECT(!exists(path));
+    create_file(path);
+    EXPECT(exists(path));
+
+    EXPECT_EQ(unlink(path.characters()), 0);
+    EXPECT(!exists(path));
+    EXPECT_EQ(errno, ENOENT);
+
+    EXPECT_EQ(rmdir(directory), 0);
+}
+
+TEST_CASE(rename_is_visible_under_both_names)
+{
+    char directory[] = "/tmp/TestDentryCache.XXXXXX";
+    VERIFY(mkdtemp(directory));
+    auto old_path = String::formatted("{}/old", directory);
+    auto new_path = String::formatted("{}/new", directory);
+
+    create_file(old_path);
+    EXPECT(exists(old_path));
+    EXPECT(!exists(new_path));
+    EXPECT_EQ(rename(old_path.characters(), new_path.characters()), 0);
+    EXPECT(!exists(old_path));
+    EXPECT(exists(new_path));
+
+    EXPECT_EQ(unlink(new_path.characters()), 0);
+    EXPECT_EQ(rmdir(directory), 0);
+}
+
+TEST_CASE(replaced_directory_is_not_resolved_through)
+{
+    char directory[] = "/tmp/TestDentryCache.XXXXXX";
+    VERIFY(mkdtemp(directory));
+    auto subdirectory = String::formatted("{}/sub", directory);
+    auto file = String::formatted("{}/sub/file", directory);
+
+    EXPECT_EQ(mkdir(subdirectory.characters(), 0755), 0);
+    create_file(file);
+    EXPECT(exists(file));
+
+    EXPECT_EQ(unlink(file.characters()), 0);
+    EXPECT_EQ(rmdir(subdirectory.characters()), 0);
+    EXPECT_EQ(mkdir(subdirectory.characters(), 0755), 0);
+    EXPECT(!exists(file));
+
+    EXPECT_EQ(rmdir(subdirectory.characters()), 0);
+    EXPECT_EQ(rmdir(directory), 0);
+}
+
+TEST_CASE(repeated_lookups_hit_the_cache)
+{
+    auto hits_before = cache_statistic("hits"sv);
+    for (size_t i = 0; i < 10; ++i)
+        EXPECT(exists("/usr/lib/libc.so"));
+    EXPECT(cache_statistic("hits"sv) >= hits_before + 10);
+}
+
+// Creates a directory 9 levels deep, runs the callback with its path, and removes it again.
+template<typename Callback>
+static void with_deep_directory(Callback callback)
+{
+    char directory[] = "/tmp/TestDentryCache.XXXXXX";
+    VERIFY(mkdtemp(directory));
+    StringBuilder builder;
+    builder.append(directory);
+    for (size_t depth = 0; depth < 8; ++depth) {
+        builder.append("/directory"sv);
+        EXPECT_EQ(mkdir(builder.to_string().characters(), 0755), 0);
+    }
+
+    callback(builder.to_string());
+
+    for (size_t depth = 0; depth < 8; ++depth) {
+        EXPECT_EQ(rmdir(builder.to_string().characters()), 0);
+        builder.trim("/directory"sv.length());
+    }
+    EXPECT_EQ(rmdir(directory), 0);
+}
+
+static constexpr size_t stat_iterations = 1'000'000;
+
+BENCHMARK_CASE(stat_existing_deep_path)
+{
+    with_deep_directory([](String const& deep_path) {
+        for (size_t i = 0; i < stat_iterations; ++i)
+            VERIFY(exists(deep_path));
+    });
+}
+
+BENCHMARK_CASE(stat_missing_deep_path)
+{
+    with_deep_directory([](String const& deep_path) {
+        auto missing_path = String::formatted("{}/missing", deep_path);
+        for (size_t i = 0; i < stat_iterations; ++i)
+            VERIFY(!exists(missing_path));
+    });
+}
@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/String.h>
+#include <LibTest/TestCase.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// /tmp is a TmpFS, so these go into /var/tmp, which lives on the (Ext2) root file system.
+static String make_test_directory()
+{
+    char path[] = "/var/tmp/TestExt2Directory.XXXXXX";
+    VERIFY(mkdtemp(path));
+    return path;
+}
+
+static String entry_path(String const& directory, size_t index)
+{
+    return String::formatted("{}/file-with-a-somewhat-longer-name-{}", directory, index);
+}
+
+static void create_file(String const& path)
+{
+    int fd = open(path.characters(), O_CREAT | O_EXCL | O_WRONLY, 0644);
+    VERIFY(fd >= 0);
+    close(fd);
+}
+
+static size_t count_directory_entries(String const& directory)
+{
+    auto* dir = opendir(directory.characters());
+    VERIFY(dir);
+    size_t count = 0;
+    while (readdir(dir))
+        ++count;
+    closedir(dir);
+    return count;
+}
+
+// Enough entries to fill up many blocks, so the directory needs an index with several leaves.
+TEST_CASE(many_entries_stay_reachable)
+{
+    constexpr size_t count = 5000;
+    auto directory = make_test_directory();
+
+    for (size_t i = 0; i < count; ++i)
+        create_file(entry_path(directory, i));
+    EXPECT_EQ(count_directory_entries(directory), count + 2);
+
+    int fd = open(entry_path(directory, 0).characters(), O_CREAT | O_EXCL | O_WRONLY, 0644);
+    EXPECT_EQ(fd, -1);
+    EXPECT_EQ(errno, EEXIST);
+
+    for (size_t i = 0; i < count; i += 2)
+        EXPECT_EQ(unlink(entry_path(directory, i).characters()), 0);
+
+    struct stat st;
+    for (size_t i = 0; i < count; ++i) {
+        bool exists = stat(entry_path(directory, i).characters(), &st) == 0;
+        EXPECT_EQ(exists, i % 2 == 1);
+    }
+    EXPECT_EQ(count_directory_entries(directory), count / 2 + 2);
+
+    // Freed up space gets reused.
+    for (size_t i = 0; i < count; i += 2)
+        create_file(entry_path(directory, i));
+    EXPECT_EQ(count_directory_entries(directory), count + 2);
+
+    for (size_t i = 0; i < count; ++i)
+        EXPECT_EQ(unlink(entry_path(directory, i).characters()), 0);
+    EXPECT_EQ(count_directory_entries(directory), 2u);
+    EXPECT_EQ(rmdir(directory.characters()), 0);
+}
+
+TEST_CASE(rename_within_large_directory)
+{
+    constexpr size_t count = 1000;
+    auto directory = make_test_directory();
+    for (size_t i = 0; i < count; ++i)
+        create_file(entry_path(directory, i));
+
+    for (size_t i = 0; i < count; ++i)
+        EXPECT_EQ(rename(entry_path(directory, i).characters(), entry_path(directory, i + count).characters()), 0);
+
+    struct stat st;
+    for (size_t i = 0; i < count; ++i) {
+        EXPECT_EQ(stat(entry_path(directory, i).characters(), &st), -1);
+        EXPECT_EQ(stat(entry_path(directory, i + count).characters(), &st), 0);
+        EXPECT_EQ(unlink(entry_path(directory, i + count).characters()), 0);
+    }
+    EXPECT_EQ(rmdir(directory.characters()), 0);
+}
+
+// "." and ".." stay in the first block when the directory gets an index, where the index doesn't point.
+TEST_CASE(dot_and_dot_dot_outlive_the_index)
+{
+    constexpr size_t count = 1000;
+    auto directory = make_test_directory();
+    for (size_t i = 0; i < count; ++i)
+        create_file(entry_path(directory, i));
+
+    struct stat directory_stat;
+    struct stat parent_stat;
+    struct stat st;
+    EXPECT_EQ(stat(directory.characters(), &directory_stat), 0);
+    EXPECT_EQ(stat("/var/tmp", &parent_stat), 0);
+    EXPECT_EQ(stat(String::formatted("{}/.", directory).characters(), &st), 0);
+    EXPECT_EQ(st.st_ino, directory_stat.st_ino);
+    EXPECT_EQ(stat(String::formatted("{}/..", directory).characters(), &st), 0);
+    EXPECT_EQ(st.st_ino, parent_stat.st_ino);
+
+    for (size_t i = 0; i < count; ++i)
+        EXPECT_EQ(unlink(entry_path(directory, i).characters()), 0);
+    EXPECT_EQ(rmdir(directory.characters()), 0);
+    EXPECT_EQ(stat(directory.characters(), &st), -1);
+    EXPECT_EQ(errno, ENOENT);
+}
+
+// Every one of these used to rewrite the whole directory and look up names with a linear scan.
+BENCHMARK_CASE(create_stat_and_unlink_many_files)
+{
+    constexpr size_t count = 100'000;
+    auto directory = make_test_directory();
+
+    for (size_t i = 0; i < count; ++i)
+        create_file(entry_path(directory, i));
+    struct stat st;
+    for (size_t i = 0; i < count; ++i)
+        VERIFY(stat(entry_path(directory, i).characters(), &st) == 0);
+    for (size_t i = 0; i < count; ++i)
+        VERIFY(unlink(entry_path(directory, i).characters()) == 0);
+
+    EXPECT_EQ(rmdir(directory.characters()), 0);
+}
@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <LibTest/TestCase.h>
+#include <errno.h>
+#include <pthread.h>
+#include <spawn.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+
+static int wait_for_exit_status(pid_t pid)
+{
+    int status = 0;
+    VERIFY(waitpid(pid, &status, 0) == pid);
+    VERIFY(WIFEXITED(status));
+    return WEXITSTATUS(status);
+}
+
+TEST_CASE(fork_child_gets_a_private_copy)
+{
+    constexpr size_t size = 4 * MiB;
+    auto* buffer = static_cast<u8*>(mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0));
+    EXPECT(buffer != MAP_FAILED);
+    // Only touch every other page, so the child sees a mix of populated and zero pages.
+    for (size_t offset = 0; offset < size; offset += 2 * PAGE_SIZE)
+        buffer[offset] = 0xaa;
+
+    pid_t pid = fork();
+    VERIFY(pid >= 0);
+    if (pid == 0) {
+        for (size_t offset = 0; offset < size; offset += PAGE_SIZE) {
+            u8 expected = (offset / PAGE_SIZE) % 2 == 0 ? 0xaa : 0;
+            if (buffer[offset] != expected)
+                _exit(1);
+            buffer[offset] = 0x55;
+        }
+        _exit(0);
+    }
+
+    EXPECT_EQ(wait_for_exit_status(pid), 0);
+    for (size_t offset = 0; offset < size; offset += PAGE_SIZE)
+        EXPECT_EQ(buffer[offset], (offset / PAGE_SIZE) % 2 == 0 ? 0xaa : 0);
+    EXPECT_EQ(munmap(buffer, size), 0);
+}
+
+TEST_CASE(vfork_child_runs_on_parent_memory)
+{
+    volatile int value = 1;
+    pid_t pid = vfork();
+    VERIFY(pid >= 0);
+    if (pid == 0) {
+        value = 2;
+        _exit(42);
+    }
+
+    // We don't get to run again before the child is done with our memory.
+    EXPECT_EQ(value, 2);
+    EXPECT_EQ(wait_for_exit_status(pid), 42);
+}
+
+TEST_CASE(vfork_parent_resumes_after_exec)
+{
+    pid_t pid = vfork();
+    VERIFY(pid >= 0);
+    if (pid == 0) {
+        char const* argv[] = { "/bin/true", nullptr };
+        execve(argv[0], const_cast<char**>(argv), environ);
+        _exit(127);
+    }
+    EXPECT_EQ(wait_for_exit_status(pid), 0);
+}
+
+TEST_CASE(exec_on_another_thread_while_vforked)
+{
+    // Do this in a separate process, since it ends with that process being replaced by /bin/true.
+    pid_t pid = fork();
+    VERIFY(pid >= 0);
+    if (pid == 0) {
+        pthread_t thread;
+        auto rc = pthread_create(&thread, nullptr, [](void*) -> void* {
+            usleep(50'000);
+            char const* argv[] = { "/bin/true", nullptr };
+            execve(argv[0], const_cast<char**>(argv), environ);
+            _exit(127);
+        }, nullptr);
+        if (rc != 0)
+            _exit(126);
+
+        pid_t child = vfork();
+        if (child == 0) {
+            // Keep using the borrowed memory while our parent execs underneath us.
+            volatile u8 buffer[4 * PAGE_SIZE];
+            for (size_t i = 0; i < 200; ++i) {
+                for (size_t offset = 0; offset < sizeof(buffer); offset += PAGE_SIZE)
+                    buffer[offset] = static_cast<u8>(i);
+                (void)getpid();
+                usleep(1000);
+            }
+            _exit(0);
+        }
+        // The exec on the other thread takes us down before we get here.
+        _exit(125);
+    }
+    EXPECT_EQ(wait_for_exit_status(pid), 0);
+}
+
+TEST_CASE(posix_spawn_runs_program)
+{
+    pid_t pid = 0;
+    char const* argv[] = { "sh", "-c", "exit 7", nullptr };
+    EXPECT_EQ(posix_spawnp(&pid, "sh", nullptr, nullptr, const_cast<char**>(argv), environ), 0);
+    EXPECT_EQ(wait_for_exit_status(pid), 7);
+}
+
+TEST_CASE(posix_spawn_reports_exec_failure)
+{
+    pid_t pid = 0;
+    char const* argv[] = { "does-not-exist", nullptr };
+    EXPECT_EQ(posix_spawn(&pid, "/bin/does-not-exist", nullptr, nullptr, const_cast<char**>(argv), environ), ENOENT);
+    EXPECT_EQ(posix_spawnp(&pid, "does-not-exist", nullptr, nullptr, const_cast<char**>(argv), environ), ENOENT);
+    // The failed child has been reaped already.
+    EXPECT_EQ(waitpid(-1, nullptr, WNOHANG), -1);
+    EXPECT_EQ(errno, ECHILD);
+}
+
+TEST_CASE(posix_spawn_file_actions)
+{
+    int fds[2];
+    EXPECT_EQ(pipe(fds), 0);
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, fds[1], STDOUT_FILENO);
+    posix_spawn_file_actions_addclose(&actions, fds[0]);
+
+    pid_t pid = 0;
+    char const* argv[] = { "echo", "hello", nullptr };
+    EXPECT_EQ(posix_spawnp(&pid, "echo", &actions, nullptr, const_cast<char**>(argv), environ), 0);
+    posix_spawn_file_actions_destroy(&actions);
+    close(fds[1]);
+
+    char buffer[16] {};
+    EXPECT_EQ(read(fds[0], buffer, sizeof(buffer)), 6);
+    EXPECT_EQ(StringView(buffer, 6), "hello\n"sv);
+    close(fds[0]);
+    EXPECT_EQ(wait_for_exit_status(pid), 0);
+}
+
+// Spawning from a process with a lot of memory shouldn't cost more than spawning from a small one.
+template<typename Spawn>
+static void spawn_from_large_process(Spawn spawn)
+{
+    constexpr size_t size = 256 * MiB;
+    constexpr size_t iterations = 100;
+    auto* buffer = static_cast<u8*>(mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0));
+    EXPECT(buffer != MAP_FAILED);
+    memset(buffer, 1, size);
+
+    for (size_t i = 0; i < iterations; ++i)
+        EXPECT_EQ(wait_for_exit_status(spawn()), 0);
+
+    EXPECT_EQ(munmap(buffer, size), 0);
+}
+
+static char const* s_true_argv[] = { "/bin/true", nullptr };
+
+BENCHMARK_CASE(fork_and_exec_from_large_process)
+{
+    spawn_from_large_process([] {
+        pid_t pid = fork();
+        if (pid == 0) {
+            execve(s_true_argv[0], const_cast<char**>(s_true_argv), environ);
+            _exit(127);
+        }
+        return pid;
+    });
+}
+
+BENCHMARK_CASE(posix_spawn_from_large_process)
+{
+    spawn_from_large_process([] {
+        pid_t pid = 0;
+        VERIFY(posix_spawn(&pid, s_true_argv[0], nullptr, nullptr, const_cast<char**>(s_true_argv), environ) == 0);
+        return pid;
+    });
+}
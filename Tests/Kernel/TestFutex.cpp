@@ -0,0 +1,238 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Atomic.h>
+#include <AK/Vector.h>
+#include <LibTest/TestCase.h>
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <serenity.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+static int requeue(u32* from, u32 wake_count, u32* to, u32 requeue_count)
+{
+    // The requeue count is passed in place of the timeout.
+    return futex(from, FUTEX_REQUEUE | FUTEX_PRIVATE_FLAG, wake_count, reinterpret_cast<timespec const*>(static_cast<FlatPtr>(requeue_count)), to, 0);
+}
+
+TEST_CASE(wake_without_waiters)
+{
+    u32 word = 0;
+    EXPECT_EQ(futex_wake(&word, 1, false), 0);
+    EXPECT_EQ(futex_wake(&word, INT_MAX, true), 0);
+}
+
+TEST_CASE(wait_on_changed_value)
+{
+    u32 word = 1;
+    EXPECT_EQ(futex_wait(&word, 0, nullptr, 0, false), -1);
+    EXPECT_EQ(errno, EAGAIN);
+    EXPECT_EQ(futex_wait(&word, 0, nullptr, 0, true), -1);
+    EXPECT_EQ(errno, EAGAIN);
+}
+
+TEST_CASE(wait_times_out)
+{
+    u32 word = 0;
+    timespec deadline {};
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &deadline);
+    deadline.tv_nsec += 50'000'000;
+    if (deadline.tv_nsec >= 1'000'000'000) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1'000'000'000;
+    }
+    EXPECT_EQ(futex_wait(&word, 0, &deadline, CLOCK_MONOTONIC_COARSE, false), -1);
+    EXPECT_EQ(errno, ETIMEDOUT);
+}
+
+static u32 s_word;
+static u32 s_other_word;
+static Atomic<size_t> s_woken_count;
+
+static void* wait_on_word(void*)
+{
+    while (AK::atomic_load(&s_word) == 0)
+        futex_wait(&s_word, 0, nullptr, 0, false);
+    s_woken_count++;
+    return nullptr;
+}
+
+static void* wait_on_word_once(void*)
+{
+    futex_wait(&s_word, 0, nullptr, 0, false);
+    s_woken_count++;
+    return nullptr;
+}
+
+static Vector<pthread_t> spawn_waiters(size_t count, void* (*entry)(void*))
+{
+    Vector<pthread_t> threads;
+    threads.resize(count);
+    for (auto& thread : threads)
+        VERIFY(pthread_create(&thread, nullptr, entry, nullptr) == 0);
+    // Give them some time to actually block.
+    usleep(100'000);
+    return threads;
+}
+
+TEST_CASE(wake_wakes_every_waiter)
+{
+    s_word = 0;
+    s_woken_count = 0;
+    auto threads = spawn_waiters(16, wait_on_word);
+    AK::atomic_store(&s_word, 1u);
+    futex_wake(&s_word, INT_MAX, false);
+    for (auto& thread : threads)
+        EXPECT_EQ(pthread_join(thread, nullptr), 0);
+    EXPECT_EQ(s_woken_count.load(), 16u);
+}
+
+TEST_CASE(requeue_moves_waiters_to_the_other_futex)
+{
+    constexpr size_t waiter_count = 8;
+    s_word = 0;
+    s_other_word = 0;
+    s_woken_count = 0;
+    auto threads = spawn_waiters(waiter_count, wait_on_word_once);
+
+    // Wake one up and move the rest over. None of them should wake up from waking the original futex afterwards.
+    EXPECT_EQ(requeue(&s_word, 1, &s_other_word, INT_MAX), static_cast<int>(waiter_count));
+    EXPECT_EQ(futex_wake(&s_word, INT_MAX, false), 0);
+    usleep(50'000);
+    EXPECT_EQ(s_woken_count.load(), 1u);
+
+    EXPECT_EQ(futex_wake(&s_other_word, INT_MAX, false), static_cast<int>(waiter_count - 1));
+    for (auto& thread : threads)
+        EXPECT_EQ(pthread_join(thread, nullptr), 0);
+    EXPECT_EQ(s_woken_count.load(), waiter_count);
+}
+
+TEST_CASE(wake_op_modifies_and_conditionally_wakes)
+{
+    s_word = 0;
+    s_other_word = 5;
+    s_woken_count = 0;
+    auto threads = spawn_waiters(2, wait_on_word_once);
+
+    // Wakes one waiter and adds 1 to the other word. Nobody waits on that one, so the comparison wakes no one else.
+    auto op = FUTEX_OP(FUTEX_OP_ADD, 1, FUTEX_OP_CMP_EQ, 5);
+    EXPECT_EQ(futex(&s_word, FUTEX_WAKE_OP | FUTEX_PRIVATE_FLAG, 1, reinterpret_cast<timespec const*>(0), &s_other_word, op), 1);
+    EXPECT_EQ(AK::atomic_load(&s_other_word), 6u);
+    EXPECT_EQ(futex_wake(&s_word, INT_MAX, false), 1);
+    for (auto& thread : threads)
+        EXPECT_EQ(pthread_join(thread, nullptr), 0);
+}
+
+TEST_CASE(shared_futex_across_processes)
+{
+    auto* words = static_cast<u32*>(mmap(nullptr, PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_SHARED, -1, 0));
+    EXPECT(words != MAP_FAILED);
+    words[0] = 0;
+
+    pid_t pid = fork();
+    VERIFY(pid >= 0);
+    if (pid == 0) {
+        while (AK::atomic_load(&words[0]) == 0)
+            futex_wait(&words[0], 0, nullptr, 0, true);
+        _exit(0);
+    }
+
+    usleep(100'000);
+    AK::atomic_store(&words[0], 1u);
+    futex_wake(&words[0], 1, true);
+
+    int status = 0;
+    EXPECT_EQ(waitpid(pid, &status, 0), pid);
+    EXPECT(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    EXPECT_EQ(munmap(words, PAGE_SIZE), 0);
+}
+
+static pthread_mutex_t s_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t s_condition = PTHREAD_COND_INITIALIZER;
+static bool s_go;
+
+static void* wait_for_broadcast(void*)
+{
+    pthread_mutex_lock(&s_mutex);
+    while (!s_go)
+        pthread_cond_wait(&s_condition, &s_mutex);
+    s_woken_count++;
+    pthread_mutex_unlock(&s_mutex);
+    return nullptr;
+}
+
+TEST_CASE(condition_broadcast_wakes_everyone)
+{
+    s_go = false;
+    s_woken_count = 0;
+    auto threads = spawn_waiters(32, wait_for_broadcast);
+    pthread_mutex_lock(&s_mutex);
+    s_go = true;
+    pthread_cond_broadcast(&s_condition);
+    pthread_mutex_unlock(&s_mutex);
+    for (auto& thread : threads)
+        EXPECT_EQ(pthread_join(thread, nullptr), 0);
+    EXPECT_EQ(s_woken_count.load(), 32u);
+}
+
+// Uncontended wakes shouldn't have to take any locks in the kernel.
+BENCHMARK_CASE(uncontended_wake)
+{
+    constexpr size_t iterations = 1'000'000;
+    u32 word = 0;
+    for (size_t i = 0; i < iterations; ++i)
+        futex_wake(&word, 1, false);
+}
+
+static Atomic<bool> s_stop;
+
+static void* signal_forever(void*)
+{
+    while (!s_stop.load()) {
+        pthread_mutex_lock(&s_mutex);
+        s_go = true;
+        pthread_cond_broadcast(&s_condition);
+        pthread_mutex_unlock(&s_mutex);
+    }
+    return nullptr;
+}
+
+// Many threads hammering a single condition variable, which is where requeueing onto the mutex helps most.
+BENCHMARK_CASE(condition_broadcast_storm)
+{
+    constexpr size_t waiter_count = 16;
+    constexpr size_t rounds = 20'000;
+    s_stop = false;
+    s_woken_count = 0;
+
+    pthread_t signaller;
+    EXPECT_EQ(pthread_create(&signaller, nullptr, signal_forever, nullptr), 0);
+    Vector<pthread_t> threads;
+    threads.resize(waiter_count);
+    for (auto& thread : threads) {
+        EXPECT_EQ(pthread_create(
+                      &thread, nullptr, [](void*) -> void* {
+                          for (size_t i = 0; i < rounds; ++i) {
+                              pthread_mutex_lock(&s_mutex);
+                              s_go = false;
+                              while (!s_go)
+                                  pthread_cond_wait(&s_condition, &s_mutex);
+                              pthread_mutex_unlock(&s_mutex);
+                          }
+                          return nullptr;
+                      },
+                      nullptr),
+            0);
+    }
+    for (auto& thread : threads)
+        EXPECT_EQ(pthread_join(thread, nullptr), 0);
+    s_stop = true;
+    EXPECT_EQ(pthread_join(signaller, nullptr), 0);
+}
@@ -0,0 +1,428 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Atomic.h>
+#include <AK/Vector.h>
+#include <LibTest/TestCase.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <serenity.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+static constexpr timespec zero_timeout = { 0, 0 };
+
+class Ring {
+    AK_MAKE_NONCOPYABLE(Ring);
+    AK_MAKE_NONMOVABLE(Ring);
+
+public:
+    explicit Ring(u32 entries)
+    {
+        m_fd = io_ring_create(entries, IO_RING_CLOEXEC, &m_params);
+        VERIFY(m_fd >= 0);
+        auto* mapping = mmap(nullptr, m_params.mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+        VERIFY(mapping != MAP_FAILED);
+        m_mapping = static_cast<u8*>(mapping);
+    }
+
+    ~Ring()
+    {
+        munmap(m_mapping, m_params.mapping_size);
+        close(m_fd);
+    }
+
+    int fd() const { return m_fd; }
+    io_ring_params const& params() const { return m_params; }
+    io_ring_header& header() { return *reinterpret_cast<io_ring_header*>(m_mapping); }
+
+    void push(io_ring_submission const& submission)
+    {
+        auto tail = header().submission_tail;
+        VERIFY(tail - AK::atomic_load(&header().submission_head) < m_params.submission_entries);
+        reinterpret_cast<io_ring_submission*>(m_mapping + m_params.submissions_offset)[tail & (m_params.submission_entries - 1)] = submission;
+        AK::atomic_store(&header().submission_tail, tail + 1);
+    }
+
+    int enter(u32 to_submit, u32 min_complete, timespec const* timeout = nullptr)
+    {
+        return io_ring_enter(m_fd, to_submit, min_complete, timeout);
+    }
+
+    Vector<io_ring_completion> reap()
+    {
+        Vector<io_ring_completion> completions;
+        auto head = header().completion_head;
+        auto tail = AK::atomic_load(&header().completion_tail);
+        for (; head != tail; ++head)
+            completions.append(reinterpret_cast<io_ring_completion*>(m_mapping + m_params.completions_offset)[head & (m_params.completion_entries - 1)]);
+        AK::atomic_store(&header().completion_head, head);
+        return completions;
+    }
+
+private:
+    int m_fd { -1 };
+    io_ring_params m_params {};
+    u8* m_mapping { nullptr };
+};
+
+static io_ring_submission make_submission(u8 opcode, int fd, u64 user_data)
+{
+    io_ring_submission submission {};
+    submission.opcode = opcode;
+    submission.fd = fd;
+    submission.offset = IO_RING_OFFSET_CURRENT;
+    submission.user_data = user_data;
+    return submission;
+}
+
+static io_ring_submission make_buffer_submission(u8 opcode, int fd, void const* buffer, size_t length, u64 user_data)
+{
+    auto submission = make_submission(opcode, fd, user_data);
+    submission.address = reinterpret_cast<FlatPtr>(buffer);
+    submission.length = length;
+    return submission;
+}
+
+TEST_CASE(create_rounds_up_and_rejects_bad_arguments)
+{
+    io_ring_params params {};
+    EXPECT_EQ(io_ring_create(0, 0, &params), -1);
+    EXPECT_EQ(errno, EINVAL);
+    EXPECT_EQ(io_ring_create(IO_RING_MAX_ENTRIES + 1, 0, &params), -1);
+    EXPECT_EQ(errno, EINVAL);
+    EXPECT_EQ(io_ring_create(8, 0x100, &params), -1);
+    EXPECT_EQ(errno, EINVAL);
+
+    Ring ring(5);
+    EXPECT_EQ(ring.params().submission_entries, 8u);
+    EXPECT_EQ(ring.params().completion_entries, 16u);
+    EXPECT_EQ(ring.params().mapping_size % PAGE_SIZE, 0u);
+}
+
+TEST_CASE(nops_complete_in_order)
+{
+    Ring ring(8);
+    for (u64 i = 1; i <= 4; ++i)
+        ring.push(make_submission(IO_RING_OP_NOP, -1, i));
+    EXPECT_EQ(ring.enter(4, 4), 4);
+
+    auto completions = ring.reap();
+    EXPECT_EQ(completions.size(), 4u);
+    for (size_t i = 0; i < completions.size(); ++i) {
+        EXPECT_EQ(completions[i].user_data, i + 1);
+        EXPECT_EQ(completions[i].result, 0);
+    }
+}
+
+TEST_CASE(failed_submissions_complete_with_an_error)
+{
+    Ring ring(8);
+    ring.push(make_submission(IO_RING_OP_READ, 12345, 1));
+    ring.push(make_submission(200, -1, 2));
+    EXPECT_EQ(ring.enter(2, 2), 2);
+
+    auto completions = ring.reap();
+    EXPECT_EQ(completions.size(), 2u);
+    EXPECT_EQ(completions[0].result, -EBADF);
+    EXPECT_EQ(completions[1].result, -EINVAL);
+}
+
+TEST_CASE(pipe_write_then_read)
+{
+    Ring ring(8);
+    int fds[2];
+    EXPECT_EQ(pipe(fds), 0);
+
+    char const message[] = "hello friends";
+    char buffer[sizeof(message)] {};
+    ring.push(make_buffer_submission(IO_RING_OP_WRITE, fds[1], message, sizeof(message), 1));
+    ring.push(make_buffer_submission(IO_RING_OP_READ, fds[0], buffer, sizeof(buffer), 2));
+    EXPECT_EQ(ring.enter(2, 2), 2);
+
+    auto completions = ring.reap();
+    EXPECT_EQ(completions.size(), 2u);
+    EXPECT_EQ(completions[0].result, static_cast<i32>(sizeof(message)));
+    EXPECT_EQ(completions[1].result, static_cast<i32>(sizeof(message)));
+    EXPECT_EQ(memcmp(buffer, message, sizeof(message)), 0);
+
+    close(fds[0]);
+    close(fds[1]);
+}
+
+TEST_CASE(read_waits_for_data)
+{
+    Ring ring(8);
+    int fds[2];
+    EXPECT_EQ(pipe(fds), 0);
+
+    char buffer[8] {};
+    ring.push(make_buffer_submission(IO_RING_OP_READ, fds[0], buffer, sizeof(buffer), 7));
+    EXPECT_EQ(ring.enter(1, 1, &zero_timeout), 1);
+    EXPECT(ring.reap().is_empty());
+
+    EXPECT_EQ(write(fds[1], "abc", 3), 3);
+    EXPECT_EQ(ring.enter(0, 1), 0);
+    auto completions = ring.reap();
+    EXPECT_EQ(completions.size(), 1u);
+    EXPECT_EQ(completions[0].user_data, 7u);
+    EXPECT_EQ(completions[0].result, 3);
+    EXPECT_EQ(memcmp(buffer, "abc", 3), 0);
+
+    close(fds[0]);
+    close(fds[1]);
+}
+
+// Both reads get woken up by the first byte, but only one of them can have it.
+// The other one has to go back to waiting, rather than getting stuck in the pipe.
+TEST_CASE(reads_racing_for_the_same_data)
+{
+    Ring first_ring(8);
+    Ring second_ring(8);
+    int fds[2];
+    EXPECT_EQ(pipe(fds), 0);
+
+    char first_buffer[1] {};
+    char second_buffer[1] {};
+    first_ring.push(make_buffer_submission(IO_RING_OP_READ, fds[0], first_buffer, 1, 1));
+    second_ring.push(make_buffer_submission(IO_RING_OP_READ, fds[0], second_buffer, 1, 2));
+    EXPECT_EQ(first_ring.enter(1, 0), 1);
+    EXPECT_EQ(second_ring.enter(1, 0), 1);
+
+    EXPECT_EQ(write(fds[1], "a", 1), 1);
+    pollfd poll_fds[] = { { first_ring.fd(), POLLIN, 0 }, { second_ring.fd(), POLLIN, 0 } };
+    EXPECT_EQ(poll(poll_fds, 2, 5000), 1);
+    bool first_won = poll_fds[0].revents & POLLIN;
+    auto& winner = first_won ? first_ring : second_ring;
+    auto& loser = first_won ? second_ring : first_ring;
+    auto completions = winner.reap();
+    EXPECT_EQ(completions.size(), 1u);
+    EXPECT_EQ(completions[0].result, 1);
+
+    // Whatever else the losing ring is asked to do still gets done in the meantime.
+    char path[] = "/tmp/TestIORing.XXXXXX";
+    int fd = mkstemp(path);
+    EXPECT(fd >= 0);
+    unlink(path);
+    loser.push(make_submission(IO_RING_OP_FSYNC, fd, 3));
+    EXPECT_EQ(loser.enter(1, 1), 1);
+    completions = loser.reap();
+    EXPECT_EQ(completions.size(), 1u);
+    EXPECT_EQ(completions[0].user_data, 3u);
+    EXPECT_EQ(completions[0].result, 0);
+    close(fd);
+
+    EXPECT_EQ(write(fds[1], "b", 1), 1);
+    EXPECT_EQ(loser.enter(0, 1), 0);
+    completions = loser.reap();
+    EXPECT_EQ(completions.size(), 1u);
+    EXPECT_EQ(completions[0].result, 1);
+    EXPECT_EQ(first_won ? second_buffer[0] : first_buffer[0], 'b');
+
+    close(fds[0]);
+    close(fds[1]);
+}
+
+TEST_CASE(readv_and_writev)
+{
+    Ring ring(8);
+    int fds[2];
+    EXPECT_EQ(pipe(fds), 0);
+
+    char first[] = "well ";
+    char second[] = "hello";
+    iovec write_vecs[] = { { first, 5 }, { second, 5 } };
+    auto writev_submission = make_submission(IO_RING_OP_WRITEV, fds[1], 1);
+    writev_submission.address = reinterpret_cast<FlatPtr>(write_vecs);
+    writev_submission.length = 2;
+
+    char read_first[3] {};
+    char read_second[7] {};
+    iovec read_vecs[] = { { read_first, sizeof(read_first) }, { read_second, sizeof(read_second) } };
+    auto readv_submission = make_submission(IO_RING_OP_READV, fds[0], 2);
+    readv_submission.address = reinterpret_cast<FlatPtr>(read_vecs);
+    readv_submission.length = 2;
+
+    ring.push(writev_submission);
+    ring.push(readv_submission);
+    EXPECT_EQ(ring.enter(2, 2), 2);
+
+    auto completions = ring.reap();
+    EXPECT_EQ(completions.size(), 2u);
+    EXPECT_EQ(completions[0].result, 10);
+    EXPECT_EQ(completions[1].result, 10);
+    EXPECT_EQ(memcmp(read_first, "wel", 3), 0);
+    EXPECT_EQ(memcmp(read_second, "l hello", 7), 0);
+
+    close(fds[0]);
+    close(fds[1]);
+}
+
+TEST_CASE(file_io_at_offsets_and_fsync)
+{
+    char path[] = "/tmp/TestIORing.XXXXXX";
+    int fd = mkstemp(path);
+    EXPECT(fd >= 0);
+    unlink(path);
+
+    Ring ring(8);
+    char const data[] = "0123456789";
+    auto write_submission = make_buffer_submission(IO_RING_OP_WRITE, fd, data, 10, 1);
+    write_submission.offset = 4096;
+    ring.push(write_submission);
+    EXPECT_EQ(ring.enter(1, 1), 1);
+    ring.push(make_submission(IO_RING_OP_FSYNC, fd, 2));
+    EXPECT_EQ(ring.enter(1, 1), 1);
+
+    auto completions = ring.reap();
+    EXPECT_EQ(completions.size(), 2u);
+    EXPECT_EQ(completions[0].result, 10);
+    EXPECT_EQ(completions[1].result, 0);
+
+    // Writing at an explicit offset leaves the file offset alone.
+    EXPECT_EQ(lseek(fd, 0, SEEK_CUR), 0);
+
+    char buffer[4] {};
+    auto read_submission = make_buffer_submission(IO_RING_OP_READ, fd, buffer, sizeof(buffer), 3);
+    read_submission.offset = 4096 + 6;
+    ring.push(read_submission);
+    EXPECT_EQ(ring.enter(1, 1), 1);
+    completions = ring.reap();
+    EXPECT_EQ(completions.size(), 1u);
+    EXPECT_EQ(completions[0].result, 4);
+    EXPECT_EQ(memcmp(buffer, "6789", 4), 0);
+
+    close(fd);
+}
+
+TEST_CASE(poll_and_cancel)
+{
+    Ring ring(8);
+    int fds[2];
+    EXPECT_EQ(pipe(fds), 0);
+
+    auto poll_submission = make_submission(IO_RING_OP_POLL, fds[0], 1);
+    poll_submission.poll_events = POLLIN;
+    ring.push(poll_submission);
+    EXPECT_EQ(ring.enter(1, 1, &zero_timeout), 1);
+    EXPECT(ring.reap().is_empty());
+
+    EXPECT_EQ(write(fds[1], "x", 1), 1);
+    EXPECT_EQ(ring.enter(0, 1), 0);
+    auto completions = ring.reap();
+    EXPECT_EQ(completions.size(), 1u);
+    EXPECT_EQ(completions[0].result, static_cast<i32>(POLLIN));
+
+    // The write end of a pipe never becomes readable, so this poll has to be cancelled.
+    auto stuck_submission = make_submission(IO_RING_OP_POLL, fds[1], 2);
+    stuck_submission.poll_events = POLLIN;
+    ring.push(stuck_submission);
+    auto cancel_submission = make_submission(IO_RING_OP_CANCEL, -1, 3);
+    cancel_submission.address = 2;
+    ring.push(cancel_submission);
+    EXPECT_EQ(ring.enter(2, 2), 2);
+    completions = ring.reap();
+    EXPECT_EQ(completions.size(), 2u);
+    EXPECT_EQ(completions[0].user_data, 2u);
+    EXPECT_EQ(completions[0].result, -ECANCELED);
+    EXPECT_EQ(completions[1].user_data, 3u);
+    EXPECT_EQ(completions[1].result, 0);
+
+    // There is nothing left to cancel.
+    ring.push(cancel_submission);
+    EXPECT_EQ(ring.enter(1, 1), 1);
+    completions = ring.reap();
+    EXPECT_EQ(completions.size(), 1u);
+    EXPECT_EQ(completions[0].result, -ENOENT);
+
+    close(fds[0]);
+    close(fds[1]);
+}
+
+TEST_CASE(accept_and_connect_local_sockets)
+{
+    char const* path = "/tmp/TestIORing.socket";
+    unlink(path);
+
+    int server_fd = socket(AF_LOCAL, SOCK_STREAM, 0);
+    EXPECT(server_fd >= 0);
+    sockaddr_un address {};
+    address.sun_family = AF_LOCAL;
+    strlcpy(address.sun_path, path, sizeof(address.sun_path));
+    EXPECT_EQ(bind(server_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)), 0);
+    EXPECT_EQ(listen(server_fd, 1), 0);
+
+    Ring ring(8);
+    auto accept_submission = make_submission(IO_RING_OP_ACCEPT, server_fd, 1);
+    accept_submission.flags = SOCK_CLOEXEC;
+    ring.push(accept_submission);
+    EXPECT_EQ(ring.enter(1, 0), 1);
+
+    // Local connects block until accepted, so the accept has to finish on the work queue while io_ring_enter() is still connecting.
+    int client_fd = socket(AF_LOCAL, SOCK_STREAM, 0);
+    EXPECT(client_fd >= 0);
+    auto connect_submission = make_buffer_submission(IO_RING_OP_CONNECT, client_fd, &address, sizeof(address), 2);
+    ring.push(connect_submission);
+    EXPECT_EQ(ring.enter(1, 2), 1);
+
+    auto completions = ring.reap();
+    EXPECT_EQ(completions.size(), 2u);
+    int accepted_fd = -1;
+    for (auto& completion : completions) {
+        if (completion.user_data == 1)
+            accepted_fd = completion.result;
+        else
+            EXPECT_EQ(completion.result, 0);
+    }
+    EXPECT(accepted_fd >= 0);
+    EXPECT_EQ(fcntl(accepted_fd, F_GETFD), FD_CLOEXEC);
+
+    EXPECT_EQ(write(client_fd, "ping", 4), 4);
+    char buffer[4] {};
+    EXPECT_EQ(read(accepted_fd, buffer, 4), 4);
+    EXPECT_EQ(memcmp(buffer, "ping", 4), 0);
+
+    close(accepted_fd);
+    close(client_fd);
+    close(server_fd);
+    unlink(path);
+}
+
+// Small reads from /dev/zero are about as cheap as I/O gets, so these mostly measure the cost of getting
+// in and out of the kernel: one syscall per read, against one io_ring_enter() per batch of reads.
+static constexpr size_t small_read_count = 100'000;
+
+BENCHMARK_CASE(small_reads_one_syscall_per_read)
+{
+    int fd = open("/dev/zero", O_RDONLY);
+    EXPECT(fd >= 0);
+    char buffer[64];
+    for (size_t i = 0; i < small_read_count; ++i)
+        VERIFY(read(fd, buffer, sizeof(buffer)) == sizeof(buffer));
+    close(fd);
+}
+
+BENCHMARK_CASE(small_reads_batched)
+{
+    constexpr u32 batch_size = 64;
+    int fd = open("/dev/zero", O_RDONLY);
+    EXPECT(fd >= 0);
+    char buffer[64];
+    Ring ring(batch_size);
+    for (size_t i = 0; i < small_read_count; i += batch_size) {
+        for (u32 j = 0; j < batch_size; ++j)
+            ring.push(make_buffer_submission(IO_RING_OP_READ, fd, buffer, sizeof(buffer), j));
+        VERIFY(ring.enter(batch_size, batch_size) == static_cast<int>(batch_size));
+        for (auto& completion : ring.reap())
+            VERIFY(completion.result == sizeof(buffer));
+    }
+    close(fd);
+}
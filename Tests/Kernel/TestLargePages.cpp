@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/StringView.h>
+#include <LibTest/TestCase.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// NOTE: Whether a mapping actually ends up backed by large pages depends on how fragmented physical
+//       memory is, so these only check that the contents behave like ordinary anonymous memory.
+
+static constexpr size_t large_page_size = 2 * MiB;
+
+static u64 memstat_counter(StringView name)
+{
+    int fd = open("/proc/memstat", O_RDONLY);
+    VERIFY(fd >= 0);
+    char buffer[4096] {};
+    auto nread = read(fd, buffer, sizeof(buffer) - 1);
+    close(fd);
+    VERIFY(nread > 0);
+
+    char key[64];
+    VERIFY(snprintf(key, sizeof(key), "\"%.*s\":", static_cast<int>(name.length()), name.characters_without_null_termination()) > 0);
+    auto* value = strstr(buffer, key);
+    VERIFY(value);
+    return strtoull(value + strlen(key), nullptr, 10);
+}
+
+static u8 pattern_byte(size_t offset)
+{
+    return static_cast<u8>((offset >> 12) ^ (offset * 13));
+}
+
+static u8* map_anonymous(size_t size)
+{
+    auto* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+    VERIFY(ptr != MAP_FAILED);
+    return static_cast<u8*>(ptr);
+}
+
+static void fill_pattern(u8* data, size_t size)
+{
+    for (size_t i = 0; i < size; ++i)
+        data[i] = pattern_byte(i);
+}
+
+static bool matches_pattern(u8 const* data, size_t offset, size_t size)
+{
+    for (size_t i = offset; i < offset + size; ++i) {
+        if (data[i] != pattern_byte(i))
+            return false;
+    }
+    return true;
+}
+
+TEST_CASE(large_anonymous_mapping_is_aligned_and_zeroed)
+{
+    auto attempts_before = memstat_counter("large_pages_allocated"sv) + memstat_counter("large_page_allocation_failures"sv);
+
+    constexpr size_t size = 8 * MiB;
+    auto* data = map_anonymous(size);
+    EXPECT_EQ(reinterpret_cast<FlatPtr>(data) % large_page_size, 0u);
+
+    bool all_zero = true;
+    for (size_t i = 0; i < size; i += sizeof(u64)) {
+        if (*reinterpret_cast<u64 const*>(data + i) != 0)
+            all_zero = false;
+    }
+    EXPECT(all_zero);
+
+    fill_pattern(data, size);
+    EXPECT(matches_pattern(data, 0, size));
+
+    // Every 2 MiB chunk we faulted in either got a large page or fell back to small ones.
+    auto attempts_after = memstat_counter("large_pages_allocated"sv) + memstat_counter("large_page_allocation_failures"sv);
+    EXPECT(attempts_after >= attempts_before + size / large_page_size);
+
+    EXPECT_EQ(munmap(data, size), 0);
+}
+
+TEST_CASE(mprotect_splits_a_large_page)
+{
+    constexpr size_t size = 4 * MiB;
+    auto* data = map_anonymous(size);
+    fill_pattern(data, size);
+
+    auto* middle = data + large_page_size + 5 * PAGE_SIZE;
+    EXPECT_EQ(mprotect(middle, PAGE_SIZE, PROT_READ), 0);
+    EXPECT(matches_pattern(data, 0, size));
+
+    // The neighbours of the read-only page must still be writable.
+    middle[-1] = 0xaa;
+    middle[PAGE_SIZE] = 0xbb;
+    EXPECT_EQ(middle[-1], 0xaa);
+    EXPECT_EQ(middle[PAGE_SIZE], 0xbb);
+
+    EXPECT_EQ(munmap(data, size), 0);
+}
+
+TEST_CASE(munmap_of_a_single_page_keeps_the_rest)
+{
+    constexpr size_t size = 4 * MiB;
+    auto* data = map_anonymous(size);
+    fill_pattern(data, size);
+
+    size_t hole_offset = large_page_size / 2;
+    EXPECT_EQ(munmap(data + hole_offset, PAGE_SIZE), 0);
+    EXPECT(matches_pattern(data, 0, hole_offset));
+    EXPECT(matches_pattern(data, hole_offset + PAGE_SIZE, size - hole_offset - PAGE_SIZE));
+
+    EXPECT_EQ(munmap(data, hole_offset), 0);
+    EXPECT_EQ(munmap(data + hole_offset + PAGE_SIZE, size - hole_offset - PAGE_SIZE), 0);
+}
+
+TEST_CASE(fork_copies_large_pages_on_write)
+{
+    constexpr size_t size = 4 * MiB;
+    auto* data = map_anonymous(size);
+    fill_pattern(data, size);
+
+    pid_t pid = fork();
+    VERIFY(pid >= 0);
+    if (pid == 0) {
+        bool ok = matches_pattern(data, 0, size);
+        memset(data, 0xff, size);
+        _exit(ok ? 0 : 1);
+    }
+
+    int status = 0;
+    EXPECT_EQ(waitpid(pid, &status, 0), pid);
+    EXPECT(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    EXPECT(matches_pattern(data, 0, size));
+
+    EXPECT_EQ(munmap(data, size), 0);
+}
+
+TEST_CASE(madvise_hugepage_hints)
+{
+    constexpr size_t size = 4 * MiB;
+    auto* data = map_anonymous(size);
+    fill_pattern(data, size);
+
+    EXPECT_EQ(madvise(data, size, MADV_NOHUGEPAGE), 0);
+    EXPECT(matches_pattern(data, 0, size));
+    EXPECT_EQ(madvise(data, size, MADV_HUGEPAGE), 0);
+    EXPECT(matches_pattern(data, 0, size));
+
+    auto* shared = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_SHARED, -1, 0);
+    EXPECT(shared != MAP_FAILED);
+    EXPECT_EQ(madvise(shared, size, MADV_HUGEPAGE), -1);
+    EXPECT_EQ(errno, EINVAL);
+
+    EXPECT_EQ(munmap(shared, size), 0);
+    EXPECT_EQ(munmap(data, size), 0);
+}
+
+// Touches every page of a large mapping once. With large pages that is one fault per 2 MiB instead of
+// one per 4 KiB, and the TLB covers all of it when we read it back.
+BENCHMARK_CASE(touch_128_mib)
+{
+    constexpr size_t size = 128 * MiB;
+    auto* data = map_anonymous(size);
+    for (size_t i = 0; i < size; i += PAGE_SIZE)
+        data[i] = 1;
+
+    u64 sum = 0;
+    for (int pass = 0; pass < 4; ++pass) {
+        for (size_t i = 0; i < size; i += PAGE_SIZE)
+            sum += data[i];
+    }
+    EXPECT_EQ(sum, 4 * (size / PAGE_SIZE));
+
+    EXPECT_EQ(munmap(data, size), 0);
+}
@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Vector.h>
+#include <LibTest/TestCase.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+
+// Every thread moves the same number of small buffers from /dev/zero to /dev/null
+// through its own descriptors, so the per-thread work is constant. If read() and write()
+// scale across threads of one process, the wall time of these benchmarks should stay
+// roughly flat as the thread count goes up (up to the number of CPUs), instead of
+// growing linearly like it does when every syscall serializes on the process big lock.
+
+static constexpr size_t iterations_per_thread = 100'000;
+
+static void* copy_zeroes_to_null(void*)
+{
+    int zero_fd = open("/dev/zero", O_RDONLY);
+    VERIFY(zero_fd >= 0);
+    int null_fd = open("/dev/null", O_WRONLY);
+    VERIFY(null_fd >= 0);
+
+    u8 buffer[64];
+    for (size_t i = 0; i < iterations_per_thread; ++i) {
+        VERIFY(read(zero_fd, buffer, sizeof(buffer)) == sizeof(buffer));
+        VERIFY(write(null_fd, buffer, sizeof(buffer)) == sizeof(buffer));
+    }
+
+    close(zero_fd);
+    close(null_fd);
+    return nullptr;
+}
+
+static void run_threads(size_t thread_count)
+{
+    Vector<pthread_t> threads;
+    threads.resize(thread_count);
+    for (auto& thread : threads)
+        VERIFY(pthread_create(&thread, nullptr, copy_zeroes_to_null, nullptr) == 0);
+    for (auto& thread : threads)
+        VERIFY(pthread_join(thread, nullptr) == 0);
+}
+
+BENCHMARK_CASE(read_write_1_thread)
+{
+    run_threads(1);
+}
+
+BENCHMARK_CASE(read_write_2_threads)
+{
+    run_threads(2);
+}
+
+BENCHMARK_CASE(read_write_4_threads)
+{
+    run_threads(4);
+}
+
+BENCHMARK_CASE(read_write_8_threads)
+{
+    run_threads(8);
+}
@@ -0,0 +1,215 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Vector.h>
+#include <LibTest/TestCase.h>
+#include <errno.h>
+#include <poll.h>
+#include <serenity.h>
+#include <unistd.h>
+
+static constexpr timespec zero_timeout = { 0, 0 };
+
+TEST_CASE(reports_only_ready_descriptors)
+{
+    int set_fd = create_readiness_set(READINESS_SET_CLOEXEC);
+    EXPECT(set_fd >= 0);
+
+    int first[2];
+    int second[2];
+    EXPECT_EQ(pipe(first), 0);
+    EXPECT_EQ(pipe(second), 0);
+
+    EXPECT_EQ(readiness_set_control(set_fd, READINESS_SET_ADD, first[0], READINESS_READ, 1), 0);
+    EXPECT_EQ(readiness_set_control(set_fd, READINESS_SET_ADD, second[0], READINESS_READ, 2), 0);
+
+    readiness_event events[4];
+    EXPECT_EQ(readiness_set_wait(set_fd, events, 4, &zero_timeout), 0);
+
+    EXPECT_EQ(write(second[1], "x", 1), 1);
+    EXPECT_EQ(readiness_set_wait(set_fd, events, 4, &zero_timeout), 1);
+    EXPECT_EQ(events[0].fd, second[0]);
+    EXPECT_EQ(events[0].events, (u32)READINESS_READ);
+    EXPECT_EQ(events[0].user_data, 2u);
+
+    // Level-triggered: still readable, so it is reported again.
+    EXPECT_EQ(readiness_set_wait(set_fd, events, 4, &zero_timeout), 1);
+
+    char buffer;
+    EXPECT_EQ(read(second[0], &buffer, 1), 1);
+    EXPECT_EQ(readiness_set_wait(set_fd, events, 4, &zero_timeout), 0);
+
+    close(first[0]);
+    close(first[1]);
+    close(second[0]);
+    close(second[1]);
+    close(set_fd);
+}
+
+TEST_CASE(edge_triggered_reports_once)
+{
+    int set_fd = create_readiness_set(READINESS_SET_CLOEXEC);
+    int fds[2];
+    EXPECT_EQ(pipe(fds), 0);
+    EXPECT_EQ(readiness_set_control(set_fd, READINESS_SET_ADD, fds[0], READINESS_READ | READINESS_EDGE_TRIGGERED, 0), 0);
+
+    readiness_event events[2];
+    EXPECT_EQ(write(fds[1], "x", 1), 1);
+    EXPECT_EQ(readiness_set_wait(set_fd, events, 2, &zero_timeout), 1);
+    EXPECT_EQ(readiness_set_wait(set_fd, events, 2, &zero_timeout), 0);
+
+    EXPECT_EQ(write(fds[1], "y", 1), 1);
+    EXPECT_EQ(readiness_set_wait(set_fd, events, 2, &zero_timeout), 1);
+
+    close(fds[0]);
+    close(fds[1]);
+    close(set_fd);
+}
+
+TEST_CASE(control_errors)
+{
+    int set_fd = create_readiness_set(0);
+    int fds[2];
+    EXPECT_EQ(pipe(fds), 0);
+
+    EXPECT_EQ(readiness_set_control(set_fd, READINESS_SET_MODIFY, fds[0], READINESS_READ, 0), -1);
+    EXPECT_EQ(errno, ENOENT);
+
+    EXPECT_EQ(readiness_set_control(set_fd, READINESS_SET_ADD, fds[0], READINESS_READ, 0), 0);
+    EXPECT_EQ(readiness_set_control(set_fd, READINESS_SET_ADD, fds[0], READINESS_READ, 0), -1);
+    EXPECT_EQ(errno, EEXIST);
+
+    EXPECT_EQ(readiness_set_control(set_fd, READINESS_SET_ADD, set_fd, READINESS_READ, 0), -1);
+    EXPECT_EQ(errno, EINVAL);
+
+    EXPECT_EQ(readiness_set_control(set_fd, READINESS_SET_REMOVE, fds[0], 0, 0), 0);
+    EXPECT_EQ(readiness_set_control(set_fd, READINESS_SET_REMOVE, fds[0], 0, 0), -1);
+    EXPECT_EQ(errno, ENOENT);
+
+    close(fds[0]);
+    close(fds[1]);
+    close(set_fd);
+}
+
+TEST_CASE(closed_descriptor_is_dropped)
+{
+    int set_fd = create_readiness_set(0);
+    int fds[2];
+    EXPECT_EQ(pipe(fds), 0);
+    EXPECT_EQ(readiness_set_control(set_fd, READINESS_SET_ADD, fds[1], READINESS_WRITE, 0), 0);
+
+    // Closing the fd must not keep the pipe alive through the set, and the fd number can be re-added.
+    close(fds[1]);
+    readiness_event event;
+    EXPECT_EQ(readiness_set_wait(set_fd, &event, 1, &zero_timeout), 0);
+
+    char buffer;
+    EXPECT_EQ(read(fds[0], &buffer, 1), 0);
+
+    close(fds[0]);
+    close(set_fd);
+}
+
+// Wakeup latency: N descriptors are watched, one of them becomes readable, and we measure
+// how long it takes to find out. poll() has to look at every descriptor on each call,
+// while the readiness set only looks at the one that changed.
+// NOTE: A process can't have more than FD_SETSIZE open descriptors, so this tops out at 1000.
+
+static constexpr int wakeup_iterations = 1000;
+
+struct WatchedPipes {
+    explicit WatchedPipes(size_t descriptor_count)
+    {
+        for (size_t i = 0; i < descriptor_count / 2; ++i) {
+            int fds[2];
+            VERIFY(pipe(fds) == 0);
+            read_fds.append(fds[0]);
+            write_fds.append(fds[1]);
+        }
+    }
+
+    ~WatchedPipes()
+    {
+        for (auto fd : read_fds)
+            close(fd);
+        for (auto fd : write_fds)
+            close(fd);
+    }
+
+    Vector<int> read_fds;
+    Vector<int> write_fds;
+};
+
+static void benchmark_poll_wakeups(size_t descriptor_count)
+{
+    WatchedPipes pipes(descriptor_count);
+    Vector<pollfd> pollfds;
+    for (auto fd : pipes.read_fds)
+        pollfds.append({ fd, POLLIN, 0 });
+    for (auto fd : pipes.write_fds)
+        pollfds.append({ fd, 0, 0 });
+
+    for (int i = 0; i < wakeup_iterations; ++i) {
+        auto index = i % pipes.read_fds.size();
+        VERIFY(write(pipes.write_fds[index], "x", 1) == 1);
+        VERIFY(poll(pollfds.data(), pollfds.size(), -1) == 1);
+        char buffer;
+        VERIFY(read(pipes.read_fds[index], &buffer, 1) == 1);
+    }
+}
+
+static void benchmark_readiness_set_wakeups(size_t descriptor_count)
+{
+    WatchedPipes pipes(descriptor_count);
+    int set_fd = create_readiness_set(READINESS_SET_CLOEXEC);
+    VERIFY(set_fd >= 0);
+    for (auto fd : pipes.read_fds)
+        VERIFY(readiness_set_control(set_fd, READINESS_SET_ADD, fd, READINESS_READ, 0) == 0);
+    // Like in the poll() benchmark, the write ends are watched without any interest so both look at the same number of fds.
+    for (auto fd : pipes.write_fds)
+        VERIFY(readiness_set_control(set_fd, READINESS_SET_ADD, fd, 0, 0) == 0);
+
+    for (int i = 0; i < wakeup_iterations; ++i) {
+        auto index = i % pipes.read_fds.size();
+        VERIFY(write(pipes.write_fds[index], "x", 1) == 1);
+        readiness_event event;
+        VERIFY(readiness_set_wait(set_fd, &event, 1, nullptr) == 1);
+        VERIFY(event.fd == pipes.read_fds[index]);
+        char buffer;
+        VERIFY(read(pipes.read_fds[index], &buffer, 1) == 1);
+    }
+    close(set_fd);
+}
+
+BENCHMARK_CASE(poll_wakeup_10_fds)
+{
+    benchmark_poll_wakeups(10);
+}
+
+BENCHMARK_CASE(readiness_set_wakeup_10_fds)
+{
+    benchmark_readiness_set_wakeups(10);
+}
+
+BENCHMARK_CASE(poll_wakeup_100_fds)
+{
+    benchmark_poll_wakeups(100);
+}
+
+BENCHMARK_CASE(readiness_set_wakeup_100_fds)
+{
+    benchmark_readiness_set_wakeups(100);
+}
+
+BENCHMARK_CASE(poll_wakeup_1000_fds)
+{
+    benchmark_poll_wakeups(1000);
+}
+
+BENCHMARK_CASE(readiness_set_wakeup_1000_fds)
+{
+    benchmark_readiness_set_wakeups(1000);
+}
@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Vector.h>
+#include <LibTest/TestCase.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <string.h>
+#include <sys/sendfile.h>
+#include <unistd.h>
+
+static constexpr char const* test_path = "/tmp/sendfile-test";
+static constexpr char const test_data[] = "Well hello friends!";
+
+static int create_test_file()
+{
+    int fd = open(test_path, O_CREAT | O_TRUNC | O_RDWR, 0644);
+    VERIFY(fd >= 0);
+    VERIFY(write(fd, test_data, strlen(test_data)) == (ssize_t)strlen(test_data));
+    VERIFY(lseek(fd, 0, SEEK_SET) == 0);
+    return fd;
+}
+
+TEST_CASE(file_to_pipe_advances_file_offset)
+{
+    int file_fd = create_test_file();
+    int pipe_fds[2];
+    EXPECT_EQ(pipe(pipe_fds), 0);
+
+    EXPECT_EQ(sendfile(pipe_fds[1], file_fd, nullptr, 5), 5);
+    EXPECT_EQ(lseek(file_fd, 0, SEEK_CUR), 5);
+    EXPECT_EQ(sendfile(pipe_fds[1], file_fd, nullptr, 1024), (ssize_t)strlen(test_data) - 5);
+    EXPECT_EQ(sendfile(pipe_fds[1], file_fd, nullptr, 1024), 0);
+
+    char buffer[64] {};
+    EXPECT_EQ(read(pipe_fds[0], buffer, sizeof(buffer)), (ssize_t)strlen(test_data));
+    EXPECT_EQ(memcmp(buffer, test_data, strlen(test_data)), 0);
+
+    close(pipe_fds[0]);
+    close(pipe_fds[1]);
+    close(file_fd);
+    unlink(test_path);
+}
+
+TEST_CASE(explicit_offset_leaves_file_offset_alone)
+{
+    int file_fd = create_test_file();
+    int pipe_fds[2];
+    EXPECT_EQ(pipe(pipe_fds), 0);
+
+    off_t offset = 5;
+    EXPECT_EQ(sendfile(pipe_fds[1], file_fd, &offset, 5), 5);
+    EXPECT_EQ(offset, 10);
+    EXPECT_EQ(lseek(file_fd, 0, SEEK_CUR), 0);
+
+    char buffer[5];
+    EXPECT_EQ(read(pipe_fds[0], buffer, sizeof(buffer)), 5);
+    EXPECT_EQ(memcmp(buffer, test_data + 5, 5), 0);
+
+    close(pipe_fds[0]);
+    close(pipe_fds[1]);
+    close(file_fd);
+    unlink(test_path);
+}
+
+TEST_CASE(source_must_be_a_regular_file)
+{
+    int pipe_fds[2];
+    EXPECT_EQ(pipe(pipe_fds), 0);
+
+    EXPECT_EQ(sendfile(pipe_fds[1], pipe_fds[0], nullptr, 1), -1);
+    EXPECT_EQ(errno, EINVAL);
+
+    close(pipe_fds[0]);
+    close(pipe_fds[1]);
+}
+
+static constexpr size_t shared_chunk_size = 4096;
+static constexpr size_t shared_chunk_count = 256;
+static constexpr size_t shared_thread_count = 4;
+
+struct SharedSourceSender {
+    int source_fd { -1 };
+    int destination_fd { -1 };
+    size_t nsent { 0 };
+};
+
+static void* send_shared_source_until_eof(void* data)
+{
+    auto& sender = *static_cast<SharedSourceSender*>(data);
+    for (;;) {
+        auto nsent = sendfile(sender.destination_fd, sender.source_fd, nullptr, shared_chunk_size);
+        VERIFY(nsent >= 0);
+        if (nsent == 0)
+            return nullptr;
+        sender.nsent += nsent;
+    }
+}
+
+TEST_CASE(threads_sharing_a_source_never_send_the_same_chunk_twice)
+{
+    // Every chunk of the source is filled with its own index, so we can tell which ones ended up where.
+    int source_fd = open(test_path, O_CREAT | O_TRUNC | O_RDWR, 0644);
+    VERIFY(source_fd >= 0);
+    Vector<u32> chunk;
+    chunk.resize(shared_chunk_size / sizeof(u32));
+    for (u32 i = 0; i < shared_chunk_count; ++i) {
+        for (auto& value : chunk)
+            value = i;
+        VERIFY(write(source_fd, chunk.data(), shared_chunk_size) == (ssize_t)shared_chunk_size);
+    }
+    VERIFY(lseek(source_fd, 0, SEEK_SET) == 0);
+
+    SharedSourceSender senders[shared_thread_count];
+    pthread_t threads[shared_thread_count];
+    for (size_t i = 0; i < shared_thread_count; ++i) {
+        char destination_path[] = "/tmp/sendfile-test-destination.XXXXXX";
+        senders[i].source_fd = source_fd;
+        senders[i].destination_fd = mkstemp(destination_path);
+        VERIFY(senders[i].destination_fd >= 0);
+        unlink(destination_path);
+        EXPECT_EQ(pthread_create(&threads[i], nullptr, send_shared_source_until_eof, &senders[i]), 0);
+    }
+    for (auto thread : threads)
+        EXPECT_EQ(pthread_join(thread, nullptr), 0);
+
+    // Together, the threads must have sent every chunk exactly once, each in one piece.
+    Vector<size_t> times_sent;
+    times_sent.resize(shared_chunk_count);
+    size_t total_nsent = 0;
+    for (auto& sender : senders) {
+        total_nsent += sender.nsent;
+        VERIFY(lseek(sender.destination_fd, 0, SEEK_SET) == 0);
+        for (size_t i = 0; i < sender.nsent / shared_chunk_size; ++i) {
+            VERIFY(read(sender.destination_fd, chunk.data(), shared_chunk_size) == (ssize_t)shared_chunk_size);
+            EXPECT(chunk.first() < shared_chunk_count);
+            EXPECT_EQ(chunk.first(), chunk.last());
+            if (chunk.first() < shared_chunk_count)
+                ++times_sent[chunk.first()];
+        }
+        close(sender.destination_fd);
+    }
+    EXPECT_EQ(total_nsent, shared_chunk_count * shared_chunk_size);
+    for (auto count : times_sent)
+        EXPECT_EQ(count, 1u);
+    EXPECT_EQ(lseek(source_fd, 0, SEEK_CUR), (off_t)(shared_chunk_count * shared_chunk_size));
+
+    close(source_fd);
+    unlink(test_path);
+}
@@ -0,0 +1,221 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/ByteBuffer.h>
+#include <AK/Format.h>
+#include <AK/Vector.h>
+#include <LibTest/TestCase.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// NOTE: These run over the loopback adapter, which never drops anything. Loss recovery is
+//       still exercised by the slow reader, whose full receive buffer makes us drop segments.
+
+static u8 pattern_byte(size_t offset)
+{
+    return static_cast<u8>((offset * 7) ^ (offset >> 11));
+}
+
+static int listen_on_loopback(u16& port)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    VERIFY(fd >= 0);
+    sockaddr_in address {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = 0;
+    VERIFY(bind(fd, (sockaddr const*)&address, sizeof(address)) == 0);
+    VERIFY(listen(fd, 1) == 0);
+    socklen_t address_length = sizeof(address);
+    VERIFY(getsockname(fd, (sockaddr*)&address, &address_length) == 0);
+    port = ntohs(address.sin_port);
+    return fd;
+}
+
+// Connects to the given port in a child process and sends `size` bytes of the test pattern.
+static pid_t send_pattern_from_child(u16 port, size_t size)
+{
+    pid_t pid = fork();
+    VERIFY(pid >= 0);
+    if (pid != 0)
+        return pid;
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(port);
+    if (fd < 0 || connect(fd, (sockaddr const*)&address, sizeof(address)) < 0)
+        _exit(1);
+
+    u8 buffer[16 * KiB];
+    for (size_t offset = 0; offset < size;) {
+        auto chunk_size = min(sizeof(buffer), size - offset);
+        for (size_t i = 0; i < chunk_size; ++i)
+            buffer[i] = pattern_byte(offset + i);
+        auto nwritten = write(fd, buffer, chunk_size);
+        if (nwritten <= 0)
+            _exit(1);
+        offset += nwritten;
+    }
+    close(fd);
+    _exit(0);
+}
+
+// Returns the number of bytes received, and whether they all matched the pattern.
+static size_t receive_pattern(int fd, size_t read_size, useconds_t delay_between_reads, bool& matched)
+{
+    auto buffer = ByteBuffer::create_uninitialized(read_size).release_value();
+    size_t total = 0;
+    matched = true;
+    for (;;) {
+        auto nread = read(fd, buffer.data(), buffer.size());
+        if (nread <= 0)
+            break;
+        for (ssize_t i = 0; i < nread; ++i) {
+            if (buffer[i] != pattern_byte(total + i))
+                matched = false;
+        }
+        total += nread;
+        if (delay_between_reads)
+            usleep(delay_between_reads);
+    }
+    return total;
+}
+
+static void transfer_and_verify(size_t size, size_t read_size, useconds_t delay_between_reads)
+{
+    u16 port = 0;
+    int listen_fd = listen_on_loopback(port);
+    pid_t pid = send_pattern_from_child(port, size);
+
+    int fd = accept(listen_fd, nullptr, nullptr);
+    EXPECT(fd >= 0);
+    bool matched = false;
+    EXPECT_EQ(receive_pattern(fd, read_size, delay_between_reads, matched), size);
+    EXPECT(matched);
+
+    int status = 0;
+    EXPECT_EQ(waitpid(pid, &status, 0), pid);
+    EXPECT(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    close(fd);
+    close(listen_fd);
+}
+
+TEST_CASE(bulk_transfer_arrives_intact)
+{
+    // More than fits into an unscaled 64 KiB window many times over.
+    transfer_and_verify(8 * MiB, 64 * KiB, 0);
+}
+
+TEST_CASE(slow_reader_closes_and_reopens_the_window)
+{
+    // The sender keeps running into a full receive buffer, and has to wait for window updates.
+    transfer_and_verify(2 * MiB, 4 * KiB, 1000);
+}
+
+TEST_CASE(connection_negotiates_window_scaling_and_sack)
+{
+    u16 port = 0;
+    int listen_fd = listen_on_loopback(port);
+    pid_t pid = send_pattern_from_child(port, 1 * MiB);
+    int fd = accept(listen_fd, nullptr, nullptr);
+    EXPECT(fd >= 0);
+
+    int proc_fd = open("/proc/net/tcp", O_RDONLY);
+    EXPECT(proc_fd >= 0);
+    auto contents = ByteBuffer::create_zeroed(256 * KiB).release_value();
+    auto nread = read(proc_fd, contents.data(), contents.size() - 1);
+    EXPECT(nread > 0);
+    close(proc_fd);
+    EXPECT(strstr((char const*)contents.data(), "\"window_scaling\":true") != nullptr);
+    EXPECT(strstr((char const*)contents.data(), "\"sack\":true") != nullptr);
+
+    bool matched = false;
+    EXPECT_EQ(receive_pattern(fd, 64 * KiB, 0, matched), 1 * MiB);
+    EXPECT_EQ(waitpid(pid, nullptr, 0), pid);
+    close(fd);
+    close(listen_fd);
+}
+
+BENCHMARK_CASE(loopback_throughput)
+{
+    transfer_and_verify(128 * MiB, 256 * KiB, 0);
+}
+
+// Every connection is its own flow, so their packets get spread over the network workers.
+// On an SMP guest this should take about as long as a single transfer, as long as there are enough CPUs.
+static void run_parallel_transfers(size_t connection_count, size_t size)
+{
+    Vector<pid_t> receivers;
+    for (size_t i = 0; i < connection_count; ++i) {
+        pid_t pid = fork();
+        VERIFY(pid >= 0);
+        if (pid == 0) {
+            u16 port = 0;
+            int listen_fd = listen_on_loopback(port);
+            pid_t sender = send_pattern_from_child(port, size);
+            int fd = accept(listen_fd, nullptr, nullptr);
+            bool matched = false;
+            bool ok = fd >= 0 && receive_pattern(fd, 64 * KiB, 0, matched) == size && matched;
+            int status = 0;
+            ok = ok && waitpid(sender, &status, 0) == sender && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+            _exit(ok ? 0 : 1);
+        }
+        receivers.append(pid);
+    }
+    for (auto pid : receivers) {
+        int status = 0;
+        EXPECT_EQ(waitpid(pid, &status, 0), pid);
+        EXPECT(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    }
+}
+
+TEST_CASE(parallel_connections_arrive_intact)
+{
+    run_parallel_transfers(8, 1 * MiB);
+}
+
+BENCHMARK_CASE(parallel_loopback_throughput)
+{
+    run_parallel_transfers(4, 32 * MiB);
+}
+
+// Compares network adapters under QEMU's user mode networking, where 10.0.2.2 is the host.
+// Start a sink on the host first (e.g. `nc -l 127.0.0.1 8891 > /dev/null`), then run this once with
+// SERENITY_ETHERNET_DEVICE_TYPE=e1000 and once with SERENITY_ETHERNET_DEVICE_TYPE=virtio-net-pci.
+BENCHMARK_CASE(host_throughput)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    EXPECT(fd >= 0);
+    sockaddr_in address {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = inet_addr("10.0.2.2");
+    address.sin_port = htons(8891);
+    if (connect(fd, (sockaddr const*)&address, sizeof(address)) < 0) {
+        warnln("Skipping, nothing is listening on 10.0.2.2:8891");
+        close(fd);
+        return;
+    }
+
+    constexpr size_t size = 256 * MiB;
+    auto buffer = ByteBuffer::create_uninitialized(256 * KiB).release_value();
+    for (size_t i = 0; i < buffer.size(); ++i)
+        buffer[i] = pattern_byte(i);
+    for (size_t offset = 0; offset < size;) {
+        auto nwritten = write(fd, buffer.data(), min(buffer.size(), size - offset));
+        EXPECT(nwritten > 0);
+        if (nwritten <= 0)
+            break;
+        offset += nwritten;
+    }
+    close(fd);
+}
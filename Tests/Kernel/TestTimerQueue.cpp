@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Atomic.h>
+#include <AK/Vector.h>
+#include <LibCore/ElapsedTimer.h>
+#include <LibTest/TestCase.h>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+
+static constexpr size_t sleeper_count = 16;
+static Atomic<size_t> s_wakeup_sequence;
+
+static void* sleep_and_record_order(void* argument)
+{
+    auto rank = reinterpret_cast<FlatPtr>(argument);
+    // The lowest rank sleeps the shortest, so it must wake up first.
+    usleep((rank + 1) * 15'000);
+    auto position = s_wakeup_sequence.fetch_add(1);
+    return reinterpret_cast<void*>(position == rank ? 1 : 0);
+}
+
+TEST_CASE(timers_expire_in_order)
+{
+    s_wakeup_sequence = 0;
+    Vector<pthread_t> threads;
+    threads.resize(sleeper_count);
+    // Arm the timers in reverse order of expiry, so insertion order doesn't help.
+    for (size_t i = 0; i < sleeper_count; ++i) {
+        auto rank = static_cast<FlatPtr>(sleeper_count - 1 - i);
+        EXPECT_EQ(pthread_create(&threads[i], nullptr, sleep_and_record_order, reinterpret_cast<void*>(rank)), 0);
+    }
+    for (auto& thread : threads) {
+        void* in_order = nullptr;
+        EXPECT_EQ(pthread_join(thread, &in_order), 0);
+        EXPECT(in_order != nullptr);
+    }
+}
+
+static void expect_sleep_within(u64 requested_ms)
+{
+    Core::ElapsedTimer timer { true };
+    timer.start();
+    usleep(requested_ms * 1000);
+    auto elapsed_ms = static_cast<u64>(timer.elapsed_time().to_milliseconds());
+    EXPECT(elapsed_ms >= requested_ms);
+    EXPECT(elapsed_ms < requested_ms + 100);
+}
+
+TEST_CASE(long_timeouts_are_not_early)
+{
+    // These land on higher levels of the timer wheel and get cascaded down before they fire.
+    expect_sleep_within(300);
+    expect_sleep_within(1500);
+}
+
+static int s_wakeup_pipe[2];
+
+static void* wait_for_wakeup(void* argument)
+{
+    pollfd pfd { s_wakeup_pipe[0], POLLIN, 0 };
+    poll(&pfd, 1, static_cast<int>(reinterpret_cast<FlatPtr>(argument)));
+    return nullptr;
+}
+
+// Keeps a few dozen long timeouts pending while alarm() re-arms the process timer 100k times.
+// Every call cancels the previous timer and queues a new one, so this measures both operations.
+BENCHMARK_CASE(arm_and_cancel_100k_timers)
+{
+    constexpr size_t background_thread_count = 64;
+    constexpr size_t iterations = 100'000;
+
+    EXPECT_EQ(pipe(s_wakeup_pipe), 0);
+    Vector<pthread_t> threads;
+    threads.resize(background_thread_count);
+    for (size_t i = 0; i < background_thread_count; ++i) {
+        auto timeout_ms = static_cast<FlatPtr>(10'000 + (i % 7) * 10'000);
+        EXPECT_EQ(pthread_create(&threads[i], nullptr, wait_for_wakeup, reinterpret_cast<void*>(timeout_ms)), 0);
+    }
+
+    for (size_t i = 0; i < iterations; ++i)
+        alarm(1 + i % 3600);
+    alarm(0);
+
+    EXPECT_EQ(write(s_wakeup_pipe[1], "x", 1), 1);
+    for (auto& thread : threads)
+        EXPECT_EQ(pthread_join(thread, nullptr), 0);
+    close(s_wakeup_pipe[0]);
+    close(s_wakeup_pipe[1]);
+}
@@ -371,6 +371,78 @@ TEST_CASE(writev)
     close(pipefds[1]);
 }
 
+TEST_CASE(positional_io_leaves_offset_alone)
+{
+    char path[] = "/tmp/positional_io.XXXXXX";
+    int fd = mkstemp(path);
+    EXPECT(fd >= 0);
+    unlink(path);
+
+    EXPECT_EQ(write(fd, "0123456789", 10), 10);
+    EXPECT_EQ(pwrite(fd, "abc", 3, 2), 3);
+    EXPECT_EQ(lseek(fd, 0, SEEK_CUR), 10);
+
+    iovec write_iov[2];
+    write_iov[0].iov_base = const_cast<void*>((const void*)"Hello");
+    write_iov[0].iov_len = 5;
+    write_iov[1].iov_base = const_cast<void*>((const void*)"Friends");
+    write_iov[1].iov_len = 7;
+    EXPECT_EQ(pwritev(fd, write_iov, 2, 20), 12);
+    EXPECT_EQ(lseek(fd, 0, SEEK_CUR), 10);
+
+    char first[4] {};
+    char second[9] {};
+    iovec read_iov[2];
+    read_iov[0].iov_base = first;
+    read_iov[0].iov_len = 3;
+    read_iov[1].iov_base = second;
+    read_iov[1].iov_len = 8;
+    EXPECT_EQ(preadv(fd, read_iov, 2, 21), 11);
+    EXPECT_EQ(first, "ell"sv);
+    EXPECT_EQ(second, "oFriends"sv);
+
+    // Reads stop at the end of the file.
+    EXPECT_EQ(preadv(fd, read_iov, 2, 30), 2);
+    EXPECT_EQ(lseek(fd, 0, SEEK_CUR), 10);
+
+    char buffer[11] {};
+    EXPECT_EQ(pread(fd, buffer, 10, 0), 10);
+    EXPECT_EQ(buffer, "01abc56789"sv);
+
+    close(fd);
+}
+
+TEST_CASE(positional_write_ignores_append)
+{
+    char path[] = "/tmp/positional_append.XXXXXX";
+    int fd = mkstemp(path);
+    EXPECT(fd >= 0);
+    EXPECT_EQ(write(fd, "0123456789", 10), 10);
+    close(fd);
+
+    fd = open(path, O_RDWR | O_APPEND);
+    EXPECT(fd >= 0);
+    unlink(path);
+    EXPECT_EQ(pwrite(fd, "xy", 2, 4), 2);
+    char buffer[11] {};
+    EXPECT_EQ(pread(fd, buffer, 10, 0), 10);
+    EXPECT_EQ(buffer, "0123xy6789"sv);
+    close(fd);
+}
+
+TEST_CASE(positional_io_on_pipe)
+{
+    int pipefds[2];
+    EXPECT_EQ(pipe(pipefds), 0);
+    EXPECT_EQ(pwrite(pipefds[1], "x", 1, 0), -1);
+    EXPECT_EQ(errno, EINVAL);
+    char buffer[1];
+    EXPECT_EQ(pread(pipefds[0], buffer, 1, 0), -1);
+    EXPECT_EQ(errno, EINVAL);
+    close(pipefds[0]);
+    close(pipefds[1]);
+}
+
 TEST_CASE(rmdir_root)
 {
     int rc = rmdir("/");
@@ -0,0 +1,318 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Array.h>
+#include <AK/NumericLimits.h>
+#include <LibTest/TestCase.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// This file is built with -fno-builtin, so every call below really ends up in LibC.
+
+static constexpr size_t max_tested_size = 300;
+static constexpr size_t max_tested_offset = 64;
+static constexpr size_t buffer_size = max_tested_size + 2 * max_tested_offset;
+
+static constexpr Array<size_t, 7> benchmark_sizes = { 8, 32, 128, 512, 4096, 64 * KiB, 1 * MiB };
+static constexpr Array<size_t, 4> benchmark_alignments = { 0, 1, 7, 31 };
+// Leaves room for the largest size at the largest alignment.
+static constexpr size_t benchmark_buffer_size = 1 * MiB + 64;
+static constexpr size_t benchmark_bytes_per_run = 256 * MiB;
+
+static void fill_with_pattern(u8* buffer, size_t size, u8 seed)
+{
+    for (size_t i = 0; i < size; ++i)
+        buffer[i] = static_cast<u8>(seed + i * 7 + 1);
+}
+
+// Returns two pages, where the second one is inaccessible. Anything placed right before
+// the guard page crashes the test if a function reads past the end of its input.
+static u8* allocate_guarded_page()
+{
+    auto page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    auto* pages = static_cast<u8*>(mmap(nullptr, 2 * page_size, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0));
+    VERIFY(pages != MAP_FAILED);
+    VERIFY(mprotect(pages + page_size, page_size, PROT_NONE) == 0);
+    return pages;
+}
+
+static void free_guarded_page(u8* pages)
+{
+    auto page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    VERIFY(munmap(pages, 2 * page_size) == 0);
+}
+
+TEST_CASE(memcpy_sizes_and_alignments)
+{
+    u8 source[buffer_size];
+    u8 destination[buffer_size];
+    u8 expected[buffer_size];
+    fill_with_pattern(source, buffer_size, 0);
+
+    for (size_t size = 0; size <= max_tested_size; ++size) {
+        for (size_t source_offset = 0; source_offset < max_tested_offset; source_offset += 5) {
+            for (size_t destination_offset = 0; destination_offset < max_tested_offset; destination_offset += 3) {
+                fill_with_pattern(destination, buffer_size, 0x55);
+                fill_with_pattern(expected, buffer_size, 0x55);
+                for (size_t i = 0; i < size; ++i)
+                    expected[destination_offset + i] = source[source_offset + i];
+
+                EXPECT_EQ(memcpy(destination + destination_offset, source + source_offset, size), destination + destination_offset);
+                for (size_t i = 0; i < buffer_size; ++i)
+                    EXPECT_EQ(destination[i], expected[i]);
+            }
+        }
+    }
+}
+
+TEST_CASE(memmove_overlapping)
+{
+    u8 buffer[buffer_size];
+    u8 expected[buffer_size];
+
+    for (size_t size = 0; size <= max_tested_size; ++size) {
+        for (size_t source_offset = 0; source_offset < max_tested_offset; source_offset += 3) {
+            for (size_t destination_offset = 0; destination_offset < max_tested_offset; destination_offset += 3) {
+                fill_with_pattern(buffer, buffer_size, 0);
+                fill_with_pattern(expected, buffer_size, 0);
+                // Copy through a temporary so the reference is correct in both directions.
+                u8 temporary[max_tested_size];
+                for (size_t i = 0; i < size; ++i)
+                    temporary[i] = buffer[source_offset + i];
+                for (size_t i = 0; i < size; ++i)
+                    expected[destination_offset + i] = temporary[i];
+
+                EXPECT_EQ(memmove(buffer + destination_offset, buffer + source_offset, size), buffer + destination_offset);
+                for (size_t i = 0; i < buffer_size; ++i)
+                    EXPECT_EQ(buffer[i], expected[i]);
+            }
+        }
+    }
+}
+
+TEST_CASE(memset_sizes_and_alignments)
+{
+    u8 buffer[buffer_size];
+
+    for (size_t size = 0; size <= max_tested_size; ++size) {
+        for (size_t offset = 0; offset < max_tested_offset; ++offset) {
+            memset(buffer, 0x11, buffer_size);
+            EXPECT_EQ(memset(buffer + offset, 0x1ab, size), buffer + offset);
+            for (size_t i = 0; i < buffer_size; ++i) {
+                bool inside = i >= offset && i < offset + size;
+                EXPECT_EQ(buffer[i], inside ? 0xab : 0x11);
+            }
+        }
+    }
+}
+
+TEST_CASE(memcmp_finds_first_difference)
+{
+    u8 first[buffer_size];
+    u8 second[buffer_size];
+    fill_with_pattern(first, buffer_size, 0);
+
+    for (size_t size = 0; size <= max_tested_size; ++size) {
+        for (size_t offset = 0; offset < max_tested_offset; offset += 7) {
+            memcpy(second, first, buffer_size);
+            EXPECT_EQ(memcmp(first + offset, second + offset, size), 0);
+            for (size_t difference = 0; difference < size; difference += 13) {
+                // A second difference further along must not affect the result.
+                second[offset + difference] = first[offset + difference] + 1;
+                if (difference + 1 < size)
+                    second[offset + size - 1] = first[offset + size - 1] - 1;
+                auto expected_sign = first[offset + difference] < second[offset + difference] ? -1 : 1;
+                auto result = memcmp(first + offset, second + offset, size);
+                EXPECT_EQ(result < 0 ? -1 : 1, expected_sign);
+                EXPECT_EQ(memcmp(second + offset, first + offset, size) > 0 ? -1 : 1, expected_sign);
+                memcpy(second, first, buffer_size);
+            }
+        }
+    }
+}
+
+TEST_CASE(memchr_finds_first_match)
+{
+    u8 buffer[buffer_size];
+
+    for (size_t size = 0; size <= max_tested_size; ++size) {
+        for (size_t offset = 0; offset < max_tested_offset; offset += 5) {
+            memset(buffer, 'a', buffer_size);
+            EXPECT_EQ(memchr(buffer + offset, 'b', size), nullptr);
+            for (size_t position = 0; position < size; position += 11) {
+                memset(buffer, 'a', buffer_size);
+                buffer[offset + position] = 'b';
+                if (position + 1 < size)
+                    buffer[offset + size - 1] = 'b';
+                EXPECT_EQ(memchr(buffer + offset, 'b', size), buffer + offset + position);
+            }
+            // Matches right after the end must be ignored.
+            buffer[offset + size] = 'c';
+            EXPECT_EQ(memchr(buffer + offset, 'c', size), nullptr);
+        }
+    }
+}
+
+TEST_CASE(strlen_and_strchr_sizes_and_alignments)
+{
+    char buffer[buffer_size];
+
+    for (size_t length = 0; length < max_tested_size; ++length) {
+        for (size_t offset = 0; offset < max_tested_offset; ++offset) {
+            memset(buffer, 'x', buffer_size);
+            buffer[offset + length] = '\0';
+            EXPECT_EQ(strlen(buffer + offset), length);
+            EXPECT_EQ(strchr(buffer + offset, 'y'), nullptr);
+            EXPECT_EQ(strchr(buffer + offset, '\0'), buffer + offset + length);
+            if (length > 0) {
+                buffer[offset + length / 2] = 'y';
+                buffer[offset + length - 1] = 'y';
+                EXPECT_EQ(strchr(buffer + offset, 'y'), buffer + offset + length / 2);
+            }
+        }
+    }
+}
+
+TEST_CASE(no_reads_past_the_end)
+{
+    auto page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    auto* pages = allocate_guarded_page();
+    auto* end = pages + page_size;
+
+    for (size_t size = 0; size <= max_tested_size; ++size) {
+        memset(pages, 'a', page_size);
+        auto* data = end - size;
+        EXPECT_EQ(memchr(data, 'b', size), nullptr);
+        EXPECT_EQ(memcmp(data, data, size), 0);
+        memcpy(pages, data, size);
+        memmove(pages + 1, data, size);
+        memset(data, 'a', size);
+
+        if (size > 0) {
+            end[-1] = '\0';
+            auto* string = reinterpret_cast<char*>(data);
+            EXPECT_EQ(strlen(string), size - 1);
+            EXPECT_EQ(strchr(string, 'b'), nullptr);
+        }
+    }
+
+    free_guarded_page(pages);
+}
+
+TEST_CASE(memchr_stops_at_the_first_match)
+{
+    auto page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    auto* pages = allocate_guarded_page();
+    auto* end = pages + page_size;
+
+    // memchr() has to behave as if it reads one byte at a time, so a length that reaches past
+    // the end of the buffer is fine as long as the byte is found before that.
+    for (size_t distance = 1; distance <= max_tested_size; ++distance) {
+        memset(pages, 'a', page_size);
+        end[-1] = 'b';
+        EXPECT_EQ(memchr(end - distance, 'b', NumericLimits<size_t>::max()), end - 1);
+        EXPECT_EQ(memchr(end - distance, 'b', page_size), end - 1);
+    }
+
+    free_guarded_page(pages);
+}
+
+template<typename Callback>
+static void benchmark_sizes_and_alignments(Callback callback)
+{
+    for (auto size : benchmark_sizes) {
+        for (auto alignment : benchmark_alignments) {
+            auto iterations = max<size_t>(benchmark_bytes_per_run / size, 1000);
+            for (size_t i = 0; i < iterations; ++i)
+                callback(size, alignment);
+        }
+    }
+}
+
+struct BenchmarkBuffers {
+    BenchmarkBuffers()
+    {
+        first = static_cast<u8*>(mmap(nullptr, benchmark_buffer_size, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0));
+        second = static_cast<u8*>(mmap(nullptr, benchmark_buffer_size, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0));
+        VERIFY(first != MAP_FAILED && second != MAP_FAILED);
+        memset(first, 'a', benchmark_buffer_size);
+        memset(second, 'a', benchmark_buffer_size);
+    }
+
+    ~BenchmarkBuffers()
+    {
+        munmap(first, benchmark_buffer_size);
+        munmap(second, benchmark_buffer_size);
+    }
+
+    u8* first { nullptr };
+    u8* second { nullptr };
+};
+
+static volatile size_t s_sink;
+
+BENCHMARK_CASE(memcpy)
+{
+    BenchmarkBuffers buffers;
+    benchmark_sizes_and_alignments([&](size_t size, size_t alignment) {
+        memcpy(buffers.first + alignment, buffers.second, size);
+    });
+}
+
+BENCHMARK_CASE(memmove)
+{
+    BenchmarkBuffers buffers;
+    benchmark_sizes_and_alignments([&](size_t size, size_t alignment) {
+        memmove(buffers.first + alignment, buffers.first + 32, size);
+    });
+}
+
+BENCHMARK_CASE(memset)
+{
+    BenchmarkBuffers buffers;
+    benchmark_sizes_and_alignments([&](size_t size, size_t alignment) {
+        memset(buffers.first + alignment, 'a', size);
+    });
+}
+
+BENCHMARK_CASE(memcmp)
+{
+    BenchmarkBuffers buffers;
+    benchmark_sizes_and_alignments([&](size_t size, size_t alignment) {
+        s_sink = memcmp(buffers.first + alignment, buffers.second, size);
+    });
+}
+
+BENCHMARK_CASE(memchr)
+{
+    BenchmarkBuffers buffers;
+    benchmark_sizes_and_alignments([&](size_t size, size_t alignment) {
+        s_sink = reinterpret_cast<FlatPtr>(memchr(buffers.first + alignment, 'b', size));
+    });
+}
+
+BENCHMARK_CASE(strlen)
+{
+    BenchmarkBuffers buffers;
+    benchmark_sizes_and_alignments([&](size_t size, size_t alignment) {
+        auto* string = reinterpret_cast<char const*>(buffers.second + alignment);
+        buffers.second[alignment + size] = '\0';
+        s_sink = strlen(string);
+        buffers.second[alignment + size] = 'a';
+    });
+}
+
+BENCHMARK_CASE(strchr)
+{
+    BenchmarkBuffers buffers;
+    benchmark_sizes_and_alignments([&](size_t size, size_t alignment) {
+        auto* string = reinterpret_cast<char const*>(buffers.second + alignment);
+        buffers.second[alignment + size] = '\0';
+        s_sink = reinterpret_cast<FlatPtr>(strchr(string, 'b'));
+        buffers.second[alignment + size] = 'a';
+    });
+}
@@ -4,11 +4,57 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/Array.h>
+#include <AK/Vector.h>
 #include <LibTest/TestCase.h>
 
 #include <LibC/mallocdefs.h>
 #include <errno.h>
+#include <pthread.h>
 #include <stdlib.h>
+#include <string.h>
+
+// A tiny xorshift generator, so the threads don't contend on anything but malloc.
+static u32 next_random(u32& state)
+{
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+static size_t random_allocation_size(u32& state)
+{
+    // Mostly small allocations, with the occasional one that's too big for the thread caches.
+    auto value = next_random(state);
+    if (value % 64 == 0)
+        return 4 * KiB + value % (64 * KiB);
+    return 1 + value % 512;
+}
+
+template<typename Callback>
+static void run_on_threads(size_t thread_count, Callback callback)
+{
+    struct Context {
+        Callback* callback;
+        size_t index;
+    };
+    Vector<pthread_t> threads;
+    Vector<Context> contexts;
+    threads.resize(thread_count);
+    for (size_t i = 0; i < thread_count; ++i)
+        contexts.append({ &callback, i });
+    for (size_t i = 0; i < thread_count; ++i) {
+        auto rc = pthread_create(&threads[i], nullptr, [](void* argument) -> void* {
+            auto& context = *static_cast<Context*>(argument);
+            (*context.callback)(context.index);
+            return nullptr;
+        }, &contexts[i]);
+        VERIFY(rc == 0);
+    }
+    for (auto thread : threads)
+        VERIFY(pthread_join(thread, nullptr) == 0);
+}
 
 TEST_CASE(malloc_limits)
 {
@@ -38,3 +84,97 @@ TEST_CASE(malloc_limits)
         return Test::Crash::Failure::DidNotCrash;
     });
 }
+
+TEST_CASE(chunks_freed_by_another_thread)
+{
+    static constexpr size_t allocation_count = 4096;
+    Array<u8*, allocation_count> allocations;
+    Array<size_t, allocation_count> sizes;
+
+    for (size_t round = 0; round < 8; ++round) {
+        run_on_threads(1, [&](size_t) {
+            u32 random_state = 0x1234 + round;
+            for (size_t i = 0; i < allocation_count; ++i) {
+                sizes[i] = random_allocation_size(random_state);
+                allocations[i] = static_cast<u8*>(malloc(sizes[i]));
+                VERIFY(allocations[i]);
+                memset(allocations[i], static_cast<u8>(i), sizes[i]);
+            }
+        });
+
+        run_on_threads(1, [&](size_t) {
+            for (size_t i = 0; i < allocation_count; ++i) {
+                for (size_t j = 0; j < sizes[i]; ++j)
+                    EXPECT_EQ(allocations[i][j], static_cast<u8>(i));
+                free(allocations[i]);
+            }
+        });
+    }
+}
+
+TEST_CASE(concurrent_allocations_do_not_overlap)
+{
+    static constexpr size_t thread_count = 8;
+    static constexpr size_t iterations = 20000;
+    static constexpr size_t live_allocations_per_thread = 64;
+
+    run_on_threads(thread_count, [&](size_t index) {
+        u32 random_state = 0x9e3779b9 * (index + 1);
+        Array<u8*, live_allocations_per_thread> allocations {};
+        Array<size_t, live_allocations_per_thread> sizes {};
+        for (size_t i = 0; i < iterations; ++i) {
+            auto slot = next_random(random_state) % live_allocations_per_thread;
+            if (allocations[slot]) {
+                // Every byte must still be what this thread wrote into it.
+                for (size_t j = 0; j < sizes[slot]; ++j)
+                    VERIFY(allocations[slot][j] == static_cast<u8>(index + slot));
+                free(allocations[slot]);
+            }
+            sizes[slot] = random_allocation_size(random_state);
+            allocations[slot] = static_cast<u8*>(malloc(sizes[slot]));
+            VERIFY(allocations[slot]);
+            memset(allocations[slot], static_cast<u8>(index + slot), sizes[slot]);
+        }
+        for (auto* allocation : allocations)
+            free(allocation);
+    });
+}
+
+static void churn_malloc_and_free_on_threads(size_t thread_count)
+{
+    static constexpr size_t operations_per_thread = 1'000'000;
+    static constexpr size_t live_allocations_per_thread = 256;
+
+    run_on_threads(thread_count, [&](size_t index) {
+        u32 random_state = 0x2545f491 * (index + 1);
+        Array<void*, live_allocations_per_thread> allocations {};
+        for (size_t i = 0; i < operations_per_thread; ++i) {
+            auto slot = next_random(random_state) % live_allocations_per_thread;
+            free(allocations[slot]);
+            allocations[slot] = malloc(1 + next_random(random_state) % 512);
+        }
+        for (auto* allocation : allocations)
+            free(allocation);
+    });
+}
+
+// Every thread does the same amount of work, so these should take about as long as each other.
+BENCHMARK_CASE(malloc_free_on_1_thread)
+{
+    churn_malloc_and_free_on_threads(1);
+}
+
+BENCHMARK_CASE(malloc_free_on_2_threads)
+{
+    churn_malloc_and_free_on_threads(2);
+}
+
+BENCHMARK_CASE(malloc_free_on_4_threads)
+{
+    churn_malloc_and_free_on_threads(4);
+}
+
+BENCHMARK_CASE(malloc_free_on_8_threads)
+{
+    churn_malloc_and_free_on_threads(8);
+}
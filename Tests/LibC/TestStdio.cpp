@@ -6,6 +6,8 @@
 
 #include <LibTest/TestCase.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <sys/wait.h>
 #include <unistd.h>
 
@@ -40,3 +42,34 @@ TEST_CASE(flush_on_exit)
         EXPECT_EQ(strcmp(test_str, buf), 0);
     }
 }
+
+// Writes bigger than the buffer go straight to the file, but must still come after whatever was buffered before.
+TEST_CASE(large_write_after_buffered_data)
+{
+    char path[] = "/tmp/stdio_large_write.XXXXXX";
+    int fd = mkstemp(path);
+    VERIFY(fd >= 0);
+    auto* fp = fdopen(fd, "w");
+    VERIFY(fp != nullptr);
+    char buffer[16];
+    EXPECT_EQ(setvbuf(fp, buffer, _IOFBF, sizeof(buffer)), 0);
+
+    char large[64];
+    memset(large, 'b', sizeof(large));
+    EXPECT_EQ(fwrite("aaaa", 1, 4, fp), 4u);
+    EXPECT_EQ(fwrite(large, 1, sizeof(large), fp), sizeof(large));
+    EXPECT_EQ(fwrite("cc", 1, 2, fp), 2u);
+    fclose(fp);
+
+    char contents[128] {};
+    fp = fopen(path, "r");
+    VERIFY(fp != nullptr);
+    EXPECT_EQ(fread(contents, 1, sizeof(contents), fp), 70u);
+    fclose(fp);
+    unlink(path);
+
+    EXPECT_EQ(memcmp(contents, "aaaa", 4), 0);
+    for (size_t i = 4; i < 68; ++i)
+        EXPECT_EQ(contents[i], 'b');
+    EXPECT_EQ(memcmp(contents + 68, "cc", 2), 0);
+}
@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <LibCore/ProcessStatisticsReader.h>
+#include <LibTest/TestCase.h>
+#include <serenity.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static Core::ProcessStatistics const* find_process(Core::AllProcessesStatistics const& statistics, pid_t pid)
+{
+    for (auto& process : statistics.processes) {
+        if (process.pid == pid)
+            return &process;
+    }
+    return nullptr;
+}
+
+TEST_CASE(binary_snapshot_matches_json)
+{
+    RefPtr<Core::File> proc_all_file;
+    auto json = Core::ProcessStatisticsReader::get_all_from_json(proc_all_file);
+    auto binary = Core::ProcessStatisticsReader::get_all();
+    EXPECT(json.has_value());
+    EXPECT(binary.has_value());
+
+    auto* json_self = find_process(*json, getpid());
+    auto* binary_self = find_process(*binary, getpid());
+    EXPECT(json_self);
+    EXPECT(binary_self);
+    EXPECT_EQ(binary_self->name, json_self->name);
+    EXPECT_EQ(binary_self->executable, json_self->executable);
+    EXPECT_EQ(binary_self->pledge, json_self->pledge);
+    EXPECT_EQ(binary_self->veil, json_self->veil);
+    EXPECT_EQ(binary_self->uid, json_self->uid);
+    EXPECT_EQ(binary_self->threads.size(), json_self->threads.size());
+    EXPECT_EQ(binary_self->threads[0].tid, json_self->threads[0].tid);
+    EXPECT_EQ(binary_self->threads[0].name, json_self->threads[0].name);
+
+    // The colonel is always listed first.
+    EXPECT_EQ(binary->processes[0].pid, 0);
+    EXPECT(binary->processes[0].kernel);
+}
+
+TEST_CASE(incremental_refresh_keeps_every_process)
+{
+    Core::ProcessStatisticsReader reader;
+    EXPECT(reader.refresh());
+    auto process_count = reader.statistics().processes.size();
+    auto syscall_count = find_process(reader.statistics(), getpid())->threads[0].syscall_count;
+
+    EXPECT(reader.refresh());
+    EXPECT_EQ(reader.statistics().processes.size(), process_count);
+
+    // We were running while making the previous snapshot, so our own counters are refreshed.
+    auto* self = find_process(reader.statistics(), getpid());
+    EXPECT(self);
+    EXPECT(self->threads[0].syscall_count > syscall_count);
+
+    pid_t child = fork();
+    VERIFY(child >= 0);
+    if (child == 0) {
+        pause();
+        _exit(0);
+    }
+    EXPECT(reader.refresh());
+    EXPECT(find_process(reader.statistics(), child));
+
+    EXPECT_EQ(kill(child, SIGKILL), 0);
+    int status;
+    EXPECT_EQ(waitpid(child, &status, 0), child);
+    EXPECT(reader.refresh());
+    EXPECT(!find_process(reader.statistics(), child));
+}
+
+TEST_CASE(incremental_refresh_sees_changes_made_by_other_processes)
+{
+    pid_t child = fork();
+    VERIFY(child >= 0);
+    if (child == 0) {
+        pause();
+        _exit(0);
+    }
+
+    // Give the child time to block, then take two snapshots, so it hasn't changed since the last one.
+    usleep(100'000);
+    Core::ProcessStatisticsReader reader;
+    EXPECT(reader.refresh());
+    EXPECT(reader.refresh());
+    EXPECT_EQ(find_process(reader.statistics(), child)->pgp, getpgid(0));
+
+    EXPECT_EQ(setpgid(child, child), 0);
+    EXPECT(reader.refresh());
+    EXPECT_EQ(find_process(reader.statistics(), child)->pgp, child);
+
+    EXPECT_EQ(disown(child), 0);
+    EXPECT(reader.refresh());
+    EXPECT_EQ(find_process(reader.statistics(), child)->ppid, 0);
+
+    EXPECT_EQ(kill(child, SIGKILL), 0);
+}
+
+static constexpr size_t snapshot_iterations = 1000;
+
+BENCHMARK_CASE(json_snapshots)
+{
+    RefPtr<Core::File> proc_all_file;
+    for (size_t i = 0; i < snapshot_iterations; ++i)
+        VERIFY(Core::ProcessStatisticsReader::get_all_from_json(proc_all_file).has_value());
+}
+
+BENCHMARK_CASE(full_binary_snapshots)
+{
+    for (size_t i = 0; i < snapshot_iterations; ++i)
+        VERIFY(Core::ProcessStatisticsReader::get_all().has_value());
+}
+
+BENCHMARK_CASE(incremental_binary_snapshots)
+{
+    Core::ProcessStatisticsReader reader;
+    for (size_t i = 0; i < snapshot_iterations; ++i)
+        VERIFY(reader.refresh());
+}
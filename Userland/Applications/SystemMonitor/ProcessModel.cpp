@@ -331,19 +331,20 @@ Vector<GUI::ModelIndex> ProcessModel::matches(StringView searching, unsigned fla
 void ProcessModel::update()
 {
     auto previous_tid_count = m_tids.size();
-    auto all_processes = Core::ProcessStatisticsReader::get_all(m_proc_all);
+    bool refreshed = m_process_statistics_reader.refresh();
+    auto const& all_processes = m_process_statistics_reader.statistics();
 
     HashTable<int> live_tids;
     u64 total_time_scheduled_diff = 0;
-    if (all_processes.has_value()) {
+    if (refreshed) {
         if (m_has_total_scheduled_time)
-            total_time_scheduled_diff = all_processes->total_time_scheduled - m_total_time_scheduled;
+            total_time_scheduled_diff = all_processes.total_time_scheduled - m_total_time_scheduled;
 
-        m_total_time_scheduled = all_processes->total_time_scheduled;
-        m_total_time_scheduled_kernel = all_processes->total_time_scheduled_kernel;
+        m_total_time_scheduled = all_processes.total_time_scheduled;
+        m_total_time_scheduled_kernel = all_processes.total_time_scheduled_kernel;
         m_has_total_scheduled_time = true;
 
-        for (auto& process : all_processes.value().processes) {
+        for (auto& process : all_processes.processes) {
             for (auto& thread : process.threads) {
                 ThreadState state;
                 state.kernel = process.kernel;
@@ -423,7 +424,7 @@ void ProcessModel::update()
         on_cpu_info_change(m_cpus);
 
     if (on_state_update)
-        on_state_update(all_processes.has_value() ? all_processes->processes.size() : 0, m_threads.size());
+        on_state_update(refreshed ? all_processes.processes.size() : 0, m_threads.size());
 
     // FIXME: This is a rather hackish way of invalidating indices.
     //        It would be good if GUI::Model had a way to orchestrate removal/insertion while preserving indices.
@@ -10,6 +10,7 @@
 #include <AK/NonnullOwnPtrVector.h>
 #include <AK/String.h>
 #include <AK/Vector.h>
+#include <LibCore/ProcessStatisticsReader.h>
 #include <LibGUI/Model.h>
 #include <unistd.h>
 
@@ -129,7 +130,7 @@ private:
     HashMap<int, NonnullOwnPtr<Thread>> m_threads;
     NonnullOwnPtrVector<CpuInfo> m_cpus;
     Vector<int> m_tids;
-    RefPtr<Core::File> m_proc_all;
+    Core::ProcessStatisticsReader m_process_statistics_reader;
     GUI::Icon m_kernel_process_icon;
     u64 m_total_time_scheduled { 0 };
     u64 m_total_time_scheduled_kernel { 0 };
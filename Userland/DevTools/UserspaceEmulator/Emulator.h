@@ -63,7 +63,7 @@ public:
 
     int exec();
     void handle_repl();
-    u32 virt_syscall(u32 function, u32 arg1, u32 arg2, u32 arg3);
+    u32 virt_syscall(u32 function, u32 arg1, u32 arg2, u32 arg3, u32 arg4);
 
     SoftMMU& mmu() { return m_mmu; }
 
@@ -144,6 +144,9 @@ private:
     int virt$close(int);
     int virt$connect(int sockfd, FlatPtr address, socklen_t address_size);
     int virt$create_inode_watcher(unsigned);
+    int virt$create_readiness_set(int);
+    int virt$readiness_set_control(FlatPtr);
+    int virt$readiness_set_wait(FlatPtr);
     int virt$dbgputstr(FlatPtr characters, int length);
     int virt$disown(pid_t);
     int virt$dup2(int, int);
@@ -197,10 +200,12 @@ private:
     int virt$pipe(FlatPtr pipefd, int flags);
     u32 virt$pledge(u32);
     int virt$poll(FlatPtr);
+    u32 virt$pread(int, FlatPtr, ssize_t, FlatPtr);
     int virt$profiling_disable(pid_t);
     int virt$profiling_enable(pid_t);
     int virt$ptsname(int fd, FlatPtr buffer, size_t buffer_size);
     int virt$purge(int mode);
+    u32 virt$pwrite(int, FlatPtr, ssize_t, FlatPtr);
     u32 virt$read(int, FlatPtr, ssize_t);
     int virt$readlink(FlatPtr);
     int virt$realpath(FlatPtr);
@@ -211,6 +216,7 @@ private:
     int virt$sched_getparam(pid_t, FlatPtr);
     int virt$sched_setparam(int, FlatPtr);
     int virt$sendfd(int, int);
+    int virt$sendfile(FlatPtr);
     int virt$sendmsg(int sockfd, FlatPtr msg_addr, int flags);
     int virt$set_coredump_metadata(FlatPtr address);
     int virt$set_mmap_name(FlatPtr);
@@ -237,6 +243,7 @@ private:
     u32 virt$unveil(u32);
     int virt$waitid(FlatPtr);
     u32 virt$write(int, FlatPtr, ssize_t);
+    u32 virt$writev(int, FlatPtr, int);
 
     void dispatch_one_pending_signal();
     MmapRegion const* find_text_region(FlatPtr address);
@@ -32,7 +32,7 @@
 
 namespace UserspaceEmulator {
 
-u32 Emulator::virt_syscall(u32 function, u32 arg1, u32 arg2, u32 arg3)
+u32 Emulator::virt_syscall(u32 function, u32 arg1, u32 arg2, u32 arg3, u32 arg4)
 {
     if constexpr (SPAM_DEBUG)
         reportln("Syscall: {} ({:x})", Syscall::to_string((Syscall::Function)function), function);
@@ -67,6 +67,8 @@ u32 Emulator::virt_syscall(u32 function, u32 arg1, u32 arg2, u32 arg3)
         return virt$connect(arg1, arg2, arg3);
     case SC_create_inode_watcher:
         return virt$create_inode_watcher(arg1);
+    case SC_create_readiness_set:
+        return virt$create_readiness_set(arg1);
     case SC_dbgputstr:
         return virt$dbgputstr(arg1, arg2);
     case SC_disown:
@@ -87,6 +89,7 @@ u32 Emulator::virt_syscall(u32 function, u32 arg1, u32 arg2, u32 arg3)
     case SC_fcntl:
         return virt$fcntl(arg1, arg2, arg3);
     case SC_fork:
+    case SC_vfork:
         return virt$fork();
     case SC_fstat:
         return virt$fstat(arg1, arg2);
@@ -136,6 +139,10 @@ u32 Emulator::virt_syscall(u32 function, u32 arg1, u32 arg2, u32 arg3)
         return virt$inode_watcher_add_watch(arg1);
     case SC_inode_watcher_remove_watch:
         return virt$inode_watcher_remove_watch(arg1, arg2);
+    case SC_io_ring_create:
+    case SC_io_ring_enter:
+        // NOTE: The kernel accesses the buffers named by submissions directly, but their addresses only make sense to the emulated program.
+        return -ENOSYS;
     case SC_ioctl:
         return virt$ioctl(arg1, arg2, arg3);
     case SC_kill:
@@ -180,12 +187,20 @@ u32 Emulator::virt_syscall(u32 function, u32 arg1, u32 arg2, u32 arg3)
         return virt$profiling_disable(arg1);
     case SC_profiling_enable:
         return virt$profiling_enable(arg1);
+    case SC_pread:
+        return virt$pread(arg1, arg2, arg3, arg4);
     case SC_ptsname:
         return virt$ptsname(arg1, arg2, arg3);
     case SC_purge:
         return virt$purge(arg1);
+    case SC_pwrite:
+        return virt$pwrite(arg1, arg2, arg3, arg4);
     case SC_read:
         return virt$read(arg1, arg2, arg3);
+    case SC_readiness_set_control:
+        return virt$readiness_set_control(arg1);
+    case SC_readiness_set_wait:
+        return virt$readiness_set_wait(arg1);
     case SC_readlink:
         return virt$readlink(arg1);
     case SC_realpath:
@@ -204,6 +219,8 @@ u32 Emulator::virt_syscall(u32 function, u32 arg1, u32 arg2, u32 arg3)
         return virt$sched_setparam(arg1, arg2);
     case SC_sendfd:
         return virt$sendfd(arg1, arg2);
+    case SC_sendfile:
+        return virt$sendfile(arg1);
     case SC_sendmsg:
         return virt$sendmsg(arg1, arg2, arg3);
     case SC_set_coredump_metadata:
@@ -257,6 +274,8 @@ u32 Emulator::virt_syscall(u32 function, u32 arg1, u32 arg2, u32 arg3)
         return virt$waitid(arg1);
     case SC_write:
         return virt$write(arg1, arg2, arg3);
+    case SC_writev:
+        return virt$writev(arg1, arg2, arg3);
     default:
         reportln("\n=={}==  \033[31;1mUnimplemented syscall: {}\033[0m, {:p}", getpid(), Syscall::to_string((Syscall::Function)function), function);
         dump_backtrace();
@@ -274,6 +293,23 @@ int Emulator::virt$sendfd(int socket, int fd)
     return syscall(SC_sendfd, socket, fd);
 }
 
+int Emulator::virt$sendfile(FlatPtr params_addr)
+{
+    Syscall::SC_sendfile_params params;
+    mmu().copy_from_vm(&params, params_addr, sizeof(params));
+
+    off_t offset = 0;
+    if (params.offset)
+        mmu().copy_from_vm(&offset, (FlatPtr)params.offset, sizeof(offset));
+
+    auto* guest_offset = params.offset;
+    params.offset = guest_offset ? &offset : nullptr;
+    int rc = syscall(SC_sendfile, &params);
+    if (rc >= 0 && guest_offset)
+        mmu().copy_to_vm((FlatPtr)guest_offset, &offset, sizeof(offset));
+    return rc;
+}
+
 int Emulator::virt$recvfd(int socket, int options)
 {
     return syscall(SC_recvfd, socket, options);
@@ -1047,6 +1083,48 @@ u32 Emulator::virt$write(int fd, FlatPtr data, ssize_t size)
     return syscall(SC_write, fd, buffer.data(), buffer.size());
 }
 
+u32 Emulator::virt$pwrite(int fd, FlatPtr data, ssize_t size, FlatPtr offset_addr)
+{
+    if (size < 0)
+        return -EINVAL;
+    off_t offset;
+    mmu().copy_from_vm(&offset, offset_addr, sizeof(offset));
+    auto buffer = mmu().copy_buffer_from_vm(data, size);
+    return syscall(SC_pwrite, fd, buffer.data(), buffer.size(), &offset);
+}
+
+u32 Emulator::virt$writev(int fd, FlatPtr iov_addr, int iov_count)
+{
+    if (iov_count < 0)
+        return -EINVAL;
+    Vector<iovec, 8> iovs;
+    iovs.resize(iov_count);
+    mmu().copy_from_vm(iovs.data(), iov_addr, iov_count * sizeof(iovec));
+    Vector<ByteBuffer, 8> buffers;
+    for (auto& iov : iovs) {
+        buffers.append(mmu().copy_buffer_from_vm((FlatPtr)iov.iov_base, iov.iov_len));
+        iov = { buffers.last().data(), buffers.last().size() };
+    }
+    return syscall(SC_writev, fd, iovs.data(), iovs.size());
+}
+
+u32 Emulator::virt$pread(int fd, FlatPtr buffer, ssize_t size, FlatPtr offset_addr)
+{
+    if (size < 0)
+        return -EINVAL;
+    off_t offset;
+    mmu().copy_from_vm(&offset, offset_addr, sizeof(offset));
+    auto buffer_result = ByteBuffer::create_uninitialized(size);
+    if (!buffer_result.has_value())
+        return -ENOMEM;
+    auto& local_buffer = buffer_result.value();
+    int nread = syscall(SC_pread, fd, local_buffer.data(), local_buffer.size(), &offset);
+    if (nread < 0)
+        return nread;
+    mmu().copy_to_vm(buffer, local_buffer.data(), nread);
+    return nread;
+}
+
 u32 Emulator::virt$read(int fd, FlatPtr buffer, ssize_t size)
 {
     if (size < 0)
@@ -1501,6 +1579,40 @@ int Emulator::virt$inode_watcher_remove_watch(int fd, int wd)
     return syscall(SC_inode_watcher_add_watch, fd, wd);
 }
 
+int Emulator::virt$create_readiness_set(int flags)
+{
+    return syscall(SC_create_readiness_set, flags);
+}
+
+int Emulator::virt$readiness_set_control(FlatPtr params_addr)
+{
+    Syscall::SC_readiness_set_control_params params;
+    mmu().copy_from_vm(&params, params_addr, sizeof(params));
+    return syscall(SC_readiness_set_control, &params);
+}
+
+int Emulator::virt$readiness_set_wait(FlatPtr params_addr)
+{
+    Syscall::SC_readiness_set_wait_params params;
+    mmu().copy_from_vm(&params, params_addr, sizeof(params));
+
+    if (params.max_events == 0)
+        return -EINVAL;
+
+    Vector<readiness_event> events;
+    events.resize(params.max_events);
+    struct timespec timeout;
+    if (params.timeout)
+        mmu().copy_from_vm(&timeout, (FlatPtr)params.timeout, sizeof(timeout));
+
+    int rc = readiness_set_wait(params.set_fd, events.data(), events.size(), params.timeout ? &timeout : nullptr);
+    if (rc < 0)
+        return -errno;
+
+    mmu().copy_to_vm((FlatPtr)params.events, events.data(), sizeof(readiness_event) * rc);
+    return rc;
+}
+
 int Emulator::virt$clock_nanosleep(FlatPtr params_addr)
 {
     Syscall::SC_clock_nanosleep_params params;
@@ -1747,7 +1747,7 @@ void SoftCPU::INT_imm8(const X86::Instruction& insn)
 {
     VERIFY(insn.imm8() == 0x82);
     // FIXME: virt_syscall should take ValueWithShadow and whine about uninitialized arguments
-    set_eax(shadow_wrap_as_initialized(m_emulator.virt_syscall(eax().value(), edx().value(), ecx().value(), ebx().value())));
+    set_eax(shadow_wrap_as_initialized(m_emulator.virt_syscall(eax().value(), edx().value(), ecx().value(), ebx().value(), esi().value())));
 }
 
 void SoftCPU::INVLPG(const X86::Instruction&) { TODO_INSN(); }
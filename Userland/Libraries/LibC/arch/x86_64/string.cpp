@@ -0,0 +1,321 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Platform.h>
+#include <AK/StdLibExtras.h>
+#include <AK/Types.h>
+#include <immintrin.h>
+#include <string.h>
+
+// Vectorized versions of the hottest string.h functions. They are bound through resolvers, which
+// the dynamic loader (or crt0, for static programs) calls once to pick an implementation.
+//
+// For now there are only SSE2 variants, which every x86_64 CPU supports. Wider variants have to
+// wait until the kernel preserves the upper halves of the YMM registers across context switches,
+// since it only saves the legacy SSE state with fxsave at the moment.
+//
+// The generic implementations in string.cpp are still used on other architectures and by the
+// dynamic loader itself, since it has to run before anything has been relocated.
+//
+// memchr(), strlen() and strchr() only ever use aligned loads, which can't cross into a page that
+// isn't mapped, and stop at the first match. This matters for memchr() too, since it has to behave
+// as if it reads one byte at a time, and the given length may well be larger than the buffer.
+// All others never read past the given length, and instead handle the last partial block with a
+// load that overlaps the previous one.
+
+using UnalignedU16 = u16 __attribute__((may_alias, aligned(1)));
+using UnalignedU32 = u32 __attribute__((may_alias, aligned(1)));
+using UnalignedU64 = u64 __attribute__((may_alias, aligned(1)));
+
+// Copies fewer than 16 bytes. Everything is loaded before anything is stored, so this also
+// works for overlapping buffers.
+ALWAYS_INLINE static void copy_less_than_16_bytes(u8* dest, u8 const* src, size_t n)
+{
+    if (n >= 8) {
+        u64 head = *reinterpret_cast<UnalignedU64 const*>(src);
+        u64 tail = *reinterpret_cast<UnalignedU64 const*>(src + n - 8);
+        *reinterpret_cast<UnalignedU64*>(dest) = head;
+        *reinterpret_cast<UnalignedU64*>(dest + n - 8) = tail;
+    } else if (n >= 4) {
+        u32 head = *reinterpret_cast<UnalignedU32 const*>(src);
+        u32 tail = *reinterpret_cast<UnalignedU32 const*>(src + n - 4);
+        *reinterpret_cast<UnalignedU32*>(dest) = head;
+        *reinterpret_cast<UnalignedU32*>(dest + n - 4) = tail;
+    } else if (n >= 2) {
+        u16 head = *reinterpret_cast<UnalignedU16 const*>(src);
+        u16 tail = *reinterpret_cast<UnalignedU16 const*>(src + n - 2);
+        *reinterpret_cast<UnalignedU16*>(dest) = head;
+        *reinterpret_cast<UnalignedU16*>(dest + n - 2) = tail;
+    } else if (n == 1) {
+        *dest = *src;
+    }
+}
+
+ALWAYS_INLINE static void set_less_than_16_bytes(u8* dest, u8 c, size_t n)
+{
+    u64 value = 0x0101010101010101ull * c;
+    if (n >= 8) {
+        *reinterpret_cast<UnalignedU64*>(dest) = value;
+        *reinterpret_cast<UnalignedU64*>(dest + n - 8) = value;
+    } else if (n >= 4) {
+        *reinterpret_cast<UnalignedU32*>(dest) = value;
+        *reinterpret_cast<UnalignedU32*>(dest + n - 4) = value;
+    } else if (n >= 2) {
+        *reinterpret_cast<UnalignedU16*>(dest) = value;
+        *reinterpret_cast<UnalignedU16*>(dest + n - 2) = value;
+    } else if (n == 1) {
+        *dest = c;
+    }
+}
+
+ALWAYS_INLINE static int compare_bytes(u8 const* s1, u8 const* s2, size_t n)
+{
+    for (size_t i = 0; i < n; ++i) {
+        if (s1[i] != s2[i])
+            return s1[i] < s2[i] ? -1 : 1;
+    }
+    return 0;
+}
+
+// Copies 16 to 32 bytes, also for overlapping buffers.
+ALWAYS_INLINE static void copy_16_to_32_bytes(u8* dest, u8 const* src, size_t n)
+{
+    auto head = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src));
+    auto tail = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + n - 16));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest), head);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + n - 16), tail);
+}
+
+ALWAYS_INLINE static void set_16_to_32_bytes(u8* dest, __m128i value, size_t n)
+{
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest), value);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + n - 16), value);
+}
+
+// Clears the bits for the bytes in front of the string in its first aligned block.
+ALWAYS_INLINE static u32 skip_leading_bytes(u32 mask, size_t offset)
+{
+    return mask >> offset << offset;
+}
+
+// Copies more than 32 bytes front to back. This is also what memmove() uses if the destination
+// comes before the source.
+static void copy_forward_sse2(u8* dest, u8 const* src, size_t n)
+{
+    auto head = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src));
+    auto tail = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + n - 16));
+    u8* dest_end = dest + n;
+
+    // The stores in the loop are aligned, the (unaligned) first and last block are stored separately.
+    size_t skew = 16 - (reinterpret_cast<FlatPtr>(dest) & 15);
+    u8* out = dest + skew;
+    u8 const* in = src + skew;
+    while (dest_end - out > 64) {
+        auto a = _mm_loadu_si128(reinterpret_cast<__m128i const*>(in));
+        auto b = _mm_loadu_si128(reinterpret_cast<__m128i const*>(in + 16));
+        auto c = _mm_loadu_si128(reinterpret_cast<__m128i const*>(in + 32));
+        auto d = _mm_loadu_si128(reinterpret_cast<__m128i const*>(in + 48));
+        _mm_store_si128(reinterpret_cast<__m128i*>(out), a);
+        _mm_store_si128(reinterpret_cast<__m128i*>(out + 16), b);
+        _mm_store_si128(reinterpret_cast<__m128i*>(out + 32), c);
+        _mm_store_si128(reinterpret_cast<__m128i*>(out + 48), d);
+        out += 64;
+        in += 64;
+    }
+    while (dest_end - out > 16) {
+        _mm_store_si128(reinterpret_cast<__m128i*>(out), _mm_loadu_si128(reinterpret_cast<__m128i const*>(in)));
+        out += 16;
+        in += 16;
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest), head);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest_end - 16), tail);
+}
+
+// Copies more than 32 bytes back to front, for memmove() with the destination after the source.
+static void copy_backward_sse2(u8* dest, u8 const* src, size_t n)
+{
+    auto head = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src));
+    auto tail = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + n - 16));
+
+    size_t skew = reinterpret_cast<FlatPtr>(dest + n) & 15;
+    if (skew == 0)
+        skew = 16;
+    u8* out = dest + n - skew;
+    u8 const* in = src + n - skew;
+    while (out - dest > 64) {
+        auto a = _mm_loadu_si128(reinterpret_cast<__m128i const*>(in - 16));
+        auto b = _mm_loadu_si128(reinterpret_cast<__m128i const*>(in - 32));
+        auto c = _mm_loadu_si128(reinterpret_cast<__m128i const*>(in - 48));
+        auto d = _mm_loadu_si128(reinterpret_cast<__m128i const*>(in - 64));
+        _mm_store_si128(reinterpret_cast<__m128i*>(out - 16), a);
+        _mm_store_si128(reinterpret_cast<__m128i*>(out - 32), b);
+        _mm_store_si128(reinterpret_cast<__m128i*>(out - 48), c);
+        _mm_store_si128(reinterpret_cast<__m128i*>(out - 64), d);
+        out -= 64;
+        in -= 64;
+    }
+    while (out - dest > 16) {
+        out -= 16;
+        in -= 16;
+        _mm_store_si128(reinterpret_cast<__m128i*>(out), _mm_loadu_si128(reinterpret_cast<__m128i const*>(in)));
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest), head);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + n - 16), tail);
+}
+
+static void* memcpy_sse2(void* dest_ptr, void const* src_ptr, size_t n)
+{
+    auto* dest = static_cast<u8*>(dest_ptr);
+    auto const* src = static_cast<u8 const*>(src_ptr);
+    if (n < 16)
+        copy_less_than_16_bytes(dest, src, n);
+    else if (n <= 32)
+        copy_16_to_32_bytes(dest, src, n);
+    else
+        copy_forward_sse2(dest, src, n);
+    return dest_ptr;
+}
+
+static void* memmove_sse2(void* dest_ptr, void const* src_ptr, size_t n)
+{
+    auto* dest = static_cast<u8*>(dest_ptr);
+    auto const* src = static_cast<u8 const*>(src_ptr);
+    if (n < 16)
+        copy_less_than_16_bytes(dest, src, n);
+    else if (n <= 32)
+        copy_16_to_32_bytes(dest, src, n);
+    else if (reinterpret_cast<FlatPtr>(dest) - reinterpret_cast<FlatPtr>(src) >= n)
+        copy_forward_sse2(dest, src, n);
+    else
+        copy_backward_sse2(dest, src, n);
+    return dest_ptr;
+}
+
+static void* memset_sse2(void* dest_ptr, int c, size_t n)
+{
+    auto* dest = static_cast<u8*>(dest_ptr);
+    if (n < 16) {
+        set_less_than_16_bytes(dest, c, n);
+        return dest_ptr;
+    }
+    auto value = _mm_set1_epi8(static_cast<char>(c));
+    if (n <= 32) {
+        set_16_to_32_bytes(dest, value, n);
+        return dest_ptr;
+    }
+
+    u8* dest_end = dest + n;
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest), value);
+    u8* out = dest + 16 - (reinterpret_cast<FlatPtr>(dest) & 15);
+    while (dest_end - out > 64) {
+        _mm_store_si128(reinterpret_cast<__m128i*>(out), value);
+        _mm_store_si128(reinterpret_cast<__m128i*>(out + 16), value);
+        _mm_store_si128(reinterpret_cast<__m128i*>(out + 32), value);
+        _mm_store_si128(reinterpret_cast<__m128i*>(out + 48), value);
+        out += 64;
+    }
+    while (dest_end - out > 16) {
+        _mm_store_si128(reinterpret_cast<__m128i*>(out), value);
+        out += 16;
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest_end - 16), value);
+    return dest_ptr;
+}
+
+static int memcmp_sse2(void const* v1, void const* v2, size_t n)
+{
+    auto const* s1 = static_cast<u8 const*>(v1);
+    auto const* s2 = static_cast<u8 const*>(v2);
+    if (n < 16)
+        return compare_bytes(s1, s2, n);
+
+    for (size_t offset = 0;; offset += 16) {
+        // The last block overlaps the previous one, which is known to be equal.
+        offset = min(offset, n - 16);
+        auto a = _mm_loadu_si128(reinterpret_cast<__m128i const*>(s1 + offset));
+        auto b = _mm_loadu_si128(reinterpret_cast<__m128i const*>(s2 + offset));
+        u32 equal = _mm_movemask_epi8(_mm_cmpeq_epi8(a, b));
+        if (equal != 0xffff) {
+            size_t index = offset + __builtin_ctz(~equal);
+            return s1[index] < s2[index] ? -1 : 1;
+        }
+        if (offset == n - 16)
+            return 0;
+    }
+}
+
+static void* memchr_sse2(void const* ptr, int c, size_t n)
+{
+    if (!n)
+        return nullptr;
+
+    auto const* s = static_cast<u8 const*>(ptr);
+    auto needle = _mm_set1_epi8(static_cast<char>(c));
+    size_t offset = reinterpret_cast<FlatPtr>(s) & 15;
+    auto const* block = reinterpret_cast<__m128i const*>(s - offset);
+    u32 mask = skip_leading_bytes(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_load_si128(block), needle)), offset);
+    size_t scanned = 16 - offset;
+    while (!mask) {
+        if (scanned >= n)
+            return nullptr;
+        mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_load_si128(++block), needle));
+        scanned += 16;
+    }
+    size_t index = reinterpret_cast<u8 const*>(block) + __builtin_ctz(mask) - s;
+    return index < n ? const_cast<u8*>(s + index) : nullptr;
+}
+
+static size_t strlen_sse2(char const* str)
+{
+    auto zero = _mm_setzero_si128();
+    size_t offset = reinterpret_cast<FlatPtr>(str) & 15;
+    auto const* block = reinterpret_cast<__m128i const*>(str - offset);
+    u32 mask = skip_leading_bytes(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_load_si128(block), zero)), offset);
+    while (!mask)
+        mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_load_si128(++block), zero));
+    return reinterpret_cast<char const*>(block) + __builtin_ctz(mask) - str;
+}
+
+ALWAYS_INLINE static u32 null_or_byte_mask_sse2(__m128i const* block, __m128i needle)
+{
+    auto bytes = _mm_load_si128(block);
+    return _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_setzero_si128()), _mm_cmpeq_epi8(bytes, needle)));
+}
+
+static char* strchr_sse2(char const* str, int c)
+{
+    auto needle = _mm_set1_epi8(static_cast<char>(c));
+    size_t offset = reinterpret_cast<FlatPtr>(str) & 15;
+    auto const* block = reinterpret_cast<__m128i const*>(str - offset);
+    u32 mask = skip_leading_bytes(null_or_byte_mask_sse2(block, needle), offset);
+    while (!mask)
+        mask = null_or_byte_mask_sse2(++block, needle);
+    auto const* result = reinterpret_cast<char const*>(block) + __builtin_ctz(mask);
+    return *result == static_cast<char>(c) ? const_cast<char*>(result) : nullptr;
+}
+
+// Our toolchains don't support the ifunc attribute on every target, so we emit what the compiler
+// would for it. The resolvers have C linkage, so their names can be used in the assembly.
+// They run while the dynamic loader is still relocating libc, so they must not call anything
+// or access anything that needs a relocation.
+#define DEFINE_IFUNC(name, return_type, ...)                                  \
+    extern "C" {                                                              \
+    [[gnu::used]] static return_type (*resolve_##name())(__VA_ARGS__)         \
+    {                                                                         \
+        return name##_sse2;                                                   \
+    }                                                                         \
+    }                                                                         \
+    asm(".globl " #name "\n"                                                  \
+        ".type " #name ", @gnu_indirect_function\n"                           \
+        ".set " #name ", resolve_" #name "\n");
+
+DEFINE_IFUNC(memcpy, void*, void*, void const*, size_t)
+DEFINE_IFUNC(memmove, void*, void*, void const*, size_t)
+DEFINE_IFUNC(memset, void*, void*, int, size_t)
+DEFINE_IFUNC(memcmp, int, void const*, void const*, size_t)
+DEFINE_IFUNC(memchr, void*, void const*, int, size_t)
+DEFINE_IFUNC(strlen, size_t, char const*)
+DEFINE_IFUNC(strchr, char*, char const*, int)
@@ -82,6 +82,9 @@ private:
         bool may_use() const;
         bool is_not_empty() const { return m_ungotten || !m_empty; }
         size_t buffered_size() const;
+        size_t capacity() const { return m_capacity; }
+        // Whether begin_dequeue() hands out everything that is buffered in one go.
+        bool is_contiguous() const;
 
         const u8* begin_dequeue(size_t& available_size) const;
         void did_dequeue(size_t actual_size);
@@ -119,6 +122,9 @@ private:
     bool read_into_buffer();
     // Flush *some* data from the buffer.
     bool write_from_buffer();
+    // Write data that's too big for the buffer, along with whatever is still
+    // buffered in front of it. Returns how much of the new data got written.
+    ssize_t write_around_buffer(const u8*, size_t);
 
     int m_fd { -1 };
     int m_mode { 0 };
@@ -4,8 +4,10 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/Platform.h>
 #include <AK/Types.h>
 #include <assert.h>
+#include <elf.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <sys/internals.h>
@@ -19,6 +21,21 @@ extern bool s_global_initializers_ran;
 
 int main(int, char**, char**);
 
+#if ARCH(X86_64)
+// Statically linked programs aren't relocated by the dynamic loader, so the IFUNC relocations for
+// LibC's string functions (see arch/x86_64/string.cpp) are applied here. The linker only defines
+// these symbols for such programs.
+extern ElfW(Rela) const __rela_iplt_start[] __attribute__((weak));
+extern ElfW(Rela) const __rela_iplt_end[] __attribute__((weak));
+
+static void apply_ifunc_relocations()
+{
+    using IfuncResolver = FlatPtr (*)();
+    for (auto const* relocation = __rela_iplt_start; relocation < __rela_iplt_end; ++relocation)
+        *reinterpret_cast<FlatPtr*>(relocation->r_offset) = reinterpret_cast<IfuncResolver>(relocation->r_addend)();
+}
+#endif
+
 // Tell the compiler that this may be called from somewhere else.
 int _entry(int argc, char** argv, char** env) __attribute__((used));
 void _start(int, char**, char**) __attribute__((used));
@@ -32,6 +49,11 @@ NAKED void _start(int, char**, char**)
 
 int _entry(int argc, char** argv, char** env)
 {
+#if ARCH(X86_64)
+    // This has to happen before anything calls memcpy() and friends.
+    apply_ifunc_relocations();
+#endif
+
     size_t original_stack_chk = __stack_chk_guard;
     arc4random_buf(&__stack_chk_guard, sizeof(__stack_chk_guard));
 
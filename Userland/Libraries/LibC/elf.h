@@ -114,6 +114,7 @@ typedef uint16_t Elf64_Quarter;
 #define ELFOSABI_HPUX 1         /* HP-UX operating system */
 #define ELFOSABI_NETBSD 2       /* NetBSD */
 #define ELFOSABI_LINUX 3        /* GNU/Linux */
+#define ELFOSABI_GNU 3          /* GNU extensions, like IFUNC symbols */
 #define ELFOSABI_HURD 4         /* GNU/Hurd */
 #define ELFOSABI_86OPEN 5       /* 86Open common IA32 ABI */
 #define ELFOSABI_SOLARIS 6      /* Solaris */
@@ -374,14 +375,15 @@ typedef struct {
 #define STB_HIPROC 15 /*  specific symbol bindings */
 
 /* Symbol type - ELF32_ST_TYPE - st_info */
-#define STT_NOTYPE 0  /* not specified */
-#define STT_OBJECT 1  /* data object */
-#define STT_FUNC 2    /* function */
-#define STT_SECTION 3 /* section */
-#define STT_FILE 4    /* file */
-#define STT_TLS 6     /* thread local storage */
-#define STT_LOPROC 13 /* reserved range for processor */
-#define STT_HIPROC 15 /*  specific symbol types */
+#define STT_NOTYPE 0     /* not specified */
+#define STT_OBJECT 1     /* data object */
+#define STT_FUNC 2       /* function */
+#define STT_SECTION 3    /* section */
+#define STT_FILE 4       /* file */
+#define STT_TLS 6        /* thread local storage */
+#define STT_GNU_IFUNC 10 /* indirect function, the value is its resolver */
+#define STT_LOPROC 13    /* reserved range for processor */
+#define STT_HIPROC 15    /*  specific symbol types */
 
 /* Extract symbol visibility - st_other */
 #define ELF_ST_VISIBILITY(v) ((v)&0x3)
@@ -803,6 +805,7 @@ struct elf_args {
 #define R_386_RELATIVE 8   /* Base address + Addned */
 #define R_386_TLS_TPOFF 14 /* Negative offset into the static TLS storage */
 #define R_386_TLS_TPOFF32 37
+#define R_386_IRELATIVE 42 /* Result of calling the resolver at Base address + Addend */
 
 #define R_X86_64_NONE 0
 #define R_X86_64_64 1
@@ -810,3 +813,4 @@ struct elf_args {
 #define R_X86_64_JUMP_SLOT 7
 #define R_X86_64_RELATIVE 8
 #define R_X86_64_TPOFF64 18
+#define R_X86_64_IRELATIVE 37
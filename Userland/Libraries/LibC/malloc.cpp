@@ -50,6 +50,14 @@ constexpr size_t number_of_hot_chunked_blocks_to_keep_around = 16;
 constexpr size_t number_of_cold_chunked_blocks_to_keep_around = 16;
 constexpr size_t number_of_big_blocks_to_keep_around_per_size_class = 8;
 
+// Freed chunks of up to this size go into a cache owned by the freeing thread, and
+// allocations of those sizes are served from it without taking s_malloc_mutex.
+// Each size class may hold up to thread_cache_bytes_per_size_class worth of chunks.
+constexpr size_t max_thread_cached_chunk_size = 4 * KiB;
+constexpr size_t thread_cache_bytes_per_size_class = 8 * KiB;
+constexpr size_t min_thread_cached_chunks_per_size_class = 2;
+constexpr size_t max_thread_cached_chunks_per_size_class = 64;
+
 static bool s_log_malloc = false;
 static bool s_scrub_malloc = true;
 static bool s_scrub_free = true;
@@ -93,9 +101,29 @@ struct MemoryAuditingSuppressor {
     }
 };
 
-struct MallocStats {
+// These are counted by each thread without taking s_malloc_mutex.
+struct ThreadMallocStats {
     size_t number_of_malloc_calls;
+    size_t number_of_thread_cache_hits;
+    size_t number_of_thread_cache_refills;
+
+    size_t number_of_free_calls;
+    size_t number_of_thread_cache_keeps;
+    size_t number_of_thread_cache_flushes;
+
+    void add(ThreadMallocStats const& other)
+    {
+        number_of_malloc_calls += other.number_of_malloc_calls;
+        number_of_thread_cache_hits += other.number_of_thread_cache_hits;
+        number_of_thread_cache_refills += other.number_of_thread_cache_refills;
+        number_of_free_calls += other.number_of_free_calls;
+        number_of_thread_cache_keeps += other.number_of_thread_cache_keeps;
+        number_of_thread_cache_flushes += other.number_of_thread_cache_flushes;
+    }
+};
 
+// Everything else is only touched while holding s_malloc_mutex.
+struct MallocStats {
     size_t number_of_big_allocator_hits;
     size_t number_of_big_allocator_purge_hits;
     size_t number_of_big_allocs;
@@ -106,8 +134,6 @@ struct MallocStats {
     size_t number_of_block_allocs;
     size_t number_of_blocks_full;
 
-    size_t number_of_free_calls;
-
     size_t number_of_big_allocator_keeps;
     size_t number_of_big_allocator_frees;
 
@@ -115,6 +141,9 @@ struct MallocStats {
     size_t number_of_hot_keeps;
     size_t number_of_cold_keeps;
     size_t number_of_frees;
+
+    // The counters of threads that have exited, and so no longer have a ThreadCache.
+    ThreadMallocStats exited_threads;
 };
 static MallocStats g_malloc_stats = {};
 
@@ -165,6 +194,45 @@ static Allocator* allocator_for_size(size_t size, size_t& good_size)
     return nullptr;
 }
 
+struct ThreadCache {
+    FreelistEntry* chunks[num_size_classes];
+    size_t chunk_counts[num_size_classes];
+    ThreadMallocStats stats;
+
+    // All registered caches are kept in the s_thread_caches list, so their statistics can
+    // be summed up and the cache can be emptied when the thread exits.
+    bool is_registered;
+    ThreadCache* next;
+};
+
+// Guarded by s_malloc_mutex.
+static ThreadCache* s_thread_caches { nullptr };
+
+#ifdef NO_TLS
+// The dynamic loader only ever runs on a single thread.
+static ThreadCache s_thread_cache;
+#else
+// This must not have an initializer, see the comment on s_allocation_enabled.
+static __thread ThreadCache s_thread_cache;
+#endif
+
+static constexpr size_t thread_cache_capacity(size_t size_class)
+{
+    return clamp(thread_cache_bytes_per_size_class / size_classes[size_class], min_thread_cached_chunks_per_size_class, max_thread_cached_chunks_per_size_class);
+}
+
+// Chunks move between a thread cache and the ChunkedBlocks in batches of half the cache,
+// so a thread that keeps allocating or freeing only takes the lock once per batch.
+static constexpr size_t thread_cache_batch_size(size_t size_class)
+{
+    return thread_cache_capacity(size_class) / 2;
+}
+
+static size_t size_class_index(Allocator const& allocator)
+{
+    return &allocator - allocators();
+}
+
 #ifdef RECYCLE_BIG_ALLOCATIONS
 static BigAllocator* big_allocator_for_size(size_t size)
 {
@@ -208,73 +276,11 @@ enum class CallerWillInitializeMemory {
 __thread bool s_allocation_enabled;
 #endif
 
-static void* malloc_impl(size_t size, CallerWillInitializeMemory caller_will_initialize_memory)
+// Must be called with s_malloc_mutex held.
+static void* allocate_chunk(Allocator& allocator, size_t good_size)
 {
-#ifndef NO_TLS
-    VERIFY(s_allocation_enabled);
-#endif
-
-    if (s_log_malloc)
-        dbgln("LibC: malloc({})", size);
-
-    if (!size) {
-        // Legally we could just return a null pointer here, but this is more
-        // compatible with existing software.
-        size = 1;
-    }
-
-    g_malloc_stats.number_of_malloc_calls++;
-
-    size_t good_size;
-    auto* allocator = allocator_for_size(size, good_size);
-
-    PthreadMutexLocker locker(s_malloc_mutex);
-
-    if (!allocator) {
-        size_t real_size = round_up_to_power_of_two(sizeof(BigAllocationBlock) + size, ChunkedBlock::block_size);
-        if (real_size < size) {
-            dbgln_if(MALLOC_DEBUG, "LibC: Detected overflow trying to do big allocation of size {} for {}", real_size, size);
-            errno = ENOMEM;
-            return nullptr;
-        }
-#ifdef RECYCLE_BIG_ALLOCATIONS
-        if (auto* allocator = big_allocator_for_size(real_size)) {
-            if (!allocator->blocks.is_empty()) {
-                g_malloc_stats.number_of_big_allocator_hits++;
-                auto* block = allocator->blocks.take_last();
-                int rc = madvise(block, real_size, MADV_SET_NONVOLATILE);
-                bool this_block_was_purged = rc == 1;
-                if (rc < 0) {
-                    perror("madvise");
-                    VERIFY_NOT_REACHED();
-                }
-                if (mprotect(block, real_size, PROT_READ | PROT_WRITE) < 0) {
-                    perror("mprotect");
-                    VERIFY_NOT_REACHED();
-                }
-                if (this_block_was_purged) {
-                    g_malloc_stats.number_of_big_allocator_purge_hits++;
-                    new (block) BigAllocationBlock(real_size);
-                }
-
-                ue_notify_malloc(&block->m_slot[0], size);
-                return &block->m_slot[0];
-            }
-        }
-#endif
-        auto* block = (BigAllocationBlock*)os_alloc(real_size, "malloc: BigAllocationBlock");
-        if (block == nullptr) {
-            dbgln_if(MALLOC_DEBUG, "LibC: Failed to do big allocation of size {} for {}", real_size, size);
-            return nullptr;
-        }
-        g_malloc_stats.number_of_big_allocs++;
-        new (block) BigAllocationBlock(real_size);
-        ue_notify_malloc(&block->m_slot[0], size);
-        return &block->m_slot[0];
-    }
-
     ChunkedBlock* block = nullptr;
-    for (auto& current : allocator->usable_blocks) {
+    for (auto& current : allocator.usable_blocks) {
         if (current.free_chunks()) {
             block = &current;
             break;
@@ -291,7 +297,7 @@ static void* malloc_impl(size_t size, CallerWillInitializeMemory caller_will_ini
             snprintf(buffer, sizeof(buffer), "malloc: ChunkedBlock(%zu)", good_size);
             set_mmap_name(block, ChunkedBlock::block_size, buffer);
         }
-        allocator->usable_blocks.append(*block);
+        allocator.usable_blocks.append(*block);
     }
 
     if (!block && s_cold_empty_block_count) {
@@ -314,7 +320,7 @@ static void* malloc_impl(size_t size, CallerWillInitializeMemory caller_will_ini
             new (block) ChunkedBlock(good_size);
             ue_notify_chunk_size_changed(block, good_size);
         }
-        allocator->usable_blocks.append(*block);
+        allocator.usable_blocks.append(*block);
     }
 
     if (!block) {
@@ -326,8 +332,8 @@ static void* malloc_impl(size_t size, CallerWillInitializeMemory caller_will_ini
             return nullptr;
         }
         new (block) ChunkedBlock(good_size);
-        allocator->usable_blocks.append(*block);
-        ++allocator->block_count;
+        allocator.usable_blocks.append(*block);
+        ++allocator.block_count;
     }
 
     --block->m_free_chunks;
@@ -342,13 +348,211 @@ static void* malloc_impl(size_t size, CallerWillInitializeMemory caller_will_ini
     if (block->is_full()) {
         g_malloc_stats.number_of_blocks_full++;
         dbgln_if(MALLOC_DEBUG, "Block {:p} is now full in size class {}", block, good_size);
-        allocator->usable_blocks.remove(*block);
-        allocator->full_blocks.append(*block);
+        allocator.usable_blocks.remove(*block);
+        allocator.full_blocks.append(*block);
     }
     dbgln_if(MALLOC_DEBUG, "LibC: allocated {:p} (chunk in block {:p}, size {})", ptr, block, block->bytes_per_chunk());
+    return ptr;
+}
+
+// Must be called with s_malloc_mutex held.
+static void free_chunk(void* ptr)
+{
+    auto* block = (ChunkedBlock*)((FlatPtr)ptr & ChunkedBlock::block_mask);
+    VERIFY(block->m_magic == MAGIC_PAGE_HEADER);
+
+    auto* entry = (FreelistEntry*)ptr;
+    entry->next = block->m_freelist;
+    block->m_freelist = entry;
+
+    if (block->is_full()) {
+        size_t good_size;
+        auto* allocator = allocator_for_size(block->m_size, good_size);
+        dbgln_if(MALLOC_DEBUG, "Block {:p} no longer full in size class {}", block, good_size);
+        g_malloc_stats.number_of_freed_full_blocks++;
+        allocator->full_blocks.remove(*block);
+        allocator->usable_blocks.prepend(*block);
+    }
+
+    ++block->m_free_chunks;
+
+    if (!block->used_chunks()) {
+        size_t good_size;
+        auto* allocator = allocator_for_size(block->m_size, good_size);
+        if (s_hot_empty_block_count < number_of_hot_chunked_blocks_to_keep_around) {
+            dbgln_if(MALLOC_DEBUG, "Keeping hot block {:p} around", block);
+            g_malloc_stats.number_of_hot_keeps++;
+            allocator->usable_blocks.remove(*block);
+            s_hot_empty_blocks[s_hot_empty_block_count++] = block;
+            return;
+        }
+        if (s_cold_empty_block_count < number_of_cold_chunked_blocks_to_keep_around) {
+            dbgln_if(MALLOC_DEBUG, "Keeping cold block {:p} around", block);
+            g_malloc_stats.number_of_cold_keeps++;
+            allocator->usable_blocks.remove(*block);
+            s_cold_empty_blocks[s_cold_empty_block_count++] = block;
+            mprotect(block, ChunkedBlock::block_size, PROT_NONE);
+            madvise(block, ChunkedBlock::block_size, MADV_SET_VOLATILE);
+            return;
+        }
+        dbgln_if(MALLOC_DEBUG, "Releasing block {:p} for size class {}", block, good_size);
+        g_malloc_stats.number_of_frees++;
+        allocator->usable_blocks.remove(*block);
+        --allocator->block_count;
+        os_free(block, ChunkedBlock::block_size);
+    }
+}
+
+static void register_thread_cache()
+{
+    PthreadMutexLocker locker(s_malloc_mutex);
+    s_thread_cache.next = s_thread_caches;
+    s_thread_caches = &s_thread_cache;
+    s_thread_cache.is_registered = true;
+}
+
+ALWAYS_INLINE static ThreadCache& thread_cache()
+{
+    if (!s_thread_cache.is_registered) [[unlikely]]
+        register_thread_cache();
+    return s_thread_cache;
+}
+
+static void* allocate_chunk_from_thread_cache(Allocator& allocator, size_t good_size)
+{
+    auto& cache = s_thread_cache;
+    auto size_class = size_class_index(allocator);
+
+    if (cache.chunk_counts[size_class]) {
+        cache.stats.number_of_thread_cache_hits++;
+    } else {
+        PthreadMutexLocker locker(s_malloc_mutex);
+        cache.stats.number_of_thread_cache_refills++;
+        for (size_t i = 0; i < thread_cache_batch_size(size_class); ++i) {
+            auto* entry = (FreelistEntry*)allocate_chunk(allocator, good_size);
+            if (!entry)
+                break;
+            entry->next = cache.chunks[size_class];
+            cache.chunks[size_class] = entry;
+            ++cache.chunk_counts[size_class];
+        }
+        if (!cache.chunk_counts[size_class])
+            return nullptr;
+    }
+
+    auto* entry = cache.chunks[size_class];
+    cache.chunks[size_class] = entry->next;
+    --cache.chunk_counts[size_class];
+    return entry;
+}
+
+// Must be called with s_malloc_mutex held.
+static void flush_thread_cache(ThreadCache& cache, size_t size_class, size_t count)
+{
+    for (; count && cache.chunk_counts[size_class]; --count) {
+        auto* entry = cache.chunks[size_class];
+        cache.chunks[size_class] = entry->next;
+        --cache.chunk_counts[size_class];
+        free_chunk(entry);
+    }
+}
+
+static void free_chunk_to_thread_cache(ChunkedBlock& block, void* ptr)
+{
+    auto& cache = s_thread_cache;
+    size_t good_size;
+    auto size_class = size_class_index(*allocator_for_size(block.m_size, good_size));
+
+    if (cache.chunk_counts[size_class] >= thread_cache_capacity(size_class)) {
+        PthreadMutexLocker locker(s_malloc_mutex);
+        cache.stats.number_of_thread_cache_flushes++;
+        flush_thread_cache(cache, size_class, thread_cache_batch_size(size_class));
+    }
+
+    cache.stats.number_of_thread_cache_keeps++;
+    auto* entry = (FreelistEntry*)ptr;
+    entry->next = cache.chunks[size_class];
+    cache.chunks[size_class] = entry;
+    ++cache.chunk_counts[size_class];
+}
+
+static void* malloc_impl(size_t size, CallerWillInitializeMemory caller_will_initialize_memory)
+{
+#ifndef NO_TLS
+    VERIFY(s_allocation_enabled);
+#endif
+
+    if (s_log_malloc)
+        dbgln("LibC: malloc({})", size);
+
+    if (!size) {
+        // Legally we could just return a null pointer here, but this is more
+        // compatible with existing software.
+        size = 1;
+    }
+
+    thread_cache().stats.number_of_malloc_calls++;
+
+    size_t good_size;
+    auto* allocator = allocator_for_size(size, good_size);
+
+    if (!allocator) {
+        PthreadMutexLocker locker(s_malloc_mutex);
+
+        size_t real_size = round_up_to_power_of_two(sizeof(BigAllocationBlock) + size, ChunkedBlock::block_size);
+        if (real_size < size) {
+            dbgln_if(MALLOC_DEBUG, "LibC: Detected overflow trying to do big allocation of size {} for {}", real_size, size);
+            errno = ENOMEM;
+            return nullptr;
+        }
+#ifdef RECYCLE_BIG_ALLOCATIONS
+        if (auto* allocator = big_allocator_for_size(real_size)) {
+            if (!allocator->blocks.is_empty()) {
+                g_malloc_stats.number_of_big_allocator_hits++;
+                auto* block = allocator->blocks.take_last();
+                int rc = madvise(block, real_size, MADV_SET_NONVOLATILE);
+                bool this_block_was_purged = rc == 1;
+                if (rc < 0) {
+                    perror("madvise");
+                    VERIFY_NOT_REACHED();
+                }
+                if (mprotect(block, real_size, PROT_READ | PROT_WRITE) < 0) {
+                    perror("mprotect");
+                    VERIFY_NOT_REACHED();
+                }
+                if (this_block_was_purged) {
+                    g_malloc_stats.number_of_big_allocator_purge_hits++;
+                    new (block) BigAllocationBlock(real_size);
+                }
+
+                ue_notify_malloc(&block->m_slot[0], size);
+                return &block->m_slot[0];
+            }
+        }
+#endif
+        auto* block = (BigAllocationBlock*)os_alloc(real_size, "malloc: BigAllocationBlock");
+        if (block == nullptr) {
+            dbgln_if(MALLOC_DEBUG, "LibC: Failed to do big allocation of size {} for {}", real_size, size);
+            return nullptr;
+        }
+        g_malloc_stats.number_of_big_allocs++;
+        new (block) BigAllocationBlock(real_size);
+        ue_notify_malloc(&block->m_slot[0], size);
+        return &block->m_slot[0];
+    }
+
+    void* ptr = nullptr;
+    if (good_size <= max_thread_cached_chunk_size) {
+        ptr = allocate_chunk_from_thread_cache(*allocator, good_size);
+    } else {
+        PthreadMutexLocker locker(s_malloc_mutex);
+        ptr = allocate_chunk(*allocator, good_size);
+    }
+    if (!ptr)
+        return nullptr;
 
     if (s_scrub_malloc && caller_will_initialize_memory == CallerWillInitializeMemory::No)
-        memset(ptr, MALLOC_SCRUB_BYTE, block->m_size);
+        memset(ptr, MALLOC_SCRUB_BYTE, good_size);
 
     ue_notify_malloc(ptr, size);
     return ptr;
@@ -365,14 +569,13 @@ static void free_impl(void* ptr)
     if (!ptr)
         return;
 
-    g_malloc_stats.number_of_free_calls++;
+    thread_cache().stats.number_of_free_calls++;
 
     void* block_base = (void*)((FlatPtr)ptr & ChunkedBlock::ChunkedBlock::block_mask);
     size_t magic = *(size_t*)block_base;
 
-    PthreadMutexLocker locker(s_malloc_mutex);
-
     if (magic == MAGIC_BIGALLOC_HEADER) {
+        PthreadMutexLocker locker(s_malloc_mutex);
         auto* block = (BigAllocationBlock*)block_base;
 #ifdef RECYCLE_BIG_ALLOCATIONS
         if (auto* allocator = big_allocator_for_size(block->m_size)) {
@@ -405,46 +608,16 @@ static void free_impl(void* ptr)
     if (s_scrub_free)
         memset(ptr, FREE_SCRUB_BYTE, block->bytes_per_chunk());
 
-    auto* entry = (FreelistEntry*)ptr;
-    entry->next = block->m_freelist;
-    block->m_freelist = entry;
-
-    if (block->is_full()) {
-        size_t good_size;
-        auto* allocator = allocator_for_size(block->m_size, good_size);
-        dbgln_if(MALLOC_DEBUG, "Block {:p} no longer full in size class {}", block, good_size);
-        g_malloc_stats.number_of_freed_full_blocks++;
-        allocator->full_blocks.remove(*block);
-        allocator->usable_blocks.prepend(*block);
+    // Chunks are cached by the thread freeing them, whichever thread allocated them.
+    // The ChunkedBlocks themselves are shared, so a chunk can be handed out again by any
+    // thread, and there's no owner that would have to be told about the free.
+    if (block->bytes_per_chunk() <= max_thread_cached_chunk_size) {
+        free_chunk_to_thread_cache(*block, ptr);
+        return;
     }
 
-    ++block->m_free_chunks;
-
-    if (!block->used_chunks()) {
-        size_t good_size;
-        auto* allocator = allocator_for_size(block->m_size, good_size);
-        if (s_hot_empty_block_count < number_of_hot_chunked_blocks_to_keep_around) {
-            dbgln_if(MALLOC_DEBUG, "Keeping hot block {:p} around", block);
-            g_malloc_stats.number_of_hot_keeps++;
-            allocator->usable_blocks.remove(*block);
-            s_hot_empty_blocks[s_hot_empty_block_count++] = block;
-            return;
-        }
-        if (s_cold_empty_block_count < number_of_cold_chunked_blocks_to_keep_around) {
-            dbgln_if(MALLOC_DEBUG, "Keeping cold block {:p} around", block);
-            g_malloc_stats.number_of_cold_keeps++;
-            allocator->usable_blocks.remove(*block);
-            s_cold_empty_blocks[s_cold_empty_block_count++] = block;
-            mprotect(block, ChunkedBlock::block_size, PROT_NONE);
-            madvise(block, ChunkedBlock::block_size, MADV_SET_VOLATILE);
-            return;
-        }
-        dbgln_if(MALLOC_DEBUG, "Releasing block {:p} for size class {}", block, good_size);
-        g_malloc_stats.number_of_frees++;
-        allocator->usable_blocks.remove(*block);
-        --allocator->block_count;
-        os_free(block, ChunkedBlock::block_size);
-    }
+    PthreadMutexLocker locker(s_malloc_mutex);
+    free_chunk(ptr);
 }
 
 // https://pubs.opengroup.org/onlinepubs/9699919799/functions/malloc.html
@@ -565,6 +738,27 @@ void* realloc(void* ptr, size_t size)
     return new_ptr;
 }
 
+void __malloc_destroy_thread_cache()
+{
+    MemoryAuditingSuppressor suppressor;
+    auto& cache = s_thread_cache;
+    if (!cache.is_registered)
+        return;
+
+    PthreadMutexLocker locker(s_malloc_mutex);
+    for (size_t size_class = 0; size_class < num_size_classes; ++size_class)
+        flush_thread_cache(cache, size_class, cache.chunk_counts[size_class]);
+    g_malloc_stats.exited_threads.add(cache.stats);
+
+    for (auto** it = &s_thread_caches; *it; it = &(*it)->next) {
+        if (*it == &cache) {
+            *it = cache.next;
+            break;
+        }
+    }
+    cache = {};
+}
+
 void __malloc_init()
 {
 #ifndef NO_TLS
@@ -600,26 +794,52 @@ void __malloc_init()
 
 void serenity_dump_malloc_stats()
 {
-    dbgln("# malloc() calls: {}", g_malloc_stats.number_of_malloc_calls);
+    // Take a snapshot first, since logging may allocate.
+    MallocStats stats;
+    ThreadMallocStats thread_stats;
+    size_t thread_cache_count = 0;
+    size_t thread_cached_bytes = 0;
+    {
+        PthreadMutexLocker locker(s_malloc_mutex);
+        stats = g_malloc_stats;
+        thread_stats = g_malloc_stats.exited_threads;
+        for (auto* cache = s_thread_caches; cache; cache = cache->next) {
+            ++thread_cache_count;
+            thread_stats.add(cache->stats);
+            for (size_t size_class = 0; size_class < num_size_classes; ++size_class)
+                thread_cached_bytes += cache->chunk_counts[size_class] * size_classes[size_class];
+        }
+    }
+
+    dbgln("# malloc() calls: {}", thread_stats.number_of_malloc_calls);
+    dbgln();
+    dbgln("thread cache hits: {}", thread_stats.number_of_thread_cache_hits);
+    dbgln("thread cache refills: {}", thread_stats.number_of_thread_cache_refills);
+    dbgln();
+    dbgln("big alloc hits: {}", stats.number_of_big_allocator_hits);
+    dbgln("big alloc hits that were purged: {}", stats.number_of_big_allocator_purge_hits);
+    dbgln("big allocs: {}", stats.number_of_big_allocs);
+    dbgln();
+    dbgln("empty hot block hits: {}", stats.number_of_hot_empty_block_hits);
+    dbgln("empty cold block hits: {}", stats.number_of_cold_empty_block_hits);
+    dbgln("empty cold block hits that were purged: {}", stats.number_of_cold_empty_block_purge_hits);
+    dbgln("block allocs: {}", stats.number_of_block_allocs);
+    dbgln("filled blocks: {}", stats.number_of_blocks_full);
     dbgln();
-    dbgln("big alloc hits: {}", g_malloc_stats.number_of_big_allocator_hits);
-    dbgln("big alloc hits that were purged: {}", g_malloc_stats.number_of_big_allocator_purge_hits);
-    dbgln("big allocs: {}", g_malloc_stats.number_of_big_allocs);
+    dbgln("# free() calls: {}", thread_stats.number_of_free_calls);
     dbgln();
-    dbgln("empty hot block hits: {}", g_malloc_stats.number_of_hot_empty_block_hits);
-    dbgln("empty cold block hits: {}", g_malloc_stats.number_of_cold_empty_block_hits);
-    dbgln("empty cold block hits that were purged: {}", g_malloc_stats.number_of_cold_empty_block_purge_hits);
-    dbgln("block allocs: {}", g_malloc_stats.number_of_block_allocs);
-    dbgln("filled blocks: {}", g_malloc_stats.number_of_blocks_full);
+    dbgln("thread cache keeps: {}", thread_stats.number_of_thread_cache_keeps);
+    dbgln("thread cache flushes: {}", thread_stats.number_of_thread_cache_flushes);
     dbgln();
-    dbgln("# free() calls: {}", g_malloc_stats.number_of_free_calls);
+    dbgln("big alloc keeps: {}", stats.number_of_big_allocator_keeps);
+    dbgln("big alloc frees: {}", stats.number_of_big_allocator_frees);
     dbgln();
-    dbgln("big alloc keeps: {}", g_malloc_stats.number_of_big_allocator_keeps);
-    dbgln("big alloc frees: {}", g_malloc_stats.number_of_big_allocator_frees);
+    dbgln("full block frees: {}", stats.number_of_freed_full_blocks);
+    dbgln("number of hot keeps: {}", stats.number_of_hot_keeps);
+    dbgln("number of cold keeps: {}", stats.number_of_cold_keeps);
+    dbgln("number of frees: {}", stats.number_of_frees);
     dbgln();
-    dbgln("full block frees: {}", g_malloc_stats.number_of_freed_full_blocks);
-    dbgln("number of hot keeps: {}", g_malloc_stats.number_of_hot_keeps);
-    dbgln("number of cold keeps: {}", g_malloc_stats.number_of_cold_keeps);
-    dbgln("number of frees: {}", g_malloc_stats.number_of_frees);
+    dbgln("live thread caches: {}", thread_cache_count);
+    dbgln("bytes in thread caches: {}", thread_cached_bytes);
 }
 }
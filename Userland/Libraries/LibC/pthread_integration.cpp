@@ -156,7 +156,7 @@ int __pthread_mutex_lock(pthread_mutex_t* mutex)
         value = AK::atomic_exchange(&mutex->lock, MUTEX_LOCKED_NEED_TO_WAKE, AK::memory_order_acquire);
 
     while (value != MUTEX_UNLOCKED) {
-        futex_wait(&mutex->lock, value, nullptr, 0);
+        futex_wait(&mutex->lock, value, nullptr, 0, false);
         value = AK::atomic_exchange(&mutex->lock, MUTEX_LOCKED_NEED_TO_WAKE, AK::memory_order_acquire);
     }
 
@@ -175,7 +175,7 @@ int __pthread_mutex_lock_pessimistic_np(pthread_mutex_t* mutex)
     // because we know we don't. Used in the condition variable implementation.
     u32 value = AK::atomic_exchange(&mutex->lock, MUTEX_LOCKED_NEED_TO_WAKE, AK::memory_order_acquire);
     while (value != MUTEX_UNLOCKED) {
-        futex_wait(&mutex->lock, value, nullptr, 0);
+        futex_wait(&mutex->lock, value, nullptr, 0, false);
         value = AK::atomic_exchange(&mutex->lock, MUTEX_LOCKED_NEED_TO_WAKE, AK::memory_order_acquire);
     }
 
@@ -197,7 +197,7 @@ int __pthread_mutex_unlock(pthread_mutex_t* mutex)
 
     u32 value = AK::atomic_exchange(&mutex->lock, MUTEX_UNLOCKED, AK::memory_order_release);
     if (value == MUTEX_LOCKED_NEED_TO_WAKE) [[unlikely]] {
-        int rc = futex_wake(&mutex->lock, 1);
+        int rc = futex_wake(&mutex->lock, 1, false);
         VERIFY(rc >= 0);
     }
 
@@ -42,7 +42,9 @@ int futex(uint32_t* userspace_address, int futex_op, uint32_t value, const struc
 {
     int rc;
     switch (futex_op & FUTEX_CMD_MASK) {
-    case FUTEX_WAKE_OP: {
+    case FUTEX_WAKE_OP:
+    case FUTEX_REQUEUE:
+    case FUTEX_CMP_REQUEUE: {
         // These interpret timeout as a u32 value for val2
         Syscall::SC_futex_params params {
             .userspace_address = userspace_address,
@@ -173,4 +175,37 @@ int serenity_open(char const* path, size_t path_length, int options, ...)
 
     __RETURN_WITH_ERRNO(rc, rc, -1);
 }
+
+int create_readiness_set(int flags)
+{
+    int rc = syscall(SC_create_readiness_set, flags);
+    __RETURN_WITH_ERRNO(rc, rc, -1);
+}
+
+int readiness_set_control(int set_fd, int operation, int fd, uint32_t events, uint64_t user_data)
+{
+    Syscall::SC_readiness_set_control_params params { set_fd, operation, fd, events, user_data };
+    int rc = syscall(SC_readiness_set_control, &params);
+    __RETURN_WITH_ERRNO(rc, rc, -1);
+}
+
+int readiness_set_wait(int set_fd, struct readiness_event* events, size_t max_events, const struct timespec* timeout)
+{
+    Syscall::SC_readiness_set_wait_params params { set_fd, events, max_events, timeout };
+    int rc = syscall(SC_readiness_set_wait, &params);
+    __RETURN_WITH_ERRNO(rc, rc, -1);
+}
+
+int io_ring_create(uint32_t entries, int flags, struct io_ring_params* params)
+{
+    int rc = syscall(SC_io_ring_create, entries, flags, params);
+    __RETURN_WITH_ERRNO(rc, rc, -1);
+}
+
+int io_ring_enter(int ring_fd, uint32_t to_submit, uint32_t min_complete, const struct timespec* timeout)
+{
+    Syscall::SC_io_ring_enter_params params { ring_fd, to_submit, min_complete, timeout };
+    int rc = syscall(SC_io_ring_enter, &params);
+    __RETURN_WITH_ERRNO(rc, rc, -1);
+}
 }
@@ -22,7 +22,9 @@ int profiling_free_buffer(pid_t);
 
 int futex(uint32_t* userspace_address, int futex_op, uint32_t value, const struct timespec* timeout, uint32_t* userspace_address2, uint32_t value3);
 
-static ALWAYS_INLINE int futex_wait(uint32_t* userspace_address, uint32_t value, const struct timespec* abstime, int clockid)
+// Futexes that are never touched by another process should pass process_shared = 0,
+// which saves the kernel from looking up the memory region that backs them.
+static ALWAYS_INLINE int futex_wait(uint32_t* userspace_address, uint32_t value, const struct timespec* abstime, int clockid, int process_shared)
 {
     int op;
 
@@ -34,12 +36,14 @@ static ALWAYS_INLINE int futex_wait(uint32_t* userspace_address, uint32_t value,
     } else {
         op = FUTEX_WAIT;
     }
+    if (!process_shared)
+        op |= FUTEX_PRIVATE_FLAG;
     return futex(userspace_address, op, value, abstime, NULL, FUTEX_BITSET_MATCH_ANY);
 }
 
-static ALWAYS_INLINE int futex_wake(uint32_t* userspace_address, uint32_t count)
+static ALWAYS_INLINE int futex_wake(uint32_t* userspace_address, uint32_t count, int process_shared)
 {
-    return futex(userspace_address, FUTEX_WAKE, count, NULL, NULL, 0);
+    return futex(userspace_address, process_shared ? FUTEX_WAKE : (FUTEX_WAKE | FUTEX_PRIVATE_FLAG), count, NULL, NULL, 0);
 }
 
 int purge(int mode);
@@ -62,4 +66,11 @@ int emuctl(uintptr_t command, uintptr_t arg0, uintptr_t arg1);
 
 int serenity_open(char const* path, size_t path_length, int options, ...);
 
+int create_readiness_set(int flags);
+int readiness_set_control(int set_fd, int operation, int fd, uint32_t events, uint64_t user_data);
+int readiness_set_wait(int set_fd, struct readiness_event* events, size_t max_events, const struct timespec* timeout);
+
+int io_ring_create(uint32_t entries, int flags, struct io_ring_params* params);
+int io_ring_enter(int ring_fd, uint32_t to_submit, uint32_t min_complete, const struct timespec* timeout);
+
 __END_DECLS
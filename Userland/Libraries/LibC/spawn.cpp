@@ -18,9 +18,13 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <stdio.h>
+#include <limits.h>
+#include <signal.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/wait.h>
 #include <unistd.h>
 
 struct posix_spawn_file_actions_state {
@@ -29,57 +33,80 @@ struct posix_spawn_file_actions_state {
 
 extern "C" {
 
-[[noreturn]] static void posix_spawn_child(const char* path, const posix_spawn_file_actions_t* file_actions, const posix_spawnattr_t* attr, char* const argv[], char* const envp[], int (*exec)(const char*, char* const[], char* const[]))
+// Like execvpe(), but without allocating. The child shares our heap until it has exec'd.
+static int execvpe_without_allocating(const char* filename, char* const argv[], char* const envp[])
 {
+    if (strchr(filename, '/'))
+        return execve(filename, argv, envp);
+
+    const char* path = getenv("PATH");
+    if (!path || !*path)
+        path = "/bin:/usr/bin";
+    size_t filename_length = strlen(filename);
+    for (const char* part = path; *part;) {
+        const char* part_end = strchrnul(part, ':');
+        size_t part_length = part_end - part;
+        char candidate[PATH_MAX];
+        if (part_length > 0 && part_length + 1 + filename_length < sizeof(candidate)) {
+            memcpy(candidate, part, part_length);
+            candidate[part_length] = '/';
+            memcpy(candidate + part_length + 1, filename, filename_length + 1);
+            if (execve(candidate, argv, envp) < 0 && errno != ENOENT)
+                return -1;
+        }
+        part = *part_end ? part_end + 1 : part_end;
+    }
+    errno = ENOENT;
+    return -1;
+}
+
+// NOTE: This runs in a child created by vfork(), on the memory of the process calling posix_spawn().
+//       So it must not allocate or touch any state of the parent, and it reports failure by leaving
+//       the errno for posix_spawn() to return in `error` rather than printing anything.
+[[noreturn]] static void posix_spawn_child(const char* path, const posix_spawn_file_actions_t* file_actions, const posix_spawnattr_t* attr, char* const argv[], char* const envp[], int (*exec)(const char*, char* const[], char* const[]), const sigset_t& parent_signal_mask, volatile int* error)
+{
+    auto fail = [&] {
+        *error = errno;
+        _exit(127);
+    };
+
+    // The parent's signal handlers would run on its memory as well, so don't let any of them
+    // run before exec() gets rid of them. Signals are blocked until we get to exec().
+    struct sigaction default_action;
+    default_action.sa_flags = 0;
+    sigemptyset(&default_action.sa_mask);
+    default_action.sa_handler = SIG_DFL;
+    bool should_set_defaults = attr && (attr->flags & POSIX_SPAWN_SETSIGDEF);
+    for (int signal = 1; signal < NSIG; ++signal) {
+        if (should_set_defaults && sigismember(&attr->sigdefault, signal)) {
+            if (sigaction(signal, &default_action, nullptr) < 0)
+                fail();
+            continue;
+        }
+        struct sigaction action;
+        if (sigaction(signal, nullptr, &action) == 0 && action.sa_handler != SIG_DFL && action.sa_handler != SIG_IGN)
+            (void)sigaction(signal, &default_action, nullptr);
+    }
+
     if (attr) {
         short flags = attr->flags;
         if (flags & POSIX_SPAWN_RESETIDS) {
-            if (seteuid(getuid()) < 0) {
-                perror("posix_spawn seteuid");
-                _exit(127);
-            }
-            if (setegid(getgid()) < 0) {
-                perror("posix_spawn setegid");
-                _exit(127);
-            }
+            if (seteuid(getuid()) < 0)
+                fail();
+            if (setegid(getgid()) < 0)
+                fail();
         }
         if (flags & POSIX_SPAWN_SETPGROUP) {
-            if (setpgid(0, attr->pgroup) < 0) {
-                perror("posix_spawn setpgid");
-                _exit(127);
-            }
+            if (setpgid(0, attr->pgroup) < 0)
+                fail();
         }
         if (flags & POSIX_SPAWN_SETSCHEDPARAM) {
-            if (sched_setparam(0, &attr->schedparam) < 0) {
-                perror("posix_spawn sched_setparam");
-                _exit(127);
-            }
-        }
-        if (flags & POSIX_SPAWN_SETSIGDEF) {
-            struct sigaction default_action;
-            default_action.sa_flags = 0;
-            sigemptyset(&default_action.sa_mask);
-            default_action.sa_handler = SIG_DFL;
-
-            sigset_t sigdefault = attr->sigdefault;
-            for (int i = 0; i < NSIG; ++i) {
-                if (sigismember(&sigdefault, i) && sigaction(i, &default_action, nullptr) < 0) {
-                    perror("posix_spawn sigaction");
-                    _exit(127);
-                }
-            }
-        }
-        if (flags & POSIX_SPAWN_SETSIGMASK) {
-            if (sigprocmask(SIG_SETMASK, &attr->sigmask, nullptr) < 0) {
-                perror("posix_spawn sigprocmask");
-                _exit(127);
-            }
+            if (sched_setparam(0, &attr->schedparam) < 0)
+                fail();
         }
         if (flags & POSIX_SPAWN_SETSID) {
-            if (setsid() < 0) {
-                perror("posix_spawn setsid");
-                _exit(127);
-            }
+            if (setsid() < 0)
+                fail();
         }
 
         // FIXME: POSIX_SPAWN_SETSCHEDULER
@@ -87,46 +114,60 @@ extern "C" {
 
     if (file_actions) {
         for (const auto& action : file_actions->state->actions) {
-            if (action() < 0) {
-                perror("posix_spawn file action");
-                _exit(127);
-            }
+            if (action() < 0)
+                fail();
         }
     }
 
+    auto const& signal_mask = attr && (attr->flags & POSIX_SPAWN_SETSIGMASK) ? attr->sigmask : parent_signal_mask;
+    if (sigprocmask(SIG_SETMASK, &signal_mask, nullptr) < 0)
+        fail();
+
     exec(path, argv, envp);
-    perror("posix_spawn exec");
-    _exit(127);
+    fail();
+    VERIFY_NOT_REACHED();
 }
 
-// https://pubs.opengroup.org/onlinepubs/9699919799/functions/posix_spawn.html
-int posix_spawn(pid_t* out_pid, const char* path, const posix_spawn_file_actions_t* file_actions, const posix_spawnattr_t* attr, char* const argv[], char* const envp[])
+static int spawn_with_vfork(pid_t* out_pid, const char* path, const posix_spawn_file_actions_t* file_actions, const posix_spawnattr_t* attr, char* const argv[], char* const envp[], int (*exec)(const char*, char* const[], char* const[]))
 {
-    pid_t child_pid = fork();
+    // With vfork(), the child neither has to copy our address space nor page tables, and it can tell us directly
+    // whether it got to exec(). Where vfork() is just fork(), failures only show up as the child exiting with 127.
+    sigset_t all_signals;
+    sigset_t signal_mask;
+    sigfillset(&all_signals);
+    sigprocmask(SIG_BLOCK, &all_signals, &signal_mask);
+
+    volatile int child_error = 0;
+    pid_t child_pid = vfork();
+    if (child_pid == 0)
+        posix_spawn_child(path, file_actions, attr, argv, envp, exec, signal_mask, &child_error);
+
+    int saved_errno = errno;
+    sigprocmask(SIG_SETMASK, &signal_mask, nullptr);
+
     if (child_pid < 0)
-        return errno;
+        return saved_errno;
 
-    if (child_pid != 0) {
-        *out_pid = child_pid;
-        return 0;
+    if (child_error != 0) {
+        // Reap the child, since as far as our caller is concerned it never existed.
+        (void)waitpid(child_pid, nullptr, 0);
+        return child_error;
     }
 
-    posix_spawn_child(path, file_actions, attr, argv, envp, execve);
+    *out_pid = child_pid;
+    return 0;
+}
+
+// https://pubs.opengroup.org/onlinepubs/9699919799/functions/posix_spawn.html
+int posix_spawn(pid_t* out_pid, const char* path, const posix_spawn_file_actions_t* file_actions, const posix_spawnattr_t* attr, char* const argv[], char* const envp[])
+{
+    return spawn_with_vfork(out_pid, path, file_actions, attr, argv, envp, execve);
 }
 
 // https://pubs.opengroup.org/onlinepubs/9699919799/functions/posix_spawnp.html
 int posix_spawnp(pid_t* out_pid, const char* path, const posix_spawn_file_actions_t* file_actions, const posix_spawnattr_t* attr, char* const argv[], char* const envp[])
 {
-    pid_t child_pid = fork();
-    if (child_pid < 0)
-        return errno;
-
-    if (child_pid != 0) {
-        *out_pid = child_pid;
-        return 0;
-    }
-
-    posix_spawn_child(path, file_actions, attr, argv, envp, execvpe);
+    return spawn_with_vfork(out_pid, path, file_actions, attr, argv, envp, execvpe_without_allocating);
 }
 
 // https://pubs.opengroup.org/onlinepubs/9699919799/functions/posix_spawn_file_actions_addchdir.html
@@ -23,6 +23,7 @@
 #include <string.h>
 #include <sys/internals.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <sys/wait.h>
 #include <syscall.h>
 #include <unistd.h>
@@ -157,6 +158,33 @@ bool FILE::write_from_buffer()
     return true;
 }
 
+ssize_t FILE::write_around_buffer(const u8* data, size_t size)
+{
+    if (!m_buffer.is_not_empty())
+        return do_write(data, size);
+
+    // If the buffered data wraps around, its second half has to go out before the new data does.
+    if (!m_buffer.is_contiguous())
+        return write_from_buffer() ? 0 : -1;
+
+    size_t queued_size;
+    const u8* queued_data = m_buffer.begin_dequeue(queued_size);
+    iovec iov[2] = {
+        { const_cast<u8*>(queued_data), queued_size },
+        { const_cast<u8*>(data), min(size, static_cast<size_t>(NumericLimits<i32>::max()) - queued_size) },
+    };
+    ssize_t nwritten = ::writev(m_fd, iov, 2);
+    if (nwritten < 0) {
+        m_error = errno;
+        return -1;
+    }
+
+    size_t dequeued_size = min(queued_size, static_cast<size_t>(nwritten));
+    if (dequeued_size > 0)
+        m_buffer.did_dequeue(dequeued_size);
+    return nwritten - dequeued_size;
+}
+
 size_t FILE::read(u8* data, size_t size)
 {
     size_t total_read = 0;
@@ -211,6 +239,16 @@ size_t FILE::write(const u8* data, size_t size)
 
         if (m_buffer.may_use()) {
             m_buffer.realize(m_fd);
+            if (m_buffer.mode() != _IONBF && size >= m_buffer.capacity()) {
+                // Copying this through the buffer would only split it up into more write() calls.
+                ssize_t nwritten = write_around_buffer(data, size);
+                if (nwritten < 0)
+                    return total_written;
+                total_written += nwritten;
+                data += nwritten;
+                size -= nwritten;
+                continue;
+            }
             // Try writing into the buffer.
             size_t available_size;
             u8* buffer_data = m_buffer.begin_enqueue(available_size);
@@ -416,6 +454,14 @@ size_t FILE::Buffer::buffered_size() const
         return m_capacity - (m_begin - m_end);
 }
 
+bool FILE::Buffer::is_contiguous() const
+{
+    if (m_ungotten != 0u)
+        return false;
+    // Either nothing is buffered, the data doesn't wrap, or it ends exactly at the end of the buffer.
+    return m_empty || m_begin < m_end || m_end == 0;
+}
+
 const u8* FILE::Buffer::begin_dequeue(size_t& available_size) const
 {
     if (m_ungotten != 0u) {
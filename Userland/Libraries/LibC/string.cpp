@@ -48,6 +48,7 @@ size_t strcspn(const char* s, const char* reject)
     }
 }
 
+#if !ARCH(X86_64) || defined(_DYNAMIC_LOADER)
 // https://pubs.opengroup.org/onlinepubs/9699919799/functions/strlen.html
 size_t strlen(const char* str)
 {
@@ -56,6 +57,7 @@ size_t strlen(const char* str)
         ++len;
     return len;
 }
+#endif
 
 // https://pubs.opengroup.org/onlinepubs/9699919799/functions/strnlen.html
 size_t strnlen(const char* str, size_t maxlen)
@@ -109,6 +111,9 @@ int strncmp(const char* s1, const char* s2, size_t n)
     return 0;
 }
 
+// On x86_64, these (along with strlen, strchr and memchr) are vectorized and selected at load time,
+// see arch/x86_64/string.cpp. The dynamic loader can't use those, so it keeps using the ones here.
+#if !ARCH(X86_64) || defined(_DYNAMIC_LOADER)
 // https://pubs.opengroup.org/onlinepubs/9699919799/functions/memcmp.html
 int memcmp(const void* v1, const void* v2, size_t n)
 {
@@ -176,6 +181,7 @@ void* memmove(void* dest, const void* src, size_t n)
         *--pd = *--ps;
     return dest;
 }
+#endif
 
 const void* memmem(const void* haystack, size_t haystack_length, const void* needle, size_t needle_length)
 {
@@ -215,6 +221,7 @@ size_t strlcpy(char* dest, const char* src, size_t n)
     return i;
 }
 
+#if !ARCH(X86_64) || defined(_DYNAMIC_LOADER)
 // https://pubs.opengroup.org/onlinepubs/9699919799/functions/strchr.html
 char* strchr(const char* str, int c)
 {
@@ -226,6 +233,7 @@ char* strchr(const char* str, int c)
             return nullptr;
     }
 }
+#endif
 
 // https://pubs.opengroup.org/onlinepubs/9699959399/functions/index.html
 char* index(const char* str, int c)
@@ -242,6 +250,7 @@ char* strchrnul(const char* str, int c)
     }
 }
 
+#if !ARCH(X86_64) || defined(_DYNAMIC_LOADER)
 // https://pubs.opengroup.org/onlinepubs/9699919799/functions/memchr.html
 void* memchr(const void* ptr, int c, size_t size)
 {
@@ -253,6 +262,7 @@ void* memchr(const void* ptr, int c, size_t size)
     }
     return nullptr;
 }
+#endif
 
 // https://pubs.opengroup.org/onlinepubs/9699919799/functions/strrchr.html
 char* strrchr(const char* str, int ch)
@@ -96,11 +96,56 @@ pid_t fork()
     __RETURN_WITH_ERRNO(rc, rc, -1);
 }
 
+#if ARCH(I386) || ARCH(X86_64)
+extern "C" [[gnu::used, gnu::visibility("hidden")]] pid_t __vfork_failed(int rc)
+{
+    __RETURN_WITH_ERRNO(rc, rc, -1);
+}
+
+// https://pubs.opengroup.org/onlinepubs/9699919799/functions/vfork.html
+// NOTE: The child runs on our memory, including this very stack, until it calls _exit() or one of the exec*()
+//       functions. Since it's free to overwrite our return address in the meantime, we keep that in a register
+//       across the syscall. Unlike fork(), this doesn't run any pthread_atfork() handlers, and the child also sees
+//       the parent's cached pid and tid.
+extern "C" [[gnu::naked]] pid_t vfork()
+{
+    // clang-format off
+#    if ARCH(I386)
+    asm(
+        "    popl %%ecx \n"
+        "    movl %[function], %%eax \n"
+        "    int $0x82 \n"
+        "    pushl %%ecx \n"
+        "    testl %%eax, %%eax \n"
+        "    js 1f \n"
+        "    ret \n"
+        "1:  pushl %%eax \n"
+        "    call __vfork_failed \n"
+        "    addl $4, %%esp \n"
+        "    ret \n"
+    :: [function] "i"(SC_vfork));
+#    else
+    asm(
+        "    popq %%rdi \n"
+        "    movl %[function], %%eax \n"
+        "    syscall \n"
+        "    pushq %%rdi \n"
+        "    testl %%eax, %%eax \n"
+        "    js 1f \n"
+        "    ret \n"
+        "1:  movl %%eax, %%edi \n"
+        "    jmp __vfork_failed \n"
+    :: [function] "i"(SC_vfork));
+#    endif
+    // clang-format on
+}
+#else
 // https://pubs.opengroup.org/onlinepubs/9699919799/functions/vfork.html
 pid_t vfork()
 {
     return fork();
 }
+#endif
 
 // Non-POSIX, but present in BSDs and Linux
 // https://man.openbsd.org/daemon.3
@@ -390,12 +435,8 @@ ssize_t write(int fd, const void* buf, size_t count)
 // https://pubs.opengroup.org/onlinepubs/9699919799/functions/pwrite.html
 ssize_t pwrite(int fd, const void* buf, size_t count, off_t offset)
 {
-    // FIXME: This is not thread safe and should be implemented in the kernel instead.
-    off_t old_offset = lseek(fd, 0, SEEK_CUR);
-    lseek(fd, offset, SEEK_SET);
-    ssize_t nwritten = write(fd, buf, count);
-    lseek(fd, old_offset, SEEK_SET);
-    return nwritten;
+    int rc = syscall(SC_pwrite, fd, buf, count, &offset);
+    __RETURN_WITH_ERRNO(rc, rc, -1);
 }
 
 // https://pubs.opengroup.org/onlinepubs/9699919799/functions/ttyname_r.html
@@ -36,6 +36,10 @@
 #include <unistd.h>
 
 #ifdef __serenity__
+#    include <AK/Atomic.h>
+#    include <poll.h>
+#    include <serenity.h>
+#    include <sys/mman.h>
 extern bool s_global_initializers_ran;
 #endif
 
@@ -73,6 +77,224 @@ static thread_local HashTable<Notifier*>* s_notifiers;
 thread_local int EventLoop::s_wake_pipe_fds[2];
 thread_local bool EventLoop::s_wake_pipe_initialized { false };
 
+#ifdef __serenity__
+// Each thread also keeps a kernel readiness set with the wake pipe and all of its notifiers registered,
+// so that waiting for events doesn't hand every file descriptor to the kernel again on each iteration.
+static thread_local int s_readiness_set_fd { -1 };
+static thread_local HashMap<int, Vector<Notifier*, 1>>* s_notifiers_by_fd;
+
+// Alternatively, a thread can wait for its notifiers with one-shot polls on an I/O ring, which is opted into by
+// setting LIBCORE_EVENT_LOOP_IO_RING in the environment. Re-arming the polls that fired, as well as any changes to
+// the set of notifiers, are then handed to the kernel with the same io_ring_enter() call that waits for events.
+struct EventLoopIORing {
+    struct WatchedFd {
+        u32 events { 0 };
+        // Identifies the poll that is currently in flight for this fd, or 0 if there is none.
+        u64 poll_user_data { 0 };
+    };
+
+    int fd { -1 };
+    io_ring_params params {};
+    u8* mapping { nullptr };
+    u32 next_generation { 1 };
+    HashMap<int, WatchedFd> watched_fds;
+
+    io_ring_header& header() { return *reinterpret_cast<io_ring_header*>(mapping); }
+    io_ring_submission& submission_at(u32 index) { return reinterpret_cast<io_ring_submission*>(mapping + params.submissions_offset)[index & (params.submission_entries - 1)]; }
+    io_ring_completion& completion_at(u32 index) { return reinterpret_cast<io_ring_completion*>(mapping + params.completions_offset)[index & (params.completion_entries - 1)]; }
+};
+static thread_local EventLoopIORing* s_io_ring;
+static constexpr u32 io_ring_entries = 256;
+
+static void destroy_io_ring()
+{
+    if (!s_io_ring)
+        return;
+    munmap(s_io_ring->mapping, s_io_ring->params.mapping_size);
+    close(s_io_ring->fd);
+    delete s_io_ring;
+    s_io_ring = nullptr;
+}
+
+static void queue_io_ring_submission(io_ring_submission const& submission)
+{
+    auto& ring = *s_io_ring;
+    auto tail = ring.header().submission_tail;
+    if (tail - AK::atomic_load(&ring.header().submission_head, AK::memory_order_acquire) == ring.params.submission_entries) {
+        // The submission queue is full, so hand what we have to the kernel right away.
+        if (io_ring_enter(ring.fd, ring.params.submission_entries, 0, nullptr) < 0) {
+            dbgln("Core::EventLoop: Failed to submit to I/O ring: {}", strerror(errno));
+            VERIFY_NOT_REACHED();
+        }
+    }
+    ring.submission_at(tail) = submission;
+    AK::atomic_store(&ring.header().submission_tail, tail + 1, AK::memory_order_release);
+}
+
+static void arm_io_ring_poll(int fd, EventLoopIORing::WatchedFd& watched_fd)
+{
+    io_ring_submission submission {};
+    submission.opcode = IO_RING_OP_POLL;
+    submission.fd = fd;
+    if (watched_fd.events & READINESS_READ)
+        submission.poll_events |= POLLIN;
+    if (watched_fd.events & READINESS_WRITE)
+        submission.poll_events |= POLLOUT;
+
+    // NOTE: The generation tells apart completions of polls that have since been cancelled, and is never 0.
+    auto generation = s_io_ring->next_generation++;
+    if (generation == 0)
+        generation = s_io_ring->next_generation++;
+    watched_fd.poll_user_data = (static_cast<u64>(generation) << 32) | static_cast<u32>(fd);
+    submission.user_data = watched_fd.poll_user_data;
+    queue_io_ring_submission(submission);
+}
+
+static void cancel_io_ring_poll(EventLoopIORing::WatchedFd& watched_fd)
+{
+    if (!watched_fd.poll_user_data)
+        return;
+    io_ring_submission submission {};
+    submission.opcode = IO_RING_OP_CANCEL;
+    submission.address = watched_fd.poll_user_data;
+    queue_io_ring_submission(submission);
+    watched_fd.poll_user_data = 0;
+}
+
+static void update_io_ring(int fd, u32 events)
+{
+    auto& watched_fds = s_io_ring->watched_fds;
+    // NOTE: We always start over, as the fd number may have been closed and reused since we started polling it.
+    if (auto it = watched_fds.find(fd); it != watched_fds.end()) {
+        cancel_io_ring_poll(it->value);
+        if (events == 0) {
+            watched_fds.remove(it);
+            return;
+        }
+    }
+    if (events == 0)
+        return;
+    auto& watched_fd = watched_fds.ensure(fd);
+    watched_fd.events = events;
+    arm_io_ring_poll(fd, watched_fd);
+}
+
+static bool initialize_io_ring(int wake_pipe_read_fd)
+{
+    destroy_io_ring();
+
+    io_ring_params params {};
+    int fd = io_ring_create(io_ring_entries, IO_RING_CLOEXEC, &params);
+    if (fd < 0) {
+        dbgln("Core::EventLoop: Failed to create I/O ring, falling back to a readiness set: {}", strerror(errno));
+        return false;
+    }
+    auto* mapping = mmap(nullptr, params.mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED) {
+        dbgln("Core::EventLoop: Failed to map I/O ring, falling back to a readiness set: {}", strerror(errno));
+        close(fd);
+        return false;
+    }
+
+    s_io_ring = new EventLoopIORing;
+    s_io_ring->fd = fd;
+    s_io_ring->params = params;
+    s_io_ring->mapping = static_cast<u8*>(mapping);
+    update_io_ring(wake_pipe_read_fd, READINESS_READ);
+    return true;
+}
+
+static int wait_on_io_ring(readiness_event* ready_events, size_t max_events, timespec const* timeout)
+{
+    auto& ring = *s_io_ring;
+    auto& header = ring.header();
+    u32 queued = header.submission_tail - AK::atomic_load(&header.submission_head, AK::memory_order_acquire);
+    // If we left completions behind last time, there is no need to wait for more.
+    u32 min_complete = AK::atomic_load(&header.completion_tail, AK::memory_order_acquire) == header.completion_head ? 1 : 0;
+    if (io_ring_enter(ring.fd, queued, min_complete, timeout) < 0)
+        return -1;
+
+    size_t count = 0;
+    auto head = header.completion_head;
+    auto tail = AK::atomic_load(&header.completion_tail, AK::memory_order_acquire);
+    for (; head != tail && count < max_events; ++head) {
+        auto completion = ring.completion_at(head);
+        // Cancellations are submitted with no user data, and we don't care how they went.
+        if (!completion.user_data)
+            continue;
+        int fd = static_cast<int>(completion.user_data & 0xffffffff);
+        auto it = ring.watched_fds.find(fd);
+        if (it == ring.watched_fds.end() || it->value.poll_user_data != completion.user_data)
+            continue;
+        it->value.poll_user_data = 0;
+        if (completion.result < 0) {
+            dbgln_if(EVENTLOOP_DEBUG, "Core::EventLoop: Failed to poll fd {}: {}", fd, strerror(-completion.result));
+            continue;
+        }
+
+        auto& ready_event = ready_events[count++];
+        ready_event.fd = fd;
+        ready_event.events = 0;
+        if (completion.result & POLLIN)
+            ready_event.events |= READINESS_READ;
+        if (completion.result & POLLOUT)
+            ready_event.events |= READINESS_WRITE;
+        ready_event.user_data = 0;
+
+        // Like the readiness set, we are level-triggered. The new poll only goes out the next time we wait,
+        // by which point the notifier has had its chance to drain the fd.
+        arm_io_ring_poll(fd, it->value);
+    }
+    AK::atomic_store(&header.completion_head, head, AK::memory_order_release);
+    return static_cast<int>(count);
+}
+
+static void initialize_readiness_set(int wake_pipe_read_fd)
+{
+    if (getenv("LIBCORE_EVENT_LOOP_IO_RING") && initialize_io_ring(wake_pipe_read_fd))
+        return;
+    if (s_readiness_set_fd >= 0)
+        close(s_readiness_set_fd);
+    s_readiness_set_fd = create_readiness_set(READINESS_SET_CLOEXEC);
+    VERIFY(s_readiness_set_fd >= 0);
+    int rc = readiness_set_control(s_readiness_set_fd, READINESS_SET_ADD, wake_pipe_read_fd, READINESS_READ, 0);
+    VERIFY(rc == 0);
+}
+
+static void update_readiness_set(int fd)
+{
+    u32 events = 0;
+    if (auto it = s_notifiers_by_fd->find(fd); it != s_notifiers_by_fd->end()) {
+        for (auto* notifier : it->value) {
+            if (notifier->event_mask() & Notifier::Read)
+                events |= READINESS_READ;
+            if (notifier->event_mask() & Notifier::Write)
+                events |= READINESS_WRITE;
+            if (notifier->event_mask() & Notifier::Exceptional)
+                VERIFY_NOT_REACHED();
+        }
+    }
+
+    if (s_io_ring) {
+        update_io_ring(fd, events);
+        return;
+    }
+
+    if (events == 0) {
+        // NOTE: This is allowed to fail, the fd may never have been added in the first place.
+        (void)readiness_set_control(s_readiness_set_fd, READINESS_SET_REMOVE, fd, 0, 0);
+        return;
+    }
+
+    // NOTE: Adding replaces a stale entry left behind by a closed fd with the same number.
+    if (readiness_set_control(s_readiness_set_fd, READINESS_SET_ADD, fd, events, 0) == 0)
+        return;
+    if (errno == EEXIST && readiness_set_control(s_readiness_set_fd, READINESS_SET_MODIFY, fd, events, 0) == 0)
+        return;
+    dbgln_if(EVENTLOOP_DEBUG, "Core::EventLoop: Failed to watch fd {}: {}", fd, strerror(errno));
+}
+#endif
+
 void EventLoop::initialize_wake_pipes()
 {
     if (!s_wake_pipe_initialized) {
@@ -304,6 +526,9 @@ EventLoop::EventLoop([[maybe_unused]] MakeInspectable make_inspectable)
         s_event_loop_stack = new Vector<EventLoop&>;
         s_timers = new HashMap<int, NonnullOwnPtr<EventLoopTimer>>;
         s_notifiers = new HashTable<Notifier*>;
+#ifdef __serenity__
+        s_notifiers_by_fd = new HashMap<int, Vector<Notifier*, 1>>;
+#endif
     }
     s_main_event_loop.with_locked([&, this](auto*& main_event_loop) {
         if (main_event_loop == nullptr) {
@@ -324,6 +549,10 @@ EventLoop::EventLoop([[maybe_unused]] MakeInspectable make_inspectable)
     });
 
     initialize_wake_pipes();
+#ifdef __serenity__
+    if (s_readiness_set_fd < 0 && !s_io_ring)
+        initialize_readiness_set(s_wake_pipe_fds[0]);
+#endif
 
     dbgln_if(EVENTLOOP_DEBUG, "{} Core::EventLoop constructed :)", getpid());
 }
@@ -614,6 +843,11 @@ void EventLoop::notify_forked(ForkEvent event)
         s_notifiers->clear();
         s_wake_pipe_initialized = false;
         initialize_wake_pipes();
+#ifdef __serenity__
+        // NOTE: The readiness set (or I/O ring) is shared with our parent after fork(), so we need our own.
+        s_notifiers_by_fd->clear();
+        initialize_readiness_set(s_wake_pipe_fds[0]);
+#endif
         if (auto* info = signals_info<false>()) {
             info->signal_handlers.clear();
             info->next_signal_id = 0;
@@ -630,9 +864,14 @@ void EventLoop::notify_forked(ForkEvent event)
 
 void EventLoop::wait_for_event(WaitMode mode)
 {
+#ifdef __serenity__
+    readiness_event ready_events[64];
+#else
     fd_set rfds;
     fd_set wfds;
+#endif
 retry:
+#ifndef __serenity__
     FD_ZERO(&rfds);
     FD_ZERO(&wfds);
 
@@ -655,6 +894,7 @@ retry:
         if (notifier->event_mask() & Notifier::Exceptional)
             VERIFY_NOT_REACHED();
     }
+#endif
 
     bool queued_events_is_empty;
     {
@@ -678,19 +918,42 @@ retry:
         }
     }
 
+#ifdef __serenity__
+    struct timespec timeout_spec;
+    timeval_to_timespec(timeout, timeout_spec);
+try_wait_again:
+    int marked_fd_count = s_io_ring
+        ? wait_on_io_ring(ready_events, array_size(ready_events), should_wait_forever ? nullptr : &timeout_spec)
+        : readiness_set_wait(s_readiness_set_fd, ready_events, array_size(ready_events), should_wait_forever ? nullptr : &timeout_spec);
+#else
 try_select_again:
     int marked_fd_count = select(max_fd + 1, &rfds, &wfds, nullptr, should_wait_forever ? nullptr : &timeout);
+#endif
     if (marked_fd_count < 0) {
         int saved_errno = errno;
         if (saved_errno == EINTR) {
             if (m_exit_requested)
                 return;
+#ifdef __serenity__
+            goto try_wait_again;
+#else
             goto try_select_again;
+#endif
         }
         dbgln("Core::EventLoop::wait_for_event: {} ({}: {})", marked_fd_count, saved_errno, strerror(saved_errno));
         VERIFY_NOT_REACHED();
     }
-    if (FD_ISSET(s_wake_pipe_fds[0], &rfds)) {
+
+#ifdef __serenity__
+    bool wake_pipe_is_readable = false;
+    for (int i = 0; i < marked_fd_count; ++i) {
+        if (ready_events[i].fd == s_wake_pipe_fds[0])
+            wake_pipe_is_readable = true;
+    }
+#else
+    bool wake_pipe_is_readable = FD_ISSET(s_wake_pipe_fds[0], &rfds);
+#endif
+    if (wake_pipe_is_readable) {
         int wake_events[8];
         ssize_t nread;
         // We might receive another signal while read()ing here. The signal will go to the handle_signal properly,
@@ -748,6 +1011,20 @@ try_select_again:
     if (!marked_fd_count)
         return;
 
+#ifdef __serenity__
+    for (int i = 0; i < marked_fd_count; ++i) {
+        auto& ready_event = ready_events[i];
+        auto it = s_notifiers_by_fd->find(ready_event.fd);
+        if (it == s_notifiers_by_fd->end())
+            continue;
+        for (auto* notifier : it->value) {
+            if ((ready_event.events & READINESS_READ) && (notifier->event_mask() & Notifier::Event::Read))
+                post_event(*notifier, make<NotifierReadEvent>(notifier->fd()));
+            if ((ready_event.events & READINESS_WRITE) && (notifier->event_mask() & Notifier::Event::Write))
+                post_event(*notifier, make<NotifierWriteEvent>(notifier->fd()));
+        }
+    }
+#else
     for (auto& notifier : *s_notifiers) {
         if (FD_ISSET(notifier->fd(), &rfds)) {
             if (notifier->event_mask() & Notifier::Event::Read)
@@ -758,6 +1035,7 @@ try_select_again:
                 post_event(*notifier, make<NotifierWriteEvent>(notifier->fd()));
         }
     }
+#endif
 }
 
 bool EventLoopTimer::has_expired(const Time& now) const
@@ -814,11 +1092,33 @@ bool EventLoop::unregister_timer(int timer_id)
 void EventLoop::register_notifier(Badge<Notifier>, Notifier& notifier)
 {
     s_notifiers->set(&notifier);
+#ifdef __serenity__
+    auto& notifiers = s_notifiers_by_fd->ensure(notifier.fd());
+    if (!notifiers.contains_slow(&notifier))
+        notifiers.append(&notifier);
+    update_readiness_set(notifier.fd());
+#endif
 }
 
 void EventLoop::unregister_notifier(Badge<Notifier>, Notifier& notifier)
 {
     s_notifiers->remove(&notifier);
+#ifdef __serenity__
+    if (auto it = s_notifiers_by_fd->find(notifier.fd()); it != s_notifiers_by_fd->end()) {
+        it->value.remove_first_matching([&](auto* entry) { return entry == &notifier; });
+        if (it->value.is_empty())
+            s_notifiers_by_fd->remove(it);
+    }
+    update_readiness_set(notifier.fd());
+#endif
+}
+
+void EventLoop::notifier_event_mask_changed(Badge<Notifier>, [[maybe_unused]] Notifier& notifier)
+{
+#ifdef __serenity__
+    if (s_notifiers->contains(&notifier))
+        update_readiness_set(notifier.fd());
+#endif
 }
 
 void EventLoop::wake()
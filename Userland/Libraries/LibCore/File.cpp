@@ -6,6 +6,7 @@
 
 #ifdef __serenity__
 #    include <serenity.h>
+#    include <sys/sendfile.h>
 #endif
 #include <AK/LexicalPath.h>
 #include <AK/ScopeGuard.h>
@@ -415,7 +416,25 @@ ErrorOr<void, File::CopyError> File::copy_file(String const& dst_path, struct st
             return CopyError { errno, false };
     }
 
+    bool copied_by_kernel = false;
+#ifdef __serenity__
+    // Let the kernel move the data over directly. This fails with EINVAL before copying
+    // anything if the source isn't a regular file, in which case we fall back to read() + write().
     for (;;) {
+        ssize_t nsent = ::sendfile(dst_fd, source.fd(), nullptr, 1 * MiB);
+        if (nsent < 0) {
+            if (errno != EINVAL)
+                return CopyError { errno, false };
+            break;
+        }
+        if (nsent == 0) {
+            copied_by_kernel = true;
+            break;
+        }
+    }
+#endif
+
+    while (!copied_by_kernel) {
         char buffer[32768];
         ssize_t nread = ::read(source.fd(), buffer, sizeof(buffer));
         if (nread < 0) {
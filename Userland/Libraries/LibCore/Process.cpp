@@ -25,12 +25,12 @@ pid_t Process::spawn(StringView path)
     char const* argv[] = { path_string.characters(), nullptr };
     if ((errno = posix_spawn(&pid, path_string.characters(), nullptr, nullptr, const_cast<char**>(argv), environ))) {
         perror("Process::spawn posix_spawn");
-    } else {
+        return -1;
+    }
 #ifdef __serenity__
-        if (disown(pid) < 0)
-            perror("Process::spawn disown");
+    if (disown(pid) < 0)
+        perror("Process::spawn disown");
 #endif
-    }
     return pid;
 }
 
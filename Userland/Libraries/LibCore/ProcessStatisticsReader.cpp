@@ -8,15 +8,17 @@
 #include <AK/JsonArray.h>
 #include <AK/JsonObject.h>
 #include <AK/JsonValue.h>
+#include <Kernel/API/ProcessStatistics.h>
 #include <LibCore/File.h>
 #include <LibCore/ProcessStatisticsReader.h>
 #include <pwd.h>
+#include <string.h>
 
 namespace Core {
 
 HashMap<uid_t, String> ProcessStatisticsReader::s_usernames;
 
-Optional<AllProcessesStatistics> ProcessStatisticsReader::get_all(RefPtr<Core::File>& proc_all_file)
+Optional<AllProcessesStatistics> ProcessStatisticsReader::get_all_from_json(RefPtr<Core::File>& proc_all_file)
 {
     if (proc_all_file) {
         if (!proc_all_file->seek(0, Core::SeekMode::SetPosition)) {
@@ -102,10 +104,220 @@ Optional<AllProcessesStatistics> ProcessStatisticsReader::get_all(RefPtr<Core::F
     return all_processes_statistics;
 }
 
+namespace {
+
+class BinaryReader {
+public:
+    explicit BinaryReader(ReadonlyBytes bytes)
+        : m_bytes(bytes)
+    {
+    }
+
+    size_t offset() const { return m_offset; }
+    bool is_at_end() const { return m_offset == m_bytes.size(); }
+
+    template<typename T>
+    bool read(T& value)
+    {
+        if (m_bytes.size() - m_offset < sizeof(T))
+            return false;
+        memcpy(&value, m_bytes.offset_pointer(m_offset), sizeof(T));
+        m_offset += sizeof(T);
+        return true;
+    }
+
+    bool read_string(String& string, size_t length)
+    {
+        if (m_bytes.size() - m_offset < length)
+            return false;
+        string = StringView { m_bytes.offset_pointer(m_offset), length };
+        m_offset += length;
+        return true;
+    }
+
+private:
+    ReadonlyBytes m_bytes;
+    size_t m_offset { 0 };
+};
+
+}
+
+static bool read_thread(BinaryReader& reader, ThreadStatistics& thread)
+{
+    auto start = reader.offset();
+    Kernel::ThreadStatisticsRecord record;
+    if (!reader.read(record))
+        return false;
+
+    thread.tid = record.tid;
+    thread.times_scheduled = record.times_scheduled;
+    thread.time_user = record.time_user;
+    thread.time_kernel = record.time_kernel;
+    thread.cpu = record.cpu;
+    thread.priority = record.priority;
+    thread.syscall_count = record.syscall_count;
+    thread.inode_faults = record.inode_faults;
+    thread.zero_faults = record.zero_faults;
+    thread.cow_faults = record.cow_faults;
+    thread.file_read_bytes = record.file_read_bytes;
+    thread.file_write_bytes = record.file_write_bytes;
+    thread.unix_socket_read_bytes = record.unix_socket_read_bytes;
+    thread.unix_socket_write_bytes = record.unix_socket_write_bytes;
+    thread.ipv4_socket_read_bytes = record.ipv4_socket_read_bytes;
+    thread.ipv4_socket_write_bytes = record.ipv4_socket_write_bytes;
+    if (!reader.read_string(thread.name, record.name_length) || !reader.read_string(thread.state, record.state_length))
+        return false;
+    return reader.offset() - start == record.record_size;
+}
+
+static bool read_process(BinaryReader& reader, ProcessStatistics& process)
+{
+    auto start = reader.offset();
+    Kernel::ProcessStatisticsRecord record;
+    if (!reader.read(record))
+        return false;
+
+    process.pid = record.pid;
+    process.pgid = record.pgid;
+    process.pgp = record.pgp;
+    process.sid = record.sid;
+    process.uid = record.uid;
+    process.gid = record.gid;
+    process.ppid = record.ppid;
+    process.nfds = record.nfds;
+    process.kernel = record.kernel;
+    process.amount_virtual = record.amount_virtual;
+    process.amount_resident = record.amount_resident;
+    process.amount_shared = record.amount_shared;
+    process.amount_dirty_private = record.amount_dirty_private;
+    process.amount_clean_inode = record.amount_clean_inode;
+    process.amount_purgeable_volatile = record.amount_purgeable_volatile;
+    process.amount_purgeable_nonvolatile = record.amount_purgeable_nonvolatile;
+    if (!reader.read_string(process.name, record.name_length)
+        || !reader.read_string(process.executable, record.executable_length)
+        || !reader.read_string(process.tty, record.tty_length)
+        || !reader.read_string(process.pledge, record.pledge_length)
+        || !reader.read_string(process.veil, record.veil_length))
+        return false;
+
+    process.threads.clear_with_capacity();
+    process.threads.ensure_capacity(record.thread_count);
+    for (u32 i = 0; i < record.thread_count; ++i) {
+        ThreadStatistics thread;
+        if (!read_thread(reader, thread))
+            return false;
+        process.threads.unchecked_append(move(thread));
+    }
+    return reader.offset() - start == record.record_size;
+}
+
+bool ProcessStatisticsReader::refresh_from_binary()
+{
+    auto contents = m_file->read_all();
+    BinaryReader reader { contents };
+
+    Kernel::ProcessStatisticsHeader header;
+    if (!reader.read(header)
+        || header.magic != Kernel::process_statistics_magic
+        || header.version != Kernel::process_statistics_version
+        || header.header_size != sizeof(header)
+        || header.changed_process_count > header.process_count) {
+        warnln("ProcessStatisticsReader: Unsupported /proc/process_statistics format");
+        return false;
+    }
+
+    Vector<pid_t> pids;
+    pids.ensure_capacity(header.process_count);
+    for (u32 i = 0; i < header.process_count; ++i) {
+        u32 pid;
+        if (!reader.read(pid))
+            return false;
+        pids.unchecked_append(pid);
+    }
+
+    Vector<ProcessStatistics> changed_processes;
+    changed_processes.ensure_capacity(header.changed_process_count);
+    for (u32 i = 0; i < header.changed_process_count; ++i) {
+        ProcessStatistics process;
+        if (!read_process(reader, process))
+            return false;
+        process.username = username_from_uid(process.uid);
+        changed_processes.unchecked_append(move(process));
+    }
+    if (!reader.is_at_end())
+        return false;
+
+    // Processes that haven't changed are carried over from the previous snapshot. The changed
+    // ones are listed in the same order as their PIDs, and every other PID has to be known already.
+    HashMap<pid_t, size_t> previous_indices;
+    if (header.since_generation != 0) {
+        previous_indices.ensure_capacity(m_statistics.processes.size());
+        for (size_t i = 0; i < m_statistics.processes.size(); ++i)
+            previous_indices.set(m_statistics.processes[i].pid, i);
+    }
+
+    Vector<ProcessStatistics> processes;
+    processes.ensure_capacity(pids.size());
+    size_t next_changed_process = 0;
+    for (auto pid : pids) {
+        if (next_changed_process < changed_processes.size() && changed_processes[next_changed_process].pid == pid) {
+            processes.unchecked_append(move(changed_processes[next_changed_process++]));
+            continue;
+        }
+        auto previous_index = previous_indices.get(pid);
+        if (!previous_index.has_value())
+            return false;
+        processes.unchecked_append(move(m_statistics.processes[previous_index.value()]));
+    }
+    if (next_changed_process != changed_processes.size())
+        return false;
+
+    m_statistics.processes = move(processes);
+    m_statistics.total_time_scheduled = header.total_time_scheduled;
+    m_statistics.total_time_scheduled_kernel = header.total_time_scheduled_kernel;
+    return true;
+}
+
+bool ProcessStatisticsReader::refresh()
+{
+    bool needs_rewind = !m_file.is_null();
+    if (!m_file && !m_json_file) {
+        auto file = Core::File::construct("/proc/process_statistics");
+        if (file->open(Core::OpenMode::ReadOnly))
+            m_file = move(file);
+    }
+
+    if (!m_file) {
+        auto statistics = get_all_from_json(m_json_file);
+        if (!statistics.has_value())
+            return false;
+        m_statistics = statistics.release_value();
+        return true;
+    }
+
+    // The first read after opening the file is a full snapshot. Every seek back to the start
+    // makes the kernel prepare one with just the processes that changed since the last one.
+    if (needs_rewind && !m_file->seek(0, Core::SeekMode::SetPosition)) {
+        warnln("ProcessStatisticsReader: Failed to refresh /proc/process_statistics: {}", m_file->error_string());
+        m_file = nullptr;
+        return false;
+    }
+
+    if (!refresh_from_binary()) {
+        // The kernel already considers our state up to date, so start over with a full snapshot.
+        m_file = nullptr;
+        m_statistics = {};
+        return false;
+    }
+    return true;
+}
+
 Optional<AllProcessesStatistics> ProcessStatisticsReader::get_all()
 {
-    RefPtr<Core::File> proc_all_file;
-    return get_all(proc_all_file);
+    ProcessStatisticsReader reader;
+    if (!reader.refresh())
+        return {};
+    return reader.take_statistics();
 }
 
 String ProcessStatisticsReader::username_from_uid(uid_t uid)
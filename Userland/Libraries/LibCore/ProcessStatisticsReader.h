@@ -6,7 +6,9 @@
 
 #pragma once
 
+#include <AK/HashMap.h>
 #include <AK/String.h>
+#include <AK/Vector.h>
 #include <LibCore/File.h>
 #include <unistd.h>
 
@@ -34,7 +36,7 @@ struct ThreadStatistics {
 };
 
 struct ProcessStatistics {
-    // Keep this in sync with /proc/all.
+    // Keep this in sync with /proc/all and /proc/process_statistics.
     // From the kernel side:
     pid_t pid;
     pid_t pgid;
@@ -66,18 +68,31 @@ struct ProcessStatistics {
 
 struct AllProcessesStatistics {
     Vector<ProcessStatistics> processes;
-    u64 total_time_scheduled;
-    u64 total_time_scheduled_kernel;
+    u64 total_time_scheduled { 0 };
+    u64 total_time_scheduled_kernel { 0 };
 };
 
 class ProcessStatisticsReader {
 public:
-    static Optional<AllProcessesStatistics> get_all(RefPtr<Core::File>&);
     static Optional<AllProcessesStatistics> get_all();
+    static Optional<AllProcessesStatistics> get_all_from_json(RefPtr<Core::File>&);
+
+    // Keeps /proc/process_statistics open, so every refresh after the first one only has to
+    // read the processes that may have changed since the previous one. Falls back to /proc/all
+    // if the binary interface isn't available.
+    bool refresh();
+    AllProcessesStatistics const& statistics() const { return m_statistics; }
+    AllProcessesStatistics take_statistics() { return move(m_statistics); }
 
 private:
+    bool refresh_from_binary();
+
     static String username_from_uid(uid_t);
     static HashMap<uid_t, String> s_usernames;
+
+    RefPtr<Core::File> m_file;
+    RefPtr<Core::File> m_json_file;
+    AllProcessesStatistics m_statistics;
 };
 
 }
@@ -287,6 +287,9 @@ public:
     ErrorOr<void> set_blocking(bool enabled) override { return m_helper.set_blocking(enabled); }
     ErrorOr<void> set_close_on_exec(bool enabled) override { return m_helper.set_close_on_exec(enabled); }
 
+    // NOTE: Only meant for handing the socket to the kernel directly, e.g. as the destination of sendfile().
+    int fd() const { return m_helper.fd(); }
+
     virtual ~TCPSocket() override { close(); }
 
 private:
@@ -784,6 +787,9 @@ public:
 
     size_t buffer_size() const { return m_helper.buffer_size(); }
 
+    T& underlying_stream() { return m_helper.stream(); }
+    T const& underlying_stream() const { return m_helper.stream(); }
+
     virtual ~BufferedSocket() override { }
 
 private:
@@ -186,7 +186,17 @@ bool DynamicLoader::load_stage_2(unsigned flags)
 
 void DynamicLoader::do_main_relocations()
 {
+    Vector<DynamicObject::Relocation> ifunc_relocations;
     auto do_single_relocation = [&](const ELF::DynamicObject::Relocation& relocation) {
+        // Resolvers may depend on everything else being relocated already, so they are called last.
+#if ARCH(I386)
+        if (relocation.type() == R_386_IRELATIVE) {
+#else
+        if (relocation.type() == R_X86_64_IRELATIVE) {
+#endif
+            ifunc_relocations.append(relocation);
+            return;
+        }
         switch (do_relocation(relocation, ShouldInitializeWeak::No)) {
         case RelocationResult::Failed:
             dbgln("Loader.so: {} unresolved symbol '{}'", m_filename, relocation.symbol().name());
@@ -200,6 +210,11 @@ void DynamicLoader::do_main_relocations()
     };
     m_dynamic_object->relocation_section().for_each_relocation(do_single_relocation);
     m_dynamic_object->plt_relocation_section().for_each_relocation(do_single_relocation);
+
+    for (auto const& relocation : ifunc_relocations) {
+        auto result = do_relocation(relocation, ShouldInitializeWeak::No);
+        VERIFY(result == RelocationResult::Success);
+    }
 }
 
 Result<NonnullRefPtr<DynamicObject>, DlErrorMessage> DynamicLoader::load_stage_3(unsigned flags)
@@ -511,6 +526,19 @@ DynamicLoader::RelocationResult DynamicLoader::do_relocation(const ELF::DynamicO
         *patch_ptr = negative_offset_from_tls_block_end(dynamic_object_of_symbol->tls_offset().value(), symbol_value + addend);
         break;
     }
+#if ARCH(I386)
+    case R_386_IRELATIVE: {
+#else
+    case R_X86_64_IRELATIVE: {
+#endif
+        VirtualAddress resolver;
+        if (relocation.addend_used())
+            resolver = m_dynamic_object->base_address().offset(relocation.addend());
+        else
+            resolver = m_dynamic_object->base_address().offset(*patch_ptr);
+        *patch_ptr = call_ifunc_resolver(resolver).get();
+        break;
+    }
 #if ARCH(I386)
     case R_386_JMP_SLOT: {
 #else
@@ -627,7 +655,16 @@ Optional<DynamicObject::SymbolLookupResult> DynamicLoader::lookup_symbol(const E
     if (symbol.is_undefined() || symbol.bind() == STB_WEAK)
         return DynamicLinker::lookup_global_symbol(symbol.name());
 
-    return DynamicObject::SymbolLookupResult { symbol.value(), symbol.size(), symbol.address(), symbol.bind(), &symbol.object() };
+    auto address = symbol.address();
+    if (symbol.type() == STT_GNU_IFUNC)
+        address = call_ifunc_resolver(address);
+    return DynamicObject::SymbolLookupResult { symbol.value(), symbol.size(), address, symbol.bind(), &symbol.object() };
+}
+
+VirtualAddress DynamicLoader::call_ifunc_resolver(VirtualAddress resolver)
+{
+    using IfuncResolver = FlatPtr (*)();
+    return VirtualAddress { reinterpret_cast<IfuncResolver>(resolver.get())() };
 }
 
 } // end namespace ELF
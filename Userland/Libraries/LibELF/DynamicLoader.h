@@ -78,6 +78,8 @@ public:
     bool is_dynamic() const { return m_elf_image.is_dynamic(); }
 
     static Optional<DynamicObject::SymbolLookupResult> lookup_symbol(const ELF::DynamicObject::Symbol&);
+    // The value of an IFUNC symbol is the address of its resolver, which returns the implementation to use.
+    static VirtualAddress call_ifunc_resolver(VirtualAddress resolver);
     void copy_initial_tls_data_into(ByteBuffer& buffer) const;
 
 private:
@@ -449,7 +449,10 @@ auto DynamicObject::lookup_symbol(const HashSymbol& symbol) const -> Optional<Sy
     auto symbol_result = result.value();
     if (symbol_result.is_undefined())
         return {};
-    return SymbolLookupResult { symbol_result.value(), symbol_result.size(), symbol_result.address(), symbol_result.bind(), this };
+    auto address = symbol_result.address();
+    if (symbol_result.type() == STT_GNU_IFUNC)
+        address = DynamicLoader::call_ifunc_resolver(address);
+    return SymbolLookupResult { symbol_result.value(), symbol_result.size(), address, symbol_result.bind(), this };
 }
 
 NonnullRefPtr<DynamicObject> DynamicObject::create(const String& filename, VirtualAddress base_address, VirtualAddress dynamic_section_address)
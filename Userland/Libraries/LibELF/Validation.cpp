@@ -47,9 +47,10 @@ bool validate_elf_header(ElfW(Ehdr) const& elf_header, size_t file_size, bool ve
         return false;
     }
 
-    if (ELFOSABI_SYSV != elf_header.e_ident[EI_OSABI]) {
+    // The linker marks files that contain IFUNC symbols as using the GNU OS ABI.
+    if (ELFOSABI_SYSV != elf_header.e_ident[EI_OSABI] && ELFOSABI_GNU != elf_header.e_ident[EI_OSABI]) {
         if (verbose)
-            dbgln("File has unknown OS ABI ({}), expected SYSV(0)!", elf_header.e_ident[EI_OSABI]);
+            dbgln("File has unknown OS ABI ({}), expected SYSV(0) or GNU(3)!", elf_header.e_ident[EI_OSABI]);
         return false;
     }
 
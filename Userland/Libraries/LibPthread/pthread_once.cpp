@@ -46,7 +46,7 @@ int pthread_once(pthread_once_t* self, void (*callback)(void))
             // anyone.
             break;
         case State::PERFORMING_WITH_WAITERS:
-            futex_wake(self, INT_MAX);
+            futex_wake(self, INT_MAX, false);
             break;
         }
 
@@ -76,7 +76,7 @@ int pthread_once(pthread_once_t* self, void (*callback)(void))
             [[fallthrough]];
         case State::PERFORMING_WITH_WAITERS:
             // Let's wait for it.
-            futex_wait(self, state2, nullptr, 0);
+            futex_wait(self, state2, nullptr, 0, false);
             // We have been woken up, but that might have been due to a signal
             // or something, so we have to reevaluate. We need acquire ordering
             // here for the same reason as above. Hopefully we'll just see
@@ -12,6 +12,8 @@
 #include <LibSQL/Serializer.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/uio.h>
+#include <unistd.h>
 
 namespace SQL {
 
@@ -79,12 +81,19 @@ ErrorOr<ByteBuffer> Heap::read_block(u32 block)
         return Error::from_string_literal("Heap()::read_block(): block # out of range"sv);
     }
     dbgln_if(SQL_DEBUG, "Read heap block {}", block);
-    TRY(seek_block(block));
-    auto ret = m_file->read(BLOCKSIZE);
-    if (ret.is_empty()) {
+    auto buffer_or_error = ByteBuffer::create_uninitialized(BLOCKSIZE);
+    if (!buffer_or_error.has_value()) {
+        warnln("Heap({})::read_block({}): Could not allocate block buffer"sv, name(), block);
+        return Error::from_string_literal("Heap()::read_block(): Could not allocate block buffer"sv);
+    }
+    auto ret = buffer_or_error.release_value();
+    // Positional reads leave the file offset alone, so reads never have to be serialized against writes.
+    auto nread = pread(m_file->fd(), ret.data(), BLOCKSIZE, block_offset(block));
+    if (nread <= 0) {
         warnln("Heap({})::read_block({}): Could not read block"sv, name(), block);
         return Error::from_string_literal("Heap()::read_block(): Could not read block"sv);
     }
+    ret.resize(nread);
     dbgln_if(SQL_DEBUG, "{:02x} {:02x} {:02x} {:02x} {:02x} {:02x} {:02x} {:02x}",
         *ret.offset_pointer(0), *ret.offset_pointer(1),
         *ret.offset_pointer(2), *ret.offset_pointer(3),
@@ -93,65 +102,54 @@ ErrorOr<ByteBuffer> Heap::read_block(u32 block)
     return ret;
 }
 
-ErrorOr<void> Heap::write_block(u32 block, ByteBuffer& buffer)
+ErrorOr<void> Heap::write_blocks(u32 first_block, size_t count)
 {
+    VERIFY(count > 0 && count <= max_blocks_per_write);
     if (m_file.is_null()) {
-        warnln("Heap({})::write_block({}): Heap file not opened"sv, name(), block);
-        return Error::from_string_literal("Heap()::write_block(): Heap file not opened"sv);
-    }
-    if (block > m_next_block) {
-        warnln("Heap({})::write_block({}): block # out of range (> {})"sv, name(), block, m_next_block);
-        return Error::from_string_literal("Heap()::write_block(): block # out of range"sv);
+        warnln("Heap({})::write_blocks({}): Heap file not opened"sv, name(), first_block);
+        return Error::from_string_literal("Heap()::write_blocks(): Heap file not opened"sv);
     }
-    TRY(seek_block(block));
-    dbgln_if(SQL_DEBUG, "Write heap block {} size {}", block, buffer.size());
-    if (buffer.size() > BLOCKSIZE) {
-        warnln("Heap({})::write_block({}): Oversized block ({} > {})"sv, name(), block, buffer.size(), BLOCKSIZE);
-        return Error::from_string_literal("Heap()::write_block(): Oversized block"sv);
+    if (first_block > m_end_of_file) {
+        warnln("Heap({})::write_blocks({}): Cannot write beyond end of file at block {}"sv, name(), first_block, m_end_of_file);
+        return Error::from_string_literal("Heap()::write_blocks(): Cannot write beyond end of file"sv);
     }
-    auto sz = buffer.size();
-    if (sz < BLOCKSIZE) {
-        if (buffer.try_resize(BLOCKSIZE).is_error()) {
-            warnln("Heap({})::write_block({}): Could not align block of size {} to {}"sv, name(), block, buffer.size(), BLOCKSIZE);
-            return Error::from_string_literal("Heap()::write_block(): Could not align block"sv);
-        }
-        memset(buffer.offset_pointer((int)sz), 0, BLOCKSIZE - sz);
-    }
-    dbgln_if(SQL_DEBUG, "{:02x} {:02x} {:02x} {:02x} {:02x} {:02x} {:02x} {:02x}",
-        *buffer.offset_pointer(0), *buffer.offset_pointer(1),
-        *buffer.offset_pointer(2), *buffer.offset_pointer(3),
-        *buffer.offset_pointer(4), *buffer.offset_pointer(5),
-        *buffer.offset_pointer(6), *buffer.offset_pointer(7));
-    if (m_file->write(buffer.data(), (int)buffer.size())) {
-        if (block == m_end_of_file)
-            m_end_of_file++;
-        return {};
-    }
-    warnln("Heap({})::write_block({}): Could not full write block"sv, name(), block);
-    return Error::from_string_literal("Heap()::write_block(): Could not full write block"sv);
-}
 
-ErrorOr<void> Heap::seek_block(u32 block)
-{
-    if (m_file.is_null()) {
-        warnln("Heap({})::seek_block({}): Heap file not opened"sv, name(), block);
-        return Error::from_string_literal("Heap()::seek_block(): Heap file not opened"sv);
-    }
-    if (block == m_end_of_file) {
-        off_t pos;
-        if (!m_file->seek(0, Core::SeekMode::FromEndPosition, &pos)) {
-            warnln("Heap({})::seek_block({}): Error seeking end of file: {}"sv, name(), block, m_file->error_string());
-            return Error::from_string_literal("Heap()::seek_block(): Error seeking end of file"sv);
+    Vector<iovec, max_blocks_per_write> iovecs;
+    for (auto block = first_block; block < first_block + count; ++block) {
+        if (block > m_next_block) {
+            warnln("Heap({})::write_blocks({}): block # out of range (> {})"sv, name(), block, m_next_block);
+            return Error::from_string_literal("Heap()::write_blocks(): block # out of range"sv);
         }
-    } else if (block > m_end_of_file) {
-        warnln("Heap({})::seek_block({}): Cannot seek beyond end of file at block {}"sv, name(), block, m_end_of_file);
-        return Error::from_string_literal("Heap()::seek_block(): Cannot seek beyond end of file"sv);
-    } else {
-        if (!m_file->seek(block * BLOCKSIZE)) {
-            warnln("Heap({})::seek_block({}): Error seeking: {}"sv, name(), block, m_file->error_string());
-            return Error::from_string_literal("Heap()::seek_block(): Error seeking: {}"sv);
+        auto buffer_it = m_write_ahead_log.find(block);
+        VERIFY(buffer_it != m_write_ahead_log.end());
+        auto& buffer = buffer_it->value;
+        dbgln_if(SQL_DEBUG, "Write heap block {} size {}", block, buffer.size());
+        if (buffer.size() > BLOCKSIZE) {
+            warnln("Heap({})::write_blocks({}): Oversized block ({} > {})"sv, name(), block, buffer.size(), BLOCKSIZE);
+            return Error::from_string_literal("Heap()::write_blocks(): Oversized block"sv);
+        }
+        auto sz = buffer.size();
+        if (sz < BLOCKSIZE) {
+            if (buffer.try_resize(BLOCKSIZE).is_error()) {
+                warnln("Heap({})::write_blocks({}): Could not align block of size {} to {}"sv, name(), block, buffer.size(), BLOCKSIZE);
+                return Error::from_string_literal("Heap()::write_blocks(): Could not align block"sv);
+            }
+            memset(buffer.offset_pointer((int)sz), 0, BLOCKSIZE - sz);
         }
+        dbgln_if(SQL_DEBUG, "{:02x} {:02x} {:02x} {:02x} {:02x} {:02x} {:02x} {:02x}",
+            *buffer.offset_pointer(0), *buffer.offset_pointer(1),
+            *buffer.offset_pointer(2), *buffer.offset_pointer(3),
+            *buffer.offset_pointer(4), *buffer.offset_pointer(5),
+            *buffer.offset_pointer(6), *buffer.offset_pointer(7));
+        iovecs.append({ buffer.data(), buffer.size() });
     }
+
+    auto nwritten = pwritev(m_file->fd(), iovecs.data(), (int)iovecs.size(), block_offset(first_block));
+    if (nwritten < 0 || static_cast<size_t>(nwritten) != count * BLOCKSIZE) {
+        warnln("Heap({})::write_blocks({}): Could not fully write {} blocks"sv, name(), first_block, count);
+        return Error::from_string_literal("Heap()::write_blocks(): Could not fully write blocks"sv);
+    }
+    m_end_of_file = max(m_end_of_file, first_block + static_cast<u32>(count));
     return {};
 }
 
@@ -180,11 +178,14 @@ ErrorOr<void> Heap::flush()
         blocks.append(wal_entry.key);
     }
     quick_sort(blocks);
-    for (auto& block : blocks) {
-        auto buffer_it = m_write_ahead_log.find(block);
-        VERIFY(buffer_it != m_write_ahead_log.end());
-        dbgln_if(SQL_DEBUG, "Flushing block {} to {}", block, name());
-        TRY(write_block(block, buffer_it->value));
+    // Runs of consecutive blocks are written out with a single pwritev().
+    for (size_t i = 0; i < blocks.size();) {
+        size_t run_length = 1;
+        while (i + run_length < blocks.size() && run_length < max_blocks_per_write && blocks[i + run_length] == blocks[i] + run_length)
+            ++run_length;
+        dbgln_if(SQL_DEBUG, "Flushing blocks {}-{} to {}", blocks[i], blocks[i + run_length - 1], name());
+        TRY(write_blocks(blocks[i], run_length));
+        i += run_length;
     }
     m_write_ahead_log.clear();
     dbgln_if(SQL_DEBUG, "WAL flushed. Heap size = {}", size());
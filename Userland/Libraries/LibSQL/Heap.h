@@ -17,6 +17,7 @@
 namespace SQL {
 
 constexpr static u32 BLOCKSIZE = 1024;
+constexpr static size_t max_blocks_per_write = 64;
 
 /**
  * A Heap is a logical container for database (SQL) data. Conceptually a
@@ -96,8 +97,9 @@ public:
 private:
     explicit Heap(String);
 
-    ErrorOr<void> write_block(u32, ByteBuffer&);
-    ErrorOr<void> seek_block(u32);
+    // Writes out the write-ahead log entries of a run of consecutive blocks.
+    ErrorOr<void> write_blocks(u32 first_block, size_t count);
+    static off_t block_offset(u32 block) { return static_cast<off_t>(block) * BLOCKSIZE; }
     ErrorOr<void> read_zero_block();
     void initialize_zero_block();
     void update_zero_block();
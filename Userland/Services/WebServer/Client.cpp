@@ -15,9 +15,9 @@
 #include <LibCore/DateTime.h>
 #include <LibCore/DirIterator.h>
 #include <LibCore/File.h>
-#include <LibCore/FileStream.h>
 #include <LibCore/MappedFile.h>
 #include <LibCore/MimeData.h>
+#include <LibCore/System.h>
 #include <LibHTTP/HttpRequest.h>
 #include <LibHTTP/HttpResponse.h>
 #include <WebServer/Client.h>
@@ -162,13 +162,11 @@ ErrorOr<bool> Client::handle_request(ReadonlyBytes raw_request)
         return false;
     }
 
-    Core::InputFileStream stream { file };
-
-    TRY(send_response(stream, request, Core::guess_mime_type_based_on_filename(real_path)));
+    TRY(send_file_response(file->fd(), request, Core::guess_mime_type_based_on_filename(real_path)));
     return true;
 }
 
-ErrorOr<void> Client::send_response(InputStream& response, HTTP::HttpRequest const& request, String const& content_type)
+ErrorOr<void> Client::send_response_headers(HTTP::HttpRequest const& request, String const& content_type)
 {
     StringBuilder builder;
     builder.append("HTTP/1.0 200 OK\r\n");
@@ -184,6 +182,12 @@ ErrorOr<void> Client::send_response(InputStream& response, HTTP::HttpRequest con
     auto builder_contents = builder.to_byte_buffer();
     TRY(m_socket->write(builder_contents));
     log_response(200, request);
+    return {};
+}
+
+ErrorOr<void> Client::send_response(InputStream& response, HTTP::HttpRequest const& request, String const& content_type)
+{
+    TRY(send_response_headers(request, content_type));
 
     char buffer[PAGE_SIZE];
     do {
@@ -206,6 +210,21 @@ ErrorOr<void> Client::send_response(InputStream& response, HTTP::HttpRequest con
     return {};
 }
 
+ErrorOr<void> Client::send_file_response(int fd, HTTP::HttpRequest const& request, String const& content_type)
+{
+    TRY(send_response_headers(request, content_type));
+
+    // The kernel moves the file contents into the socket for us, so they never have to pass through our address space.
+    auto socket_fd = m_socket->underlying_stream().fd();
+    for (;;) {
+        auto nsent = TRY(Core::System::sendfile(socket_fd, fd, nullptr, 1 * MiB));
+        if (nsent == 0)
+            break;
+    }
+
+    return {};
+}
+
 ErrorOr<void> Client::send_redirect(StringView redirect_path, HTTP::HttpRequest const& request)
 {
     StringBuilder builder;
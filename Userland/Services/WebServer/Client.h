@@ -24,6 +24,8 @@ private:
 
     ErrorOr<bool> handle_request(ReadonlyBytes);
     ErrorOr<void> send_response(InputStream&, HTTP::HttpRequest const&, String const& content_type);
+    ErrorOr<void> send_file_response(int fd, HTTP::HttpRequest const&, String const& content_type);
+    ErrorOr<void> send_response_headers(HTTP::HttpRequest const&, String const& content_type);
     ErrorOr<void> send_redirect(StringView redirect, HTTP::HttpRequest const&);
     ErrorOr<void> send_error_response(unsigned code, HTTP::HttpRequest const&, Vector<String> const& headers = {});
     void die();
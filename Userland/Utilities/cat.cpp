@@ -8,10 +8,26 @@
 #include <LibCore/ArgsParser.h>
 #include <LibCore/System.h>
 #include <LibMain/Main.h>
+#include <errno.h>
 #include <fcntl.h>
 #include <string.h>
 #include <unistd.h>
 
+// Lets the kernel copy regular files straight to stdout. Returns false if `fd` can't be used as a sendfile() source.
+static ErrorOr<bool> try_sendfile_to_stdout(int fd)
+{
+    for (;;) {
+        auto nsent_or_error = Core::System::sendfile(STDOUT_FILENO, fd, nullptr, 1 * MiB);
+        if (nsent_or_error.is_error()) {
+            if (nsent_or_error.error().code() == EINVAL)
+                return false;
+            return nsent_or_error.release_error();
+        }
+        if (nsent_or_error.value() == 0)
+            return true;
+    }
+}
+
 ErrorOr<int> serenity_main(Main::Arguments arguments)
 {
     TRY(Core::System::pledge("stdio rpath"));
@@ -47,6 +63,10 @@ ErrorOr<int> serenity_main(Main::Arguments arguments)
 
     Array<u8, 32768> buffer;
     for (auto& fd : fds) {
+        if (TRY(try_sendfile_to_stdout(fd))) {
+            TRY(Core::System::close(fd));
+            continue;
+        }
         for (;;) {
             auto buffer_span = buffer.span();
             auto nread = TRY(Core::System::read(fd, buffer_span));
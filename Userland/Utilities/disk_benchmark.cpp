@@ -4,6 +4,7 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/Atomic.h>
 #include <AK/ByteBuffer.h>
 #include <AK/ScopeGuard.h>
 #include <AK/String.h>
@@ -12,9 +13,11 @@
 #include <LibCore/ElapsedTimer.h>
 #include <fcntl.h>
 #include <getopt.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <sys/stat.h>
+#include <sys/statvfs.h>
 #include <unistd.h>
 
 struct Result {
@@ -39,22 +42,171 @@ static Result average_result(const Vector<Result>& results)
 
 static void exit_with_usage(int rc)
 {
-    warnln("Usage: disk_benchmark [-h] [-d directory] [-t time_per_benchmark] [-f file_size1,file_size2,...] [-b block_size1,block_size2,...]");
+    warnln("Usage: disk_benchmark [-h] [-c] [-s] [-d directory] [-t time_per_benchmark] [-f file_size1,file_size2,...] [-b block_size1,block_size2,...] [-j job_count1,job_count2,...]");
+    warnln("  -s  Also run every benchmark with one file system block per read/write, and report the difference");
+    warnln("  -j  Instead of sequential throughput, measure random read IOPS with that many jobs reading in parallel");
     exit(rc);
 }
 
 static Optional<Result> benchmark(const String& filename, int file_size, int block_size, ByteBuffer& buffer, bool allow_cache);
 
+static Optional<Result> run_benchmarks(const String& filename, int file_size, int block_size, int time_per_benchmark, bool allow_cache)
+{
+    auto buffer_result = ByteBuffer::create_uninitialized(block_size);
+    if (!buffer_result.has_value()) {
+        warnln("Not enough memory to allocate space for block size = {}", block_size);
+        return {};
+    }
+    Vector<Result> results;
+
+    outln("Running: file_size={} block_size={}", file_size, block_size);
+    auto timer = Core::ElapsedTimer::start_new();
+    while (timer.elapsed() < time_per_benchmark * 1000) {
+        out(".");
+        fflush(stdout);
+        auto result = benchmark(filename, file_size, block_size, *buffer_result, allow_cache);
+        if (!result.has_value())
+            exit(1);
+        results.append(result.release_value());
+        usleep(100);
+    }
+    auto average = average_result(results);
+    outln("Finished: runs={} time={}ms write_bps={} read_bps={}", results.size(), timer.elapsed(), average.write_bps, average.read_bps);
+
+    sleep(1);
+    return average;
+}
+
+// Random reads from several threads at once, each with its own file descriptor (like fio's randread with numjobs).
+// How the IOPS scale with the job count shows whether the storage stack can keep several requests in flight.
+struct RandomReadJob {
+    String filename;
+    size_t file_size { 0 };
+    size_t block_size { 0 };
+    bool allow_cache { false };
+    Atomic<bool>* should_stop { nullptr };
+    u64 completed_reads { 0 };
+    bool failed { false };
+};
+
+static void* run_random_read_job(void* argument)
+{
+    auto& job = *static_cast<RandomReadJob*>(argument);
+    int fd = open(job.filename.characters(), O_RDONLY | (job.allow_cache ? 0 : O_DIRECT));
+    if (fd < 0) {
+        perror("open");
+        job.failed = true;
+        return nullptr;
+    }
+    auto buffer = ByteBuffer::create_uninitialized(job.block_size);
+    if (!buffer.has_value()) {
+        job.failed = true;
+        close(fd);
+        return nullptr;
+    }
+    auto block_count = job.file_size / job.block_size;
+    while (!job.should_stop->load(AK::MemoryOrder::memory_order_relaxed)) {
+        off_t offset = static_cast<off_t>(arc4random_uniform(block_count)) * job.block_size;
+        if (pread(fd, buffer->data(), job.block_size, offset) < 0) {
+            perror("pread");
+            job.failed = true;
+            break;
+        }
+        ++job.completed_reads;
+    }
+    close(fd);
+    return nullptr;
+}
+
+static bool create_file_for_random_reads(const String& filename, size_t file_size, size_t block_size)
+{
+    int fd = open(filename.characters(), O_CREAT | O_TRUNC | O_WRONLY, 0644);
+    if (fd < 0) {
+        perror("open");
+        return false;
+    }
+    auto buffer = ByteBuffer::create_zeroed(block_size);
+    if (!buffer.has_value()) {
+        close(fd);
+        return false;
+    }
+    for (size_t total_written = 0; total_written < file_size;) {
+        auto nwritten = write(fd, buffer->data(), min(block_size, file_size - total_written));
+        if (nwritten < 0) {
+            perror("write");
+            close(fd);
+            return false;
+        }
+        total_written += nwritten;
+    }
+    if (fsync(fd) < 0)
+        perror("fsync");
+    close(fd);
+    return true;
+}
+
+static Optional<u64> run_random_read_benchmark(const String& filename, size_t file_size, size_t block_size, size_t job_count, int time_per_benchmark, bool allow_cache)
+{
+    outln("Running: file_size={} block_size={} jobs={}", file_size, block_size, job_count);
+
+    Atomic<bool> should_stop { false };
+    Vector<RandomReadJob> jobs;
+    jobs.resize(job_count);
+    Vector<pthread_t> threads;
+    for (auto& job : jobs) {
+        job.filename = filename;
+        job.file_size = file_size;
+        job.block_size = block_size;
+        job.allow_cache = allow_cache;
+        job.should_stop = &should_stop;
+    }
+
+    auto timer = Core::ElapsedTimer::start_new();
+    for (auto& job : jobs) {
+        pthread_t thread;
+        if (int rc = pthread_create(&thread, nullptr, run_random_read_job, &job); rc != 0) {
+            warnln("pthread_create: {}", strerror(rc));
+            break;
+        }
+        threads.append(thread);
+    }
+    sleep(time_per_benchmark);
+    should_stop.store(true);
+    for (auto thread : threads)
+        pthread_join(thread, nullptr);
+    auto elapsed_ms = max<u64>(timer.elapsed(), 1);
+
+    u64 total_reads = 0;
+    for (auto& job : jobs) {
+        if (job.failed)
+            return {};
+        total_reads += job.completed_reads;
+    }
+    if (threads.size() != job_count)
+        return {};
+
+    auto iops = total_reads * 1000 / elapsed_ms;
+    outln("Finished: reads={} time={}ms iops={}", total_reads, elapsed_ms, iops);
+    return iops;
+}
+
+static double ratio(u64 value, u64 baseline)
+{
+    return baseline ? static_cast<double>(value) / baseline : 0;
+}
+
 int main(int argc, char** argv)
 {
     String directory = ".";
     int time_per_benchmark = 10;
     Vector<size_t> file_sizes;
     Vector<size_t> block_sizes;
+    Vector<size_t> job_counts;
     bool allow_cache = false;
+    bool compare_with_single_block_io = false;
 
     int opt;
-    while ((opt = getopt(argc, argv, "chd:t:f:b:")) != -1) {
+    while ((opt = getopt(argc, argv, "cshd:t:f:b:j:")) != -1) {
         switch (opt) {
         case 'h':
             exit_with_usage(0);
@@ -62,6 +214,9 @@ int main(int argc, char** argv)
         case 'c':
             allow_cache = true;
             break;
+        case 's':
+            compare_with_single_block_io = true;
+            break;
         case 'd':
             directory = optarg;
             break;
@@ -76,6 +231,10 @@ int main(int argc, char** argv)
             for (const auto& size : String(optarg).split(','))
                 block_sizes.append(atoi(size.characters()));
             break;
+        case 'j':
+            for (const auto& count : String(optarg).split(','))
+                job_counts.append(max(atoi(count.characters()), 1));
+            break;
         }
     }
 
@@ -90,33 +249,60 @@ int main(int argc, char** argv)
 
     auto filename = String::formatted("{}/disk_benchmark.tmp", directory);
 
+    if (!job_counts.is_empty()) {
+        for (auto file_size : file_sizes) {
+            for (auto block_size : block_sizes) {
+                if (block_size > file_size)
+                    continue;
+                if (!create_file_for_random_reads(filename, file_size, block_size))
+                    return 1;
+                Optional<u64> single_job_iops;
+                for (auto job_count : job_counts) {
+                    auto iops = run_random_read_benchmark(filename, file_size, block_size, job_count, time_per_benchmark, allow_cache);
+                    if (!iops.has_value())
+                        continue;
+                    if (!single_job_iops.has_value() && job_count == 1)
+                        single_job_iops = iops;
+                    else if (single_job_iops.has_value())
+                        outln("Compared to 1 job: x{:.2}", ratio(iops.value(), single_job_iops.value()));
+                }
+                if (unlink(filename.characters()) < 0)
+                    perror("unlink");
+            }
+        }
+        return 0;
+    }
+
+    // With -s, every benchmark is repeated with reads and writes of a single file system block,
+    // which the kernel has to turn into one device request each. The difference shows how much
+    // is gained by moving larger runs of contiguous blocks with a single request.
+    size_t fs_block_size = 0;
+    if (compare_with_single_block_io) {
+        struct statvfs fs_info;
+        if (statvfs(directory.characters(), &fs_info) < 0) {
+            perror("statvfs");
+            return 1;
+        }
+        fs_block_size = fs_info.f_bsize;
+    }
+
     for (auto file_size : file_sizes) {
         for (auto block_size : block_sizes) {
             if (block_size > file_size)
                 continue;
 
-            auto buffer_result = ByteBuffer::create_uninitialized(block_size);
-            if (!buffer_result.has_value()) {
-                warnln("Not enough memory to allocate space for block size = {}", block_size);
+            auto average = run_benchmarks(filename, file_size, block_size, time_per_benchmark, allow_cache);
+            if (!average.has_value())
                 continue;
-            }
-            Vector<Result> results;
-
-            outln("Running: file_size={} block_size={}", file_size, block_size);
-            auto timer = Core::ElapsedTimer::start_new();
-            while (timer.elapsed() < time_per_benchmark * 1000) {
-                out(".");
-                fflush(stdout);
-                auto result = benchmark(filename, file_size, block_size, *buffer_result, allow_cache);
-                if (!result.has_value())
-                    return 1;
-                results.append(result.release_value());
-                usleep(100);
-            }
-            auto average = average_result(results);
-            outln("Finished: runs={} time={}ms write_bps={} read_bps={}", results.size(), timer.elapsed(), average.write_bps, average.read_bps);
 
-            sleep(1);
+            if (!compare_with_single_block_io || block_size <= fs_block_size)
+                continue;
+            auto single_block_average = run_benchmarks(filename, file_size, fs_block_size, time_per_benchmark, allow_cache);
+            if (!single_block_average.has_value())
+                continue;
+            outln("Compared to {}-byte I/O: write x{:.2} read x{:.2}", fs_block_size,
+                ratio(average->write_bps, single_block_average->write_bps),
+                ratio(average->read_bps, single_block_average->read_bps));
         }
     }
 
@@ -4,10 +4,110 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/JsonObject.h>
+#include <AK/JsonValue.h>
+#include <AK/StringBuilder.h>
+#include <AK/StringView.h>
 #include <LibCore/ArgsParser.h>
+#include <LibCore/File.h>
+#include <fcntl.h>
+#include <poll.h>
 #include <serenity.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <unistd.h>
+
+// Copies all events currently buffered by the kernel into the output, separated by commas.
+static bool drain_profile_stream(int stream_fd, FILE* output, bool& is_first_event)
+{
+    static char buffer[64 * KiB];
+    for (;;) {
+        auto nread = read(stream_fd, buffer, sizeof(buffer));
+        if (nread < 0) {
+            perror("read");
+            return false;
+        }
+        if (nread == 0)
+            return true;
+        // Every read hands out whole events, one per line.
+        for (auto event : StringView(buffer, nread).split_view('\n')) {
+            if (!is_first_event)
+                fputc(',', output);
+            is_first_event = false;
+            fwrite(event.characters_without_null_termination(), 1, event.length(), output);
+        }
+    }
+}
+
+// Streams the system-wide profile into a perfcore file until there's input on stdin,
+// so that the kernel's event buffers never have to hold the whole profile at once.
+static bool stream_profile_until_input(char const* output_path)
+{
+    int stream_fd = open("/proc/profile_stream", O_RDONLY | O_CLOEXEC);
+    if (stream_fd < 0) {
+        perror("open /proc/profile_stream");
+        return false;
+    }
+    auto* output = fopen(output_path, "w");
+    if (!output) {
+        perror("fopen");
+        close(stream_fd);
+        return false;
+    }
+
+    fputs("{\"events\":[", output);
+    bool is_first_event = true;
+    bool ok = true;
+    for (;;) {
+        pollfd stdin_poll { STDIN_FILENO, POLLIN, 0 };
+        auto rc = poll(&stdin_poll, 1, 100);
+        if (!drain_profile_stream(stream_fd, output, is_first_event)) {
+            ok = false;
+            break;
+        }
+        if (rc != 0)
+            break;
+    }
+    (void)getchar();
+
+    if (ok && profiling_disable(-1) < 0) {
+        perror("profiling_disable");
+        ok = false;
+    }
+    // Pick up whatever was recorded between the last read and disabling the profiler.
+    if (ok)
+        ok = drain_profile_stream(stream_fd, output, is_first_event);
+    close(stream_fd);
+
+    // Strings registered for signposts are only available from the regular profile.
+    auto strings = String("[]");
+    if (ok) {
+        auto file_or_error = Core::File::open("/proc/profile", Core::OpenMode::ReadOnly);
+        if (file_or_error.is_error()) {
+            warnln("Failed to open /proc/profile: {}", file_or_error.error());
+            ok = false;
+        } else if (auto json = JsonValue::from_string(file_or_error.value()->read_all()); json.is_error() || !json.value().is_object()) {
+            warnln("Failed to parse /proc/profile");
+            ok = false;
+        } else {
+            auto const& object = json.value().as_object();
+            if (auto const* events = object.get_ptr("events"); events && events->is_array()) {
+                for (auto const& event : events->as_array().values()) {
+                    if (!is_first_event)
+                        fputc(',', output);
+                    is_first_event = false;
+                    fputs(event.serialized<StringBuilder>().characters(), output);
+                }
+            }
+            if (auto const* string_table = object.get_ptr("strings"))
+                strings = string_table->serialized<StringBuilder>();
+        }
+    }
+
+    fprintf(output, "],\"strings\":%s}", strings.characters());
+    fclose(output);
+    return ok;
+}
 
 int main(int argc, char** argv)
 {
@@ -15,6 +115,7 @@ int main(int argc, char** argv)
 
     const char* pid_argument = nullptr;
     const char* cmd_argument = nullptr;
+    const char* stream_path = nullptr;
     bool wait = false;
     bool free = false;
     bool enable = false;
@@ -32,6 +133,7 @@ int main(int argc, char** argv)
     args_parser.add_option(free, "Free the profiling buffer for the associated process(es).", nullptr, 'f');
     args_parser.add_option(wait, "Enable profiling and wait for user input to disable.", nullptr, 'w');
     args_parser.add_option(cmd_argument, "Command", nullptr, 'c', "command");
+    args_parser.add_option(stream_path, "With -a -w, stream the profile into a file while recording", "stream", 's', "path");
     args_parser.add_option(Core::ArgsParser::Option {
         true, "Enable tracking specific event type", nullptr, 't', "event_type",
         [&](String event_type) {
@@ -92,6 +194,15 @@ int main(int argc, char** argv)
                 return 0;
         }
 
+        if (wait && stream_path) {
+            if (!all_processes) {
+                warnln("--stream requires -a.");
+                return 1;
+            }
+            outln("Profiling enabled, streaming to {} until there's user input...", stream_path);
+            return stream_profile_until_input(stream_path) ? 0 : 1;
+        }
+
         if (wait) {
             outln("Profiling enabled, waiting for user input to disable...");
             (void)getchar();
@@ -17,7 +17,7 @@ ErrorOr<int> serenity_main(Main::Arguments arguments)
     String this_tty = ttyname(STDIN_FILENO);
 
     TRY(Core::System::pledge("stdio rpath"));
-    TRY(Core::System::unveil("/proc/all", "r"));
+    TRY(Core::System::unveil("/proc/process_statistics", "r"));
     TRY(Core::System::unveil("/etc/passwd", "r"));
     TRY(Core::System::unveil(nullptr, nullptr));
 
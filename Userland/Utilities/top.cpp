@@ -91,12 +91,13 @@ struct Snapshot {
 
 static Snapshot get_snapshot()
 {
-    auto all_processes = Core::ProcessStatisticsReader::get_all();
-    if (!all_processes.has_value())
+    static Core::ProcessStatisticsReader reader;
+    if (!reader.refresh())
         return {};
+    auto const& all_processes = reader.statistics();
 
     Snapshot snapshot;
-    for (auto& process : all_processes.value().processes) {
+    for (auto& process : all_processes.processes) {
         for (auto& thread : process.threads) {
             ThreadData thread_data;
             thread_data.tid = thread.tid;
@@ -126,8 +127,8 @@ static Snapshot get_snapshot()
         }
     }
 
-    snapshot.total_time_scheduled = all_processes->total_time_scheduled;
-    snapshot.total_time_scheduled_kernel = all_processes->total_time_scheduled_kernel;
+    snapshot.total_time_scheduled = all_processes.total_time_scheduled;
+    snapshot.total_time_scheduled_kernel = all_processes.total_time_scheduled_kernel;
 
     return snapshot;
 }
@@ -180,7 +181,7 @@ static void parse_args(Main::Arguments arguments, TopOption& top_option)
 ErrorOr<int> serenity_main(Main::Arguments arguments)
 {
     TRY(Core::System::pledge("stdio rpath tty sigaction"));
-    TRY(Core::System::unveil("/proc/all", "r"));
+    TRY(Core::System::unveil("/proc/process_statistics", "r"));
     TRY(Core::System::unveil("/etc/passwd", "r"));
     unveil(nullptr, nullptr);
 